@@ -0,0 +1,152 @@
+#ifndef NETCHUNK_CATALOG_H
+#define NETCHUNK_CATALOG_H
+
+#include "chunker.h"
+#include "config.h"
+#include "ftp_client.h"
+#include "manifest.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Forward declarations
+typedef struct netchunk_catalog_entry netchunk_catalog_entry_t;
+typedef struct netchunk_catalog netchunk_catalog_t;
+typedef struct netchunk_catalog_sync_stats netchunk_catalog_sync_stats_t;
+
+// Catalog constants
+#define NETCHUNK_CATALOG_VERSION "1.0"
+#define NETCHUNK_CATALOG_FILENAME "catalog.json" // Under local_storage_path
+
+/**
+ * @brief Summary of one stored file, as recorded in its manifest
+ */
+typedef struct netchunk_catalog_entry {
+    char name[NETCHUNK_FTP_MAX_NAME_LEN]; // Remote file name identifier (the key)
+    uint64_t total_size; // File size in bytes
+    uint8_t file_hash[NETCHUNK_HASH_LENGTH]; // SHA-256 of the whole file
+    uint32_t chunk_count; // Number of chunks
+    time_t created_timestamp; // When the file was chunked
+    time_t last_modified; // Last manifest modification
+    time_t remote_modified; // Modification time of the manifest copy indexed, 0 if unknown
+    uint64_t remote_size; // Size of that manifest copy
+} netchunk_catalog_entry_t;
+
+/**
+ * @brief Local index of all stored files, kept sorted by name
+ *
+ * Answers listings and lookups without contacting the servers. It is
+ * refreshed by netchunk_catalog_sync(), which lists each server's manifest
+ * directory once and only downloads manifests whose remote size or
+ * modification time changed. Persisted as JSON; the catalog is owned by a
+ * single process at a time and concurrent writers are not coordinated.
+ */
+typedef struct netchunk_catalog {
+    char path[NETCHUNK_MAX_PATH_LEN]; // Backing file
+    netchunk_catalog_entry_t* entries; // Sorted by name
+    size_t count; // Number of entries
+    size_t capacity; // Allocated entries
+    time_t last_sync; // When the catalog last matched the servers, 0 if never
+    bool dirty; // Modified since last load/save
+} netchunk_catalog_t;
+
+/**
+ * @brief Work done by one catalog sync
+ */
+typedef struct netchunk_catalog_sync_stats {
+    uint32_t manifests_listed; // Manifests found on the servers
+    uint32_t manifests_fetched; // New or changed manifests downloaded
+    uint32_t entries_removed; // Entries whose manifest is gone
+    uint32_t fetch_failures; // Changed manifests that could not be read
+    int servers_listed; // Servers whose listing succeeded
+} netchunk_catalog_sync_stats_t;
+
+/**
+ * @brief Initialize an empty catalog
+ * @param catalog Catalog to initialize
+ * @param path Backing file path (~ is expanded)
+ * @return NETCHUNK_SUCCESS on success, error code on failure
+ */
+netchunk_error_t netchunk_catalog_init(netchunk_catalog_t* catalog, const char* path);
+
+/**
+ * @brief Load the catalog from its backing file
+ *
+ * A missing file leaves the catalog empty and never synced.
+ *
+ * @param catalog Initialized catalog
+ * @return NETCHUNK_SUCCESS on success, error code on failure
+ */
+netchunk_error_t netchunk_catalog_load(netchunk_catalog_t* catalog);
+
+/**
+ * @brief Write the catalog to its backing file atomically
+ * @param catalog Catalog to save
+ * @return NETCHUNK_SUCCESS on success, error code on failure
+ */
+netchunk_error_t netchunk_catalog_save(netchunk_catalog_t* catalog);
+
+/**
+ * @brief Free catalog resources
+ * @param catalog Catalog to cleanup
+ */
+void netchunk_catalog_cleanup(netchunk_catalog_t* catalog);
+
+/**
+ * @brief Find a file by name
+ * @param catalog Catalog to search
+ * @param name Remote file name identifier
+ * @return Entry, valid until the catalog is next modified, or NULL if unknown
+ */
+const netchunk_catalog_entry_t* netchunk_catalog_lookup(const netchunk_catalog_t* catalog, const char* name);
+
+/**
+ * @brief Record a file from its manifest, replacing any entry of the same name
+ * @param catalog Catalog to update
+ * @param manifest Manifest of the file (chunks are not needed)
+ * @param remote_modified Modification time of the remote manifest copy, 0 if unknown
+ * @param remote_size Size of the remote manifest copy, 0 if unknown
+ * @return NETCHUNK_SUCCESS on success, error code on failure
+ */
+netchunk_error_t netchunk_catalog_put(netchunk_catalog_t* catalog,
+    const netchunk_file_manifest_t* manifest,
+    time_t remote_modified,
+    uint64_t remote_size);
+
+/**
+ * @brief Forget a file
+ * @param catalog Catalog to update
+ * @param name Remote file name identifier
+ * @return true if an entry was removed
+ */
+bool netchunk_catalog_remove(netchunk_catalog_t* catalog, const char* name);
+
+/**
+ * @brief Bring the catalog up to date with the servers
+ *
+ * Manifests whose newest remote copy matches the size and modification
+ * time already indexed are not downloaded. Entries are only removed when
+ * every server answered and none lists them any more. The catalog is saved
+ * afterwards.
+ *
+ * @param catalog Catalog to refresh
+ * @param ftp_context FTP context
+ * @param config NetChunk configuration
+ * @param stats Optional sync statistics output (can be NULL)
+ * @return NETCHUNK_SUCCESS on success, NETCHUNK_ERROR_SERVER_UNAVAILABLE if
+ *         no server could be listed, error code on failure
+ */
+netchunk_error_t netchunk_catalog_sync(netchunk_catalog_t* catalog,
+    netchunk_ftp_context_t* ftp_context,
+    netchunk_config_t* config,
+    netchunk_catalog_sync_stats_t* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NETCHUNK_CATALOG_H
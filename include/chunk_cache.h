@@ -0,0 +1,143 @@
+#ifndef NETCHUNK_CHUNK_CACHE_H
+#define NETCHUNK_CHUNK_CACHE_H
+
+#include "chunker.h"
+#include "config.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Forward declarations
+typedef struct netchunk_chunk_cache_entry netchunk_chunk_cache_entry_t;
+typedef struct netchunk_chunk_cache netchunk_chunk_cache_t;
+
+// Chunk cache constants
+#define NETCHUNK_CHUNK_CACHE_INITIAL_BUCKETS 256 // Always a power of two
+
+/**
+ * @brief One cached chunk
+ *
+ * Entries are handed out pinned; a pinned entry is never evicted or freed,
+ * so its data may be read without holding the caller's lock.
+ */
+typedef struct netchunk_chunk_cache_entry {
+    uint8_t hash[NETCHUNK_HASH_LENGTH]; // SHA-256 of the chunk data (the key)
+    uint8_t* data; // Chunk data, owned by the cache
+    size_t size; // Chunk size in bytes
+    int server_index; // Server the data was fetched from, -1 if unknown
+    bool verified; // Data checked against the hash
+    bool removed; // Dropped from the index, freed once unpinned
+    int pins; // Callers currently using the entry
+    struct netchunk_chunk_cache_entry* bucket_next;
+    struct netchunk_chunk_cache_entry* lru_prev; // Towards most recently used
+    struct netchunk_chunk_cache_entry* lru_next; // Towards least recently used
+} netchunk_chunk_cache_entry_t;
+
+/**
+ * @brief Size-bounded in-memory LRU cache of chunk data, keyed by chunk hash
+ *
+ * Chained hash table plus a recency list. Unpinned entries are evicted from
+ * the least recently used end once the cached bytes exceed the capacity;
+ * pinned entries may hold the cache above it until they are released. The
+ * cache does no locking of its own, callers serialize access.
+ */
+typedef struct netchunk_chunk_cache {
+    netchunk_chunk_cache_entry_t** buckets;
+    size_t bucket_count;
+    size_t count; // Indexed entries
+    netchunk_chunk_cache_entry_t* lru_head; // Most recently used
+    netchunk_chunk_cache_entry_t* lru_tail; // Least recently used
+    size_t capacity_bytes; // Budget for cached chunk data
+    size_t used_bytes; // Data bytes of indexed entries
+    uint64_t hits; // Lookups answered from the cache
+    uint64_t misses; // Lookups that were not
+    uint64_t evictions; // Entries evicted to stay within the budget
+} netchunk_chunk_cache_t;
+
+/**
+ * @brief Initialize an empty cache
+ * @param cache Cache to initialize
+ * @param capacity_bytes Byte budget; 0 keeps chunks only while pinned
+ * @return NETCHUNK_SUCCESS on success, error code on failure
+ */
+netchunk_error_t netchunk_chunk_cache_init(netchunk_chunk_cache_t* cache, size_t capacity_bytes);
+
+/**
+ * @brief Free all entries, pinned or not
+ * @param cache Cache to cleanup
+ */
+void netchunk_chunk_cache_cleanup(netchunk_chunk_cache_t* cache);
+
+/**
+ * @brief Look up a chunk and pin it
+ *
+ * Counts a hit or a miss and marks the entry most recently used.
+ *
+ * @param cache Cache to search
+ * @param hash Chunk hash
+ * @return Pinned entry, to be released with netchunk_chunk_cache_release(), or NULL
+ */
+netchunk_chunk_cache_entry_t* netchunk_chunk_cache_acquire(netchunk_chunk_cache_t* cache, const uint8_t* hash);
+
+/**
+ * @brief Check whether a chunk is cached, without counting or reordering
+ * @param cache Cache to search
+ * @param hash Chunk hash
+ * @return true if the chunk is cached
+ */
+bool netchunk_chunk_cache_contains(const netchunk_chunk_cache_t* cache, const uint8_t* hash);
+
+/**
+ * @brief Add a chunk and pin it
+ *
+ * The cache takes ownership of data, also on failure. If the hash is
+ * already cached, data is freed and the existing entry is returned.
+ *
+ * @param cache Cache to update
+ * @param hash Chunk hash
+ * @param data Chunk data allocated with malloc()
+ * @param size Chunk size in bytes
+ * @param server_index Server the data came from, -1 if unknown
+ * @param verified Whether data was already checked against hash
+ * @return Pinned entry, or NULL if out of memory
+ */
+netchunk_chunk_cache_entry_t* netchunk_chunk_cache_insert(netchunk_chunk_cache_t* cache,
+    const uint8_t* hash,
+    uint8_t* data,
+    size_t size,
+    int server_index,
+    bool verified);
+
+/**
+ * @brief Pin an entry again
+ * @param cache Cache owning the entry
+ * @param entry Entry already pinned by the caller
+ */
+void netchunk_chunk_cache_pin(netchunk_chunk_cache_t* cache, netchunk_chunk_cache_entry_t* entry);
+
+/**
+ * @brief Unpin an entry and evict down to the byte budget
+ * @param cache Cache owning the entry
+ * @param entry Pinned entry
+ */
+void netchunk_chunk_cache_release(netchunk_chunk_cache_t* cache, netchunk_chunk_cache_entry_t* entry);
+
+/**
+ * @brief Drop a pinned entry, e.g. after it failed verification
+ *
+ * Later lookups miss; the entry is freed once its last pin is released.
+ *
+ * @param cache Cache owning the entry
+ * @param entry Pinned entry
+ */
+void netchunk_chunk_cache_remove(netchunk_chunk_cache_t* cache, netchunk_chunk_cache_entry_t* entry);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NETCHUNK_CHUNK_CACHE_H
@@ -1,7 +1,10 @@
 #ifndef NETCHUNK_CHUNKER_H
 #define NETCHUNK_CHUNKER_H
 
+#include "cipher.h"
 #include "config.h"
+#include "crypto.h"
+#include "metrics.h"
 #include <stdint.h>
 #include <stdio.h>
 #include <time.h>
@@ -11,10 +14,18 @@ extern "C" {
 #endif
 
 // Chunk processing constants
-#define NETCHUNK_CHUNK_ID_LENGTH 16 // UUID-like chunk ID
 #define NETCHUNK_HASH_LENGTH 32 // SHA-256 hash length
+#define NETCHUNK_CHUNK_ID_LENGTH (NETCHUNK_HASH_LENGTH * 2) // Longest ID (content-addressed hex hash)
+#define NETCHUNK_RANDOM_CHUNK_ID_LENGTH 16 // UUID-like per-upload chunk ID
 #define NETCHUNK_MAX_CHUNK_LOCATIONS NETCHUNK_MAX_REPLICATION_FACTOR
 #define NETCHUNK_READ_BUFFER_SIZE (64 * 1024) // 64KB read buffer
+#define NETCHUNK_UPLOAD_ID_LENGTH 8 // Random per-upload salt mixed into chunk IDs
+#define NETCHUNK_CHUNKER_STDIN "-" // Input path that selects standard input
+
+// Content-defined chunking: chunks range from a quarter to four times the
+// average (chunk_size), clamped to these bounds
+#define NETCHUNK_CDC_MIN_CHUNK_SIZE (NETCHUNK_MIN_CHUNK_SIZE / 4) // 256KB
+#define NETCHUNK_CDC_MAX_CHUNK_SIZE NETCHUNK_MAX_CHUNK_SIZE
 
 // Forward declarations
 typedef struct netchunk_chunk netchunk_chunk_t;
@@ -22,9 +33,10 @@ typedef struct netchunk_chunker_context netchunk_chunker_context_t;
 typedef struct netchunk_file_info netchunk_file_info_t;
 
 // Chunk location on server (define before using in netchunk_chunk)
+// The remote path is not stored: it is derived from the chunk ID
+// (netchunk_ftp_chunk_path()) and is the same on every server.
 typedef struct netchunk_chunk_location {
     char server_id[NETCHUNK_MAX_SERVER_ID_LEN]; // Server ID string
-    char remote_path[NETCHUNK_MAX_PATH_LEN]; // Full path on server
     time_t upload_time; // When uploaded to this server
     bool verified; // Whether integrity was verified
     time_t last_verified; // Last verification timestamp
@@ -35,6 +47,10 @@ typedef struct netchunk_chunk {
     char id[NETCHUNK_CHUNK_ID_LENGTH + 1]; // Null-terminated chunk ID
     uint8_t hash[NETCHUNK_HASH_LENGTH]; // SHA-256 hash of chunk data
     size_t size; // Actual size of chunk data
+    netchunk_compression_t codec; // Compression of the copy stored on the servers
+    uint8_t key_id[NETCHUNK_KEY_ID_LENGTH]; // Key of the copy stored on the servers, all zero if not encrypted
+    size_t stored_size; // Bytes stored on the servers when compressed or encrypted
+    size_t offset; // Byte offset in original file
     uint32_t sequence_number; // Order in original file
     time_t created_timestamp; // When chunk was created
 
@@ -43,7 +59,7 @@ typedef struct netchunk_chunk {
     int location_count; // Number of servers storing this chunk
 
     // Data pointer (for in-memory operations)
-    uint8_t* data; // Chunk data (NULL if not loaded)
+    uint8_t* data; // Chunk data in its stored form (NULL if not loaded)
     bool data_owned; // Whether this structure owns the data
 } netchunk_chunk_t;
 
@@ -61,16 +77,34 @@ typedef struct netchunk_file_info {
 // Chunker context for streaming operations
 typedef struct netchunk_chunker_context {
     FILE* input_file; // Input file handle
-    size_t chunk_size; // Target chunk size
+    bool owns_input; // Whether cleanup closes input_file
+    bool size_known; // False for pipes and other non-regular inputs
+    size_t chunk_size; // Target chunk size (average size in CDC mode)
     uint32_t current_chunk_number; // Current chunk being processed
-    uint32_t total_chunks; // Total number of chunks
-    size_t total_file_size; // Total size of input file
+    uint32_t total_chunks; // Total number of chunks (0 until EOF if size unknown)
+    size_t total_file_size; // Total size of input file (0 until EOF if size unknown)
     size_t bytes_processed; // Bytes processed so far
-
-    // Current chunk being built
-    uint8_t* chunk_buffer; // Buffer for current chunk
-    size_t chunk_buffer_size; // Current buffer size
-    size_t chunk_buffer_capacity; // Buffer capacity
+    size_t input_bytes_read; // Bytes consumed from the input (may run ahead in CDC mode)
+    bool input_eof; // Input exhausted; buffered bytes may remain
+
+    // Content-defined chunking
+    netchunk_chunking_mode_t chunking_mode; // Boundary selection
+    size_t min_chunk_size; // No cut point before this many bytes
+    size_t max_chunk_size; // Forced cut point
+    uint64_t cdc_mask_small; // Harder cut condition below the average size
+    uint64_t cdc_mask_large; // Easier cut condition above the average size
+    uint8_t* carry; // Bytes read past the last cut point
+    size_t carry_size; // Valid bytes in carry
+
+    // Single-pass hashing
+    uint8_t upload_id[NETCHUNK_UPLOAD_ID_LENGTH]; // Salt for chunk IDs
+    netchunk_sha256_context_t file_hash_context; // Running hash of all data read
+    bool file_hash_ready; // file_info.file_hash is final
+
+    // Instrumentation
+    netchunk_metrics_t* metrics; // Receives read and hash timings per chunk (can be NULL)
+    uint64_t read_ns; // Reading time of the chunk being filled
+    uint64_t hash_ns; // Hashing time of the chunk being filled
 
     // File information
     netchunk_file_info_t file_info; // File metadata
@@ -91,8 +125,13 @@ typedef void (*netchunk_chunk_progress_callback_t)(void* userdata,
 
 /**
  * @brief Initialize chunker context for file processing
+ *
+ * The input is read exactly once: each chunk's hash and the whole-file hash
+ * are computed in the same pass, and the file hash becomes available once
+ * netchunk_chunker_next_chunk() has returned NETCHUNK_ERROR_EOF.
+ *
  * @param context Chunker context to initialize
- * @param input_file_path Path to input file
+ * @param input_file_path Path to input file, or NETCHUNK_CHUNKER_STDIN for standard input
  * @param chunk_size Size for each chunk
  * @return NETCHUNK_SUCCESS on success, error code on failure
  */
@@ -100,6 +139,47 @@ netchunk_error_t netchunk_chunker_init(netchunk_chunker_context_t* context,
     const char* input_file_path,
     size_t chunk_size);
 
+/**
+ * @brief Initialize chunker context over an already open stream
+ *
+ * Works with non-seekable inputs such as pipes. When the size cannot be
+ * determined up front, total_file_size and total_chunks stay 0 until EOF.
+ *
+ * @param context Chunker context to initialize
+ * @param input Open input stream (not closed by netchunk_chunker_cleanup())
+ * @param name Name recorded in the file info
+ * @param chunk_size Size for each chunk
+ * @return NETCHUNK_SUCCESS on success, error code on failure
+ */
+netchunk_error_t netchunk_chunker_init_stream(netchunk_chunker_context_t* context,
+    FILE* input,
+    const char* name,
+    size_t chunk_size);
+
+/**
+ * @brief Select how chunk boundaries are chosen
+ *
+ * Must be called before the first chunk is read. In CDC mode a Gear rolling
+ * hash (FastCDC) picks boundaries from the data itself, so an insertion only
+ * changes the chunks around it. chunk_size becomes the average size and
+ * total_chunks an estimate until EOF.
+ *
+ * @param context Chunker context
+ * @param mode Chunking mode
+ * @return NETCHUNK_SUCCESS on success, error code on failure
+ */
+netchunk_error_t netchunk_chunker_set_mode(netchunk_chunker_context_t* context,
+    netchunk_chunking_mode_t mode);
+
+/**
+ * @brief Get the hash of all input read, once the input is exhausted
+ * @param context Chunker context
+ * @param hash Output buffer (NETCHUNK_HASH_LENGTH bytes)
+ * @return NETCHUNK_SUCCESS on success, NETCHUNK_ERROR_INVALID_ARGUMENT before EOF
+ */
+netchunk_error_t netchunk_chunker_get_file_hash(const netchunk_chunker_context_t* context,
+    uint8_t* hash);
+
 /**
  * @brief Cleanup chunker context and free resources
  * @param context Chunker context to cleanup
@@ -110,11 +190,40 @@ void netchunk_chunker_cleanup(netchunk_chunker_context_t* context);
  * @brief Get the next chunk from the file
  * @param context Chunker context
  * @param chunk Output chunk structure
- * @return NETCHUNK_SUCCESS if chunk retrieved, NETCHUNK_ERROR_FILE_NOT_FOUND if no more chunks
+ * @return NETCHUNK_SUCCESS if chunk retrieved, NETCHUNK_ERROR_EOF if no more chunks
  */
 netchunk_error_t netchunk_chunker_next_chunk(netchunk_chunker_context_t* context,
     netchunk_chunk_t* chunk);
 
+/**
+ * @brief Size a buffer passed to netchunk_chunker_next_chunk_into() must have
+ *
+ * The chunk size in fixed mode, the maximum chunk size in CDC mode. Only
+ * valid once the chunking mode is set.
+ *
+ * @param context Chunker context
+ * @return Required buffer size in bytes
+ */
+size_t netchunk_chunker_buffer_size(const netchunk_chunker_context_t* context);
+
+/**
+ * @brief Get the next chunk, reading it into a caller-owned buffer
+ *
+ * Lets callers recycle a fixed set of buffers instead of allocating one
+ * per chunk. The chunk borrows the buffer (data_owned is false), so its
+ * data is only valid until the buffer is reused.
+ *
+ * @param context Chunker context
+ * @param chunk Output chunk structure
+ * @param buffer Buffer to read the chunk into
+ * @param buffer_size Size of buffer, at least netchunk_chunker_buffer_size()
+ * @return NETCHUNK_SUCCESS if chunk retrieved, NETCHUNK_ERROR_EOF if no more chunks
+ */
+netchunk_error_t netchunk_chunker_next_chunk_into(netchunk_chunker_context_t* context,
+    netchunk_chunk_t* chunk,
+    uint8_t* buffer,
+    size_t buffer_size);
+
 /**
  * @brief Check if more chunks are available
  * @param context Chunker context
@@ -168,21 +277,34 @@ netchunk_error_t netchunk_chunk_set_data(netchunk_chunk_t* chunk,
 
 /**
  * @brief Verify chunk data against stored hash
+ *
+ * The hash covers the raw bytes; data of a compressed or encrypted chunk is
+ * decoded first, and fails with NETCHUNK_ERROR_CHUNK_INTEGRITY if it cannot be.
+ *
  * @param chunk Chunk to verify
  * @return NETCHUNK_SUCCESS if hash matches, error code if corrupted
  */
 netchunk_error_t netchunk_chunk_verify_integrity(const netchunk_chunk_t* chunk);
 
+/**
+ * @brief Verify several chunks with one batched hash pass
+ * @param chunks Chunks to verify
+ * @param count Number of chunks
+ * @param results Per-chunk result, as netchunk_chunk_verify_integrity() would return
+ * @return NETCHUNK_SUCCESS if the batch was hashed, error code on failure
+ */
+netchunk_error_t netchunk_chunk_verify_batch(const netchunk_chunk_t* const* chunks,
+    size_t count,
+    netchunk_error_t* results);
+
 /**
  * @brief Add server location to chunk
  * @param chunk Target chunk
  * @param server_id Server index
- * @param remote_path Path on server
  * @return NETCHUNK_SUCCESS on success, error code on failure
  */
 netchunk_error_t netchunk_chunk_add_location(netchunk_chunk_t* chunk,
-    int server_id,
-    const char* remote_path);
+    int server_id);
 
 /**
  * @brief Remove server location from chunk
@@ -217,6 +339,9 @@ netchunk_chunk_location_t* netchunk_chunk_get_best_location(const netchunk_chunk
 
 /**
  * @brief Initialize file reconstruction from chunks
+ *
+ * Chunks may differ in size; their offsets must tile the file without gaps.
+ *
  * @param output_file_path Output file path
  * @param file_info File information structure
  * @param chunks Array of chunks to reconstruct from
@@ -258,15 +383,39 @@ netchunk_error_t netchunk_verify_reconstructed_file(const char* file_path,
  * @brief Generate unique chunk ID
  * @param chunk_id Output buffer for chunk ID (must be at least NETCHUNK_CHUNK_ID_LENGTH + 1)
  * @param sequence_number Sequence number to incorporate
- * @param file_hash Hash of source file
+ * @param upload_id Per-upload random salt (NETCHUNK_UPLOAD_ID_LENGTH bytes), so IDs
+ *        can be assigned before the file hash is known
  * @return NETCHUNK_SUCCESS on success, error code on failure
  */
 netchunk_error_t netchunk_generate_chunk_id(char* chunk_id,
     uint32_t sequence_number,
-    const uint8_t* file_hash);
+    const uint8_t* upload_id);
+
+/**
+ * @brief Name a chunk after its content
+ *
+ * Replaces the chunk ID with the hex SHA-256 of its data, so identical
+ * chunks share one remote object across uploads.
+ *
+ * @param chunk Chunk with its hash already computed
+ * @return NETCHUNK_SUCCESS on success, error code on failure
+ */
+netchunk_error_t netchunk_chunk_set_content_id(netchunk_chunk_t* chunk);
+
+/**
+ * @brief Check whether a chunk is named after its content
+ * @param chunk Chunk to check
+ * @return true if the chunk ID is the hex hash of its data
+ */
+bool netchunk_chunk_is_content_addressed(const netchunk_chunk_t* chunk);
 
 /**
  * @brief Calculate optimal number of chunks for file size
+ *
+ * Exact for fixed-size chunking. For content-defined chunking, pass the
+ * average size to get an estimate; the real count is only known once the
+ * file has been chunked.
+ *
  * @param file_size Size of file
  * @param target_chunk_size Target chunk size
  * @return Number of chunks needed
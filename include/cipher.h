@@ -0,0 +1,113 @@
+#ifndef NETCHUNK_CIPHER_H
+#define NETCHUNK_CIPHER_H
+
+#include "config.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Cipher constants
+#define NETCHUNK_CIPHER_KEY_LENGTH 32 // AES-256
+#define NETCHUNK_CIPHER_NONCE_LENGTH 12 // GCM nonce, fresh for every encryption
+#define NETCHUNK_CIPHER_TAG_LENGTH 16
+#define NETCHUNK_CIPHER_OVERHEAD (NETCHUNK_CIPHER_NONCE_LENGTH + NETCHUNK_CIPHER_TAG_LENGTH) // Trailer of every encrypted chunk
+#define NETCHUNK_KEY_ID_LENGTH 8 // Leading bytes of the key's SHA-256
+#define NETCHUNK_MAX_KEYS 16 // Keys the key ring can hold
+
+// Key Ring Functions
+
+/**
+ * @brief Load encryption keys from a key file into the process key ring
+ *
+ * The file holds one key per line as 64 hex digits; blank lines and lines
+ * starting with '#' are skipped. The first key encrypts new chunks, the
+ * others stay available to read chunks encrypted before a key rotation.
+ * The file must not be readable by group or others.
+ *
+ * @param path Key file path
+ * @param current_key_id Output ID of the first key
+ * @return NETCHUNK_SUCCESS on success, NETCHUNK_ERROR_FILE_NOT_FOUND if the
+ *         file does not exist, NETCHUNK_ERROR_CONFIG_VALIDATION if it is
+ *         malformed or too permissive, error code on failure
+ */
+netchunk_error_t netchunk_keyring_load_file(const char* path, uint8_t* current_key_id);
+
+/**
+ * @brief Add a key to the process key ring
+ *
+ * Adding a key that is already present is not an error.
+ *
+ * @param key NETCHUNK_CIPHER_KEY_LENGTH key bytes
+ * @param key_id Output key ID (can be NULL)
+ * @return NETCHUNK_SUCCESS on success, NETCHUNK_ERROR_CRYPTO if the ring is full
+ */
+netchunk_error_t netchunk_keyring_add(const uint8_t* key, uint8_t* key_id);
+
+/**
+ * @brief Check whether the key ring holds a key
+ * @param key_id Key ID
+ * @return true if chunks encrypted with the key can be decrypted
+ */
+bool netchunk_keyring_has(const uint8_t* key_id);
+
+/**
+ * @brief Remove every key from the process key ring
+ */
+void netchunk_keyring_clear(void);
+
+/**
+ * @brief Check whether a key ID is set
+ * @param key_id Key ID
+ * @return false if it is all zero (not encrypted)
+ */
+bool netchunk_key_id_is_set(const uint8_t* key_id);
+
+// Chunk Cipher Functions
+
+/**
+ * @brief Encrypt a chunk's stored form in place with AES-256-GCM
+ *
+ * Every encryption draws a fresh random nonce, written with the tag in a
+ * trailer after the ciphertext so the data never moves. The chunk ID is
+ * authenticated too, so a chunk cannot be passed off under another ID.
+ * OpenSSL uses AES-NI or the ARMv8 crypto extensions where the CPU has
+ * them. Cipher contexts are cached per thread.
+ *
+ * @param key_id Key to encrypt with
+ * @param chunk_id ID the chunk is stored under
+ * @param data Buffer of at least size + NETCHUNK_CIPHER_OVERHEAD bytes
+ * @param size Plaintext bytes; the trailer is written after them
+ * @return NETCHUNK_SUCCESS on success, NETCHUNK_ERROR_CRYPTO if the key is
+ *         not in the key ring or encryption fails
+ */
+netchunk_error_t netchunk_cipher_encrypt(const uint8_t* key_id,
+    const char* chunk_id,
+    uint8_t* data,
+    size_t size);
+
+/**
+ * @brief Decrypt and authenticate data produced by netchunk_cipher_encrypt()
+ * @param key_id Key the data was encrypted with
+ * @param chunk_id ID the chunk is stored under
+ * @param src Ciphertext followed by the trailer
+ * @param stored_size Bytes of src, including the trailer
+ * @param dst Output buffer of stored_size - NETCHUNK_CIPHER_OVERHEAD bytes (may be src)
+ * @return NETCHUNK_SUCCESS on success, NETCHUNK_ERROR_CHUNK_INTEGRITY if the
+ *         data fails authentication, NETCHUNK_ERROR_CRYPTO if the key is not
+ *         in the key ring, error code on failure
+ */
+netchunk_error_t netchunk_cipher_decrypt(const uint8_t* key_id,
+    const char* chunk_id,
+    const uint8_t* src,
+    size_t stored_size,
+    uint8_t* dst);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NETCHUNK_CIPHER_H
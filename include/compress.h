@@ -0,0 +1,135 @@
+#ifndef NETCHUNK_COMPRESS_H
+#define NETCHUNK_COMPRESS_H
+
+#include "chunker.h"
+#include "config.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Compression constants
+#define NETCHUNK_COMPRESS_SAMPLE_SIZE (32 * 1024) // Bytes per trial-compressed sample
+#define NETCHUNK_COMPRESS_SAMPLES 4 // Samples spread over a large chunk
+#define NETCHUNK_COMPRESS_MIN_SAVINGS 10 // Percent a chunk must shrink by to be stored compressed
+
+// Codec Functions
+
+/**
+ * @brief Check whether a codec was compiled in
+ * @param codec Codec to check
+ * @return true if chunks can be compressed and decompressed with it
+ */
+bool netchunk_compress_available(netchunk_compression_t codec);
+
+/**
+ * @brief Largest output netchunk_compress() can produce
+ * @param codec Codec
+ * @param size Input bytes
+ * @return Output buffer size to allocate, 0 if the codec is unavailable
+ */
+size_t netchunk_compress_bound(netchunk_compression_t codec, size_t size);
+
+/**
+ * @brief Compress a chunk unless it does not pay off
+ *
+ * Large inputs are judged from a few samples first, so incompressible data
+ * (media, archives, encrypted files) costs a fraction of a full pass. Output
+ * that does not save NETCHUNK_COMPRESS_MIN_SAVINGS percent is discarded.
+ * Compression contexts are cached per thread.
+ *
+ * @param codec Codec to use
+ * @param level Codec level (1 = fastest)
+ * @param src Raw data
+ * @param size Raw bytes
+ * @param dst Output buffer
+ * @param capacity Output buffer size, at least netchunk_compress_bound()
+ * @param stored_size Output compressed bytes, 0 if the data should be stored raw
+ * @return NETCHUNK_SUCCESS on success, error code on failure
+ */
+netchunk_error_t netchunk_compress(netchunk_compression_t codec,
+    int level,
+    const uint8_t* src,
+    size_t size,
+    uint8_t* dst,
+    size_t capacity,
+    size_t* stored_size);
+
+/**
+ * @brief Decompress data produced by netchunk_compress()
+ * @param codec Codec the data was compressed with
+ * @param src Compressed data
+ * @param stored_size Compressed bytes
+ * @param dst Output buffer
+ * @param size Expected raw bytes; anything else is an error
+ * @return NETCHUNK_SUCCESS on success, NETCHUNK_ERROR_CHUNK_INTEGRITY if the
+ *         data is malformed or decodes to another size, error code on failure
+ */
+netchunk_error_t netchunk_decompress(netchunk_compression_t codec,
+    const uint8_t* src,
+    size_t stored_size,
+    uint8_t* dst,
+    size_t size);
+
+// Chunk Functions
+
+/**
+ * @brief Check whether a chunk is stored in another form than its raw bytes
+ * @param chunk Chunk
+ * @return true if the chunk is compressed or encrypted
+ */
+bool netchunk_chunk_is_encoded(const netchunk_chunk_t* chunk);
+
+/**
+ * @brief Bytes a chunk occupies on its servers
+ * @param chunk Chunk
+ * @return stored_size for compressed or encrypted chunks, size otherwise
+ */
+size_t netchunk_chunk_stored_size(const netchunk_chunk_t* chunk);
+
+/**
+ * @brief Decode a chunk's stored data into its raw bytes
+ *
+ * Encrypted data is authenticated and decrypted, then decompressed.
+ *
+ * @param chunk Chunk whose data holds the stored form
+ * @param raw Output buffer of chunk->size bytes
+ * @return NETCHUNK_SUCCESS on success, NETCHUNK_ERROR_CHUNK_INTEGRITY if the
+ *         data cannot be decoded, NETCHUNK_ERROR_CRYPTO if its key is not in
+ *         the key ring, error code on failure
+ */
+netchunk_error_t netchunk_chunk_decode(const netchunk_chunk_t* chunk, uint8_t* raw);
+
+/**
+ * @brief Verify a chunk's raw bytes against its hash
+ * @param chunk Chunk
+ * @param raw chunk->size raw bytes, such as the output of netchunk_chunk_decode()
+ * @return NETCHUNK_SUCCESS if the hash matches, NETCHUNK_ERROR_CHUNK_INTEGRITY if not
+ */
+netchunk_error_t netchunk_chunk_verify_raw(const netchunk_chunk_t* chunk, const uint8_t* raw);
+
+/**
+ * @brief Give a chunk its stored form again from a raw copy
+ *
+ * Used to restore replicas from raw bytes, such as the local chunk cache or
+ * rebuilt erasure-coded shards. A compressed chunk is compressed again and
+ * an encrypted one encrypted again with its recorded key; the result is only
+ * accepted at the stored size its manifest records. Any data the chunk held
+ * before is left to the caller.
+ *
+ * @param chunk Chunk; on success it owns its stored data
+ * @param level Codec level to compress with
+ * @param raw chunk->size raw bytes, taken over (freed or kept) either way
+ * @return NETCHUNK_SUCCESS on success, NETCHUNK_ERROR_CHUNK_INTEGRITY if the
+ *         result has another size, error code on failure
+ */
+netchunk_error_t netchunk_chunk_restore_stored(netchunk_chunk_t* chunk, int level, uint8_t* raw);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NETCHUNK_COMPRESS_H
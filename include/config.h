@@ -28,6 +28,15 @@ typedef enum netchunk_log_level netchunk_log_level_t;
 #define NETCHUNK_MIN_REPLICATION_FACTOR 1
 #define NETCHUNK_MAX_REPLICATION_FACTOR 10
 #define NETCHUNK_DEFAULT_REPLICATION_FACTOR 3
+#define NETCHUNK_DEFAULT_READ_CACHE_SIZE (64 * 1024 * 1024) // 64MB
+#define NETCHUNK_MAX_READ_CACHE_SIZE ((size_t)16 * 1024 * 1024 * 1024) // 16GB
+#define NETCHUNK_DEFAULT_SCRUB_INTERVAL (7 * 24 * 3600) // One week
+#define NETCHUNK_DEFAULT_SCRUB_BANDWIDTH (10 * 1024 * 1024) // 10MB per second
+#define NETCHUNK_DEFAULT_REPAIR_WORKERS 4
+#define NETCHUNK_DEFAULT_REPAIR_MAX_PER_SERVER 2
+#define NETCHUNK_MAX_REPAIR_WORKERS 64
+#define NETCHUNK_DEFAULT_COMPRESSION_LEVEL 3
+#define NETCHUNK_MAX_COMPRESSION_LEVEL 19
 
 // Error codes
 typedef enum netchunk_error {
@@ -62,6 +71,24 @@ typedef enum netchunk_log_level {
     NETCHUNK_LOG_DEBUG = 3
 } netchunk_log_level_t;
 
+// Chunk boundary selection
+typedef enum netchunk_chunking_mode {
+    NETCHUNK_CHUNKING_FIXED = 0, // Split every chunk_size bytes
+    NETCHUNK_CHUNKING_CDC = 1 // Content-defined (FastCDC), chunk_size is the average
+} netchunk_chunking_mode_t;
+
+// Chunk compression codecs
+typedef enum netchunk_compression {
+    NETCHUNK_COMPRESSION_NONE = 0, // Stored as read
+    NETCHUNK_COMPRESSION_ZSTD = 1 // Zstandard
+} netchunk_compression_t;
+
+// Format of the metrics written to monitoring_data_path
+typedef enum netchunk_monitoring_format {
+    NETCHUNK_MONITORING_PROMETHEUS = 0, // Prometheus text exposition format
+    NETCHUNK_MONITORING_JSON = 1
+} netchunk_monitoring_format_t;
+
 // Server connection status
 typedef enum netchunk_server_status {
     NETCHUNK_SERVER_UNKNOWN = 0,
@@ -84,6 +111,8 @@ typedef struct netchunk_server {
     netchunk_server_status_t status;
     time_t last_health_check;
     double last_latency_ms;
+    int max_connections; // Pooled connections (0 = max_concurrent_operations)
+    bool fxp; // Accepts server-to-server (FXP) copies from other fxp servers
     uint64_t bytes_available;
     uint64_t bytes_used;
 } netchunk_server_t;
@@ -92,11 +121,25 @@ typedef struct netchunk_server {
 typedef struct netchunk_config {
     // General settings
     size_t chunk_size;
+    netchunk_chunking_mode_t chunking_mode;
+    netchunk_compression_t compression; // Codec applied to chunks before upload
+    int compression_level; // Codec level, 1 is fastest
+    bool content_addressed; // Name chunks by hash and deduplicate across files
+    char dedup_index_path[NETCHUNK_MAX_PATH_LEN]; // Local hash -> locations/refcount index
     int replication_factor;
+    int erasure_data_shards; // Data chunks per Reed-Solomon stripe (0 = replicate chunks instead)
+    int erasure_parity_shards; // Parity chunks per stripe, any this many per stripe may be lost
     int max_concurrent_operations;
     int ftp_timeout;
     int max_retry_attempts; // Maximum retry attempts for operations
+    int connection_idle_timeout; // Seconds before an idle pooled connection is closed
+    int hedge_budget_percent; // Backup chunk requests allowed per 100 downloads (0 = no hedging)
     char local_storage_path[NETCHUNK_MAX_PATH_LEN];
+    int catalog_sync_interval; // Seconds a synced file catalog answers listings (0 = sync every time)
+    size_t read_cache_size; // Bytes of chunk data kept in memory for ranged reads (0 = no caching)
+    size_t chunk_cache_size; // Bytes of chunk data kept on disk under local_storage_path (0 = disabled)
+    char daemon_socket_path[NETCHUNK_MAX_PATH_LEN]; // Unix socket of the background daemon
+    bool background_delete; // Remove a deleted file's chunks after delete returns
     netchunk_log_level_t log_level;
     char log_file[NETCHUNK_MAX_PATH_LEN];
     bool health_monitoring_enabled;
@@ -111,17 +154,25 @@ typedef struct netchunk_config {
     int max_repair_attempts;
     int repair_delay;
     bool rebalancing_enabled;
+    int scrub_interval; // Seconds between background scrub passes (0 = no background scrubbing)
+    size_t scrub_bandwidth; // Bytes per second a scrub may read from the servers (0 = unlimited)
+    bool scrub_deep; // Download a rotating sample of replicas, not only check them remotely
+    int repair_workers; // Chunks checked or repaired at once by a repair run
+    int repair_max_per_server; // Repair requests in flight per server
+    size_t repair_bandwidth; // Bytes per second repairs may move per server (0 = unlimited)
 
     // Monitoring settings
     int storage_alert_threshold;
     int latency_alert_threshold;
-    bool performance_logging;
+    bool performance_logging; // Time hot path phases and dump them to monitoring_data_path
     char monitoring_data_path[NETCHUNK_MAX_PATH_LEN];
+    netchunk_monitoring_format_t monitoring_format;
 
     // Security settings
     bool verify_ssl_certificates;
     bool always_verify_integrity;
     bool encrypt_chunks;
+    char encryption_key_file[NETCHUNK_MAX_PATH_LEN]; // Hex keys, one per line, the first encrypts new chunks
 } netchunk_config_t;
 
 // Configuration parsing functions
@@ -133,6 +184,12 @@ netchunk_error_t netchunk_config_find_file(char* config_path, size_t path_len);
 const char* netchunk_error_string(netchunk_error_t error);
 netchunk_log_level_t netchunk_log_level_from_string(const char* level_str);
 const char* netchunk_log_level_to_string(netchunk_log_level_t level);
+netchunk_chunking_mode_t netchunk_chunking_mode_from_string(const char* mode_str);
+const char* netchunk_chunking_mode_to_string(netchunk_chunking_mode_t mode);
+netchunk_compression_t netchunk_compression_from_string(const char* codec_str);
+const char* netchunk_compression_to_string(netchunk_compression_t codec);
+netchunk_monitoring_format_t netchunk_monitoring_format_from_string(const char* format_str);
+const char* netchunk_monitoring_format_to_string(netchunk_monitoring_format_t format);
 netchunk_error_t netchunk_config_expand_path(const char* path, char* expanded_path, size_t max_len);
 void netchunk_config_cleanup(netchunk_config_t* config);
 
@@ -2,6 +2,7 @@
 #define NETCHUNK_CRYPTO_H
 
 #include "config.h"
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
@@ -13,6 +14,19 @@ extern "C" {
 #define NETCHUNK_SHA256_DIGEST_LENGTH 32
 #define NETCHUNK_SHA256_BLOCK_SIZE 64
 
+// Most messages hashed together by one multi-buffer pass
+#define NETCHUNK_SHA256_MAX_LANES 8
+
+// SHA-256 implementations selectable at runtime
+typedef enum netchunk_sha256_backend {
+    NETCHUNK_SHA256_BACKEND_AUTO = -1, // Best backend detected on this CPU
+    NETCHUNK_SHA256_BACKEND_GENERIC = 0, // Portable C implementation
+    NETCHUNK_SHA256_BACKEND_SHANI, // x86 SHA extensions
+    NETCHUNK_SHA256_BACKEND_ARMV8, // ARMv8 SHA2 instructions
+    NETCHUNK_SHA256_BACKEND_AVX2, // 8-lane AVX2 multi-buffer, batch hashing only
+    NETCHUNK_SHA256_BACKEND_COUNT
+} netchunk_sha256_backend_t;
+
 // Hash context for streaming operations
 typedef struct netchunk_sha256_context {
     uint32_t state[8];
@@ -69,6 +83,66 @@ netchunk_error_t netchunk_sha256_hash(const uint8_t* data,
 netchunk_error_t netchunk_sha256_hash_file(const char* file_path,
     uint8_t* hash);
 
+/**
+ * @brief Hash several independent buffers in one call
+ *
+ * Used for batch verification. With the AVX2 backend up to
+ * NETCHUNK_SHA256_MAX_LANES messages are hashed side by side; otherwise
+ * each message goes through the single-stream backend.
+ *
+ * @param data Array of message pointers
+ * @param data_len Array of message lengths
+ * @param count Number of messages
+ * @param hashes Array of output buffers (each NETCHUNK_SHA256_DIGEST_LENGTH bytes)
+ * @return NETCHUNK_SUCCESS on success, error code on failure
+ */
+netchunk_error_t netchunk_sha256_hash_batch(const uint8_t* const* data,
+    const size_t* data_len,
+    size_t count,
+    uint8_t* const* hashes);
+
+// Backend Selection
+
+/**
+ * @brief Check whether a SHA-256 backend can run on this CPU
+ * @param backend Backend to check
+ * @return true if the backend is compiled in and supported by the CPU
+ */
+bool netchunk_sha256_backend_available(netchunk_sha256_backend_t backend);
+
+/**
+ * @brief Force a SHA-256 backend instead of the detected one
+ *
+ * GENERIC, SHANI and ARMV8 replace the single-stream implementation used by
+ * every netchunk_sha256_* call, and batch hashing then loops over it. AVX2
+ * only replaces batch hashing. AUTO restores the detected defaults. Not
+ * safe to call while other threads are hashing.
+ *
+ * @param backend Backend to use
+ * @return NETCHUNK_SUCCESS on success, NETCHUNK_ERROR_CRYPTO if the backend
+ *         is not available, NETCHUNK_ERROR_INVALID_ARGUMENT if it is unknown
+ */
+netchunk_error_t netchunk_sha256_set_backend(netchunk_sha256_backend_t backend);
+
+/**
+ * @brief Get the backend used for single-stream hashing
+ * @return Active single-stream backend
+ */
+netchunk_sha256_backend_t netchunk_sha256_get_backend(void);
+
+/**
+ * @brief Get the backend used by netchunk_sha256_hash_batch()
+ * @return Active batch backend
+ */
+netchunk_sha256_backend_t netchunk_sha256_get_batch_backend(void);
+
+/**
+ * @brief Get a printable backend name
+ * @param backend Backend
+ * @return Static name string ("unknown" for invalid values)
+ */
+const char* netchunk_sha256_backend_name(netchunk_sha256_backend_t backend);
+
 // Utility Functions
 
 /**
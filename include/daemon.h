@@ -0,0 +1,231 @@
+#ifndef NETCHUNK_DAEMON_H
+#define NETCHUNK_DAEMON_H
+
+#include "netchunk.h"
+#include "scrub.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Forward declarations
+typedef struct netchunk_daemon netchunk_daemon_t;
+typedef struct netchunk_daemon_client netchunk_daemon_client_t;
+
+// Daemon protocol constants
+#define NETCHUNK_DAEMON_PROTOCOL_VERSION 3
+#define NETCHUNK_DAEMON_IO_TIMEOUT 30 // Seconds a client may stall sending or reading
+#define NETCHUNK_DAEMON_SCRUB_START_DELAY 300 // Seconds after startup before the first scrub pass
+
+/**
+ * @brief Long-running server that executes requests on one warm context
+ *
+ * Listens on a Unix socket and runs upload/download/list/delete/verify and
+ * health requests against a context that stays initialized, so the FTP
+ * pool, the transfer engine's cached connections and TLS sessions and the
+ * server health state survive between requests. Files are never sent
+ * through the socket: clients pass open descriptors, so the daemon only
+ * touches files the client itself could open. Requests run one at a time
+ * because they share the context's progress callback and dedup index;
+ * each one still fans out across servers internally. While idle, the
+ * daemon scrubs the stored replicas when scrub_interval is set, one chunk
+ * at a time between requests.
+ */
+typedef struct netchunk_daemon {
+    netchunk_context_t* context; // Warm context (not owned)
+    char socket_path[NETCHUNK_MAX_PATH_LEN]; // Expanded socket path
+    int listen_fd; // Listening socket
+    int wake_pipe[2]; // Self-pipe for netchunk_daemon_stop()
+    int client_fd; // Client of the request being served, -1 if none
+    uint64_t requests_served; // Completed requests
+    netchunk_scrubber_t scrubber; // Background scrubber, if scrubbing
+    bool scrubbing; // Whether scrub_interval enabled the scrubber
+    double next_scrub_ms; // Monotonic time of the next scrub step
+} netchunk_daemon_t;
+
+/**
+ * @brief Connection from a CLI process to a running daemon
+ */
+typedef struct netchunk_daemon_client {
+    int fd; // Connected socket, -1 if not connected
+    netchunk_progress_callback_t progress_cb; // Receives forwarded progress (optional)
+    void* progress_userdata; // Progress callback user data
+} netchunk_daemon_client_t;
+
+// Daemon Functions
+
+/**
+ * @brief Create the daemon's listening socket
+ *
+ * A stale socket left by a dead daemon is replaced; a live one is not.
+ *
+ * @param daemon Daemon to initialize
+ * @param context Initialized NetChunk context, kept warm by the daemon
+ * @param socket_path Unix socket path (~ is expanded)
+ * @return NETCHUNK_SUCCESS on success, NETCHUNK_ERROR_CONFIG if a daemon
+ *         already listens there, error code on failure
+ */
+netchunk_error_t netchunk_daemon_init(netchunk_daemon_t* daemon,
+    netchunk_context_t* context,
+    const char* socket_path);
+
+/**
+ * @brief Serve requests until netchunk_daemon_stop() or a shutdown request
+ * @param daemon Initialized daemon
+ * @return NETCHUNK_SUCCESS once stopped, error code on failure
+ */
+netchunk_error_t netchunk_daemon_run(netchunk_daemon_t* daemon);
+
+/**
+ * @brief Ask a running daemon loop to return
+ *
+ * Async-signal-safe, so it can be called from a SIGTERM handler. A request
+ * in progress is finished first.
+ *
+ * @param daemon Daemon to stop
+ */
+void netchunk_daemon_stop(netchunk_daemon_t* daemon);
+
+/**
+ * @brief Close the socket and remove it from the filesystem
+ * @param daemon Daemon to cleanup
+ */
+void netchunk_daemon_cleanup(netchunk_daemon_t* daemon);
+
+// Client Functions
+
+/**
+ * @brief Connect to a daemon
+ * @param client Client to initialize
+ * @param socket_path Unix socket path (~ is expanded)
+ * @return NETCHUNK_SUCCESS if connected, NETCHUNK_ERROR_SERVER_UNAVAILABLE if
+ *         no daemon is listening, error code on failure
+ */
+netchunk_error_t netchunk_daemon_connect(netchunk_daemon_client_t* client, const char* socket_path);
+
+/**
+ * @brief Forward progress reported by the daemon to a callback
+ * @param client Connected client
+ * @param callback Progress callback function
+ * @param userdata User data passed to callback
+ */
+void netchunk_daemon_client_set_progress_callback(netchunk_daemon_client_t* client,
+    netchunk_progress_callback_t callback,
+    void* userdata);
+
+/**
+ * @brief Close the connection
+ * @param client Client to disconnect
+ */
+void netchunk_daemon_disconnect(netchunk_daemon_client_t* client);
+
+/**
+ * @brief Upload through the daemon, as netchunk_upload_stream()
+ * @param client Connected client
+ * @param input_fd Readable descriptor (file or pipe), passed to the daemon
+ * @param remote_name Remote file name identifier
+ * @param stats Optional statistics output (can be NULL)
+ * @return Result of the upload in the daemon
+ */
+netchunk_error_t netchunk_daemon_upload(netchunk_daemon_client_t* client,
+    int input_fd,
+    const char* remote_name,
+    netchunk_stats_t* stats);
+
+/**
+ * @brief Download through the daemon, as netchunk_download_fd()
+ * @param client Connected client
+ * @param output_fd Writable regular file descriptor, passed to the daemon
+ * @param remote_name Remote file name identifier
+ * @param stats Optional statistics output (can be NULL)
+ * @return Result of the download in the daemon
+ */
+netchunk_error_t netchunk_daemon_download(netchunk_daemon_client_t* client,
+    const char* remote_name,
+    int output_fd,
+    netchunk_stats_t* stats);
+
+/**
+ * @brief List files through the daemon, as netchunk_list_files()
+ *
+ * Only the summary fields (name, size, chunk count, timestamps) are filled;
+ * chunks are not transferred.
+ *
+ * @param client Connected client
+ * @param files Output array, freed with netchunk_free_file_list()
+ * @param count Output number of files
+ * @return Result of the listing in the daemon
+ */
+netchunk_error_t netchunk_daemon_list_files(netchunk_daemon_client_t* client,
+    netchunk_file_manifest_t** files,
+    size_t* count);
+
+/**
+ * @brief Delete through the daemon, as netchunk_delete()
+ * @param client Connected client
+ * @param remote_name Remote file name identifier
+ * @return Result of the delete in the daemon
+ */
+netchunk_error_t netchunk_daemon_delete(netchunk_daemon_client_t* client, const char* remote_name);
+
+/**
+ * @brief Verify through the daemon, as netchunk_verify()
+ * @param client Connected client
+ * @param remote_name Remote file name identifier
+ * @param repair If true, attempt to repair any issues found
+ * @param chunks_verified Output number of chunks verified (optional)
+ * @param chunks_repaired Output number of chunks repaired (optional)
+ * @return Result of the verification in the daemon
+ */
+netchunk_error_t netchunk_daemon_verify(netchunk_daemon_client_t* client,
+    const char* remote_name,
+    bool repair,
+    uint32_t* chunks_verified,
+    uint32_t* chunks_repaired);
+
+/**
+ * @brief Health check through the daemon, as netchunk_health_check()
+ * @param client Connected client
+ * @param healthy_servers Output number of healthy servers (optional)
+ * @param total_servers Output number of configured servers (optional)
+ * @return Result of the health check in the daemon
+ */
+netchunk_error_t netchunk_daemon_health_check(netchunk_daemon_client_t* client,
+    uint32_t* healthy_servers,
+    uint32_t* total_servers);
+
+/**
+ * @brief Health check through the daemon, with the daemon's server scores
+ *
+ * The daemon's scores cover every transfer it has run, so they are more
+ * telling than those of a context that just started.
+ *
+ * @param client Connected client
+ * @param healthy_servers Output number of healthy servers (optional)
+ * @param total_servers Output number of configured servers (optional)
+ * @param scores Output array, one score per server in configuration order (optional)
+ * @param max_scores Capacity of scores
+ * @param score_count Output number of scores written (optional)
+ * @return Result of the health check in the daemon
+ */
+netchunk_error_t netchunk_daemon_health_report(netchunk_daemon_client_t* client,
+    uint32_t* healthy_servers,
+    uint32_t* total_servers,
+    netchunk_server_score_t* scores,
+    int max_scores,
+    int* score_count);
+
+/**
+ * @brief Ask the daemon to exit once this request is answered
+ * @param client Connected client
+ * @return NETCHUNK_SUCCESS if the daemon acknowledged
+ */
+netchunk_error_t netchunk_daemon_shutdown(netchunk_daemon_client_t* client);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NETCHUNK_DAEMON_H
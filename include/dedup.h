@@ -0,0 +1,134 @@
+#ifndef NETCHUNK_DEDUP_H
+#define NETCHUNK_DEDUP_H
+
+#include "chunker.h"
+#include "config.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Forward declarations
+typedef struct netchunk_dedup_entry netchunk_dedup_entry_t;
+typedef struct netchunk_dedup_index netchunk_dedup_index_t;
+
+// Dedup index constants
+#define NETCHUNK_DEDUP_INDEX_VERSION "1.0"
+#define NETCHUNK_DEDUP_INITIAL_CAPACITY 1024 // Slots, always a power of two
+
+/**
+ * @brief One content-addressed chunk known to the index
+ *
+ * Servers are interned in the index so an entry only keeps a bitmask of
+ * the servers holding a replica.
+ */
+typedef struct netchunk_dedup_entry {
+    uint8_t hash[NETCHUNK_HASH_LENGTH]; // SHA-256 of the chunk data (the key)
+    size_t size; // Chunk size in bytes
+    uint32_t refcount; // Manifest references to this chunk
+    uint32_t server_mask; // Bit i set if server_ids[i] holds a replica
+    bool used; // Slot holds an entry
+} netchunk_dedup_entry_t;
+
+/**
+ * @brief Local index of content-addressed chunks (hash -> locations, refcount)
+ *
+ * Open-addressed hash table persisted as JSON. The index is owned by a
+ * single process at a time; concurrent writers to the same file are not
+ * coordinated.
+ */
+typedef struct netchunk_dedup_index {
+    char path[NETCHUNK_MAX_PATH_LEN]; // Backing file
+    netchunk_dedup_entry_t* entries; // Hash table slots
+    size_t capacity; // Number of slots
+    size_t count; // Used slots
+    char server_ids[NETCHUNK_MAX_SERVERS][NETCHUNK_MAX_SERVER_ID_LEN]; // Interned server IDs
+    int server_count; // Interned server count
+    bool dirty; // Modified since last load/save
+} netchunk_dedup_index_t;
+
+/**
+ * @brief Initialize an empty dedup index
+ * @param index Index to initialize
+ * @param path Backing file path (~ is expanded)
+ * @return NETCHUNK_SUCCESS on success, error code on failure
+ */
+netchunk_error_t netchunk_dedup_index_init(netchunk_dedup_index_t* index, const char* path);
+
+/**
+ * @brief Load the index from its backing file
+ *
+ * A missing file leaves the index empty.
+ *
+ * @param index Initialized index
+ * @return NETCHUNK_SUCCESS on success, error code on failure
+ */
+netchunk_error_t netchunk_dedup_index_load(netchunk_dedup_index_t* index);
+
+/**
+ * @brief Write the index to its backing file atomically
+ * @param index Index to save
+ * @return NETCHUNK_SUCCESS on success, error code on failure
+ */
+netchunk_error_t netchunk_dedup_index_save(netchunk_dedup_index_t* index);
+
+/**
+ * @brief Free index resources
+ * @param index Index to cleanup
+ */
+void netchunk_dedup_index_cleanup(netchunk_dedup_index_t* index);
+
+/**
+ * @brief Find the entry for a chunk hash
+ * @param index Dedup index
+ * @param hash Chunk hash (NETCHUNK_HASH_LENGTH bytes)
+ * @return Entry if known, NULL otherwise
+ */
+const netchunk_dedup_entry_t* netchunk_dedup_index_lookup(const netchunk_dedup_index_t* index,
+    const uint8_t* hash);
+
+/**
+ * @brief Check whether an entry records a replica on a server
+ * @param index Dedup index
+ * @param entry Entry returned by netchunk_dedup_index_lookup()
+ * @param server_id Server ID
+ * @return true if the server holds a replica
+ */
+bool netchunk_dedup_entry_has_server(const netchunk_dedup_index_t* index,
+    const netchunk_dedup_entry_t* entry,
+    const char* server_id);
+
+/**
+ * @brief Add a manifest reference to a chunk
+ *
+ * Creates the entry if needed and merges the chunk's locations into it.
+ *
+ * @param index Dedup index
+ * @param chunk Content-addressed chunk with its locations
+ * @return NETCHUNK_SUCCESS on success, error code on failure
+ */
+netchunk_error_t netchunk_dedup_index_add_ref(netchunk_dedup_index_t* index,
+    const netchunk_chunk_t* chunk);
+
+/**
+ * @brief Drop a manifest reference to a chunk
+ *
+ * The entry is removed once no references remain; the caller then owns
+ * deleting the chunk from its servers.
+ *
+ * @param index Dedup index
+ * @param hash Chunk hash
+ * @param remaining Output references left (optional)
+ * @return NETCHUNK_SUCCESS on success, NETCHUNK_ERROR_FILE_NOT_FOUND if unknown
+ */
+netchunk_error_t netchunk_dedup_index_release(netchunk_dedup_index_t* index,
+    const uint8_t* hash,
+    uint32_t* remaining);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NETCHUNK_DEDUP_H
@@ -0,0 +1,164 @@
+#ifndef NETCHUNK_DELETE_QUEUE_H
+#define NETCHUNK_DELETE_QUEUE_H
+
+#include "config.h"
+#include "ftp_client.h"
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Forward declarations
+typedef struct netchunk_delete_item netchunk_delete_item_t;
+typedef struct netchunk_delete_queue_stats netchunk_delete_queue_stats_t;
+typedef struct netchunk_delete_queue netchunk_delete_queue_t;
+
+// Delete queue constants
+#define NETCHUNK_DELETE_QUEUE_MAX_ATTEMPTS 5 // Tries per removal before it is given up
+#define NETCHUNK_DELETE_QUEUE_RETRY_DELAY 30 // Seconds before the first retry, doubled for each later one
+#define NETCHUNK_DELETE_QUEUE_ROUND_SIZE 4096 // Removals sent together by one round of the worker
+
+/**
+ * @brief One remote file waiting to be deleted
+ */
+typedef struct netchunk_delete_item {
+    int server_index; // Index into config->servers
+    char* remote_path; // Path relative to the server's base_path, owned by the holder
+    int attempts; // Tries so far
+    time_t retry_at; // Earliest time of the next try
+} netchunk_delete_item_t;
+
+/**
+ * @brief Counters of a delete queue
+ */
+typedef struct netchunk_delete_queue_stats {
+    uint64_t queued; // Removals pushed
+    uint64_t deleted; // Files removed, or found already gone
+    uint64_t retried; // Failed tries put back for another attempt
+    uint64_t abandoned; // Removals given up after NETCHUNK_DELETE_QUEUE_MAX_ATTEMPTS
+    uint64_t pending; // Removals still queued or being sent
+} netchunk_delete_queue_stats_t;
+
+/**
+ * @brief Remote files to delete in the background
+ *
+ * A worker thread sends the due removals in rounds through
+ * netchunk_ftp_delete_many(), so they are batched per server and all
+ * servers are worked on at once. Failed removals are queued again with
+ * exponential backoff until NETCHUNK_DELETE_QUEUE_MAX_ATTEMPTS tries have
+ * failed; files already gone count as deleted. Thread-safe.
+ */
+typedef struct netchunk_delete_queue {
+    netchunk_ftp_context_t* ftp_context;
+    netchunk_delete_item_t* items; // Waiting removals, in no particular order
+    size_t count;
+    size_t capacity;
+    size_t in_flight; // Taken for a round and not settled yet
+    int flushing; // Callers waiting in flush; retries are due at once
+    netchunk_delete_queue_stats_t stats;
+
+    pthread_mutex_t mutex;
+    pthread_cond_t changed; // Removals were queued or settled, or the worker should stop
+    pthread_t thread;
+    bool thread_running;
+    bool stopping;
+} netchunk_delete_queue_t;
+
+/**
+ * @brief Initialize an empty delete queue without starting its worker
+ * @param queue Queue to initialize
+ * @param ftp_context FTP context the removals are sent through
+ * @return NETCHUNK_SUCCESS on success, error code on failure
+ */
+netchunk_error_t netchunk_delete_queue_init(netchunk_delete_queue_t* queue, netchunk_ftp_context_t* ftp_context);
+
+/**
+ * @brief Start the worker thread that sends queued removals
+ * @param queue Initialized queue
+ * @return NETCHUNK_SUCCESS on success, error code on failure
+ */
+netchunk_error_t netchunk_delete_queue_start(netchunk_delete_queue_t* queue);
+
+/**
+ * @brief Queue a remote file for deletion
+ * @param queue Initialized queue
+ * @param server_index Server holding the file
+ * @param remote_path Path relative to the server's base_path (copied)
+ * @return NETCHUNK_SUCCESS on success, error code on failure
+ */
+netchunk_error_t netchunk_delete_queue_push(netchunk_delete_queue_t* queue,
+    int server_index,
+    const char* remote_path);
+
+/**
+ * @brief Take removals that are due for a round
+ *
+ * The caller owns the taken items until it hands them back with
+ * netchunk_delete_queue_settle().
+ *
+ * @param queue Initialized queue
+ * @param now Current time
+ * @param items Output removals
+ * @param max Capacity of items
+ * @return Number of removals taken
+ */
+size_t netchunk_delete_queue_take(netchunk_delete_queue_t* queue,
+    time_t now,
+    netchunk_delete_item_t* items,
+    size_t max);
+
+/**
+ * @brief Record the outcome of a round
+ *
+ * Deleted files and files already gone are done with; other failures are
+ * queued again or, after their last attempt, given up.
+ *
+ * @param queue Initialized queue
+ * @param items Removals taken with netchunk_delete_queue_take()
+ * @param results Result of each removal
+ * @param count Number of removals
+ * @param now Current time
+ */
+void netchunk_delete_queue_settle(netchunk_delete_queue_t* queue,
+    netchunk_delete_item_t* items,
+    const netchunk_error_t* results,
+    size_t count,
+    time_t now);
+
+/**
+ * @brief Wait until every queued removal is done or given up
+ *
+ * Backoff is skipped while flushing. Without a running worker the rounds
+ * run on the calling thread.
+ *
+ * @param queue Initialized queue
+ * @return NETCHUNK_SUCCESS if nothing was given up, NETCHUNK_ERROR_FTP otherwise
+ */
+netchunk_error_t netchunk_delete_queue_flush(netchunk_delete_queue_t* queue);
+
+/**
+ * @brief Copy a delete queue's counters
+ * @param queue Initialized queue
+ * @param stats Output counters
+ */
+void netchunk_delete_queue_get_stats(netchunk_delete_queue_t* queue, netchunk_delete_queue_stats_t* stats);
+
+/**
+ * @brief Stop the worker and release the queue
+ *
+ * Removals still queued are dropped; flush first to send them.
+ *
+ * @param queue Queue to clean up
+ */
+void netchunk_delete_queue_cleanup(netchunk_delete_queue_t* queue);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NETCHUNK_DELETE_QUEUE_H
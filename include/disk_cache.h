@@ -0,0 +1,152 @@
+#ifndef NETCHUNK_DISK_CACHE_H
+#define NETCHUNK_DISK_CACHE_H
+
+#include "chunker.h"
+#include "config.h"
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Forward declarations
+typedef struct netchunk_disk_cache_entry netchunk_disk_cache_entry_t;
+typedef struct netchunk_disk_cache netchunk_disk_cache_t;
+typedef struct netchunk_disk_cache_stats netchunk_disk_cache_stats_t;
+
+// Disk cache constants
+#define NETCHUNK_DISK_CACHE_DIRECTORY "chunk-cache" // Under local_storage_path
+#define NETCHUNK_DISK_CACHE_INITIAL_SLOTS 1024 // Always a power of two
+
+/**
+ * @brief One chunk stored in the cache directory
+ */
+typedef struct netchunk_disk_cache_entry {
+    uint8_t hash[NETCHUNK_HASH_LENGTH]; // SHA-256 of the chunk data (the key)
+    uint64_t size; // Chunk size in bytes
+    bool referenced; // Read since the clock hand last passed
+} netchunk_disk_cache_entry_t;
+
+/**
+ * @brief Counters of a disk cache
+ */
+typedef struct netchunk_disk_cache_stats {
+    uint64_t hits; // Chunks read from the cache
+    uint64_t misses; // Lookups of chunks not cached
+    uint64_t corrupt; // Cached chunks dropped because they failed verification
+    uint64_t insertions; // Chunks added
+    uint64_t evictions; // Chunks evicted to stay within the budget
+    uint64_t entries; // Chunks currently cached
+    uint64_t bytes_used; // Their total size
+} netchunk_disk_cache_stats_t;
+
+/**
+ * @brief Persistent cache of chunk data on local disk, keyed by chunk hash
+ *
+ * Each chunk is a file named after its hex hash, fanned out over 256
+ * subdirectories. The index of cached chunks is rebuilt from the directory
+ * on init, oldest file first. Eviction follows the CLOCK algorithm: a hit
+ * sets the chunk's reference bit, and the hand evicts the first chunk
+ * whose bit is clear, clearing the bits it passes. Every read is verified
+ * against the hash, so a damaged file is only ever a miss.
+ *
+ * Safe for concurrent use by several threads. Several processes may share
+ * a directory: files are written atomically and foreign deletions are seen
+ * as misses, but each process enforces the budget on its own index only.
+ */
+typedef struct netchunk_disk_cache {
+    char directory[NETCHUNK_MAX_PATH_LEN]; // Cache directory, created on first insert
+    uint64_t capacity_bytes; // Budget for cached chunk data
+    netchunk_disk_cache_entry_t* entries; // Clock ring
+    size_t count; // Entries in the ring
+    size_t capacity; // Allocated entries
+    size_t hand; // Next entry the clock examines
+    uint32_t* slots; // Hash table of entry positions plus one, 0 if empty
+    size_t slot_count; // Number of slots
+    netchunk_disk_cache_stats_t stats;
+    pthread_mutex_t mutex;
+} netchunk_disk_cache_t;
+
+/**
+ * @brief Open a cache directory and index the chunks already in it
+ *
+ * Chunks beyond capacity_bytes are evicted right away; leftovers of
+ * interrupted writes are removed.
+ *
+ * @param cache Cache to initialize
+ * @param directory Cache directory (~ is expanded)
+ * @param capacity_bytes Byte budget
+ * @return NETCHUNK_SUCCESS on success, error code on failure
+ */
+netchunk_error_t netchunk_disk_cache_init(netchunk_disk_cache_t* cache,
+    const char* directory,
+    uint64_t capacity_bytes);
+
+/**
+ * @brief Free the index; cached files are kept
+ * @param cache Cache to cleanup
+ */
+void netchunk_disk_cache_cleanup(netchunk_disk_cache_t* cache);
+
+/**
+ * @brief Check whether a chunk is indexed, without counting
+ * @param cache Cache to search
+ * @param hash Chunk hash
+ * @return true if the chunk is cached
+ */
+bool netchunk_disk_cache_contains(netchunk_disk_cache_t* cache, const uint8_t* hash);
+
+/**
+ * @brief Check whether a chunk is indexed before reading it, counting a miss if not
+ * @param cache Cache to search
+ * @param hash Chunk hash
+ * @return true if the chunk is cached
+ */
+bool netchunk_disk_cache_lookup(netchunk_disk_cache_t* cache, const uint8_t* hash);
+
+/**
+ * @brief Read and verify a cached chunk
+ * @param cache Cache to read
+ * @param hash Chunk hash
+ * @param size Expected chunk size
+ * @param data_out Receives the chunk data (caller frees)
+ * @return NETCHUNK_SUCCESS on a hit, NETCHUNK_ERROR_FILE_NOT_FOUND on a
+ *         miss, NETCHUNK_ERROR_CHUNK_INTEGRITY if the cached copy was bad
+ *         and has been dropped
+ */
+netchunk_error_t netchunk_disk_cache_get(netchunk_disk_cache_t* cache,
+    const uint8_t* hash,
+    size_t size,
+    uint8_t** data_out);
+
+/**
+ * @brief Store a verified chunk
+ *
+ * Chunks already cached, or larger than the whole budget, are skipped.
+ *
+ * @param cache Cache to update
+ * @param hash Chunk hash
+ * @param data Chunk data, already verified against hash
+ * @param size Chunk size in bytes
+ * @return NETCHUNK_SUCCESS on success, error code on failure
+ */
+netchunk_error_t netchunk_disk_cache_put(netchunk_disk_cache_t* cache,
+    const uint8_t* hash,
+    const uint8_t* data,
+    size_t size);
+
+/**
+ * @brief Read the cache counters
+ * @param cache Cache to inspect
+ * @param stats Output counters
+ */
+void netchunk_disk_cache_get_stats(netchunk_disk_cache_t* cache, netchunk_disk_cache_stats_t* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NETCHUNK_DISK_CACHE_H
@@ -0,0 +1,177 @@
+#ifndef NETCHUNK_ERASURE_H
+#define NETCHUNK_ERASURE_H
+
+#include "config.h"
+#include "ftp_client.h"
+#include "manifest.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Erasure coding constants
+#define NETCHUNK_EC_MAX_SHARDS NETCHUNK_MAX_SERVERS // Data plus parity shards per stripe
+#define NETCHUNK_EC_PARITY_ID_FLAG 0x80000000u // Sequence bit marking parity chunk IDs
+
+// GF(2^8) region kernels selectable at runtime
+typedef enum netchunk_gf_backend {
+    NETCHUNK_GF_BACKEND_AUTO = -1, // Best backend detected on this CPU
+    NETCHUNK_GF_BACKEND_GENERIC = 0, // Portable table lookups
+    NETCHUNK_GF_BACKEND_SSSE3, // 16 bytes per step with PSHUFB
+    NETCHUNK_GF_BACKEND_AVX2, // 32 bytes per step with VPSHUFB
+    NETCHUNK_GF_BACKEND_NEON, // 16 bytes per step with TBL
+    NETCHUNK_GF_BACKEND_COUNT
+} netchunk_gf_backend_t;
+
+// Field Arithmetic
+
+/**
+ * @brief Multiply two elements of GF(2^8) (polynomial 0x11d)
+ * @param a First factor
+ * @param b Second factor
+ * @return Product
+ */
+uint8_t netchunk_gf_mul(uint8_t a, uint8_t b);
+
+/**
+ * @brief Multiplicative inverse in GF(2^8)
+ * @param a Nonzero element
+ * @return Inverse of a, or 0 if a is 0
+ */
+uint8_t netchunk_gf_inverse(uint8_t a);
+
+/**
+ * @brief Add a multiple of one region to another: dst ^= coefficient * src
+ * @param dst Region to update
+ * @param src Region to multiply
+ * @param coefficient Field element to multiply src by
+ * @param size Bytes in each region
+ */
+void netchunk_gf_mul_add_region(uint8_t* dst, const uint8_t* src, uint8_t coefficient, size_t size);
+
+// Reed-Solomon Coding
+
+/**
+ * @brief Coefficient of a data shard in a parity shard
+ *
+ * Parity rows form a Cauchy matrix below the identity, so any data_shards
+ * of the data_shards + parity_shards shards rebuild the stripe. Parity can
+ * therefore be built incrementally: parity[p] ^= coefficient(p, d) * data[d].
+ *
+ * @param data_shards Data shards per stripe
+ * @param parity_index Parity shard (0 to parity_shards - 1)
+ * @param data_index Data shard (0 to data_shards - 1)
+ * @return Coefficient
+ */
+uint8_t netchunk_ec_coefficient(int data_shards, int parity_index, int data_index);
+
+/**
+ * @brief Check a stripe layout
+ * @param data_shards Data shards per stripe
+ * @param parity_shards Parity shards per stripe
+ * @return true if both are positive and together at most NETCHUNK_EC_MAX_SHARDS
+ */
+bool netchunk_ec_layout_valid(int data_shards, int parity_shards);
+
+/**
+ * @brief Compute the parity shards of a stripe
+ * @param data_shards Data shards per stripe
+ * @param parity_shards Parity shards per stripe
+ * @param data Data shard buffers, each shard_size bytes (shorter data zero-padded)
+ * @param parity Output parity buffers, each shard_size bytes
+ * @param shard_size Bytes per shard
+ * @return NETCHUNK_SUCCESS on success, error code on failure
+ */
+netchunk_error_t netchunk_ec_encode(int data_shards,
+    int parity_shards,
+    const uint8_t* const* data,
+    uint8_t* const* parity,
+    size_t shard_size);
+
+/**
+ * @brief Rebuild the missing shards of a stripe
+ *
+ * Shards are indexed data first, then parity. Missing shards are written
+ * into their buffers from any data_shards present ones.
+ *
+ * @param data_shards Data shards per stripe
+ * @param parity_shards Parity shards per stripe
+ * @param shards Buffers for every shard, each shard_size bytes
+ * @param present Which shards hold valid data
+ * @param shard_size Bytes per shard
+ * @return NETCHUNK_SUCCESS on success, NETCHUNK_ERROR_CHUNK_INTEGRITY if
+ *         fewer than data_shards shards are present, error code on failure
+ */
+netchunk_error_t netchunk_ec_reconstruct(int data_shards,
+    int parity_shards,
+    uint8_t* const* shards,
+    const bool* present,
+    size_t shard_size);
+
+// Stripe Recovery
+
+/**
+ * @brief Rebuild a stripe of an erasure-coded file from its servers
+ *
+ * Shards the caller already holds (present[i] set, e.g. read back from a
+ * local copy) are used as they are. Further shards are downloaded and
+ * verified, data first, until enough are at hand, and the rest are
+ * decoded from them.
+ *
+ * @param ftp_context FTP context used for downloads
+ * @param manifest Erasure-coded manifest
+ * @param stripe Stripe index
+ * @param shards Buffers for every shard, data then parity, each shard_size bytes
+ * @param present Shards already filled in; all set on success
+ * @param shard_size Bytes per shard, the size of the stripe's parity chunks
+ * @return NETCHUNK_SUCCESS on success, NETCHUNK_ERROR_CHUNK_INTEGRITY if
+ *         too few shards could be fetched, error code on failure
+ */
+netchunk_error_t netchunk_ec_recover_stripe(netchunk_ftp_context_t* ftp_context,
+    const netchunk_file_manifest_t* manifest,
+    uint32_t stripe,
+    uint8_t* const* shards,
+    bool* present,
+    size_t shard_size);
+
+// Backend Selection
+
+/**
+ * @brief Check whether a GF(2^8) backend can run on this CPU
+ * @param backend Backend to check
+ * @return true if the backend is compiled in and supported by the CPU
+ */
+bool netchunk_gf_backend_available(netchunk_gf_backend_t backend);
+
+/**
+ * @brief Force a GF(2^8) backend instead of the detected one
+ *
+ * Not safe to call while other threads are coding.
+ *
+ * @param backend Backend to use, AUTO restores the detected one
+ * @return NETCHUNK_SUCCESS on success, NETCHUNK_ERROR_CRYPTO if the backend
+ *         is not available, NETCHUNK_ERROR_INVALID_ARGUMENT if it is unknown
+ */
+netchunk_error_t netchunk_gf_set_backend(netchunk_gf_backend_t backend);
+
+/**
+ * @brief Get the active GF(2^8) backend
+ * @return Active backend
+ */
+netchunk_gf_backend_t netchunk_gf_get_backend(void);
+
+/**
+ * @brief Get a printable backend name
+ * @param backend Backend
+ * @return Static name string ("unknown" for invalid values)
+ */
+const char* netchunk_gf_backend_name(netchunk_gf_backend_t backend);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NETCHUNK_ERASURE_H
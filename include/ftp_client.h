@@ -2,6 +2,8 @@
 #define NETCHUNK_FTP_CLIENT_H
 
 #include "config.h"
+#include "metrics.h"
+#include "server_score.h"
 #include <curl/curl.h>
 #include <pthread.h>
 #include <stddef.h>
@@ -13,6 +15,7 @@ extern "C" {
 
 // Forward declarations
 typedef struct netchunk_ftp_pool netchunk_ftp_pool_t;
+typedef struct netchunk_ftp_server_pool netchunk_ftp_server_pool_t;
 typedef struct netchunk_ftp_connection netchunk_ftp_connection_t;
 typedef struct netchunk_upload_progress netchunk_upload_progress_t;
 typedef struct netchunk_download_progress netchunk_download_progress_t;
@@ -20,14 +23,38 @@ typedef struct netchunk_ftp_stats netchunk_ftp_stats_t;
 typedef struct netchunk_ftp_context netchunk_ftp_context_t;
 typedef struct netchunk_chunk netchunk_chunk_t;
 typedef struct netchunk_file_manifest netchunk_file_manifest_t;
+typedef struct netchunk_ftp_segment_reader netchunk_ftp_segment_reader_t;
+typedef struct netchunk_ftp_transfer netchunk_ftp_transfer_t;
+typedef struct netchunk_ftp_engine netchunk_ftp_engine_t;
+typedef struct netchunk_health_monitor netchunk_health_monitor_t;
 
 // Connection pool constants
-#define NETCHUNK_FTP_POOL_MAX_CONNECTIONS 16
+#define NETCHUNK_FTP_POOL_MAX_CONNECTIONS 32 // Per server
+#define NETCHUNK_FTP_KEEPALIVE_IDLE 30 // seconds before TCP keepalive probes start
+#define NETCHUNK_FTP_KEEPALIVE_INTERVAL 15 // seconds between keepalive probes
 #define NETCHUNK_FTP_MAX_RETRIES 3
 #define NETCHUNK_FTP_RETRY_DELAY_BASE 1000 // milliseconds
 #define NETCHUNK_FTP_CONNECTION_TIMEOUT 30 // seconds
 #define NETCHUNK_FTP_MAX_REDIRECTS 5
 
+// Batched delete constants
+#define NETCHUNK_FTP_DELETE_BATCH_SIZE 64 // DELE commands sent in one control session
+#define NETCHUNK_FTP_DELETE_MAX_WORKERS 32 // Threads of one netchunk_ftp_delete_many() call
+
+// Async transfer engine constants
+#define NETCHUNK_FTP_ENGINE_MAX_SEGMENTS 4 // Buffers per upload transfer
+#define NETCHUNK_FTP_ENGINE_MAX_HANDLES 256 // Idle easy handles kept for reuse
+#define NETCHUNK_FTP_ENGINE_POLL_TIMEOUT_MS 100
+#define NETCHUNK_FTP_HEDGE_MIN_DELAY_MS 50 // Never hedge a download sooner than this
+#define NETCHUNK_FTP_HEDGE_BURST 10 // Backup requests that may be issued back to back
+
+// Remote layout
+#define NETCHUNK_FTP_CHUNK_DIR "chunks" // Chunk directory under each server's base_path
+#define NETCHUNK_FTP_CHUNK_EXTENSION ".chunk"
+#define NETCHUNK_FTP_MANIFEST_DIR "manifests" // Manifest directory under each server's base_path
+#define NETCHUNK_FTP_MANIFEST_EXTENSION ".manifest"
+#define NETCHUNK_FTP_MAX_NAME_LEN 256 // Longest remote file name, extension included
+
 // FTP connection status
 typedef enum netchunk_ftp_status {
     NETCHUNK_FTP_STATUS_DISCONNECTED = 0,
@@ -37,6 +64,14 @@ typedef enum netchunk_ftp_status {
     NETCHUNK_FTP_STATUS_ERROR = 4
 } netchunk_ftp_status_t;
 
+// Server-side hash commands, probed once per server
+typedef enum netchunk_ftp_hash_command {
+    NETCHUNK_FTP_HASH_UNKNOWN = 0, // Not probed yet
+    NETCHUNK_FTP_HASH_RFC = 1, // OPTS HASH SHA-256, then HASH (draft-bryan-ftpext-hash)
+    NETCHUNK_FTP_HASH_XSHA256 = 2, // XSHA256
+    NETCHUNK_FTP_HASH_NONE = 3 // Neither is supported
+} netchunk_ftp_hash_command_t;
+
 // Progress callback function types
 typedef void (*netchunk_upload_progress_callback_t)(void* userdata, double total_bytes, double uploaded_bytes);
 typedef void (*netchunk_download_progress_callback_t)(void* userdata, double total_bytes, double downloaded_bytes);
@@ -63,6 +98,20 @@ typedef struct netchunk_download_progress {
     bool cancelled;
 } netchunk_download_progress_t;
 
+// Caller-owned buffer streamed as part of an upload
+typedef struct netchunk_ftp_segment {
+    const uint8_t* data;
+    size_t size;
+} netchunk_ftp_segment_t;
+
+// Read position across a list of upload segments
+typedef struct netchunk_ftp_segment_reader {
+    const netchunk_ftp_segment_t* segments;
+    size_t segment_count;
+    size_t segment_index; // Segment currently being read
+    size_t segment_offset; // Offset within current segment
+} netchunk_ftp_segment_reader_t;
+
 // FTP connection statistics
 typedef struct netchunk_ftp_stats {
     uint64_t bytes_uploaded;
@@ -79,6 +128,7 @@ typedef struct netchunk_ftp_stats {
 typedef struct netchunk_ftp_connection {
     CURL* curl_handle;
     netchunk_server_t* server;
+    int server_index; // Index into config->servers
     netchunk_ftp_status_t status;
     time_t last_used;
     time_t connected_at;
@@ -87,16 +137,28 @@ typedef struct netchunk_ftp_connection {
     int retry_count;
     bool in_use;
     char error_message[256];
+    char curl_error[CURL_ERROR_SIZE]; // libcurl error buffer owned by this handle
+    netchunk_ftp_segment_reader_t* upload_reader; // Active in-memory upload, rewound on retry
 } netchunk_ftp_connection_t;
 
+// Connections to a single server, with their own wait queue
+typedef struct netchunk_ftp_server_pool {
+    netchunk_ftp_connection_t* connections;
+    int connection_count; // Connections allowed to this server
+    int in_use_count;
+    int waiters; // Threads blocked in acquire
+    pthread_cond_t connection_available; // Signalled only for this server
+    netchunk_ftp_hash_command_t hash_command; // Server-side hashing support, guarded by pool_mutex
+} netchunk_ftp_server_pool_t;
+
 // FTP connection pool
 typedef struct netchunk_ftp_pool {
-    netchunk_ftp_connection_t connections[NETCHUNK_FTP_POOL_MAX_CONNECTIONS];
-    int connection_count;
+    netchunk_ftp_server_pool_t servers[NETCHUNK_MAX_SERVERS];
+    int server_count;
     pthread_mutex_t pool_mutex;
-    pthread_cond_t connection_available;
     bool initialized;
     int max_concurrent;
+    int idle_timeout; // Seconds before an idle connection is reaped
     netchunk_config_t* config;
 } netchunk_ftp_pool_t;
 
@@ -108,10 +170,113 @@ typedef struct netchunk_memory_buffer {
     size_t position; // For reading operations
 } netchunk_memory_buffer_t;
 
+// One file of a remote directory listing
+typedef struct netchunk_ftp_dir_entry {
+    char name[NETCHUNK_FTP_MAX_NAME_LEN]; // File name within the directory
+    uint64_t size; // Size in bytes
+    time_t modified; // Modification time, 0 if unknown
+} netchunk_ftp_dir_entry_t;
+
+// Newest copy of one manifest across all servers
+typedef struct netchunk_ftp_manifest_entry {
+    char name[NETCHUNK_FTP_MAX_NAME_LEN]; // Remote file name identifier
+    uint64_t size; // Size of the newest copy
+    time_t modified; // Modification time of the newest copy
+    int server_index; // Server holding the newest copy
+} netchunk_ftp_manifest_entry_t;
+
+// One removal of a batched delete
+typedef struct netchunk_ftp_delete_request {
+    int server_index; // Index into config->servers
+    const char* remote_path; // Path relative to the server's base_path
+    netchunk_error_t result; // NETCHUNK_ERROR_FILE_NOT_FOUND if there was nothing to delete
+} netchunk_ftp_delete_request_t;
+
+// Async transfer operation
+typedef enum netchunk_ftp_transfer_type {
+    NETCHUNK_FTP_TRANSFER_UPLOAD = 0,
+    NETCHUNK_FTP_TRANSFER_DOWNLOAD = 1,
+    NETCHUNK_FTP_TRANSFER_DELETE = 2
+} netchunk_ftp_transfer_type_t;
+
+// Completion callback, invoked on the engine thread; the transfer may be
+// freed or resubmitted from inside the callback
+typedef void (*netchunk_ftp_transfer_callback_t)(netchunk_ftp_transfer_t* transfer, void* userdata);
+
+// Single queued transfer, owned by the caller until its callback returns
+typedef struct netchunk_ftp_transfer {
+    // Request
+    netchunk_ftp_transfer_type_t type;
+    int server_index; // Index into config->servers
+    char remote_path[NETCHUNK_MAX_PATH_LEN];
+    netchunk_ftp_segment_t segments[NETCHUNK_FTP_ENGINE_MAX_SEGMENTS]; // Upload source
+    size_t segment_count;
+    size_t expected_size; // Download size hint for buffer preallocation
+    int alternate_servers[NETCHUNK_MAX_REPLICATION_FACTOR]; // Download replicas to use when server_index is saturated
+    int alternate_count;
+    int max_attempts;
+    netchunk_ftp_transfer_callback_t callback;
+    void* userdata;
+
+    // Result, valid inside the callback
+    netchunk_error_t result;
+    netchunk_memory_buffer_t buffer; // Downloaded data, caller frees
+    size_t bytes_transferred;
+    double elapsed_ms;
+    int attempts;
+    bool hedged; // Served by a backup request to an alternate
+
+    // Engine-private state
+    CURL* curl_handle;
+    struct curl_slist* commands;
+    netchunk_ftp_segment_reader_t reader;
+    char curl_error[CURL_ERROR_SIZE];
+    double started_ms;
+    double attempt_ms; // Start of the current attempt
+    double retry_at_ms; // Earliest time a failed attempt may run again
+    struct netchunk_ftp_transfer* hedge; // Backup request racing this download
+    struct netchunk_ftp_transfer* hedge_of; // Download this backup request races
+    bool hedge_tried; // A backup was issued; each download gets one
+    bool hedge_pending; // Failed, waiting for the backup before retrying
+    struct netchunk_ftp_transfer* next;
+    struct netchunk_ftp_transfer* active_prev; // Transfers in the multi handle
+    struct netchunk_ftp_transfer* active_next;
+} netchunk_ftp_transfer_t;
+
+// Event-driven transfer engine on the libcurl multi interface
+typedef struct netchunk_ftp_engine {
+    CURLM* multi_handle;
+    CURLSH* share_handle; // TLS session and DNS cache shared by engine handles
+    netchunk_config_t* config;
+    pthread_t thread; // Event loop
+    pthread_mutex_t mutex;
+    pthread_cond_t idle; // Signalled when no transfers are outstanding
+    netchunk_ftp_transfer_t* queue_head; // Submitted, waiting for a slot
+    netchunk_ftp_transfer_t* queue_tail;
+    netchunk_ftp_transfer_t* active_head; // Transfers in the multi handle, backups included
+    CURL* idle_handles[NETCHUNK_FTP_ENGINE_MAX_HANDLES];
+    int idle_handle_count;
+    int active_per_server[NETCHUNK_MAX_SERVERS];
+    int server_limit[NETCHUNK_MAX_SERVERS]; // Per-server cap on transfers in flight
+    int active_count;
+    int outstanding_count; // Queued plus active
+    int max_active; // Global cap on transfers in flight
+    int max_per_server; // Default per-server cap when a server sets no max_connections
+    netchunk_scoreboard_t scores; // Observed server performance, guarded by mutex
+    double hedge_tokens; // Backup requests that may be issued now
+    double hedge_rate; // Tokens earned per download attempt, from hedge_budget_percent
+    netchunk_metrics_t* metrics; // Receives every attempt's duration and bytes (can be NULL)
+    bool running;
+    bool stopping;
+} netchunk_ftp_engine_t;
+
 // FTP context structure (main interface)
 typedef struct netchunk_ftp_context {
     netchunk_ftp_pool_t* pool; // Connection pool
+    netchunk_ftp_engine_t* engine; // Shared async transfer engine
     netchunk_config_t* config; // Configuration reference
+    netchunk_health_monitor_t* health_monitor; // Server status published in the background (can be NULL)
+    netchunk_metrics_t* metrics; // Receives manifest I/O timings (can be NULL)
     bool initialized; // Initialization flag
 } netchunk_ftp_context_t;
 
@@ -140,13 +305,51 @@ void netchunk_ftp_pool_cleanup(netchunk_ftp_pool_t* pool);
  */
 netchunk_error_t netchunk_ftp_pool_acquire(netchunk_ftp_pool_t* pool, int server_id, netchunk_ftp_connection_t** connection);
 
+/**
+ * @brief Get a connection for a server without waiting
+ * @param pool Pointer to FTP pool structure
+ * @param server_id Server index in configuration
+ * @param connection Output pointer for acquired connection
+ * @return NETCHUNK_SUCCESS on success, NETCHUNK_ERROR_SERVER_UNAVAILABLE if
+ *         every connection to the server is busy, other error code on failure
+ */
+netchunk_error_t netchunk_ftp_pool_try_acquire(netchunk_ftp_pool_t* pool, int server_id, netchunk_ftp_connection_t** connection);
+
+/**
+ * @brief Get a connection to whichever of several servers is free first
+ *
+ * Servers are tried in order without blocking, so the first entry is the
+ * preferred one. If all of them are busy, waits on the preferred server.
+ *
+ * @param pool Pointer to FTP pool structure
+ * @param server_ids Candidate server indices, e.g. every replica of a chunk
+ * @param server_count Number of candidates
+ * @param connection Output pointer for acquired connection
+ * @return NETCHUNK_SUCCESS on success, error code on failure
+ */
+netchunk_error_t netchunk_ftp_pool_acquire_any(netchunk_ftp_pool_t* pool,
+    const int* server_ids,
+    int server_count,
+    netchunk_ftp_connection_t** connection);
+
 /**
  * @brief Return a connection to the pool
+ *
+ * The connection stays open for reuse and wakes one thread waiting for the
+ * same server.
+ *
  * @param pool Pointer to FTP pool structure
  * @param connection Connection to return
  */
 void netchunk_ftp_pool_release(netchunk_ftp_pool_t* pool, netchunk_ftp_connection_t* connection);
 
+/**
+ * @brief Close connections idle for longer than the configured timeout
+ * @param pool Pointer to FTP pool structure
+ * @return Number of connections closed
+ */
+int netchunk_ftp_pool_reap_idle(netchunk_ftp_pool_t* pool);
+
 /**
  * @brief Test connectivity to all servers in the pool
  * @param pool Pointer to FTP pool structure
@@ -160,7 +363,7 @@ netchunk_error_t netchunk_ftp_pool_test_connectivity(netchunk_ftp_pool_t* pool);
  * @brief Upload data to an FTP server
  * @param connection FTP connection to use
  * @param remote_path Remote file path
- * @param data Data buffer to upload
+ * @param data Data buffer to upload (streamed directly, not copied)
  * @param data_size Size of data to upload
  * @param progress Progress callback structure (optional)
  * @return NETCHUNK_SUCCESS on success, error code on failure
@@ -171,6 +374,26 @@ netchunk_error_t netchunk_ftp_upload(netchunk_ftp_connection_t* connection,
     size_t data_size,
     netchunk_upload_progress_t* progress);
 
+/**
+ * @brief Upload the concatenation of several buffers as one remote file
+ *
+ * Segments are streamed in order through a libcurl read callback, so a
+ * header and payload produced by different stages need not be joined.
+ * Buffers must stay valid until the call returns.
+ *
+ * @param connection FTP connection to use
+ * @param remote_path Remote file path
+ * @param segments Array of buffers to upload
+ * @param segment_count Number of segments
+ * @param progress Progress callback structure (optional)
+ * @return NETCHUNK_SUCCESS on success, error code on failure
+ */
+netchunk_error_t netchunk_ftp_upload_segments(netchunk_ftp_connection_t* connection,
+    const char* remote_path,
+    const netchunk_ftp_segment_t* segments,
+    size_t segment_count,
+    netchunk_upload_progress_t* progress);
+
 /**
  * @brief Upload data from file to FTP server
  * @param connection FTP connection to use
@@ -218,6 +441,38 @@ netchunk_error_t netchunk_ftp_download_file(netchunk_ftp_connection_t* connectio
  */
 netchunk_error_t netchunk_ftp_delete(netchunk_ftp_connection_t* connection, const char* remote_path);
 
+/**
+ * @brief Delete several files on the FTP server in one control session
+ *
+ * All DELE commands go out as one quote list instead of one request per
+ * file, and a file the server refuses does not stop the ones after it.
+ *
+ * @param connection FTP connection to use
+ * @param remote_paths Remote file paths to delete
+ * @param count Number of paths
+ * @param results Output result per path, NETCHUNK_ERROR_FILE_NOT_FOUND for
+ *        files the server reports missing
+ * @return NETCHUNK_SUCCESS if every command got an answer, error code if the
+ *         connection failed (paths not answered get that error)
+ */
+netchunk_error_t netchunk_ftp_delete_batch(netchunk_ftp_connection_t* connection,
+    const char* const* remote_paths,
+    size_t count,
+    netchunk_error_t* results);
+
+/**
+ * @brief Match the control replies of a batched delete to its DELE commands
+ * @param replies Control channel replies, login included
+ * @param length Bytes of replies
+ * @param results Output result per command, in the order they were sent
+ * @param count Commands that were sent
+ * @return Number of commands that were answered
+ */
+size_t netchunk_ftp_parse_delete_replies(const char* replies,
+    size_t length,
+    netchunk_error_t* results,
+    size_t count);
+
 /**
  * @brief Check if a file exists on the FTP server
  * @param connection FTP connection to use
@@ -255,6 +510,64 @@ netchunk_error_t netchunk_ftp_list_directory(netchunk_ftp_connection_t* connecti
     const char* remote_path,
     netchunk_memory_buffer_t* buffer);
 
+/**
+ * @brief Get size and modification time of a remote file (SIZE and MDTM)
+ * @param connection FTP connection to use
+ * @param remote_path Remote file path
+ * @param size Output file size
+ * @param modified Output modification time, 0 if the server does not report it
+ * @return NETCHUNK_SUCCESS on success, error code on failure
+ */
+netchunk_error_t netchunk_ftp_stat(netchunk_ftp_connection_t* connection,
+    const char* remote_path,
+    uint64_t* size,
+    time_t* modified);
+
+/**
+ * @brief Have the server compute a file's SHA-256 (HASH or XSHA256)
+ * @param connection FTP connection to use
+ * @param remote_path Remote file path
+ * @param command NETCHUNK_FTP_HASH_RFC or NETCHUNK_FTP_HASH_XSHA256
+ * @param hash Output hash, NETCHUNK_HASH_LENGTH bytes
+ * @return NETCHUNK_SUCCESS on success, NETCHUNK_ERROR_FTP if the server
+ *         refused the command or its reply had no SHA-256, error code on failure
+ */
+netchunk_error_t netchunk_ftp_hash(netchunk_ftp_connection_t* connection,
+    const char* remote_path,
+    netchunk_ftp_hash_command_t command,
+    uint8_t* hash);
+
+/**
+ * @brief List the files of a remote directory with sizes and modification times
+ *
+ * Uses a single MLSD listing. Servers without MLSD are listed with NLST
+ * and queried per file with SIZE and MDTM. Subdirectories are skipped.
+ *
+ * @param connection FTP connection to use
+ * @param remote_path Remote directory path
+ * @param entries Output array of entries (allocated by function, free() it)
+ * @param count Output number of entries
+ * @return NETCHUNK_SUCCESS on success, NETCHUNK_ERROR_FILE_NOT_FOUND if the
+ *         directory does not exist, error code on failure
+ */
+netchunk_error_t netchunk_ftp_list_entries(netchunk_ftp_connection_t* connection,
+    const char* remote_path,
+    netchunk_ftp_dir_entry_t** entries,
+    size_t* count);
+
+/**
+ * @brief Parse an MLSD listing (RFC 3659), keeping regular files only
+ * @param listing Listing text
+ * @param size Size of listing
+ * @param entries Output array of entries (allocated by function, free() it)
+ * @param count Output number of entries
+ * @return NETCHUNK_SUCCESS on success, error code on failure
+ */
+netchunk_error_t netchunk_ftp_parse_mlsd(const char* listing,
+    size_t size,
+    netchunk_ftp_dir_entry_t** entries,
+    size_t* count);
+
 // Memory Buffer Functions
 
 /**
@@ -298,6 +611,32 @@ netchunk_error_t netchunk_memory_buffer_append(netchunk_memory_buffer_t* buffer,
  */
 netchunk_error_t netchunk_ftp_test_server(const netchunk_server_t* server, double* latency_ms);
 
+/**
+ * @brief Ask a server how much space it has left and how much the chunks take
+ *
+ * Free space comes from AVBL, which not every server implements. Usage is
+ * the total size in an MLSD listing of the chunk directory, so it costs a
+ * full listing; pass NULL to skip it.
+ *
+ * @param server Server configuration
+ * @param bytes_available Output free space under base_path, 0 if the server does not tell
+ * @param bytes_used Output size of the chunk files, 0 if there is no chunk directory yet (can be NULL)
+ * @return NETCHUNK_SUCCESS on success, NETCHUNK_ERROR_FTP if the chunk
+ *         directory could not be listed, error code on failure
+ */
+netchunk_error_t netchunk_ftp_query_space(const netchunk_server_t* server,
+    uint64_t* bytes_available,
+    uint64_t* bytes_used);
+
+/**
+ * @brief Find the free space in the control replies of an AVBL command
+ * @param replies Control channel replies, login included
+ * @param length Bytes of replies
+ * @param bytes_available Output free space
+ * @return true if a "213" reply carried a number
+ */
+bool netchunk_ftp_parse_avbl_reply(const char* replies, size_t length, uint64_t* bytes_available);
+
 /**
  * @brief Build complete FTP URL from server config and path
  * @param server Server configuration
@@ -311,6 +650,66 @@ netchunk_error_t netchunk_ftp_build_url(const netchunk_server_t* server,
     char* url_buffer,
     size_t buffer_size);
 
+/**
+ * @brief Build the remote path of a chunk relative to a server's base_path
+ * @param chunk Chunk whose ID names the remote file
+ * @param path_buffer Output buffer for path
+ * @param buffer_size Size of path buffer
+ * @return NETCHUNK_SUCCESS on success, error code on failure
+ */
+netchunk_error_t netchunk_ftp_chunk_path(const netchunk_chunk_t* chunk,
+    char* path_buffer,
+    size_t buffer_size);
+
+/**
+ * @brief Build the remote path of a file's manifest relative to a server's base_path
+ *
+ * Bytes other than letters, digits, '.', '-' and '_' (and a leading '.')
+ * are written as '=' and two hex digits, so any remote name maps to one
+ * flat file name.
+ *
+ * @param remote_name Remote file name identifier
+ * @param path_buffer Output buffer for path
+ * @param buffer_size Size of path buffer
+ * @return NETCHUNK_SUCCESS on success, NETCHUNK_ERROR_INVALID_ARGUMENT if the
+ *         encoded name exceeds NETCHUNK_FTP_MAX_NAME_LEN, error code on failure
+ */
+netchunk_error_t netchunk_ftp_manifest_path(const char* remote_name,
+    char* path_buffer,
+    size_t buffer_size);
+
+/**
+ * @brief Recover the remote name from a manifest file name in a listing
+ * @param entry_name File name as listed in NETCHUNK_FTP_MANIFEST_DIR
+ * @param name_buffer Output buffer for the remote name
+ * @param buffer_size Size of name buffer
+ * @return NETCHUNK_SUCCESS on success, NETCHUNK_ERROR_INVALID_ARGUMENT if the
+ *         entry is not a manifest written by netchunk_ftp_upload_manifest()
+ */
+netchunk_error_t netchunk_ftp_manifest_name(const char* entry_name,
+    char* name_buffer,
+    size_t buffer_size);
+
+/**
+ * @brief Build the absolute remote path of a file under a server's base_path
+ * @param server Server configuration
+ * @param remote_path Path relative to base_path
+ * @param path_buffer Output buffer for path
+ * @param buffer_size Size of path buffer
+ * @return NETCHUNK_SUCCESS on success, error code on failure
+ */
+netchunk_error_t netchunk_ftp_build_remote_path(const netchunk_server_t* server,
+    const char* remote_path,
+    char* path_buffer,
+    size_t buffer_size);
+
+/**
+ * @brief Map a libcurl result to a NetChunk error code
+ * @param code libcurl result code
+ * @return Matching NetChunk error code
+ */
+netchunk_error_t netchunk_ftp_map_curl_error(CURLcode code);
+
 /**
  * @brief Get last error message from connection
  * @param connection FTP connection
@@ -362,6 +761,39 @@ netchunk_error_t netchunk_ftp_upload_chunk(netchunk_ftp_context_t* context,
     const netchunk_server_t* server,
     const netchunk_chunk_t* chunk);
 
+/**
+ * @brief Get the size of a server's copy of a chunk without downloading it
+ * @param context FTP context
+ * @param server Server to query
+ * @param chunk Chunk to look up
+ * @param size Output size in bytes
+ * @return NETCHUNK_SUCCESS on success, NETCHUNK_ERROR_FILE_NOT_FOUND if the
+ *         server has no copy, error code on failure
+ */
+netchunk_error_t netchunk_ftp_stat_chunk(netchunk_ftp_context_t* context,
+    const netchunk_server_t* server,
+    const netchunk_chunk_t* chunk,
+    uint64_t* size);
+
+/**
+ * @brief Have a server hash its copy of a chunk, without transferring it
+ *
+ * The first hash command the server accepts is remembered for it; servers
+ * that accept neither are not asked again. Only call this for a copy
+ * known to exist, since a missing file is refused like an unknown command.
+ *
+ * @param context FTP context
+ * @param server Server to query
+ * @param chunk Chunk to hash
+ * @param hash Output SHA-256 of the stored copy, NETCHUNK_HASH_LENGTH bytes
+ * @return NETCHUNK_SUCCESS on success, NETCHUNK_ERROR_FTP if the server
+ *         cannot hash files, error code on failure
+ */
+netchunk_error_t netchunk_ftp_hash_chunk(netchunk_ftp_context_t* context,
+    const netchunk_server_t* server,
+    const netchunk_chunk_t* chunk,
+    uint8_t* hash);
+
 /**
  * @brief Download chunk from FTP server
  * @param context FTP context
@@ -373,6 +805,20 @@ netchunk_error_t netchunk_ftp_download_chunk(netchunk_ftp_context_t* context,
     const netchunk_server_t* server,
     netchunk_chunk_t* chunk);
 
+/**
+ * @brief Download chunk from whichever of its replica servers is free first
+ *
+ * Falls through to the next replica when a download fails.
+ *
+ * @param context FTP context
+ * @param chunk Chunk to download (data will be allocated)
+ * @param served_by Optional output for the server that returned the data
+ * @return NETCHUNK_SUCCESS on success, error code on failure
+ */
+netchunk_error_t netchunk_ftp_download_chunk_any(netchunk_ftp_context_t* context,
+    netchunk_chunk_t* chunk,
+    const netchunk_server_t** served_by);
+
 /**
  * @brief Delete chunk from FTP server
  * @param context FTP context
@@ -384,10 +830,31 @@ netchunk_error_t netchunk_ftp_delete_chunk(netchunk_ftp_context_t* context,
     const netchunk_server_t* server,
     const netchunk_chunk_t* chunk);
 
+/**
+ * @brief Delete many remote files across servers
+ *
+ * Requests are grouped per server and sent NETCHUNK_FTP_DELETE_BATCH_SIZE
+ * at a time with netchunk_ftp_delete_batch(). Every server is worked on at
+ * once, each over as many pooled connections as it allows.
+ *
+ * @param context FTP context
+ * @param requests Removals to perform; their results are filled in
+ * @param count Number of requests
+ * @return NETCHUNK_SUCCESS if every file is gone (deleted or already
+ *         missing), otherwise the first other error
+ */
+netchunk_error_t netchunk_ftp_delete_many(netchunk_ftp_context_t* context,
+    netchunk_ftp_delete_request_t* requests,
+    size_t count);
+
 // Manifest-specific Functions
 
 /**
  * @brief Upload manifest to FTP servers
+ *
+ * The manifest is stored packed on every configured server, so any one of
+ * them can answer for it.
+ *
  * @param context FTP context
  * @param config NetChunk configuration
  * @param manifest Manifest to upload
@@ -399,6 +866,9 @@ netchunk_error_t netchunk_ftp_upload_manifest(netchunk_ftp_context_t* context,
 
 /**
  * @brief Download manifest from FTP servers
+ *
+ * Servers are tried in configuration order until one returns a valid copy.
+ *
  * @param context FTP context
  * @param config NetChunk configuration
  * @param remote_name Remote file name
@@ -410,6 +880,20 @@ netchunk_error_t netchunk_ftp_download_manifest(netchunk_ftp_context_t* context,
     const char* remote_name,
     netchunk_file_manifest_t* manifest);
 
+/**
+ * @brief Download a manifest from one server
+ * @param context FTP context
+ * @param server Server to download from
+ * @param remote_name Remote file name
+ * @param manifest Output manifest structure
+ * @return NETCHUNK_SUCCESS on success, NETCHUNK_ERROR_MANIFEST_CORRUPT if the
+ *         stored copy is invalid, error code on failure
+ */
+netchunk_error_t netchunk_ftp_download_manifest_from(netchunk_ftp_context_t* context,
+    const netchunk_server_t* server,
+    const char* remote_name,
+    netchunk_file_manifest_t* manifest);
+
 /**
  * @brief Delete manifest from FTP servers
  * @param context FTP context
@@ -421,8 +905,33 @@ netchunk_error_t netchunk_ftp_delete_manifest(netchunk_ftp_context_t* context,
     netchunk_config_t* config,
     const char* remote_name);
 
+/**
+ * @brief List the manifests stored on any server without downloading them
+ *
+ * Each server's manifest directory is listed once; for names stored on
+ * several servers the most recently modified copy is reported. Servers
+ * that cannot be listed are skipped.
+ *
+ * @param context FTP context
+ * @param config NetChunk configuration
+ * @param entries Output array sorted by name (allocated by function, free() it)
+ * @param count Output number of entries
+ * @param servers_listed Output number of servers that answered (optional)
+ * @return NETCHUNK_SUCCESS on success, NETCHUNK_ERROR_SERVER_UNAVAILABLE if
+ *         no server could be listed, error code on failure
+ */
+netchunk_error_t netchunk_ftp_list_manifest_entries(netchunk_ftp_context_t* context,
+    netchunk_config_t* config,
+    netchunk_ftp_manifest_entry_t** entries,
+    size_t* count,
+    int* servers_listed);
+
 /**
  * @brief List all manifests on FTP servers
+ *
+ * Downloads every manifest found on any server, which is slow for large
+ * stores; netchunk_list_files() answers from the local catalog instead.
+ *
  * @param context FTP context
  * @param config NetChunk configuration
  * @param files Output array of manifests (allocated by function)
@@ -434,6 +943,174 @@ netchunk_error_t netchunk_ftp_list_manifests(netchunk_ftp_context_t* context,
     netchunk_file_manifest_t** files,
     size_t* count);
 
+// Async Transfer Engine Functions
+
+/**
+ * @brief Initialize the transfer engine and start its event loop thread
+ * @param engine Engine to initialize
+ * @param config NetChunk configuration
+ * @param max_per_server Concurrent transfers per server without max_connections
+ * @return NETCHUNK_SUCCESS on success, error code on failure
+ */
+netchunk_error_t netchunk_ftp_engine_init(netchunk_ftp_engine_t* engine,
+    netchunk_config_t* config,
+    int max_per_server);
+
+/**
+ * @brief Wait for outstanding transfers, stop the event loop and free resources
+ * @param engine Engine to cleanup
+ */
+void netchunk_ftp_engine_cleanup(netchunk_ftp_engine_t* engine);
+
+/**
+ * @brief Queue a transfer; its callback runs on the engine thread when done
+ * @param engine Transfer engine
+ * @param transfer Transfer prepared with netchunk_ftp_transfer_init_*()
+ * @return NETCHUNK_SUCCESS if queued, error code on failure
+ */
+netchunk_error_t netchunk_ftp_engine_submit(netchunk_ftp_engine_t* engine,
+    netchunk_ftp_transfer_t* transfer);
+
+/**
+ * @brief Block until every submitted transfer has completed
+ * @param engine Transfer engine
+ */
+void netchunk_ftp_engine_wait_idle(netchunk_ftp_engine_t* engine);
+
+/**
+ * @brief Submit a transfer and block until it completes
+ *
+ * Convenience for callers that are not event driven; the transfer still
+ * shares the engine's connections and concurrency caps.
+ *
+ * @param engine Transfer engine
+ * @param transfer Transfer prepared without a callback
+ * @return Result of the transfer
+ */
+netchunk_error_t netchunk_ftp_engine_execute(netchunk_ftp_engine_t* engine,
+    netchunk_ftp_transfer_t* transfer);
+
+/**
+ * @brief Prepare an upload of one or more caller-owned buffers
+ * @param transfer Transfer to initialize
+ * @param server_index Index of target server in the configuration
+ * @param remote_path Path relative to the server's base_path
+ * @param segments Buffers to upload in order (must outlive the transfer)
+ * @param segment_count Number of segments (at most NETCHUNK_FTP_ENGINE_MAX_SEGMENTS)
+ * @param callback Completion callback
+ * @param userdata User data passed to callback
+ * @return NETCHUNK_SUCCESS on success, error code on failure
+ */
+netchunk_error_t netchunk_ftp_transfer_init_upload(netchunk_ftp_transfer_t* transfer,
+    int server_index,
+    const char* remote_path,
+    const netchunk_ftp_segment_t* segments,
+    size_t segment_count,
+    netchunk_ftp_transfer_callback_t callback,
+    void* userdata);
+
+/**
+ * @brief Prepare a download into the transfer's memory buffer
+ * @param transfer Transfer to initialize
+ * @param server_index Index of source server in the configuration
+ * @param remote_path Path relative to the server's base_path
+ * @param expected_size Expected size, used to preallocate (0 if unknown)
+ * @param callback Completion callback
+ * @param userdata User data passed to callback
+ * @return NETCHUNK_SUCCESS on success, error code on failure
+ */
+netchunk_error_t netchunk_ftp_transfer_init_download(netchunk_ftp_transfer_t* transfer,
+    int server_index,
+    const char* remote_path,
+    size_t expected_size,
+    netchunk_ftp_transfer_callback_t callback,
+    void* userdata);
+
+/**
+ * @brief Prepare deletion of a remote file
+ * @param transfer Transfer to initialize
+ * @param server_index Index of server in the configuration
+ * @param remote_path Path relative to the server's base_path
+ * @param callback Completion callback
+ * @param userdata User data passed to callback
+ * @return NETCHUNK_SUCCESS on success, error code on failure
+ */
+netchunk_error_t netchunk_ftp_transfer_init_delete(netchunk_ftp_transfer_t* transfer,
+    int server_index,
+    const char* remote_path,
+    netchunk_ftp_transfer_callback_t callback,
+    void* userdata);
+
+/**
+ * @brief Allow a download to run on another replica while its server is saturated
+ *
+ * When every slot for server_index is busy, the engine starts the transfer
+ * on the first listed server with spare capacity instead; server_index is
+ * updated to the server actually used.
+ *
+ * Alternates also enable hedging: once the download has run longer than
+ * its server's p95 transfer time, a backup request is sent to the best
+ * ranked alternate with a free slot, the first copy to arrive is used and
+ * the other request is cancelled. Backups are limited to
+ * hedge_budget_percent of download attempts, with bursts of up to
+ * NETCHUNK_FTP_HEDGE_BURST. A download won by its backup reports hedged
+ * and the alternate's server_index.
+ *
+ * @param transfer Download transfer to update
+ * @param server_indices Servers holding the same data
+ * @param count Number of servers
+ * @return NETCHUNK_SUCCESS on success, error code on failure
+ */
+netchunk_error_t netchunk_ftp_transfer_set_alternates(netchunk_ftp_transfer_t* transfer,
+    const int* server_indices,
+    int count);
+
+/**
+ * @brief Order replica servers by their observed performance, best first
+ *
+ * Uses the latency, throughput and error rate of the engine's past
+ * transfers and the transfers each server is running now. Ties keep the
+ * given order.
+ *
+ * @param engine Transfer engine
+ * @param server_indices Servers holding the same data, reordered in place
+ * @param count Number of servers
+ * @param size Size of the data in bytes
+ */
+void netchunk_ftp_engine_rank_servers(netchunk_ftp_engine_t* engine,
+    int* server_indices,
+    int count,
+    size_t size);
+
+/**
+ * @brief Feed the result of a connectivity probe into a server's score
+ * @param engine Transfer engine
+ * @param server_index Probed server
+ * @param success Whether the server answered
+ * @param latency_ms Time the probe took
+ */
+void netchunk_ftp_engine_record_probe(netchunk_ftp_engine_t* engine,
+    int server_index,
+    bool success,
+    double latency_ms);
+
+/**
+ * @brief Get a snapshot of a server's score
+ * @param engine Transfer engine
+ * @param server_index Server index
+ * @param score Output score
+ * @return NETCHUNK_SUCCESS on success, error code on failure
+ */
+netchunk_error_t netchunk_ftp_engine_get_score(netchunk_ftp_engine_t* engine,
+    int server_index,
+    netchunk_server_score_t* score);
+
+/**
+ * @brief Release resources held by a completed transfer (download buffer)
+ * @param transfer Transfer to cleanup
+ */
+void netchunk_ftp_transfer_cleanup(netchunk_ftp_transfer_t* transfer);
+
 #ifdef __cplusplus
 }
 #endif
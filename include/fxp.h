@@ -0,0 +1,64 @@
+#ifndef NETCHUNK_FXP_H
+#define NETCHUNK_FXP_H
+
+#include "config.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// FXP constants
+#define NETCHUNK_FXP_REPLY_MAX 512 // Longest control reply line kept
+#define NETCHUNK_FXP_MIN_RATE (1024 * 1024) // Bytes per second a copy is given before timing out
+
+/**
+ * @brief Whether a file can be copied directly from one server to another
+ *
+ * Both servers must be marked fxp in the configuration, since the target
+ * has to accept a data connection from the source rather than from the
+ * control client. Only plain FTP control connections are supported.
+ *
+ * @param source Server holding the file
+ * @param target Server to copy it to
+ * @return true if netchunk_fxp_copy() may be tried
+ */
+bool netchunk_fxp_supported(const netchunk_server_t* source, const netchunk_server_t* target);
+
+/**
+ * @brief Copy a file between two servers without passing it through the client
+ *
+ * Logs in to both servers, puts the target in passive mode and points the
+ * source at it with PORT, then runs STOR on the target and RETR on the
+ * source together. Missing directories on the target are created. The
+ * copy is not verified, and a failed copy may leave a partial file.
+ *
+ * @param source Server holding the file
+ * @param target Server to copy it to
+ * @param remote_path Path relative to each server's base path
+ * @param size Bytes expected, sets how long to wait for the copy
+ * @param timeout Seconds to wait for each control reply
+ * @return NETCHUNK_SUCCESS on success, error code on failure
+ */
+netchunk_error_t netchunk_fxp_copy(const netchunk_server_t* source,
+    const netchunk_server_t* target,
+    const char* remote_path,
+    uint64_t size,
+    int timeout);
+
+/**
+ * @brief Parse a 227 reply to PASV
+ *
+ * @param reply Reply line, e.g. "227 Entering Passive Mode (10,0,0,5,195,80)"
+ * @param numbers Output h1,h2,h3,h4,p1,p2 as used by PORT
+ * @return NETCHUNK_SUCCESS on success, NETCHUNK_ERROR_FTP if malformed
+ */
+netchunk_error_t netchunk_fxp_parse_pasv(const char* reply, int numbers[6]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NETCHUNK_FXP_H
@@ -0,0 +1,186 @@
+#ifndef NETCHUNK_HEALTH_MONITOR_H
+#define NETCHUNK_HEALTH_MONITOR_H
+
+#include "config.h"
+#include "ftp_client.h"
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Forward declarations
+typedef struct netchunk_server_health netchunk_server_health_t;
+typedef struct netchunk_health_snapshot netchunk_health_snapshot_t;
+typedef struct netchunk_health_monitor netchunk_health_monitor_t;
+
+// Health monitor constants
+#define NETCHUNK_HEALTH_START_DELAY 10 // Seconds before the worker's first round; short runs never probe
+#define NETCHUNK_HEALTH_USAGE_INTERVAL 3600 // Seconds between listings of a server's chunk directory
+#define NETCHUNK_HEALTH_FAILURE_LIMIT 2 // Failed probes in a row before a server is unavailable
+
+/**
+ * @brief Last known state of one server
+ */
+typedef struct netchunk_server_health {
+    netchunk_server_status_t status; // NETCHUNK_SERVER_UNKNOWN until the first probe
+    double latency_ms; // Duration of the last successful probe
+    uint64_t bytes_available; // Free space reported by the server, 0 if unknown
+    int capacity_step; // Free space bucket placement weighs by, kept across rounds; 0 if unknown
+    uint64_t bytes_used; // Size of the server's chunk files, 0 if unknown
+    time_t checked_at; // Time of the last probe, 0 if never probed
+    int consecutive_failures; // Failed probes since the last success
+} netchunk_server_health_t;
+
+/**
+ * @brief State of all servers as of one probe round
+ */
+typedef struct netchunk_health_snapshot {
+    uint64_t generation; // Probe rounds published so far, 0 before the first
+    int server_count;
+    netchunk_server_health_t servers[NETCHUNK_MAX_SERVERS]; // Indexed like config->servers
+} netchunk_health_snapshot_t;
+
+/**
+ * @brief Background prober of the configured servers
+ *
+ * A worker thread probes every server each health_check_interval seconds
+ * and publishes the results as a snapshot. Free space is asked for on
+ * every round; usage takes a listing, so it is refreshed only once per
+ * NETCHUNK_HEALTH_USAGE_INTERVAL. Readers copy the snapshot without
+ * locking or touching the network: it is guarded by a sequence counter
+ * that is odd while a round is being published, and a reader that sees it
+ * change retries its copy. Probes are also fed to the transfer engine's
+ * scoreboard so replica ranking follows them.
+ */
+typedef struct netchunk_health_monitor {
+    netchunk_config_t* config;
+    netchunk_ftp_context_t* ftp_context;
+    netchunk_health_snapshot_t snapshot; // Read through netchunk_health_monitor_read() only
+    uint64_t sequence; // Odd while the snapshot is being written
+    time_t usage_checked_at[NETCHUNK_MAX_SERVERS]; // Last listing of each chunk directory, or init time
+    bool no_usage_listing[NETCHUNK_MAX_SERVERS]; // Server refused MLSD; usage is not listed
+
+    pthread_mutex_t mutex; // Serializes probe rounds
+    pthread_mutex_t wait_mutex;
+    pthread_cond_t wake; // The worker should stop
+    pthread_t thread;
+    bool thread_running;
+    bool stopping;
+} netchunk_health_monitor_t;
+
+/**
+ * @brief Initialize a health monitor without starting its worker
+ * @param monitor Monitor to initialize
+ * @param config Configuration holding the servers
+ * @param ftp_context FTP context whose scoreboard receives the probes
+ * @return NETCHUNK_SUCCESS on success, error code on failure
+ */
+netchunk_error_t netchunk_health_monitor_init(netchunk_health_monitor_t* monitor,
+    netchunk_config_t* config,
+    netchunk_ftp_context_t* ftp_context);
+
+/**
+ * @brief Start the worker thread
+ *
+ * The first round runs NETCHUNK_HEALTH_START_DELAY seconds later, then one
+ * every health_check_interval seconds.
+ *
+ * @param monitor Initialized monitor
+ * @return NETCHUNK_SUCCESS on success, error code on failure
+ */
+netchunk_error_t netchunk_health_monitor_start(netchunk_health_monitor_t* monitor);
+
+/**
+ * @brief Probe every server now and publish the results
+ *
+ * Blocks for the duration of the probes; rounds do not overlap.
+ *
+ * @param monitor Initialized monitor
+ * @return NETCHUNK_SUCCESS on success, error code on failure
+ */
+netchunk_error_t netchunk_health_monitor_probe_all(netchunk_health_monitor_t* monitor);
+
+/**
+ * @brief Probe every server now unless a round has been published already
+ *
+ * For callers that need real results before the worker's first round.
+ *
+ * @param monitor Initialized monitor
+ * @return NETCHUNK_SUCCESS on success, error code on failure
+ */
+netchunk_error_t netchunk_health_monitor_ensure_probed(netchunk_health_monitor_t* monitor);
+
+/**
+ * @brief Replace the published snapshot
+ *
+ * @param monitor Initialized monitor
+ * @param snapshot New state; its generation is assigned here
+ */
+void netchunk_health_monitor_publish(netchunk_health_monitor_t* monitor, const netchunk_health_snapshot_t* snapshot);
+
+/**
+ * @brief Copy the published snapshot
+ * @param monitor Initialized monitor
+ * @param snapshot Output snapshot
+ */
+void netchunk_health_monitor_read(const netchunk_health_monitor_t* monitor, netchunk_health_snapshot_t* snapshot);
+
+/**
+ * @brief Copy the published state of one server
+ * @param monitor Initialized monitor
+ * @param server_index Index into config->servers
+ * @param health Output state
+ * @return false if the index is out of range
+ */
+bool netchunk_health_monitor_read_server(const netchunk_health_monitor_t* monitor,
+    int server_index,
+    netchunk_server_health_t* health);
+
+/**
+ * @brief Whether a server may be given new work
+ *
+ * Servers not probed yet are assumed usable, so a monitor that has not
+ * finished its first round never holds anything back. A NULL monitor
+ * treats every server as usable.
+ *
+ * @param monitor Monitor, or NULL
+ * @param server_index Index into config->servers
+ * @return false if the last probes found the server unavailable
+ */
+bool netchunk_health_monitor_usable(const netchunk_health_monitor_t* monitor, int server_index);
+
+/**
+ * @brief Status a server's probe results put it in
+ *
+ * A server is unavailable after NETCHUNK_HEALTH_FAILURE_LIMIT failed probes
+ * in a row, and degraded while slower than latency_alert_threshold or
+ * fuller than storage_alert_threshold.
+ *
+ * @param config Configuration holding the thresholds
+ * @param health Server state with everything but status filled in
+ * @return Server status
+ */
+netchunk_server_status_t netchunk_health_classify(const netchunk_config_t* config,
+    const netchunk_server_health_t* health);
+
+/**
+ * @brief Stop the worker and release the monitor
+ *
+ * Copies the last state of every probed server into config->servers once
+ * the worker has stopped; while the monitor runs the configuration is
+ * left alone, since other threads read it without locking, and the
+ * current state is only available through the snapshot.
+ *
+ * @param monitor Monitor to clean up
+ */
+void netchunk_health_monitor_cleanup(netchunk_health_monitor_t* monitor);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NETCHUNK_HEALTH_MONITOR_H
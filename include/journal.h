@@ -0,0 +1,182 @@
+#ifndef NETCHUNK_JOURNAL_H
+#define NETCHUNK_JOURNAL_H
+
+#include "chunker.h"
+#include "config.h"
+#include "manifest.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Forward declarations
+typedef struct netchunk_journal netchunk_journal_t;
+
+// Journal constants
+#define NETCHUNK_JOURNAL_VERSION "1.0"
+#define NETCHUNK_JOURNAL_DIRECTORY "journal" // Under local_storage_path
+#define NETCHUNK_JOURNAL_EXTENSION ".journal"
+#define NETCHUNK_JOURNAL_CHECKPOINT_INTERVAL 2 // Seconds between checkpoints of a running transfer
+
+// Operation a journal belongs to
+typedef enum netchunk_journal_operation {
+    NETCHUNK_JOURNAL_UPLOAD = 0,
+    NETCHUNK_JOURNAL_DOWNLOAD = 1
+} netchunk_journal_operation_t;
+
+/**
+ * @brief Checkpoint of an interrupted upload or download
+ *
+ * An upload journal lists the chunks already committed, in sequence order,
+ * with the servers holding them, so a retry only re-reads and re-hashes
+ * them. A download journal marks which manifest chunks were written to the
+ * local file; a retry verifies those ranges against the chunk hashes
+ * instead of fetching them again. The identity fields tie a journal to one
+ * source file or manifest; when they no longer match, the journal is reset.
+ */
+typedef struct netchunk_journal {
+    char path[NETCHUNK_MAX_PATH_LEN]; // Backing file
+    netchunk_journal_operation_t operation;
+    char remote_name[NETCHUNK_MAX_PATH_LEN]; // Remote file name identifier
+    char local_path[NETCHUNK_MAX_PATH_LEN]; // Local source or destination
+
+    // Upload identity: the local file and how it is chunked
+    uint64_t source_size;
+    time_t source_modified;
+    size_t chunk_size;
+    netchunk_chunking_mode_t chunking_mode;
+    bool content_addressed;
+
+    // Download identity: the manifest being restored
+    char manifest_id[64];
+    uint8_t file_hash[NETCHUNK_HASH_LENGTH];
+    uint64_t total_size;
+
+    // Upload progress: committed chunks, chunks[i] has sequence number i
+    netchunk_chunk_t* chunks;
+    uint32_t chunk_count;
+    uint32_t chunk_capacity;
+
+    // Download progress: one flag per manifest chunk
+    bool* completed;
+    uint32_t completed_length;
+
+    time_t last_checkpoint; // When the journal was last written
+    bool dirty; // Progress not yet written
+} netchunk_journal_t;
+
+/**
+ * @brief Initialize an empty journal for one transfer
+ *
+ * The backing file is named after the operation, remote name and local
+ * path, so each transfer has its own journal in directory.
+ *
+ * @param journal Journal to initialize
+ * @param directory Journal directory (~ is expanded, created on first save)
+ * @param operation Upload or download
+ * @param remote_name Remote file name identifier
+ * @param local_path Local source or destination path
+ * @return NETCHUNK_SUCCESS on success, error code on failure
+ */
+netchunk_error_t netchunk_journal_init(netchunk_journal_t* journal,
+    const char* directory,
+    netchunk_journal_operation_t operation,
+    const char* remote_name,
+    const char* local_path);
+
+/**
+ * @brief Load the journal of an earlier attempt
+ * @param journal Initialized journal
+ * @return NETCHUNK_SUCCESS on success, NETCHUNK_ERROR_FILE_NOT_FOUND if there
+ *         is none, NETCHUNK_ERROR_MANIFEST_CORRUPT if it cannot be used
+ */
+netchunk_error_t netchunk_journal_load(netchunk_journal_t* journal);
+
+/**
+ * @brief Write the journal atomically
+ * @param journal Journal to save
+ * @return NETCHUNK_SUCCESS on success, error code on failure
+ */
+netchunk_error_t netchunk_journal_save(netchunk_journal_t* journal);
+
+/**
+ * @brief Save the journal if it has unsaved progress and the checkpoint interval elapsed
+ * @param journal Journal to checkpoint
+ * @return NETCHUNK_SUCCESS on success, error code on failure
+ */
+netchunk_error_t netchunk_journal_checkpoint(netchunk_journal_t* journal);
+
+/**
+ * @brief Forget all progress, keeping the journal's identity and path
+ * @param journal Journal to reset
+ */
+void netchunk_journal_reset(netchunk_journal_t* journal);
+
+/**
+ * @brief Remove the backing file once the transfer completed
+ * @param journal Journal to discard
+ */
+void netchunk_journal_discard(netchunk_journal_t* journal);
+
+/**
+ * @brief Free journal resources
+ * @param journal Journal to cleanup
+ */
+void netchunk_journal_cleanup(netchunk_journal_t* journal);
+
+/**
+ * @brief Record a committed upload chunk
+ * @param journal Upload journal
+ * @param chunk Chunk with its replica locations; replaces the entry of the
+ *              same sequence number, or must be the next one
+ * @return NETCHUNK_SUCCESS on success, error code on failure
+ */
+netchunk_error_t netchunk_journal_record_chunk(netchunk_journal_t* journal, const netchunk_chunk_t* chunk);
+
+/**
+ * @brief Find a committed upload chunk by sequence number
+ * @param journal Upload journal
+ * @param sequence_number Chunk sequence number
+ * @return Journaled chunk (no data) or NULL if not committed
+ */
+const netchunk_chunk_t* netchunk_journal_find_chunk(const netchunk_journal_t* journal, uint32_t sequence_number);
+
+/**
+ * @brief Size the download progress flags for a manifest
+ * @param journal Download journal
+ * @param chunk_count Number of chunks in the manifest
+ * @return NETCHUNK_SUCCESS on success, error code on failure
+ */
+netchunk_error_t netchunk_journal_set_chunk_count(netchunk_journal_t* journal, uint32_t chunk_count);
+
+/**
+ * @brief Mark a manifest chunk as written, or not
+ * @param journal Download journal
+ * @param index Chunk index in the manifest
+ * @param completed Whether the chunk's range holds verified data
+ */
+void netchunk_journal_set_completed(netchunk_journal_t* journal, uint32_t index, bool completed);
+
+/**
+ * @brief Check whether a manifest chunk was written
+ * @param journal Download journal
+ * @param index Chunk index in the manifest
+ * @return true if the chunk was recorded as written
+ */
+bool netchunk_journal_is_completed(const netchunk_journal_t* journal, uint32_t index);
+
+/**
+ * @brief Check whether the journal records any progress
+ * @param journal Journal to inspect
+ * @return true if at least one chunk is recorded
+ */
+bool netchunk_journal_has_progress(const netchunk_journal_t* journal);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NETCHUNK_JOURNAL_H
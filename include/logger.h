@@ -10,7 +10,9 @@
 #define NETCHUNK_LOGGER_H
 
 #include "config.h"
+#include <pthread.h>
 #include <stdarg.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <time.h>
 
@@ -20,6 +22,21 @@ extern "C" {
 
 // Log levels are defined in config.h
 
+// Logger constants
+#define NETCHUNK_LOGGER_LINE_MAX 1024 // Longest queued line in async mode, newline included
+#define NETCHUNK_LOGGER_DEFAULT_QUEUE_LINES 4096
+#define NETCHUNK_LOGGER_BATCH_SIZE (64 * 1024) // Bytes the writer thread gathers per write
+#define NETCHUNK_LOGGER_IDLE_WAIT_MS 100 // Writer sleep when the queue is empty
+
+/**
+ * @brief One line waiting in the async queue
+ */
+typedef struct {
+    uint64_t sequence; // Position the slot is ready for; see netchunk_logger_context_t
+    size_t length;
+    char text[NETCHUNK_LOGGER_LINE_MAX];
+} netchunk_logger_slot_t;
+
 /**
  * @brief Logger configuration
  */
@@ -33,15 +50,41 @@ typedef struct {
     bool include_timestamp; // Include timestamp in logs
     bool include_level; // Include level in logs
     bool include_location; // Include file:line in logs
+    bool async; // Hand lines to a writer thread instead of writing them inline
+    size_t async_queue_lines; // Lines the async queue holds, rounded up to a power of two
 } netchunk_logger_config_t;
 
 /**
  * @brief Logger context
+ *
+ * In async mode callers format straight into a slot of a bounded ring
+ * shared by all threads. A slot is claimed by advancing tail with a
+ * compare-and-swap and handed over by storing its position + 1 in the
+ * slot's sequence, so producers never take a lock. The writer thread
+ * gathers ready lines into batches, writes each batch with one call and
+ * flushes once per batch; it alone rotates the file. When the ring is
+ * full, errors wait for room and other lines are dropped and counted.
+ *
+ * In sync mode lines are written by the caller under output_mutex.
  */
 typedef struct {
     netchunk_logger_config_t config; // Logger configuration
     FILE* log_file; // Current log file handle
     size_t current_file_size; // Current log file size
+    pthread_mutex_t output_mutex; // Guards log_file, current_file_size and rotation
+
+    netchunk_logger_slot_t* slots; // Async ring, NULL in sync mode
+    uint64_t slot_mask; // Slot count - 1
+    uint64_t tail; // Next position producers claim
+    uint64_t head; // Next position the writer takes
+    uint64_t dropped; // Lines lost to a full ring
+    bool writer_idle; // Writer waits for wake
+    bool stopping;
+    pthread_t writer;
+    pthread_mutex_t wake_mutex;
+    pthread_cond_t wake; // Lines were queued, or the writer should stop
+    pthread_cond_t written; // The writer finished a batch
+
     bool initialized; // Initialization flag
 } netchunk_logger_context_t;
 
@@ -65,6 +108,17 @@ netchunk_error_t netchunk_logger_init(netchunk_logger_context_t* context,
 netchunk_error_t netchunk_logger_set_level(netchunk_logger_context_t* context,
     netchunk_log_level_t level);
 
+/**
+ * @brief Whether a message of a level would be logged
+ *
+ * The logging macros check this before evaluating their arguments.
+ *
+ * @param context Logger context
+ * @param level Log level
+ * @return true if messages of the level are written
+ */
+bool netchunk_logger_enabled(const netchunk_logger_context_t* context, netchunk_log_level_t level);
+
 /**
  * @brief Log a message with specified level
  *
@@ -110,6 +164,9 @@ netchunk_error_t netchunk_logger_rotate(netchunk_logger_context_t* context);
 /**
  * @brief Flush all pending log messages
  *
+ * In async mode this waits until the writer thread has written every line
+ * queued before the call.
+ *
  * @param context Logger context
  */
 void netchunk_logger_flush(netchunk_logger_context_t* context);
@@ -122,27 +179,42 @@ void netchunk_logger_flush(netchunk_logger_context_t* context);
  */
 const char* netchunk_logger_level_string(netchunk_log_level_t level);
 
+/**
+ * @brief Number of lines dropped because the async queue was full
+ *
+ * @param context Logger context
+ * @return Lines dropped since initialization
+ */
+uint64_t netchunk_logger_dropped(const netchunk_logger_context_t* context);
+
 /**
  * @brief Cleanup logger and close files
  *
+ * Lines still queued are written first.
+ *
  * @param context Logger context to cleanup
  */
 void netchunk_logger_cleanup(netchunk_logger_context_t* context);
 
 /**
  * @brief Convenience macros for logging
+ *
+ * Arguments are not evaluated for levels that are filtered out.
  */
-#define NETCHUNK_LOG_ERROR_MSG(ctx, fmt, ...) \
-    netchunk_logger_log(ctx, NETCHUNK_LOG_ERROR, __FILE__, __LINE__, fmt, ##__VA_ARGS__)
+#define NETCHUNK_LOG_MSG(ctx, level, fmt, ...)                                            \
+    do {                                                                                  \
+        netchunk_logger_context_t* log_ctx_ = (ctx);                                      \
+        if (netchunk_logger_enabled(log_ctx_, level))                                     \
+            netchunk_logger_log(log_ctx_, level, __FILE__, __LINE__, fmt, ##__VA_ARGS__); \
+    } while (0)
+
+#define NETCHUNK_LOG_ERROR_MSG(ctx, fmt, ...) NETCHUNK_LOG_MSG(ctx, NETCHUNK_LOG_ERROR, fmt, ##__VA_ARGS__)
 
-#define NETCHUNK_LOG_WARN_MSG(ctx, fmt, ...) \
-    netchunk_logger_log(ctx, NETCHUNK_LOG_WARN, __FILE__, __LINE__, fmt, ##__VA_ARGS__)
+#define NETCHUNK_LOG_WARN_MSG(ctx, fmt, ...) NETCHUNK_LOG_MSG(ctx, NETCHUNK_LOG_WARN, fmt, ##__VA_ARGS__)
 
-#define NETCHUNK_LOG_INFO_MSG(ctx, fmt, ...) \
-    netchunk_logger_log(ctx, NETCHUNK_LOG_INFO, __FILE__, __LINE__, fmt, ##__VA_ARGS__)
+#define NETCHUNK_LOG_INFO_MSG(ctx, fmt, ...) NETCHUNK_LOG_MSG(ctx, NETCHUNK_LOG_INFO, fmt, ##__VA_ARGS__)
 
-#define NETCHUNK_LOG_DEBUG_MSG(ctx, fmt, ...) \
-    netchunk_logger_log(ctx, NETCHUNK_LOG_DEBUG, __FILE__, __LINE__, fmt, ##__VA_ARGS__)
+#define NETCHUNK_LOG_DEBUG_MSG(ctx, fmt, ...) NETCHUNK_LOG_MSG(ctx, NETCHUNK_LOG_DEBUG, fmt, ##__VA_ARGS__)
 
 /**
  * @brief Global logger instance (if desired)
@@ -167,25 +239,13 @@ void netchunk_logger_cleanup_global(void);
 /**
  * @brief Global logging macros (use global logger instance)
  */
-#define NETCHUNK_ERROR(fmt, ...)                \
-    if (netchunk_global_logger)                 \
-    netchunk_logger_log(netchunk_global_logger, \
-        NETCHUNK_LOG_ERROR, __FILE__, __LINE__, fmt, ##__VA_ARGS__)
-
-#define NETCHUNK_WARN(fmt, ...)                 \
-    if (netchunk_global_logger)                 \
-    netchunk_logger_log(netchunk_global_logger, \
-        NETCHUNK_LOG_WARN, __FILE__, __LINE__, fmt, ##__VA_ARGS__)
-
-#define NETCHUNK_INFO(fmt, ...)                 \
-    if (netchunk_global_logger)                 \
-    netchunk_logger_log(netchunk_global_logger, \
-        NETCHUNK_LOG_INFO, __FILE__, __LINE__, fmt, ##__VA_ARGS__)
-
-#define NETCHUNK_DEBUG(fmt, ...)                \
-    if (netchunk_global_logger)                 \
-    netchunk_logger_log(netchunk_global_logger, \
-        NETCHUNK_LOG_DEBUG, __FILE__, __LINE__, fmt, ##__VA_ARGS__)
+#define NETCHUNK_ERROR(fmt, ...) NETCHUNK_LOG_MSG(netchunk_global_logger, NETCHUNK_LOG_ERROR, fmt, ##__VA_ARGS__)
+
+#define NETCHUNK_WARN(fmt, ...) NETCHUNK_LOG_MSG(netchunk_global_logger, NETCHUNK_LOG_WARN, fmt, ##__VA_ARGS__)
+
+#define NETCHUNK_INFO(fmt, ...) NETCHUNK_LOG_MSG(netchunk_global_logger, NETCHUNK_LOG_INFO, fmt, ##__VA_ARGS__)
+
+#define NETCHUNK_DEBUG(fmt, ...) NETCHUNK_LOG_MSG(netchunk_global_logger, NETCHUNK_LOG_DEBUG, fmt, ##__VA_ARGS__)
 
 #ifdef __cplusplus
 }
@@ -32,7 +32,8 @@ typedef struct netchunk_file_manifest {
     size_t total_size; // Total file size
     size_t original_size; // Original file size (alias for total_size)
     uint8_t file_hash[NETCHUNK_HASH_LENGTH]; // SHA-256 hash of entire file
-    size_t chunk_size; // Chunk size used
+    size_t chunk_size; // Chunk size used (average size for CDC)
+    netchunk_chunking_mode_t chunking_mode; // How chunk boundaries were chosen
     uint32_t chunk_count; // Number of chunks
 
     // Timestamps
@@ -44,11 +45,19 @@ typedef struct netchunk_file_manifest {
     // Chunks array
     netchunk_chunk_t* chunks; // Array of chunks
     bool chunks_owned; // Whether this structure owns the chunks array
+    uint32_t chunk_capacity; // Allocated entries in an owned chunks array
 
     // Replication settings
     int replication_factor; // Number of replicas per chunk
     int min_replicas_required; // Minimum replicas needed for reconstruction
 
+    // Erasure coding (ec_data_shards == 0: chunks are replicated instead)
+    int ec_data_shards; // Data chunks per stripe, in chunk order
+    int ec_parity_shards; // Parity chunks per stripe
+    netchunk_chunk_t* parity_chunks; // ec_parity_shards per stripe, in stripe order
+    uint32_t parity_count; // Entries in parity_chunks
+    uint32_t parity_capacity; // Allocated entries in parity_chunks
+
     // Manifest metadata
     char creator_info[256]; // Information about who created the manifest
     char comment[512]; // Optional comment
@@ -115,7 +124,20 @@ netchunk_error_t netchunk_manifest_init(netchunk_file_manifest_t* manifest,
     size_t file_size);
 
 /**
- * @brief Add chunk to manifest
+ * @brief Preallocate room for chunks so adding them does not reallocate
+ * @param manifest Manifest to grow
+ * @param count Total number of chunks expected
+ * @return NETCHUNK_SUCCESS on success, error code on failure
+ */
+netchunk_error_t netchunk_manifest_reserve_chunks(netchunk_file_manifest_t* manifest,
+    uint32_t count);
+
+/**
+ * @brief Add chunk metadata to manifest
+ *
+ * Only metadata is stored: the chunk's data is not copied, so the manifest
+ * stays small however large the file is. The array grows geometrically.
+ *
  * @param manifest Manifest to add chunk to
  * @param chunk Chunk to add
  * @return NETCHUNK_SUCCESS on success, error code on failure
@@ -123,6 +145,49 @@ netchunk_error_t netchunk_manifest_init(netchunk_file_manifest_t* manifest,
 netchunk_error_t netchunk_manifest_add_chunk(netchunk_file_manifest_t* manifest,
     const netchunk_chunk_t* chunk);
 
+/**
+ * @brief Add parity chunk metadata to an erasure-coded manifest
+ *
+ * Parity chunks are added in stripe order, ec_parity_shards per stripe.
+ * As with netchunk_manifest_add_chunk() only metadata is stored.
+ *
+ * @param manifest Manifest to add chunk to
+ * @param chunk Parity chunk to add
+ * @return NETCHUNK_SUCCESS on success, error code on failure
+ */
+netchunk_error_t netchunk_manifest_add_parity_chunk(netchunk_file_manifest_t* manifest,
+    const netchunk_chunk_t* chunk);
+
+/**
+ * @brief Check whether a manifest stores its chunks in erasure-coded stripes
+ * @param manifest Manifest to check
+ * @return true if chunks have parity instead of replicas
+ */
+bool netchunk_manifest_is_erasure_coded(const netchunk_file_manifest_t* manifest);
+
+/**
+ * @brief Number of stripes in an erasure-coded manifest
+ * @param manifest Manifest to check
+ * @return Stripe count, 0 if the manifest is replicated
+ */
+uint32_t netchunk_manifest_stripe_count(const netchunk_file_manifest_t* manifest);
+
+/**
+ * @brief Find a shard of a stripe
+ *
+ * Shards are numbered data first (0 to ec_data_shards - 1), then parity.
+ * The last stripe may have fewer data chunks than ec_data_shards; its
+ * missing data shards count as all zeros and have no chunk.
+ *
+ * @param manifest Erasure-coded manifest
+ * @param stripe Stripe index
+ * @param shard Shard index within the stripe
+ * @return The shard's chunk, or NULL if the shard has none
+ */
+netchunk_chunk_t* netchunk_manifest_stripe_shard(const netchunk_file_manifest_t* manifest,
+    uint32_t stripe,
+    int shard);
+
 /**
  * @brief Cleanup manifest structure (alias for netchunk_file_manifest_cleanup)
  * @param manifest Manifest to cleanup
@@ -336,6 +401,29 @@ netchunk_error_t netchunk_manifest_build_path(netchunk_manifest_manager_t* manag
     char* full_path,
     size_t path_len);
 
+/**
+ * @brief Write a file through a temporary file and rename
+ *
+ * The data is flushed to disk before the rename, so readers see either the
+ * old or the new content, never a torn file.
+ *
+ * @param file_path Destination path
+ * @param content Data to write
+ * @param size Size of data in bytes
+ * @return NETCHUNK_SUCCESS on success, error code on failure
+ */
+netchunk_error_t netchunk_manifest_write_atomic(const char* file_path, const char* content, size_t size);
+
+/**
+ * @brief Read a whole file into a NUL-terminated buffer
+ * @param file_path File to read
+ * @param content Output buffer (caller must free)
+ * @param size Output size in bytes, excluding the terminator
+ * @return NETCHUNK_SUCCESS on success, NETCHUNK_ERROR_FILE_NOT_FOUND if the
+ *         file cannot be opened, error code on failure
+ */
+netchunk_error_t netchunk_manifest_read_file(const char* file_path, char** content, size_t* size);
+
 /**
  * @brief Get manifest statistics
  * @param manifest Manifest to analyze
@@ -0,0 +1,184 @@
+#ifndef NETCHUNK_MANIFEST_PACK_H
+#define NETCHUNK_MANIFEST_PACK_H
+
+#include "manifest.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Forward declarations
+typedef struct netchunk_packed_manifest netchunk_packed_manifest_t;
+typedef struct netchunk_packed_location netchunk_packed_location_t;
+
+// Packed manifest format constants
+#define NETCHUNK_PACKED_MANIFEST_MAGIC 0x464d434eu // "NCMF" in a little-endian file
+#define NETCHUNK_PACKED_MANIFEST_VERSION 4 // Adds chunk key IDs; versions 1 to 3 are still read
+#define NETCHUNK_PACKED_NO_STRING UINT32_MAX // Chunk ID derived from the hash
+
+/**
+ * @brief One replica of a chunk in a packed manifest
+ */
+typedef struct netchunk_packed_location {
+    int64_t upload_time; // When uploaded to this server
+    int64_t last_verified; // Last verification timestamp
+    uint16_t server; // Index into the interned server IDs
+    uint8_t verified; // Whether integrity was verified
+    uint8_t reserved[5];
+} netchunk_packed_location_t;
+
+/**
+ * @brief Compact, read-only manifest stored as one flat buffer
+ *
+ * The same layout is used in memory and on disk, so a manifest file is
+ * mmap()ed and used in place: opening it costs a header check regardless
+ * of chunk count, and chunks are only expanded when asked for. Per-chunk
+ * fields are kept as arrays (hashes, sizes, offsets...), server IDs are
+ * interned and referenced by index, and remote paths are not stored since
+ * they derive from the chunk ID. Parity chunks of erasure-coded files
+ * follow the data chunks in the same arrays. The format is versioned; JSON
+ * (netchunk_file_manifest_to_json()) remains the export format.
+ */
+typedef struct netchunk_packed_manifest {
+    const uint8_t* base; // Start of the packed buffer
+    size_t size; // Buffer size in bytes
+    void* mapping; // mmap()ed file backing base, or NULL
+    uint8_t* buffer; // Heap buffer backing base, or NULL
+
+    // File metadata
+    const char* original_filename;
+    uint64_t total_size;
+    const uint8_t* file_hash; // NETCHUNK_HASH_LENGTH bytes
+    uint32_t chunk_count;
+
+    // Erasure coding (ec_data_shards == 0: no parity chunks)
+    int ec_data_shards;
+    int ec_parity_shards;
+    uint32_t parity_count;
+
+    // Interned server IDs
+    uint32_t server_count;
+    const char (*server_ids)[NETCHUNK_MAX_SERVER_ID_LEN];
+
+    // Per-chunk arrays: data chunks by position in the manifest, then parity chunks
+    const uint8_t (*hashes)[NETCHUNK_HASH_LENGTH];
+    const uint64_t* sizes;
+    const uint64_t* offsets;
+    const uint32_t* sequence_numbers;
+    const int64_t* created_timestamps;
+    const uint32_t* id_strings; // String table offsets, or NETCHUNK_PACKED_NO_STRING
+    const uint32_t* location_index; // Chunk i owns locations [index[i], index[i + 1])
+
+    // Locations of all chunks, in chunk order
+    uint32_t location_count;
+    const netchunk_packed_location_t* locations;
+
+    // NUL-terminated strings referenced by offset
+    const char* strings;
+    uint64_t strings_size;
+
+    // Codec and stored bytes of each entry, NULL before version 3
+    const uint8_t* codecs;
+    const uint64_t* stored_sizes;
+
+    // Key ID of each entry, NULL before version 4
+    const uint8_t (*key_ids)[NETCHUNK_KEY_ID_LENGTH];
+} netchunk_packed_manifest_t;
+
+// Packing Functions
+
+/**
+ * @brief Pack a manifest into a new heap buffer
+ * @param manifest Manifest to pack
+ * @param packed Output packed manifest, released with netchunk_packed_manifest_close()
+ * @return NETCHUNK_SUCCESS on success, error code on failure
+ */
+netchunk_error_t netchunk_manifest_pack(const netchunk_file_manifest_t* manifest,
+    netchunk_packed_manifest_t* packed);
+
+/**
+ * @brief Expand a packed manifest into a regular manifest
+ * @param packed Packed manifest
+ * @param manifest Output manifest, cleaned up with netchunk_file_manifest_cleanup()
+ * @return NETCHUNK_SUCCESS on success, error code on failure
+ */
+netchunk_error_t netchunk_packed_manifest_unpack(const netchunk_packed_manifest_t* packed,
+    netchunk_file_manifest_t* manifest);
+
+/**
+ * @brief Expand one chunk without touching the others
+ * @param packed Packed manifest
+ * @param index Chunk position (0 to chunk_count - 1)
+ * @param chunk Output chunk (data is NULL)
+ * @return NETCHUNK_SUCCESS on success, NETCHUNK_ERROR_MANIFEST_CORRUPT if the
+ *         chunk's entries are inconsistent, error code on failure
+ */
+netchunk_error_t netchunk_packed_manifest_get_chunk(const netchunk_packed_manifest_t* packed,
+    uint32_t index,
+    netchunk_chunk_t* chunk);
+
+/**
+ * @brief Expand one parity chunk without touching the others
+ * @param packed Packed manifest
+ * @param index Parity chunk position (0 to parity_count - 1)
+ * @param chunk Output chunk (data is NULL)
+ * @return NETCHUNK_SUCCESS on success, NETCHUNK_ERROR_MANIFEST_CORRUPT if the
+ *         chunk's entries are inconsistent, error code on failure
+ */
+netchunk_error_t netchunk_packed_manifest_get_parity_chunk(const netchunk_packed_manifest_t* packed,
+    uint32_t index,
+    netchunk_chunk_t* chunk);
+
+// Storage Functions
+
+/**
+ * @brief Check whether data starts like a packed manifest
+ * @param data Data to check
+ * @param size Size of data
+ * @return true if the magic number matches
+ */
+bool netchunk_packed_manifest_detect(const void* data, size_t size);
+
+/**
+ * @brief Map a packed manifest file read-only
+ * @param packed Output packed manifest
+ * @param path File path
+ * @return NETCHUNK_SUCCESS on success, NETCHUNK_ERROR_MANIFEST_CORRUPT if the
+ *         file is not a valid packed manifest, error code on failure
+ */
+netchunk_error_t netchunk_packed_manifest_open(netchunk_packed_manifest_t* packed, const char* path);
+
+/**
+ * @brief Validate and copy a packed manifest held in memory
+ * @param packed Output packed manifest
+ * @param data Packed bytes, e.g. as downloaded
+ * @param size Size of data
+ * @return NETCHUNK_SUCCESS on success, NETCHUNK_ERROR_MANIFEST_CORRUPT if the
+ *         data is not a valid packed manifest, error code on failure
+ */
+netchunk_error_t netchunk_packed_manifest_from_buffer(netchunk_packed_manifest_t* packed,
+    const void* data,
+    size_t size);
+
+/**
+ * @brief Write a packed manifest to a file atomically
+ * @param packed Packed manifest
+ * @param path Destination path
+ * @return NETCHUNK_SUCCESS on success, error code on failure
+ */
+netchunk_error_t netchunk_packed_manifest_save(const netchunk_packed_manifest_t* packed, const char* path);
+
+/**
+ * @brief Unmap or free a packed manifest
+ * @param packed Packed manifest to release
+ */
+void netchunk_packed_manifest_close(netchunk_packed_manifest_t* packed);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NETCHUNK_MANIFEST_PACK_H
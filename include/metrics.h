@@ -0,0 +1,243 @@
+#ifndef NETCHUNK_METRICS_H
+#define NETCHUNK_METRICS_H
+
+#include "config.h"
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Forward declarations
+typedef struct netchunk_metrics_histogram netchunk_metrics_histogram_t;
+typedef struct netchunk_metrics_server netchunk_metrics_server_t;
+typedef struct netchunk_metrics_snapshot netchunk_metrics_snapshot_t;
+typedef struct netchunk_metrics netchunk_metrics_t;
+
+// Metrics constants
+#define NETCHUNK_METRICS_BUCKETS 28 // Bucket i counts durations up to 2^i microseconds, the last one the rest
+#define NETCHUNK_METRICS_DUMP_INTERVAL 10 // Seconds between dumps written after operations
+#define NETCHUNK_METRICS_PROMETHEUS_FILE "netchunk.prom"
+#define NETCHUNK_METRICS_JSON_FILE "netchunk.json"
+
+/**
+ * @brief Timed stages of uploads and downloads
+ *
+ * Transfers are timed per attempt and also kept per server; compression
+ * and encryption cover uploads only, decoding their reverse on downloads.
+ */
+typedef enum netchunk_metrics_phase {
+    NETCHUNK_METRICS_READ = 0, // Reading the input file
+    NETCHUNK_METRICS_HASH, // Chunk and whole-file hashing while reading
+    NETCHUNK_METRICS_COMPRESS, // Compressing a chunk
+    NETCHUNK_METRICS_ENCRYPT, // Encrypting a chunk
+    NETCHUNK_METRICS_TRANSFER, // One chunk transfer attempt on the engine
+    NETCHUNK_METRICS_DECODE, // Decrypting and decompressing a fetched chunk
+    NETCHUNK_METRICS_VERIFY, // Hashing a batch of fetched chunks
+    NETCHUNK_METRICS_WRITE, // Writing a chunk to the output file
+    NETCHUNK_METRICS_MANIFEST, // Storing or fetching a manifest
+    NETCHUNK_METRICS_PHASE_COUNT
+} netchunk_metrics_phase_t;
+
+/**
+ * @brief Running totals
+ */
+typedef enum netchunk_metrics_counter {
+    NETCHUNK_METRICS_BYTES_READ = 0, // Input file bytes chunked
+    NETCHUNK_METRICS_BYTES_WRITTEN, // Output file bytes written
+    NETCHUNK_METRICS_BYTES_SENT, // Chunk bytes uploaded, every replica counted
+    NETCHUNK_METRICS_BYTES_RECEIVED, // Chunk bytes downloaded
+    NETCHUNK_METRICS_RETRIES, // Transfer attempts repeated after a failure or a corrupt replica
+    NETCHUNK_METRICS_CACHE_HITS, // Chunks served from the memory or disk chunk cache
+    NETCHUNK_METRICS_CACHE_MISSES, // Chunks looked up in a cache and fetched instead
+    NETCHUNK_METRICS_COUNTER_COUNT
+} netchunk_metrics_counter_t;
+
+/**
+ * @brief Latency distribution with power-of-two microsecond buckets
+ *
+ * Buckets are not cumulative; the number of observations is their sum.
+ */
+typedef struct netchunk_metrics_histogram {
+    uint64_t buckets[NETCHUNK_METRICS_BUCKETS];
+    uint64_t sum_ns; // Total of all observations
+    uint64_t max_ns; // Longest observation
+} netchunk_metrics_histogram_t;
+
+/**
+ * @brief Transfer metrics of one server
+ */
+typedef struct netchunk_metrics_server {
+    char id[NETCHUNK_MAX_SERVER_ID_LEN];
+    netchunk_metrics_histogram_t transfer; // Attempt durations, failed ones included
+    uint64_t bytes_sent;
+    uint64_t bytes_received;
+    uint64_t failures; // Attempts that failed
+} netchunk_metrics_server_t;
+
+/**
+ * @brief Copy of all metrics at one point in time
+ */
+typedef struct netchunk_metrics_snapshot {
+    time_t started_at; // When collection started
+    time_t taken_at; // When the copy was made
+    netchunk_metrics_histogram_t phases[NETCHUNK_METRICS_PHASE_COUNT];
+    uint64_t counters[NETCHUNK_METRICS_COUNTER_COUNT];
+    int server_count;
+    netchunk_metrics_server_t servers[NETCHUNK_MAX_SERVERS]; // Indexed like config->servers
+} netchunk_metrics_snapshot_t;
+
+/**
+ * @brief Hot path timings and counters of one context
+ *
+ * Only created when performance_logging is set; every recording function
+ * takes a NULL collector and then does nothing, so disabled metrics cost
+ * a pointer test and no clock reads. Recording is lock-free: values are
+ * updated with relaxed atomic adds from any thread, and a snapshot may
+ * therefore see one update of a phase without the next.
+ */
+typedef struct netchunk_metrics {
+    netchunk_metrics_snapshot_t values; // Updated in place; read through netchunk_metrics_read()
+    char output_dir[NETCHUNK_MAX_PATH_LEN]; // Expanded monitoring_data_path
+    netchunk_monitoring_format_t format; // Format of dumped files
+    pthread_mutex_t dump_mutex; // Serializes dumps
+    time_t dumped_at; // Last dump, guarded by dump_mutex
+} netchunk_metrics_t;
+
+/**
+ * @brief Initialize a collector for the configured servers
+ * @param metrics Collector to initialize
+ * @param config Configuration holding the servers and the dump settings
+ * @return NETCHUNK_SUCCESS on success, error code on failure
+ */
+netchunk_error_t netchunk_metrics_init(netchunk_metrics_t* metrics, const netchunk_config_t* config);
+
+/**
+ * @brief Monotonic clock reading in nanoseconds
+ */
+uint64_t netchunk_metrics_now_ns(void);
+
+/**
+ * @brief Start timing a phase
+ * @param metrics Collector, or NULL
+ * @return Clock reading to pass to netchunk_metrics_record(), 0 if metrics is NULL
+ */
+uint64_t netchunk_metrics_start(const netchunk_metrics_t* metrics);
+
+/**
+ * @brief Record a phase timed since netchunk_metrics_start()
+ * @param metrics Collector, or NULL
+ * @param phase Phase to record
+ * @param start_ns Value returned by netchunk_metrics_start()
+ */
+void netchunk_metrics_record(netchunk_metrics_t* metrics, netchunk_metrics_phase_t phase, uint64_t start_ns);
+
+/**
+ * @brief Record a phase duration measured by the caller
+ * @param metrics Collector, or NULL
+ * @param phase Phase to record
+ * @param duration_ns Duration in nanoseconds
+ */
+void netchunk_metrics_record_duration(netchunk_metrics_t* metrics, netchunk_metrics_phase_t phase, uint64_t duration_ns);
+
+/**
+ * @brief Record one transfer attempt on a server
+ *
+ * Counts in the server's histogram and in NETCHUNK_METRICS_TRANSFER, and
+ * adds the bytes to the server's and the global byte counters.
+ *
+ * @param metrics Collector, or NULL
+ * @param server_index Index into config->servers
+ * @param success Whether the attempt succeeded
+ * @param duration_ns Duration of the attempt
+ * @param bytes_sent Bytes uploaded by the attempt
+ * @param bytes_received Bytes downloaded by the attempt
+ */
+void netchunk_metrics_record_transfer(netchunk_metrics_t* metrics,
+    int server_index,
+    bool success,
+    uint64_t duration_ns,
+    uint64_t bytes_sent,
+    uint64_t bytes_received);
+
+/**
+ * @brief Add to a counter
+ * @param metrics Collector, or NULL
+ * @param counter Counter to increase
+ * @param value Amount to add
+ */
+void netchunk_metrics_add(netchunk_metrics_t* metrics, netchunk_metrics_counter_t counter, uint64_t value);
+
+/**
+ * @brief Copy the current values
+ * @param metrics Collector
+ * @param snapshot Output copy
+ */
+void netchunk_metrics_read(const netchunk_metrics_t* metrics, netchunk_metrics_snapshot_t* snapshot);
+
+/**
+ * @brief Number of observations in a histogram
+ */
+uint64_t netchunk_metrics_histogram_count(const netchunk_metrics_histogram_t* histogram);
+
+/**
+ * @brief Upper bound of a histogram bucket
+ * @param bucket Bucket index
+ * @return Bound in seconds, or a negative value for the last, unbounded bucket
+ */
+double netchunk_metrics_bucket_bound(int bucket);
+
+/**
+ * @brief Write a snapshot in the Prometheus text exposition format or as JSON
+ * @param snapshot Values to write
+ * @param format Output format
+ * @param output Stream to write to
+ * @return NETCHUNK_SUCCESS on success, NETCHUNK_ERROR_FILE_ACCESS if writing failed
+ */
+netchunk_error_t netchunk_metrics_write(const netchunk_metrics_snapshot_t* snapshot,
+    netchunk_monitoring_format_t format,
+    FILE* output);
+
+/**
+ * @brief Write the current values to monitoring_data_path
+ *
+ * The file is replaced atomically, so a scraper never reads it half
+ * written; the Prometheus file suits node_exporter's textfile collector.
+ *
+ * @param metrics Collector
+ * @return NETCHUNK_SUCCESS on success, error code on failure
+ */
+netchunk_error_t netchunk_metrics_dump(netchunk_metrics_t* metrics);
+
+/**
+ * @brief Dump unless the last dump is less than NETCHUNK_METRICS_DUMP_INTERVAL old
+ * @param metrics Collector, or NULL
+ * @return NETCHUNK_SUCCESS if dumped or not due, error code on failure
+ */
+netchunk_error_t netchunk_metrics_dump_if_due(netchunk_metrics_t* metrics);
+
+/**
+ * @brief Name of a phase as used in dumps
+ */
+const char* netchunk_metrics_phase_name(netchunk_metrics_phase_t phase);
+
+/**
+ * @brief Name of a counter as used in dumps
+ */
+const char* netchunk_metrics_counter_name(netchunk_metrics_counter_t counter);
+
+/**
+ * @brief Release a collector
+ * @param metrics Collector to clean up
+ */
+void netchunk_metrics_cleanup(netchunk_metrics_t* metrics);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NETCHUNK_METRICS_H
@@ -13,17 +13,28 @@
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <stdio.h>
 #include <time.h>
 
+#include "catalog.h"
 #include "chunker.h"
 #include "config.h"
 #include "crypto.h"
+#include "dedup.h"
+#include "delete_queue.h"
+#include "disk_cache.h"
 #include "ftp_client.h"
+#include "health_monitor.h"
 #include "manifest.h"
+#include "metrics.h"
+#include "scrub.h"
 
 // Forward declaration for FTP context
 typedef struct netchunk_ftp_context netchunk_ftp_context_t;
 
+// Forward declaration for ranged read state
+typedef struct netchunk_read_state netchunk_read_state_t;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -36,6 +47,12 @@ extern "C" {
 #define NETCHUNK_VERSION_PATCH 0
 #define NETCHUNK_VERSION_STRING "1.0.0"
 
+/**
+ * @brief Ranged read limits
+ */
+#define NETCHUNK_READ_OPEN_FILES 8 // Manifests kept for ranged reads
+#define NETCHUNK_READ_AHEAD_MAX_CHUNKS 8 // Largest readahead window
+
 /**
  * @brief Progress callback function type
  *
@@ -60,6 +77,14 @@ typedef void (*netchunk_progress_callback_t)(
 typedef struct netchunk_context {
     netchunk_config_t* config; // Configuration
     netchunk_ftp_context_t* ftp_context; // FTP client context
+    netchunk_dedup_index_t* dedup_index; // Content-addressed chunk index (loaded on first use)
+    netchunk_catalog_t* catalog; // Local file catalog (loaded on first use)
+    netchunk_read_state_t* read_state; // Chunk cache and open manifests of ranged reads
+    netchunk_disk_cache_t* chunk_cache; // Persistent chunk cache, NULL if chunk_cache_size is 0
+    netchunk_delete_queue_t* delete_queue; // Chunk removals sent in the background, NULL unless background_delete
+    netchunk_health_monitor_t* health_monitor; // Background server prober, NULL unless health_monitoring_enabled
+    netchunk_metrics_t* metrics; // Phase timings and counters, NULL unless performance_logging
+    uint8_t encryption_key_id[NETCHUNK_KEY_ID_LENGTH]; // First key of the key file, all zero without one
     netchunk_progress_callback_t progress_cb; // Progress callback
     void* progress_userdata; // Progress callback user data
     bool initialized; // Initialization flag
@@ -74,8 +99,32 @@ typedef struct netchunk_stats {
     uint32_t servers_used; // Number of servers used
     double elapsed_seconds; // Operation duration
     uint32_t retries_performed; // Number of retries
+    uint32_t chunks_deduplicated; // Chunks already stored, not transferred again
+    uint64_t bytes_deduplicated; // Bytes of those chunks
+    uint32_t chunks_resumed; // Chunks carried over from an interrupted attempt
+    uint64_t bytes_resumed; // Bytes of those chunks
+    uint32_t cache_hits; // Chunks read from the local chunk cache instead of a server
+    uint64_t bytes_from_cache; // Bytes of those chunks
+    uint32_t cache_misses; // Chunks looked up in the local chunk cache and fetched from a server
+    uint32_t chunks_hedged; // Chunks delivered by a backup request to another replica
+    uint32_t chunks_compressed; // Uploaded chunks stored compressed
+    uint64_t bytes_stored; // File data bytes stored per replica after compression and encryption
+    uint32_t chunks_under_replicated; // Uploaded chunks stored on fewer servers than replication_factor
 } netchunk_stats_t;
 
+/**
+ * @brief Chunk cache counters since the context was initialized
+ */
+typedef struct netchunk_cache_stats {
+    uint64_t memory_hits; // Ranged read chunks found in memory
+    uint64_t memory_misses; // Ranged read chunks that were not
+    uint64_t memory_evictions; // Chunks evicted from memory
+    uint64_t memory_bytes_used; // Bytes of chunk data held in memory
+    uint64_t memory_capacity; // read_cache_size
+    netchunk_disk_cache_stats_t disk; // Persistent chunk cache counters, zero if disabled
+    uint64_t disk_capacity; // chunk_cache_size
+} netchunk_cache_stats_t;
+
 /**
  * @brief Initialize NetChunk context
  *
@@ -102,10 +151,26 @@ netchunk_error_t netchunk_set_progress_callback(
  * @brief Upload a file to the distributed storage system
  *
  * @param context NetChunk context
- * @param local_path Path to local file to upload
+ * @param local_path Path to local file to upload, or "-" for standard input
  * @param remote_name Remote file name identifier
  * @param stats Optional statistics output (can be NULL)
  * @return NETCHUNK_SUCCESS on success, error code on failure
+ *
+ * @note The input is read exactly once: each chunk and the whole-file hash
+ *       are computed in the same pass, while earlier chunks are still being
+ *       replicated. Replica uploads are queued on the shared FTP transfer
+ *       engine, which keeps up to max_concurrent_operations transfers in
+ *       flight per server. Chunks enter the manifest in sequence order with
+ *       locations sorted by server, and the progress callback is only
+ *       invoked from the calling thread.
+ * @note Committed chunks are checkpointed in a journal under
+ *       local_storage_path. If the upload fails, retrying it with the same
+ *       unchanged file re-reads every chunk but only transfers those not
+ *       already stored. Standard input cannot be resumed.
+ * @note A chunk fails the upload only when no server accepts it. Chunks
+ *       stored on fewer servers than replication_factor (or the server
+ *       count, if lower) are counted in stats->chunks_under_replicated;
+ *       netchunk_verify() with repair restores their missing replicas.
  */
 netchunk_error_t netchunk_upload(
     netchunk_context_t* context,
@@ -113,6 +178,24 @@ netchunk_error_t netchunk_upload(
     const char* remote_name,
     netchunk_stats_t* stats);
 
+/**
+ * @brief Upload from an already open stream
+ *
+ * Same as netchunk_upload() but reads from input, which may be a pipe or
+ * a descriptor received from another process. The stream is not closed.
+ *
+ * @param context NetChunk context
+ * @param input Open input stream
+ * @param remote_name Remote file name identifier
+ * @param stats Optional statistics output (can be NULL)
+ * @return NETCHUNK_SUCCESS on success, error code on failure
+ */
+netchunk_error_t netchunk_upload_stream(
+    netchunk_context_t* context,
+    FILE* input,
+    const char* remote_name,
+    netchunk_stats_t* stats);
+
 /**
  * @brief Download a file from the distributed storage system
  *
@@ -121,6 +204,19 @@ netchunk_error_t netchunk_upload(
  * @param local_path Path where to save downloaded file
  * @param stats Optional statistics output (can be NULL)
  * @return NETCHUNK_SUCCESS on success, error code on failure
+ *
+ * @note Chunk fetches are queued on the shared FTP transfer engine, up to
+ *       max_concurrent_operations per server, each from any of its replicas.
+ *       Verifier threads check each chunk and write it at its offset in a
+ *       preallocated output file, so chunks may complete out of order; the
+ *       progress callback reports completed bytes.
+ * @note Written chunks are checkpointed in a journal under
+ *       local_storage_path. If the download fails after writing some chunks,
+ *       the partial file is kept. A retry to the same path checks those
+ *       ranges against the chunk hashes and only fetches the rest.
+ * @note With chunk_cache_size set, chunks found in the local chunk cache
+ *       are read from disk instead of a server, and fetched chunks are
+ *       added to it; stats reports the hits and misses.
  */
 netchunk_error_t netchunk_download(
     netchunk_context_t* context,
@@ -128,9 +224,67 @@ netchunk_error_t netchunk_download(
     const char* local_path,
     netchunk_stats_t* stats);
 
+/**
+ * @brief Download into an already open file descriptor
+ *
+ * Same as netchunk_download() but writes to output_fd, which must refer to
+ * a regular file opened for writing. It is resized to the file size once the
+ * manifest is loaded, left open, and not removed on failure. Descriptor
+ * downloads are not journaled and always fetch every chunk.
+ *
+ * @param context NetChunk context
+ * @param remote_name Remote file name identifier
+ * @param output_fd Writable file descriptor
+ * @param stats Optional statistics output (can be NULL)
+ * @return NETCHUNK_SUCCESS on success, error code on failure
+ */
+netchunk_error_t netchunk_download_fd(
+    netchunk_context_t* context,
+    const char* remote_name,
+    int output_fd,
+    netchunk_stats_t* stats);
+
+/**
+ * @brief Read a byte range of a stored file into memory
+ *
+ * Only the chunks overlapping [offset, offset + length) are fetched. Each
+ * is verified against its hash before any of it is returned, and recently
+ * read chunks are kept in an in-memory LRU cache of read_cache_size bytes,
+ * keyed by chunk hash. When a read starts where the previous read of the
+ * same file ended, the following chunks are prefetched in the background,
+ * the window doubling with each sequential read up to
+ * NETCHUNK_READ_AHEAD_MAX_CHUNKS. The manifests of recently read files are
+ * kept for catalog_sync_interval seconds, or until this context uploads or
+ * deletes the file. Chunks missing from memory are looked up in the local
+ * chunk cache, if enabled, before they are fetched.
+ *
+ * @param context NetChunk context
+ * @param remote_name Remote file name identifier
+ * @param offset First byte to read
+ * @param length Number of bytes to read
+ * @param buffer Output buffer of at least length bytes
+ * @param bytes_read Receives the bytes read, fewer than length only at the
+ *                   end of the file (can be NULL)
+ * @return NETCHUNK_SUCCESS on success, error code on failure
+ *
+ * @note Safe to call from several threads sharing one context.
+ */
+netchunk_error_t netchunk_read_range(
+    netchunk_context_t* context,
+    const char* remote_name,
+    uint64_t offset,
+    size_t length,
+    void* buffer,
+    size_t* bytes_read);
+
 /**
  * @brief List all files in the distributed storage system
  *
+ * Answered from the local catalog, which is synced with the servers first
+ * once it is older than catalog_sync_interval. If that sync fails, a
+ * catalog synced before is still used. Only the summary fields are
+ * filled (name, size, hash, chunk count, timestamps); chunks are NULL.
+ *
  * @param context NetChunk context
  * @param files Pointer to array of file manifests (allocated by function)
  * @param count Pointer to receive number of files found
@@ -143,6 +297,33 @@ netchunk_error_t netchunk_list_files(
     netchunk_file_manifest_t** files,
     size_t* count);
 
+/**
+ * @brief Look up one file in the local catalog
+ *
+ * Syncs the catalog under the same rules as netchunk_list_files().
+ *
+ * @param context NetChunk context
+ * @param remote_name Remote file name identifier
+ * @param summary Output summary manifest (chunks are NULL)
+ * @return NETCHUNK_SUCCESS on success, NETCHUNK_ERROR_FILE_NOT_FOUND if the
+ *         file is not stored, error code on failure
+ */
+netchunk_error_t netchunk_lookup_file(
+    netchunk_context_t* context,
+    const char* remote_name,
+    netchunk_file_manifest_t* summary);
+
+/**
+ * @brief Sync the local catalog with the servers now
+ *
+ * @param context NetChunk context
+ * @param stats Optional sync statistics output (can be NULL)
+ * @return NETCHUNK_SUCCESS on success, error code on failure
+ */
+netchunk_error_t netchunk_sync_catalog(
+    netchunk_context_t* context,
+    netchunk_catalog_sync_stats_t* stats);
+
 /**
  * @brief Free file list returned by netchunk_list_files()
  *
@@ -154,6 +335,11 @@ void netchunk_free_file_list(netchunk_file_manifest_t* files, size_t count);
 /**
  * @brief Delete a file from the distributed storage system
  *
+ * Chunk removals are batched per server and sent to all servers at once.
+ * With background_delete they are queued once the manifest is gone and
+ * sent by a worker thread, which retries failed removals; shared
+ * content-addressed chunks are always removed before this returns.
+ *
  * @param context NetChunk context
  * @param remote_name Remote file name identifier
  * @return NETCHUNK_SUCCESS on success, error code on failure
@@ -167,7 +353,9 @@ netchunk_error_t netchunk_delete(
  *
  * @param context NetChunk context
  * @param remote_name Remote file name identifier
- * @param repair If true, attempt to repair any issues found
+ * @param repair If true, attempt to repair any issues found. A chunk with
+ *               no intact replica is restored from the local chunk cache
+ *               when it holds a copy.
  * @param chunks_verified Pointer to receive number of chunks verified
  * @param chunks_repaired Pointer to receive number of chunks repaired
  * @return NETCHUNK_SUCCESS on success, error code on failure
@@ -179,9 +367,34 @@ netchunk_error_t netchunk_verify(
     uint32_t* chunks_verified,
     uint32_t* chunks_repaired);
 
+/**
+ * @brief Scrub every stored replica once, in the foreground
+ *
+ * Checks that each replica exists with the right size and, where the
+ * server supports HASH or XSHA256, that its content matches, without
+ * downloading it. Replicas verified within scrub_interval seconds are
+ * skipped, and reads are paced to scrub_bandwidth. Problems are counted,
+ * not repaired; see netchunk_verify().
+ *
+ * @param context NetChunk context
+ * @param deep Also download and hash one replica of every chunk, choosing
+ *             the replica verified longest ago
+ * @param stats Pointer to receive the pass's counters (can be NULL)
+ * @return NETCHUNK_SUCCESS on success, error code on failure
+ */
+netchunk_error_t netchunk_scrub(
+    netchunk_context_t* context,
+    bool deep,
+    netchunk_scrub_stats_t* stats);
+
 /**
  * @brief Check health of all configured servers
  *
+ * With the health monitor running this reads its last round instead of
+ * probing, and only probes if no round has run yet. Otherwise each server
+ * is probed now. Each probe also feeds the server's score; see
+ * netchunk_get_server_scores().
+ *
  * @param context NetChunk context
  * @param healthy_servers Pointer to receive number of healthy servers
  * @param total_servers Pointer to receive total number of servers
@@ -192,6 +405,63 @@ netchunk_error_t netchunk_health_check(
     uint32_t* healthy_servers,
     uint32_t* total_servers);
 
+/**
+ * @brief Get the observed performance of every configured server
+ *
+ * Scores come from the transfers and health checks this context has run:
+ * latency, throughput and error rate moving averages and the transfers in
+ * flight. Downloads, ranged reads and repairs use them to pick the
+ * replica expected to answer first.
+ *
+ * @param context NetChunk context
+ * @param scores Output array, one score per server in configuration order
+ * @param max_scores Capacity of scores
+ * @param count Pointer to receive number of scores written
+ * @return NETCHUNK_SUCCESS on success, error code on failure
+ */
+netchunk_error_t netchunk_get_server_scores(
+    netchunk_context_t* context,
+    netchunk_server_score_t* scores,
+    int max_scores,
+    int* count);
+
+/**
+ * @brief Get the hit and miss counters of the chunk caches
+ *
+ * @param context NetChunk context
+ * @param stats Output counters
+ * @return NETCHUNK_SUCCESS on success, error code on failure
+ */
+netchunk_error_t netchunk_get_cache_stats(
+    netchunk_context_t* context,
+    netchunk_cache_stats_t* stats);
+
+/**
+ * @brief Get the phase timings and counters collected so far
+ *
+ * Collection is enabled by performance_logging. The same values are
+ * written to monitoring_data_path at most every
+ * NETCHUNK_METRICS_DUMP_INTERVAL seconds after an operation and when the
+ * context is cleaned up.
+ *
+ * @param context NetChunk context
+ * @param snapshot Output values
+ * @return NETCHUNK_SUCCESS on success, NETCHUNK_ERROR_CONFIG if
+ *         performance_logging is off, error code on failure
+ */
+netchunk_error_t netchunk_get_metrics(
+    netchunk_context_t* context,
+    netchunk_metrics_snapshot_t* snapshot);
+
+/**
+ * @brief Write the collected metrics to monitoring_data_path now
+ *
+ * @param context NetChunk context
+ * @return NETCHUNK_SUCCESS on success, NETCHUNK_ERROR_CONFIG if
+ *         performance_logging is off, error code on failure
+ */
+netchunk_error_t netchunk_dump_metrics(netchunk_context_t* context);
+
 /**
  * @brief Get version information
  *
@@ -0,0 +1,109 @@
+#ifndef NETCHUNK_PLACEMENT_H
+#define NETCHUNK_PLACEMENT_H
+
+#include "config.h"
+#include "health_monitor.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Forward declarations
+typedef struct netchunk_placement netchunk_placement_t;
+
+// Placement constants
+#define NETCHUNK_PLACEMENT_DEGRADED_WEIGHT 0.25 // Weight factor of servers the health monitor found degraded
+#define NETCHUNK_PLACEMENT_CAPACITY_STEPS 2 // Free space buckets per doubling
+#define NETCHUNK_PLACEMENT_CAPACITY_HYSTERESIS 0.25 // Steps past a bucket edge before a server changes bucket
+
+/**
+ * @brief Weighted rendezvous placement of chunks on the configured servers
+ *
+ * Every server scores every chunk ID with a hash of the two, scaled by
+ * the server's weight; a chunk's replicas go to the highest scores. The
+ * ranking of a chunk depends only on its ID and on the servers' IDs and
+ * weights, so reordering the configuration moves nothing, and adding a
+ * server takes over only the chunks it now outscores the others on,
+ * about its share of the total weight. A server's chance of holding a
+ * given replica is proportional to its weight.
+ *
+ * Weights come from the health snapshot when there is one: free space
+ * relative to the other servers that reported it (servers that did not
+ * count as average), divided by the priority when above 1, and cut to
+ * NETCHUNK_PLACEMENT_DEGRADED_WEIGHT for degraded servers. Free space is
+ * rounded to NETCHUNK_PLACEMENT_CAPACITY_STEPS buckets per doubling, and
+ * a server keeps the bucket recorded in the snapshot until its free space
+ * is NETCHUNK_PLACEMENT_CAPACITY_HYSTERESIS steps past the edge, so its
+ * weight changes with real growth or shrinkage, not with the drift
+ * between probes. Servers found unavailable keep their weight but rank
+ * after every usable one.
+ */
+typedef struct netchunk_placement {
+    int server_count;
+    double weights[NETCHUNK_MAX_SERVERS]; // Indexed like config->servers
+    uint64_t seeds[NETCHUNK_MAX_SERVERS]; // Hash of each server's ID
+    bool usable[NETCHUNK_MAX_SERVERS]; // Not found unavailable
+    uint64_t generation; // Generation of the snapshot the weights come from, 0 if none
+} netchunk_placement_t;
+
+/**
+ * @brief Weigh the configured servers
+ * @param placement Placement to initialize
+ * @param config Configuration holding the servers and their priorities
+ * @param health Health snapshot, or NULL to weigh by priority alone
+ * @return NETCHUNK_SUCCESS on success, error code on failure
+ */
+netchunk_error_t netchunk_placement_init(netchunk_placement_t* placement,
+    const netchunk_config_t* config,
+    const netchunk_health_snapshot_t* health);
+
+/**
+ * @brief Free space bucket of a server, with hysteresis
+ *
+ * NETCHUNK_PLACEMENT_CAPACITY_STEPS buckets per doubling of free space.
+ * The previous bucket is kept while free space stays within
+ * NETCHUNK_PLACEMENT_CAPACITY_HYSTERESIS steps of its edges.
+ *
+ * @param bytes_available Free space, 0 if unknown
+ * @param previous_step Bucket the server had so far, 0 if none
+ * @return Bucket, 0 if free space is unknown
+ */
+int netchunk_placement_capacity_step(uint64_t bytes_available, int previous_step);
+
+/**
+ * @brief Rank the servers for a chunk, best first
+ *
+ * Usable servers come before unusable ones; the first n entries are the
+ * servers a chunk with n replicas belongs on, all distinct.
+ *
+ * @param placement Initialized placement
+ * @param chunk_id Chunk ID
+ * @param servers Output server indices
+ * @param max_servers Capacity of servers
+ * @return Number of indices written, at most the number of servers
+ */
+int netchunk_placement_rank(const netchunk_placement_t* placement,
+    const char* chunk_id,
+    int* servers,
+    int max_servers);
+
+/**
+ * @brief Score of one server for a chunk, higher is better
+ *
+ * Ignores usability; netchunk_placement_rank() orders by this within the
+ * usable and the unusable servers.
+ *
+ * @param placement Initialized placement
+ * @param chunk_id Chunk ID
+ * @param server_index Index into config->servers
+ * @return Score, 0 for an index out of range
+ */
+double netchunk_placement_score(const netchunk_placement_t* placement, const char* chunk_id, int server_index);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NETCHUNK_PLACEMENT_H
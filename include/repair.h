@@ -12,6 +12,7 @@
 
 #include "config.h"
 #include "crypto.h"
+#include "disk_cache.h"
 #include "ftp_client.h"
 #include "manifest.h"
 
@@ -19,6 +20,9 @@
 extern "C" {
 #endif
 
+// Forward declarations
+typedef struct netchunk_repair_throttle netchunk_repair_throttle_t;
+
 /**
  * @brief Repair operation types
  */
@@ -38,6 +42,30 @@ typedef enum {
     NETCHUNK_CHUNK_LOST = 3 // No valid replicas found
 } netchunk_chunk_health_t;
 
+/**
+ * @brief How thoroughly replicas are checked
+ *
+ * Every level first asks each server for the size of its copy, and for a
+ * server-side hash where the server supports HASH or XSHA256; only the
+ * downloads differ.
+ */
+typedef enum {
+    NETCHUNK_VERIFY_FAST = 0, // No downloads
+    NETCHUNK_VERIFY_DEEP = 1, // Download the replica verified longest ago
+    NETCHUNK_VERIFY_FULL = 2 // Download every replica not hashed remotely
+} netchunk_verify_level_t;
+
+/**
+ * @brief Outcome of checking one replica
+ */
+typedef enum {
+    NETCHUNK_REPLICA_PRESENT = 0, // Stored with the right size, content not checked
+    NETCHUNK_REPLICA_VERIFIED = 1, // Content matches the chunk hash
+    NETCHUNK_REPLICA_MISSING = 2, // Not on its server, or the server is not configured
+    NETCHUNK_REPLICA_CORRUPT = 3, // Wrong size or content
+    NETCHUNK_REPLICA_UNREACHABLE = 4 // Server could not be asked
+} netchunk_replica_status_t;
+
 /**
  * @brief Repair statistics
  */
@@ -73,9 +101,12 @@ typedef void (*netchunk_repair_progress_callback_t)(
 typedef struct {
     netchunk_config_t* config; // Configuration
     netchunk_ftp_context_t* ftp_context; // FTP client context
+    netchunk_disk_cache_t* chunk_cache; // Local chunk cache tried before the replicas (can be NULL)
     netchunk_repair_progress_callback_t progress_cb; // Progress callback
     void* progress_userdata; // Progress callback data
     netchunk_repair_mode_t repair_mode; // Current repair mode
+    netchunk_verify_level_t verify_level; // Used by netchunk_repair_check_chunk_health()
+    netchunk_repair_throttle_t* throttle; // Limits requests per server (NULL = unlimited)
     bool initialized; // Initialization flag
 } netchunk_repair_context_t;
 
@@ -105,6 +136,28 @@ netchunk_error_t netchunk_repair_set_progress_callback(
     netchunk_repair_progress_callback_t callback,
     void* userdata);
 
+/**
+ * @brief Let repairs take chunk data from a local chunk cache
+ *
+ * @param context Repair context
+ * @param chunk_cache Cache to read before fetching from a replica (NULL to stop)
+ * @return NETCHUNK_SUCCESS on success, error code on failure
+ */
+netchunk_error_t netchunk_repair_set_chunk_cache(
+    netchunk_repair_context_t* context,
+    netchunk_disk_cache_t* chunk_cache);
+
+/**
+ * @brief Choose how health checks verify replicas
+ *
+ * @param context Repair context
+ * @param level Verification level (NETCHUNK_VERIFY_DEEP by default)
+ * @return NETCHUNK_SUCCESS on success, error code on failure
+ */
+netchunk_error_t netchunk_repair_set_verify_level(
+    netchunk_repair_context_t* context,
+    netchunk_verify_level_t level);
+
 /**
  * @brief Verify and repair a single file
  *
@@ -123,6 +176,10 @@ netchunk_error_t netchunk_repair_file(
 /**
  * @brief Verify and repair all files in the system
  *
+ * Runs the repair scheduler over every manifest, so the most endangered
+ * chunks of all files are repaired first and several chunks are worked on
+ * at once.
+ *
  * @param context Repair context
  * @param repair_mode Repair mode (verify only, auto repair, force)
  * @param stats Output repair statistics (can be NULL)
@@ -133,9 +190,50 @@ netchunk_error_t netchunk_repair_all_files(
     netchunk_repair_mode_t repair_mode,
     netchunk_repair_stats_t* stats);
 
+/**
+ * @brief Check one replica of a chunk
+ *
+ * Asks the server for the size of its copy, then for a server-side hash
+ * where supported, and downloads the copy only if download is set and the
+ * server could not hash it. A verified replica has its location marked
+ * verified at the current time; a missing or corrupt one is marked
+ * unverified.
+ *
+ * @param context Repair context
+ * @param chunk Chunk whose replica to check
+ * @param location_index Index into chunk->locations
+ * @param download Whether to download a replica the server cannot hash
+ * @param status Output replica status
+ * @param bytes_downloaded Incremented by the bytes downloaded (can be NULL)
+ * @return NETCHUNK_SUCCESS on success, error code on failure
+ */
+netchunk_error_t netchunk_repair_check_replica(
+    netchunk_repair_context_t* context,
+    netchunk_chunk_t* chunk,
+    int location_index,
+    bool download,
+    netchunk_replica_status_t* status,
+    uint64_t* bytes_downloaded);
+
+/**
+ * @brief Pick the replica a deep check should download
+ *
+ * The replica found present whose content was verified longest ago;
+ * replicas never verified come first, ties go to the first listed.
+ *
+ * @param chunk Chunk whose replicas were checked
+ * @param statuses Status of each of chunk->locations
+ * @return Location index, or -1 if no replica is present unverified
+ */
+int netchunk_repair_select_sample(const netchunk_chunk_t* chunk,
+    const netchunk_replica_status_t* statuses);
+
 /**
  * @brief Check health of a single chunk
  *
+ * Replicas are checked at the context's verification level. Replicas
+ * found present but not downloaded count as healthy.
+ *
  * @param context Repair context
  * @param chunk Chunk to check
  * @param health Output chunk health status
@@ -151,6 +249,10 @@ netchunk_error_t netchunk_repair_check_chunk_health(
 /**
  * @brief Repair a single chunk by recreating missing replicas
  *
+ * New replicas are copied directly from an existing one when both servers
+ * are marked fxp, and verified afterwards. Otherwise the chunk is
+ * downloaded once and uploaded to each new server.
+ *
  * @param context Repair context
  * @param chunk Chunk to repair
  * @param target_replication Target replication factor
@@ -163,6 +265,50 @@ netchunk_error_t netchunk_repair_chunk(
     int target_replication,
     int* replicas_added);
 
+/**
+ * @brief Check health of a stripe of an erasure-coded file
+ *
+ * Each shard is checked like a chunk; a shard without a healthy replica
+ * is lost. The stripe is degraded while it can lose more shards, critical
+ * when losing one more would make it unrecoverable, and lost when it
+ * already is.
+ *
+ * @param context Repair context
+ * @param manifest Erasure-coded manifest
+ * @param stripe Stripe index
+ * @param health Output stripe health status
+ * @param healthy_shards Output number of shards still readable
+ * @return NETCHUNK_SUCCESS on success, error code on failure
+ */
+netchunk_error_t netchunk_repair_check_stripe_health(
+    netchunk_repair_context_t* context,
+    netchunk_file_manifest_t* manifest,
+    uint32_t stripe,
+    netchunk_chunk_health_t* health,
+    int* healthy_shards);
+
+/**
+ * @brief Repair a stripe of an erasure-coded file by rebuilding lost shards
+ *
+ * Lost shards have their bad replicas removed and are decoded from enough
+ * good shards of the stripe, then uploaded to servers holding no other
+ * shard of it where possible.
+ *
+ * @param context Repair context
+ * @param manifest Erasure-coded manifest, updated with the new locations
+ * @param stripe Stripe index
+ * @param shards_rebuilt Output number of shards rebuilt
+ * @param replicas_removed Output number of bad replicas removed
+ * @return NETCHUNK_SUCCESS on success, NETCHUNK_ERROR_CHUNK_INTEGRITY if
+ *         too many shards are lost, error code on failure
+ */
+netchunk_error_t netchunk_repair_stripe(
+    netchunk_repair_context_t* context,
+    netchunk_file_manifest_t* manifest,
+    uint32_t stripe,
+    int* shards_rebuilt,
+    int* replicas_removed);
+
 /**
  * @brief Remove corrupted replicas of a chunk
  *
@@ -179,12 +325,18 @@ netchunk_error_t netchunk_repair_cleanup_chunk(
 /**
  * @brief Rebalance chunk distribution across servers
  *
- * This function attempts to evenly distribute chunks across all available
- * servers to improve performance and reliability.
+ * Moves replicas that sit outside their chunk's placement (see
+ * placement.h) onto the placed servers that lack one, so only chunks
+ * whose placement changed are touched: after adding a server, about the
+ * new server's share of them. A replica is added and verified before the
+ * misplaced one is deleted, directly between servers marked fxp where
+ * possible. Chunks short of replicas are left to repair, and
+ * erasure-coded manifests are left as they are. The caller stores the
+ * updated manifest.
  *
  * @param context Repair context
  * @param manifest File manifest to rebalance
- * @param moves_performed Output number of chunks moved
+ * @param moves_performed Output number of replicas moved
  * @return NETCHUNK_SUCCESS on success, error code on failure
  */
 netchunk_error_t netchunk_repair_rebalance_chunks(
@@ -0,0 +1,187 @@
+/**
+ * @file repair_scheduler.h
+ * @brief NetChunk repair scheduler
+ *
+ * Parallel, prioritized verification and repair of many chunks. Chunks
+ * wait in a priority queue by health so lost and critical chunks are
+ * handled before degraded ones and before the remaining chunks are
+ * checked, and a throttle keeps repair traffic within per-server caps.
+ */
+
+#ifndef NETCHUNK_REPAIR_SCHEDULER_H
+#define NETCHUNK_REPAIR_SCHEDULER_H
+
+#include "config.h"
+#include "manifest.h"
+#include "repair.h"
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Forward declarations
+typedef struct netchunk_repair_task netchunk_repair_task_t;
+typedef struct netchunk_repair_queue netchunk_repair_queue_t;
+typedef struct netchunk_repair_throttle netchunk_repair_throttle_t;
+
+// Repair scheduler constants
+#define NETCHUNK_REPAIR_QUEUE_INITIAL_CAPACITY 64
+
+/**
+ * @brief One chunk waiting for repair
+ */
+typedef struct netchunk_repair_task {
+    uint32_t file_index; // Index into the manifests being repaired
+    uint32_t chunk_index; // Index into the manifest's chunks, or its stripes if erasure-coded
+    netchunk_chunk_health_t health; // Higher values are repaired first
+    bool checked; // Health comes from a check, not only from the manifest
+    uint64_t sequence; // Arrival order, breaks ties between equal health
+} netchunk_repair_task_t;
+
+/**
+ * @brief Priority queue of repair tasks, worst health first
+ *
+ * A binary heap; tasks of equal health come out in the order they were
+ * pushed. Not thread-safe.
+ */
+typedef struct netchunk_repair_queue {
+    netchunk_repair_task_t* tasks;
+    size_t count;
+    size_t capacity;
+    uint64_t next_sequence;
+} netchunk_repair_queue_t;
+
+/**
+ * @brief Per-server limits on repair requests
+ *
+ * Caps the requests in flight to each server and paces the bytes moved to
+ * or from it. A request waits for a free slot and then for its share of
+ * the server's bandwidth, so repair traffic leaves room for client
+ * transfers on the same servers. Thread-safe.
+ */
+typedef struct netchunk_repair_throttle {
+    pthread_mutex_t mutex;
+    pthread_cond_t slot_free; // Signalled when a request to any server completes
+    int max_per_server; // Requests in flight per server
+    uint64_t bandwidth; // Bytes per second per server, 0 = unlimited
+    int active[NETCHUNK_MAX_SERVERS]; // Requests in flight per server
+    double next_free_ms[NETCHUNK_MAX_SERVERS]; // End of the bandwidth already reserved per server
+} netchunk_repair_throttle_t;
+
+/**
+ * @brief Initialize an empty repair queue
+ * @param queue Queue to initialize
+ */
+void netchunk_repair_queue_init(netchunk_repair_queue_t* queue);
+
+/**
+ * @brief Add a chunk to a repair queue
+ * @param queue Initialized queue
+ * @param file_index Index of the chunk's manifest
+ * @param chunk_index Index of the chunk in its manifest
+ * @param health Known or suspected health of the chunk
+ * @param checked Whether health comes from checking the replicas
+ * @return NETCHUNK_SUCCESS on success, error code on failure
+ */
+netchunk_error_t netchunk_repair_queue_push(netchunk_repair_queue_t* queue,
+    uint32_t file_index,
+    uint32_t chunk_index,
+    netchunk_chunk_health_t health,
+    bool checked);
+
+/**
+ * @brief Take the most urgent task from a repair queue
+ * @param queue Initialized queue
+ * @param task Output task
+ * @return true if a task was taken, false if the queue is empty
+ */
+bool netchunk_repair_queue_pop(netchunk_repair_queue_t* queue, netchunk_repair_task_t* task);
+
+/**
+ * @brief Free a repair queue
+ * @param queue Queue to clean up
+ */
+void netchunk_repair_queue_cleanup(netchunk_repair_queue_t* queue);
+
+/**
+ * @brief Initialize a repair throttle
+ * @param throttle Throttle to initialize
+ * @param max_per_server Requests in flight per server (at least 1)
+ * @param bandwidth Bytes per second per server (0 = unlimited)
+ * @return NETCHUNK_SUCCESS on success, error code on failure
+ */
+netchunk_error_t netchunk_repair_throttle_init(netchunk_repair_throttle_t* throttle,
+    int max_per_server,
+    uint64_t bandwidth);
+
+/**
+ * @brief Wait until a request to a server may start
+ *
+ * Blocks for a free slot on the server, then sleeps off whatever the
+ * bandwidth reserved by earlier requests requires. Every acquire must be
+ * followed by netchunk_repair_throttle_release() for the same server.
+ *
+ * @param throttle Initialized throttle
+ * @param server_index Index into config->servers
+ * @param bytes Bytes the request will transfer (0 for metadata requests)
+ */
+void netchunk_repair_throttle_acquire(netchunk_repair_throttle_t* throttle, int server_index, uint64_t bytes);
+
+/**
+ * @brief Mark a request to a server as finished
+ * @param throttle Initialized throttle
+ * @param server_index Index into config->servers
+ */
+void netchunk_repair_throttle_release(netchunk_repair_throttle_t* throttle, int server_index);
+
+/**
+ * @brief Reserve bandwidth on a server without waiting
+ *
+ * @param throttle Initialized throttle
+ * @param server_index Index into config->servers
+ * @param bytes Bytes to reserve
+ * @param now_ms Current monotonic time in milliseconds
+ * @return Milliseconds until the reservation starts
+ */
+int netchunk_repair_throttle_reserve(netchunk_repair_throttle_t* throttle,
+    int server_index,
+    uint64_t bytes,
+    double now_ms);
+
+/**
+ * @brief Destroy a repair throttle
+ * @param throttle Throttle to clean up
+ */
+void netchunk_repair_throttle_cleanup(netchunk_repair_throttle_t* throttle);
+
+/**
+ * @brief Verify and repair the chunks of several files in parallel
+ *
+ * Chunks the manifests already record as under-replicated are queued by
+ * that health and handled first; the others are checked by
+ * config->repair_workers threads, and any found unhealthy are queued ahead
+ * of the chunks still unchecked. Requests go through a throttle built from
+ * config->repair_max_per_server and config->repair_bandwidth. Manifests
+ * whose chunk locations changed are uploaded at the end.
+ *
+ * @param context Repair context, its progress callback reports chunks done
+ * @param manifests Manifests to repair, updated in place
+ * @param manifest_count Number of manifests
+ * @param repair_mode Repair mode (verify only, auto repair, force)
+ * @param stats Output repair statistics (can be NULL)
+ * @return NETCHUNK_SUCCESS on success, error code on failure
+ */
+netchunk_error_t netchunk_repair_schedule(netchunk_repair_context_t* context,
+    netchunk_file_manifest_t* manifests,
+    size_t manifest_count,
+    netchunk_repair_mode_t repair_mode,
+    netchunk_repair_stats_t* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NETCHUNK_REPAIR_SCHEDULER_H */
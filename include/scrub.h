@@ -0,0 +1,156 @@
+#ifndef NETCHUNK_SCRUB_H
+#define NETCHUNK_SCRUB_H
+
+#include "config.h"
+#include "ftp_client.h"
+#include "manifest.h"
+#include "repair.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Forward declarations
+typedef struct netchunk_scrub_stats netchunk_scrub_stats_t;
+typedef struct netchunk_scrubber netchunk_scrubber_t;
+
+// Scrub constants
+#define NETCHUNK_SCRUB_REQUEST_COST 4096 // Bytes a remote check is charged against the bandwidth budget
+#define NETCHUNK_SCRUB_SAVE_INTERVAL 1024 // Chunks re-verified between manifest saves
+#define NETCHUNK_SCRUB_RETRY_DELAY 60 // Seconds before a pass that could not list files is retried
+
+/**
+ * @brief Counters of a scrubber, cumulative over its passes
+ */
+typedef struct netchunk_scrub_stats {
+    uint32_t passes_completed;
+    uint32_t files_scrubbed;
+    uint64_t chunks_scrubbed;
+    uint64_t replicas_checked; // Replicas that were due and got checked
+    uint64_t replicas_verified; // Of which content matched, hashed remotely or downloaded
+    uint64_t replicas_present; // Of which only existence and size were confirmed
+    uint64_t replicas_missing;
+    uint64_t replicas_corrupt;
+    uint64_t replicas_unreachable;
+    uint64_t replicas_skipped; // Verified recently enough not to be checked again
+    uint64_t bytes_downloaded; // Replica data downloaded by deep checks
+} netchunk_scrub_stats_t;
+
+/**
+ * @brief Incremental verifier of every stored replica
+ *
+ * Walks all manifests one chunk per step so it can run between other work.
+ * Each replica is checked like netchunk_repair_check_replica() does:
+ * existence and size, a server-side hash where the server supports one,
+ * and in deep mode one download per chunk, rotating through its replicas
+ * by verification time. Replicas verified less than interval seconds ago
+ * are skipped, so an interrupted pass never repeats work. Verification
+ * times are written back into the manifests, but only when a manifest did
+ * not change on the servers in the meantime.
+ *
+ * The scrubber only finds problems; repairing them is left to
+ * netchunk_verify() and the repair engine. Not thread-safe.
+ */
+typedef struct netchunk_scrubber {
+    netchunk_repair_context_t repair; // Performs the replica checks
+    netchunk_config_t* config;
+    netchunk_ftp_context_t* ftp_context;
+    bool deep; // Download a sample of the replicas
+    int interval; // Seconds a verification stays valid, and between pass starts
+    uint64_t bandwidth; // Bytes per second steps are paced to, 0 = unlimited
+
+    // Current pass
+    bool pass_active;
+    time_t pass_started;
+    time_t next_pass; // Earliest start of the next pass
+    netchunk_ftp_manifest_entry_t* files; // Manifests listed at the start of the pass
+    size_t file_count;
+    size_t file_index; // Next file to load
+
+    // Current file
+    netchunk_file_manifest_t manifest;
+    bool manifest_loaded;
+    uint32_t chunk_index; // Next chunk to scrub
+    uint32_t chunks_changed; // Chunks with updated locations not saved yet
+
+    netchunk_scrub_stats_t stats;
+} netchunk_scrubber_t;
+
+/**
+ * @brief Initialize a scrubber; the first pass may start right away
+ *
+ * The interval and bandwidth come from config->scrub_interval and
+ * config->scrub_bandwidth.
+ *
+ * @param scrubber Scrubber to initialize
+ * @param config NetChunk configuration
+ * @param ftp_context FTP client context
+ * @param deep Whether to download a rotating sample of the replicas
+ * @return NETCHUNK_SUCCESS on success, error code on failure
+ */
+netchunk_error_t netchunk_scrubber_init(netchunk_scrubber_t* scrubber,
+    netchunk_config_t* config,
+    netchunk_ftp_context_t* ftp_context,
+    bool deep);
+
+/**
+ * @brief Do the next piece of scrubbing work
+ *
+ * Scrubs one chunk, loads or saves a manifest, or starts or finishes a
+ * pass. delay_ms tells the caller when to call again: long enough to keep
+ * the data read within the bandwidth budget, or until the next pass is due.
+ *
+ * @param scrubber Initialized scrubber
+ * @param delay_ms Output milliseconds to wait before the next step
+ * @return NETCHUNK_SUCCESS on success, error code if a pass could not start
+ */
+netchunk_error_t netchunk_scrubber_step(netchunk_scrubber_t* scrubber, int* delay_ms);
+
+/**
+ * @brief Run a whole pass now, pacing it to the bandwidth budget
+ *
+ * A pass already in progress is continued rather than restarted.
+ *
+ * @param scrubber Initialized scrubber
+ * @return NETCHUNK_SUCCESS on success, error code on failure
+ */
+netchunk_error_t netchunk_scrubber_run_pass(netchunk_scrubber_t* scrubber);
+
+/**
+ * @brief Copy a scrubber's counters
+ * @param scrubber Initialized scrubber
+ * @param stats Output counters
+ */
+void netchunk_scrubber_get_stats(const netchunk_scrubber_t* scrubber, netchunk_scrub_stats_t* stats);
+
+/**
+ * @brief Save pending verification times and release the scrubber
+ * @param scrubber Scrubber to clean up
+ */
+void netchunk_scrubber_cleanup(netchunk_scrubber_t* scrubber);
+
+/**
+ * @brief Whether a replica needs checking
+ * @param location Replica location
+ * @param now Current time
+ * @param interval Seconds a verification stays valid (0 = always check)
+ * @return true unless the replica was verified less than interval seconds ago
+ */
+bool netchunk_scrub_replica_due(const netchunk_chunk_location_t* location, time_t now, int interval);
+
+/**
+ * @brief Time a step must be followed by to stay within a bandwidth budget
+ * @param cost_bytes Bytes the step read, or was charged for
+ * @param bandwidth Bytes per second (0 = unlimited)
+ * @return Delay in milliseconds
+ */
+int netchunk_scrub_delay_ms(uint64_t cost_bytes, uint64_t bandwidth);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NETCHUNK_SCRUB_H
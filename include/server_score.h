@@ -0,0 +1,210 @@
+#ifndef NETCHUNK_SERVER_SCORE_H
+#define NETCHUNK_SERVER_SCORE_H
+
+#include "config.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Forward declarations
+typedef struct netchunk_server_score netchunk_server_score_t;
+typedef struct netchunk_score_history netchunk_score_history_t;
+typedef struct netchunk_scoreboard netchunk_scoreboard_t;
+
+// Scoring constants
+#define NETCHUNK_SCORE_EWMA_ALPHA 0.2 // Weight of the newest sample
+#define NETCHUNK_SCORE_MIN_THROUGHPUT_BYTES (64 * 1024) // Smaller transfers only update latency
+#define NETCHUNK_SCORE_MAX_ERROR_RATE 0.95 // Keeps the error penalty finite
+#define NETCHUNK_SCORE_FAILURE_THRESHOLD 3 // Consecutive failures before a server is unhealthy
+#define NETCHUNK_SCORE_RETRY_INTERVAL_MS 30000 // Unhealthy servers are tried again after this
+#define NETCHUNK_SCORE_HISTORY 64 // Transfer durations kept per server for the p95
+#define NETCHUNK_SCORE_MIN_HISTORY 10 // Durations needed before a p95 is reported
+
+/**
+ * @brief Observed performance of one server
+ *
+ * Latency is the time to the first byte of a transfer, connection setup
+ * included. Throughput is the server's aggregate rate: the rate of one
+ * transfer times the transfers it was sharing the server with.
+ */
+typedef struct netchunk_server_score {
+    double latency_ms; // EWMA of time to first byte
+    double throughput_bps; // EWMA of aggregate bytes per second, 0 if unmeasured
+    double error_rate; // EWMA of failed attempts, 0 to 1
+    int in_flight; // Transfers currently running on the server
+    uint64_t samples; // Attempts and probes observed
+    uint64_t successes; // Of which succeeded
+    uint32_t consecutive_failures;
+    double last_failure_ms; // Time of the latest failure, 0 if none
+    double p95_ms; // 95th percentile of recent transfer durations, 0 until known
+    bool healthy; // Filled in by netchunk_scoreboard_get()
+} netchunk_server_score_t;
+
+/**
+ * @brief Ring of a server's most recent transfer durations
+ */
+typedef struct netchunk_score_history {
+    double durations_ms[NETCHUNK_SCORE_HISTORY];
+    int count; // Durations recorded, at most NETCHUNK_SCORE_HISTORY
+    int next; // Slot the next duration overwrites
+} netchunk_score_history_t;
+
+/**
+ * @brief Scores of every configured server
+ *
+ * Does no locking of its own; callers serialize access. Times are
+ * milliseconds on any clock, as long as the caller uses the same one.
+ */
+typedef struct netchunk_scoreboard {
+    netchunk_server_score_t servers[NETCHUNK_MAX_SERVERS];
+    netchunk_score_history_t history[NETCHUNK_MAX_SERVERS]; // Behind each p95_ms
+    int server_count;
+} netchunk_scoreboard_t;
+
+/**
+ * @brief Initialize a scoreboard with no samples
+ * @param board Scoreboard to initialize
+ * @param server_count Number of servers
+ */
+void netchunk_scoreboard_init(netchunk_scoreboard_t* board, int server_count);
+
+/**
+ * @brief Count a transfer starting on a server
+ * @param board Scoreboard to update
+ * @param server_index Server index
+ */
+void netchunk_scoreboard_begin(netchunk_scoreboard_t* board, int server_index);
+
+/**
+ * @brief Record a transfer started with netchunk_scoreboard_begin() that succeeded
+ *
+ * Transfers of at least NETCHUNK_SCORE_MIN_THROUGHPUT_BYTES also update the
+ * throughput and the duration history behind p95_ms.
+ *
+ * @param board Scoreboard to update
+ * @param server_index Server index
+ * @param latency_ms Time to first byte
+ * @param bytes Payload bytes transferred
+ * @param transfer_ms Time spent moving the payload after the first byte
+ */
+void netchunk_scoreboard_record_success(netchunk_scoreboard_t* board,
+    int server_index,
+    double latency_ms,
+    uint64_t bytes,
+    double transfer_ms);
+
+/**
+ * @brief Record a transfer started with netchunk_scoreboard_begin() that failed
+ * @param board Scoreboard to update
+ * @param server_index Server index
+ * @param now_ms Current time
+ */
+void netchunk_scoreboard_record_failure(netchunk_scoreboard_t* board, int server_index, double now_ms);
+
+/**
+ * @brief Record a transfer started with netchunk_scoreboard_begin() that was abandoned
+ *
+ * Used when another replica delivered the data first. The transfer would
+ * have taken at least elapsed_ms, so once the server has latency samples
+ * that time is folded into its latency when it is longer; a server that
+ * keeps losing races gets ranked down rather than staying first.
+ *
+ * @param board Scoreboard to update
+ * @param server_index Server index
+ * @param elapsed_ms Time the transfer had been running
+ */
+void netchunk_scoreboard_cancel(netchunk_scoreboard_t* board, int server_index, double elapsed_ms);
+
+/**
+ * @brief Record a connectivity probe, e.g. from a health check
+ * @param board Scoreboard to update
+ * @param server_index Server index
+ * @param success Whether the server answered
+ * @param latency_ms Time the probe took, if it succeeded
+ * @param now_ms Current time
+ */
+void netchunk_scoreboard_record_probe(netchunk_scoreboard_t* board,
+    int server_index,
+    bool success,
+    double latency_ms,
+    double now_ms);
+
+/**
+ * @brief Whether a server should be preferred over failing ones
+ *
+ * A server is unhealthy after NETCHUNK_SCORE_FAILURE_THRESHOLD failures in
+ * a row, until NETCHUNK_SCORE_RETRY_INTERVAL_MS have passed since the last
+ * one; then it gets a chance to prove itself again.
+ *
+ * @param score Server score
+ * @param now_ms Current time
+ * @return true if the server is healthy
+ */
+bool netchunk_server_score_healthy(const netchunk_server_score_t* score, double now_ms);
+
+/**
+ * @brief Expected time to fetch a chunk from a server right now
+ *
+ * Latency plus the chunk's share of the server's throughput given the
+ * transfers already running there, divided by the chance an attempt
+ * succeeds. Servers without samples cost nothing, so they get measured;
+ * servers that have only ever failed cost HUGE_VAL.
+ *
+ * @param score Server score
+ * @param size Chunk size in bytes
+ * @return Expected milliseconds
+ */
+double netchunk_server_score_cost(const netchunk_server_score_t* score, size_t size);
+
+/**
+ * @brief Order servers holding the same data, best first
+ *
+ * Healthy servers come first, each group by expected cost. The sort is
+ * stable, so the caller's order breaks ties.
+ *
+ * @param board Scoreboard to consult
+ * @param server_indices Servers to order in place
+ * @param count Number of servers
+ * @param size Chunk size in bytes
+ * @param now_ms Current time
+ */
+void netchunk_scoreboard_rank(const netchunk_scoreboard_t* board,
+    int* server_indices,
+    int count,
+    size_t size,
+    double now_ms);
+
+/**
+ * @brief Time after which a transfer from a server is unusually slow
+ *
+ * The 95th percentile of the server's recent transfer durations, once
+ * NETCHUNK_SCORE_MIN_HISTORY of them have been recorded.
+ *
+ * @param board Scoreboard to consult
+ * @param server_index Server index
+ * @return Milliseconds, or 0 if not enough transfers have been observed
+ */
+double netchunk_scoreboard_p95(const netchunk_scoreboard_t* board, int server_index);
+
+/**
+ * @brief Copy a server's score, with its health evaluated
+ * @param board Scoreboard to read
+ * @param server_index Server index
+ * @param now_ms Current time
+ * @param score Output score
+ * @return NETCHUNK_SUCCESS on success, error code on failure
+ */
+netchunk_error_t netchunk_scoreboard_get(const netchunk_scoreboard_t* board,
+    int server_index,
+    double now_ms,
+    netchunk_server_score_t* score);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NETCHUNK_SERVER_SCORE_H
@@ -0,0 +1,586 @@
+/**
+ * @file catalog.c
+ * @brief Local catalog of stored files
+ *
+ * Keeps name, size, hash, chunk count and timestamps of every stored file
+ * so listings and lookups never download manifests. Synchronization
+ * compares each server's manifest directory listing against the sizes and
+ * modification times recorded here and only fetches what changed.
+ */
+
+#include "catalog.h"
+#include "crypto.h"
+#include "manifest_pack.h"
+#include <cjson/cJSON.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define CATALOG_TEMP_SUFFIX ".tmp"
+#define CATALOG_INITIAL_CAPACITY 64
+#define CATALOG_FETCH_BATCH 64 // Manifest downloads in flight during a sync
+
+// Completion state of one batch of manifest downloads
+typedef struct catalog_fetch_batch {
+    pthread_mutex_t mutex;
+    pthread_cond_t done_cond;
+    size_t remaining;
+} catalog_fetch_batch_t;
+
+// Internal helper functions
+static size_t catalog_position(const netchunk_catalog_t* catalog, const char* name, bool* found);
+static netchunk_catalog_entry_t* catalog_insert(netchunk_catalog_t* catalog, const char* name);
+static const netchunk_ftp_manifest_entry_t* find_remote_entry(const netchunk_ftp_manifest_entry_t* entries,
+    size_t count, const char* name);
+static netchunk_error_t ensure_parent_directory(const char* file_path);
+static void fetch_complete(netchunk_ftp_transfer_t* transfer, void* userdata);
+static netchunk_error_t fetch_manifests(netchunk_catalog_t* catalog,
+    netchunk_ftp_context_t* ftp_context,
+    const netchunk_ftp_manifest_entry_t* remote,
+    const size_t* pending,
+    size_t pending_count,
+    netchunk_catalog_sync_stats_t* stats);
+
+netchunk_error_t netchunk_catalog_init(netchunk_catalog_t* catalog, const char* path)
+{
+    if (!catalog || !path) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    memset(catalog, 0, sizeof(netchunk_catalog_t));
+
+    netchunk_error_t error = netchunk_config_expand_path(path, catalog->path, sizeof(catalog->path));
+    if (error != NETCHUNK_SUCCESS) {
+        return error;
+    }
+
+    catalog->entries = calloc(CATALOG_INITIAL_CAPACITY, sizeof(netchunk_catalog_entry_t));
+    if (!catalog->entries) {
+        return NETCHUNK_ERROR_OUT_OF_MEMORY;
+    }
+    catalog->capacity = CATALOG_INITIAL_CAPACITY;
+
+    return NETCHUNK_SUCCESS;
+}
+
+netchunk_error_t netchunk_catalog_load(netchunk_catalog_t* catalog)
+{
+    if (!catalog || !catalog->entries) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    FILE* file = fopen(catalog->path, "r");
+    if (!file) {
+        // No catalog yet: the first sync builds it
+        return errno == ENOENT ? NETCHUNK_SUCCESS : NETCHUNK_ERROR_FILE_ACCESS;
+    }
+
+    fseek(file, 0, SEEK_END);
+    long file_size = ftell(file);
+    rewind(file);
+
+    if (file_size < 0) {
+        fclose(file);
+        return NETCHUNK_ERROR_FILE_ACCESS;
+    }
+
+    char* content = malloc((size_t)file_size + 1);
+    if (!content) {
+        fclose(file);
+        return NETCHUNK_ERROR_OUT_OF_MEMORY;
+    }
+
+    size_t bytes_read = fread(content, 1, (size_t)file_size, file);
+    fclose(file);
+    if (bytes_read != (size_t)file_size) {
+        free(content);
+        return NETCHUNK_ERROR_FILE_ACCESS;
+    }
+    content[file_size] = '\0';
+
+    cJSON* root = cJSON_Parse(content);
+    free(content);
+    if (!root) {
+        return NETCHUNK_ERROR_MANIFEST_CORRUPT;
+    }
+
+    cJSON* files = cJSON_GetObjectItem(root, "files");
+    if (!files || !cJSON_IsArray(files)) {
+        cJSON_Delete(root);
+        return NETCHUNK_ERROR_MANIFEST_CORRUPT;
+    }
+
+    netchunk_error_t result = NETCHUNK_SUCCESS;
+    cJSON* file_json;
+    cJSON_ArrayForEach(file_json, files)
+    {
+        cJSON* name = cJSON_GetObjectItem(file_json, "name");
+        cJSON* size = cJSON_GetObjectItem(file_json, "size");
+        cJSON* hash = cJSON_GetObjectItem(file_json, "hash");
+        cJSON* chunks = cJSON_GetObjectItem(file_json, "chunks");
+
+        uint8_t hash_bytes[NETCHUNK_HASH_LENGTH];
+        if (!cJSON_IsString(name) || strlen(name->valuestring) >= NETCHUNK_FTP_MAX_NAME_LEN
+            || !cJSON_IsNumber(size) || !cJSON_IsNumber(chunks) || !cJSON_IsString(hash)
+            || netchunk_hex_string_to_hash(hash->valuestring, hash_bytes, sizeof(hash_bytes)) != NETCHUNK_SUCCESS) {
+            result = NETCHUNK_ERROR_MANIFEST_CORRUPT;
+            break;
+        }
+
+        netchunk_catalog_entry_t* entry = catalog_insert(catalog, name->valuestring);
+        if (!entry) {
+            result = NETCHUNK_ERROR_OUT_OF_MEMORY;
+            break;
+        }
+
+        entry->total_size = (uint64_t)size->valuedouble;
+        memcpy(entry->file_hash, hash_bytes, NETCHUNK_HASH_LENGTH);
+        entry->chunk_count = (uint32_t)chunks->valuedouble;
+
+        cJSON* item = cJSON_GetObjectItem(file_json, "created");
+        entry->created_timestamp = cJSON_IsNumber(item) ? (time_t)item->valuedouble : 0;
+        item = cJSON_GetObjectItem(file_json, "modified");
+        entry->last_modified = cJSON_IsNumber(item) ? (time_t)item->valuedouble : 0;
+        item = cJSON_GetObjectItem(file_json, "remote_modified");
+        entry->remote_modified = cJSON_IsNumber(item) ? (time_t)item->valuedouble : 0;
+        item = cJSON_GetObjectItem(file_json, "remote_size");
+        entry->remote_size = cJSON_IsNumber(item) ? (uint64_t)item->valuedouble : 0;
+    }
+
+    cJSON* last_sync = cJSON_GetObjectItem(root, "last_sync");
+    catalog->last_sync = (result == NETCHUNK_SUCCESS && cJSON_IsNumber(last_sync)) ? (time_t)last_sync->valuedouble : 0;
+
+    cJSON_Delete(root);
+    catalog->dirty = false;
+    return result;
+}
+
+netchunk_error_t netchunk_catalog_save(netchunk_catalog_t* catalog)
+{
+    if (!catalog || !catalog->entries) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    cJSON* root = cJSON_CreateObject();
+    cJSON* files = cJSON_CreateArray();
+    if (!root || !files) {
+        cJSON_Delete(root);
+        cJSON_Delete(files);
+        return NETCHUNK_ERROR_OUT_OF_MEMORY;
+    }
+
+    cJSON_AddStringToObject(root, "version", NETCHUNK_CATALOG_VERSION);
+    cJSON_AddNumberToObject(root, "last_sync", (double)catalog->last_sync);
+    cJSON_AddItemToObject(root, "files", files);
+
+    for (size_t i = 0; i < catalog->count; i++) {
+        const netchunk_catalog_entry_t* entry = &catalog->entries[i];
+
+        char hash_hex[NETCHUNK_HASH_LENGTH * 2 + 1];
+        netchunk_hash_to_hex_string(entry->file_hash, NETCHUNK_HASH_LENGTH, hash_hex);
+
+        cJSON* file_json = cJSON_CreateObject();
+        if (!file_json) {
+            cJSON_Delete(root);
+            return NETCHUNK_ERROR_OUT_OF_MEMORY;
+        }
+
+        cJSON_AddStringToObject(file_json, "name", entry->name);
+        cJSON_AddNumberToObject(file_json, "size", (double)entry->total_size);
+        cJSON_AddStringToObject(file_json, "hash", hash_hex);
+        cJSON_AddNumberToObject(file_json, "chunks", (double)entry->chunk_count);
+        cJSON_AddNumberToObject(file_json, "created", (double)entry->created_timestamp);
+        cJSON_AddNumberToObject(file_json, "modified", (double)entry->last_modified);
+        cJSON_AddNumberToObject(file_json, "remote_modified", (double)entry->remote_modified);
+        cJSON_AddNumberToObject(file_json, "remote_size", (double)entry->remote_size);
+        cJSON_AddItemToArray(files, file_json);
+    }
+
+    char* content = cJSON_PrintUnformatted(root);
+    cJSON_Delete(root);
+    if (!content) {
+        return NETCHUNK_ERROR_OUT_OF_MEMORY;
+    }
+
+    netchunk_error_t error = ensure_parent_directory(catalog->path);
+    if (error != NETCHUNK_SUCCESS) {
+        free(content);
+        return error;
+    }
+
+    // Write to a temporary file and rename so a crash never leaves a torn catalog
+    char temp_path[NETCHUNK_MAX_PATH_LEN + sizeof(CATALOG_TEMP_SUFFIX)];
+    snprintf(temp_path, sizeof(temp_path), "%s%s", catalog->path, CATALOG_TEMP_SUFFIX);
+
+    FILE* temp_file = fopen(temp_path, "w");
+    if (!temp_file) {
+        free(content);
+        return NETCHUNK_ERROR_FILE_ACCESS;
+    }
+
+    bool written = fputs(content, temp_file) >= 0 && fflush(temp_file) == 0 && fsync(fileno(temp_file)) == 0;
+    fclose(temp_file);
+    free(content);
+
+    if (!written || rename(temp_path, catalog->path) != 0) {
+        unlink(temp_path);
+        return NETCHUNK_ERROR_FILE_ACCESS;
+    }
+
+    catalog->dirty = false;
+    return NETCHUNK_SUCCESS;
+}
+
+void netchunk_catalog_cleanup(netchunk_catalog_t* catalog)
+{
+    if (!catalog) {
+        return;
+    }
+
+    free(catalog->entries);
+    memset(catalog, 0, sizeof(netchunk_catalog_t));
+}
+
+const netchunk_catalog_entry_t* netchunk_catalog_lookup(const netchunk_catalog_t* catalog, const char* name)
+{
+    if (!catalog || !catalog->entries || !name) {
+        return NULL;
+    }
+
+    bool found;
+    size_t position = catalog_position(catalog, name, &found);
+    return found ? &catalog->entries[position] : NULL;
+}
+
+netchunk_error_t netchunk_catalog_put(netchunk_catalog_t* catalog,
+    const netchunk_file_manifest_t* manifest,
+    time_t remote_modified,
+    uint64_t remote_size)
+{
+    if (!catalog || !catalog->entries || !manifest || manifest->original_filename[0] == '\0'
+        || strlen(manifest->original_filename) >= NETCHUNK_FTP_MAX_NAME_LEN) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    netchunk_catalog_entry_t* entry = catalog_insert(catalog, manifest->original_filename);
+    if (!entry) {
+        return NETCHUNK_ERROR_OUT_OF_MEMORY;
+    }
+
+    entry->total_size = manifest->total_size;
+    memcpy(entry->file_hash, manifest->file_hash, NETCHUNK_HASH_LENGTH);
+    entry->chunk_count = manifest->chunk_count;
+    entry->created_timestamp = manifest->created_timestamp;
+    entry->last_modified = manifest->last_modified;
+    entry->remote_modified = remote_modified;
+    entry->remote_size = remote_size;
+
+    catalog->dirty = true;
+    return NETCHUNK_SUCCESS;
+}
+
+bool netchunk_catalog_remove(netchunk_catalog_t* catalog, const char* name)
+{
+    if (!catalog || !catalog->entries || !name) {
+        return false;
+    }
+
+    bool found;
+    size_t position = catalog_position(catalog, name, &found);
+    if (!found) {
+        return false;
+    }
+
+    memmove(&catalog->entries[position], &catalog->entries[position + 1],
+        (catalog->count - position - 1) * sizeof(netchunk_catalog_entry_t));
+    catalog->count--;
+    catalog->dirty = true;
+    return true;
+}
+
+netchunk_error_t netchunk_catalog_sync(netchunk_catalog_t* catalog,
+    netchunk_ftp_context_t* ftp_context,
+    netchunk_config_t* config,
+    netchunk_catalog_sync_stats_t* stats)
+{
+    if (!catalog || !catalog->entries || !ftp_context || !config) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    netchunk_catalog_sync_stats_t sync_stats;
+    memset(&sync_stats, 0, sizeof(sync_stats));
+
+    netchunk_ftp_manifest_entry_t* remote = NULL;
+    size_t remote_count = 0;
+    netchunk_error_t error = netchunk_ftp_list_manifest_entries(ftp_context, config,
+        &remote, &remote_count, &sync_stats.servers_listed);
+    if (error != NETCHUNK_SUCCESS) {
+        return error;
+    }
+    sync_stats.manifests_listed = (uint32_t)remote_count;
+
+    // Fetch manifests that are new or whose newest copy changed
+    size_t* pending = malloc((remote_count > 0 ? remote_count : 1) * sizeof(size_t));
+    if (!pending) {
+        free(remote);
+        return NETCHUNK_ERROR_OUT_OF_MEMORY;
+    }
+
+    size_t pending_count = 0;
+    for (size_t i = 0; i < remote_count; i++) {
+        const netchunk_catalog_entry_t* known = netchunk_catalog_lookup(catalog, remote[i].name);
+        if (!known || known->remote_modified != remote[i].modified || known->remote_size != remote[i].size) {
+            pending[pending_count++] = i;
+        }
+    }
+
+    for (size_t offset = 0; offset < pending_count && error == NETCHUNK_SUCCESS; offset += CATALOG_FETCH_BATCH) {
+        size_t batch = pending_count - offset < CATALOG_FETCH_BATCH ? pending_count - offset : CATALOG_FETCH_BATCH;
+        error = fetch_manifests(catalog, ftp_context, remote, &pending[offset], batch, &sync_stats);
+    }
+    free(pending);
+
+    // An unreachable server may hold the only copy, so only prune on a full listing
+    if (error == NETCHUNK_SUCCESS && sync_stats.servers_listed == config->server_count) {
+        size_t kept = 0;
+        for (size_t i = 0; i < catalog->count; i++) {
+            if (find_remote_entry(remote, remote_count, catalog->entries[i].name)) {
+                catalog->entries[kept++] = catalog->entries[i];
+            } else {
+                sync_stats.entries_removed++;
+            }
+        }
+        if (kept != catalog->count) {
+            catalog->count = kept;
+            catalog->dirty = true;
+        }
+    }
+
+    free(remote);
+
+    if (error == NETCHUNK_SUCCESS) {
+        catalog->last_sync = time(NULL);
+        error = netchunk_catalog_save(catalog);
+    }
+
+    if (stats) {
+        *stats = sync_stats;
+    }
+
+    return error;
+}
+
+/**
+ * @brief Binary search for name; returns its position or where it would go
+ */
+static size_t catalog_position(const netchunk_catalog_t* catalog, const char* name, bool* found)
+{
+    size_t low = 0;
+    size_t high = catalog->count;
+
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        int order = strcmp(catalog->entries[mid].name, name);
+        if (order == 0) {
+            *found = true;
+            return mid;
+        }
+        if (order < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    *found = false;
+    return low;
+}
+
+/**
+ * @brief Find or create the entry for name, keeping entries sorted
+ *
+ * Appending in name order (as when loading) never moves existing entries.
+ */
+static netchunk_catalog_entry_t* catalog_insert(netchunk_catalog_t* catalog, const char* name)
+{
+    bool found;
+    size_t position = catalog_position(catalog, name, &found);
+    if (found) {
+        return &catalog->entries[position];
+    }
+
+    if (catalog->count == catalog->capacity) {
+        size_t new_capacity = catalog->capacity * 2;
+        netchunk_catalog_entry_t* grown = realloc(catalog->entries, new_capacity * sizeof(netchunk_catalog_entry_t));
+        if (!grown) {
+            return NULL;
+        }
+        catalog->entries = grown;
+        catalog->capacity = new_capacity;
+    }
+
+    memmove(&catalog->entries[position + 1], &catalog->entries[position],
+        (catalog->count - position) * sizeof(netchunk_catalog_entry_t));
+    catalog->count++;
+
+    netchunk_catalog_entry_t* entry = &catalog->entries[position];
+    memset(entry, 0, sizeof(netchunk_catalog_entry_t));
+    strncpy(entry->name, name, sizeof(entry->name) - 1);
+    return entry;
+}
+
+/**
+ * @brief Binary search a name-sorted manifest listing
+ */
+static const netchunk_ftp_manifest_entry_t* find_remote_entry(const netchunk_ftp_manifest_entry_t* entries,
+    size_t count, const char* name)
+{
+    size_t low = 0;
+    size_t high = count;
+
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        int order = strcmp(entries[mid].name, name);
+        if (order == 0) {
+            return &entries[mid];
+        }
+        if (order < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    return NULL;
+}
+
+static netchunk_error_t ensure_parent_directory(const char* file_path)
+{
+    char path_copy[NETCHUNK_MAX_PATH_LEN];
+    strncpy(path_copy, file_path, sizeof(path_copy) - 1);
+    path_copy[sizeof(path_copy) - 1] = '\0';
+
+    for (char* p = path_copy + 1; *p; p++) {
+        if (*p == '/') {
+            *p = '\0';
+            if (mkdir(path_copy, 0755) != 0 && errno != EEXIST) {
+                return NETCHUNK_ERROR_FILE_ACCESS;
+            }
+            *p = '/';
+        }
+    }
+
+    return NETCHUNK_SUCCESS;
+}
+
+/**
+ * @brief Engine callback counting down a fetch batch
+ */
+static void fetch_complete(netchunk_ftp_transfer_t* transfer, void* userdata)
+{
+    (void)transfer;
+    catalog_fetch_batch_t* batch = (catalog_fetch_batch_t*)userdata;
+
+    pthread_mutex_lock(&batch->mutex);
+    if (--batch->remaining == 0) {
+        pthread_cond_signal(&batch->done_cond);
+    }
+    pthread_mutex_unlock(&batch->mutex);
+}
+
+/**
+ * @brief Download a batch of manifests concurrently and record them
+ *
+ * A manifest that cannot be fetched or parsed keeps its old entry and is
+ * counted as a fetch failure; the next sync tries again.
+ */
+static netchunk_error_t fetch_manifests(netchunk_catalog_t* catalog,
+    netchunk_ftp_context_t* ftp_context,
+    const netchunk_ftp_manifest_entry_t* remote,
+    const size_t* pending,
+    size_t pending_count,
+    netchunk_catalog_sync_stats_t* stats)
+{
+    netchunk_ftp_transfer_t* transfers = calloc(pending_count, sizeof(netchunk_ftp_transfer_t));
+    bool* submitted = calloc(pending_count, sizeof(bool));
+    if (!transfers || !submitted) {
+        free(transfers);
+        free(submitted);
+        return NETCHUNK_ERROR_OUT_OF_MEMORY;
+    }
+
+    catalog_fetch_batch_t batch;
+    pthread_mutex_init(&batch.mutex, NULL);
+    pthread_cond_init(&batch.done_cond, NULL);
+    batch.remaining = 0;
+
+    // Count every submission up front so early completions cannot signal too soon
+    pthread_mutex_lock(&batch.mutex);
+    for (size_t i = 0; i < pending_count; i++) {
+        const netchunk_ftp_manifest_entry_t* listed = &remote[pending[i]];
+        char remote_path[NETCHUNK_MAX_PATH_LEN];
+
+        if (netchunk_ftp_manifest_path(listed->name, remote_path, sizeof(remote_path)) == NETCHUNK_SUCCESS
+            && netchunk_ftp_transfer_init_download(&transfers[i], listed->server_index, remote_path,
+                   (size_t)listed->size, fetch_complete, &batch)
+                == NETCHUNK_SUCCESS) {
+            batch.remaining++;
+            if (netchunk_ftp_engine_submit(ftp_context->engine, &transfers[i]) == NETCHUNK_SUCCESS) {
+                submitted[i] = true;
+            } else {
+                batch.remaining--;
+            }
+        }
+    }
+    while (batch.remaining > 0) {
+        pthread_cond_wait(&batch.done_cond, &batch.mutex);
+    }
+    pthread_mutex_unlock(&batch.mutex);
+
+    netchunk_error_t error = NETCHUNK_SUCCESS;
+    for (size_t i = 0; i < pending_count; i++) {
+        const netchunk_ftp_manifest_entry_t* listed = &remote[pending[i]];
+        netchunk_ftp_transfer_t* transfer = &transfers[i];
+        netchunk_file_manifest_t manifest;
+        bool unpacked = false;
+
+        if (error == NETCHUNK_SUCCESS && submitted[i] && transfer->result == NETCHUNK_SUCCESS) {
+            netchunk_packed_manifest_t packed;
+            if (netchunk_packed_manifest_from_buffer(&packed, transfer->buffer.data, transfer->buffer.size)
+                == NETCHUNK_SUCCESS) {
+                unpacked = netchunk_packed_manifest_unpack(&packed, &manifest) == NETCHUNK_SUCCESS;
+                netchunk_packed_manifest_close(&packed);
+            }
+        }
+        netchunk_memory_buffer_cleanup(&transfer->buffer);
+
+        if (error != NETCHUNK_SUCCESS) {
+            continue;
+        }
+        if (!unpacked) {
+            stats->fetch_failures++;
+            continue;
+        }
+
+        // The listing is authoritative for the name, whatever the manifest says
+        if (strcmp(manifest.original_filename, listed->name) != 0) {
+            strncpy(manifest.original_filename, listed->name, sizeof(manifest.original_filename) - 1);
+            manifest.original_filename[sizeof(manifest.original_filename) - 1] = '\0';
+        }
+
+        error = netchunk_catalog_put(catalog, &manifest, listed->modified, listed->size);
+        netchunk_manifest_cleanup(&manifest);
+        stats->manifests_fetched++;
+    }
+
+    pthread_cond_destroy(&batch.done_cond);
+    pthread_mutex_destroy(&batch.mutex);
+    free(submitted);
+    free(transfers);
+
+    return error;
+}
@@ -0,0 +1,300 @@
+/**
+ * @file chunk_cache.c
+ * @brief Size-bounded in-memory LRU cache of chunk data
+ *
+ * Keeps recently read chunks keyed by their hash so ranged reads of the
+ * same region, or of chunks shared between files, are served without
+ * fetching them again.
+ */
+
+#include "chunk_cache.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Internal helper functions
+static size_t cache_bucket(const uint8_t* hash, size_t bucket_count);
+static netchunk_chunk_cache_entry_t* cache_find(const netchunk_chunk_cache_t* cache, const uint8_t* hash);
+static netchunk_error_t cache_grow(netchunk_chunk_cache_t* cache);
+static void cache_lru_unlink(netchunk_chunk_cache_t* cache, netchunk_chunk_cache_entry_t* entry);
+static void cache_lru_push_front(netchunk_chunk_cache_t* cache, netchunk_chunk_cache_entry_t* entry);
+static void cache_unindex(netchunk_chunk_cache_t* cache, netchunk_chunk_cache_entry_t* entry);
+static void cache_free_entry(netchunk_chunk_cache_entry_t* entry);
+static void cache_evict(netchunk_chunk_cache_t* cache);
+
+netchunk_error_t netchunk_chunk_cache_init(netchunk_chunk_cache_t* cache, size_t capacity_bytes)
+{
+    if (!cache) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    memset(cache, 0, sizeof(netchunk_chunk_cache_t));
+
+    cache->buckets = calloc(NETCHUNK_CHUNK_CACHE_INITIAL_BUCKETS, sizeof(netchunk_chunk_cache_entry_t*));
+    if (!cache->buckets) {
+        return NETCHUNK_ERROR_OUT_OF_MEMORY;
+    }
+    cache->bucket_count = NETCHUNK_CHUNK_CACHE_INITIAL_BUCKETS;
+    cache->capacity_bytes = capacity_bytes;
+
+    return NETCHUNK_SUCCESS;
+}
+
+void netchunk_chunk_cache_cleanup(netchunk_chunk_cache_t* cache)
+{
+    if (!cache) {
+        return;
+    }
+
+    netchunk_chunk_cache_entry_t* entry = cache->lru_head;
+    while (entry) {
+        netchunk_chunk_cache_entry_t* next = entry->lru_next;
+        cache_free_entry(entry);
+        entry = next;
+    }
+
+    free(cache->buckets);
+    memset(cache, 0, sizeof(netchunk_chunk_cache_t));
+}
+
+netchunk_chunk_cache_entry_t* netchunk_chunk_cache_acquire(netchunk_chunk_cache_t* cache, const uint8_t* hash)
+{
+    if (!cache || !hash) {
+        return NULL;
+    }
+
+    netchunk_chunk_cache_entry_t* entry = cache_find(cache, hash);
+    if (!entry) {
+        cache->misses++;
+        return NULL;
+    }
+
+    cache->hits++;
+    entry->pins++;
+    cache_lru_unlink(cache, entry);
+    cache_lru_push_front(cache, entry);
+    return entry;
+}
+
+bool netchunk_chunk_cache_contains(const netchunk_chunk_cache_t* cache, const uint8_t* hash)
+{
+    if (!cache || !hash) {
+        return false;
+    }
+
+    return cache_find(cache, hash) != NULL;
+}
+
+netchunk_chunk_cache_entry_t* netchunk_chunk_cache_insert(netchunk_chunk_cache_t* cache,
+    const uint8_t* hash,
+    uint8_t* data,
+    size_t size,
+    int server_index,
+    bool verified)
+{
+    if (!cache || !hash || (!data && size > 0)) {
+        free(data);
+        return NULL;
+    }
+
+    netchunk_chunk_cache_entry_t* entry = cache_find(cache, hash);
+    if (entry) {
+        free(data);
+        netchunk_chunk_cache_pin(cache, entry);
+        cache_lru_unlink(cache, entry);
+        cache_lru_push_front(cache, entry);
+        return entry;
+    }
+
+    // Keep chains short: grow once the table is three quarters full
+    if ((cache->count + 1) * 4 > cache->bucket_count * 3 && cache_grow(cache) != NETCHUNK_SUCCESS) {
+        free(data);
+        return NULL;
+    }
+
+    entry = calloc(1, sizeof(netchunk_chunk_cache_entry_t));
+    if (!entry) {
+        free(data);
+        return NULL;
+    }
+
+    memcpy(entry->hash, hash, NETCHUNK_HASH_LENGTH);
+    entry->data = data;
+    entry->size = size;
+    entry->server_index = server_index;
+    entry->verified = verified;
+    entry->pins = 1;
+
+    size_t bucket = cache_bucket(hash, cache->bucket_count);
+    entry->bucket_next = cache->buckets[bucket];
+    cache->buckets[bucket] = entry;
+    cache_lru_push_front(cache, entry);
+    cache->count++;
+    cache->used_bytes += size;
+
+    cache_evict(cache);
+    return entry;
+}
+
+void netchunk_chunk_cache_pin(netchunk_chunk_cache_t* cache, netchunk_chunk_cache_entry_t* entry)
+{
+    (void)cache;
+    if (entry) {
+        entry->pins++;
+    }
+}
+
+void netchunk_chunk_cache_release(netchunk_chunk_cache_t* cache, netchunk_chunk_cache_entry_t* entry)
+{
+    if (!cache || !entry || entry->pins <= 0) {
+        return;
+    }
+
+    entry->pins--;
+    if (entry->pins == 0 && entry->removed) {
+        cache_free_entry(entry);
+        return;
+    }
+
+    cache_evict(cache);
+}
+
+void netchunk_chunk_cache_remove(netchunk_chunk_cache_t* cache, netchunk_chunk_cache_entry_t* entry)
+{
+    if (!cache || !entry || entry->removed) {
+        return;
+    }
+
+    cache_unindex(cache, entry);
+    entry->removed = true;
+}
+
+/**
+ * @brief Map a hash to its bucket
+ */
+static size_t cache_bucket(const uint8_t* hash, size_t bucket_count)
+{
+    uint64_t key = 0;
+    for (int i = 0; i < 8; i++) {
+        key = (key << 8) | hash[i];
+    }
+    return (size_t)(key & (uint64_t)(bucket_count - 1));
+}
+
+/**
+ * @brief Find an indexed entry by hash
+ */
+static netchunk_chunk_cache_entry_t* cache_find(const netchunk_chunk_cache_t* cache, const uint8_t* hash)
+{
+    netchunk_chunk_cache_entry_t* entry = cache->buckets[cache_bucket(hash, cache->bucket_count)];
+    while (entry && memcmp(entry->hash, hash, NETCHUNK_HASH_LENGTH) != 0) {
+        entry = entry->bucket_next;
+    }
+    return entry;
+}
+
+/**
+ * @brief Double the bucket count and rehash
+ */
+static netchunk_error_t cache_grow(netchunk_chunk_cache_t* cache)
+{
+    size_t bucket_count = cache->bucket_count * 2;
+    netchunk_chunk_cache_entry_t** buckets = calloc(bucket_count, sizeof(netchunk_chunk_cache_entry_t*));
+    if (!buckets) {
+        return NETCHUNK_ERROR_OUT_OF_MEMORY;
+    }
+
+    for (size_t i = 0; i < cache->bucket_count; i++) {
+        netchunk_chunk_cache_entry_t* entry = cache->buckets[i];
+        while (entry) {
+            netchunk_chunk_cache_entry_t* next = entry->bucket_next;
+            size_t bucket = cache_bucket(entry->hash, bucket_count);
+            entry->bucket_next = buckets[bucket];
+            buckets[bucket] = entry;
+            entry = next;
+        }
+    }
+
+    free(cache->buckets);
+    cache->buckets = buckets;
+    cache->bucket_count = bucket_count;
+    return NETCHUNK_SUCCESS;
+}
+
+/**
+ * @brief Take an entry off the recency list
+ */
+static void cache_lru_unlink(netchunk_chunk_cache_t* cache, netchunk_chunk_cache_entry_t* entry)
+{
+    if (entry->lru_prev) {
+        entry->lru_prev->lru_next = entry->lru_next;
+    } else {
+        cache->lru_head = entry->lru_next;
+    }
+    if (entry->lru_next) {
+        entry->lru_next->lru_prev = entry->lru_prev;
+    } else {
+        cache->lru_tail = entry->lru_prev;
+    }
+    entry->lru_prev = NULL;
+    entry->lru_next = NULL;
+}
+
+/**
+ * @brief Mark an entry most recently used
+ */
+static void cache_lru_push_front(netchunk_chunk_cache_t* cache, netchunk_chunk_cache_entry_t* entry)
+{
+    entry->lru_prev = NULL;
+    entry->lru_next = cache->lru_head;
+    if (cache->lru_head) {
+        cache->lru_head->lru_prev = entry;
+    } else {
+        cache->lru_tail = entry;
+    }
+    cache->lru_head = entry;
+}
+
+/**
+ * @brief Remove an entry from the hash table and recency list
+ */
+static void cache_unindex(netchunk_chunk_cache_t* cache, netchunk_chunk_cache_entry_t* entry)
+{
+    netchunk_chunk_cache_entry_t** link = &cache->buckets[cache_bucket(entry->hash, cache->bucket_count)];
+    while (*link && *link != entry) {
+        link = &(*link)->bucket_next;
+    }
+    if (*link) {
+        *link = entry->bucket_next;
+    }
+    entry->bucket_next = NULL;
+
+    cache_lru_unlink(cache, entry);
+    cache->count--;
+    cache->used_bytes -= entry->size;
+}
+
+/**
+ * @brief Free an entry and its data
+ */
+static void cache_free_entry(netchunk_chunk_cache_entry_t* entry)
+{
+    free(entry->data);
+    free(entry);
+}
+
+/**
+ * @brief Evict unpinned entries, least recently used first, until within budget
+ */
+static void cache_evict(netchunk_chunk_cache_t* cache)
+{
+    netchunk_chunk_cache_entry_t* entry = cache->lru_tail;
+    while (entry && cache->used_bytes > cache->capacity_bytes) {
+        netchunk_chunk_cache_entry_t* prev = entry->lru_prev;
+        if (entry->pins == 0) {
+            cache_unindex(cache, entry);
+            cache_free_entry(entry);
+            cache->evictions++;
+        }
+        entry = prev;
+    }
+}
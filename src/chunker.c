@@ -1,6 +1,8 @@
 #include "chunker.h"
+#include "compress.h"
 #include "crypto.h"
 #include <errno.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -8,9 +10,21 @@
 #include <unistd.h>
 
 // Internal helper functions
-static netchunk_error_t read_file_chunk(FILE* file, uint8_t* buffer, size_t buffer_size, size_t* bytes_read);
+static netchunk_error_t chunker_read(netchunk_chunker_context_t* context, uint8_t* buffer, size_t want, netchunk_sha256_context_t* chunk_hash_context, size_t* bytes_read);
+static netchunk_error_t read_fixed_chunk(netchunk_chunker_context_t* context, uint8_t* buffer, size_t* size, uint8_t* hash);
+static netchunk_error_t read_cdc_chunk(netchunk_chunker_context_t* context, uint8_t* buffer, size_t* size, uint8_t* hash);
+static netchunk_error_t chunker_fill(netchunk_chunker_context_t* context, uint8_t* buffer, size_t* size, uint8_t* hash);
+static netchunk_error_t chunker_emit(netchunk_chunker_context_t* context, netchunk_chunk_t* chunk, uint8_t* data, size_t size, const uint8_t* hash, bool data_owned);
+static void cdc_gear_init(void);
+static uint64_t cdc_top_bits_mask(int bits);
+static size_t cdc_find_cut(const netchunk_chunker_context_t* context, const uint8_t* data, size_t len);
+static void chunker_finish(netchunk_chunker_context_t* context);
 static int chunk_compare_by_sequence(const void* a, const void* b);
 
+// Gear rolling hash table for content-defined chunking, filled once
+static uint64_t cdc_gear[256];
+static pthread_once_t cdc_gear_once = PTHREAD_ONCE_INIT;
+
 // Chunking Functions
 
 netchunk_error_t netchunk_chunker_init(netchunk_chunker_context_t* context,
@@ -21,59 +35,76 @@ netchunk_error_t netchunk_chunker_init(netchunk_chunker_context_t* context,
         return NETCHUNK_ERROR_INVALID_ARGUMENT;
     }
 
-    memset(context, 0, sizeof(netchunk_chunker_context_t));
+    if (strcmp(input_file_path, NETCHUNK_CHUNKER_STDIN) == 0) {
+        return netchunk_chunker_init_stream(context, stdin, "stdin", chunk_size);
+    }
 
     // Open input file
-    context->input_file = fopen(input_file_path, "rb");
-    if (!context->input_file) {
+    FILE* input = fopen(input_file_path, "rb");
+    if (!input) {
         return NETCHUNK_ERROR_FILE_NOT_FOUND;
     }
 
-    // Get file size
+    const char* filename = strrchr(input_file_path, '/');
+    filename = filename ? filename + 1 : input_file_path;
+
+    netchunk_error_t error = netchunk_chunker_init_stream(context, input, filename, chunk_size);
+    if (error != NETCHUNK_SUCCESS) {
+        fclose(input);
+        return error;
+    }
+
+    context->owns_input = true;
+    return NETCHUNK_SUCCESS;
+}
+
+netchunk_error_t netchunk_chunker_init_stream(netchunk_chunker_context_t* context,
+    FILE* input,
+    const char* name,
+    size_t chunk_size)
+{
+    if (!context || !input || !name || chunk_size == 0) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    memset(context, 0, sizeof(netchunk_chunker_context_t));
+
+    // Only regular files have a size worth trusting before reading
     struct stat file_stat;
-    if (stat(input_file_path, &file_stat) != 0) {
-        fclose(context->input_file);
+    if (fstat(fileno(input), &file_stat) != 0) {
         return NETCHUNK_ERROR_FILE_ACCESS;
     }
 
+    context->input_file = input;
+    context->owns_input = false;
+    context->size_known = S_ISREG(file_stat.st_mode);
     context->chunk_size = chunk_size;
-    context->total_file_size = file_stat.st_size;
-    context->total_chunks = netchunk_calculate_chunk_count(file_stat.st_size, chunk_size);
+    context->chunking_mode = NETCHUNK_CHUNKING_FIXED;
+    context->min_chunk_size = chunk_size;
+    context->max_chunk_size = chunk_size;
+    context->total_file_size = context->size_known ? (size_t)file_stat.st_size : 0;
+    context->total_chunks = netchunk_calculate_chunk_count(context->total_file_size, chunk_size);
     context->current_chunk_number = 0;
     context->bytes_processed = 0;
     context->finished = false;
     context->start_time = time(NULL);
 
     // Initialize file info
-    const char* filename = strrchr(input_file_path, '/');
-    filename = filename ? filename + 1 : input_file_path;
-    strncpy(context->file_info.filename, filename, NETCHUNK_MAX_PATH_LEN - 1);
+    strncpy(context->file_info.filename, name, NETCHUNK_MAX_PATH_LEN - 1);
     context->file_info.total_size = context->total_file_size;
     context->file_info.created_timestamp = time(NULL);
     context->file_info.last_accessed = time(NULL);
-    context->file_info.chunk_count = netchunk_calculate_chunk_count(context->total_file_size, chunk_size);
+    context->file_info.chunk_count = context->total_chunks;
     context->file_info.chunk_size = chunk_size;
 
-    // Calculate file hash
-    rewind(context->input_file);
-    netchunk_error_t hash_error = netchunk_sha256_hash_file(input_file_path, context->file_info.file_hash);
-    if (hash_error != NETCHUNK_SUCCESS) {
-        fclose(context->input_file);
-        return hash_error;
+    // File hash accumulates as chunks are read
+    netchunk_error_t error = netchunk_sha256_init(&context->file_hash_context);
+    if (error != NETCHUNK_SUCCESS) {
+        return error;
     }
 
-    // Allocate chunk buffer
-    context->chunk_buffer_capacity = chunk_size;
-    context->chunk_buffer = malloc(context->chunk_buffer_capacity);
-    if (!context->chunk_buffer) {
-        fclose(context->input_file);
-        return NETCHUNK_ERROR_OUT_OF_MEMORY;
-    }
-
-    // Reset file position for chunking
-    rewind(context->input_file);
-
-    return NETCHUNK_SUCCESS;
+    // Chunk IDs use a per-upload salt instead of the not-yet-known file hash
+    return netchunk_generate_random_bytes(context->upload_id, sizeof(context->upload_id));
 }
 
 void netchunk_chunker_cleanup(netchunk_chunker_context_t* context)
@@ -82,18 +113,15 @@ void netchunk_chunker_cleanup(netchunk_chunker_context_t* context)
         return;
     }
 
-    if (context->input_file) {
+    if (context->input_file && context->owns_input) {
         fclose(context->input_file);
-        context->input_file = NULL;
     }
+    context->input_file = NULL;
+    context->owns_input = false;
 
-    if (context->chunk_buffer) {
-        free(context->chunk_buffer);
-        context->chunk_buffer = NULL;
-    }
-
-    context->chunk_buffer_capacity = 0;
-    context->chunk_buffer_size = 0;
+    free(context->carry);
+    context->carry = NULL;
+    context->carry_size = 0;
 }
 
 netchunk_error_t netchunk_chunker_next_chunk(netchunk_chunker_context_t* context,
@@ -104,58 +132,139 @@ netchunk_error_t netchunk_chunker_next_chunk(netchunk_chunker_context_t* context
     }
 
     if (context->finished || !context->input_file) {
-        return NETCHUNK_ERROR_FILE_NOT_FOUND; // No more chunks
+        return NETCHUNK_ERROR_EOF; // No more chunks
     }
 
-    // Read next chunk
-    size_t bytes_read;
-    netchunk_error_t read_error = read_file_chunk(context->input_file,
-        context->chunk_buffer,
-        context->chunk_size,
-        &bytes_read);
+    // Read straight into the chunk's own buffer so data is never copied
+    size_t capacity = netchunk_chunker_buffer_size(context);
+    uint8_t* data = malloc(capacity);
+    if (!data) {
+        return NETCHUNK_ERROR_OUT_OF_MEMORY;
+    }
 
-    if (read_error != NETCHUNK_SUCCESS) {
-        return read_error;
+    size_t chunk_bytes = 0;
+    uint8_t chunk_hash[NETCHUNK_HASH_LENGTH];
+    netchunk_error_t error = chunker_fill(context, data, &chunk_bytes, chunk_hash);
+    if (error != NETCHUNK_SUCCESS || chunk_bytes == 0) {
+        free(data);
+        return error;
     }
 
-    if (bytes_read == 0) {
-        context->finished = true;
-        return NETCHUNK_ERROR_FILE_NOT_FOUND; // No more chunks
+    // Give back the unused tail of a short chunk
+    if (chunk_bytes < capacity) {
+        uint8_t* shrunk = realloc(data, chunk_bytes);
+        if (shrunk) {
+            data = shrunk;
+        }
     }
 
-    // Initialize chunk
-    netchunk_error_t chunk_error = netchunk_chunk_init(chunk, context->current_chunk_number, bytes_read);
-    if (chunk_error != NETCHUNK_SUCCESS) {
-        return chunk_error;
+    error = chunker_emit(context, chunk, data, chunk_bytes, chunk_hash, true);
+    if (error != NETCHUNK_SUCCESS) {
+        free(data);
     }
+    return error;
+}
 
-    // Set chunk data
-    chunk_error = netchunk_chunk_set_data(chunk, context->chunk_buffer, bytes_read);
-    if (chunk_error != NETCHUNK_SUCCESS) {
-        netchunk_chunk_cleanup(chunk);
-        return chunk_error;
+size_t netchunk_chunker_buffer_size(const netchunk_chunker_context_t* context)
+{
+    if (!context) {
+        return 0;
     }
 
-    // Generate chunk ID
-    char chunk_id[NETCHUNK_CHUNK_ID_LENGTH + 1];
-    netchunk_error_t id_error = netchunk_generate_chunk_id(chunk_id,
-        context->current_chunk_number,
-        context->file_info.file_hash);
-    if (id_error != NETCHUNK_SUCCESS) {
-        netchunk_chunk_cleanup(chunk);
-        return id_error;
+    return context->chunking_mode == NETCHUNK_CHUNKING_CDC ? context->max_chunk_size : context->chunk_size;
+}
+
+netchunk_error_t netchunk_chunker_next_chunk_into(netchunk_chunker_context_t* context,
+    netchunk_chunk_t* chunk,
+    uint8_t* buffer,
+    size_t buffer_size)
+{
+    if (!context || !chunk || !buffer || buffer_size < netchunk_chunker_buffer_size(context)) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
     }
-    strcpy(chunk->id, chunk_id);
 
-    // Update progress
-    context->current_chunk_number++;
-    context->bytes_processed += bytes_read;
+    if (context->finished || !context->input_file) {
+        return NETCHUNK_ERROR_EOF; // No more chunks
+    }
+
+    size_t chunk_bytes = 0;
+    uint8_t chunk_hash[NETCHUNK_HASH_LENGTH];
+    netchunk_error_t error = chunker_fill(context, buffer, &chunk_bytes, chunk_hash);
+    if (error != NETCHUNK_SUCCESS || chunk_bytes == 0) {
+        return error;
+    }
 
-    // Check if this was the last chunk
-    if (context->bytes_processed >= context->total_file_size) {
-        context->finished = true;
+    return chunker_emit(context, chunk, buffer, chunk_bytes, chunk_hash, false);
+}
+
+netchunk_error_t netchunk_chunker_set_mode(netchunk_chunker_context_t* context,
+    netchunk_chunking_mode_t mode)
+{
+    if (!context || context->input_bytes_read > 0) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    free(context->carry);
+    context->carry = NULL;
+    context->carry_size = 0;
+    context->chunking_mode = mode;
+    context->min_chunk_size = context->chunk_size;
+    context->max_chunk_size = context->chunk_size;
+
+    if (mode != NETCHUNK_CHUNKING_CDC) {
+        context->chunking_mode = NETCHUNK_CHUNKING_FIXED;
+        return NETCHUNK_SUCCESS;
+    }
+
+    size_t average = context->chunk_size;
+    size_t min_size = average / 4;
+    if (min_size < NETCHUNK_CDC_MIN_CHUNK_SIZE) {
+        min_size = NETCHUNK_CDC_MIN_CHUNK_SIZE;
+    }
+    if (min_size > average) {
+        min_size = average;
+    }
+    size_t max_size = average * 4;
+    if (max_size > NETCHUNK_CDC_MAX_CHUNK_SIZE) {
+        max_size = NETCHUNK_CDC_MAX_CHUNK_SIZE;
+    }
+    if (max_size < average) {
+        max_size = average;
+    }
+
+    // Bytes read past a cut point wait here for the next chunk
+    context->carry = malloc(max_size);
+    if (!context->carry) {
+        context->chunking_mode = NETCHUNK_CHUNKING_FIXED;
+        return NETCHUNK_ERROR_OUT_OF_MEMORY;
+    }
+    context->min_chunk_size = min_size;
+    context->max_chunk_size = max_size;
+
+    // Normalized chunking: two bits harder than log2(average) before the
+    // average, two bits easier after it, which narrows the size spread
+    int bits = 0;
+    while (bits < 60 && ((size_t)1 << (bits + 1)) <= average) {
+        bits++;
+    }
+    if (bits < 4) {
+        bits = 4;
+    }
+    context->cdc_mask_small = cdc_top_bits_mask(bits + 2);
+    context->cdc_mask_large = cdc_top_bits_mask(bits - 2);
+
+    pthread_once(&cdc_gear_once, cdc_gear_init);
+    return NETCHUNK_SUCCESS;
+}
+
+netchunk_error_t netchunk_chunker_get_file_hash(const netchunk_chunker_context_t* context,
+    uint8_t* hash)
+{
+    if (!context || !hash || !context->file_hash_ready) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
     }
 
+    memcpy(hash, context->file_info.file_hash, NETCHUNK_HASH_LENGTH);
     return NETCHUNK_SUCCESS;
 }
 
@@ -165,6 +274,10 @@ bool netchunk_chunker_has_next(const netchunk_chunker_context_t* context)
         return false;
     }
 
+    if (!context->size_known) {
+        return !context->finished;
+    }
+
     return !context->finished && context->bytes_processed < context->total_file_size;
 }
 
@@ -273,8 +386,24 @@ netchunk_error_t netchunk_chunk_verify_integrity(const netchunk_chunk_t* chunk)
         return NETCHUNK_ERROR_INVALID_ARGUMENT;
     }
 
+    // The hash covers the raw bytes, so compressed or encrypted data is decoded first
+    uint8_t* raw = NULL;
+    if (netchunk_chunk_is_encoded(chunk)) {
+        raw = malloc(chunk->size > 0 ? chunk->size : 1);
+        if (!raw) {
+            return NETCHUNK_ERROR_OUT_OF_MEMORY;
+        }
+
+        netchunk_error_t decode_error = netchunk_chunk_decode(chunk, raw);
+        if (decode_error != NETCHUNK_SUCCESS) {
+            free(raw);
+            return decode_error;
+        }
+    }
+
     uint8_t computed_hash[NETCHUNK_HASH_LENGTH];
-    netchunk_error_t hash_error = netchunk_sha256_hash(chunk->data, chunk->size, computed_hash);
+    netchunk_error_t hash_error = netchunk_sha256_hash(raw ? raw : chunk->data, chunk->size, computed_hash);
+    free(raw);
     if (hash_error != NETCHUNK_SUCCESS) {
         return hash_error;
     }
@@ -286,11 +415,58 @@ netchunk_error_t netchunk_chunk_verify_integrity(const netchunk_chunk_t* chunk)
     return NETCHUNK_SUCCESS;
 }
 
+netchunk_error_t netchunk_chunk_verify_batch(const netchunk_chunk_t* const* chunks,
+    size_t count,
+    netchunk_error_t* results)
+{
+    if (!chunks || !results || count > NETCHUNK_SHA256_MAX_LANES) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    const uint8_t* data[NETCHUNK_SHA256_MAX_LANES] = { 0 };
+    size_t sizes[NETCHUNK_SHA256_MAX_LANES] = { 0 };
+    uint8_t computed[NETCHUNK_SHA256_MAX_LANES][NETCHUNK_HASH_LENGTH];
+    uint8_t* hashes[NETCHUNK_SHA256_MAX_LANES] = { 0 };
+    size_t batched[NETCHUNK_SHA256_MAX_LANES];
+    size_t batch_count = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        if (!chunks[i] || !chunks[i]->data) {
+            return NETCHUNK_ERROR_INVALID_ARGUMENT;
+        }
+
+        // Compressed or encrypted chunks are decoded and checked one at a time
+        if (netchunk_chunk_is_encoded(chunks[i])) {
+            results[i] = netchunk_chunk_verify_integrity(chunks[i]);
+            continue;
+        }
+        data[batch_count] = chunks[i]->data;
+        sizes[batch_count] = chunks[i]->size;
+        hashes[batch_count] = computed[batch_count];
+        batched[batch_count++] = i;
+    }
+
+    if (batch_count == 0) {
+        return NETCHUNK_SUCCESS;
+    }
+
+    netchunk_error_t hash_error = netchunk_sha256_hash_batch(data, sizes, batch_count, hashes);
+    if (hash_error != NETCHUNK_SUCCESS) {
+        return hash_error;
+    }
+
+    for (size_t j = 0; j < batch_count; j++) {
+        bool match = netchunk_hash_compare(chunks[batched[j]]->hash, computed[j], NETCHUNK_HASH_LENGTH);
+        results[batched[j]] = match ? NETCHUNK_SUCCESS : NETCHUNK_ERROR_CHUNK_INTEGRITY;
+    }
+
+    return NETCHUNK_SUCCESS;
+}
+
 netchunk_error_t netchunk_chunk_add_location(netchunk_chunk_t* chunk,
-    int server_id,
-    const char* remote_path)
+    int server_id)
 {
-    if (!chunk || !remote_path || server_id < 0) {
+    if (!chunk || server_id < 0) {
         return NETCHUNK_ERROR_INVALID_ARGUMENT;
     }
 
@@ -302,7 +478,6 @@ netchunk_error_t netchunk_chunk_add_location(netchunk_chunk_t* chunk,
     for (int i = 0; i < chunk->location_count; i++) {
         if (strcmp(chunk->locations[i].server_id, server_id_str) == 0) {
             // Update existing location
-            strncpy(chunk->locations[i].remote_path, remote_path, NETCHUNK_MAX_PATH_LEN - 1);
             chunk->locations[i].upload_time = time(NULL);
             chunk->locations[i].verified = false;
             return NETCHUNK_SUCCESS;
@@ -317,7 +492,6 @@ netchunk_error_t netchunk_chunk_add_location(netchunk_chunk_t* chunk,
     // Add new location
     netchunk_chunk_location_t* location = &chunk->locations[chunk->location_count];
     snprintf(location->server_id, sizeof(location->server_id), "%d", server_id);
-    strncpy(location->remote_path, remote_path, NETCHUNK_MAX_PATH_LEN - 1);
     location->upload_time = time(NULL);
     location->verified = false;
     location->last_verified = 0;
@@ -414,11 +588,17 @@ netchunk_error_t netchunk_reconstruct_file_init(const char* output_file_path,
     // Sort chunks by sequence number
     netchunk_sort_chunks_by_sequence(chunks, chunk_count);
 
-    // Verify chunk sequence is complete
+    // Verify chunk sequence is complete and chunks tile the file
+    size_t expected_offset = 0;
     for (uint32_t i = 0; i < chunk_count; i++) {
-        if (chunks[i].sequence_number != i) {
+        if (chunks[i].sequence_number != i || chunks[i].offset != expected_offset) {
             return NETCHUNK_ERROR_INVALID_ARGUMENT;
         }
+        expected_offset += chunks[i].size;
+    }
+
+    if (expected_offset != file_info->total_size) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
     }
 
     return NETCHUNK_SUCCESS;
@@ -451,7 +631,8 @@ netchunk_error_t netchunk_reconstruct_file(const char* output_file_path,
     for (uint32_t i = 0; i < chunk_count; i++) {
         netchunk_chunk_t* chunk = &chunks[i];
 
-        if (!chunk->data) {
+        // Chunks vary in size, so each must start where the previous one ended
+        if (!chunk->data || chunk->offset != total_bytes_written) {
             fclose(output_file);
             unlink(output_file_path); // Remove partial file
             return NETCHUNK_ERROR_INVALID_ARGUMENT;
@@ -522,29 +703,52 @@ netchunk_error_t netchunk_verify_reconstructed_file(const char* file_path,
 
 netchunk_error_t netchunk_generate_chunk_id(char* chunk_id,
     uint32_t sequence_number,
-    const uint8_t* file_hash)
+    const uint8_t* upload_id)
 {
-    if (!chunk_id || !file_hash) {
+    if (!chunk_id || !upload_id) {
         return NETCHUNK_ERROR_INVALID_ARGUMENT;
     }
 
     // Generate random component for uniqueness
-    uint8_t random_bytes[8];
+    uint8_t random_bytes[2];
     netchunk_error_t random_error = netchunk_generate_random_bytes(random_bytes, sizeof(random_bytes));
     if (random_error != NETCHUNK_SUCCESS) {
         return random_error;
     }
 
-    // Create chunk ID from sequence number, file hash prefix, and random bytes
-    snprintf(chunk_id, NETCHUNK_CHUNK_ID_LENGTH + 1,
-        "%08x%02x%02x%02x%02x%02x%02x",
+    // Create chunk ID from sequence number, upload salt prefix, and random bytes
+    snprintf(chunk_id, NETCHUNK_RANDOM_CHUNK_ID_LENGTH + 1,
+        "%08x%02x%02x%02x%02x",
         sequence_number,
-        file_hash[0], file_hash[1],
-        random_bytes[0], random_bytes[1], random_bytes[2], random_bytes[3]);
+        upload_id[0], upload_id[1],
+        random_bytes[0], random_bytes[1]);
 
     return NETCHUNK_SUCCESS;
 }
 
+netchunk_error_t netchunk_chunk_set_content_id(netchunk_chunk_t* chunk)
+{
+    if (!chunk) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    return netchunk_hash_to_hex_string(chunk->hash, NETCHUNK_HASH_LENGTH, chunk->id);
+}
+
+bool netchunk_chunk_is_content_addressed(const netchunk_chunk_t* chunk)
+{
+    if (!chunk || strlen(chunk->id) != NETCHUNK_CHUNK_ID_LENGTH) {
+        return false;
+    }
+
+    char hash_hex[NETCHUNK_CHUNK_ID_LENGTH + 1];
+    if (netchunk_hash_to_hex_string(chunk->hash, NETCHUNK_HASH_LENGTH, hash_hex) != NETCHUNK_SUCCESS) {
+        return false;
+    }
+
+    return strcmp(chunk->id, hash_hex) == 0;
+}
+
 uint32_t netchunk_calculate_chunk_count(size_t file_size, size_t target_chunk_size)
 {
     if (file_size == 0 || target_chunk_size == 0) {
@@ -644,25 +848,290 @@ void netchunk_get_chunk_statistics(const netchunk_chunk_t* chunks,
 
 // Internal helper functions
 
-static netchunk_error_t read_file_chunk(FILE* file, uint8_t* buffer, size_t buffer_size, size_t* bytes_read)
+/**
+ * @brief Read up to want bytes, feeding the file hash and optionally a chunk hash
+ *
+ * Reads in NETCHUNK_READ_BUFFER_SIZE slices so each slice is hashed while it
+ * is still in cache. Sets input_eof on a short read or once a known input
+ * size has been consumed.
+ */
+static netchunk_error_t chunker_read(netchunk_chunker_context_t* context,
+    uint8_t* buffer,
+    size_t want,
+    netchunk_sha256_context_t* chunk_hash_context,
+    size_t* bytes_read)
 {
-    if (!file || !buffer || !bytes_read) {
-        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    size_t filled = 0;
+
+    while (filled < want) {
+        size_t slice = want - filled;
+        if (slice > NETCHUNK_READ_BUFFER_SIZE) {
+            slice = NETCHUNK_READ_BUFFER_SIZE;
+        }
+
+        // Clock readings are 0 without metrics, so the sums stay 0 too
+        uint64_t read_start = netchunk_metrics_start(context->metrics);
+        size_t got = fread(buffer + filled, 1, slice, context->input_file);
+        uint64_t hash_start = netchunk_metrics_start(context->metrics);
+        context->read_ns += hash_start - read_start;
+        if (got > 0) {
+            if (chunk_hash_context) {
+                netchunk_sha256_update(chunk_hash_context, buffer + filled, got);
+            }
+            netchunk_sha256_update(&context->file_hash_context, buffer + filled, got);
+            context->hash_ns += netchunk_metrics_start(context->metrics) - hash_start;
+            filled += got;
+        }
+
+        if (got < slice) {
+            if (ferror(context->input_file)) {
+                return NETCHUNK_ERROR_FILE_ACCESS;
+            }
+            context->input_eof = true; // End of file reached
+            break;
+        }
     }
 
-    *bytes_read = fread(buffer, 1, buffer_size, file);
+    context->input_bytes_read += filled;
+    if (context->size_known && context->input_bytes_read >= context->total_file_size) {
+        context->input_eof = true;
+    }
 
-    if (*bytes_read == 0) {
-        if (feof(file)) {
-            return NETCHUNK_SUCCESS; // End of file reached
-        } else if (ferror(file)) {
-            return NETCHUNK_ERROR_FILE_ACCESS;
+    *bytes_read = filled;
+    return NETCHUNK_SUCCESS;
+}
+
+/**
+ * @brief Read the next fixed-size chunk into a buffer of chunk_size bytes
+ */
+static netchunk_error_t read_fixed_chunk(netchunk_chunker_context_t* context,
+    uint8_t* buffer,
+    size_t* size,
+    uint8_t* hash)
+{
+    *size = 0;
+
+    netchunk_sha256_context_t chunk_hash_context;
+    netchunk_sha256_init(&chunk_hash_context);
+
+    size_t bytes_read = 0;
+    netchunk_error_t read_error = chunker_read(context, buffer, context->chunk_size, &chunk_hash_context, &bytes_read);
+    if (read_error != NETCHUNK_SUCCESS || bytes_read == 0) {
+        return read_error;
+    }
+
+    netchunk_sha256_final(&chunk_hash_context, hash);
+    *size = bytes_read;
+    return NETCHUNK_SUCCESS;
+}
+
+/**
+ * @brief Read ahead to the maximum chunk size and cut at a content-defined boundary
+ *
+ * The buffer holds max_chunk_size bytes. The file hash is still fused with
+ * reading; the chunk hash runs over the chunk once its boundary is known.
+ */
+static netchunk_error_t read_cdc_chunk(netchunk_chunker_context_t* context,
+    uint8_t* buffer,
+    size_t* size,
+    uint8_t* hash)
+{
+    *size = 0;
+
+    // Start with the bytes left over after the previous cut
+    size_t filled = context->carry_size;
+    memcpy(buffer, context->carry, filled);
+    context->carry_size = 0;
+
+    if (!context->input_eof && filled < context->max_chunk_size) {
+        size_t bytes_read = 0;
+        netchunk_error_t read_error = chunker_read(context, buffer + filled,
+            context->max_chunk_size - filled, NULL, &bytes_read);
+        if (read_error != NETCHUNK_SUCCESS) {
+            return read_error;
         }
+        filled += bytes_read;
+    }
+
+    if (filled == 0) {
+        return NETCHUNK_SUCCESS;
+    }
+
+    size_t cut = cdc_find_cut(context, buffer, filled);
+    if (cut < filled) {
+        memcpy(context->carry, buffer + cut, filled - cut);
+        context->carry_size = filled - cut;
+    }
+
+    uint64_t hash_start = netchunk_metrics_start(context->metrics);
+    netchunk_error_t hash_error = netchunk_sha256_hash(buffer, cut, hash);
+    if (hash_error != NETCHUNK_SUCCESS) {
+        return hash_error;
+    }
+    context->hash_ns += netchunk_metrics_start(context->metrics) - hash_start;
+
+    *size = cut;
+    return NETCHUNK_SUCCESS;
+}
+
+/**
+ * @brief Read the next chunk in the configured mode; finishes the chunker at EOF
+ */
+static netchunk_error_t chunker_fill(netchunk_chunker_context_t* context,
+    uint8_t* buffer,
+    size_t* size,
+    uint8_t* hash)
+{
+    netchunk_error_t read_error;
+    if (context->chunking_mode == NETCHUNK_CHUNKING_CDC) {
+        read_error = read_cdc_chunk(context, buffer, size, hash);
+    } else {
+        read_error = read_fixed_chunk(context, buffer, size, hash);
+    }
+    if (read_error != NETCHUNK_SUCCESS) {
+        return read_error;
+    }
+
+    if (*size == 0) {
+        chunker_finish(context);
+        return NETCHUNK_ERROR_EOF; // No more chunks
+    }
+
+    if (context->metrics) {
+        netchunk_metrics_record_duration(context->metrics, NETCHUNK_METRICS_READ, context->read_ns);
+        netchunk_metrics_record_duration(context->metrics, NETCHUNK_METRICS_HASH, context->hash_ns);
+        netchunk_metrics_add(context->metrics, NETCHUNK_METRICS_BYTES_READ, *size);
+        context->read_ns = 0;
+        context->hash_ns = 0;
+    }
+
+    return NETCHUNK_SUCCESS;
+}
+
+/**
+ * @brief Fill in a chunk read by chunker_fill() and advance the chunker
+ *
+ * The chunk only takes the data on success; on failure the caller still
+ * owns it.
+ */
+static netchunk_error_t chunker_emit(netchunk_chunker_context_t* context,
+    netchunk_chunk_t* chunk,
+    uint8_t* data,
+    size_t size,
+    const uint8_t* hash,
+    bool data_owned)
+{
+    // Initialize chunk
+    netchunk_error_t chunk_error = netchunk_chunk_init(chunk, context->current_chunk_number, size);
+    if (chunk_error != NETCHUNK_SUCCESS) {
+        return chunk_error;
+    }
+
+    // Generate chunk ID
+    char chunk_id[NETCHUNK_CHUNK_ID_LENGTH + 1];
+    netchunk_error_t id_error = netchunk_generate_chunk_id(chunk_id,
+        context->current_chunk_number,
+        context->upload_id);
+    if (id_error != NETCHUNK_SUCCESS) {
+        return id_error;
+    }
+    strcpy(chunk->id, chunk_id);
+
+    chunk->data = data;
+    chunk->data_owned = data_owned;
+    chunk->offset = context->bytes_processed;
+    memcpy(chunk->hash, hash, NETCHUNK_HASH_LENGTH);
+
+    // Update progress
+    context->current_chunk_number++;
+    context->bytes_processed += size;
+
+    // Stop without another read once the input and any carried bytes are used up
+    if (context->input_eof && context->carry_size == 0) {
+        chunker_finish(context);
     }
 
     return NETCHUNK_SUCCESS;
 }
 
+/**
+ * @brief Fill the Gear table from a fixed seed
+ *
+ * Boundaries, and therefore deduplication across uploads, depend on these
+ * values: the seed and generator must never change.
+ */
+static void cdc_gear_init(void)
+{
+    uint64_t seed = 0x6e65746368756e6bULL; // "netchunk"
+    for (int i = 0; i < 256; i++) {
+        // splitmix64
+        uint64_t z = (seed += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        cdc_gear[i] = z ^ (z >> 31);
+    }
+}
+
+/**
+ * @brief Mask of the top bits of the Gear hash, which depend on the last 64 bytes
+ */
+static uint64_t cdc_top_bits_mask(int bits)
+{
+    return ~(uint64_t)0 << (64 - bits);
+}
+
+/**
+ * @brief Find the FastCDC cut point in the first len bytes of data
+ *
+ * len is below max_chunk_size only at end of input, where the remainder
+ * becomes the last chunk if no boundary is found.
+ */
+static size_t cdc_find_cut(const netchunk_chunker_context_t* context, const uint8_t* data, size_t len)
+{
+    if (len <= context->min_chunk_size) {
+        return len;
+    }
+
+    size_t limit = len < context->max_chunk_size ? len : context->max_chunk_size;
+    size_t normal = context->chunk_size < limit ? context->chunk_size : limit;
+    uint64_t hash = 0;
+    size_t i = context->min_chunk_size;
+
+    for (; i < normal; i++) {
+        hash = (hash << 1) + cdc_gear[data[i]];
+        if (!(hash & context->cdc_mask_small)) {
+            return i + 1;
+        }
+    }
+    for (; i < limit; i++) {
+        hash = (hash << 1) + cdc_gear[data[i]];
+        if (!(hash & context->cdc_mask_large)) {
+            return i + 1;
+        }
+    }
+
+    return limit;
+}
+
+/**
+ * @brief Mark the input exhausted and finalize the whole-file hash
+ */
+static void chunker_finish(netchunk_chunker_context_t* context)
+{
+    context->finished = true;
+
+    if (!context->file_hash_ready) {
+        netchunk_sha256_final(&context->file_hash_context, context->file_info.file_hash);
+        context->file_hash_ready = true;
+    }
+
+    // Streams of unknown length only learn their size now
+    context->total_file_size = context->bytes_processed;
+    context->total_chunks = context->current_chunk_number;
+    context->file_info.total_size = context->total_file_size;
+    context->file_info.chunk_count = context->total_chunks;
+}
+
 static int chunk_compare_by_sequence(const void* a, const void* b)
 {
     const netchunk_chunk_t* chunk_a = (const netchunk_chunk_t*)a;
@@ -0,0 +1,320 @@
+/**
+ * @file cipher.c
+ * @brief Per-chunk authenticated encryption
+ *
+ * Chunks are encrypted one at a time with AES-256-GCM after compression,
+ * so each can be fetched and decrypted on its own. Keys live in a process
+ * wide key ring and chunks name the key they were encrypted with, which
+ * lets files written before a key rotation stay readable.
+ */
+
+#include "cipher.h"
+#include "crypto.h"
+#include <ctype.h>
+#include <errno.h>
+#include <limits.h>
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+// One key of the ring
+typedef struct keyring_entry {
+    uint8_t id[NETCHUNK_KEY_ID_LENGTH];
+    uint8_t key[NETCHUNK_CIPHER_KEY_LENGTH];
+} keyring_entry_t;
+
+static pthread_mutex_t keyring_mutex = PTHREAD_MUTEX_INITIALIZER;
+static keyring_entry_t keyring[NETCHUNK_MAX_KEYS];
+static int keyring_count = 0;
+
+// Cipher context reused by each thread, freed when it exits
+static pthread_once_t cipher_key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t cipher_key;
+
+// Internal helper functions
+static bool keyring_lookup(const uint8_t* key_id, uint8_t* key);
+static netchunk_error_t keyring_parse_line(char* line, uint8_t* key, bool* found);
+static void cipher_key_init(void);
+static void cipher_context_free(void* context);
+static EVP_CIPHER_CTX* cipher_context(void);
+
+// Key Ring Functions
+
+netchunk_error_t netchunk_keyring_load_file(const char* path, uint8_t* current_key_id)
+{
+    if (!path || !current_key_id) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        return errno == ENOENT ? NETCHUNK_ERROR_FILE_NOT_FOUND : NETCHUNK_ERROR_FILE_ACCESS;
+    }
+
+    // Whoever can read the key can read every file encrypted with it
+    if ((st.st_mode & (S_IRWXG | S_IRWXO)) != 0) {
+        return NETCHUNK_ERROR_CONFIG_VALIDATION;
+    }
+
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        return NETCHUNK_ERROR_FILE_ACCESS;
+    }
+
+    char line[256];
+    int keys_loaded = 0;
+    netchunk_error_t error = NETCHUNK_SUCCESS;
+    while (error == NETCHUNK_SUCCESS && fgets(line, sizeof(line), file)) {
+        uint8_t key[NETCHUNK_CIPHER_KEY_LENGTH];
+        bool found = false;
+
+        error = keyring_parse_line(line, key, &found);
+        if (error == NETCHUNK_SUCCESS && found) {
+            error = netchunk_keyring_add(key, keys_loaded == 0 ? current_key_id : NULL);
+            keys_loaded++;
+        }
+        OPENSSL_cleanse(key, sizeof(key));
+    }
+    OPENSSL_cleanse(line, sizeof(line));
+    fclose(file);
+
+    if (error == NETCHUNK_SUCCESS && keys_loaded == 0) {
+        error = NETCHUNK_ERROR_CONFIG_VALIDATION;
+    }
+    return error;
+}
+
+netchunk_error_t netchunk_keyring_add(const uint8_t* key, uint8_t* key_id)
+{
+    if (!key) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    uint8_t digest[NETCHUNK_SHA256_DIGEST_LENGTH];
+    netchunk_error_t error = netchunk_sha256_hash(key, NETCHUNK_CIPHER_KEY_LENGTH, digest);
+    if (error != NETCHUNK_SUCCESS) {
+        return error;
+    }
+
+    pthread_mutex_lock(&keyring_mutex);
+
+    int index = 0;
+    while (index < keyring_count && memcmp(keyring[index].id, digest, NETCHUNK_KEY_ID_LENGTH) != 0) {
+        index++;
+    }
+    if (index == keyring_count) {
+        if (keyring_count == NETCHUNK_MAX_KEYS) {
+            error = NETCHUNK_ERROR_CRYPTO;
+        } else {
+            memcpy(keyring[index].id, digest, NETCHUNK_KEY_ID_LENGTH);
+            memcpy(keyring[index].key, key, NETCHUNK_CIPHER_KEY_LENGTH);
+            keyring_count++;
+        }
+    }
+
+    pthread_mutex_unlock(&keyring_mutex);
+
+    if (error == NETCHUNK_SUCCESS && key_id) {
+        memcpy(key_id, digest, NETCHUNK_KEY_ID_LENGTH);
+    }
+    return error;
+}
+
+bool netchunk_keyring_has(const uint8_t* key_id)
+{
+    uint8_t key[NETCHUNK_CIPHER_KEY_LENGTH];
+    bool found = key_id && keyring_lookup(key_id, key);
+    OPENSSL_cleanse(key, sizeof(key));
+    return found;
+}
+
+void netchunk_keyring_clear(void)
+{
+    pthread_mutex_lock(&keyring_mutex);
+    OPENSSL_cleanse(keyring, sizeof(keyring));
+    keyring_count = 0;
+    pthread_mutex_unlock(&keyring_mutex);
+}
+
+bool netchunk_key_id_is_set(const uint8_t* key_id)
+{
+    if (!key_id) {
+        return false;
+    }
+
+    for (int i = 0; i < NETCHUNK_KEY_ID_LENGTH; i++) {
+        if (key_id[i] != 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Chunk Cipher Functions
+
+netchunk_error_t netchunk_cipher_encrypt(const uint8_t* key_id,
+    const char* chunk_id,
+    uint8_t* data,
+    size_t size)
+{
+    if (!key_id || !chunk_id || !data || size > INT_MAX) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    EVP_CIPHER_CTX* context = cipher_context();
+    if (!context) {
+        return NETCHUNK_ERROR_OUT_OF_MEMORY;
+    }
+
+    uint8_t key[NETCHUNK_CIPHER_KEY_LENGTH];
+    if (!keyring_lookup(key_id, key)) {
+        return NETCHUNK_ERROR_CRYPTO;
+    }
+
+    uint8_t* nonce = data + size;
+    uint8_t* tag = nonce + NETCHUNK_CIPHER_NONCE_LENGTH;
+    int length = 0;
+    bool ok = RAND_bytes(nonce, NETCHUNK_CIPHER_NONCE_LENGTH) == 1
+        && EVP_EncryptInit_ex(context, EVP_aes_256_gcm(), NULL, key, nonce) == 1
+        && EVP_EncryptUpdate(context, NULL, &length, (const uint8_t*)chunk_id, (int)strlen(chunk_id)) == 1
+        && EVP_EncryptUpdate(context, data, &length, data, (int)size) == 1
+        && EVP_EncryptFinal_ex(context, data + length, &length) == 1
+        && EVP_CIPHER_CTX_ctrl(context, EVP_CTRL_GCM_GET_TAG, NETCHUNK_CIPHER_TAG_LENGTH, tag) == 1;
+    OPENSSL_cleanse(key, sizeof(key));
+
+    return ok ? NETCHUNK_SUCCESS : NETCHUNK_ERROR_CRYPTO;
+}
+
+netchunk_error_t netchunk_cipher_decrypt(const uint8_t* key_id,
+    const char* chunk_id,
+    const uint8_t* src,
+    size_t stored_size,
+    uint8_t* dst)
+{
+    if (!key_id || !chunk_id || !src || !dst) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+    if (stored_size < NETCHUNK_CIPHER_OVERHEAD || stored_size - NETCHUNK_CIPHER_OVERHEAD > INT_MAX) {
+        return NETCHUNK_ERROR_CHUNK_INTEGRITY;
+    }
+
+    EVP_CIPHER_CTX* context = cipher_context();
+    if (!context) {
+        return NETCHUNK_ERROR_OUT_OF_MEMORY;
+    }
+
+    uint8_t key[NETCHUNK_CIPHER_KEY_LENGTH];
+    if (!keyring_lookup(key_id, key)) {
+        return NETCHUNK_ERROR_CRYPTO;
+    }
+
+    size_t size = stored_size - NETCHUNK_CIPHER_OVERHEAD;
+    const uint8_t* nonce = src + size;
+    uint8_t tag[NETCHUNK_CIPHER_TAG_LENGTH];
+    memcpy(tag, nonce + NETCHUNK_CIPHER_NONCE_LENGTH, sizeof(tag));
+
+    int length = 0;
+    bool ok = EVP_DecryptInit_ex(context, EVP_aes_256_gcm(), NULL, key, nonce) == 1
+        && EVP_DecryptUpdate(context, NULL, &length, (const uint8_t*)chunk_id, (int)strlen(chunk_id)) == 1
+        && EVP_DecryptUpdate(context, dst, &length, src, (int)size) == 1
+        && EVP_CIPHER_CTX_ctrl(context, EVP_CTRL_GCM_SET_TAG, NETCHUNK_CIPHER_TAG_LENGTH, tag) == 1;
+    OPENSSL_cleanse(key, sizeof(key));
+    if (!ok) {
+        return NETCHUNK_ERROR_CRYPTO;
+    }
+
+    // Only a matching tag makes the output trustworthy
+    if (EVP_DecryptFinal_ex(context, dst + length, &length) != 1) {
+        OPENSSL_cleanse(dst, size);
+        return NETCHUNK_ERROR_CHUNK_INTEGRITY;
+    }
+    return NETCHUNK_SUCCESS;
+}
+
+// Internal helper functions
+
+/**
+ * @brief Copy the key with an ID out of the ring
+ */
+static bool keyring_lookup(const uint8_t* key_id, uint8_t* key)
+{
+    bool found = false;
+
+    pthread_mutex_lock(&keyring_mutex);
+    for (int i = 0; i < keyring_count && !found; i++) {
+        if (memcmp(keyring[i].id, key_id, NETCHUNK_KEY_ID_LENGTH) == 0) {
+            memcpy(key, keyring[i].key, NETCHUNK_CIPHER_KEY_LENGTH);
+            found = true;
+        }
+    }
+    pthread_mutex_unlock(&keyring_mutex);
+
+    return found;
+}
+
+/**
+ * @brief Parse one key file line; found is false for blank and comment lines
+ */
+static netchunk_error_t keyring_parse_line(char* line, uint8_t* key, bool* found)
+{
+    char* start = line;
+    while (isspace((unsigned char)*start)) {
+        start++;
+    }
+    char* end = start + strlen(start);
+    while (end > start && isspace((unsigned char)end[-1])) {
+        end--;
+    }
+    *end = '\0';
+
+    *found = false;
+    if (*start == '\0' || *start == '#') {
+        return NETCHUNK_SUCCESS;
+    }
+
+    if (end - start != NETCHUNK_CIPHER_KEY_LENGTH * 2) {
+        return NETCHUNK_ERROR_CONFIG_VALIDATION;
+    }
+    for (char* c = start; c < end; c++) {
+        if (!isxdigit((unsigned char)*c)) {
+            return NETCHUNK_ERROR_CONFIG_VALIDATION;
+        }
+    }
+
+    netchunk_error_t error = netchunk_hex_string_to_hash(start, key, NETCHUNK_CIPHER_KEY_LENGTH);
+    *found = error == NETCHUNK_SUCCESS;
+    return error;
+}
+
+static void cipher_key_init(void)
+{
+    pthread_key_create(&cipher_key, cipher_context_free);
+}
+
+static void cipher_context_free(void* context)
+{
+    EVP_CIPHER_CTX_free((EVP_CIPHER_CTX*)context);
+}
+
+/**
+ * @brief Get the calling thread's cipher context, created on first use
+ */
+static EVP_CIPHER_CTX* cipher_context(void)
+{
+    pthread_once(&cipher_key_once, cipher_key_init);
+
+    EVP_CIPHER_CTX* context = pthread_getspecific(cipher_key);
+    if (!context) {
+        context = EVP_CIPHER_CTX_new();
+        if (context && pthread_setspecific(cipher_key, context) != 0) {
+            EVP_CIPHER_CTX_free(context);
+            context = NULL;
+        }
+    }
+    return context;
+}
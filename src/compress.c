@@ -0,0 +1,363 @@
+/**
+ * @file compress.c
+ * @brief Per-chunk compression
+ *
+ * Chunks are compressed one at a time and independently, so any chunk can
+ * be fetched and decoded on its own. The hash always covers the raw bytes;
+ * compression and encryption only change what is stored on the servers.
+ */
+
+#include "compress.h"
+#include "cipher.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef NETCHUNK_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#define COMPRESS_SAMPLE_LEVEL 1 // Samples only estimate the ratio
+
+#ifdef NETCHUNK_HAVE_ZSTD
+// Codec contexts reused by each thread, freed when it exits
+typedef struct compress_thread_state {
+    ZSTD_CCtx* cctx;
+    ZSTD_DCtx* dctx;
+} compress_thread_state_t;
+
+static pthread_once_t compress_key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t compress_key;
+#endif
+
+// Internal helper functions
+#ifdef NETCHUNK_HAVE_ZSTD
+static void compress_key_init(void);
+static void compress_thread_state_free(void* state);
+static compress_thread_state_t* compress_thread_state(void);
+static netchunk_error_t zstd_compress(int level, const uint8_t* src, size_t size, uint8_t* dst, size_t capacity, size_t* written);
+static bool compress_pays_off(size_t stored_size, size_t size);
+#endif
+
+// Codec Functions
+
+bool netchunk_compress_available(netchunk_compression_t codec)
+{
+    switch (codec) {
+    case NETCHUNK_COMPRESSION_NONE:
+        return true;
+    case NETCHUNK_COMPRESSION_ZSTD:
+#ifdef NETCHUNK_HAVE_ZSTD
+        return true;
+#else
+        return false;
+#endif
+    default:
+        return false;
+    }
+}
+
+size_t netchunk_compress_bound(netchunk_compression_t codec, size_t size)
+{
+    switch (codec) {
+    case NETCHUNK_COMPRESSION_NONE:
+        return size;
+#ifdef NETCHUNK_HAVE_ZSTD
+    case NETCHUNK_COMPRESSION_ZSTD:
+        return ZSTD_compressBound(size);
+#endif
+    default:
+        return 0;
+    }
+}
+
+netchunk_error_t netchunk_compress(netchunk_compression_t codec,
+    int level,
+    const uint8_t* src,
+    size_t size,
+    uint8_t* dst,
+    size_t capacity,
+    size_t* stored_size)
+{
+    if (!src || !dst || !stored_size || size == 0) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    *stored_size = 0;
+
+    if (codec == NETCHUNK_COMPRESSION_NONE) {
+        return NETCHUNK_SUCCESS;
+    }
+    if (!netchunk_compress_available(codec) || capacity < netchunk_compress_bound(codec, size)) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+#ifdef NETCHUNK_HAVE_ZSTD
+    // Estimate the ratio from samples spread over the chunk before paying for all of it
+    size_t sample_span = (size_t)NETCHUNK_COMPRESS_SAMPLES * NETCHUNK_COMPRESS_SAMPLE_SIZE;
+    if (size >= 2 * sample_span) {
+        size_t sampled = 0;
+        size_t sampled_stored = 0;
+        size_t stride = size / NETCHUNK_COMPRESS_SAMPLES;
+
+        for (int i = 0; i < NETCHUNK_COMPRESS_SAMPLES; i++) {
+            size_t written;
+            netchunk_error_t error = zstd_compress(COMPRESS_SAMPLE_LEVEL, src + (size_t)i * stride,
+                NETCHUNK_COMPRESS_SAMPLE_SIZE, dst, capacity, &written);
+            if (error != NETCHUNK_SUCCESS) {
+                return error;
+            }
+            sampled += NETCHUNK_COMPRESS_SAMPLE_SIZE;
+            sampled_stored += written;
+        }
+
+        if (!compress_pays_off(sampled_stored, sampled)) {
+            return NETCHUNK_SUCCESS;
+        }
+    }
+
+    size_t written;
+    netchunk_error_t error = zstd_compress(level, src, size, dst, capacity, &written);
+    if (error != NETCHUNK_SUCCESS) {
+        return error;
+    }
+
+    if (compress_pays_off(written, size)) {
+        *stored_size = written;
+    }
+    return NETCHUNK_SUCCESS;
+#else
+    (void)level;
+    return NETCHUNK_ERROR_INVALID_ARGUMENT;
+#endif
+}
+
+netchunk_error_t netchunk_decompress(netchunk_compression_t codec,
+    const uint8_t* src,
+    size_t stored_size,
+    uint8_t* dst,
+    size_t size)
+{
+    if (!src || !dst) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    switch (codec) {
+    case NETCHUNK_COMPRESSION_NONE:
+        if (stored_size != size) {
+            return NETCHUNK_ERROR_CHUNK_INTEGRITY;
+        }
+        memcpy(dst, src, size);
+        return NETCHUNK_SUCCESS;
+#ifdef NETCHUNK_HAVE_ZSTD
+    case NETCHUNK_COMPRESSION_ZSTD: {
+        compress_thread_state_t* state = compress_thread_state();
+        if (!state) {
+            return NETCHUNK_ERROR_OUT_OF_MEMORY;
+        }
+        if (!state->dctx) {
+            state->dctx = ZSTD_createDCtx();
+            if (!state->dctx) {
+                return NETCHUNK_ERROR_OUT_OF_MEMORY;
+            }
+        }
+
+        size_t result = ZSTD_decompressDCtx(state->dctx, dst, size, src, stored_size);
+        if (ZSTD_isError(result) || result != size) {
+            return NETCHUNK_ERROR_CHUNK_INTEGRITY;
+        }
+        return NETCHUNK_SUCCESS;
+    }
+#endif
+    default:
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+}
+
+// Chunk Functions
+
+bool netchunk_chunk_is_encoded(const netchunk_chunk_t* chunk)
+{
+    return chunk && (chunk->codec != NETCHUNK_COMPRESSION_NONE || netchunk_key_id_is_set(chunk->key_id));
+}
+
+size_t netchunk_chunk_stored_size(const netchunk_chunk_t* chunk)
+{
+    if (!chunk) {
+        return 0;
+    }
+
+    return netchunk_chunk_is_encoded(chunk) ? chunk->stored_size : chunk->size;
+}
+
+netchunk_error_t netchunk_chunk_decode(const netchunk_chunk_t* chunk, uint8_t* raw)
+{
+    if (!chunk || !chunk->data || !raw) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    size_t stored_size = netchunk_chunk_stored_size(chunk);
+    if (!netchunk_key_id_is_set(chunk->key_id)) {
+        return netchunk_decompress(chunk->codec, chunk->data, stored_size, raw, chunk->size);
+    }
+    if (stored_size < NETCHUNK_CIPHER_OVERHEAD) {
+        return NETCHUNK_ERROR_CHUNK_INTEGRITY;
+    }
+
+    // Uncompressed plaintext goes straight to the output
+    size_t plain_size = stored_size - NETCHUNK_CIPHER_OVERHEAD;
+    if (chunk->codec == NETCHUNK_COMPRESSION_NONE) {
+        if (plain_size != chunk->size) {
+            return NETCHUNK_ERROR_CHUNK_INTEGRITY;
+        }
+        return netchunk_cipher_decrypt(chunk->key_id, chunk->id, chunk->data, stored_size, raw);
+    }
+
+    uint8_t* plain = malloc(plain_size > 0 ? plain_size : 1);
+    if (!plain) {
+        return NETCHUNK_ERROR_OUT_OF_MEMORY;
+    }
+
+    netchunk_error_t error = netchunk_cipher_decrypt(chunk->key_id, chunk->id, chunk->data, stored_size, plain);
+    if (error == NETCHUNK_SUCCESS) {
+        error = netchunk_decompress(chunk->codec, plain, plain_size, raw, chunk->size);
+    }
+    free(plain);
+    return error;
+}
+
+netchunk_error_t netchunk_chunk_verify_raw(const netchunk_chunk_t* chunk, const uint8_t* raw)
+{
+    if (!chunk || !raw) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    uint8_t computed[NETCHUNK_HASH_LENGTH];
+    netchunk_error_t error = netchunk_sha256_hash(raw, chunk->size, computed);
+    if (error != NETCHUNK_SUCCESS) {
+        return error;
+    }
+
+    return netchunk_hash_compare(chunk->hash, computed, NETCHUNK_HASH_LENGTH) ? NETCHUNK_SUCCESS : NETCHUNK_ERROR_CHUNK_INTEGRITY;
+}
+
+netchunk_error_t netchunk_chunk_restore_stored(netchunk_chunk_t* chunk, int level, uint8_t* raw)
+{
+    if (!chunk || !raw) {
+        free(raw);
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    bool encrypted = netchunk_key_id_is_set(chunk->key_id);
+    size_t trailer = encrypted ? NETCHUNK_CIPHER_OVERHEAD : 0;
+    uint8_t* stored = raw;
+    size_t plain_size = chunk->size;
+
+    if (chunk->codec != NETCHUNK_COMPRESSION_NONE) {
+        size_t capacity = netchunk_compress_bound(chunk->codec, chunk->size);
+        stored = capacity > 0 ? malloc(capacity + trailer) : NULL;
+        if (!stored) {
+            free(raw);
+            return NETCHUNK_ERROR_OUT_OF_MEMORY;
+        }
+
+        // Another valid stream of the same size decodes to the same bytes
+        netchunk_error_t error = netchunk_compress(chunk->codec, level, raw, chunk->size, stored, capacity, &plain_size);
+        free(raw);
+        if (error == NETCHUNK_SUCCESS && (plain_size == 0 || plain_size + trailer != chunk->stored_size)) {
+            error = NETCHUNK_ERROR_CHUNK_INTEGRITY;
+        }
+        if (error != NETCHUNK_SUCCESS) {
+            free(stored);
+            return error;
+        }
+    } else if (encrypted) {
+        if (chunk->size + trailer != chunk->stored_size) {
+            free(raw);
+            return NETCHUNK_ERROR_CHUNK_INTEGRITY;
+        }
+        stored = realloc(raw, chunk->size + trailer);
+        if (!stored) {
+            free(raw);
+            return NETCHUNK_ERROR_OUT_OF_MEMORY;
+        }
+    }
+
+    // A fresh nonce gives different bytes of the same size, equally valid
+    if (encrypted) {
+        netchunk_error_t error = netchunk_cipher_encrypt(chunk->key_id, chunk->id, stored, plain_size);
+        if (error != NETCHUNK_SUCCESS) {
+            free(stored);
+            return error;
+        }
+    }
+
+    chunk->data = stored;
+    chunk->data_owned = true;
+    return NETCHUNK_SUCCESS;
+}
+
+// Internal helper functions
+
+#ifdef NETCHUNK_HAVE_ZSTD
+/**
+ * @brief Whether stored_size saves enough over size to keep the compressed form
+ */
+static bool compress_pays_off(size_t stored_size, size_t size)
+{
+    return stored_size <= size / 100 * (100 - NETCHUNK_COMPRESS_MIN_SAVINGS);
+}
+
+static void compress_key_init(void)
+{
+    pthread_key_create(&compress_key, compress_thread_state_free);
+}
+
+static void compress_thread_state_free(void* arg)
+{
+    compress_thread_state_t* state = (compress_thread_state_t*)arg;
+    ZSTD_freeCCtx(state->cctx);
+    ZSTD_freeDCtx(state->dctx);
+    free(state);
+}
+
+/**
+ * @brief Get the calling thread's codec contexts, created on first use
+ */
+static compress_thread_state_t* compress_thread_state(void)
+{
+    pthread_once(&compress_key_once, compress_key_init);
+
+    compress_thread_state_t* state = pthread_getspecific(compress_key);
+    if (!state) {
+        state = calloc(1, sizeof(compress_thread_state_t));
+        if (state && pthread_setspecific(compress_key, state) != 0) {
+            free(state);
+            state = NULL;
+        }
+    }
+    return state;
+}
+
+static netchunk_error_t zstd_compress(int level, const uint8_t* src, size_t size, uint8_t* dst, size_t capacity, size_t* written)
+{
+    compress_thread_state_t* state = compress_thread_state();
+    if (!state) {
+        return NETCHUNK_ERROR_OUT_OF_MEMORY;
+    }
+    if (!state->cctx) {
+        state->cctx = ZSTD_createCCtx();
+        if (!state->cctx) {
+            return NETCHUNK_ERROR_OUT_OF_MEMORY;
+        }
+    }
+
+    size_t result = ZSTD_compressCCtx(state->cctx, dst, capacity, src, size, level);
+    if (ZSTD_isError(result)) {
+        return NETCHUNK_ERROR_UNKNOWN;
+    }
+
+    *written = result;
+    return NETCHUNK_SUCCESS;
+}
+#endif
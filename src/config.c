@@ -26,10 +26,22 @@ netchunk_error_t netchunk_config_init_defaults(netchunk_config_t* config)
 
     // General settings defaults
     config->chunk_size = NETCHUNK_DEFAULT_CHUNK_SIZE;
+    config->chunking_mode = NETCHUNK_CHUNKING_FIXED;
+    config->compression = NETCHUNK_COMPRESSION_NONE;
+    config->compression_level = NETCHUNK_DEFAULT_COMPRESSION_LEVEL;
+    config->content_addressed = false;
+    strcpy(config->dedup_index_path, "~/.netchunk/data/dedup-index.json");
     config->replication_factor = NETCHUNK_DEFAULT_REPLICATION_FACTOR;
     config->max_concurrent_operations = 4;
     config->ftp_timeout = 30;
+    config->connection_idle_timeout = 60;
+    config->hedge_budget_percent = 5;
     strcpy(config->local_storage_path, "~/.netchunk/data");
+    config->catalog_sync_interval = 60;
+    config->read_cache_size = NETCHUNK_DEFAULT_READ_CACHE_SIZE;
+    config->chunk_cache_size = 0;
+    strcpy(config->daemon_socket_path, "~/.netchunk/netchunk.sock");
+    config->background_delete = false;
     config->log_level = NETCHUNK_LOG_INFO;
     strcpy(config->log_file, "~/.netchunk/netchunk.log");
     config->health_monitoring_enabled = true;
@@ -43,17 +55,25 @@ netchunk_error_t netchunk_config_init_defaults(netchunk_config_t* config)
     config->max_repair_attempts = 3;
     config->repair_delay = 10;
     config->rebalancing_enabled = true;
+    config->scrub_interval = NETCHUNK_DEFAULT_SCRUB_INTERVAL;
+    config->scrub_bandwidth = NETCHUNK_DEFAULT_SCRUB_BANDWIDTH;
+    config->scrub_deep = true;
+    config->repair_workers = NETCHUNK_DEFAULT_REPAIR_WORKERS;
+    config->repair_max_per_server = NETCHUNK_DEFAULT_REPAIR_MAX_PER_SERVER;
+    config->repair_bandwidth = 0;
 
     // Monitoring settings defaults
     config->storage_alert_threshold = 85;
     config->latency_alert_threshold = 1000;
     config->performance_logging = false;
     strcpy(config->monitoring_data_path, "~/.netchunk/monitoring");
+    config->monitoring_format = NETCHUNK_MONITORING_PROMETHEUS;
 
     // Security settings defaults
     config->verify_ssl_certificates = true;
     config->always_verify_integrity = true;
     config->encrypt_chunks = false;
+    strcpy(config->encryption_key_file, "~/.netchunk/encryption.key");
 
     return NETCHUNK_SUCCESS;
 }
@@ -123,6 +143,40 @@ netchunk_error_t netchunk_config_validate(const netchunk_config_t* config)
         return NETCHUNK_ERROR_INSUFFICIENT_SERVERS;
     }
 
+    // Erasure coding needs both shard counts and a server for every shard of a stripe
+    if (config->erasure_data_shards != 0 || config->erasure_parity_shards != 0) {
+        if (config->erasure_data_shards < 1 || config->erasure_parity_shards < 1) {
+            return NETCHUNK_ERROR_CONFIG_VALIDATION;
+        }
+
+        // Stripes are built from the file's chunks, not from shared deduplicated ones
+        if (config->content_addressed) {
+            return NETCHUNK_ERROR_CONFIG_VALIDATION;
+        }
+
+        if (config->erasure_data_shards + config->erasure_parity_shards > config->server_count) {
+            return NETCHUNK_ERROR_INSUFFICIENT_SERVERS;
+        }
+    }
+
+    // Each compressed chunk has one stored form, recorded in the manifest that
+    // uploaded it; shared and striped chunks would need it to match elsewhere
+    if (config->compression != NETCHUNK_COMPRESSION_NONE) {
+        if (config->compression != NETCHUNK_COMPRESSION_ZSTD || config->compression_level < 1
+            || config->compression_level > NETCHUNK_MAX_COMPRESSION_LEVEL) {
+            return NETCHUNK_ERROR_CONFIG_VALIDATION;
+        }
+
+        if (config->content_addressed || config->erasure_data_shards > 0) {
+            return NETCHUNK_ERROR_CONFIG_VALIDATION;
+        }
+    }
+
+    // A deduplicated chunk is shared by files that may be encrypted differently
+    if (config->encrypt_chunks && config->content_addressed) {
+        return NETCHUNK_ERROR_CONFIG_VALIDATION;
+    }
+
     // Validate each server configuration
     for (int i = 0; i < config->server_count; i++) {
         const netchunk_server_t* server = &config->servers[i];
@@ -142,6 +196,10 @@ netchunk_error_t netchunk_config_validate(const netchunk_config_t* config)
         if (strlen(server->base_path) == 0) {
             return NETCHUNK_ERROR_CONFIG_VALIDATION;
         }
+
+        if (server->max_connections < 0 || server->max_connections > 32) {
+            return NETCHUNK_ERROR_CONFIG_VALIDATION;
+        }
     }
 
     // Validate other settings
@@ -153,10 +211,38 @@ netchunk_error_t netchunk_config_validate(const netchunk_config_t* config)
         return NETCHUNK_ERROR_CONFIG_VALIDATION;
     }
 
+    if (config->connection_idle_timeout < 5 || config->connection_idle_timeout > 3600) {
+        return NETCHUNK_ERROR_CONFIG_VALIDATION;
+    }
+
+    if (config->hedge_budget_percent < 0 || config->hedge_budget_percent > 100) {
+        return NETCHUNK_ERROR_CONFIG_VALIDATION;
+    }
+
+    if (config->catalog_sync_interval < 0 || config->catalog_sync_interval > 86400) {
+        return NETCHUNK_ERROR_CONFIG_VALIDATION;
+    }
+
+    if (config->read_cache_size > NETCHUNK_MAX_READ_CACHE_SIZE) {
+        return NETCHUNK_ERROR_CONFIG_VALIDATION;
+    }
+
     if (config->health_check_interval < 30 || config->health_check_interval > 3600) {
         return NETCHUNK_ERROR_CONFIG_VALIDATION;
     }
 
+    if (config->scrub_interval < 0) {
+        return NETCHUNK_ERROR_CONFIG_VALIDATION;
+    }
+
+    if (config->repair_workers < 1 || config->repair_workers > NETCHUNK_MAX_REPAIR_WORKERS) {
+        return NETCHUNK_ERROR_CONFIG_VALIDATION;
+    }
+
+    if (config->repair_max_per_server < 1) {
+        return NETCHUNK_ERROR_CONFIG_VALIDATION;
+    }
+
     return NETCHUNK_SUCCESS;
 }
 
@@ -270,6 +356,78 @@ const char* netchunk_log_level_to_string(netchunk_log_level_t level)
     }
 }
 
+netchunk_chunking_mode_t netchunk_chunking_mode_from_string(const char* mode_str)
+{
+    if (!mode_str) {
+        return NETCHUNK_CHUNKING_FIXED;
+    }
+
+    if (strcasecmp(mode_str, "cdc") == 0 || strcasecmp(mode_str, "content") == 0) {
+        return NETCHUNK_CHUNKING_CDC;
+    }
+
+    return NETCHUNK_CHUNKING_FIXED;
+}
+
+const char* netchunk_chunking_mode_to_string(netchunk_chunking_mode_t mode)
+{
+    switch (mode) {
+    case NETCHUNK_CHUNKING_CDC:
+        return "cdc";
+    case NETCHUNK_CHUNKING_FIXED:
+    default:
+        return "fixed";
+    }
+}
+
+netchunk_compression_t netchunk_compression_from_string(const char* codec_str)
+{
+    if (!codec_str) {
+        return NETCHUNK_COMPRESSION_NONE;
+    }
+
+    if (strcasecmp(codec_str, "zstd") == 0) {
+        return NETCHUNK_COMPRESSION_ZSTD;
+    }
+
+    return NETCHUNK_COMPRESSION_NONE;
+}
+
+const char* netchunk_compression_to_string(netchunk_compression_t codec)
+{
+    switch (codec) {
+    case NETCHUNK_COMPRESSION_ZSTD:
+        return "zstd";
+    case NETCHUNK_COMPRESSION_NONE:
+    default:
+        return "none";
+    }
+}
+
+netchunk_monitoring_format_t netchunk_monitoring_format_from_string(const char* format_str)
+{
+    if (!format_str) {
+        return NETCHUNK_MONITORING_PROMETHEUS;
+    }
+
+    if (strcasecmp(format_str, "json") == 0) {
+        return NETCHUNK_MONITORING_JSON;
+    }
+
+    return NETCHUNK_MONITORING_PROMETHEUS;
+}
+
+const char* netchunk_monitoring_format_to_string(netchunk_monitoring_format_t format)
+{
+    switch (format) {
+    case NETCHUNK_MONITORING_JSON:
+        return "json";
+    case NETCHUNK_MONITORING_PROMETHEUS:
+    default:
+        return "prometheus";
+    }
+}
+
 netchunk_error_t netchunk_config_expand_path(const char* path, char* expanded_path, size_t max_len)
 {
     if (!path || !expanded_path || max_len == 0) {
@@ -379,14 +537,42 @@ static netchunk_error_t parse_section(netchunk_config_t* config, const char* sec
     if (strcmp(section, "general") == 0) {
         if (strcmp(key, "chunk_size") == 0) {
             config->chunk_size = parse_size(value);
+        } else if (strcmp(key, "chunking") == 0) {
+            config->chunking_mode = netchunk_chunking_mode_from_string(value);
+        } else if (strcmp(key, "compression") == 0) {
+            config->compression = netchunk_compression_from_string(value);
+        } else if (strcmp(key, "compression_level") == 0) {
+            config->compression_level = (int)parse_int(value);
+        } else if (strcmp(key, "content_addressed") == 0) {
+            config->content_addressed = parse_bool(value);
+        } else if (strcmp(key, "dedup_index_path") == 0) {
+            strncpy(config->dedup_index_path, value, NETCHUNK_MAX_PATH_LEN - 1);
         } else if (strcmp(key, "replication_factor") == 0) {
             config->replication_factor = (int)parse_int(value);
+        } else if (strcmp(key, "erasure_data_shards") == 0) {
+            config->erasure_data_shards = (int)parse_int(value);
+        } else if (strcmp(key, "erasure_parity_shards") == 0) {
+            config->erasure_parity_shards = (int)parse_int(value);
         } else if (strcmp(key, "max_concurrent_operations") == 0) {
             config->max_concurrent_operations = (int)parse_int(value);
         } else if (strcmp(key, "ftp_timeout") == 0) {
             config->ftp_timeout = (int)parse_int(value);
+        } else if (strcmp(key, "connection_idle_timeout") == 0) {
+            config->connection_idle_timeout = (int)parse_int(value);
+        } else if (strcmp(key, "hedge_budget_percent") == 0) {
+            config->hedge_budget_percent = (int)parse_int(value);
         } else if (strcmp(key, "local_storage_path") == 0) {
             strncpy(config->local_storage_path, value, NETCHUNK_MAX_PATH_LEN - 1);
+        } else if (strcmp(key, "catalog_sync_interval") == 0) {
+            config->catalog_sync_interval = (int)parse_int(value);
+        } else if (strcmp(key, "read_cache_size") == 0) {
+            config->read_cache_size = parse_size(value);
+        } else if (strcmp(key, "chunk_cache_size") == 0) {
+            config->chunk_cache_size = parse_size(value);
+        } else if (strcmp(key, "daemon_socket_path") == 0) {
+            strncpy(config->daemon_socket_path, value, NETCHUNK_MAX_PATH_LEN - 1);
+        } else if (strcmp(key, "background_delete") == 0) {
+            config->background_delete = parse_bool(value);
         } else if (strcmp(key, "log_level") == 0) {
             config->log_level = netchunk_log_level_from_string(value);
         } else if (strcmp(key, "log_file") == 0) {
@@ -410,6 +596,11 @@ static netchunk_error_t parse_section(netchunk_config_t* config, const char* sec
 
         netchunk_server_t* server = &config->servers[server_num];
 
+        // Servers are identified by their section name in chunk locations
+        if (server->id[0] == '\0') {
+            snprintf(server->id, NETCHUNK_MAX_SERVER_ID_LEN, "%s", section);
+        }
+
         if (strcmp(key, "host") == 0) {
             strncpy(server->host, value, NETCHUNK_MAX_HOST_LEN - 1);
         } else if (strcmp(key, "port") == 0) {
@@ -426,6 +617,10 @@ static netchunk_error_t parse_section(netchunk_config_t* config, const char* sec
             server->passive_mode = parse_bool(value);
         } else if (strcmp(key, "priority") == 0) {
             server->priority = (int)parse_int(value);
+        } else if (strcmp(key, "max_connections") == 0) {
+            server->max_connections = (int)parse_int(value);
+        } else if (strcmp(key, "fxp") == 0) {
+            server->fxp = parse_bool(value);
         }
     } else if (strcmp(section, "repair") == 0) {
         if (strcmp(key, "auto_repair_enabled") == 0) {
@@ -436,6 +631,18 @@ static netchunk_error_t parse_section(netchunk_config_t* config, const char* sec
             config->repair_delay = (int)parse_int(value);
         } else if (strcmp(key, "rebalancing_enabled") == 0) {
             config->rebalancing_enabled = parse_bool(value);
+        } else if (strcmp(key, "scrub_interval") == 0) {
+            config->scrub_interval = (int)parse_int(value);
+        } else if (strcmp(key, "scrub_bandwidth") == 0) {
+            config->scrub_bandwidth = parse_size(value);
+        } else if (strcmp(key, "scrub_deep") == 0) {
+            config->scrub_deep = parse_bool(value);
+        } else if (strcmp(key, "repair_workers") == 0) {
+            config->repair_workers = (int)parse_int(value);
+        } else if (strcmp(key, "repair_max_per_server") == 0) {
+            config->repair_max_per_server = (int)parse_int(value);
+        } else if (strcmp(key, "repair_bandwidth") == 0) {
+            config->repair_bandwidth = parse_size(value);
         }
     } else if (strcmp(section, "monitoring") == 0) {
         if (strcmp(key, "storage_alert_threshold") == 0) {
@@ -446,6 +653,8 @@ static netchunk_error_t parse_section(netchunk_config_t* config, const char* sec
             config->performance_logging = parse_bool(value);
         } else if (strcmp(key, "monitoring_data_path") == 0) {
             strncpy(config->monitoring_data_path, value, NETCHUNK_MAX_PATH_LEN - 1);
+        } else if (strcmp(key, "monitoring_format") == 0) {
+            config->monitoring_format = netchunk_monitoring_format_from_string(value);
         }
     } else if (strcmp(section, "security") == 0) {
         if (strcmp(key, "verify_ssl_certificates") == 0) {
@@ -454,6 +663,8 @@ static netchunk_error_t parse_section(netchunk_config_t* config, const char* sec
             config->always_verify_integrity = parse_bool(value);
         } else if (strcmp(key, "encrypt_chunks") == 0) {
             config->encrypt_chunks = parse_bool(value);
+        } else if (strcmp(key, "encryption_key_file") == 0) {
+            strncpy(config->encryption_key_file, value, NETCHUNK_MAX_PATH_LEN - 1);
         }
     }
     // Ignore unknown sections/keys for forward compatibility
@@ -1,10 +1,31 @@
 #include "crypto.h"
 #include <fcntl.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 
+// Hardware backends are built with per-function target attributes, so the
+// rest of the library keeps the baseline instruction set
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define NETCHUNK_SHA256_HAVE_X86 1
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+#if defined(__GNUC__) && defined(__aarch64__) && defined(__linux__)
+#define NETCHUNK_SHA256_HAVE_ARMV8 1
+#include <arm_neon.h>
+#include <asm/hwcap.h>
+#include <sys/auxv.h>
+#if defined(__clang__)
+#define NETCHUNK_SHA256_ARMV8_TARGET __attribute__((target("sha2")))
+#else
+#define NETCHUNK_SHA256_ARMV8_TARGET __attribute__((target("+crypto")))
+#endif
+#endif
+
 // SHA-256 constants
 static const uint32_t SHA256_K[64] = {
     0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
@@ -21,8 +42,30 @@ static const uint32_t SHA256_H0[8] = {
     0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
 };
 
+// Compress whole 64-byte blocks into the state
+typedef void (*sha256_blocks_fn)(uint32_t state[8], const uint8_t* data, size_t blocks);
+
+// Active backends, detected once on first use
+static pthread_once_t sha256_dispatch_once = PTHREAD_ONCE_INIT;
+static sha256_blocks_fn sha256_blocks = NULL;
+static netchunk_sha256_backend_t sha256_single_backend = NETCHUNK_SHA256_BACKEND_GENERIC;
+static netchunk_sha256_backend_t sha256_batch_backend = NETCHUNK_SHA256_BACKEND_GENERIC;
+
 // Internal helper functions
-static void sha256_transform(netchunk_sha256_context_t* context, const uint8_t data[64]);
+static void sha256_dispatch_init(void);
+static void sha256_dispatch_ensure(void);
+static sha256_blocks_fn sha256_backend_blocks(netchunk_sha256_backend_t backend);
+static void sha256_blocks_generic(uint32_t state[8], const uint8_t* data, size_t blocks);
+#ifdef NETCHUNK_SHA256_HAVE_X86
+static void sha256_blocks_shani(uint32_t state[8], const uint8_t* data, size_t blocks);
+static void sha256_lanes_avx2(const uint8_t* const* data, const size_t* data_len, size_t count, uint8_t* const* hashes);
+static size_t sha256_pad_tail(const uint8_t* data, size_t data_len, uint8_t tail[NETCHUNK_SHA256_BLOCK_SIZE * 2]);
+static bool sha256_cpu_has_shani(void);
+static bool sha256_cpu_has_avx2(void);
+#endif
+#ifdef NETCHUNK_SHA256_HAVE_ARMV8
+static void sha256_blocks_armv8(uint32_t state[8], const uint8_t* data, size_t blocks);
+#endif
 static uint32_t sha256_rotr(uint32_t value, uint32_t amount);
 static uint32_t sha256_choose(uint32_t x, uint32_t y, uint32_t z);
 static uint32_t sha256_majority(uint32_t x, uint32_t y, uint32_t z);
@@ -39,6 +82,8 @@ netchunk_error_t netchunk_sha256_init(netchunk_sha256_context_t* context)
         return NETCHUNK_ERROR_INVALID_ARGUMENT;
     }
 
+    sha256_dispatch_ensure();
+
     context->count = 0;
     memcpy(context->state, SHA256_H0, sizeof(SHA256_H0));
     memset(context->buffer, 0, sizeof(context->buffer));
@@ -67,15 +112,16 @@ netchunk_error_t netchunk_sha256_update(netchunk_sha256_context_t* context,
     // If we have data in buffer and new data fills it
     if (buffer_space <= input_len) {
         memcpy(context->buffer + (NETCHUNK_SHA256_BLOCK_SIZE - buffer_space), input, buffer_space);
-        sha256_transform(context, context->buffer);
+        sha256_blocks(context->state, context->buffer, 1);
         input += buffer_space;
         input_len -= buffer_space;
 
-        // Process complete 64-byte blocks
-        while (input_len >= NETCHUNK_SHA256_BLOCK_SIZE) {
-            sha256_transform(context, input);
-            input += NETCHUNK_SHA256_BLOCK_SIZE;
-            input_len -= NETCHUNK_SHA256_BLOCK_SIZE;
+        // Process complete 64-byte blocks in one backend call
+        size_t blocks = input_len / NETCHUNK_SHA256_BLOCK_SIZE;
+        if (blocks > 0) {
+            sha256_blocks(context->state, input, blocks);
+            input += blocks * NETCHUNK_SHA256_BLOCK_SIZE;
+            input_len -= blocks * NETCHUNK_SHA256_BLOCK_SIZE;
         }
 
         // Store remaining data in buffer
@@ -104,7 +150,7 @@ netchunk_error_t netchunk_sha256_final(netchunk_sha256_context_t* context,
     // If we don't have room for the length, pad and transform
     if (buffer_pos > 56) {
         memset(context->buffer + buffer_pos, 0, NETCHUNK_SHA256_BLOCK_SIZE - buffer_pos);
-        sha256_transform(context, context->buffer);
+        sha256_blocks(context->state, context->buffer, 1);
         memset(context->buffer, 0, 56);
     } else {
         memset(context->buffer + buffer_pos, 0, 56 - buffer_pos);
@@ -114,7 +160,7 @@ netchunk_error_t netchunk_sha256_final(netchunk_sha256_context_t* context,
     uint32_to_bytes((uint32_t)(bit_len >> 32), context->buffer + 56);
     uint32_to_bytes((uint32_t)(bit_len & 0xffffffff), context->buffer + 60);
 
-    sha256_transform(context, context->buffer);
+    sha256_blocks(context->state, context->buffer, 1);
 
     // Produce the final hash value in big-endian format
     for (int i = 0; i < 8; i++) {
@@ -198,6 +244,124 @@ netchunk_error_t netchunk_sha256_hash_file(const char* file_path,
     return NETCHUNK_SUCCESS;
 }
 
+netchunk_error_t netchunk_sha256_hash_batch(const uint8_t* const* data,
+    const size_t* data_len,
+    size_t count,
+    uint8_t* const* hashes)
+{
+    if (!data || !data_len || !hashes) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        if (!data[i] || !hashes[i]) {
+            return NETCHUNK_ERROR_INVALID_ARGUMENT;
+        }
+    }
+
+    sha256_dispatch_ensure();
+
+#ifdef NETCHUNK_SHA256_HAVE_X86
+    if (sha256_batch_backend == NETCHUNK_SHA256_BACKEND_AVX2) {
+        for (size_t first = 0; first < count; first += NETCHUNK_SHA256_MAX_LANES) {
+            size_t lanes = count - first;
+            if (lanes > NETCHUNK_SHA256_MAX_LANES) {
+                lanes = NETCHUNK_SHA256_MAX_LANES;
+            }
+            sha256_lanes_avx2(data + first, data_len + first, lanes, hashes + first);
+        }
+        return NETCHUNK_SUCCESS;
+    }
+#endif
+
+    for (size_t i = 0; i < count; i++) {
+        netchunk_error_t error = netchunk_sha256_hash(data[i], data_len[i], hashes[i]);
+        if (error != NETCHUNK_SUCCESS) {
+            return error;
+        }
+    }
+
+    return NETCHUNK_SUCCESS;
+}
+
+// Backend Selection
+
+bool netchunk_sha256_backend_available(netchunk_sha256_backend_t backend)
+{
+    switch (backend) {
+    case NETCHUNK_SHA256_BACKEND_AUTO:
+    case NETCHUNK_SHA256_BACKEND_GENERIC:
+        return true;
+#ifdef NETCHUNK_SHA256_HAVE_X86
+    case NETCHUNK_SHA256_BACKEND_SHANI:
+        return sha256_cpu_has_shani();
+    case NETCHUNK_SHA256_BACKEND_AVX2:
+        return sha256_cpu_has_avx2();
+#endif
+#ifdef NETCHUNK_SHA256_HAVE_ARMV8
+    case NETCHUNK_SHA256_BACKEND_ARMV8:
+        return (getauxval(AT_HWCAP) & HWCAP_SHA2) != 0;
+#endif
+    default:
+        return false;
+    }
+}
+
+netchunk_error_t netchunk_sha256_set_backend(netchunk_sha256_backend_t backend)
+{
+    if (backend < NETCHUNK_SHA256_BACKEND_AUTO || backend >= NETCHUNK_SHA256_BACKEND_COUNT) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    if (!netchunk_sha256_backend_available(backend)) {
+        return NETCHUNK_ERROR_CRYPTO;
+    }
+
+    sha256_dispatch_ensure();
+
+    if (backend == NETCHUNK_SHA256_BACKEND_AUTO) {
+        sha256_dispatch_init();
+    } else if (backend == NETCHUNK_SHA256_BACKEND_AVX2) {
+        sha256_batch_backend = backend;
+    } else {
+        sha256_single_backend = backend;
+        sha256_batch_backend = backend;
+        sha256_blocks = sha256_backend_blocks(backend);
+    }
+
+    return NETCHUNK_SUCCESS;
+}
+
+netchunk_sha256_backend_t netchunk_sha256_get_backend(void)
+{
+    sha256_dispatch_ensure();
+    return sha256_single_backend;
+}
+
+netchunk_sha256_backend_t netchunk_sha256_get_batch_backend(void)
+{
+    sha256_dispatch_ensure();
+    return sha256_batch_backend;
+}
+
+const char* netchunk_sha256_backend_name(netchunk_sha256_backend_t backend)
+{
+    switch (backend) {
+    case NETCHUNK_SHA256_BACKEND_AUTO:
+        return "auto";
+    case NETCHUNK_SHA256_BACKEND_GENERIC:
+        return "generic";
+    case NETCHUNK_SHA256_BACKEND_SHANI:
+        return "sha-ni";
+    case NETCHUNK_SHA256_BACKEND_ARMV8:
+        return "armv8-sha2";
+    case NETCHUNK_SHA256_BACKEND_AVX2:
+        return "avx2-multibuffer";
+    default:
+        return "unknown";
+    }
+}
+
 // Utility Functions
 
 netchunk_error_t netchunk_hash_to_hex_string(const uint8_t* hash,
@@ -258,10 +422,14 @@ bool netchunk_hash_compare(const uint8_t* hash1,
 netchunk_error_t netchunk_generate_random_bytes(uint8_t* buffer,
     size_t buffer_size)
 {
-    if (!buffer || buffer_size == 0) {
+    if (!buffer) {
         return NETCHUNK_ERROR_INVALID_ARGUMENT;
     }
 
+    if (buffer_size == 0) {
+        return NETCHUNK_SUCCESS;
+    }
+
     // Try to use /dev/urandom first
     int fd = open("/dev/urandom", O_RDONLY);
     if (fd != -1) {
@@ -291,59 +459,6 @@ netchunk_error_t netchunk_generate_random_bytes(uint8_t* buffer,
 
 // Internal helper function implementations
 
-static void sha256_transform(netchunk_sha256_context_t* context, const uint8_t data[64])
-{
-    uint32_t w[64];
-    uint32_t a, b, c, d, e, f, g, h;
-    uint32_t t1, t2;
-
-    // Copy chunk into first 16 words W[0..15] of the message schedule array
-    for (int i = 0; i < 16; i++) {
-        w[i] = bytes_to_uint32(data + (i * 4));
-    }
-
-    // Extend the first 16 words into the remaining 48 words W[16..63] of the message schedule array
-    for (int i = 16; i < 64; i++) {
-        uint32_t s0 = sha256_rotr(w[i - 15], 7) ^ sha256_rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
-        uint32_t s1 = sha256_rotr(w[i - 2], 17) ^ sha256_rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
-        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
-    }
-
-    // Initialize hash value for this chunk
-    a = context->state[0];
-    b = context->state[1];
-    c = context->state[2];
-    d = context->state[3];
-    e = context->state[4];
-    f = context->state[5];
-    g = context->state[6];
-    h = context->state[7];
-
-    // Main loop
-    for (int i = 0; i < 64; i++) {
-        t1 = h + sha256_sig1(e) + sha256_choose(e, f, g) + SHA256_K[i] + w[i];
-        t2 = sha256_sig0(a) + sha256_majority(a, b, c);
-        h = g;
-        g = f;
-        f = e;
-        e = d + t1;
-        d = c;
-        c = b;
-        b = a;
-        a = t1 + t2;
-    }
-
-    // Add the compressed chunk to the current hash value
-    context->state[0] += a;
-    context->state[1] += b;
-    context->state[2] += c;
-    context->state[3] += d;
-    context->state[4] += e;
-    context->state[5] += f;
-    context->state[6] += g;
-    context->state[7] += h;
-}
-
 static uint32_t sha256_rotr(uint32_t value, uint32_t amount)
 {
     return (value >> amount) | (value << (32 - amount));
@@ -381,3 +496,391 @@ static uint32_t bytes_to_uint32(const uint8_t* bytes)
 {
     return ((uint32_t)bytes[0] << 24) | ((uint32_t)bytes[1] << 16) | ((uint32_t)bytes[2] << 8) | (uint32_t)bytes[3];
 }
+
+// SHA-256 backend implementations
+
+static void sha256_blocks_generic(uint32_t state[8], const uint8_t* data, size_t blocks)
+{
+    uint32_t w[64];
+    uint32_t a, b, c, d, e, f, g, h;
+    uint32_t t1, t2;
+
+    for (; blocks > 0; blocks--, data += NETCHUNK_SHA256_BLOCK_SIZE) {
+        // Copy chunk into first 16 words W[0..15] of the message schedule array
+        for (int i = 0; i < 16; i++) {
+            w[i] = bytes_to_uint32(data + (i * 4));
+        }
+
+        // Extend the first 16 words into the remaining 48 words W[16..63] of the message schedule array
+        for (int i = 16; i < 64; i++) {
+            uint32_t s0 = sha256_rotr(w[i - 15], 7) ^ sha256_rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            uint32_t s1 = sha256_rotr(w[i - 2], 17) ^ sha256_rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+
+        // Initialize hash value for this chunk
+        a = state[0];
+        b = state[1];
+        c = state[2];
+        d = state[3];
+        e = state[4];
+        f = state[5];
+        g = state[6];
+        h = state[7];
+
+        // Main loop
+        for (int i = 0; i < 64; i++) {
+            t1 = h + sha256_sig1(e) + sha256_choose(e, f, g) + SHA256_K[i] + w[i];
+            t2 = sha256_sig0(a) + sha256_majority(a, b, c);
+            h = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + t2;
+        }
+
+        // Add the compressed chunk to the current hash value
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+        state[5] += f;
+        state[6] += g;
+        state[7] += h;
+    }
+}
+
+#ifdef NETCHUNK_SHA256_HAVE_X86
+
+__attribute__((target("sha,sse4.1"))) static void sha256_blocks_shani(uint32_t state[8], const uint8_t* data, size_t blocks)
+{
+    const __m128i byte_swap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+    __m128i w[16];
+
+    // The SHA instructions keep the state as ABEF and CDGH
+    __m128i tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)&state[0]), 0xB1);
+    __m128i state1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)&state[4]), 0x1B);
+    __m128i state0 = _mm_alignr_epi8(tmp, state1, 8);
+    state1 = _mm_blend_epi16(state1, tmp, 0xF0);
+
+    for (; blocks > 0; blocks--, data += NETCHUNK_SHA256_BLOCK_SIZE) {
+        __m128i abef_save = state0;
+        __m128i cdgh_save = state1;
+
+        for (int i = 0; i < 4; i++) {
+            w[i] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data + (i * 16))), byte_swap);
+        }
+        for (int i = 4; i < 16; i++) {
+            __m128i schedule = _mm_sha256msg1_epu32(w[i - 4], w[i - 3]);
+            schedule = _mm_add_epi32(schedule, _mm_alignr_epi8(w[i - 1], w[i - 2], 4));
+            w[i] = _mm_sha256msg2_epu32(schedule, w[i - 1]);
+        }
+
+        // Four rounds per iteration, two per sha256rnds2
+        for (int i = 0; i < 16; i++) {
+            __m128i message = _mm_add_epi32(w[i], _mm_loadu_si128((const __m128i*)&SHA256_K[i * 4]));
+            state1 = _mm_sha256rnds2_epu32(state1, state0, message);
+            message = _mm_shuffle_epi32(message, 0x0E);
+            state0 = _mm_sha256rnds2_epu32(state0, state1, message);
+        }
+
+        state0 = _mm_add_epi32(state0, abef_save);
+        state1 = _mm_add_epi32(state1, cdgh_save);
+    }
+
+    // Back to ABCD and EFGH
+    tmp = _mm_shuffle_epi32(state0, 0x1B);
+    state1 = _mm_shuffle_epi32(state1, 0xB1);
+    state0 = _mm_blend_epi16(tmp, state1, 0xF0);
+    state1 = _mm_alignr_epi8(state1, tmp, 8);
+
+    _mm_storeu_si128((__m128i*)&state[0], state0);
+    _mm_storeu_si128((__m128i*)&state[4], state1);
+}
+
+/**
+ * @brief Build the padded final block(s) of a message
+ * @return Number of tail blocks written (1 or 2)
+ */
+static size_t sha256_pad_tail(const uint8_t* data, size_t data_len, uint8_t tail[NETCHUNK_SHA256_BLOCK_SIZE * 2])
+{
+    size_t remainder = data_len % NETCHUNK_SHA256_BLOCK_SIZE;
+    size_t tail_blocks = (remainder + 9 > NETCHUNK_SHA256_BLOCK_SIZE) ? 2 : 1;
+    size_t tail_len = tail_blocks * NETCHUNK_SHA256_BLOCK_SIZE;
+    uint64_t bit_len = (uint64_t)data_len * 8;
+
+    memset(tail, 0, tail_len);
+    if (remainder > 0) {
+        memcpy(tail, data + (data_len - remainder), remainder);
+    }
+    tail[remainder] = 0x80;
+    uint32_to_bytes((uint32_t)(bit_len >> 32), tail + tail_len - 8);
+    uint32_to_bytes((uint32_t)(bit_len & 0xffffffff), tail + tail_len - 4);
+
+    return tail_blocks;
+}
+
+__attribute__((target("avx2"))) static inline __m256i sha256_avx2_rotr(__m256i x, int n)
+{
+    return _mm256_or_si256(_mm256_srli_epi32(x, n), _mm256_slli_epi32(x, 32 - n));
+}
+
+/**
+ * @brief Load one block from each of eight lanes as eight words per vector
+ */
+__attribute__((target("avx2"))) static void sha256_avx2_load_block(__m256i w[16], const uint8_t* const blocks[8])
+{
+    const __m256i byte_swap = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+        3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+
+    for (int half = 0; half < 2; half++) {
+        __m256i r[8];
+        for (int lane = 0; lane < 8; lane++) {
+            r[lane] = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)(blocks[lane] + (half * 32))), byte_swap);
+        }
+
+        // 8x8 transpose of 32-bit words: lane-major to word-major
+        __m256i t0 = _mm256_unpacklo_epi32(r[0], r[1]);
+        __m256i t1 = _mm256_unpackhi_epi32(r[0], r[1]);
+        __m256i t2 = _mm256_unpacklo_epi32(r[2], r[3]);
+        __m256i t3 = _mm256_unpackhi_epi32(r[2], r[3]);
+        __m256i t4 = _mm256_unpacklo_epi32(r[4], r[5]);
+        __m256i t5 = _mm256_unpackhi_epi32(r[4], r[5]);
+        __m256i t6 = _mm256_unpacklo_epi32(r[6], r[7]);
+        __m256i t7 = _mm256_unpackhi_epi32(r[6], r[7]);
+
+        __m256i u0 = _mm256_unpacklo_epi64(t0, t2);
+        __m256i u1 = _mm256_unpackhi_epi64(t0, t2);
+        __m256i u2 = _mm256_unpacklo_epi64(t1, t3);
+        __m256i u3 = _mm256_unpackhi_epi64(t1, t3);
+        __m256i u4 = _mm256_unpacklo_epi64(t4, t6);
+        __m256i u5 = _mm256_unpackhi_epi64(t4, t6);
+        __m256i u6 = _mm256_unpacklo_epi64(t5, t7);
+        __m256i u7 = _mm256_unpackhi_epi64(t5, t7);
+
+        __m256i* out = w + (half * 8);
+        out[0] = _mm256_permute2x128_si256(u0, u4, 0x20);
+        out[1] = _mm256_permute2x128_si256(u1, u5, 0x20);
+        out[2] = _mm256_permute2x128_si256(u2, u6, 0x20);
+        out[3] = _mm256_permute2x128_si256(u3, u7, 0x20);
+        out[4] = _mm256_permute2x128_si256(u0, u4, 0x31);
+        out[5] = _mm256_permute2x128_si256(u1, u5, 0x31);
+        out[6] = _mm256_permute2x128_si256(u2, u6, 0x31);
+        out[7] = _mm256_permute2x128_si256(u3, u7, 0x31);
+    }
+}
+
+/**
+ * @brief Hash up to eight messages side by side, one per 32-bit vector lane
+ */
+__attribute__((target("avx2"))) static void sha256_lanes_avx2(const uint8_t* const* data,
+    const size_t* data_len,
+    size_t count,
+    uint8_t* const* hashes)
+{
+    static const uint8_t idle_block[NETCHUNK_SHA256_BLOCK_SIZE] = { 0 };
+    uint8_t tails[8][NETCHUNK_SHA256_BLOCK_SIZE * 2];
+    size_t full_blocks[8] = { 0 };
+    int32_t total_blocks[8] = { 0 };
+    size_t max_blocks = 0;
+
+    for (size_t lane = 0; lane < count; lane++) {
+        full_blocks[lane] = data_len[lane] / NETCHUNK_SHA256_BLOCK_SIZE;
+        total_blocks[lane] = (int32_t)(full_blocks[lane] + sha256_pad_tail(data[lane], data_len[lane], tails[lane]));
+        if ((size_t)total_blocks[lane] > max_blocks) {
+            max_blocks = (size_t)total_blocks[lane];
+        }
+    }
+
+    __m256i state[8];
+    for (int i = 0; i < 8; i++) {
+        state[i] = _mm256_set1_epi32((int32_t)SHA256_H0[i]);
+    }
+    const __m256i lane_blocks = _mm256_loadu_si256((const __m256i*)total_blocks);
+
+    for (size_t block = 0; block < max_blocks; block++) {
+        // Lanes that ran out of blocks hash a dummy block and keep their state
+        const uint8_t* blocks[8];
+        for (size_t lane = 0; lane < 8; lane++) {
+            if (lane >= count || block >= (size_t)total_blocks[lane]) {
+                blocks[lane] = idle_block;
+            } else if (block < full_blocks[lane]) {
+                blocks[lane] = data[lane] + (block * NETCHUNK_SHA256_BLOCK_SIZE);
+            } else {
+                blocks[lane] = tails[lane] + ((block - full_blocks[lane]) * NETCHUNK_SHA256_BLOCK_SIZE);
+            }
+        }
+        const __m256i active = _mm256_cmpgt_epi32(lane_blocks, _mm256_set1_epi32((int32_t)block));
+
+        __m256i w[16];
+        sha256_avx2_load_block(w, blocks);
+
+        __m256i a = state[0], b = state[1], c = state[2], d = state[3];
+        __m256i e = state[4], f = state[5], g = state[6], h = state[7];
+
+        for (int i = 0; i < 64; i++) {
+            // Message schedule kept in a 16-entry ring
+            if (i >= 16) {
+                __m256i w15 = w[(i - 15) & 15];
+                __m256i w2 = w[(i - 2) & 15];
+                __m256i s0 = _mm256_xor_si256(_mm256_xor_si256(sha256_avx2_rotr(w15, 7), sha256_avx2_rotr(w15, 18)),
+                    _mm256_srli_epi32(w15, 3));
+                __m256i s1 = _mm256_xor_si256(_mm256_xor_si256(sha256_avx2_rotr(w2, 17), sha256_avx2_rotr(w2, 19)),
+                    _mm256_srli_epi32(w2, 10));
+                w[i & 15] = _mm256_add_epi32(_mm256_add_epi32(w[i & 15], s0), _mm256_add_epi32(w[(i - 7) & 15], s1));
+            }
+
+            __m256i sig1 = _mm256_xor_si256(_mm256_xor_si256(sha256_avx2_rotr(e, 6), sha256_avx2_rotr(e, 11)),
+                sha256_avx2_rotr(e, 25));
+            __m256i choose = _mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g));
+            __m256i t1 = _mm256_add_epi32(_mm256_add_epi32(h, sig1),
+                _mm256_add_epi32(_mm256_add_epi32(choose, _mm256_set1_epi32((int32_t)SHA256_K[i])), w[i & 15]));
+            __m256i sig0 = _mm256_xor_si256(_mm256_xor_si256(sha256_avx2_rotr(a, 2), sha256_avx2_rotr(a, 13)),
+                sha256_avx2_rotr(a, 22));
+            __m256i majority = _mm256_xor_si256(_mm256_xor_si256(_mm256_and_si256(a, b), _mm256_and_si256(a, c)),
+                _mm256_and_si256(b, c));
+            __m256i t2 = _mm256_add_epi32(sig0, majority);
+
+            h = g;
+            g = f;
+            f = e;
+            e = _mm256_add_epi32(d, t1);
+            d = c;
+            c = b;
+            b = a;
+            a = _mm256_add_epi32(t1, t2);
+        }
+
+        __m256i rounds[8] = { a, b, c, d, e, f, g, h };
+        for (int i = 0; i < 8; i++) {
+            state[i] = _mm256_blendv_epi8(state[i], _mm256_add_epi32(state[i], rounds[i]), active);
+        }
+    }
+
+    uint32_t words[8][8];
+    for (int i = 0; i < 8; i++) {
+        _mm256_storeu_si256((__m256i*)words[i], state[i]);
+    }
+    for (size_t lane = 0; lane < count; lane++) {
+        for (int i = 0; i < 8; i++) {
+            uint32_to_bytes(words[i][lane], hashes[lane] + (i * 4));
+        }
+    }
+}
+
+static bool sha256_cpu_has_shani(void)
+{
+    unsigned int eax, ebx, ecx, edx;
+
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || !(ecx & bit_SSE4_1) || !(ecx & bit_SSSE3)) {
+        return false;
+    }
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+        return false;
+    }
+    return (ebx & (1u << 29)) != 0; // SHA
+}
+
+static bool sha256_cpu_has_avx2(void)
+{
+    unsigned int eax, ebx, ecx, edx;
+
+    // AVX2 also needs the OS to save YMM registers
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || !(ecx & bit_OSXSAVE) || !(ecx & bit_AVX)) {
+        return false;
+    }
+    unsigned int xcr0_low, xcr0_high;
+    __asm__ volatile("xgetbv" : "=a"(xcr0_low), "=d"(xcr0_high) : "c"(0));
+    (void)xcr0_high;
+    if ((xcr0_low & 0x6) != 0x6) {
+        return false;
+    }
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+        return false;
+    }
+    return (ebx & bit_AVX2) != 0;
+}
+
+#endif // NETCHUNK_SHA256_HAVE_X86
+
+#ifdef NETCHUNK_SHA256_HAVE_ARMV8
+
+NETCHUNK_SHA256_ARMV8_TARGET static void sha256_blocks_armv8(uint32_t state[8], const uint8_t* data, size_t blocks)
+{
+    uint32x4_t state0 = vld1q_u32(&state[0]);
+    uint32x4_t state1 = vld1q_u32(&state[4]);
+    uint32x4_t w[16];
+
+    for (; blocks > 0; blocks--, data += NETCHUNK_SHA256_BLOCK_SIZE) {
+        uint32x4_t abcd_save = state0;
+        uint32x4_t efgh_save = state1;
+
+        for (int i = 0; i < 4; i++) {
+            w[i] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data + (i * 16))));
+        }
+        for (int i = 4; i < 16; i++) {
+            w[i] = vsha256su1q_u32(vsha256su0q_u32(w[i - 4], w[i - 3]), w[i - 2], w[i - 1]);
+        }
+
+        // Four rounds per iteration
+        for (int i = 0; i < 16; i++) {
+            uint32x4_t message = vaddq_u32(w[i], vld1q_u32(&SHA256_K[i * 4]));
+            uint32x4_t abcd = state0;
+            state0 = vsha256hq_u32(state0, state1, message);
+            state1 = vsha256h2q_u32(state1, abcd, message);
+        }
+
+        state0 = vaddq_u32(state0, abcd_save);
+        state1 = vaddq_u32(state1, efgh_save);
+    }
+
+    vst1q_u32(&state[0], state0);
+    vst1q_u32(&state[4], state1);
+}
+
+#endif // NETCHUNK_SHA256_HAVE_ARMV8
+
+// Backend dispatch
+
+static sha256_blocks_fn sha256_backend_blocks(netchunk_sha256_backend_t backend)
+{
+    switch (backend) {
+#ifdef NETCHUNK_SHA256_HAVE_X86
+    case NETCHUNK_SHA256_BACKEND_SHANI:
+        return sha256_blocks_shani;
+#endif
+#ifdef NETCHUNK_SHA256_HAVE_ARMV8
+    case NETCHUNK_SHA256_BACKEND_ARMV8:
+        return sha256_blocks_armv8;
+#endif
+    default:
+        return sha256_blocks_generic;
+    }
+}
+
+static void sha256_dispatch_init(void)
+{
+    sha256_single_backend = NETCHUNK_SHA256_BACKEND_GENERIC;
+    if (netchunk_sha256_backend_available(NETCHUNK_SHA256_BACKEND_SHANI)) {
+        sha256_single_backend = NETCHUNK_SHA256_BACKEND_SHANI;
+    } else if (netchunk_sha256_backend_available(NETCHUNK_SHA256_BACKEND_ARMV8)) {
+        sha256_single_backend = NETCHUNK_SHA256_BACKEND_ARMV8;
+    }
+    sha256_blocks = sha256_backend_blocks(sha256_single_backend);
+
+    // Multi-buffer AVX2 only beats a scalar loop when there are no SHA instructions
+    sha256_batch_backend = sha256_single_backend;
+    if (sha256_single_backend == NETCHUNK_SHA256_BACKEND_GENERIC
+        && netchunk_sha256_backend_available(NETCHUNK_SHA256_BACKEND_AVX2)) {
+        sha256_batch_backend = NETCHUNK_SHA256_BACKEND_AVX2;
+    }
+}
+
+static void sha256_dispatch_ensure(void)
+{
+    pthread_once(&sha256_dispatch_once, sha256_dispatch_init);
+}
@@ -0,0 +1,908 @@
+/**
+ * @file daemon.c
+ * @brief Background daemon and thin client over a Unix socket
+ *
+ * The daemon keeps one NetChunk context initialized so that connection
+ * setup is paid once rather than per CLI invocation. Each client connection
+ * carries a single request: a fixed-size request record, optionally with an
+ * open file descriptor attached (SCM_RIGHTS), answered by any number of
+ * progress records followed by one result record.
+ */
+
+#define _GNU_SOURCE // pipe2, accept4
+
+#include "daemon.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#define DAEMON_MAGIC 0x4e434b44 // "NCKD"
+#define DAEMON_LISTEN_BACKLOG 64
+#define DAEMON_FLAG_REPAIR 0x1
+
+// Request types
+typedef enum daemon_command {
+    DAEMON_CMD_UPLOAD = 1,
+    DAEMON_CMD_DOWNLOAD = 2,
+    DAEMON_CMD_LIST = 3,
+    DAEMON_CMD_DELETE = 4,
+    DAEMON_CMD_VERIFY = 5,
+    DAEMON_CMD_HEALTH = 6,
+    DAEMON_CMD_SHUTDOWN = 7
+} daemon_command_t;
+
+// Response record types
+typedef enum daemon_message_type {
+    DAEMON_MSG_PROGRESS = 1,
+    DAEMON_MSG_RESULT = 2
+} daemon_message_type_t;
+
+// Client -> daemon
+typedef struct daemon_request {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t command; // daemon_command_t
+    uint32_t flags; // DAEMON_FLAG_*
+    char remote_name[NETCHUNK_MAX_PATH_LEN];
+} daemon_request_t;
+
+// Daemon -> client, progress or final result
+typedef struct daemon_response {
+    uint32_t type; // daemon_message_type_t
+    int32_t error; // Result of the operation
+    char operation[64]; // Progress: current operation
+    uint64_t current; // Progress: current item
+    uint64_t total; // Progress: total items
+    uint64_t bytes_current; // Progress: bytes done
+    uint64_t bytes_total; // Progress: bytes expected
+    netchunk_stats_t stats; // Result: upload/download statistics
+    uint32_t values[2]; // Result: verify (verified, repaired) or health (healthy, total)
+    uint32_t entry_count; // Result: list entries or health server scores following this record
+} daemon_response_t;
+
+// One listed file, sent after a list result
+typedef struct daemon_list_entry {
+    char filename[NETCHUNK_MAX_PATH_LEN];
+    uint64_t original_size;
+    uint32_t chunk_count;
+    int64_t created_timestamp;
+    int64_t last_modified;
+} daemon_list_entry_t;
+
+// Internal helper functions
+static netchunk_error_t send_all(int fd, const void* data, size_t size);
+static netchunk_error_t recv_all(int fd, void* data, size_t size);
+static netchunk_error_t send_with_fd(int fd, const void* data, size_t size, int pass_fd);
+static netchunk_error_t recv_with_fd(int fd, void* data, size_t size, int* pass_fd);
+static netchunk_error_t build_socket_address(const char* socket_path, char* expanded_path, struct sockaddr_un* address);
+static netchunk_error_t ensure_parent_directory(const char* file_path);
+static void daemon_forward_progress(void* userdata, const char* operation,
+    uint64_t current, uint64_t total, uint64_t bytes_current, uint64_t bytes_total);
+static bool daemon_serve_client(netchunk_daemon_t* daemon, int client_fd);
+static int daemon_scrub_timeout(netchunk_daemon_t* daemon);
+static double daemon_now_ms(void);
+static netchunk_error_t daemon_send_list(int client_fd, daemon_response_t* response,
+    const netchunk_file_manifest_t* files, size_t count);
+static netchunk_error_t client_request(netchunk_daemon_client_t* client,
+    daemon_command_t command, uint32_t flags, const char* remote_name, int pass_fd,
+    daemon_response_t* response, void** entries, size_t entry_size);
+
+// Daemon Functions
+
+netchunk_error_t netchunk_daemon_init(netchunk_daemon_t* daemon,
+    netchunk_context_t* context,
+    const char* socket_path)
+{
+    if (!daemon || !context || !context->initialized || !socket_path) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    memset(daemon, 0, sizeof(netchunk_daemon_t));
+    daemon->context = context;
+    daemon->listen_fd = -1;
+    daemon->client_fd = -1;
+    daemon->wake_pipe[0] = -1;
+    daemon->wake_pipe[1] = -1;
+
+    struct sockaddr_un address;
+    netchunk_error_t error = build_socket_address(socket_path, daemon->socket_path, &address);
+    if (error != NETCHUNK_SUCCESS) {
+        return error;
+    }
+
+    error = ensure_parent_directory(daemon->socket_path);
+    if (error != NETCHUNK_SUCCESS) {
+        return error;
+    }
+
+    daemon->listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (daemon->listen_fd < 0) {
+        return NETCHUNK_ERROR_NETWORK;
+    }
+
+    // Refuse to take over from a daemon that still answers; replace a stale socket
+    if (connect(daemon->listen_fd, (struct sockaddr*)&address, sizeof(address)) == 0) {
+        close(daemon->listen_fd);
+        daemon->listen_fd = -1;
+        return NETCHUNK_ERROR_CONFIG;
+    }
+    close(daemon->listen_fd);
+    unlink(daemon->socket_path);
+
+    daemon->listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (daemon->listen_fd < 0) {
+        return NETCHUNK_ERROR_NETWORK;
+    }
+
+    // Only the owner may talk to the daemon
+    mode_t old_umask = umask(0077);
+    int bind_result = bind(daemon->listen_fd, (struct sockaddr*)&address, sizeof(address));
+    umask(old_umask);
+
+    if (bind_result != 0 || listen(daemon->listen_fd, DAEMON_LISTEN_BACKLOG) != 0) {
+        close(daemon->listen_fd);
+        daemon->listen_fd = -1;
+        return NETCHUNK_ERROR_FILE_ACCESS;
+    }
+
+    if (pipe2(daemon->wake_pipe, O_CLOEXEC | O_NONBLOCK) != 0) {
+        netchunk_daemon_cleanup(daemon);
+        return NETCHUNK_ERROR_UNKNOWN;
+    }
+
+    // Leave the first minutes after startup to the clients
+    if (context->config->scrub_interval > 0
+        && netchunk_scrubber_init(&daemon->scrubber, context->config, context->ftp_context,
+               context->config->scrub_deep)
+            == NETCHUNK_SUCCESS) {
+        daemon->scrubbing = true;
+        daemon->scrubber.next_pass = time(NULL) + NETCHUNK_DAEMON_SCRUB_START_DELAY;
+        daemon->next_scrub_ms = daemon_now_ms() + NETCHUNK_DAEMON_SCRUB_START_DELAY * 1000.0;
+    }
+
+    return NETCHUNK_SUCCESS;
+}
+
+netchunk_error_t netchunk_daemon_run(netchunk_daemon_t* daemon)
+{
+    if (!daemon || daemon->listen_fd < 0) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    for (;;) {
+        struct pollfd fds[2] = {
+            { .fd = daemon->listen_fd, .events = POLLIN },
+            { .fd = daemon->wake_pipe[0], .events = POLLIN },
+        };
+
+        int ready = poll(fds, 2, daemon_scrub_timeout(daemon));
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return NETCHUNK_ERROR_UNKNOWN;
+        }
+
+        if (fds[1].revents) {
+            return NETCHUNK_SUCCESS;
+        }
+
+        // Scrub only while no client is waiting
+        if (ready == 0) {
+            int delay_ms = 0;
+            netchunk_scrubber_step(&daemon->scrubber, &delay_ms);
+            daemon->next_scrub_ms = daemon_now_ms() + delay_ms;
+            continue;
+        }
+
+        if (!(fds[0].revents & POLLIN)) {
+            continue;
+        }
+
+        int client_fd = accept4(daemon->listen_fd, NULL, NULL, SOCK_CLOEXEC);
+        if (client_fd < 0) {
+            continue;
+        }
+
+        // A client that stops sending or reading must not stall the daemon
+        struct timeval timeout = { .tv_sec = NETCHUNK_DAEMON_IO_TIMEOUT, .tv_usec = 0 };
+        setsockopt(client_fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(client_fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+        bool keep_running = daemon_serve_client(daemon, client_fd);
+        close(client_fd);
+
+        if (!keep_running) {
+            return NETCHUNK_SUCCESS;
+        }
+    }
+}
+
+void netchunk_daemon_stop(netchunk_daemon_t* daemon)
+{
+    if (daemon && daemon->wake_pipe[1] >= 0) {
+        ssize_t written = write(daemon->wake_pipe[1], "x", 1);
+        (void)written;
+    }
+}
+
+void netchunk_daemon_cleanup(netchunk_daemon_t* daemon)
+{
+    if (!daemon) {
+        return;
+    }
+
+    if (daemon->listen_fd >= 0) {
+        close(daemon->listen_fd);
+        daemon->listen_fd = -1;
+        unlink(daemon->socket_path);
+    }
+
+    for (int i = 0; i < 2; i++) {
+        if (daemon->wake_pipe[i] >= 0) {
+            close(daemon->wake_pipe[i]);
+            daemon->wake_pipe[i] = -1;
+        }
+    }
+
+    if (daemon->scrubbing) {
+        netchunk_scrubber_cleanup(&daemon->scrubber);
+        daemon->scrubbing = false;
+    }
+}
+
+// Client Functions
+
+netchunk_error_t netchunk_daemon_connect(netchunk_daemon_client_t* client, const char* socket_path)
+{
+    if (!client || !socket_path) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    memset(client, 0, sizeof(netchunk_daemon_client_t));
+    client->fd = -1;
+
+    char expanded_path[NETCHUNK_MAX_PATH_LEN];
+    struct sockaddr_un address;
+    netchunk_error_t error = build_socket_address(socket_path, expanded_path, &address);
+    if (error != NETCHUNK_SUCCESS) {
+        return error;
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return NETCHUNK_ERROR_NETWORK;
+    }
+
+    if (connect(fd, (struct sockaddr*)&address, sizeof(address)) != 0) {
+        int saved_errno = errno;
+        close(fd);
+        if (saved_errno == ENOENT || saved_errno == ECONNREFUSED) {
+            return NETCHUNK_ERROR_SERVER_UNAVAILABLE;
+        }
+        return NETCHUNK_ERROR_NETWORK;
+    }
+
+    client->fd = fd;
+    return NETCHUNK_SUCCESS;
+}
+
+void netchunk_daemon_client_set_progress_callback(netchunk_daemon_client_t* client,
+    netchunk_progress_callback_t callback,
+    void* userdata)
+{
+    if (client) {
+        client->progress_cb = callback;
+        client->progress_userdata = userdata;
+    }
+}
+
+void netchunk_daemon_disconnect(netchunk_daemon_client_t* client)
+{
+    if (client && client->fd >= 0) {
+        close(client->fd);
+        client->fd = -1;
+    }
+}
+
+netchunk_error_t netchunk_daemon_upload(netchunk_daemon_client_t* client,
+    int input_fd,
+    const char* remote_name,
+    netchunk_stats_t* stats)
+{
+    if (input_fd < 0 || !remote_name) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    daemon_response_t response;
+    netchunk_error_t error = client_request(client, DAEMON_CMD_UPLOAD, 0, remote_name, input_fd, &response, NULL, 0);
+    if (error == NETCHUNK_SUCCESS && stats) {
+        *stats = response.stats;
+    }
+    return error;
+}
+
+netchunk_error_t netchunk_daemon_download(netchunk_daemon_client_t* client,
+    const char* remote_name,
+    int output_fd,
+    netchunk_stats_t* stats)
+{
+    if (output_fd < 0 || !remote_name) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    daemon_response_t response;
+    netchunk_error_t error = client_request(client, DAEMON_CMD_DOWNLOAD, 0, remote_name, output_fd, &response, NULL, 0);
+    if (error == NETCHUNK_SUCCESS && stats) {
+        *stats = response.stats;
+    }
+    return error;
+}
+
+netchunk_error_t netchunk_daemon_list_files(netchunk_daemon_client_t* client,
+    netchunk_file_manifest_t** files,
+    size_t* count)
+{
+    if (!files || !count) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    *files = NULL;
+    *count = 0;
+
+    daemon_response_t response;
+    daemon_list_entry_t* entries = NULL;
+    netchunk_error_t error = client_request(client, DAEMON_CMD_LIST, 0, NULL, -1, &response,
+        (void**)&entries, sizeof(daemon_list_entry_t));
+    if (error != NETCHUNK_SUCCESS || response.entry_count == 0) {
+        free(entries);
+        return error;
+    }
+
+    netchunk_file_manifest_t* list = calloc(response.entry_count, sizeof(netchunk_file_manifest_t));
+    if (!list) {
+        free(entries);
+        return NETCHUNK_ERROR_OUT_OF_MEMORY;
+    }
+
+    for (uint32_t i = 0; i < response.entry_count; i++) {
+        entries[i].filename[sizeof(entries[i].filename) - 1] = '\0';
+        strncpy(list[i].original_filename, entries[i].filename, sizeof(list[i].original_filename) - 1);
+        list[i].original_size = (size_t)entries[i].original_size;
+        list[i].total_size = (size_t)entries[i].original_size;
+        list[i].chunk_count = entries[i].chunk_count;
+        list[i].created_timestamp = (time_t)entries[i].created_timestamp;
+        list[i].last_modified = (time_t)entries[i].last_modified;
+    }
+
+    free(entries);
+    *files = list;
+    *count = response.entry_count;
+    return NETCHUNK_SUCCESS;
+}
+
+netchunk_error_t netchunk_daemon_delete(netchunk_daemon_client_t* client, const char* remote_name)
+{
+    if (!remote_name) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    daemon_response_t response;
+    return client_request(client, DAEMON_CMD_DELETE, 0, remote_name, -1, &response, NULL, 0);
+}
+
+netchunk_error_t netchunk_daemon_verify(netchunk_daemon_client_t* client,
+    const char* remote_name,
+    bool repair,
+    uint32_t* chunks_verified,
+    uint32_t* chunks_repaired)
+{
+    if (!remote_name) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    daemon_response_t response;
+    netchunk_error_t error = client_request(client, DAEMON_CMD_VERIFY, repair ? DAEMON_FLAG_REPAIR : 0,
+        remote_name, -1, &response, NULL, 0);
+    if (error == NETCHUNK_SUCCESS) {
+        if (chunks_verified)
+            *chunks_verified = response.values[0];
+        if (chunks_repaired)
+            *chunks_repaired = response.values[1];
+    }
+    return error;
+}
+
+netchunk_error_t netchunk_daemon_health_check(netchunk_daemon_client_t* client,
+    uint32_t* healthy_servers,
+    uint32_t* total_servers)
+{
+    return netchunk_daemon_health_report(client, healthy_servers, total_servers, NULL, 0, NULL);
+}
+
+netchunk_error_t netchunk_daemon_health_report(netchunk_daemon_client_t* client,
+    uint32_t* healthy_servers,
+    uint32_t* total_servers,
+    netchunk_server_score_t* scores,
+    int max_scores,
+    int* score_count)
+{
+    if (score_count) {
+        *score_count = 0;
+    }
+
+    daemon_response_t response;
+    netchunk_server_score_t* entries = NULL;
+    netchunk_error_t error = client_request(client, DAEMON_CMD_HEALTH, 0, NULL, -1, &response,
+        (void**)&entries, sizeof(netchunk_server_score_t));
+    if (error == NETCHUNK_SUCCESS) {
+        if (healthy_servers)
+            *healthy_servers = response.values[0];
+        if (total_servers)
+            *total_servers = response.values[1];
+
+        int received = (int)response.entry_count;
+        if (scores && score_count && received > 0 && max_scores > 0) {
+            *score_count = received < max_scores ? received : max_scores;
+            memcpy(scores, entries, (size_t)*score_count * sizeof(netchunk_server_score_t));
+        }
+    }
+
+    free(entries);
+    return error;
+}
+
+netchunk_error_t netchunk_daemon_shutdown(netchunk_daemon_client_t* client)
+{
+    daemon_response_t response;
+    return client_request(client, DAEMON_CMD_SHUTDOWN, 0, NULL, -1, &response, NULL, 0);
+}
+
+// Internal helper functions
+
+static netchunk_error_t send_all(int fd, const void* data, size_t size)
+{
+    const uint8_t* bytes = (const uint8_t*)data;
+
+    while (size > 0) {
+        ssize_t sent = send(fd, bytes, size, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return NETCHUNK_ERROR_NETWORK;
+        }
+        bytes += sent;
+        size -= (size_t)sent;
+    }
+
+    return NETCHUNK_SUCCESS;
+}
+
+static netchunk_error_t recv_all(int fd, void* data, size_t size)
+{
+    uint8_t* bytes = (uint8_t*)data;
+
+    while (size > 0) {
+        ssize_t received = recv(fd, bytes, size, 0);
+        if (received < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return errno == EAGAIN || errno == EWOULDBLOCK ? NETCHUNK_ERROR_TIMEOUT : NETCHUNK_ERROR_NETWORK;
+        }
+        if (received == 0) {
+            return NETCHUNK_ERROR_NETWORK;
+        }
+        bytes += received;
+        size -= (size_t)received;
+    }
+
+    return NETCHUNK_SUCCESS;
+}
+
+/**
+ * @brief Send a record with a file descriptor attached to its first byte
+ */
+static netchunk_error_t send_with_fd(int fd, const void* data, size_t size, int pass_fd)
+{
+    if (pass_fd < 0) {
+        return send_all(fd, data, size);
+    }
+
+    union {
+        struct cmsghdr header;
+        char buffer[CMSG_SPACE(sizeof(int))];
+    } control;
+    memset(&control, 0, sizeof(control));
+
+    struct iovec iov = { .iov_base = (void*)data, .iov_len = size };
+    struct msghdr message = { 0 };
+    message.msg_iov = &iov;
+    message.msg_iovlen = 1;
+    message.msg_control = control.buffer;
+    message.msg_controllen = sizeof(control.buffer);
+
+    struct cmsghdr* cmsg = CMSG_FIRSTHDR(&message);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(cmsg), &pass_fd, sizeof(int));
+
+    ssize_t sent;
+    do {
+        sent = sendmsg(fd, &message, MSG_NOSIGNAL);
+    } while (sent < 0 && errno == EINTR);
+
+    if (sent < 0) {
+        return NETCHUNK_ERROR_NETWORK;
+    }
+
+    return send_all(fd, (const uint8_t*)data + sent, size - (size_t)sent);
+}
+
+/**
+ * @brief Receive a record and any file descriptor attached to it
+ */
+static netchunk_error_t recv_with_fd(int fd, void* data, size_t size, int* pass_fd)
+{
+    union {
+        struct cmsghdr header;
+        char buffer[CMSG_SPACE(sizeof(int))];
+    } control;
+    memset(&control, 0, sizeof(control));
+
+    struct iovec iov = { .iov_base = data, .iov_len = size };
+    struct msghdr message = { 0 };
+    message.msg_iov = &iov;
+    message.msg_iovlen = 1;
+    message.msg_control = control.buffer;
+    message.msg_controllen = sizeof(control.buffer);
+
+    *pass_fd = -1;
+
+    ssize_t received;
+    do {
+        received = recvmsg(fd, &message, MSG_CMSG_CLOEXEC);
+    } while (received < 0 && errno == EINTR);
+
+    if (received == 0) {
+        return NETCHUNK_ERROR_NETWORK;
+    }
+    if (received < 0) {
+        return errno == EAGAIN || errno == EWOULDBLOCK ? NETCHUNK_ERROR_TIMEOUT : NETCHUNK_ERROR_NETWORK;
+    }
+
+    for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&message); cmsg; cmsg = CMSG_NXTHDR(&message, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS
+            && cmsg->cmsg_len == CMSG_LEN(sizeof(int))) {
+            memcpy(pass_fd, CMSG_DATA(cmsg), sizeof(int));
+        }
+    }
+
+    netchunk_error_t error = recv_all(fd, (uint8_t*)data + received, size - (size_t)received);
+    if (error != NETCHUNK_SUCCESS && *pass_fd >= 0) {
+        close(*pass_fd);
+        *pass_fd = -1;
+    }
+    return error;
+}
+
+static netchunk_error_t build_socket_address(const char* socket_path, char* expanded_path, struct sockaddr_un* address)
+{
+    netchunk_error_t error = netchunk_config_expand_path(socket_path, expanded_path, NETCHUNK_MAX_PATH_LEN);
+    if (error != NETCHUNK_SUCCESS) {
+        return error;
+    }
+
+    memset(address, 0, sizeof(struct sockaddr_un));
+    address->sun_family = AF_UNIX;
+
+    // Socket paths are limited to sizeof(sun_path), far below NETCHUNK_MAX_PATH_LEN
+    if (strlen(expanded_path) == 0 || strlen(expanded_path) >= sizeof(address->sun_path)) {
+        return NETCHUNK_ERROR_CONFIG;
+    }
+    strcpy(address->sun_path, expanded_path);
+
+    return NETCHUNK_SUCCESS;
+}
+
+/**
+ * @brief Create the directories leading up to the socket
+ */
+static netchunk_error_t ensure_parent_directory(const char* file_path)
+{
+    char path_copy[NETCHUNK_MAX_PATH_LEN];
+    strncpy(path_copy, file_path, sizeof(path_copy) - 1);
+    path_copy[sizeof(path_copy) - 1] = '\0';
+
+    for (char* p = path_copy + 1; *p; p++) {
+        if (*p == '/') {
+            *p = '\0';
+            if (mkdir(path_copy, 0700) != 0 && errno != EEXIST) {
+                return NETCHUNK_ERROR_FILE_ACCESS;
+            }
+            *p = '/';
+        }
+    }
+
+    return NETCHUNK_SUCCESS;
+}
+
+/**
+ * @brief Context progress callback relaying progress to the current client
+ *
+ * A client that went away only loses progress; the operation carries on.
+ */
+static void daemon_forward_progress(void* userdata, const char* operation,
+    uint64_t current, uint64_t total, uint64_t bytes_current, uint64_t bytes_total)
+{
+    netchunk_daemon_t* daemon = (netchunk_daemon_t*)userdata;
+    if (daemon->client_fd < 0) {
+        return;
+    }
+
+    daemon_response_t progress;
+    memset(&progress, 0, sizeof(progress));
+    progress.type = DAEMON_MSG_PROGRESS;
+    strncpy(progress.operation, operation ? operation : "", sizeof(progress.operation) - 1);
+    progress.current = current;
+    progress.total = total;
+    progress.bytes_current = bytes_current;
+    progress.bytes_total = bytes_total;
+
+    if (send_all(daemon->client_fd, &progress, sizeof(progress)) != NETCHUNK_SUCCESS) {
+        daemon->client_fd = -1;
+    }
+}
+
+/**
+ * @brief Execute one request and send its result
+ * @return false if the client asked the daemon to shut down
+ */
+static bool daemon_serve_client(netchunk_daemon_t* daemon, int client_fd)
+{
+    netchunk_context_t* context = daemon->context;
+    daemon_request_t request;
+    int pass_fd = -1;
+
+    if (recv_with_fd(client_fd, &request, sizeof(request), &pass_fd) != NETCHUNK_SUCCESS) {
+        return true;
+    }
+    request.remote_name[sizeof(request.remote_name) - 1] = '\0';
+
+    daemon_response_t response;
+    memset(&response, 0, sizeof(response));
+    response.type = DAEMON_MSG_RESULT;
+
+    if (request.magic != DAEMON_MAGIC || request.version != NETCHUNK_DAEMON_PROTOCOL_VERSION) {
+        if (pass_fd >= 0) {
+            close(pass_fd);
+        }
+        response.error = NETCHUNK_ERROR_INVALID_ARGUMENT;
+        send_all(client_fd, &response, sizeof(response));
+        return true;
+    }
+
+    // Relay progress for the duration of this request only
+    netchunk_progress_callback_t saved_cb = context->progress_cb;
+    void* saved_userdata = context->progress_userdata;
+    daemon->client_fd = client_fd;
+    netchunk_set_progress_callback(context, daemon_forward_progress, daemon);
+
+    netchunk_file_manifest_t* files = NULL;
+    size_t file_count = 0;
+    netchunk_server_score_t scores[NETCHUNK_MAX_SERVERS];
+    int score_count = 0;
+    bool keep_running = true;
+
+    switch ((daemon_command_t)request.command) {
+    case DAEMON_CMD_UPLOAD: {
+        FILE* input = pass_fd >= 0 ? fdopen(pass_fd, "rb") : NULL;
+        if (!input) {
+            response.error = NETCHUNK_ERROR_INVALID_ARGUMENT;
+            break;
+        }
+        pass_fd = -1;
+        response.error = netchunk_upload_stream(context, input, request.remote_name, &response.stats);
+        fclose(input);
+        break;
+    }
+
+    case DAEMON_CMD_DOWNLOAD:
+        if (pass_fd < 0) {
+            response.error = NETCHUNK_ERROR_INVALID_ARGUMENT;
+            break;
+        }
+        response.error = netchunk_download_fd(context, request.remote_name, pass_fd, &response.stats);
+        if (close(pass_fd) != 0 && response.error == NETCHUNK_SUCCESS) {
+            response.error = NETCHUNK_ERROR_FILE_ACCESS;
+        }
+        pass_fd = -1;
+        break;
+
+    case DAEMON_CMD_LIST:
+        response.error = netchunk_list_files(context, &files, &file_count);
+        break;
+
+    case DAEMON_CMD_DELETE:
+        response.error = netchunk_delete(context, request.remote_name);
+        break;
+
+    case DAEMON_CMD_VERIFY:
+        response.error = netchunk_verify(context, request.remote_name, (request.flags & DAEMON_FLAG_REPAIR) != 0,
+            &response.values[0], &response.values[1]);
+        break;
+
+    case DAEMON_CMD_HEALTH:
+        response.error = netchunk_health_check(context, &response.values[0], &response.values[1]);
+        if (response.error == NETCHUNK_SUCCESS) {
+            response.error = netchunk_get_server_scores(context, scores, NETCHUNK_MAX_SERVERS, &score_count);
+        }
+        break;
+
+    case DAEMON_CMD_SHUTDOWN:
+        response.error = NETCHUNK_SUCCESS;
+        keep_running = false;
+        break;
+
+    default:
+        response.error = NETCHUNK_ERROR_INVALID_ARGUMENT;
+        break;
+    }
+
+    if (pass_fd >= 0) {
+        close(pass_fd);
+    }
+
+    netchunk_set_progress_callback(context, saved_cb, saved_userdata);
+
+    if (daemon->client_fd >= 0) {
+        if (response.error == NETCHUNK_SUCCESS && request.command == DAEMON_CMD_LIST) {
+            daemon_send_list(client_fd, &response, files, file_count);
+        } else if (response.error == NETCHUNK_SUCCESS && request.command == DAEMON_CMD_HEALTH) {
+            response.entry_count = (uint32_t)score_count;
+            if (send_all(client_fd, &response, sizeof(response)) == NETCHUNK_SUCCESS) {
+                send_all(client_fd, scores, (size_t)score_count * sizeof(netchunk_server_score_t));
+            }
+        } else {
+            send_all(client_fd, &response, sizeof(response));
+        }
+    }
+    daemon->client_fd = -1;
+
+    if (files) {
+        netchunk_free_file_list(files, file_count);
+    }
+
+    daemon->requests_served++;
+    return keep_running;
+}
+
+/**
+ * @brief Milliseconds poll may wait before the next scrub step is due
+ */
+static int daemon_scrub_timeout(netchunk_daemon_t* daemon)
+{
+    if (!daemon->scrubbing) {
+        return -1;
+    }
+
+    double remaining = daemon->next_scrub_ms - daemon_now_ms();
+    if (remaining <= 0.0) {
+        return 0;
+    }
+    return remaining >= (double)INT_MAX ? INT_MAX : (int)remaining + 1;
+}
+
+/**
+ * @brief Monotonic clock in milliseconds
+ */
+static double daemon_now_ms(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec * 1000.0 + (double)now.tv_nsec / 1000000.0;
+}
+
+/**
+ * @brief Send a list result followed by one entry per file
+ */
+static netchunk_error_t daemon_send_list(int client_fd, daemon_response_t* response,
+    const netchunk_file_manifest_t* files, size_t count)
+{
+    response->entry_count = (uint32_t)count;
+
+    netchunk_error_t error = send_all(client_fd, response, sizeof(daemon_response_t));
+    for (size_t i = 0; i < count && error == NETCHUNK_SUCCESS; i++) {
+        daemon_list_entry_t entry;
+        memset(&entry, 0, sizeof(entry));
+        strncpy(entry.filename, files[i].original_filename, sizeof(entry.filename) - 1);
+        entry.original_size = files[i].original_size;
+        entry.chunk_count = files[i].chunk_count;
+        entry.created_timestamp = (int64_t)files[i].created_timestamp;
+        entry.last_modified = (int64_t)files[i].last_modified;
+
+        error = send_all(client_fd, &entry, sizeof(entry));
+    }
+
+    return error;
+}
+
+/**
+ * @brief Send one request and wait for its result, relaying progress
+ */
+static netchunk_error_t client_request(netchunk_daemon_client_t* client,
+    daemon_command_t command, uint32_t flags, const char* remote_name, int pass_fd,
+    daemon_response_t* response, void** entries, size_t entry_size)
+{
+    if (!client || client->fd < 0) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    daemon_request_t request;
+    memset(&request, 0, sizeof(request));
+    request.magic = DAEMON_MAGIC;
+    request.version = NETCHUNK_DAEMON_PROTOCOL_VERSION;
+    request.command = (uint32_t)command;
+    request.flags = flags;
+    if (remote_name) {
+        if (strlen(remote_name) >= sizeof(request.remote_name)) {
+            return NETCHUNK_ERROR_INVALID_ARGUMENT;
+        }
+        strcpy(request.remote_name, remote_name);
+    }
+
+    netchunk_error_t error = send_with_fd(client->fd, &request, sizeof(request), pass_fd);
+    if (error != NETCHUNK_SUCCESS) {
+        return error;
+    }
+
+    for (;;) {
+        error = recv_all(client->fd, response, sizeof(daemon_response_t));
+        if (error != NETCHUNK_SUCCESS) {
+            return error;
+        }
+
+        if (response->type == DAEMON_MSG_RESULT) {
+            break;
+        }
+
+        if (response->type == DAEMON_MSG_PROGRESS && client->progress_cb) {
+            response->operation[sizeof(response->operation) - 1] = '\0';
+            client->progress_cb(client->progress_userdata, response->operation,
+                response->current, response->total, response->bytes_current, response->bytes_total);
+        }
+    }
+
+    if (response->error != NETCHUNK_SUCCESS || response->entry_count == 0) {
+        return (netchunk_error_t)response->error;
+    }
+
+    if (!entries || entry_size == 0) {
+        return NETCHUNK_ERROR_NETWORK; // Entries the caller did not ask for
+    }
+
+    void* list = calloc(response->entry_count, entry_size);
+    if (!list) {
+        return NETCHUNK_ERROR_OUT_OF_MEMORY;
+    }
+
+    error = recv_all(client->fd, list, response->entry_count * entry_size);
+    if (error != NETCHUNK_SUCCESS) {
+        free(list);
+        return error;
+    }
+
+    *entries = list;
+    return NETCHUNK_SUCCESS;
+}
@@ -0,0 +1,473 @@
+/**
+ * @file dedup.c
+ * @brief Local index of content-addressed chunks
+ *
+ * Maps chunk hashes to the servers holding them and the number of
+ * manifests referencing them, so uploads can skip chunks that are already
+ * stored and deletes only remove chunks nobody else uses.
+ */
+
+#include "dedup.h"
+#include "crypto.h"
+#include <cjson/cJSON.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define DEDUP_TEMP_SUFFIX ".tmp"
+
+// Internal helper functions
+static size_t dedup_slot(const uint8_t* hash, size_t capacity);
+static netchunk_dedup_entry_t* dedup_find(const netchunk_dedup_index_t* index, const uint8_t* hash);
+static netchunk_dedup_entry_t* dedup_insert(netchunk_dedup_index_t* index, const uint8_t* hash);
+static netchunk_error_t dedup_grow(netchunk_dedup_index_t* index);
+static void dedup_remove(netchunk_dedup_index_t* index, netchunk_dedup_entry_t* entry);
+static int dedup_intern_server(netchunk_dedup_index_t* index, const char* server_id);
+static int dedup_server_slot(const netchunk_dedup_index_t* index, const char* server_id);
+static netchunk_error_t ensure_parent_directory(const char* file_path);
+
+netchunk_error_t netchunk_dedup_index_init(netchunk_dedup_index_t* index, const char* path)
+{
+    if (!index || !path) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    memset(index, 0, sizeof(netchunk_dedup_index_t));
+
+    netchunk_error_t error = netchunk_config_expand_path(path, index->path, sizeof(index->path));
+    if (error != NETCHUNK_SUCCESS) {
+        return error;
+    }
+
+    index->entries = calloc(NETCHUNK_DEDUP_INITIAL_CAPACITY, sizeof(netchunk_dedup_entry_t));
+    if (!index->entries) {
+        return NETCHUNK_ERROR_OUT_OF_MEMORY;
+    }
+    index->capacity = NETCHUNK_DEDUP_INITIAL_CAPACITY;
+
+    return NETCHUNK_SUCCESS;
+}
+
+netchunk_error_t netchunk_dedup_index_load(netchunk_dedup_index_t* index)
+{
+    if (!index || !index->entries) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    FILE* file = fopen(index->path, "r");
+    if (!file) {
+        // No index yet: nothing has been stored content-addressed
+        return errno == ENOENT ? NETCHUNK_SUCCESS : NETCHUNK_ERROR_FILE_ACCESS;
+    }
+
+    fseek(file, 0, SEEK_END);
+    long file_size = ftell(file);
+    rewind(file);
+
+    if (file_size < 0) {
+        fclose(file);
+        return NETCHUNK_ERROR_FILE_ACCESS;
+    }
+
+    char* content = malloc((size_t)file_size + 1);
+    if (!content) {
+        fclose(file);
+        return NETCHUNK_ERROR_OUT_OF_MEMORY;
+    }
+
+    size_t bytes_read = fread(content, 1, (size_t)file_size, file);
+    fclose(file);
+    if (bytes_read != (size_t)file_size) {
+        free(content);
+        return NETCHUNK_ERROR_FILE_ACCESS;
+    }
+    content[file_size] = '\0';
+
+    cJSON* root = cJSON_Parse(content);
+    free(content);
+    if (!root) {
+        return NETCHUNK_ERROR_MANIFEST_CORRUPT;
+    }
+
+    netchunk_error_t result = NETCHUNK_SUCCESS;
+    cJSON* chunks = cJSON_GetObjectItem(root, "chunks");
+    if (!chunks || !cJSON_IsArray(chunks)) {
+        cJSON_Delete(root);
+        return NETCHUNK_ERROR_MANIFEST_CORRUPT;
+    }
+
+    cJSON* chunk_json;
+    cJSON_ArrayForEach(chunk_json, chunks)
+    {
+        cJSON* hash = cJSON_GetObjectItem(chunk_json, "hash");
+        cJSON* size = cJSON_GetObjectItem(chunk_json, "size");
+        cJSON* refs = cJSON_GetObjectItem(chunk_json, "refs");
+        cJSON* servers = cJSON_GetObjectItem(chunk_json, "servers");
+
+        uint8_t hash_bytes[NETCHUNK_HASH_LENGTH];
+        if (!hash || !cJSON_IsString(hash) || !cJSON_IsNumber(size) || !cJSON_IsNumber(refs)
+            || netchunk_hex_string_to_hash(hash->valuestring, hash_bytes, sizeof(hash_bytes)) != NETCHUNK_SUCCESS) {
+            result = NETCHUNK_ERROR_MANIFEST_CORRUPT;
+            break;
+        }
+
+        netchunk_dedup_entry_t* entry = dedup_insert(index, hash_bytes);
+        if (!entry) {
+            result = NETCHUNK_ERROR_OUT_OF_MEMORY;
+            break;
+        }
+        entry->size = (size_t)size->valuedouble;
+        entry->refcount = (uint32_t)refs->valuedouble;
+
+        cJSON* server_json;
+        cJSON_ArrayForEach(server_json, servers)
+        {
+            if (cJSON_IsString(server_json)) {
+                int slot = dedup_intern_server(index, server_json->valuestring);
+                if (slot >= 0) {
+                    entry->server_mask |= 1u << slot;
+                }
+            }
+        }
+    }
+
+    cJSON_Delete(root);
+    index->dirty = false;
+    return result;
+}
+
+netchunk_error_t netchunk_dedup_index_save(netchunk_dedup_index_t* index)
+{
+    if (!index || !index->entries) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    cJSON* root = cJSON_CreateObject();
+    cJSON* chunks = cJSON_CreateArray();
+    if (!root || !chunks) {
+        cJSON_Delete(root);
+        cJSON_Delete(chunks);
+        return NETCHUNK_ERROR_OUT_OF_MEMORY;
+    }
+
+    cJSON_AddStringToObject(root, "version", NETCHUNK_DEDUP_INDEX_VERSION);
+    cJSON_AddItemToObject(root, "chunks", chunks);
+
+    for (size_t i = 0; i < index->capacity; i++) {
+        const netchunk_dedup_entry_t* entry = &index->entries[i];
+        if (!entry->used) {
+            continue;
+        }
+
+        char hash_hex[NETCHUNK_HASH_LENGTH * 2 + 1];
+        netchunk_hash_to_hex_string(entry->hash, NETCHUNK_HASH_LENGTH, hash_hex);
+
+        cJSON* chunk_json = cJSON_CreateObject();
+        cJSON* servers = cJSON_CreateArray();
+        if (!chunk_json || !servers) {
+            cJSON_Delete(chunk_json);
+            cJSON_Delete(servers);
+            cJSON_Delete(root);
+            return NETCHUNK_ERROR_OUT_OF_MEMORY;
+        }
+
+        cJSON_AddStringToObject(chunk_json, "hash", hash_hex);
+        cJSON_AddNumberToObject(chunk_json, "size", (double)entry->size);
+        cJSON_AddNumberToObject(chunk_json, "refs", (double)entry->refcount);
+        for (int s = 0; s < index->server_count; s++) {
+            if (entry->server_mask & (1u << s)) {
+                cJSON_AddItemToArray(servers, cJSON_CreateString(index->server_ids[s]));
+            }
+        }
+        cJSON_AddItemToObject(chunk_json, "servers", servers);
+        cJSON_AddItemToArray(chunks, chunk_json);
+    }
+
+    char* content = cJSON_PrintUnformatted(root);
+    cJSON_Delete(root);
+    if (!content) {
+        return NETCHUNK_ERROR_OUT_OF_MEMORY;
+    }
+
+    netchunk_error_t error = ensure_parent_directory(index->path);
+    if (error != NETCHUNK_SUCCESS) {
+        free(content);
+        return error;
+    }
+
+    // Write to a temporary file and rename so a crash never leaves a torn index
+    char temp_path[NETCHUNK_MAX_PATH_LEN + sizeof(DEDUP_TEMP_SUFFIX)];
+    snprintf(temp_path, sizeof(temp_path), "%s%s", index->path, DEDUP_TEMP_SUFFIX);
+
+    FILE* temp_file = fopen(temp_path, "w");
+    if (!temp_file) {
+        free(content);
+        return NETCHUNK_ERROR_FILE_ACCESS;
+    }
+
+    bool written = fputs(content, temp_file) >= 0 && fflush(temp_file) == 0 && fsync(fileno(temp_file)) == 0;
+    fclose(temp_file);
+    free(content);
+
+    if (!written || rename(temp_path, index->path) != 0) {
+        unlink(temp_path);
+        return NETCHUNK_ERROR_FILE_ACCESS;
+    }
+
+    index->dirty = false;
+    return NETCHUNK_SUCCESS;
+}
+
+void netchunk_dedup_index_cleanup(netchunk_dedup_index_t* index)
+{
+    if (!index) {
+        return;
+    }
+
+    free(index->entries);
+    memset(index, 0, sizeof(netchunk_dedup_index_t));
+}
+
+const netchunk_dedup_entry_t* netchunk_dedup_index_lookup(const netchunk_dedup_index_t* index,
+    const uint8_t* hash)
+{
+    if (!index || !index->entries || !hash) {
+        return NULL;
+    }
+
+    return dedup_find(index, hash);
+}
+
+bool netchunk_dedup_entry_has_server(const netchunk_dedup_index_t* index,
+    const netchunk_dedup_entry_t* entry,
+    const char* server_id)
+{
+    if (!index || !entry || !server_id) {
+        return false;
+    }
+
+    int slot = dedup_server_slot(index, server_id);
+    return slot >= 0 && (entry->server_mask & (1u << slot)) != 0;
+}
+
+netchunk_error_t netchunk_dedup_index_add_ref(netchunk_dedup_index_t* index,
+    const netchunk_chunk_t* chunk)
+{
+    if (!index || !index->entries || !chunk) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    netchunk_dedup_entry_t* entry = dedup_find(index, chunk->hash);
+    if (!entry) {
+        entry = dedup_insert(index, chunk->hash);
+        if (!entry) {
+            return NETCHUNK_ERROR_OUT_OF_MEMORY;
+        }
+        entry->size = chunk->size;
+    }
+
+    for (int i = 0; i < chunk->location_count; i++) {
+        int slot = dedup_intern_server(index, chunk->locations[i].server_id);
+        if (slot >= 0) {
+            entry->server_mask |= 1u << slot;
+        }
+    }
+
+    entry->refcount++;
+    index->dirty = true;
+    return NETCHUNK_SUCCESS;
+}
+
+netchunk_error_t netchunk_dedup_index_release(netchunk_dedup_index_t* index,
+    const uint8_t* hash,
+    uint32_t* remaining)
+{
+    if (!index || !index->entries || !hash) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    netchunk_dedup_entry_t* entry = dedup_find(index, hash);
+    if (!entry) {
+        return NETCHUNK_ERROR_FILE_NOT_FOUND;
+    }
+
+    if (entry->refcount > 0) {
+        entry->refcount--;
+    }
+
+    uint32_t left = entry->refcount;
+    if (left == 0) {
+        dedup_remove(index, entry);
+    }
+
+    if (remaining) {
+        *remaining = left;
+    }
+
+    index->dirty = true;
+    return NETCHUNK_SUCCESS;
+}
+
+// Internal helper functions
+
+/**
+ * @brief Home slot of a hash; SHA-256 output is already uniformly distributed
+ */
+static size_t dedup_slot(const uint8_t* hash, size_t capacity)
+{
+    uint64_t key = 0;
+    for (int i = 0; i < 8; i++) {
+        key = (key << 8) | hash[i];
+    }
+    return (size_t)(key & (uint64_t)(capacity - 1));
+}
+
+/**
+ * @brief Linear probe for a hash
+ */
+static netchunk_dedup_entry_t* dedup_find(const netchunk_dedup_index_t* index, const uint8_t* hash)
+{
+    size_t mask = index->capacity - 1;
+
+    for (size_t i = dedup_slot(hash, index->capacity);; i = (i + 1) & mask) {
+        netchunk_dedup_entry_t* entry = &index->entries[i];
+        if (!entry->used) {
+            return NULL;
+        }
+        if (memcmp(entry->hash, hash, NETCHUNK_HASH_LENGTH) == 0) {
+            return entry;
+        }
+    }
+}
+
+/**
+ * @brief Claim a slot for a hash not yet in the table, growing at 70% load
+ */
+static netchunk_dedup_entry_t* dedup_insert(netchunk_dedup_index_t* index, const uint8_t* hash)
+{
+    netchunk_dedup_entry_t* existing = dedup_find(index, hash);
+    if (existing) {
+        return existing;
+    }
+
+    if ((index->count + 1) * 10 > index->capacity * 7 && dedup_grow(index) != NETCHUNK_SUCCESS) {
+        return NULL;
+    }
+
+    size_t mask = index->capacity - 1;
+    size_t i = dedup_slot(hash, index->capacity);
+    while (index->entries[i].used) {
+        i = (i + 1) & mask;
+    }
+
+    netchunk_dedup_entry_t* entry = &index->entries[i];
+    memset(entry, 0, sizeof(netchunk_dedup_entry_t));
+    memcpy(entry->hash, hash, NETCHUNK_HASH_LENGTH);
+    entry->used = true;
+    index->count++;
+    return entry;
+}
+
+/**
+ * @brief Double the table and rehash every entry
+ */
+static netchunk_error_t dedup_grow(netchunk_dedup_index_t* index)
+{
+    size_t new_capacity = index->capacity * 2;
+    netchunk_dedup_entry_t* new_entries = calloc(new_capacity, sizeof(netchunk_dedup_entry_t));
+    if (!new_entries) {
+        return NETCHUNK_ERROR_OUT_OF_MEMORY;
+    }
+
+    for (size_t i = 0; i < index->capacity; i++) {
+        const netchunk_dedup_entry_t* entry = &index->entries[i];
+        if (!entry->used) {
+            continue;
+        }
+
+        size_t j = dedup_slot(entry->hash, new_capacity);
+        while (new_entries[j].used) {
+            j = (j + 1) & (new_capacity - 1);
+        }
+        new_entries[j] = *entry;
+    }
+
+    free(index->entries);
+    index->entries = new_entries;
+    index->capacity = new_capacity;
+    return NETCHUNK_SUCCESS;
+}
+
+/**
+ * @brief Remove an entry, shifting later probe-chain members back into the gap
+ */
+static void dedup_remove(netchunk_dedup_index_t* index, netchunk_dedup_entry_t* entry)
+{
+    size_t mask = index->capacity - 1;
+    size_t gap = (size_t)(entry - index->entries);
+
+    for (size_t i = (gap + 1) & mask; index->entries[i].used; i = (i + 1) & mask) {
+        size_t home = dedup_slot(index->entries[i].hash, index->capacity);
+
+        // Move the entry back if the gap lies between its home slot and its position
+        if (((i - home) & mask) >= ((i - gap) & mask)) {
+            index->entries[gap] = index->entries[i];
+            gap = i;
+        }
+    }
+
+    memset(&index->entries[gap], 0, sizeof(netchunk_dedup_entry_t));
+    index->count--;
+}
+
+/**
+ * @brief Get or assign the bit for a server ID
+ */
+static int dedup_intern_server(netchunk_dedup_index_t* index, const char* server_id)
+{
+    int slot = dedup_server_slot(index, server_id);
+    if (slot >= 0 || index->server_count >= NETCHUNK_MAX_SERVERS || strlen(server_id) == 0) {
+        return slot;
+    }
+
+    strncpy(index->server_ids[index->server_count], server_id, NETCHUNK_MAX_SERVER_ID_LEN - 1);
+    return index->server_count++;
+}
+
+/**
+ * @brief Find the bit assigned to a server ID
+ */
+static int dedup_server_slot(const netchunk_dedup_index_t* index, const char* server_id)
+{
+    for (int i = 0; i < index->server_count; i++) {
+        if (strcmp(index->server_ids[i], server_id) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Create the directories leading up to a file
+ */
+static netchunk_error_t ensure_parent_directory(const char* file_path)
+{
+    char path_copy[NETCHUNK_MAX_PATH_LEN];
+    strncpy(path_copy, file_path, sizeof(path_copy) - 1);
+    path_copy[sizeof(path_copy) - 1] = '\0';
+
+    for (char* p = path_copy + 1; *p; p++) {
+        if (*p == '/') {
+            *p = '\0';
+            if (mkdir(path_copy, 0755) != 0 && errno != EEXIST) {
+                return NETCHUNK_ERROR_FILE_ACCESS;
+            }
+            *p = '/';
+        }
+    }
+
+    return NETCHUNK_SUCCESS;
+}
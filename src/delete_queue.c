@@ -0,0 +1,342 @@
+/**
+ * @file delete_queue.c
+ * @brief Background removal of remote files
+ *
+ * Deleting a large file removes one chunk file per replica; the queue lets
+ * the caller return once the manifest is gone and sends the removals from
+ * a worker thread, retrying the ones that fail.
+ */
+
+#include "delete_queue.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Internal helper functions
+static netchunk_error_t delete_queue_append_locked(netchunk_delete_queue_t* queue, const netchunk_delete_item_t* item);
+static bool delete_queue_next_due_locked(const netchunk_delete_queue_t* queue, time_t* due);
+static size_t delete_queue_round(netchunk_delete_queue_t* queue);
+static void* delete_queue_worker(void* arg);
+
+netchunk_error_t netchunk_delete_queue_init(netchunk_delete_queue_t* queue, netchunk_ftp_context_t* ftp_context)
+{
+    if (!queue || !ftp_context) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    memset(queue, 0, sizeof(netchunk_delete_queue_t));
+    queue->ftp_context = ftp_context;
+
+    if (pthread_mutex_init(&queue->mutex, NULL) != 0) {
+        return NETCHUNK_ERROR_UNKNOWN;
+    }
+    if (pthread_cond_init(&queue->changed, NULL) != 0) {
+        pthread_mutex_destroy(&queue->mutex);
+        return NETCHUNK_ERROR_UNKNOWN;
+    }
+
+    return NETCHUNK_SUCCESS;
+}
+
+netchunk_error_t netchunk_delete_queue_start(netchunk_delete_queue_t* queue)
+{
+    if (!queue) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    pthread_mutex_lock(&queue->mutex);
+    netchunk_error_t error = NETCHUNK_SUCCESS;
+    if (!queue->thread_running) {
+        queue->stopping = false;
+        if (pthread_create(&queue->thread, NULL, delete_queue_worker, queue) == 0) {
+            queue->thread_running = true;
+        } else {
+            error = NETCHUNK_ERROR_UNKNOWN;
+        }
+    }
+    pthread_mutex_unlock(&queue->mutex);
+
+    return error;
+}
+
+netchunk_error_t netchunk_delete_queue_push(netchunk_delete_queue_t* queue,
+    int server_index,
+    const char* remote_path)
+{
+    if (!queue || !remote_path || server_index < 0 || server_index >= NETCHUNK_MAX_SERVERS) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    netchunk_delete_item_t item = {
+        .server_index = server_index,
+        .remote_path = strdup(remote_path),
+        .attempts = 0,
+        .retry_at = 0
+    };
+    if (!item.remote_path) {
+        return NETCHUNK_ERROR_OUT_OF_MEMORY;
+    }
+
+    pthread_mutex_lock(&queue->mutex);
+    netchunk_error_t error = delete_queue_append_locked(queue, &item);
+    if (error == NETCHUNK_SUCCESS) {
+        queue->stats.queued++;
+        pthread_cond_broadcast(&queue->changed);
+    }
+    pthread_mutex_unlock(&queue->mutex);
+
+    if (error != NETCHUNK_SUCCESS) {
+        free(item.remote_path);
+    }
+    return error;
+}
+
+size_t netchunk_delete_queue_take(netchunk_delete_queue_t* queue,
+    time_t now,
+    netchunk_delete_item_t* items,
+    size_t max)
+{
+    if (!queue || !items) {
+        return 0;
+    }
+
+    size_t taken = 0;
+    pthread_mutex_lock(&queue->mutex);
+
+    // Close the gaps as we go so removals leave in the order they came
+    size_t kept = 0;
+    for (size_t i = 0; i < queue->count; i++) {
+        if (taken < max && queue->items[i].retry_at <= now) {
+            items[taken++] = queue->items[i];
+        } else {
+            queue->items[kept++] = queue->items[i];
+        }
+    }
+    queue->count = kept;
+    queue->in_flight += taken;
+
+    pthread_mutex_unlock(&queue->mutex);
+    return taken;
+}
+
+void netchunk_delete_queue_settle(netchunk_delete_queue_t* queue,
+    netchunk_delete_item_t* items,
+    const netchunk_error_t* results,
+    size_t count,
+    time_t now)
+{
+    if (!queue || !items || !results) {
+        return;
+    }
+
+    pthread_mutex_lock(&queue->mutex);
+
+    for (size_t i = 0; i < count; i++) {
+        netchunk_delete_item_t* item = &items[i];
+
+        if (results[i] == NETCHUNK_SUCCESS || results[i] == NETCHUNK_ERROR_FILE_NOT_FOUND) {
+            queue->stats.deleted++;
+            free(item->remote_path);
+            continue;
+        }
+
+        item->attempts++;
+        if (item->attempts < NETCHUNK_DELETE_QUEUE_MAX_ATTEMPTS) {
+            item->retry_at = queue->flushing > 0 ? 0 : now + ((time_t)NETCHUNK_DELETE_QUEUE_RETRY_DELAY << (item->attempts - 1));
+            if (delete_queue_append_locked(queue, item) == NETCHUNK_SUCCESS) {
+                queue->stats.retried++;
+                continue;
+            }
+        }
+
+        queue->stats.abandoned++;
+        free(item->remote_path);
+    }
+
+    queue->in_flight -= count < queue->in_flight ? count : queue->in_flight;
+    pthread_cond_broadcast(&queue->changed);
+
+    pthread_mutex_unlock(&queue->mutex);
+}
+
+netchunk_error_t netchunk_delete_queue_flush(netchunk_delete_queue_t* queue)
+{
+    if (!queue) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    pthread_mutex_lock(&queue->mutex);
+
+    uint64_t abandoned = queue->stats.abandoned;
+    queue->flushing++;
+    for (size_t i = 0; i < queue->count; i++) {
+        queue->items[i].retry_at = 0;
+    }
+    pthread_cond_broadcast(&queue->changed);
+
+    while (queue->count > 0 || queue->in_flight > 0) {
+        if (queue->thread_running) {
+            pthread_cond_wait(&queue->changed, &queue->mutex);
+            continue;
+        }
+
+        pthread_mutex_unlock(&queue->mutex);
+        size_t sent = delete_queue_round(queue);
+        pthread_mutex_lock(&queue->mutex);
+
+        // Nothing could be sent, so waiting would not help either
+        if (sent == 0 && queue->in_flight == 0) {
+            break;
+        }
+    }
+
+    queue->flushing--;
+    netchunk_error_t error = (queue->stats.abandoned == abandoned && queue->count == 0)
+        ? NETCHUNK_SUCCESS
+        : NETCHUNK_ERROR_FTP;
+
+    pthread_mutex_unlock(&queue->mutex);
+    return error;
+}
+
+void netchunk_delete_queue_get_stats(netchunk_delete_queue_t* queue, netchunk_delete_queue_stats_t* stats)
+{
+    if (!queue || !stats) {
+        return;
+    }
+
+    pthread_mutex_lock(&queue->mutex);
+    *stats = queue->stats;
+    stats->pending = queue->count + queue->in_flight;
+    pthread_mutex_unlock(&queue->mutex);
+}
+
+void netchunk_delete_queue_cleanup(netchunk_delete_queue_t* queue)
+{
+    if (!queue) {
+        return;
+    }
+
+    pthread_mutex_lock(&queue->mutex);
+    bool joining = queue->thread_running;
+    queue->stopping = true;
+    pthread_cond_broadcast(&queue->changed);
+    pthread_mutex_unlock(&queue->mutex);
+
+    if (joining) {
+        pthread_join(queue->thread, NULL);
+    }
+
+    for (size_t i = 0; i < queue->count; i++) {
+        free(queue->items[i].remote_path);
+    }
+    free(queue->items);
+
+    pthread_cond_destroy(&queue->changed);
+    pthread_mutex_destroy(&queue->mutex);
+    memset(queue, 0, sizeof(netchunk_delete_queue_t));
+}
+
+// Internal helper functions
+
+static netchunk_error_t delete_queue_append_locked(netchunk_delete_queue_t* queue, const netchunk_delete_item_t* item)
+{
+    if (queue->count == queue->capacity) {
+        size_t new_capacity = queue->capacity ? queue->capacity * 2 : 256;
+        netchunk_delete_item_t* grown = realloc(queue->items, new_capacity * sizeof(netchunk_delete_item_t));
+        if (!grown) {
+            return NETCHUNK_ERROR_OUT_OF_MEMORY;
+        }
+        queue->items = grown;
+        queue->capacity = new_capacity;
+    }
+
+    queue->items[queue->count++] = *item;
+    return NETCHUNK_SUCCESS;
+}
+
+/**
+ * @brief Earliest time a queued removal may be sent
+ * @return false if nothing is queued
+ */
+static bool delete_queue_next_due_locked(const netchunk_delete_queue_t* queue, time_t* due)
+{
+    if (queue->count == 0) {
+        return false;
+    }
+
+    *due = queue->items[0].retry_at;
+    for (size_t i = 1; i < queue->count; i++) {
+        if (queue->items[i].retry_at < *due) {
+            *due = queue->items[i].retry_at;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Send the removals that are due, up to NETCHUNK_DELETE_QUEUE_ROUND_SIZE
+ * @return Number of removals sent
+ */
+static size_t delete_queue_round(netchunk_delete_queue_t* queue)
+{
+    netchunk_delete_item_t* items = malloc(NETCHUNK_DELETE_QUEUE_ROUND_SIZE * sizeof(netchunk_delete_item_t));
+    netchunk_ftp_delete_request_t* requests = malloc(NETCHUNK_DELETE_QUEUE_ROUND_SIZE * sizeof(netchunk_ftp_delete_request_t));
+    netchunk_error_t* results = malloc(NETCHUNK_DELETE_QUEUE_ROUND_SIZE * sizeof(netchunk_error_t));
+
+    size_t count = 0;
+    if (items && requests && results) {
+        count = netchunk_delete_queue_take(queue, time(NULL), items, NETCHUNK_DELETE_QUEUE_ROUND_SIZE);
+    }
+
+    if (count > 0) {
+        for (size_t i = 0; i < count; i++) {
+            requests[i].server_index = items[i].server_index;
+            requests[i].remote_path = items[i].remote_path;
+        }
+
+        netchunk_ftp_delete_many(queue->ftp_context, requests, count);
+
+        for (size_t i = 0; i < count; i++) {
+            results[i] = requests[i].result;
+        }
+        netchunk_delete_queue_settle(queue, items, results, count, time(NULL));
+    }
+
+    free(items);
+    free(requests);
+    free(results);
+    return count;
+}
+
+static void* delete_queue_worker(void* arg)
+{
+    netchunk_delete_queue_t* queue = (netchunk_delete_queue_t*)arg;
+
+    pthread_mutex_lock(&queue->mutex);
+    while (!queue->stopping) {
+        time_t due;
+        if (!delete_queue_next_due_locked(queue, &due)) {
+            pthread_cond_wait(&queue->changed, &queue->mutex);
+            continue;
+        }
+
+        if (due > time(NULL)) {
+            struct timespec deadline = { .tv_sec = due, .tv_nsec = 0 };
+            pthread_cond_timedwait(&queue->changed, &queue->mutex, &deadline);
+            continue;
+        }
+
+        pthread_mutex_unlock(&queue->mutex);
+        size_t sent = delete_queue_round(queue);
+        pthread_mutex_lock(&queue->mutex);
+
+        // Out of memory for the round; try again shortly
+        if (sent == 0 && !queue->stopping) {
+            struct timespec deadline = { .tv_sec = time(NULL) + 1, .tv_nsec = 0 };
+            pthread_cond_timedwait(&queue->changed, &queue->mutex, &deadline);
+        }
+    }
+    pthread_mutex_unlock(&queue->mutex);
+
+    return NULL;
+}
@@ -0,0 +1,620 @@
+/**
+ * @file disk_cache.c
+ * @brief Persistent local cache of chunk data
+ *
+ * Keeps fetched chunks on local disk, keyed by their hash, so files that
+ * are restored repeatedly, or share chunks with files restored before, are
+ * served without going over the network again.
+ */
+
+#include "disk_cache.h"
+#include "crypto.h"
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * @brief Chunk file found while indexing the directory
+ */
+typedef struct disk_cache_scan_entry {
+    uint8_t hash[NETCHUNK_HASH_LENGTH];
+    uint64_t size;
+    time_t modified;
+} disk_cache_scan_entry_t;
+
+// Internal helper functions
+static size_t cache_slot(const uint8_t* hash, size_t slot_count);
+static uint32_t* cache_find_slot(netchunk_disk_cache_t* cache, const uint8_t* hash, size_t* slot_out);
+static netchunk_error_t cache_grow_slots(netchunk_disk_cache_t* cache);
+static netchunk_error_t cache_add(netchunk_disk_cache_t* cache, const uint8_t* hash, uint64_t size);
+static void cache_remove_at(netchunk_disk_cache_t* cache, size_t position);
+static void cache_evict(netchunk_disk_cache_t* cache, uint64_t incoming);
+static netchunk_error_t cache_chunk_path(const netchunk_disk_cache_t* cache, const uint8_t* hash,
+    char* path, size_t path_size);
+static netchunk_error_t cache_scan(netchunk_disk_cache_t* cache);
+static int compare_scan_entries(const void* a, const void* b);
+static netchunk_error_t read_whole_file(const char* path, uint8_t* data, size_t size);
+static netchunk_error_t ensure_parent_directory(const char* file_path);
+
+netchunk_error_t netchunk_disk_cache_init(netchunk_disk_cache_t* cache,
+    const char* directory,
+    uint64_t capacity_bytes)
+{
+    if (!cache || !directory) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    memset(cache, 0, sizeof(netchunk_disk_cache_t));
+
+    netchunk_error_t error = netchunk_config_expand_path(directory, cache->directory, sizeof(cache->directory));
+    if (error != NETCHUNK_SUCCESS) {
+        return error;
+    }
+
+    cache->slots = calloc(NETCHUNK_DISK_CACHE_INITIAL_SLOTS, sizeof(uint32_t));
+    if (!cache->slots) {
+        return NETCHUNK_ERROR_OUT_OF_MEMORY;
+    }
+    cache->slot_count = NETCHUNK_DISK_CACHE_INITIAL_SLOTS;
+    cache->capacity_bytes = capacity_bytes;
+
+    error = cache_scan(cache);
+    if (error != NETCHUNK_SUCCESS) {
+        free(cache->entries);
+        free(cache->slots);
+        memset(cache, 0, sizeof(netchunk_disk_cache_t));
+        return error;
+    }
+
+    // The budget may have shrunk since the chunks were cached
+    cache_evict(cache, 0);
+
+    pthread_mutex_init(&cache->mutex, NULL);
+    return NETCHUNK_SUCCESS;
+}
+
+void netchunk_disk_cache_cleanup(netchunk_disk_cache_t* cache)
+{
+    if (!cache || !cache->slots) {
+        return;
+    }
+
+    pthread_mutex_destroy(&cache->mutex);
+    free(cache->entries);
+    free(cache->slots);
+    memset(cache, 0, sizeof(netchunk_disk_cache_t));
+}
+
+bool netchunk_disk_cache_contains(netchunk_disk_cache_t* cache, const uint8_t* hash)
+{
+    if (!cache || !cache->slots || !hash) {
+        return false;
+    }
+
+    pthread_mutex_lock(&cache->mutex);
+    bool found = cache_find_slot(cache, hash, NULL) != NULL;
+    pthread_mutex_unlock(&cache->mutex);
+    return found;
+}
+
+bool netchunk_disk_cache_lookup(netchunk_disk_cache_t* cache, const uint8_t* hash)
+{
+    if (!cache || !cache->slots || !hash) {
+        return false;
+    }
+
+    pthread_mutex_lock(&cache->mutex);
+    bool found = cache_find_slot(cache, hash, NULL) != NULL;
+    if (!found) {
+        cache->stats.misses++;
+    }
+    pthread_mutex_unlock(&cache->mutex);
+    return found;
+}
+
+netchunk_error_t netchunk_disk_cache_get(netchunk_disk_cache_t* cache,
+    const uint8_t* hash,
+    size_t size,
+    uint8_t** data_out)
+{
+    if (!cache || !cache->slots || !hash || !data_out) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    *data_out = NULL;
+
+    char path[NETCHUNK_MAX_PATH_LEN];
+    netchunk_error_t error = cache_chunk_path(cache, hash, path, sizeof(path));
+    if (error != NETCHUNK_SUCCESS) {
+        return error;
+    }
+
+    pthread_mutex_lock(&cache->mutex);
+    uint32_t* slot = cache_find_slot(cache, hash, NULL);
+    if (!slot || cache->entries[*slot - 1].size != size) {
+        cache->stats.misses++;
+        pthread_mutex_unlock(&cache->mutex);
+        return NETCHUNK_ERROR_FILE_NOT_FOUND;
+    }
+    pthread_mutex_unlock(&cache->mutex);
+
+    // Read and hash outside the lock; an open file survives eviction
+    uint8_t* data = malloc(size > 0 ? size : 1);
+    if (!data) {
+        return NETCHUNK_ERROR_OUT_OF_MEMORY;
+    }
+
+    error = read_whole_file(path, data, size);
+    if (error == NETCHUNK_SUCCESS) {
+        uint8_t computed[NETCHUNK_HASH_LENGTH];
+        error = netchunk_sha256_hash(data, size, computed);
+        if (error == NETCHUNK_SUCCESS && !netchunk_hash_compare(hash, computed, NETCHUNK_HASH_LENGTH)) {
+            error = NETCHUNK_ERROR_CHUNK_INTEGRITY;
+        }
+    }
+
+    pthread_mutex_lock(&cache->mutex);
+    slot = cache_find_slot(cache, hash, NULL);
+    if (error == NETCHUNK_SUCCESS) {
+        cache->stats.hits++;
+        if (slot) {
+            cache->entries[*slot - 1].referenced = true;
+        }
+    } else if (error == NETCHUNK_ERROR_FILE_NOT_FOUND || error == NETCHUNK_ERROR_OUT_OF_MEMORY) {
+        // Evicted by another process in the meantime
+        cache->stats.misses++;
+        if (slot && error == NETCHUNK_ERROR_FILE_NOT_FOUND) {
+            cache_remove_at(cache, *slot - 1);
+        }
+    } else {
+        cache->stats.corrupt++;
+        cache->stats.misses++;
+        if (slot) {
+            cache_remove_at(cache, *slot - 1);
+        }
+        unlink(path);
+        error = NETCHUNK_ERROR_CHUNK_INTEGRITY;
+    }
+    pthread_mutex_unlock(&cache->mutex);
+
+    if (error != NETCHUNK_SUCCESS) {
+        free(data);
+        return error;
+    }
+
+    *data_out = data;
+    return NETCHUNK_SUCCESS;
+}
+
+netchunk_error_t netchunk_disk_cache_put(netchunk_disk_cache_t* cache,
+    const uint8_t* hash,
+    const uint8_t* data,
+    size_t size)
+{
+    if (!cache || !cache->slots || !hash || (!data && size > 0)) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    if ((uint64_t)size > cache->capacity_bytes || netchunk_disk_cache_contains(cache, hash)) {
+        return NETCHUNK_SUCCESS;
+    }
+
+    char path[NETCHUNK_MAX_PATH_LEN];
+    char temp_path[NETCHUNK_MAX_PATH_LEN + 16];
+    netchunk_error_t error = cache_chunk_path(cache, hash, path, sizeof(path));
+    if (error == NETCHUNK_SUCCESS) {
+        error = ensure_parent_directory(path);
+    }
+    if (error != NETCHUNK_SUCCESS) {
+        return error;
+    }
+
+    // Write under a unique name and rename, so readers never see a partial chunk
+    snprintf(temp_path, sizeof(temp_path), "%s.XXXXXX", path);
+    int fd = mkstemp(temp_path);
+    if (fd < 0) {
+        return NETCHUNK_ERROR_FILE_ACCESS;
+    }
+
+    size_t written_total = 0;
+    while (written_total < size) {
+        ssize_t written = write(fd, data + written_total, size - written_total);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        written_total += (size_t)written;
+    }
+    if (close(fd) != 0 || written_total != size || rename(temp_path, path) != 0) {
+        unlink(temp_path);
+        return NETCHUNK_ERROR_FILE_ACCESS;
+    }
+
+    pthread_mutex_lock(&cache->mutex);
+    if (!cache_find_slot(cache, hash, NULL)) {
+        cache_evict(cache, size);
+        error = cache_add(cache, hash, size);
+        if (error == NETCHUNK_SUCCESS) {
+            cache->stats.insertions++;
+        }
+    }
+    pthread_mutex_unlock(&cache->mutex);
+
+    if (error != NETCHUNK_SUCCESS) {
+        unlink(path);
+    }
+    return error;
+}
+
+void netchunk_disk_cache_get_stats(netchunk_disk_cache_t* cache, netchunk_disk_cache_stats_t* stats)
+{
+    if (!stats) {
+        return;
+    }
+
+    memset(stats, 0, sizeof(netchunk_disk_cache_stats_t));
+    if (!cache || !cache->slots) {
+        return;
+    }
+
+    pthread_mutex_lock(&cache->mutex);
+    *stats = cache->stats;
+    pthread_mutex_unlock(&cache->mutex);
+}
+
+/**
+ * @brief Map a hash to its home slot
+ */
+static size_t cache_slot(const uint8_t* hash, size_t slot_count)
+{
+    uint64_t key = 0;
+    for (int i = 0; i < 8; i++) {
+        key = (key << 8) | hash[i];
+    }
+    return (size_t)(key & (uint64_t)(slot_count - 1));
+}
+
+/**
+ * @brief Linear probe for a hash
+ *
+ * Returns the slot holding it, or NULL with slot_out set to the empty
+ * slot where it would go.
+ */
+static uint32_t* cache_find_slot(netchunk_disk_cache_t* cache, const uint8_t* hash, size_t* slot_out)
+{
+    size_t mask = cache->slot_count - 1;
+    size_t i = cache_slot(hash, cache->slot_count);
+
+    while (cache->slots[i] != 0) {
+        if (memcmp(cache->entries[cache->slots[i] - 1].hash, hash, NETCHUNK_HASH_LENGTH) == 0) {
+            return &cache->slots[i];
+        }
+        i = (i + 1) & mask;
+    }
+
+    if (slot_out) {
+        *slot_out = i;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Double the slot count and reinsert every entry
+ */
+static netchunk_error_t cache_grow_slots(netchunk_disk_cache_t* cache)
+{
+    size_t slot_count = cache->slot_count * 2;
+    uint32_t* slots = calloc(slot_count, sizeof(uint32_t));
+    if (!slots) {
+        return NETCHUNK_ERROR_OUT_OF_MEMORY;
+    }
+
+    free(cache->slots);
+    cache->slots = slots;
+    cache->slot_count = slot_count;
+
+    for (size_t position = 0; position < cache->count; position++) {
+        size_t slot;
+        cache_find_slot(cache, cache->entries[position].hash, &slot);
+        cache->slots[slot] = (uint32_t)(position + 1);
+    }
+
+    return NETCHUNK_SUCCESS;
+}
+
+/**
+ * @brief Append a chunk to the clock ring, just behind the hand
+ */
+static netchunk_error_t cache_add(netchunk_disk_cache_t* cache, const uint8_t* hash, uint64_t size)
+{
+    if (cache->count >= UINT32_MAX - 1) {
+        return NETCHUNK_ERROR_OUT_OF_MEMORY;
+    }
+
+    // Keep probes short: grow once the table is half full
+    if ((cache->count + 1) * 2 > cache->slot_count && cache_grow_slots(cache) != NETCHUNK_SUCCESS) {
+        return NETCHUNK_ERROR_OUT_OF_MEMORY;
+    }
+
+    if (cache->count == cache->capacity) {
+        size_t new_capacity = cache->capacity ? cache->capacity * 2 : 256;
+        netchunk_disk_cache_entry_t* grown = realloc(cache->entries, new_capacity * sizeof(netchunk_disk_cache_entry_t));
+        if (!grown) {
+            return NETCHUNK_ERROR_OUT_OF_MEMORY;
+        }
+        cache->entries = grown;
+        cache->capacity = new_capacity;
+    }
+
+    // New chunks enter where the hand just was, so they get a full sweep
+    size_t position = cache->count++;
+    if (position > cache->hand) {
+        cache->entries[position] = cache->entries[cache->hand];
+        uint32_t* moved = cache_find_slot(cache, cache->entries[position].hash, NULL);
+        *moved = (uint32_t)(position + 1);
+        position = cache->hand++;
+    }
+
+    netchunk_disk_cache_entry_t* entry = &cache->entries[position];
+    memcpy(entry->hash, hash, NETCHUNK_HASH_LENGTH);
+    entry->size = size;
+    entry->referenced = false;
+
+    size_t slot;
+    cache_find_slot(cache, hash, &slot);
+    cache->slots[slot] = (uint32_t)(position + 1);
+
+    cache->stats.entries++;
+    cache->stats.bytes_used += size;
+    return NETCHUNK_SUCCESS;
+}
+
+/**
+ * @brief Drop the entry at a ring position from the index
+ *
+ * The last entry takes its place. The file itself is left alone.
+ */
+static void cache_remove_at(netchunk_disk_cache_t* cache, size_t position)
+{
+    size_t mask = cache->slot_count - 1;
+    size_t gap = (size_t)(cache_find_slot(cache, cache->entries[position].hash, NULL) - cache->slots);
+
+    // Backward-shift deletion keeps every probe sequence unbroken
+    for (size_t i = (gap + 1) & mask; cache->slots[i] != 0; i = (i + 1) & mask) {
+        size_t home = cache_slot(cache->entries[cache->slots[i] - 1].hash, cache->slot_count);
+        if (((i - home) & mask) >= ((i - gap) & mask)) {
+            cache->slots[gap] = cache->slots[i];
+            gap = i;
+        }
+    }
+    cache->slots[gap] = 0;
+
+    cache->stats.entries--;
+    cache->stats.bytes_used -= cache->entries[position].size;
+
+    size_t last = --cache->count;
+    if (position != last) {
+        cache->entries[position] = cache->entries[last];
+        uint32_t* moved = cache_find_slot(cache, cache->entries[position].hash, NULL);
+        *moved = (uint32_t)(position + 1);
+    }
+    if (cache->hand >= cache->count) {
+        cache->hand = 0;
+    }
+}
+
+/**
+ * @brief Evict chunks until incoming more bytes fit in the budget
+ *
+ * Must be called with the lock held, except during init.
+ */
+static void cache_evict(netchunk_disk_cache_t* cache, uint64_t incoming)
+{
+    while (cache->count > 0 && cache->stats.bytes_used + incoming > cache->capacity_bytes) {
+        netchunk_disk_cache_entry_t* entry = &cache->entries[cache->hand];
+        if (entry->referenced) {
+            entry->referenced = false;
+            cache->hand = (cache->hand + 1) % cache->count;
+            continue;
+        }
+
+        char path[NETCHUNK_MAX_PATH_LEN];
+        if (cache_chunk_path(cache, entry->hash, path, sizeof(path)) == NETCHUNK_SUCCESS) {
+            unlink(path);
+        }
+        cache_remove_at(cache, cache->hand);
+        cache->stats.evictions++;
+    }
+}
+
+/**
+ * @brief Build the file path of a chunk
+ */
+static netchunk_error_t cache_chunk_path(const netchunk_disk_cache_t* cache, const uint8_t* hash,
+    char* path, size_t path_size)
+{
+    char hex[NETCHUNK_HASH_LENGTH * 2 + 1];
+    netchunk_error_t error = netchunk_hash_to_hex_string(hash, NETCHUNK_HASH_LENGTH, hex);
+    if (error != NETCHUNK_SUCCESS) {
+        return error;
+    }
+
+    int written = snprintf(path, path_size, "%s/%.2s/%s", cache->directory, hex, hex);
+    if (written < 0 || (size_t)written >= path_size) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    return NETCHUNK_SUCCESS;
+}
+
+/**
+ * @brief Index the chunk files already in the cache directory, oldest first
+ */
+static netchunk_error_t cache_scan(netchunk_disk_cache_t* cache)
+{
+    DIR* top = opendir(cache->directory);
+    if (!top) {
+        return (errno == ENOENT) ? NETCHUNK_SUCCESS : NETCHUNK_ERROR_FILE_ACCESS;
+    }
+
+    disk_cache_scan_entry_t* found = NULL;
+    size_t found_count = 0;
+    size_t found_capacity = 0;
+    netchunk_error_t error = NETCHUNK_SUCCESS;
+
+    struct dirent* sub;
+    while (error == NETCHUNK_SUCCESS && (sub = readdir(top)) != NULL) {
+        if (strlen(sub->d_name) != 2 || sub->d_name[0] == '.') {
+            continue;
+        }
+
+        char sub_path[NETCHUNK_MAX_PATH_LEN];
+        int written = snprintf(sub_path, sizeof(sub_path), "%s/%s", cache->directory, sub->d_name);
+        if (written < 0 || (size_t)written >= sizeof(sub_path)) {
+            continue;
+        }
+
+        DIR* dir = opendir(sub_path);
+        if (!dir) {
+            continue;
+        }
+
+        struct dirent* file;
+        while (error == NETCHUNK_SUCCESS && (file = readdir(dir)) != NULL) {
+            char file_path[NETCHUNK_MAX_PATH_LEN];
+            written = snprintf(file_path, sizeof(file_path), "%s/%s", sub_path, file->d_name);
+            if (file->d_name[0] == '.' || written < 0 || (size_t)written >= sizeof(file_path)) {
+                continue;
+            }
+
+            // Leftover of a write that never got renamed into place
+            if (strlen(file->d_name) != NETCHUNK_HASH_LENGTH * 2) {
+                if (strchr(file->d_name, '.')) {
+                    unlink(file_path);
+                }
+                continue;
+            }
+
+            uint8_t hash[NETCHUNK_HASH_LENGTH];
+            struct stat st;
+            if (netchunk_hex_string_to_hash(file->d_name, hash, sizeof(hash)) != NETCHUNK_SUCCESS
+                || stat(file_path, &st) != 0 || !S_ISREG(st.st_mode)) {
+                continue;
+            }
+
+            if (found_count == found_capacity) {
+                size_t new_capacity = found_capacity ? found_capacity * 2 : 256;
+                disk_cache_scan_entry_t* grown = realloc(found, new_capacity * sizeof(disk_cache_scan_entry_t));
+                if (!grown) {
+                    error = NETCHUNK_ERROR_OUT_OF_MEMORY;
+                    break;
+                }
+                found = grown;
+                found_capacity = new_capacity;
+            }
+
+            memcpy(found[found_count].hash, hash, NETCHUNK_HASH_LENGTH);
+            found[found_count].size = (uint64_t)st.st_size;
+            found[found_count].modified = st.st_mtime;
+            found_count++;
+        }
+        closedir(dir);
+    }
+    closedir(top);
+
+    // Append in age order and start the hand at the oldest chunk
+    if (found_count > 1) {
+        qsort(found, found_count, sizeof(disk_cache_scan_entry_t), compare_scan_entries);
+    }
+    for (size_t i = 0; error == NETCHUNK_SUCCESS && i < found_count; i++) {
+        if (!cache_find_slot(cache, found[i].hash, NULL)) {
+            cache->hand = cache->count;
+            error = cache_add(cache, found[i].hash, found[i].size);
+        }
+    }
+    cache->hand = 0;
+
+    free(found);
+    return error;
+}
+
+/**
+ * @brief Order scanned chunks by modification time
+ */
+static int compare_scan_entries(const void* a, const void* b)
+{
+    const disk_cache_scan_entry_t* first = (const disk_cache_scan_entry_t*)a;
+    const disk_cache_scan_entry_t* second = (const disk_cache_scan_entry_t*)b;
+    return (first->modified > second->modified) - (first->modified < second->modified);
+}
+
+/**
+ * @brief Read exactly size bytes of a file that must be exactly that long
+ */
+static netchunk_error_t read_whole_file(const char* path, uint8_t* data, size_t size)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return (errno == ENOENT) ? NETCHUNK_ERROR_FILE_NOT_FOUND : NETCHUNK_ERROR_FILE_ACCESS;
+    }
+
+    size_t total = 0;
+    netchunk_error_t error = NETCHUNK_SUCCESS;
+    for (;;) {
+        // Ask for one byte more than expected to notice a longer file
+        uint8_t extra;
+        uint8_t* target = total < size ? data + total : &extra;
+        size_t wanted = total < size ? size - total : 1;
+        ssize_t got = read(fd, target, wanted);
+        if (got < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            error = NETCHUNK_ERROR_FILE_ACCESS;
+            break;
+        }
+        if (got == 0) {
+            break;
+        }
+        total += (size_t)got;
+        if (total > size) {
+            break;
+        }
+    }
+    close(fd);
+
+    if (error == NETCHUNK_SUCCESS && total != size) {
+        error = NETCHUNK_ERROR_CHUNK_INTEGRITY;
+    }
+    return error;
+}
+
+/**
+ * @brief Create every missing directory above a file path
+ */
+static netchunk_error_t ensure_parent_directory(const char* file_path)
+{
+    char path_copy[NETCHUNK_MAX_PATH_LEN];
+    strncpy(path_copy, file_path, sizeof(path_copy) - 1);
+    path_copy[sizeof(path_copy) - 1] = '\0';
+
+    for (char* p = path_copy + 1; *p; p++) {
+        if (*p == '/') {
+            *p = '\0';
+            if (mkdir(path_copy, 0755) != 0 && errno != EEXIST) {
+                return NETCHUNK_ERROR_FILE_ACCESS;
+            }
+            *p = '/';
+        }
+    }
+
+    return NETCHUNK_SUCCESS;
+}
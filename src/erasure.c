@@ -0,0 +1,585 @@
+/**
+ * @file erasure.c
+ * @brief Reed-Solomon erasure coding over GF(2^8)
+ *
+ * Stripes are systematic: data shards are stored as is and parity shards
+ * are rows of a Cauchy matrix applied to them. All the work is in
+ * multiply-and-add over whole regions, which the SIMD backends do with
+ * two 16-entry nibble tables per coefficient.
+ */
+
+#include "erasure.h"
+#include "compress.h"
+#include "ftp_client.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+// SIMD kernels are built with per-function target attributes, so the rest
+// of the library keeps the baseline instruction set
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define NETCHUNK_GF_HAVE_X86 1
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+#if defined(__GNUC__) && defined(__aarch64__) && defined(__ARM_NEON)
+#define NETCHUNK_GF_HAVE_NEON 1
+#include <arm_neon.h>
+#endif
+
+#define GF_POLYNOMIAL 0x11d // x^8 + x^4 + x^3 + x^2 + 1
+
+// Multiply-and-add a region by one coefficient
+typedef void (*gf_region_fn)(uint8_t* dst, const uint8_t* src, uint8_t coefficient, size_t size);
+
+// Log and antilog tables, and the active backend, set up once on first use
+static pthread_once_t gf_dispatch_once = PTHREAD_ONCE_INIT;
+static uint8_t gf_log[256];
+static uint8_t gf_exp[510]; // Doubled so exponent sums need no reduction
+static gf_region_fn gf_region = NULL;
+static netchunk_gf_backend_t gf_backend = NETCHUNK_GF_BACKEND_GENERIC;
+
+// Internal helper functions
+static void gf_dispatch_init(void);
+static void gf_dispatch_ensure(void);
+static gf_region_fn gf_backend_region(netchunk_gf_backend_t backend);
+static void gf_nibble_tables(uint8_t coefficient, uint8_t low[16], uint8_t high[16]);
+static void gf_region_generic(uint8_t* dst, const uint8_t* src, uint8_t coefficient, size_t size);
+#ifdef NETCHUNK_GF_HAVE_X86
+static void gf_region_ssse3(uint8_t* dst, const uint8_t* src, uint8_t coefficient, size_t size);
+static void gf_region_avx2(uint8_t* dst, const uint8_t* src, uint8_t coefficient, size_t size);
+static bool gf_cpu_has_ssse3(void);
+static bool gf_cpu_has_avx2(void);
+#endif
+#ifdef NETCHUNK_GF_HAVE_NEON
+static void gf_region_neon(uint8_t* dst, const uint8_t* src, uint8_t coefficient, size_t size);
+#endif
+static uint8_t gf_mul_raw(uint8_t a, uint8_t b);
+static uint8_t gf_inverse_raw(uint8_t a);
+static netchunk_error_t gf_invert_matrix(uint8_t* matrix, int n);
+
+// Field Arithmetic
+
+uint8_t netchunk_gf_mul(uint8_t a, uint8_t b)
+{
+    gf_dispatch_ensure();
+    return gf_mul_raw(a, b);
+}
+
+uint8_t netchunk_gf_inverse(uint8_t a)
+{
+    gf_dispatch_ensure();
+    return gf_inverse_raw(a);
+}
+
+void netchunk_gf_mul_add_region(uint8_t* dst, const uint8_t* src, uint8_t coefficient, size_t size)
+{
+    if (!dst || !src || size == 0 || coefficient == 0) {
+        return;
+    }
+
+    gf_dispatch_ensure();
+    gf_region(dst, src, coefficient, size);
+}
+
+// Reed-Solomon Coding
+
+uint8_t netchunk_ec_coefficient(int data_shards, int parity_index, int data_index)
+{
+    gf_dispatch_ensure();
+
+    // Parity rows use points data_shards.., data columns 0..; the sets are
+    // disjoint, so every entry 1 / (x ^ y) is defined
+    return gf_inverse_raw((uint8_t)((data_shards + parity_index) ^ data_index));
+}
+
+bool netchunk_ec_layout_valid(int data_shards, int parity_shards)
+{
+    return data_shards >= 1 && parity_shards >= 1 && data_shards + parity_shards <= NETCHUNK_EC_MAX_SHARDS;
+}
+
+netchunk_error_t netchunk_ec_encode(int data_shards,
+    int parity_shards,
+    const uint8_t* const* data,
+    uint8_t* const* parity,
+    size_t shard_size)
+{
+    if (!netchunk_ec_layout_valid(data_shards, parity_shards) || !data || !parity) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    for (int p = 0; p < parity_shards; p++) {
+        memset(parity[p], 0, shard_size);
+        for (int d = 0; d < data_shards; d++) {
+            netchunk_gf_mul_add_region(parity[p], data[d], netchunk_ec_coefficient(data_shards, p, d), shard_size);
+        }
+    }
+
+    return NETCHUNK_SUCCESS;
+}
+
+netchunk_error_t netchunk_ec_reconstruct(int data_shards,
+    int parity_shards,
+    uint8_t* const* shards,
+    const bool* present,
+    size_t shard_size)
+{
+    if (!netchunk_ec_layout_valid(data_shards, parity_shards) || !shards || !present) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    int total = data_shards + parity_shards;
+
+    // Any data_shards present shards will do; prefer data, which needs no decoding
+    int rows[NETCHUNK_EC_MAX_SHARDS];
+    int row_count = 0;
+    bool data_missing = false;
+    for (int i = 0; i < total && row_count < data_shards; i++) {
+        if (present[i]) {
+            rows[row_count++] = i;
+        } else if (i < data_shards) {
+            data_missing = true;
+        }
+    }
+    if (row_count < data_shards) {
+        return NETCHUNK_ERROR_CHUNK_INTEGRITY;
+    }
+
+    if (data_missing) {
+        // Generator rows of the shards used, inverted, map them back to the data
+        uint8_t matrix[NETCHUNK_EC_MAX_SHARDS * NETCHUNK_EC_MAX_SHARDS];
+        for (int r = 0; r < data_shards; r++) {
+            for (int c = 0; c < data_shards; c++) {
+                matrix[r * data_shards + c] = rows[r] < data_shards
+                    ? (uint8_t)(rows[r] == c)
+                    : netchunk_ec_coefficient(data_shards, rows[r] - data_shards, c);
+            }
+        }
+
+        netchunk_error_t error = gf_invert_matrix(matrix, data_shards);
+        if (error != NETCHUNK_SUCCESS) {
+            return error;
+        }
+
+        for (int d = 0; d < data_shards; d++) {
+            if (present[d]) {
+                continue;
+            }
+            memset(shards[d], 0, shard_size);
+            for (int r = 0; r < data_shards; r++) {
+                netchunk_gf_mul_add_region(shards[d], shards[rows[r]], matrix[d * data_shards + r], shard_size);
+            }
+        }
+    }
+
+    // With all data in place, missing parity is encoded afresh
+    for (int p = 0; p < parity_shards; p++) {
+        if (present[data_shards + p]) {
+            continue;
+        }
+        memset(shards[data_shards + p], 0, shard_size);
+        for (int d = 0; d < data_shards; d++) {
+            netchunk_gf_mul_add_region(shards[data_shards + p], shards[d],
+                netchunk_ec_coefficient(data_shards, p, d), shard_size);
+        }
+    }
+
+    return NETCHUNK_SUCCESS;
+}
+
+// Stripe Recovery
+
+netchunk_error_t netchunk_ec_recover_stripe(netchunk_ftp_context_t* ftp_context,
+    const netchunk_file_manifest_t* manifest,
+    uint32_t stripe,
+    uint8_t* const* shards,
+    bool* present,
+    size_t shard_size)
+{
+    if (!ftp_context || !netchunk_manifest_is_erasure_coded(manifest) || !shards || !present
+        || stripe >= netchunk_manifest_stripe_count(manifest)) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    int data_shards = manifest->ec_data_shards;
+    int total = data_shards + manifest->ec_parity_shards;
+
+    // Data missing from a short last stripe is zeros and always at hand
+    int available = 0;
+    for (int i = 0; i < total; i++) {
+        const netchunk_chunk_t* chunk = netchunk_manifest_stripe_shard(manifest, stripe, i);
+        if (!present[i] && !chunk && i < data_shards) {
+            memset(shards[i], 0, shard_size);
+            present[i] = true;
+        }
+        if (present[i]) {
+            available++;
+        }
+    }
+
+    // Fetch only as many verified shards as decoding needs
+    for (int i = 0; i < total && available < data_shards; i++) {
+        const netchunk_chunk_t* chunk = netchunk_manifest_stripe_shard(manifest, stripe, i);
+        if (present[i] || !chunk || chunk->size > shard_size) {
+            continue;
+        }
+
+        // Shards are coded over raw bytes, so encrypted ones are decoded into place
+        netchunk_chunk_t copy = *chunk;
+        copy.data = NULL;
+        copy.data_owned = false;
+        if (netchunk_ftp_download_chunk_any(ftp_context, &copy, NULL) == NETCHUNK_SUCCESS
+            && netchunk_chunk_decode(&copy, shards[i]) == NETCHUNK_SUCCESS
+            && netchunk_chunk_verify_raw(&copy, shards[i]) == NETCHUNK_SUCCESS) {
+            memset(shards[i] + copy.size, 0, shard_size - copy.size);
+            present[i] = true;
+            available++;
+        }
+        netchunk_chunk_cleanup(&copy);
+    }
+
+    netchunk_error_t error = netchunk_ec_reconstruct(data_shards, manifest->ec_parity_shards, shards, present, shard_size);
+    if (error != NETCHUNK_SUCCESS) {
+        return error;
+    }
+
+    for (int i = 0; i < total; i++) {
+        present[i] = true;
+    }
+    return NETCHUNK_SUCCESS;
+}
+
+// Backend Selection
+
+bool netchunk_gf_backend_available(netchunk_gf_backend_t backend)
+{
+    switch (backend) {
+    case NETCHUNK_GF_BACKEND_AUTO:
+    case NETCHUNK_GF_BACKEND_GENERIC:
+        return true;
+#ifdef NETCHUNK_GF_HAVE_X86
+    case NETCHUNK_GF_BACKEND_SSSE3:
+        return gf_cpu_has_ssse3();
+    case NETCHUNK_GF_BACKEND_AVX2:
+        return gf_cpu_has_avx2();
+#endif
+#ifdef NETCHUNK_GF_HAVE_NEON
+    case NETCHUNK_GF_BACKEND_NEON:
+        return true;
+#endif
+    default:
+        return false;
+    }
+}
+
+netchunk_error_t netchunk_gf_set_backend(netchunk_gf_backend_t backend)
+{
+    if (backend < NETCHUNK_GF_BACKEND_AUTO || backend >= NETCHUNK_GF_BACKEND_COUNT) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    if (!netchunk_gf_backend_available(backend)) {
+        return NETCHUNK_ERROR_CRYPTO;
+    }
+
+    gf_dispatch_ensure();
+
+    if (backend == NETCHUNK_GF_BACKEND_AUTO) {
+        gf_dispatch_init();
+    } else {
+        gf_backend = backend;
+        gf_region = gf_backend_region(backend);
+    }
+
+    return NETCHUNK_SUCCESS;
+}
+
+netchunk_gf_backend_t netchunk_gf_get_backend(void)
+{
+    gf_dispatch_ensure();
+    return gf_backend;
+}
+
+const char* netchunk_gf_backend_name(netchunk_gf_backend_t backend)
+{
+    switch (backend) {
+    case NETCHUNK_GF_BACKEND_AUTO:
+        return "auto";
+    case NETCHUNK_GF_BACKEND_GENERIC:
+        return "generic";
+    case NETCHUNK_GF_BACKEND_SSSE3:
+        return "ssse3";
+    case NETCHUNK_GF_BACKEND_AVX2:
+        return "avx2";
+    case NETCHUNK_GF_BACKEND_NEON:
+        return "neon";
+    default:
+        return "unknown";
+    }
+}
+
+// Internal helper function implementations
+
+static uint8_t gf_mul_raw(uint8_t a, uint8_t b)
+{
+    if (a == 0 || b == 0) {
+        return 0;
+    }
+    return gf_exp[gf_log[a] + gf_log[b]];
+}
+
+static uint8_t gf_inverse_raw(uint8_t a)
+{
+    if (a == 0) {
+        return 0;
+    }
+    return gf_exp[255 - gf_log[a]];
+}
+
+/**
+ * @brief Invert an n x n matrix in place by Gauss-Jordan elimination
+ * @return NETCHUNK_SUCCESS, or NETCHUNK_ERROR_CHUNK_INTEGRITY if singular
+ */
+static netchunk_error_t gf_invert_matrix(uint8_t* matrix, int n)
+{
+    uint8_t inverse[NETCHUNK_EC_MAX_SHARDS * NETCHUNK_EC_MAX_SHARDS];
+    memset(inverse, 0, sizeof(inverse));
+    for (int i = 0; i < n; i++) {
+        inverse[i * n + i] = 1;
+    }
+
+    for (int col = 0; col < n; col++) {
+        int pivot = col;
+        while (pivot < n && matrix[pivot * n + col] == 0) {
+            pivot++;
+        }
+        if (pivot == n) {
+            return NETCHUNK_ERROR_CHUNK_INTEGRITY;
+        }
+
+        if (pivot != col) {
+            for (int c = 0; c < n; c++) {
+                uint8_t t = matrix[col * n + c];
+                matrix[col * n + c] = matrix[pivot * n + c];
+                matrix[pivot * n + c] = t;
+                t = inverse[col * n + c];
+                inverse[col * n + c] = inverse[pivot * n + c];
+                inverse[pivot * n + c] = t;
+            }
+        }
+
+        uint8_t scale = gf_inverse_raw(matrix[col * n + col]);
+        for (int c = 0; c < n; c++) {
+            matrix[col * n + c] = gf_mul_raw(matrix[col * n + c], scale);
+            inverse[col * n + c] = gf_mul_raw(inverse[col * n + c], scale);
+        }
+
+        for (int r = 0; r < n; r++) {
+            uint8_t factor = matrix[r * n + col];
+            if (r == col || factor == 0) {
+                continue;
+            }
+            for (int c = 0; c < n; c++) {
+                matrix[r * n + c] ^= gf_mul_raw(factor, matrix[col * n + c]);
+                inverse[r * n + c] ^= gf_mul_raw(factor, inverse[col * n + c]);
+            }
+        }
+    }
+
+    memcpy(matrix, inverse, (size_t)n * (size_t)n);
+    return NETCHUNK_SUCCESS;
+}
+
+/**
+ * @brief Products of a coefficient with every low nibble and every high nibble
+ *
+ * c * x = c * (x & 0x0f) ^ c * (x & 0xf0), so two 16-byte lookups give the
+ * product of any byte.
+ */
+static void gf_nibble_tables(uint8_t coefficient, uint8_t low[16], uint8_t high[16])
+{
+    for (int i = 0; i < 16; i++) {
+        low[i] = gf_mul_raw(coefficient, (uint8_t)i);
+        high[i] = gf_mul_raw(coefficient, (uint8_t)(i << 4));
+    }
+}
+
+// GF(2^8) backend implementations
+
+static void gf_region_generic(uint8_t* dst, const uint8_t* src, uint8_t coefficient, size_t size)
+{
+    if (coefficient == 1) {
+        for (size_t i = 0; i < size; i++) {
+            dst[i] ^= src[i];
+        }
+        return;
+    }
+
+    uint8_t product[256];
+    for (int i = 0; i < 256; i++) {
+        product[i] = gf_mul_raw(coefficient, (uint8_t)i);
+    }
+    for (size_t i = 0; i < size; i++) {
+        dst[i] ^= product[src[i]];
+    }
+}
+
+#ifdef NETCHUNK_GF_HAVE_X86
+
+__attribute__((target("ssse3"))) static void gf_region_ssse3(uint8_t* dst, const uint8_t* src, uint8_t coefficient, size_t size)
+{
+    uint8_t low[16], high[16];
+    gf_nibble_tables(coefficient, low, high);
+
+    __m128i low_table = _mm_loadu_si128((const __m128i*)low);
+    __m128i high_table = _mm_loadu_si128((const __m128i*)high);
+    __m128i mask = _mm_set1_epi8(0x0f);
+
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        __m128i in = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i lo = _mm_and_si128(in, mask);
+        __m128i hi = _mm_and_si128(_mm_srli_epi64(in, 4), mask);
+        __m128i product = _mm_xor_si128(_mm_shuffle_epi8(low_table, lo), _mm_shuffle_epi8(high_table, hi));
+        __m128i out = _mm_loadu_si128((const __m128i*)(dst + i));
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_xor_si128(out, product));
+    }
+
+    if (i < size) {
+        gf_region_generic(dst + i, src + i, coefficient, size - i);
+    }
+}
+
+__attribute__((target("avx2"))) static void gf_region_avx2(uint8_t* dst, const uint8_t* src, uint8_t coefficient, size_t size)
+{
+    uint8_t low[16], high[16];
+    gf_nibble_tables(coefficient, low, high);
+
+    // VPSHUFB looks up within each 128-bit lane, so both lanes get the table
+    __m256i low_table = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)low));
+    __m256i high_table = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)high));
+    __m256i mask = _mm256_set1_epi8(0x0f);
+
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        __m256i in = _mm256_loadu_si256((const __m256i*)(src + i));
+        __m256i lo = _mm256_and_si256(in, mask);
+        __m256i hi = _mm256_and_si256(_mm256_srli_epi64(in, 4), mask);
+        __m256i product = _mm256_xor_si256(_mm256_shuffle_epi8(low_table, lo), _mm256_shuffle_epi8(high_table, hi));
+        __m256i out = _mm256_loadu_si256((const __m256i*)(dst + i));
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_xor_si256(out, product));
+    }
+
+    if (i < size) {
+        gf_region_generic(dst + i, src + i, coefficient, size - i);
+    }
+}
+
+static bool gf_cpu_has_ssse3(void)
+{
+    unsigned int eax, ebx, ecx, edx;
+
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+        return false;
+    }
+    return (ecx & bit_SSSE3) != 0;
+}
+
+static bool gf_cpu_has_avx2(void)
+{
+    unsigned int eax, ebx, ecx, edx;
+
+    // AVX2 also needs the OS to save YMM registers
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || !(ecx & bit_OSXSAVE) || !(ecx & bit_AVX)) {
+        return false;
+    }
+    unsigned int xcr0_low, xcr0_high;
+    __asm__ volatile("xgetbv" : "=a"(xcr0_low), "=d"(xcr0_high) : "c"(0));
+    (void)xcr0_high;
+    if ((xcr0_low & 0x6) != 0x6) {
+        return false;
+    }
+    if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+        return false;
+    }
+    return (ebx & bit_AVX2) != 0;
+}
+
+#endif // NETCHUNK_GF_HAVE_X86
+
+#ifdef NETCHUNK_GF_HAVE_NEON
+
+static void gf_region_neon(uint8_t* dst, const uint8_t* src, uint8_t coefficient, size_t size)
+{
+    uint8_t low[16], high[16];
+    gf_nibble_tables(coefficient, low, high);
+
+    uint8x16_t low_table = vld1q_u8(low);
+    uint8x16_t high_table = vld1q_u8(high);
+    uint8x16_t mask = vdupq_n_u8(0x0f);
+
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        uint8x16_t in = vld1q_u8(src + i);
+        uint8x16_t product = veorq_u8(vqtbl1q_u8(low_table, vandq_u8(in, mask)),
+            vqtbl1q_u8(high_table, vshrq_n_u8(in, 4)));
+        vst1q_u8(dst + i, veorq_u8(vld1q_u8(dst + i), product));
+    }
+
+    if (i < size) {
+        gf_region_generic(dst + i, src + i, coefficient, size - i);
+    }
+}
+
+#endif // NETCHUNK_GF_HAVE_NEON
+
+// Backend dispatch
+
+static gf_region_fn gf_backend_region(netchunk_gf_backend_t backend)
+{
+    switch (backend) {
+#ifdef NETCHUNK_GF_HAVE_X86
+    case NETCHUNK_GF_BACKEND_SSSE3:
+        return gf_region_ssse3;
+    case NETCHUNK_GF_BACKEND_AVX2:
+        return gf_region_avx2;
+#endif
+#ifdef NETCHUNK_GF_HAVE_NEON
+    case NETCHUNK_GF_BACKEND_NEON:
+        return gf_region_neon;
+#endif
+    default:
+        return gf_region_generic;
+    }
+}
+
+static void gf_dispatch_init(void)
+{
+    // 2 generates the multiplicative group of GF(2^8) under 0x11d
+    unsigned int value = 1;
+    for (int i = 0; i < 255; i++) {
+        gf_exp[i] = (uint8_t)value;
+        gf_exp[i + 255] = (uint8_t)value;
+        gf_log[value] = (uint8_t)i;
+        value <<= 1;
+        if (value & 0x100) {
+            value ^= GF_POLYNOMIAL;
+        }
+    }
+
+    gf_backend = NETCHUNK_GF_BACKEND_GENERIC;
+    if (netchunk_gf_backend_available(NETCHUNK_GF_BACKEND_AVX2)) {
+        gf_backend = NETCHUNK_GF_BACKEND_AVX2;
+    } else if (netchunk_gf_backend_available(NETCHUNK_GF_BACKEND_SSSE3)) {
+        gf_backend = NETCHUNK_GF_BACKEND_SSSE3;
+    } else if (netchunk_gf_backend_available(NETCHUNK_GF_BACKEND_NEON)) {
+        gf_backend = NETCHUNK_GF_BACKEND_NEON;
+    }
+    gf_region = gf_backend_region(gf_backend);
+}
+
+static void gf_dispatch_ensure(void)
+{
+    pthread_once(&gf_dispatch_once, gf_dispatch_init);
+}
@@ -0,0 +1,476 @@
+/**
+ * @file fxp.c
+ * @brief Server-to-server (FXP) file copies
+ *
+ * libcurl cannot drive two control connections against each other, so
+ * copies run over small blocking control clients of their own. The data
+ * connection goes straight from the source server to the target.
+ */
+
+#include "fxp.h"
+#include "ftp_client.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// One FTP control connection
+typedef struct fxp_control {
+    int fd;
+    char buffer[NETCHUNK_FXP_REPLY_MAX]; // Received, not yet returned as lines
+    size_t length;
+    int timeout_ms; // Wait for each reply line
+} fxp_control_t;
+
+// Internal helper functions
+static netchunk_error_t fxp_connect(fxp_control_t* control, const netchunk_server_t* server, int timeout_ms);
+static netchunk_error_t fxp_login(fxp_control_t* control, const netchunk_server_t* server);
+static netchunk_error_t fxp_send(fxp_control_t* control, const char* format, ...);
+static netchunk_error_t fxp_read_line(fxp_control_t* control, char* line, size_t line_len, int timeout_ms);
+static netchunk_error_t fxp_read_reply(fxp_control_t* control, int* code, char* text, size_t text_len, int timeout_ms);
+static netchunk_error_t fxp_command(fxp_control_t* control, int* code, char* text, size_t text_len, const char* format, ...);
+static netchunk_error_t fxp_make_parent_dirs(fxp_control_t* control, const char* path);
+static netchunk_error_t fxp_expect_preliminary(fxp_control_t* control, int timeout_ms);
+static netchunk_error_t fxp_expect_complete(fxp_control_t* control, int timeout_ms);
+static void fxp_close(fxp_control_t* control);
+
+bool netchunk_fxp_supported(const netchunk_server_t* source, const netchunk_server_t* target)
+{
+    if (!source || !target || source == target) {
+        return false;
+    }
+
+    return source->fxp && target->fxp && !source->use_ssl && !target->use_ssl;
+}
+
+netchunk_error_t netchunk_fxp_copy(const netchunk_server_t* source,
+    const netchunk_server_t* target,
+    const char* remote_path,
+    uint64_t size,
+    int timeout)
+{
+    if (!netchunk_fxp_supported(source, target) || !remote_path || timeout <= 0) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    char source_path[NETCHUNK_MAX_PATH_LEN];
+    char target_path[NETCHUNK_MAX_PATH_LEN];
+    netchunk_error_t error = netchunk_ftp_build_remote_path(source, remote_path, source_path, sizeof(source_path));
+    if (error == NETCHUNK_SUCCESS) {
+        error = netchunk_ftp_build_remote_path(target, remote_path, target_path, sizeof(target_path));
+    }
+    if (error != NETCHUNK_SUCCESS) {
+        return error;
+    }
+
+    int timeout_ms = timeout * 1000;
+    fxp_control_t source_control = { .fd = -1 };
+    fxp_control_t target_control = { .fd = -1 };
+
+    error = fxp_connect(&source_control, source, timeout_ms);
+    if (error == NETCHUNK_SUCCESS) {
+        error = fxp_connect(&target_control, target, timeout_ms);
+    }
+    if (error == NETCHUNK_SUCCESS) {
+        error = fxp_login(&source_control, source);
+    }
+    if (error == NETCHUNK_SUCCESS) {
+        error = fxp_login(&target_control, target);
+    }
+    if (error == NETCHUNK_SUCCESS) {
+        error = fxp_make_parent_dirs(&target_control, target_path);
+    }
+
+    // The target listens, the source connects to it
+    int code = 0;
+    char reply[NETCHUNK_FXP_REPLY_MAX];
+    int numbers[6];
+    if (error == NETCHUNK_SUCCESS) {
+        error = fxp_command(&target_control, &code, reply, sizeof(reply), "PASV");
+        if (error == NETCHUNK_SUCCESS && code != 227) {
+            error = NETCHUNK_ERROR_FTP;
+        }
+    }
+    if (error == NETCHUNK_SUCCESS) {
+        error = netchunk_fxp_parse_pasv(reply, numbers);
+    }
+
+    // A target behind NAT may report 0.0.0.0; use the address it was reached at
+    if (error == NETCHUNK_SUCCESS && numbers[0] == 0 && numbers[1] == 0 && numbers[2] == 0 && numbers[3] == 0) {
+        struct sockaddr_in peer;
+        socklen_t peer_len = sizeof(peer);
+        if (getpeername(target_control.fd, (struct sockaddr*)&peer, &peer_len) == 0 && peer.sin_family == AF_INET) {
+            uint32_t address = ntohl(peer.sin_addr.s_addr);
+            for (int i = 0; i < 4; i++) {
+                numbers[i] = (int)((address >> (24 - 8 * i)) & 0xff);
+            }
+        }
+    }
+
+    if (error == NETCHUNK_SUCCESS) {
+        error = fxp_command(&source_control, &code, reply, sizeof(reply), "PORT %d,%d,%d,%d,%d,%d",
+            numbers[0], numbers[1], numbers[2], numbers[3], numbers[4], numbers[5]);
+        if (error == NETCHUNK_SUCCESS && code != 200) {
+            error = NETCHUNK_ERROR_FTP;
+        }
+    }
+
+    // Start both sides before waiting on either, since a passive target
+    // may only answer once the source has connected
+    if (error == NETCHUNK_SUCCESS) {
+        error = fxp_send(&target_control, "STOR %s", target_path);
+    }
+    if (error == NETCHUNK_SUCCESS) {
+        error = fxp_send(&source_control, "RETR %s", source_path);
+    }
+    if (error == NETCHUNK_SUCCESS) {
+        error = fxp_expect_preliminary(&source_control, timeout_ms);
+    }
+    if (error == NETCHUNK_SUCCESS) {
+        error = fxp_expect_preliminary(&target_control, timeout_ms);
+    }
+
+    // The control connections stay silent while the data moves
+    uint64_t transfer_ms = (uint64_t)timeout_ms + size * 1000 / NETCHUNK_FXP_MIN_RATE;
+    int complete_ms = transfer_ms > (uint64_t)INT32_MAX ? INT32_MAX : (int)transfer_ms;
+    if (error == NETCHUNK_SUCCESS) {
+        error = fxp_expect_complete(&source_control, complete_ms);
+    }
+    if (error == NETCHUNK_SUCCESS) {
+        error = fxp_expect_complete(&target_control, complete_ms);
+    }
+
+    fxp_close(&source_control);
+    fxp_close(&target_control);
+    return error;
+}
+
+netchunk_error_t netchunk_fxp_parse_pasv(const char* reply, int numbers[6])
+{
+    if (!reply || !numbers) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    // The numbers follow the first digit after the code, parenthesized or not
+    const char* p = reply;
+    if (strncmp(p, "227", 3) == 0) {
+        p += 3;
+    }
+    while (*p && (*p < '0' || *p > '9')) {
+        p++;
+    }
+
+    int consumed = 0;
+    if (sscanf(p, "%d,%d,%d,%d,%d,%d%n", &numbers[0], &numbers[1], &numbers[2],
+            &numbers[3], &numbers[4], &numbers[5], &consumed)
+            != 6
+        || consumed == 0) {
+        return NETCHUNK_ERROR_FTP;
+    }
+
+    for (int i = 0; i < 6; i++) {
+        if (numbers[i] < 0 || numbers[i] > 255) {
+            return NETCHUNK_ERROR_FTP;
+        }
+    }
+
+    return NETCHUNK_SUCCESS;
+}
+
+/**
+ * @brief Open a control connection and read the greeting
+ */
+static netchunk_error_t fxp_connect(fxp_control_t* control, const netchunk_server_t* server, int timeout_ms)
+{
+    char port[16];
+    snprintf(port, sizeof(port), "%u", server->port ? server->port : 21);
+
+    // PORT and PASV carry IPv4 addresses only
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+
+    struct addrinfo* addresses = NULL;
+    if (getaddrinfo(server->host, port, &hints, &addresses) != 0 || !addresses) {
+        return NETCHUNK_ERROR_NETWORK;
+    }
+
+    netchunk_error_t error = NETCHUNK_ERROR_NETWORK;
+    for (struct addrinfo* address = addresses; address && error != NETCHUNK_SUCCESS; address = address->ai_next) {
+        int fd = socket(address->ai_family, address->ai_socktype | SOCK_CLOEXEC, address->ai_protocol);
+        if (fd < 0) {
+            continue;
+        }
+
+        // Connect without blocking so the timeout applies
+        int flags = fcntl(fd, F_GETFL, 0);
+        fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+        int result = connect(fd, address->ai_addr, address->ai_addrlen);
+        if (result != 0 && errno == EINPROGRESS) {
+            struct pollfd pfd = { .fd = fd, .events = POLLOUT };
+            int socket_error = 0;
+            socklen_t error_len = sizeof(socket_error);
+            if (poll(&pfd, 1, timeout_ms) == 1
+                && getsockopt(fd, SOL_SOCKET, SO_ERROR, &socket_error, &error_len) == 0
+                && socket_error == 0) {
+                result = 0;
+            }
+        }
+        fcntl(fd, F_SETFL, flags);
+
+        if (result == 0) {
+            control->fd = fd;
+            error = NETCHUNK_SUCCESS;
+        } else {
+            close(fd);
+        }
+    }
+    freeaddrinfo(addresses);
+
+    if (error != NETCHUNK_SUCCESS) {
+        return error;
+    }
+
+    control->length = 0;
+    control->timeout_ms = timeout_ms;
+
+    // 120 means "ready in a moment", another reply follows
+    int code = 0;
+    do {
+        error = fxp_read_reply(control, &code, NULL, 0, timeout_ms);
+    } while (error == NETCHUNK_SUCCESS && code == 120);
+
+    return error == NETCHUNK_SUCCESS && code != 220 ? NETCHUNK_ERROR_FTP : error;
+}
+
+/**
+ * @brief Log in and switch to binary transfers
+ */
+static netchunk_error_t fxp_login(fxp_control_t* control, const netchunk_server_t* server)
+{
+    int code = 0;
+    netchunk_error_t error = fxp_command(control, &code, NULL, 0, "USER %s", server->username);
+    if (error == NETCHUNK_SUCCESS && code == 331) {
+        error = fxp_command(control, &code, NULL, 0, "PASS %s", server->password);
+    }
+    if (error == NETCHUNK_SUCCESS && code != 230 && code != 202) {
+        return NETCHUNK_ERROR_FTP;
+    }
+
+    if (error == NETCHUNK_SUCCESS) {
+        error = fxp_command(control, &code, NULL, 0, "TYPE I");
+        if (error == NETCHUNK_SUCCESS && code != 200) {
+            error = NETCHUNK_ERROR_FTP;
+        }
+    }
+
+    return error;
+}
+
+/**
+ * @brief Send one command line
+ */
+static netchunk_error_t fxp_send(fxp_control_t* control, const char* format, ...)
+{
+    char line[NETCHUNK_MAX_PATH_LEN + 16];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(line, sizeof(line) - 2, format, args);
+    va_end(args);
+
+    if (length < 0 || length >= (int)sizeof(line) - 2 || strpbrk(line, "\r\n")) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+    line[length++] = '\r';
+    line[length++] = '\n';
+
+    size_t sent = 0;
+    while (sent < (size_t)length) {
+        ssize_t result = send(control->fd, line + sent, (size_t)length - sent, MSG_NOSIGNAL);
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        if (result <= 0) {
+            return NETCHUNK_ERROR_NETWORK;
+        }
+        sent += (size_t)result;
+    }
+
+    return NETCHUNK_SUCCESS;
+}
+
+/**
+ * @brief Read one reply line without its line ending; overlong lines are cut
+ */
+static netchunk_error_t fxp_read_line(fxp_control_t* control, char* line, size_t line_len, int timeout_ms)
+{
+    for (;;) {
+        char* newline = memchr(control->buffer, '\n', control->length);
+        if (newline || control->length == sizeof(control->buffer)) {
+            size_t consumed = newline ? (size_t)(newline - control->buffer) + 1 : control->length;
+            size_t length = newline ? consumed - 1 : consumed;
+            if (length > 0 && control->buffer[length - 1] == '\r') {
+                length--;
+            }
+            if (length >= line_len) {
+                length = line_len - 1;
+            }
+            memcpy(line, control->buffer, length);
+            line[length] = '\0';
+
+            memmove(control->buffer, control->buffer + consumed, control->length - consumed);
+            control->length -= consumed;
+            return NETCHUNK_SUCCESS;
+        }
+
+        struct pollfd pfd = { .fd = control->fd, .events = POLLIN };
+        int ready = poll(&pfd, 1, timeout_ms);
+        if (ready < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ready == 0) {
+            return NETCHUNK_ERROR_TIMEOUT;
+        }
+        if (ready < 0) {
+            return NETCHUNK_ERROR_NETWORK;
+        }
+
+        ssize_t received = recv(control->fd, control->buffer + control->length,
+            sizeof(control->buffer) - control->length, 0);
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received <= 0) {
+            return NETCHUNK_ERROR_NETWORK;
+        }
+        control->length += (size_t)received;
+    }
+}
+
+/**
+ * @brief Read a complete, possibly multi-line reply
+ */
+static netchunk_error_t fxp_read_reply(fxp_control_t* control, int* code, char* text, size_t text_len, int timeout_ms)
+{
+    char line[NETCHUNK_FXP_REPLY_MAX];
+    netchunk_error_t error = fxp_read_line(control, line, sizeof(line), timeout_ms);
+    if (error != NETCHUNK_SUCCESS) {
+        return error;
+    }
+
+    if (strlen(line) < 3 || line[0] < '1' || line[0] > '5' || line[1] < '0' || line[1] > '9'
+        || line[2] < '0' || line[2] > '9') {
+        return NETCHUNK_ERROR_FTP;
+    }
+    *code = (line[0] - '0') * 100 + (line[1] - '0') * 10 + (line[2] - '0');
+
+    // "123-" opens a multi-line reply that ends with "123 "
+    if (line[3] == '-') {
+        char last[4];
+        memcpy(last, line, 3);
+        last[3] = ' ';
+        do {
+            error = fxp_read_line(control, line, sizeof(line), timeout_ms);
+        } while (error == NETCHUNK_SUCCESS && strncmp(line, last, 4) != 0);
+        if (error != NETCHUNK_SUCCESS) {
+            return error;
+        }
+    }
+
+    if (text && text_len > 0) {
+        snprintf(text, text_len, "%s", line);
+    }
+    return NETCHUNK_SUCCESS;
+}
+
+/**
+ * @brief Send a command and read its reply
+ */
+static netchunk_error_t fxp_command(fxp_control_t* control, int* code, char* text, size_t text_len, const char* format, ...)
+{
+    char line[NETCHUNK_MAX_PATH_LEN + 16];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    if (length < 0 || length >= (int)sizeof(line)) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    netchunk_error_t error = fxp_send(control, "%s", line);
+    if (error != NETCHUNK_SUCCESS) {
+        return error;
+    }
+    return fxp_read_reply(control, code, text, text_len, control->timeout_ms);
+}
+
+/**
+ * @brief Create every directory above a path; existing ones are fine
+ */
+static netchunk_error_t fxp_make_parent_dirs(fxp_control_t* control, const char* path)
+{
+    char directory[NETCHUNK_MAX_PATH_LEN];
+    snprintf(directory, sizeof(directory), "%s", path);
+
+    for (char* slash = strchr(directory + 1, '/'); slash; slash = strchr(slash + 1, '/')) {
+        *slash = '\0';
+        int code = 0;
+        netchunk_error_t error = fxp_command(control, &code, NULL, 0, "MKD %s", directory);
+        *slash = '/';
+        if (error != NETCHUNK_SUCCESS) {
+            return error;
+        }
+    }
+
+    return NETCHUNK_SUCCESS;
+}
+
+/**
+ * @brief Wait for the 1xx reply that opens a data transfer
+ */
+static netchunk_error_t fxp_expect_preliminary(fxp_control_t* control, int timeout_ms)
+{
+    int code = 0;
+    netchunk_error_t error = fxp_read_reply(control, &code, NULL, 0, timeout_ms);
+    if (error == NETCHUNK_SUCCESS && code != 125 && code != 150) {
+        error = NETCHUNK_ERROR_FTP;
+    }
+    return error;
+}
+
+/**
+ * @brief Wait for the reply that closes a data transfer
+ */
+static netchunk_error_t fxp_expect_complete(fxp_control_t* control, int timeout_ms)
+{
+    int code = 0;
+    netchunk_error_t error = fxp_read_reply(control, &code, NULL, 0, timeout_ms);
+    if (error == NETCHUNK_SUCCESS && code != 226 && code != 250) {
+        error = NETCHUNK_ERROR_FTP;
+    }
+    return error;
+}
+
+/**
+ * @brief Log out and close a control connection
+ */
+static void fxp_close(fxp_control_t* control)
+{
+    if (control->fd < 0) {
+        return;
+    }
+
+    // Best effort; the reply is not waited for
+    fxp_send(control, "QUIT");
+    close(control->fd);
+    control->fd = -1;
+}
@@ -0,0 +1,363 @@
+/**
+ * @file health_monitor.c
+ * @brief Background server probing with a lock-free status snapshot
+ *
+ * Placement, downloads and repairs consult the snapshot instead of probing
+ * servers themselves, so a check costs a copy rather than a round trip.
+ */
+
+#include "health_monitor.h"
+#include "placement.h"
+#include <string.h>
+
+// Internal helper functions
+static void health_monitor_publish_locked(netchunk_health_monitor_t* monitor, const netchunk_health_snapshot_t* snapshot);
+static void health_monitor_write_back(netchunk_health_monitor_t* monitor);
+static void health_monitor_probe_server(netchunk_health_monitor_t* monitor,
+    int server_index,
+    netchunk_server_health_t* health,
+    time_t now);
+static bool health_monitor_stopping(netchunk_health_monitor_t* monitor);
+static void* health_monitor_worker(void* arg);
+
+netchunk_error_t netchunk_health_monitor_init(netchunk_health_monitor_t* monitor,
+    netchunk_config_t* config,
+    netchunk_ftp_context_t* ftp_context)
+{
+    if (!monitor || !config || !ftp_context) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    memset(monitor, 0, sizeof(netchunk_health_monitor_t));
+    monitor->config = config;
+    monitor->ftp_context = ftp_context;
+    monitor->snapshot.server_count = config->server_count;
+
+    // Short-lived processes never pay for a chunk directory listing
+    time_t now = time(NULL);
+    for (int i = 0; i < NETCHUNK_MAX_SERVERS; i++) {
+        monitor->usage_checked_at[i] = now;
+    }
+
+    if (pthread_mutex_init(&monitor->mutex, NULL) != 0) {
+        return NETCHUNK_ERROR_UNKNOWN;
+    }
+    if (pthread_mutex_init(&monitor->wait_mutex, NULL) != 0) {
+        pthread_mutex_destroy(&monitor->mutex);
+        return NETCHUNK_ERROR_UNKNOWN;
+    }
+    if (pthread_cond_init(&monitor->wake, NULL) != 0) {
+        pthread_mutex_destroy(&monitor->wait_mutex);
+        pthread_mutex_destroy(&monitor->mutex);
+        return NETCHUNK_ERROR_UNKNOWN;
+    }
+
+    return NETCHUNK_SUCCESS;
+}
+
+netchunk_error_t netchunk_health_monitor_start(netchunk_health_monitor_t* monitor)
+{
+    if (!monitor) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    pthread_mutex_lock(&monitor->wait_mutex);
+    netchunk_error_t error = NETCHUNK_SUCCESS;
+    if (!monitor->thread_running) {
+        monitor->stopping = false;
+        if (pthread_create(&monitor->thread, NULL, health_monitor_worker, monitor) == 0) {
+            monitor->thread_running = true;
+        } else {
+            error = NETCHUNK_ERROR_UNKNOWN;
+        }
+    }
+    pthread_mutex_unlock(&monitor->wait_mutex);
+
+    return error;
+}
+
+netchunk_error_t netchunk_health_monitor_probe_all(netchunk_health_monitor_t* monitor)
+{
+    if (!monitor || !monitor->config) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    pthread_mutex_lock(&monitor->mutex);
+
+    // Start from the last round so failure counts and space figures carry over
+    netchunk_health_snapshot_t next = monitor->snapshot;
+    next.server_count = monitor->config->server_count;
+
+    time_t now = time(NULL);
+    for (int i = 0; i < next.server_count && !health_monitor_stopping(monitor); i++) {
+        health_monitor_probe_server(monitor, i, &next.servers[i], now);
+    }
+
+    health_monitor_publish_locked(monitor, &next);
+
+    pthread_mutex_unlock(&monitor->mutex);
+    return NETCHUNK_SUCCESS;
+}
+
+netchunk_error_t netchunk_health_monitor_ensure_probed(netchunk_health_monitor_t* monitor)
+{
+    if (!monitor) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    netchunk_health_snapshot_t snapshot;
+    netchunk_health_monitor_read(monitor, &snapshot);
+    if (snapshot.generation > 0) {
+        return NETCHUNK_SUCCESS;
+    }
+
+    return netchunk_health_monitor_probe_all(monitor);
+}
+
+void netchunk_health_monitor_publish(netchunk_health_monitor_t* monitor, const netchunk_health_snapshot_t* snapshot)
+{
+    if (!monitor || !snapshot) {
+        return;
+    }
+
+    pthread_mutex_lock(&monitor->mutex);
+    health_monitor_publish_locked(monitor, snapshot);
+    pthread_mutex_unlock(&monitor->mutex);
+}
+
+void netchunk_health_monitor_read(const netchunk_health_monitor_t* monitor, netchunk_health_snapshot_t* snapshot)
+{
+    if (!monitor || !snapshot) {
+        return;
+    }
+
+    for (;;) {
+        uint64_t before = __atomic_load_n(&monitor->sequence, __ATOMIC_ACQUIRE);
+        if (before & 1) {
+            continue; // A round is being published
+        }
+
+        memcpy(snapshot, &monitor->snapshot, sizeof(netchunk_health_snapshot_t));
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&monitor->sequence, __ATOMIC_RELAXED) == before) {
+            return;
+        }
+    }
+}
+
+bool netchunk_health_monitor_read_server(const netchunk_health_monitor_t* monitor,
+    int server_index,
+    netchunk_server_health_t* health)
+{
+    if (!monitor || !health || server_index < 0 || server_index >= NETCHUNK_MAX_SERVERS) {
+        return false;
+    }
+
+    for (;;) {
+        uint64_t before = __atomic_load_n(&monitor->sequence, __ATOMIC_ACQUIRE);
+        if (before & 1) {
+            continue;
+        }
+
+        int server_count = monitor->snapshot.server_count;
+        memcpy(health, &monitor->snapshot.servers[server_index], sizeof(netchunk_server_health_t));
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&monitor->sequence, __ATOMIC_RELAXED) == before) {
+            return server_index < server_count;
+        }
+    }
+}
+
+bool netchunk_health_monitor_usable(const netchunk_health_monitor_t* monitor, int server_index)
+{
+    netchunk_server_health_t health;
+    if (!monitor || !netchunk_health_monitor_read_server(monitor, server_index, &health)) {
+        return true;
+    }
+
+    return health.status != NETCHUNK_SERVER_UNAVAILABLE;
+}
+
+netchunk_server_status_t netchunk_health_classify(const netchunk_config_t* config,
+    const netchunk_server_health_t* health)
+{
+    if (!health || health->checked_at == 0) {
+        return NETCHUNK_SERVER_UNKNOWN;
+    }
+    if (health->consecutive_failures >= NETCHUNK_HEALTH_FAILURE_LIMIT) {
+        return NETCHUNK_SERVER_UNAVAILABLE;
+    }
+    if (health->consecutive_failures > 0) {
+        return NETCHUNK_SERVER_DEGRADED;
+    }
+
+    if (config) {
+        if (config->latency_alert_threshold > 0 && health->latency_ms > config->latency_alert_threshold) {
+            return NETCHUNK_SERVER_DEGRADED;
+        }
+
+        uint64_t capacity = health->bytes_available + health->bytes_used;
+        if (config->storage_alert_threshold > 0 && health->bytes_available > 0
+            && health->bytes_used * 100 >= capacity * (uint64_t)config->storage_alert_threshold) {
+            return NETCHUNK_SERVER_DEGRADED;
+        }
+    }
+
+    return NETCHUNK_SERVER_AVAILABLE;
+}
+
+void netchunk_health_monitor_cleanup(netchunk_health_monitor_t* monitor)
+{
+    if (!monitor) {
+        return;
+    }
+
+    pthread_mutex_lock(&monitor->wait_mutex);
+    bool joining = monitor->thread_running;
+    monitor->stopping = true;
+    pthread_cond_broadcast(&monitor->wake);
+    pthread_mutex_unlock(&monitor->wait_mutex);
+
+    if (joining) {
+        pthread_join(monitor->thread, NULL);
+    }
+    if (monitor->config) {
+        health_monitor_write_back(monitor);
+    }
+
+    pthread_cond_destroy(&monitor->wake);
+    pthread_mutex_destroy(&monitor->wait_mutex);
+    pthread_mutex_destroy(&monitor->mutex);
+    memset(monitor, 0, sizeof(netchunk_health_monitor_t));
+}
+
+// Internal helper functions
+
+/**
+ * @brief Replace the snapshot; must be called with the monitor mutex held
+ */
+static void health_monitor_publish_locked(netchunk_health_monitor_t* monitor, const netchunk_health_snapshot_t* snapshot)
+{
+    uint64_t generation = monitor->snapshot.generation + 1;
+    uint64_t sequence = __atomic_load_n(&monitor->sequence, __ATOMIC_RELAXED);
+
+    __atomic_store_n(&monitor->sequence, sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    memcpy(&monitor->snapshot, snapshot, sizeof(netchunk_health_snapshot_t));
+    monitor->snapshot.generation = generation;
+
+    __atomic_store_n(&monitor->sequence, sequence + 2, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Copy the published state into config->servers
+ *
+ * Other threads read the configuration without locking, so this only runs
+ * once the worker has stopped.
+ */
+static void health_monitor_write_back(netchunk_health_monitor_t* monitor)
+{
+    const netchunk_health_snapshot_t* snapshot = &monitor->snapshot;
+    int server_count = snapshot->server_count < monitor->config->server_count
+        ? snapshot->server_count
+        : monitor->config->server_count;
+    for (int i = 0; i < server_count; i++) {
+        const netchunk_server_health_t* health = &snapshot->servers[i];
+        netchunk_server_t* server = &monitor->config->servers[i];
+        if (health->checked_at == 0) {
+            continue;
+        }
+        server->status = health->status;
+        server->last_health_check = health->checked_at;
+        server->last_latency_ms = health->latency_ms;
+        server->bytes_available = health->bytes_available;
+        server->bytes_used = health->bytes_used;
+    }
+}
+
+/**
+ * @brief Probe one server and update its entry of a snapshot being built
+ */
+static void health_monitor_probe_server(netchunk_health_monitor_t* monitor,
+    int server_index,
+    netchunk_server_health_t* health,
+    time_t now)
+{
+    const netchunk_server_t* server = &monitor->config->servers[server_index];
+
+    double latency_ms = 0.0;
+    bool reachable = netchunk_ftp_test_server(server, &latency_ms) == NETCHUNK_SUCCESS;
+    netchunk_ftp_engine_record_probe(monitor->ftp_context->engine, server_index, reachable, latency_ms);
+
+    health->checked_at = now;
+    if (!reachable) {
+        health->consecutive_failures++;
+        health->status = netchunk_health_classify(monitor->config, health);
+        return;
+    }
+
+    health->consecutive_failures = 0;
+    health->latency_ms = latency_ms;
+
+    // Listing the chunk directory is costly, so usage is refreshed rarely
+    bool list_usage = !monitor->no_usage_listing[server_index]
+        && now - monitor->usage_checked_at[server_index] >= NETCHUNK_HEALTH_USAGE_INTERVAL;
+
+    uint64_t bytes_available = 0;
+    uint64_t bytes_used = 0;
+    netchunk_error_t error = netchunk_ftp_query_space(server, &bytes_available, list_usage ? &bytes_used : NULL);
+    if (error == NETCHUNK_ERROR_FTP && list_usage) {
+        monitor->no_usage_listing[server_index] = true;
+        list_usage = false;
+        error = netchunk_ftp_query_space(server, &bytes_available, NULL);
+    }
+
+    if (error == NETCHUNK_SUCCESS) {
+        health->bytes_available = bytes_available;
+        health->capacity_step = netchunk_placement_capacity_step(bytes_available, health->capacity_step);
+        if (list_usage) {
+            health->bytes_used = bytes_used;
+            monitor->usage_checked_at[server_index] = now;
+        }
+    }
+
+    health->status = netchunk_health_classify(monitor->config, health);
+}
+
+/**
+ * @brief Whether cleanup asked the worker to stop; a round in progress ends early
+ */
+static bool health_monitor_stopping(netchunk_health_monitor_t* monitor)
+{
+    pthread_mutex_lock(&monitor->wait_mutex);
+    bool stopping = monitor->stopping;
+    pthread_mutex_unlock(&monitor->wait_mutex);
+    return stopping;
+}
+
+static void* health_monitor_worker(void* arg)
+{
+    netchunk_health_monitor_t* monitor = (netchunk_health_monitor_t*)arg;
+    int interval = monitor->config->health_check_interval > 0 ? monitor->config->health_check_interval : 300;
+    time_t next_round = time(NULL) + NETCHUNK_HEALTH_START_DELAY;
+
+    pthread_mutex_lock(&monitor->wait_mutex);
+    while (!monitor->stopping) {
+        struct timespec deadline = { .tv_sec = next_round, .tv_nsec = 0 };
+        if (pthread_cond_timedwait(&monitor->wake, &monitor->wait_mutex, &deadline) == 0) {
+            continue; // Woken to stop, or spuriously
+        }
+
+        pthread_mutex_unlock(&monitor->wait_mutex);
+        netchunk_health_monitor_probe_all(monitor);
+        pthread_mutex_lock(&monitor->wait_mutex);
+
+        next_round = time(NULL) + interval;
+    }
+    pthread_mutex_unlock(&monitor->wait_mutex);
+
+    return NULL;
+}
@@ -0,0 +1,479 @@
+/**
+ * @file journal.c
+ * @brief Checkpoint journal for resumable uploads and downloads
+ *
+ * A journal is a small JSON file under local_storage_path, rewritten
+ * atomically at most every few seconds while a transfer runs and once more
+ * when it fails. A successful transfer removes it.
+ */
+
+#include "journal.h"
+#include "crypto.h"
+#include <cjson/cJSON.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define JOURNAL_INITIAL_CAPACITY 64
+
+// Internal helper functions
+static const char* operation_name(netchunk_journal_operation_t operation);
+static netchunk_error_t ensure_directory(const char* file_path);
+static cJSON* completed_to_json(const netchunk_journal_t* journal);
+static netchunk_error_t completed_from_json(netchunk_journal_t* journal, const cJSON* ranges);
+static netchunk_error_t load_upload_fields(netchunk_journal_t* journal, const cJSON* root);
+static netchunk_error_t load_download_fields(netchunk_journal_t* journal, const cJSON* root);
+
+netchunk_error_t netchunk_journal_init(netchunk_journal_t* journal,
+    const char* directory,
+    netchunk_journal_operation_t operation,
+    const char* remote_name,
+    const char* local_path)
+{
+    if (!journal || !directory || !remote_name || !local_path) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    memset(journal, 0, sizeof(netchunk_journal_t));
+
+    if (strlen(remote_name) >= sizeof(journal->remote_name) || strlen(local_path) >= sizeof(journal->local_path)) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+    journal->operation = operation;
+    strcpy(journal->remote_name, remote_name);
+    strcpy(journal->local_path, local_path);
+
+    char expanded[NETCHUNK_MAX_PATH_LEN];
+    netchunk_error_t error = netchunk_config_expand_path(directory, expanded, sizeof(expanded));
+    if (error != NETCHUNK_SUCCESS) {
+        return error;
+    }
+
+    // Name the file after the transfer; names and paths may contain anything
+    netchunk_sha256_context_t sha;
+    uint8_t digest[NETCHUNK_HASH_LENGTH];
+    const char* op = operation_name(operation);
+    netchunk_sha256_init(&sha);
+    netchunk_sha256_update(&sha, (const uint8_t*)op, strlen(op) + 1);
+    netchunk_sha256_update(&sha, (const uint8_t*)remote_name, strlen(remote_name) + 1);
+    netchunk_sha256_update(&sha, (const uint8_t*)local_path, strlen(local_path) + 1);
+    netchunk_sha256_final(&sha, digest);
+
+    char digest_hex[NETCHUNK_HASH_LENGTH * 2 + 1];
+    netchunk_hash_to_hex_string(digest, NETCHUNK_HASH_LENGTH, digest_hex);
+
+    int result = snprintf(journal->path, sizeof(journal->path), "%s/%s%s", expanded, digest_hex,
+        NETCHUNK_JOURNAL_EXTENSION);
+    if (result < 0 || (size_t)result >= sizeof(journal->path)) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    return NETCHUNK_SUCCESS;
+}
+
+netchunk_error_t netchunk_journal_load(netchunk_journal_t* journal)
+{
+    if (!journal || journal->path[0] == '\0') {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    char* content;
+    size_t size;
+    netchunk_error_t error = netchunk_manifest_read_file(journal->path, &content, &size);
+    if (error != NETCHUNK_SUCCESS) {
+        return error;
+    }
+
+    cJSON* root = cJSON_Parse(content);
+    free(content);
+    if (!root) {
+        return NETCHUNK_ERROR_MANIFEST_CORRUPT;
+    }
+
+    // A digest collision or a hand-edited file must not resume the wrong transfer
+    cJSON* operation = cJSON_GetObjectItem(root, "operation");
+    cJSON* remote_name = cJSON_GetObjectItem(root, "remote_name");
+    cJSON* local_path = cJSON_GetObjectItem(root, "local_path");
+    if (!cJSON_IsString(operation) || strcmp(operation->valuestring, operation_name(journal->operation)) != 0
+        || !cJSON_IsString(remote_name) || strcmp(remote_name->valuestring, journal->remote_name) != 0
+        || !cJSON_IsString(local_path) || strcmp(local_path->valuestring, journal->local_path) != 0) {
+        cJSON_Delete(root);
+        return NETCHUNK_ERROR_MANIFEST_CORRUPT;
+    }
+
+    netchunk_journal_reset(journal);
+    if (journal->operation == NETCHUNK_JOURNAL_UPLOAD) {
+        error = load_upload_fields(journal, root);
+    } else {
+        error = load_download_fields(journal, root);
+    }
+    cJSON_Delete(root);
+
+    if (error != NETCHUNK_SUCCESS) {
+        netchunk_journal_reset(journal);
+        return error;
+    }
+
+    journal->dirty = false;
+    return NETCHUNK_SUCCESS;
+}
+
+netchunk_error_t netchunk_journal_save(netchunk_journal_t* journal)
+{
+    if (!journal || journal->path[0] == '\0') {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    cJSON* root = cJSON_CreateObject();
+    if (!root) {
+        return NETCHUNK_ERROR_OUT_OF_MEMORY;
+    }
+
+    cJSON_AddStringToObject(root, "version", NETCHUNK_JOURNAL_VERSION);
+    cJSON_AddStringToObject(root, "operation", operation_name(journal->operation));
+    cJSON_AddStringToObject(root, "remote_name", journal->remote_name);
+    cJSON_AddStringToObject(root, "local_path", journal->local_path);
+
+    bool built = true;
+    if (journal->operation == NETCHUNK_JOURNAL_UPLOAD) {
+        cJSON_AddNumberToObject(root, "source_size", (double)journal->source_size);
+        cJSON_AddNumberToObject(root, "source_modified", (double)journal->source_modified);
+        cJSON_AddNumberToObject(root, "chunk_size", (double)journal->chunk_size);
+        cJSON_AddNumberToObject(root, "chunking_mode", (double)journal->chunking_mode);
+        cJSON_AddBoolToObject(root, "content_addressed", journal->content_addressed);
+
+        cJSON* chunks = cJSON_CreateArray();
+        built = chunks != NULL;
+        if (built) {
+            cJSON_AddItemToObject(root, "chunks", chunks);
+        }
+        for (uint32_t i = 0; built && i < journal->chunk_count; i++) {
+            cJSON* chunk_json = netchunk_chunk_to_json(&journal->chunks[i]);
+            built = chunk_json != NULL;
+            if (built) {
+                cJSON_AddItemToArray(chunks, chunk_json);
+            }
+        }
+    } else {
+        char hash_hex[NETCHUNK_HASH_LENGTH * 2 + 1];
+        netchunk_hash_to_hex_string(journal->file_hash, NETCHUNK_HASH_LENGTH, hash_hex);
+
+        cJSON_AddStringToObject(root, "manifest_id", journal->manifest_id);
+        cJSON_AddStringToObject(root, "file_hash", hash_hex);
+        cJSON_AddNumberToObject(root, "total_size", (double)journal->total_size);
+        cJSON_AddNumberToObject(root, "chunk_count", (double)journal->completed_length);
+
+        cJSON* ranges = completed_to_json(journal);
+        built = ranges != NULL;
+        if (built) {
+            cJSON_AddItemToObject(root, "completed", ranges);
+        }
+    }
+
+    char* content = built ? cJSON_PrintUnformatted(root) : NULL;
+    cJSON_Delete(root);
+    if (!content) {
+        return NETCHUNK_ERROR_OUT_OF_MEMORY;
+    }
+
+    netchunk_error_t error = ensure_directory(journal->path);
+    if (error == NETCHUNK_SUCCESS) {
+        error = netchunk_manifest_write_atomic(journal->path, content, strlen(content));
+    }
+    free(content);
+
+    if (error == NETCHUNK_SUCCESS) {
+        journal->dirty = false;
+        journal->last_checkpoint = time(NULL);
+    }
+
+    return error;
+}
+
+netchunk_error_t netchunk_journal_checkpoint(netchunk_journal_t* journal)
+{
+    if (!journal) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    if (!journal->dirty) {
+        return NETCHUNK_SUCCESS;
+    }
+
+    time_t now = time(NULL);
+    if (now >= journal->last_checkpoint && now - journal->last_checkpoint < NETCHUNK_JOURNAL_CHECKPOINT_INTERVAL) {
+        return NETCHUNK_SUCCESS;
+    }
+
+    return netchunk_journal_save(journal);
+}
+
+void netchunk_journal_reset(netchunk_journal_t* journal)
+{
+    if (!journal) {
+        return;
+    }
+
+    journal->chunk_count = 0;
+    if (journal->completed) {
+        memset(journal->completed, 0, journal->completed_length * sizeof(bool));
+    }
+    journal->dirty = true;
+}
+
+void netchunk_journal_discard(netchunk_journal_t* journal)
+{
+    if (!journal || journal->path[0] == '\0') {
+        return;
+    }
+
+    unlink(journal->path);
+    journal->dirty = false;
+}
+
+void netchunk_journal_cleanup(netchunk_journal_t* journal)
+{
+    if (!journal) {
+        return;
+    }
+
+    free(journal->chunks);
+    free(journal->completed);
+    memset(journal, 0, sizeof(netchunk_journal_t));
+}
+
+netchunk_error_t netchunk_journal_record_chunk(netchunk_journal_t* journal, const netchunk_chunk_t* chunk)
+{
+    if (!journal || !chunk || chunk->sequence_number > journal->chunk_count) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    if (chunk->sequence_number == journal->chunk_count && journal->chunk_count == journal->chunk_capacity) {
+        uint32_t capacity = journal->chunk_capacity > 0 ? journal->chunk_capacity * 2 : JOURNAL_INITIAL_CAPACITY;
+        netchunk_chunk_t* chunks = realloc(journal->chunks, capacity * sizeof(netchunk_chunk_t));
+        if (!chunks) {
+            return NETCHUNK_ERROR_OUT_OF_MEMORY;
+        }
+        journal->chunks = chunks;
+        journal->chunk_capacity = capacity;
+    }
+
+    netchunk_chunk_t* entry = &journal->chunks[chunk->sequence_number];
+    if (chunk->sequence_number == journal->chunk_count) {
+        journal->chunk_count++;
+    }
+    *entry = *chunk;
+    entry->data = NULL;
+    entry->data_owned = false;
+    journal->dirty = true;
+
+    return NETCHUNK_SUCCESS;
+}
+
+const netchunk_chunk_t* netchunk_journal_find_chunk(const netchunk_journal_t* journal, uint32_t sequence_number)
+{
+    if (!journal || sequence_number >= journal->chunk_count) {
+        return NULL;
+    }
+
+    return &journal->chunks[sequence_number];
+}
+
+netchunk_error_t netchunk_journal_set_chunk_count(netchunk_journal_t* journal, uint32_t chunk_count)
+{
+    if (!journal) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    bool* completed = calloc(chunk_count > 0 ? chunk_count : 1, sizeof(bool));
+    if (!completed) {
+        return NETCHUNK_ERROR_OUT_OF_MEMORY;
+    }
+
+    free(journal->completed);
+    journal->completed = completed;
+    journal->completed_length = chunk_count;
+    journal->dirty = true;
+
+    return NETCHUNK_SUCCESS;
+}
+
+void netchunk_journal_set_completed(netchunk_journal_t* journal, uint32_t index, bool completed)
+{
+    if (!journal || index >= journal->completed_length || journal->completed[index] == completed) {
+        return;
+    }
+
+    journal->completed[index] = completed;
+    journal->dirty = true;
+}
+
+bool netchunk_journal_is_completed(const netchunk_journal_t* journal, uint32_t index)
+{
+    return journal && index < journal->completed_length && journal->completed[index];
+}
+
+bool netchunk_journal_has_progress(const netchunk_journal_t* journal)
+{
+    if (!journal) {
+        return false;
+    }
+
+    if (journal->chunk_count > 0) {
+        return true;
+    }
+    for (uint32_t i = 0; i < journal->completed_length; i++) {
+        if (journal->completed[i]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Internal helper functions
+
+static const char* operation_name(netchunk_journal_operation_t operation)
+{
+    return operation == NETCHUNK_JOURNAL_UPLOAD ? "upload" : "download";
+}
+
+static netchunk_error_t ensure_directory(const char* file_path)
+{
+    char path_copy[NETCHUNK_MAX_PATH_LEN];
+    strncpy(path_copy, file_path, sizeof(path_copy) - 1);
+    path_copy[sizeof(path_copy) - 1] = '\0';
+
+    for (char* p = path_copy + 1; *p; p++) {
+        if (*p == '/') {
+            *p = '\0';
+            if (mkdir(path_copy, 0755) != 0 && errno != EEXIST) {
+                return NETCHUNK_ERROR_FILE_ACCESS;
+            }
+            *p = '/';
+        }
+    }
+
+    return NETCHUNK_SUCCESS;
+}
+
+/**
+ * @brief Encode the completed flags as [start, end) runs
+ */
+static cJSON* completed_to_json(const netchunk_journal_t* journal)
+{
+    cJSON* ranges = cJSON_CreateArray();
+    if (!ranges) {
+        return NULL;
+    }
+
+    uint32_t i = 0;
+    while (i < journal->completed_length) {
+        if (!journal->completed[i]) {
+            i++;
+            continue;
+        }
+
+        uint32_t start = i;
+        while (i < journal->completed_length && journal->completed[i]) {
+            i++;
+        }
+
+        cJSON* range = cJSON_CreateArray();
+        if (!range) {
+            cJSON_Delete(ranges);
+            return NULL;
+        }
+        cJSON_AddItemToArray(range, cJSON_CreateNumber((double)start));
+        cJSON_AddItemToArray(range, cJSON_CreateNumber((double)i));
+        cJSON_AddItemToArray(ranges, range);
+    }
+
+    return ranges;
+}
+
+static netchunk_error_t completed_from_json(netchunk_journal_t* journal, const cJSON* ranges)
+{
+    if (!cJSON_IsArray(ranges)) {
+        return NETCHUNK_ERROR_MANIFEST_CORRUPT;
+    }
+
+    const cJSON* range;
+    cJSON_ArrayForEach(range, ranges)
+    {
+        const cJSON* start = cJSON_GetArrayItem(range, 0);
+        const cJSON* end = cJSON_GetArrayItem(range, 1);
+        if (!cJSON_IsNumber(start) || !cJSON_IsNumber(end) || start->valuedouble < 0
+            || end->valuedouble > journal->completed_length || start->valuedouble > end->valuedouble) {
+            return NETCHUNK_ERROR_MANIFEST_CORRUPT;
+        }
+
+        for (uint32_t i = (uint32_t)start->valuedouble; i < (uint32_t)end->valuedouble; i++) {
+            journal->completed[i] = true;
+        }
+    }
+
+    return NETCHUNK_SUCCESS;
+}
+
+static netchunk_error_t load_upload_fields(netchunk_journal_t* journal, const cJSON* root)
+{
+    cJSON* source_size = cJSON_GetObjectItem(root, "source_size");
+    cJSON* source_modified = cJSON_GetObjectItem(root, "source_modified");
+    cJSON* chunk_size = cJSON_GetObjectItem(root, "chunk_size");
+    cJSON* chunking_mode = cJSON_GetObjectItem(root, "chunking_mode");
+    cJSON* content_addressed = cJSON_GetObjectItem(root, "content_addressed");
+    cJSON* chunks = cJSON_GetObjectItem(root, "chunks");
+    if (!cJSON_IsNumber(source_size) || !cJSON_IsNumber(source_modified) || !cJSON_IsNumber(chunk_size)
+        || !cJSON_IsNumber(chunking_mode) || !cJSON_IsBool(content_addressed) || !cJSON_IsArray(chunks)) {
+        return NETCHUNK_ERROR_MANIFEST_CORRUPT;
+    }
+
+    journal->source_size = (uint64_t)source_size->valuedouble;
+    journal->source_modified = (time_t)source_modified->valuedouble;
+    journal->chunk_size = (size_t)chunk_size->valuedouble;
+    journal->chunking_mode = (netchunk_chunking_mode_t)chunking_mode->valueint;
+    journal->content_addressed = cJSON_IsTrue(content_addressed);
+
+    const cJSON* chunk_json;
+    cJSON_ArrayForEach(chunk_json, chunks)
+    {
+        netchunk_chunk_t chunk;
+        netchunk_error_t error = netchunk_chunk_from_json(chunk_json, &chunk);
+        if (error == NETCHUNK_SUCCESS) {
+            error = netchunk_journal_record_chunk(journal, &chunk);
+        }
+        if (error != NETCHUNK_SUCCESS) {
+            return error == NETCHUNK_ERROR_OUT_OF_MEMORY ? error : NETCHUNK_ERROR_MANIFEST_CORRUPT;
+        }
+    }
+
+    return NETCHUNK_SUCCESS;
+}
+
+static netchunk_error_t load_download_fields(netchunk_journal_t* journal, const cJSON* root)
+{
+    cJSON* manifest_id = cJSON_GetObjectItem(root, "manifest_id");
+    cJSON* file_hash = cJSON_GetObjectItem(root, "file_hash");
+    cJSON* total_size = cJSON_GetObjectItem(root, "total_size");
+    cJSON* chunk_count = cJSON_GetObjectItem(root, "chunk_count");
+    if (!cJSON_IsString(manifest_id) || strlen(manifest_id->valuestring) >= sizeof(journal->manifest_id)
+        || !cJSON_IsString(file_hash) || !cJSON_IsNumber(total_size) || !cJSON_IsNumber(chunk_count)
+        || chunk_count->valuedouble < 0 || chunk_count->valuedouble > UINT32_MAX
+        || netchunk_hex_string_to_hash(file_hash->valuestring, journal->file_hash, NETCHUNK_HASH_LENGTH)
+            != NETCHUNK_SUCCESS) {
+        return NETCHUNK_ERROR_MANIFEST_CORRUPT;
+    }
+
+    strcpy(journal->manifest_id, manifest_id->valuestring);
+    journal->total_size = (uint64_t)total_size->valuedouble;
+
+    netchunk_error_t error = netchunk_journal_set_chunk_count(journal, (uint32_t)chunk_count->valuedouble);
+    if (error != NETCHUNK_SUCCESS) {
+        return error;
+    }
+
+    return completed_from_json(journal, cJSON_GetObjectItem(root, "completed"));
+}
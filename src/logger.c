@@ -7,6 +7,7 @@
 
 #include "logger.h"
 #include <errno.h>
+#include <sched.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
@@ -34,6 +35,8 @@ static netchunk_logger_config_t get_default_config(void)
     config.include_timestamp = true;
     config.include_level = true;
     config.include_location = false; // Disable by default for performance
+    config.async = false;
+    config.async_queue_lines = NETCHUNK_LOGGER_DEFAULT_QUEUE_LINES;
 
     return config;
 }
@@ -59,6 +62,373 @@ static void create_backup_filename(const char* original, int backup_num,
     snprintf(backup_name, backup_name_size, "%s.%d", original, backup_num);
 }
 
+/**
+ * @brief Format the current local time, at most once per second per thread
+ */
+static const char* cached_timestamp(void)
+{
+    static __thread time_t cached_second = (time_t)-1;
+    static __thread char cached_text[32];
+
+    time_t now = time(NULL);
+    if (now != cached_second) {
+        struct tm tm_info;
+        localtime_r(&now, &tm_info);
+        strftime(cached_text, sizeof(cached_text), "%Y-%m-%d %H:%M:%S", &tm_info);
+        cached_second = now;
+    }
+
+    return cached_text;
+}
+
+/**
+ * @brief Format one log line, newline included
+ *
+ * A message too long for the buffer is cut short but keeps its newline.
+ *
+ * @return Length of the line
+ */
+static size_t format_line(const netchunk_logger_context_t* context,
+    netchunk_log_level_t level,
+    const char* file,
+    int line,
+    const char* format,
+    va_list args,
+    char* buffer,
+    size_t buffer_size)
+{
+    const char* timestamp = context->config.include_timestamp ? cached_timestamp() : "";
+    char level_buf[16] = "";
+    char location_buf[256] = "";
+
+    // Format level
+    if (context->config.include_level) {
+        snprintf(level_buf, sizeof(level_buf), "[%s]", netchunk_logger_level_string(level));
+    }
+
+    // Format location
+    if (context->config.include_location && file) {
+        const char* filename = strrchr(file, '/');
+        filename = filename ? filename + 1 : file; // Get just the filename
+        snprintf(location_buf, sizeof(location_buf), " %s:%d", filename, line);
+    }
+
+    // Leave room for the newline in every case
+    size_t limit = buffer_size - 2;
+    int prefix = snprintf(buffer, buffer_size - 1, "%s%s%s%s: ",
+        timestamp,
+        timestamp[0] ? " " : "",
+        level_buf,
+        location_buf);
+    size_t length = prefix < 0 ? 0 : ((size_t)prefix < limit ? (size_t)prefix : limit);
+
+    int message = vsnprintf(buffer + length, buffer_size - 1 - length, format, args);
+    if (message > 0) {
+        length += (size_t)message < limit - length ? (size_t)message : limit - length;
+    }
+
+    buffer[length++] = '\n';
+    buffer[length] = '\0';
+    return length;
+}
+
+/**
+ * @brief format_line() with inline arguments
+ */
+static size_t format_notice(const netchunk_logger_context_t* context,
+    netchunk_log_level_t level,
+    char* buffer,
+    size_t buffer_size,
+    const char* format,
+    ...)
+{
+    va_list args;
+    va_start(args, format);
+    size_t length = format_line(context, level, NULL, 0, format, args, buffer, buffer_size);
+    va_end(args);
+    return length;
+}
+
+/**
+ * @brief Rotate the log file; must be called with output_mutex held
+ */
+static netchunk_error_t rotate_locked(netchunk_logger_context_t* context)
+{
+    // Close current log file
+    if (context->log_file) {
+        fclose(context->log_file);
+        context->log_file = NULL;
+    }
+
+    // Rotate backup files (move .1 to .2, .2 to .3, etc.)
+    for (int i = context->config.max_backup_files - 1; i > 0; i--) {
+        char old_backup[1024], new_backup[1024];
+        create_backup_filename(context->config.log_file_path, i, old_backup, sizeof(old_backup));
+        create_backup_filename(context->config.log_file_path, i + 1, new_backup, sizeof(new_backup));
+
+        // Move file (ignore errors if file doesn't exist)
+        rename(old_backup, new_backup);
+    }
+
+    // Move current log to .1 backup
+    char first_backup[1024];
+    create_backup_filename(context->config.log_file_path, 1, first_backup, sizeof(first_backup));
+    rename(context->config.log_file_path, first_backup);
+
+    // Create new log file
+    context->log_file = fopen(context->config.log_file_path, "w");
+    if (!context->log_file) {
+        return NETCHUNK_ERROR_FILE_ACCESS;
+    }
+
+    context->current_file_size = 0;
+    return NETCHUNK_SUCCESS;
+}
+
+/**
+ * @brief Write complete lines to the configured outputs
+ *
+ * Must be called with output_mutex held. The file is rotated between lines
+ * whenever the next one would take it past max_file_size, so a batch
+ * never overfills a file.
+ */
+static void write_output_locked(netchunk_logger_context_t* context, const char* data, size_t length)
+{
+    if (context->config.log_to_stdout) {
+        fwrite(data, 1, length, stdout);
+        fflush(stdout);
+    }
+
+    if (!context->config.log_to_file || !context->log_file) {
+        return;
+    }
+
+    size_t start = 0;
+    while (start < length) {
+        // Take whole lines while they fit; an empty file takes at least one
+        size_t end = start;
+        while (end < length) {
+            const char* newline = memchr(data + end, '\n', length - end);
+            size_t next = newline ? (size_t)(newline - data) + 1 : length;
+            if (context->current_file_size + (next - start) > context->config.max_file_size
+                && (context->current_file_size > 0 || end > start)) {
+                break;
+            }
+            end = next;
+        }
+
+        if (end == start) {
+            if (rotate_locked(context) != NETCHUNK_SUCCESS) {
+                return;
+            }
+            continue;
+        }
+
+        fwrite(data + start, 1, end - start, context->log_file);
+        context->current_file_size += end - start;
+        start = end;
+    }
+
+    fflush(context->log_file);
+}
+
+static void wake_writer(netchunk_logger_context_t* context)
+{
+    pthread_mutex_lock(&context->wake_mutex);
+    pthread_cond_signal(&context->wake);
+    pthread_mutex_unlock(&context->wake_mutex);
+}
+
+/**
+ * @brief Format a line into the async ring
+ *
+ * Lock-free: the slot at tail is claimed with a compare-and-swap and
+ * handed to the writer by advancing its sequence.
+ */
+static void enqueue_line(netchunk_logger_context_t* context,
+    netchunk_log_level_t level,
+    const char* file,
+    int line,
+    const char* format,
+    va_list args)
+{
+    uint64_t position = __atomic_load_n(&context->tail, __ATOMIC_RELAXED);
+    netchunk_logger_slot_t* slot;
+
+    for (;;) {
+        slot = &context->slots[position & context->slot_mask];
+        uint64_t sequence = __atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE);
+        int64_t distance = (int64_t)(sequence - position);
+
+        if (distance == 0) {
+            if (__atomic_compare_exchange_n(&context->tail, &position, position + 1, true,
+                    __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (distance < 0) {
+            // Full: errors wait for the writer, anything else is dropped
+            if (level != NETCHUNK_LOG_ERROR) {
+                __atomic_fetch_add(&context->dropped, 1, __ATOMIC_RELAXED);
+                return;
+            }
+            wake_writer(context);
+            sched_yield();
+            position = __atomic_load_n(&context->tail, __ATOMIC_RELAXED);
+        } else {
+            position = __atomic_load_n(&context->tail, __ATOMIC_RELAXED);
+        }
+    }
+
+    slot->length = format_line(context, level, file, line, format, args, slot->text, sizeof(slot->text));
+    __atomic_store_n(&slot->sequence, position + 1, __ATOMIC_RELEASE);
+
+    // Pairs with the fence in the writer before it goes to sleep
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&context->writer_idle, __ATOMIC_RELAXED)) {
+        wake_writer(context);
+    }
+}
+
+/**
+ * @brief Whether the slot at the writer's position holds a finished line
+ */
+static bool slot_ready(const netchunk_logger_context_t* context, uint64_t position)
+{
+    const netchunk_logger_slot_t* slot = &context->slots[position & context->slot_mask];
+    return __atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE) == position + 1;
+}
+
+/**
+ * @brief Writer thread: drains the ring in batches
+ */
+static void* logger_writer(void* arg)
+{
+    netchunk_logger_context_t* context = (netchunk_logger_context_t*)arg;
+    char* batch = malloc(NETCHUNK_LOGGER_BATCH_SIZE);
+    uint64_t reported_dropped = 0;
+
+    for (;;) {
+        uint64_t head = context->head;
+        size_t batch_length = 0;
+
+        if (batch) {
+            uint64_t dropped = __atomic_load_n(&context->dropped, __ATOMIC_RELAXED);
+            if (dropped != reported_dropped) {
+                batch_length = format_notice(context, NETCHUNK_LOG_WARN, batch, NETCHUNK_LOGGER_LINE_MAX,
+                    "%llu log messages dropped, queue full", (unsigned long long)(dropped - reported_dropped));
+                reported_dropped = dropped;
+            }
+
+            while (batch_length + NETCHUNK_LOGGER_LINE_MAX <= NETCHUNK_LOGGER_BATCH_SIZE && slot_ready(context, head)) {
+                netchunk_logger_slot_t* slot = &context->slots[head & context->slot_mask];
+                memcpy(batch + batch_length, slot->text, slot->length);
+                batch_length += slot->length;
+                __atomic_store_n(&slot->sequence, head + context->slot_mask + 1, __ATOMIC_RELEASE);
+                head++;
+            }
+
+            if (batch_length > 0) {
+                pthread_mutex_lock(&context->output_mutex);
+                write_output_locked(context, batch, batch_length);
+                pthread_mutex_unlock(&context->output_mutex);
+            }
+        } else if (slot_ready(context, head)) {
+            // No batch buffer: write lines one at a time
+            netchunk_logger_slot_t* slot = &context->slots[head & context->slot_mask];
+            pthread_mutex_lock(&context->output_mutex);
+            write_output_locked(context, slot->text, slot->length);
+            pthread_mutex_unlock(&context->output_mutex);
+            __atomic_store_n(&slot->sequence, head + context->slot_mask + 1, __ATOMIC_RELEASE);
+            head++;
+        }
+
+        pthread_mutex_lock(&context->wake_mutex);
+        bool progressed = head != context->head;
+        __atomic_store_n(&context->head, head, __ATOMIC_RELEASE);
+        if (progressed) {
+            pthread_cond_broadcast(&context->written);
+        } else if (context->stopping) {
+            pthread_mutex_unlock(&context->wake_mutex);
+            break;
+        } else {
+            __atomic_store_n(&context->writer_idle, true, __ATOMIC_RELAXED);
+            __atomic_thread_fence(__ATOMIC_SEQ_CST);
+            if (!slot_ready(context, head)) {
+                // The timeout covers a wakeup raced away by a producer
+                struct timespec deadline;
+                clock_gettime(CLOCK_REALTIME, &deadline);
+                deadline.tv_nsec += NETCHUNK_LOGGER_IDLE_WAIT_MS * 1000000L;
+                deadline.tv_sec += deadline.tv_nsec / 1000000000L;
+                deadline.tv_nsec %= 1000000000L;
+                pthread_cond_timedwait(&context->wake, &context->wake_mutex, &deadline);
+            }
+            __atomic_store_n(&context->writer_idle, false, __ATOMIC_RELAXED);
+        }
+        pthread_mutex_unlock(&context->wake_mutex);
+    }
+
+    free(batch);
+    return NULL;
+}
+
+/**
+ * @brief Allocate the async ring and start the writer thread
+ */
+static netchunk_error_t start_async(netchunk_logger_context_t* context)
+{
+    size_t slot_count = 2;
+    while (slot_count < context->config.async_queue_lines) {
+        slot_count *= 2;
+    }
+
+    context->slots = malloc(slot_count * sizeof(netchunk_logger_slot_t));
+    if (!context->slots) {
+        return NETCHUNK_ERROR_OUT_OF_MEMORY;
+    }
+    for (size_t i = 0; i < slot_count; i++) {
+        context->slots[i].sequence = i;
+    }
+    context->slot_mask = slot_count - 1;
+
+    if (pthread_mutex_init(&context->wake_mutex, NULL) != 0) {
+        free(context->slots);
+        context->slots = NULL;
+        return NETCHUNK_ERROR_UNKNOWN;
+    }
+    pthread_cond_init(&context->wake, NULL);
+    pthread_cond_init(&context->written, NULL);
+
+    if (pthread_create(&context->writer, NULL, logger_writer, context) != 0) {
+        pthread_cond_destroy(&context->written);
+        pthread_cond_destroy(&context->wake);
+        pthread_mutex_destroy(&context->wake_mutex);
+        free(context->slots);
+        context->slots = NULL;
+        return NETCHUNK_ERROR_UNKNOWN;
+    }
+
+    return NETCHUNK_SUCCESS;
+}
+
+/**
+ * @brief Write out the ring and stop the writer thread
+ */
+static void stop_async(netchunk_logger_context_t* context)
+{
+    pthread_mutex_lock(&context->wake_mutex);
+    context->stopping = true;
+    pthread_cond_signal(&context->wake);
+    pthread_mutex_unlock(&context->wake_mutex);
+
+    pthread_join(context->writer, NULL);
+
+    pthread_cond_destroy(&context->written);
+    pthread_cond_destroy(&context->wake);
+    pthread_mutex_destroy(&context->wake_mutex);
+    free(context->slots);
+    context->slots = NULL;
+}
+
 netchunk_error_t netchunk_logger_init(netchunk_logger_context_t* context,
     const netchunk_logger_config_t* config)
 {
@@ -86,6 +456,20 @@ netchunk_error_t netchunk_logger_init(netchunk_logger_context_t* context,
         context->current_file_size = get_file_size(context->config.log_file_path);
     }
 
+    pthread_mutex_init(&context->output_mutex, NULL);
+
+    if (context->config.async) {
+        netchunk_error_t error = start_async(context);
+        if (error != NETCHUNK_SUCCESS) {
+            pthread_mutex_destroy(&context->output_mutex);
+            if (context->log_file) {
+                fclose(context->log_file);
+                context->log_file = NULL;
+            }
+            return error;
+        }
+    }
+
     context->initialized = true;
     return NETCHUNK_SUCCESS;
 }
@@ -127,35 +511,16 @@ netchunk_error_t netchunk_logger_rotate(netchunk_logger_context_t* context)
         return NETCHUNK_ERROR_INVALID_ARGUMENT;
     }
 
-    // Close current log file
-    if (context->log_file) {
-        fclose(context->log_file);
-        context->log_file = NULL;
-    }
+    pthread_mutex_lock(&context->output_mutex);
+    netchunk_error_t error = rotate_locked(context);
+    pthread_mutex_unlock(&context->output_mutex);
 
-    // Rotate backup files (move .1 to .2, .2 to .3, etc.)
-    for (int i = context->config.max_backup_files - 1; i > 0; i--) {
-        char old_backup[1024], new_backup[1024];
-        create_backup_filename(context->config.log_file_path, i, old_backup, sizeof(old_backup));
-        create_backup_filename(context->config.log_file_path, i + 1, new_backup, sizeof(new_backup));
-
-        // Move file (ignore errors if file doesn't exist)
-        rename(old_backup, new_backup);
-    }
-
-    // Move current log to .1 backup
-    char first_backup[1024];
-    create_backup_filename(context->config.log_file_path, 1, first_backup, sizeof(first_backup));
-    rename(context->config.log_file_path, first_backup);
-
-    // Create new log file
-    context->log_file = fopen(context->config.log_file_path, "w");
-    if (!context->log_file) {
-        return NETCHUNK_ERROR_FILE_ACCESS;
-    }
+    return error;
+}
 
-    context->current_file_size = 0;
-    return NETCHUNK_SUCCESS;
+bool netchunk_logger_enabled(const netchunk_logger_context_t* context, netchunk_log_level_t level)
+{
+    return context && context->initialized && level <= context->config.level;
 }
 
 void netchunk_logger_vlog(netchunk_logger_context_t* context,
@@ -174,64 +539,17 @@ void netchunk_logger_vlog(netchunk_logger_context_t* context,
         return;
     }
 
-    // Build log message
-    char timestamp_buf[64] = "";
-    char location_buf[256] = "";
-    char level_buf[16] = "";
-    char message_buf[2048];
-
-    // Format timestamp
-    if (context->config.include_timestamp) {
-        time_t now = time(NULL);
-        struct tm* tm_info = localtime(&now);
-        strftime(timestamp_buf, sizeof(timestamp_buf), "%Y-%m-%d %H:%M:%S", tm_info);
-    }
-
-    // Format level
-    if (context->config.include_level) {
-        snprintf(level_buf, sizeof(level_buf), "[%s]", netchunk_logger_level_string(level));
-    }
-
-    // Format location
-    if (context->config.include_location && file) {
-        const char* filename = strrchr(file, '/');
-        filename = filename ? filename + 1 : file; // Get just the filename
-        snprintf(location_buf, sizeof(location_buf), " %s:%d", filename, line);
+    if (context->slots) {
+        enqueue_line(context, level, file, line, format, args);
+        return;
     }
 
-    // Format message
-    vsnprintf(message_buf, sizeof(message_buf), format, args);
-
-    // Build complete log line
     char log_line[4096];
-    snprintf(log_line, sizeof(log_line), "%s%s%s%s: %s\n",
-        timestamp_buf[0] ? timestamp_buf : "",
-        timestamp_buf[0] ? " " : "",
-        level_buf,
-        location_buf,
-        message_buf);
-
-    // Output to stdout if configured
-    if (context->config.log_to_stdout) {
-        fputs(log_line, stdout);
-        fflush(stdout);
-    }
-
-    // Output to file if configured
-    if (context->config.log_to_file && context->log_file) {
-        size_t line_len = strlen(log_line);
+    size_t length = format_line(context, level, file, line, format, args, log_line, sizeof(log_line));
 
-        // Check if rotation is needed
-        if (context->current_file_size + line_len > context->config.max_file_size) {
-            netchunk_logger_rotate(context);
-        }
-
-        if (context->log_file) {
-            fputs(log_line, context->log_file);
-            fflush(context->log_file); // Immediate flush for reliability
-            context->current_file_size += line_len;
-        }
-    }
+    pthread_mutex_lock(&context->output_mutex);
+    write_output_locked(context, log_line, length);
+    pthread_mutex_unlock(&context->output_mutex);
 }
 
 void netchunk_logger_log(netchunk_logger_context_t* context,
@@ -253,6 +571,18 @@ void netchunk_logger_flush(netchunk_logger_context_t* context)
         return;
     }
 
+    if (context->slots) {
+        uint64_t target = __atomic_load_n(&context->tail, __ATOMIC_ACQUIRE);
+
+        pthread_mutex_lock(&context->wake_mutex);
+        pthread_cond_signal(&context->wake);
+        while (__atomic_load_n(&context->head, __ATOMIC_ACQUIRE) < target) {
+            pthread_cond_wait(&context->written, &context->wake_mutex);
+        }
+        pthread_mutex_unlock(&context->wake_mutex);
+    }
+
+    pthread_mutex_lock(&context->output_mutex);
     if (context->log_file) {
         fflush(context->log_file);
     }
@@ -260,18 +590,29 @@ void netchunk_logger_flush(netchunk_logger_context_t* context)
     if (context->config.log_to_stdout) {
         fflush(stdout);
     }
+    pthread_mutex_unlock(&context->output_mutex);
+}
+
+uint64_t netchunk_logger_dropped(const netchunk_logger_context_t* context)
+{
+    return context ? __atomic_load_n(&context->dropped, __ATOMIC_RELAXED) : 0;
 }
 
 void netchunk_logger_cleanup(netchunk_logger_context_t* context)
 {
-    if (!context)
+    if (!context || !context->initialized)
         return;
 
+    if (context->slots) {
+        stop_async(context);
+    }
+
     if (context->log_file) {
         fclose(context->log_file);
         context->log_file = NULL;
     }
 
+    pthread_mutex_destroy(&context->output_mutex);
     context->current_file_size = 0;
     context->initialized = false;
 }
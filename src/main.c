@@ -8,13 +8,17 @@
  */
 
 #include "netchunk.h"
+#include "daemon.h"
 #include <errno.h>
+#include <fcntl.h>
 #include <getopt.h>
+#include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
 #include <time.h>
+#include <unistd.h>
 
 /**
  * @brief CLI command types
@@ -25,7 +29,9 @@ typedef enum {
     CMD_LIST,
     CMD_DELETE,
     CMD_VERIFY,
+    CMD_SCRUB,
     CMD_HEALTH,
+    CMD_DAEMON,
     CMD_VERSION,
     CMD_HELP,
     CMD_UNKNOWN
@@ -39,12 +45,27 @@ typedef struct {
     char* config_path;
     char* local_path;
     char* remote_name;
+    char* socket_path;
     bool repair;
+    bool deep;
     bool verbose;
     bool quiet;
     bool show_stats;
+    bool no_daemon;
+    bool stop_daemon;
 } cli_config_t;
 
+/**
+ * @brief Where commands run: in this process or in a running daemon
+ */
+typedef struct {
+    netchunk_context_t* context; // Local context, NULL when forwarding
+    netchunk_daemon_client_t* client; // Daemon connection, NULL when local
+} cli_backend_t;
+
+// Daemon run by the daemon command, for the signal handler
+static netchunk_daemon_t* running_daemon = NULL;
+
 /**
  * @brief Progress callback context for CLI
  */
@@ -64,12 +85,14 @@ static void print_usage(const char* program_name)
     printf("  %s [OPTIONS] COMMAND [ARGS...]\n\n", program_name);
 
     printf("COMMANDS:\n");
-    printf("  upload <local_file> <remote_name>    Upload a file to distributed storage\n");
+    printf("  upload <local_file|-> <remote_name>  Upload a file (or stdin) to storage\n");
     printf("  download <remote_name> <local_file>  Download a file from distributed storage\n");
     printf("  list                                 List all files in distributed storage\n");
     printf("  delete <remote_name>                 Delete a file from distributed storage\n");
     printf("  verify <remote_name> [--repair]      Verify file integrity, optionally repair\n");
+    printf("  scrub [--deep]                       Check every stored replica, skipping recently verified ones\n");
     printf("  health                               Check health of all configured servers\n");
+    printf("  daemon [stop]                        Run (or stop) a daemon that keeps connections warm\n");
     printf("  version                              Show version information\n");
     printf("  help                                 Show this help message\n\n");
 
@@ -79,14 +102,21 @@ static void print_usage(const char* program_name)
     printf("  -q, --quiet                          Suppress progress output\n");
     printf("  -s, --stats                          Show operation statistics\n");
     printf("  -r, --repair                         Enable repair mode for verify command\n");
+    printf("  -d, --deep                           Download a sample of the replicas when scrubbing\n");
+    printf("  -S, --socket PATH                    Daemon socket (default: daemon_socket_path)\n");
+    printf("  -n, --no-daemon                      Run in this process even if a daemon is running\n");
     printf("  -h, --help                           Show this help message\n\n");
 
     printf("EXAMPLES:\n");
     printf("  %s upload /path/to/file.txt myfile.txt\n", program_name);
+    printf("  tar c dir | %s upload - backup.tar\n", program_name);
     printf("  %s download myfile.txt /path/to/downloaded.txt\n", program_name);
     printf("  %s list\n", program_name);
     printf("  %s verify myfile.txt --repair\n", program_name);
+    printf("  %s scrub --deep\n", program_name);
     printf("  %s health\n", program_name);
+    printf("  %s -c netchunk.conf daemon &\n", program_name);
+    printf("\nWhile a daemon is running, commands other than scrub are forwarded to it.\n");
     printf("\nFor more information, visit: https://github.com/aedrax/NetChunk\n");
 }
 
@@ -190,12 +220,94 @@ static void print_stats(const netchunk_stats_t* stats)
     printf("  Duration:         %s\n", duration_str);
     printf("  Retries:          %u\n", stats->retries_performed);
 
+    if (stats->chunks_deduplicated > 0) {
+        char dedup_str[32];
+        format_bytes(stats->bytes_deduplicated, dedup_str, sizeof(dedup_str));
+        printf("  Deduplicated:     %u chunks (%s)\n", stats->chunks_deduplicated, dedup_str);
+    }
+
+    if (stats->chunks_resumed > 0) {
+        char resumed_str[32];
+        format_bytes(stats->bytes_resumed, resumed_str, sizeof(resumed_str));
+        printf("  Resumed:          %u chunks (%s)\n", stats->chunks_resumed, resumed_str);
+    }
+
+    if (stats->chunks_compressed > 0) {
+        char stored_str[32];
+        format_bytes(stats->bytes_stored, stored_str, sizeof(stored_str));
+        printf("  Compressed:       %u chunks, %s stored per replica\n", stats->chunks_compressed, stored_str);
+    }
+
+    if (stats->cache_hits > 0 || stats->cache_misses > 0) {
+        char cached_str[32];
+        format_bytes(stats->bytes_from_cache, cached_str, sizeof(cached_str));
+        printf("  Chunk cache:      %u hits (%s), %u misses\n", stats->cache_hits, cached_str, stats->cache_misses);
+    }
+
+    if (stats->chunks_hedged > 0) {
+        printf("  Hedged:           %u chunks from a backup replica\n", stats->chunks_hedged);
+    }
+
+    if (stats->chunks_under_replicated > 0) {
+        printf("  Under-replicated: %u chunks stored on fewer servers than replication_factor\n",
+            stats->chunks_under_replicated);
+    }
+
     if (stats->elapsed_seconds > 0) {
         double rate_mbps = (stats->bytes_processed / 1024.0 / 1024.0) / stats->elapsed_seconds;
         printf("  Transfer rate:    %.1f MB/s\n", rate_mbps);
     }
 }
 
+/**
+ * @brief Print the counters of a scrub pass
+ */
+static void print_scrub_stats(const netchunk_scrub_stats_t* stats)
+{
+    char bytes_str[32];
+    format_bytes(stats->bytes_downloaded, bytes_str, sizeof(bytes_str));
+
+    printf("\nScrub Statistics:\n");
+    printf("  Files:            %u\n", stats->files_scrubbed);
+    printf("  Chunks:           %llu\n", (unsigned long long)stats->chunks_scrubbed);
+    printf("  Replicas checked: %llu (%llu skipped as recently verified)\n",
+        (unsigned long long)stats->replicas_checked, (unsigned long long)stats->replicas_skipped);
+    printf("  Verified:         %llu\n", (unsigned long long)stats->replicas_verified);
+    printf("  Present:          %llu (size checked only)\n", (unsigned long long)stats->replicas_present);
+    printf("  Missing:          %llu\n", (unsigned long long)stats->replicas_missing);
+    printf("  Corrupt:          %llu\n", (unsigned long long)stats->replicas_corrupt);
+    printf("  Unreachable:      %llu\n", (unsigned long long)stats->replicas_unreachable);
+    printf("  Downloaded:       %s\n", bytes_str);
+}
+
+/**
+ * @brief Print the observed performance of each server
+ */
+static void print_server_scores(const netchunk_server_score_t* scores, int count)
+{
+    printf("  Server scores:\n");
+    for (int i = 0; i < count; i++) {
+        const netchunk_server_score_t* score = &scores[i];
+        if (score->samples == 0) {
+            printf("    Server %d: no transfers yet\n", i + 1);
+            continue;
+        }
+
+        char rate_str[32] = "-";
+        if (score->throughput_bps > 0) {
+            format_bytes((uint64_t)score->throughput_bps, rate_str, sizeof(rate_str));
+            strncat(rate_str, "/s", sizeof(rate_str) - strlen(rate_str) - 1);
+        }
+        char p95_str[32] = "-";
+        if (score->p95_ms > 0) {
+            snprintf(p95_str, sizeof(p95_str), "%.0f ms", score->p95_ms);
+        }
+        printf("    Server %d: %s, latency %.1f ms, throughput %s, p95 %s, errors %.0f%%, %d in flight, %llu samples\n",
+            i + 1, score->healthy ? "healthy" : "failing", score->latency_ms, rate_str, p95_str,
+            score->error_rate * 100.0, score->in_flight, (unsigned long long)score->samples);
+    }
+}
+
 /**
  * @brief Parse command line arguments
  */
@@ -211,6 +323,9 @@ static int parse_arguments(int argc, char* argv[], cli_config_t* config)
         { "quiet", no_argument, 0, 'q' },
         { "stats", no_argument, 0, 's' },
         { "repair", no_argument, 0, 'r' },
+        { "deep", no_argument, 0, 'd' },
+        { "socket", required_argument, 0, 'S' },
+        { "no-daemon", no_argument, 0, 'n' },
         { "help", no_argument, 0, 'h' },
         { 0, 0, 0, 0 }
     };
@@ -218,7 +333,7 @@ static int parse_arguments(int argc, char* argv[], cli_config_t* config)
     int opt;
     int option_index = 0;
 
-    while ((opt = getopt_long(argc, argv, "c:vqsrh", long_options, &option_index)) != -1) {
+    while ((opt = getopt_long(argc, argv, "c:vqsrdS:nh", long_options, &option_index)) != -1) {
         switch (opt) {
         case 'c':
             config->config_path = strdup(optarg);
@@ -235,6 +350,15 @@ static int parse_arguments(int argc, char* argv[], cli_config_t* config)
         case 'r':
             config->repair = true;
             break;
+        case 'd':
+            config->deep = true;
+            break;
+        case 'S':
+            config->socket_path = strdup(optarg);
+            break;
+        case 'n':
+            config->no_daemon = true;
+            break;
         case 'h':
             config->command = CMD_HELP;
             return 0;
@@ -281,8 +405,19 @@ static int parse_arguments(int argc, char* argv[], cli_config_t* config)
             return -1;
         }
         config->remote_name = strdup(argv[optind + 1]);
+    } else if (strcmp(command_str, "scrub") == 0) {
+        config->command = CMD_SCRUB;
     } else if (strcmp(command_str, "health") == 0) {
         config->command = CMD_HEALTH;
+    } else if (strcmp(command_str, "daemon") == 0) {
+        config->command = CMD_DAEMON;
+        if (optind + 1 < argc) {
+            if (strcmp(argv[optind + 1], "stop") != 0) {
+                fprintf(stderr, "Error: Unknown daemon action '%s'\n", argv[optind + 1]);
+                return -1;
+            }
+            config->stop_daemon = true;
+        }
     } else if (strcmp(command_str, "version") == 0) {
         config->command = CMD_VERSION;
     } else if (strcmp(command_str, "help") == 0) {
@@ -303,6 +438,7 @@ static void cleanup_config(cli_config_t* config)
     free(config->config_path);
     free(config->local_path);
     free(config->remote_name);
+    free(config->socket_path);
 }
 
 /**
@@ -331,11 +467,236 @@ static const char* get_error_message(netchunk_error_t error)
         return "Download failed";
     case NETCHUNK_ERROR_CHUNK_INTEGRITY:
         return "Chunk integrity error";
+    case NETCHUNK_ERROR_SERVER_UNAVAILABLE:
+        return "Server unavailable";
+    case NETCHUNK_ERROR_TIMEOUT:
+        return "Timed out";
     default:
         return "Unknown error";
     }
 }
 
+/**
+ * @brief Resolve the daemon socket from --socket or the configuration file
+ */
+static void resolve_socket_path(const cli_config_t* config, char* buffer, size_t buffer_size)
+{
+    if (config->socket_path) {
+        snprintf(buffer, buffer_size, "%s", config->socket_path);
+        return;
+    }
+
+    // Only the socket path is needed here, so an unusable configuration
+    // falls back to the default and is reported later by netchunk_init()
+    netchunk_config_t file_config;
+    if (!config->config_path || netchunk_config_load(&file_config, config->config_path) != NETCHUNK_SUCCESS) {
+        netchunk_config_init_defaults(&file_config);
+    }
+    snprintf(buffer, buffer_size, "%s", file_config.daemon_socket_path);
+    netchunk_config_cleanup(&file_config);
+}
+
+/**
+ * @brief Signal handler that stops the running daemon
+ */
+static void daemon_signal_handler(int signum)
+{
+    (void)signum;
+    if (running_daemon) {
+        netchunk_daemon_stop(running_daemon);
+    }
+}
+
+/**
+ * @brief Run the daemon in the foreground, or stop a running one
+ */
+static int run_daemon_command(const cli_config_t* config)
+{
+    char socket_path[NETCHUNK_MAX_PATH_LEN];
+    resolve_socket_path(config, socket_path, sizeof(socket_path));
+
+    if (config->stop_daemon) {
+        netchunk_daemon_client_t client;
+        netchunk_error_t error = netchunk_daemon_connect(&client, socket_path);
+        if (error == NETCHUNK_SUCCESS) {
+            error = netchunk_daemon_shutdown(&client);
+            netchunk_daemon_disconnect(&client);
+        }
+        if (error != NETCHUNK_SUCCESS) {
+            fprintf(stderr, "Error: Failed to stop daemon: %s\n", get_error_message(error));
+            return 1;
+        }
+        if (!config->quiet) {
+            printf("Daemon stopped.\n");
+        }
+        return 0;
+    }
+
+    netchunk_context_t netchunk_ctx;
+    netchunk_error_t error = netchunk_init(&netchunk_ctx, config->config_path);
+    if (error != NETCHUNK_SUCCESS) {
+        fprintf(stderr, "Error: Failed to initialize NetChunk: %s\n", get_error_message(error));
+        return 1;
+    }
+
+    netchunk_daemon_t daemon;
+    error = netchunk_daemon_init(&daemon, &netchunk_ctx, socket_path);
+    if (error != NETCHUNK_SUCCESS) {
+        if (error == NETCHUNK_ERROR_CONFIG) {
+            fprintf(stderr, "Error: A daemon is already listening on %s\n", socket_path);
+        } else {
+            fprintf(stderr, "Error: Failed to start daemon: %s\n", get_error_message(error));
+        }
+        netchunk_cleanup(&netchunk_ctx);
+        return 1;
+    }
+
+    // Stop cleanly on SIGINT/SIGTERM so the socket is removed
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = daemon_signal_handler;
+    sigemptyset(&action.sa_mask);
+    running_daemon = &daemon;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    if (!config->quiet) {
+        printf("NetChunk daemon listening on %s\n", daemon.socket_path);
+        fflush(stdout);
+    }
+
+    error = netchunk_daemon_run(&daemon);
+
+    running_daemon = NULL;
+    netchunk_daemon_cleanup(&daemon);
+    netchunk_cleanup(&netchunk_ctx);
+
+    if (error != NETCHUNK_SUCCESS) {
+        fprintf(stderr, "Error: Daemon failed: %s\n", get_error_message(error));
+        return 1;
+    }
+    if (!config->quiet) {
+        printf("Daemon stopped after %llu requests.\n", (unsigned long long)daemon.requests_served);
+    }
+    return 0;
+}
+
+/**
+ * @brief Map an open()/errno failure to a NetChunk error
+ */
+static netchunk_error_t open_error(void)
+{
+    return errno == ENOENT ? NETCHUNK_ERROR_FILE_NOT_FOUND : NETCHUNK_ERROR_FILE_ACCESS;
+}
+
+/**
+ * @brief Upload locally or by passing the opened file to the daemon
+ */
+static netchunk_error_t backend_upload(cli_backend_t* backend, const char* local_path,
+    const char* remote_name, netchunk_stats_t* stats)
+{
+    if (!backend->client) {
+        return netchunk_upload(backend->context, local_path, remote_name, stats);
+    }
+
+    bool use_stdin = strcmp(local_path, "-") == 0;
+    int fd = use_stdin ? STDIN_FILENO : open(local_path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return open_error();
+    }
+
+    netchunk_error_t error = netchunk_daemon_upload(backend->client, fd, remote_name, stats);
+    if (!use_stdin) {
+        close(fd);
+    }
+    return error;
+}
+
+/**
+ * @brief Download locally or into a file opened here and passed to the daemon
+ */
+static netchunk_error_t backend_download(cli_backend_t* backend, const char* remote_name,
+    const char* local_path, netchunk_stats_t* stats)
+{
+    if (!backend->client) {
+        return netchunk_download(backend->context, remote_name, local_path, stats);
+    }
+
+    // The daemon truncates the file itself; only remove it on failure if
+    // it did not exist before
+    bool created = true;
+    int fd = open(local_path, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (fd < 0 && errno == EEXIST) {
+        created = false;
+        fd = open(local_path, O_WRONLY | O_CLOEXEC);
+    }
+    if (fd < 0) {
+        return open_error();
+    }
+
+    netchunk_error_t error = netchunk_daemon_download(backend->client, remote_name, fd, stats);
+    close(fd);
+
+    if (error != NETCHUNK_SUCCESS && created) {
+        unlink(local_path);
+    }
+    return error;
+}
+
+/**
+ * @brief List files locally or through the daemon
+ */
+static netchunk_error_t backend_list_files(cli_backend_t* backend,
+    netchunk_file_manifest_t** files, size_t* count)
+{
+    if (backend->client) {
+        return netchunk_daemon_list_files(backend->client, files, count);
+    }
+    return netchunk_list_files(backend->context, files, count);
+}
+
+/**
+ * @brief Delete locally or through the daemon
+ */
+static netchunk_error_t backend_delete(cli_backend_t* backend, const char* remote_name)
+{
+    if (backend->client) {
+        return netchunk_daemon_delete(backend->client, remote_name);
+    }
+    return netchunk_delete(backend->context, remote_name);
+}
+
+/**
+ * @brief Verify locally or through the daemon
+ */
+static netchunk_error_t backend_verify(cli_backend_t* backend, const char* remote_name, bool repair,
+    uint32_t* chunks_verified, uint32_t* chunks_repaired)
+{
+    if (backend->client) {
+        return netchunk_daemon_verify(backend->client, remote_name, repair, chunks_verified, chunks_repaired);
+    }
+    return netchunk_verify(backend->context, remote_name, repair, chunks_verified, chunks_repaired);
+}
+
+/**
+ * @brief Health check locally or through the daemon, with the server scores
+ */
+static netchunk_error_t backend_health_check(cli_backend_t* backend,
+    uint32_t* healthy_servers, uint32_t* total_servers,
+    netchunk_server_score_t* scores, int max_scores, int* score_count)
+{
+    if (backend->client) {
+        return netchunk_daemon_health_report(backend->client, healthy_servers, total_servers,
+            scores, max_scores, score_count);
+    }
+
+    netchunk_error_t error = netchunk_health_check(backend->context, healthy_servers, total_servers);
+    if (error == NETCHUNK_SUCCESS) {
+        error = netchunk_get_server_scores(backend->context, scores, max_scores, score_count);
+    }
+    return error;
+}
+
 /**
  * @brief Main application entry point
  */
@@ -370,21 +731,48 @@ int main(int argc, char* argv[])
         return 0;
     }
 
-    // Initialize NetChunk context
-    error = netchunk_init(&netchunk_ctx, config.config_path);
-    if (error != NETCHUNK_SUCCESS) {
-        fprintf(stderr, "Error: Failed to initialize NetChunk: %s\n", get_error_message(error));
-        if (error == NETCHUNK_ERROR_CONFIG) {
-            fprintf(stderr, "Please check your configuration file.\n");
-        }
+    if (config.command == CMD_DAEMON) {
+        exit_code = run_daemon_command(&config);
         cleanup_config(&config);
-        return 1;
+        return exit_code;
+    }
+
+    // Forward to a running daemon when there is one, so its warm
+    // connections are reused; otherwise run in this process
+    cli_backend_t backend = { NULL, NULL };
+    netchunk_daemon_client_t daemon_client;
+
+    // A scrub pass runs for a long time and would hold up the daemon's clients
+    if (!config.no_daemon && config.command != CMD_SCRUB) {
+        char socket_path[NETCHUNK_MAX_PATH_LEN];
+        resolve_socket_path(&config, socket_path, sizeof(socket_path));
+        if (netchunk_daemon_connect(&daemon_client, socket_path) == NETCHUNK_SUCCESS) {
+            backend.client = &daemon_client;
+        }
+    }
+
+    if (!backend.client) {
+        // Initialize NetChunk context
+        error = netchunk_init(&netchunk_ctx, config.config_path);
+        if (error != NETCHUNK_SUCCESS) {
+            fprintf(stderr, "Error: Failed to initialize NetChunk: %s\n", get_error_message(error));
+            if (error == NETCHUNK_ERROR_CONFIG) {
+                fprintf(stderr, "Please check your configuration file.\n");
+            }
+            cleanup_config(&config);
+            return 1;
+        }
+        backend.context = &netchunk_ctx;
     }
 
     // Set up progress callback if not quiet
     if (!config.quiet) {
         progress_ctx.verbose = config.verbose;
-        netchunk_set_progress_callback(&netchunk_ctx, progress_callback, &progress_ctx);
+        if (backend.client) {
+            netchunk_daemon_client_set_progress_callback(backend.client, progress_callback, &progress_ctx);
+        } else {
+            netchunk_set_progress_callback(&netchunk_ctx, progress_callback, &progress_ctx);
+        }
     }
 
     // Execute command
@@ -396,7 +784,7 @@ int main(int argc, char* argv[])
             printf("Uploading '%s' as '%s'...\n", config.local_path, config.remote_name);
         }
 
-        error = netchunk_upload(&netchunk_ctx, config.local_path, config.remote_name, &stats);
+        error = backend_upload(&backend, config.local_path, config.remote_name, &stats);
         if (error == NETCHUNK_SUCCESS) {
             if (!config.quiet) {
                 printf("Upload completed successfully.\n");
@@ -404,6 +792,11 @@ int main(int argc, char* argv[])
             if (config.show_stats) {
                 print_stats(&stats);
             }
+            if (stats.chunks_under_replicated > 0) {
+                fprintf(stderr, "Warning: %u chunks are stored on fewer servers than replication_factor; "
+                                "run 'verify %s --repair' once the servers are back\n",
+                    stats.chunks_under_replicated, config.remote_name);
+            }
         } else {
             fprintf(stderr, "Error: Upload failed: %s\n", get_error_message(error));
             exit_code = 1;
@@ -416,7 +809,7 @@ int main(int argc, char* argv[])
             printf("Downloading '%s' to '%s'...\n", config.remote_name, config.local_path);
         }
 
-        error = netchunk_download(&netchunk_ctx, config.remote_name, config.local_path, &stats);
+        error = backend_download(&backend, config.remote_name, config.local_path, &stats);
         if (error == NETCHUNK_SUCCESS) {
             if (!config.quiet) {
                 printf("Download completed successfully.\n");
@@ -435,7 +828,7 @@ int main(int argc, char* argv[])
         netchunk_file_manifest_t* files;
         size_t file_count;
 
-        error = netchunk_list_files(&netchunk_ctx, &files, &file_count);
+        error = backend_list_files(&backend, &files, &file_count);
         if (error == NETCHUNK_SUCCESS) {
             if (file_count == 0) {
                 printf("No files found in distributed storage.\n");
@@ -472,7 +865,7 @@ int main(int argc, char* argv[])
             printf("Deleting '%s'...\n", config.remote_name);
         }
 
-        error = netchunk_delete(&netchunk_ctx, config.remote_name);
+        error = backend_delete(&backend, config.remote_name);
         if (error == NETCHUNK_SUCCESS) {
             if (!config.quiet) {
                 printf("File deleted successfully.\n");
@@ -492,7 +885,7 @@ int main(int argc, char* argv[])
                 config.repair ? " (repair mode)" : "");
         }
 
-        error = netchunk_verify(&netchunk_ctx, config.remote_name, config.repair,
+        error = backend_verify(&backend, config.remote_name, config.repair,
             &chunks_verified, &chunks_repaired);
         if (error == NETCHUNK_SUCCESS) {
             if (!config.quiet) {
@@ -509,14 +902,46 @@ int main(int argc, char* argv[])
         break;
     }
 
+    case CMD_SCRUB: {
+        netchunk_scrub_stats_t scrub_stats;
+        bool deep = config.deep || netchunk_ctx.config->scrub_deep;
+
+        if (config.verbose) {
+            printf("Scrubbing all replicas%s...\n", deep ? " (deep)" : "");
+        }
+
+        error = netchunk_scrub(&netchunk_ctx, deep, &scrub_stats);
+        if (error == NETCHUNK_SUCCESS) {
+            if (!config.quiet) {
+                printf("Scrub completed: %llu replicas checked, %llu missing, %llu corrupt.\n",
+                    (unsigned long long)scrub_stats.replicas_checked,
+                    (unsigned long long)scrub_stats.replicas_missing,
+                    (unsigned long long)scrub_stats.replicas_corrupt);
+            }
+            if (config.show_stats) {
+                print_scrub_stats(&scrub_stats);
+            }
+            if (scrub_stats.replicas_missing > 0 || scrub_stats.replicas_corrupt > 0) {
+                exit_code = 1;
+            }
+        } else {
+            fprintf(stderr, "Error: Scrub failed: %s\n", get_error_message(error));
+            exit_code = 1;
+        }
+        break;
+    }
+
     case CMD_HEALTH: {
         uint32_t healthy_servers, total_servers;
+        netchunk_server_score_t scores[NETCHUNK_MAX_SERVERS];
+        int score_count = 0;
 
         if (config.verbose) {
             printf("Checking server health...\n");
         }
 
-        error = netchunk_health_check(&netchunk_ctx, &healthy_servers, &total_servers);
+        error = backend_health_check(&backend, &healthy_servers, &total_servers,
+            scores, NETCHUNK_MAX_SERVERS, &score_count);
         if (error == NETCHUNK_SUCCESS) {
             printf("Server Health Status:\n");
             printf("  Healthy servers: %u / %u\n", healthy_servers, total_servers);
@@ -530,6 +955,7 @@ int main(int argc, char* argv[])
                 printf("  Status: Partial connectivity ⚠\n");
                 exit_code = 1;
             }
+            print_server_scores(scores, score_count);
         } else {
             fprintf(stderr, "Error: Health check failed: %s\n", get_error_message(error));
             exit_code = 1;
@@ -545,7 +971,11 @@ int main(int argc, char* argv[])
     }
 
     // Cleanup
-    netchunk_cleanup(&netchunk_ctx);
+    if (backend.client) {
+        netchunk_daemon_disconnect(backend.client);
+    } else {
+        netchunk_cleanup(&netchunk_ctx);
+    }
     cleanup_config(&config);
 
     return exit_code;
@@ -1,5 +1,9 @@
 #include "manifest.h"
+#include "compress.h"
 #include "crypto.h"
+#include "erasure.h"
+#include "ftp_client.h"
+#include "manifest_pack.h"
 #include <dirent.h>
 #include <errno.h>
 #include <limits.h>
@@ -10,10 +14,9 @@
 #include <unistd.h>
 
 // Internal helper functions
-static netchunk_error_t write_file_atomically(const char* file_path, const char* content);
-static netchunk_error_t read_file_content(const char* file_path, char** content);
 static int compare_timestamps(const void* a, const void* b);
 static netchunk_error_t ensure_directory_exists(const char* dir_path);
+static bool chunk_encoding_valid(const netchunk_chunk_t* chunk);
 
 // Manifest Management Functions
 
@@ -103,9 +106,11 @@ netchunk_error_t netchunk_file_manifest_init(netchunk_file_manifest_t* manifest,
 
         memcpy(manifest->chunks, chunks, sizeof(netchunk_chunk_t) * chunk_count);
         manifest->chunks_owned = true;
+        manifest->chunk_capacity = chunk_count;
     } else {
         manifest->chunks = NULL;
         manifest->chunks_owned = false;
+        manifest->chunk_capacity = 0;
     }
 
     // Set default replication settings
@@ -135,6 +140,12 @@ void netchunk_file_manifest_cleanup(netchunk_file_manifest_t* manifest)
     }
 
     manifest->chunks_owned = false;
+    manifest->chunk_capacity = 0;
+
+    free(manifest->parity_chunks);
+    manifest->parity_chunks = NULL;
+    manifest->parity_count = 0;
+    manifest->parity_capacity = 0;
 }
 
 netchunk_error_t netchunk_file_manifest_create_from_chunker(netchunk_file_manifest_t* manifest,
@@ -194,6 +205,7 @@ netchunk_error_t netchunk_file_manifest_to_json(const netchunk_file_manifest_t*
     cJSON_AddStringToObject(root, "original_filename", manifest->original_filename);
     cJSON_AddNumberToObject(root, "total_size", (double)manifest->total_size);
     cJSON_AddNumberToObject(root, "chunk_size", (double)manifest->chunk_size);
+    cJSON_AddStringToObject(root, "chunking", netchunk_chunking_mode_to_string(manifest->chunking_mode));
     cJSON_AddNumberToObject(root, "chunk_count", manifest->chunk_count);
 
     // File hash as hex string
@@ -233,6 +245,29 @@ netchunk_error_t netchunk_file_manifest_to_json(const netchunk_file_manifest_t*
 
     cJSON_AddItemToObject(root, "chunks", chunks_array);
 
+    // Stripe layout and parity chunks of erasure-coded files
+    if (netchunk_manifest_is_erasure_coded(manifest)) {
+        cJSON* erasure = cJSON_CreateObject();
+        cJSON* parity_array = cJSON_CreateArray();
+        if (!erasure || !parity_array) {
+            cJSON_Delete(erasure);
+            cJSON_Delete(parity_array);
+            cJSON_Delete(root);
+            return NETCHUNK_ERROR_OUT_OF_MEMORY;
+        }
+
+        cJSON_AddNumberToObject(erasure, "data_shards", manifest->ec_data_shards);
+        cJSON_AddNumberToObject(erasure, "parity_shards", manifest->ec_parity_shards);
+        for (uint32_t i = 0; i < manifest->parity_count; i++) {
+            cJSON* chunk_json = netchunk_chunk_to_json(&manifest->parity_chunks[i]);
+            if (chunk_json) {
+                cJSON_AddItemToArray(parity_array, chunk_json);
+            }
+        }
+        cJSON_AddItemToObject(erasure, "parity_chunks", parity_array);
+        cJSON_AddItemToObject(root, "erasure", erasure);
+    }
+
     // Convert to string
     char* json_string = cJSON_Print(root);
     cJSON_Delete(root);
@@ -285,6 +320,13 @@ netchunk_error_t netchunk_file_manifest_from_json(const char* json_input,
         manifest->chunk_size = (size_t)chunk_size->valuedouble;
     }
 
+    // Manifests written before content-defined chunking have no mode and fixed offsets
+    cJSON* chunking = cJSON_GetObjectItem(root, "chunking");
+    bool legacy_offsets = !(chunking && cJSON_IsString(chunking));
+    if (!legacy_offsets) {
+        manifest->chunking_mode = netchunk_chunking_mode_from_string(chunking->valuestring);
+    }
+
     cJSON* chunk_count = cJSON_GetObjectItem(root, "chunk_count");
     if (chunk_count && cJSON_IsNumber(chunk_count)) {
         manifest->chunk_count = (uint32_t)chunk_count->valuedouble;
@@ -353,19 +395,50 @@ netchunk_error_t netchunk_file_manifest_from_json(const char* json_input,
             }
 
             manifest->chunks_owned = true;
+            manifest->chunk_capacity = (uint32_t)array_size;
             int chunks_loaded = 0;
 
-            for (int i = 0; i < array_size; i++) {
-                cJSON* chunk_json = cJSON_GetArrayItem(chunks_array, i);
-                if (chunk_json) {
-                    netchunk_error_t chunk_error = netchunk_chunk_from_json(chunk_json, &manifest->chunks[chunks_loaded]);
-                    if (chunk_error == NETCHUNK_SUCCESS) {
-                        chunks_loaded++;
-                    }
+            // Walked in order: looking items up by index is linear per lookup
+            cJSON* chunk_json = NULL;
+            cJSON_ArrayForEach(chunk_json, chunks_array)
+            {
+                netchunk_error_t chunk_error = netchunk_chunk_from_json(chunk_json, &manifest->chunks[chunks_loaded]);
+                if (chunk_error == NETCHUNK_SUCCESS) {
+                    chunks_loaded++;
                 }
             }
 
             manifest->chunk_count = chunks_loaded;
+
+            if (legacy_offsets) {
+                for (int i = 0; i < chunks_loaded; i++) {
+                    manifest->chunks[i].offset = (size_t)manifest->chunks[i].sequence_number * manifest->chunk_size;
+                }
+            }
+        }
+    }
+
+    // Stripe layout and parity chunks of erasure-coded files
+    cJSON* erasure = cJSON_GetObjectItem(root, "erasure");
+    if (erasure && cJSON_IsObject(erasure)) {
+        cJSON* data_shards = cJSON_GetObjectItem(erasure, "data_shards");
+        cJSON* parity_shards = cJSON_GetObjectItem(erasure, "parity_shards");
+        if (data_shards && cJSON_IsNumber(data_shards) && parity_shards && cJSON_IsNumber(parity_shards)) {
+            manifest->ec_data_shards = (int)data_shards->valuedouble;
+            manifest->ec_parity_shards = (int)parity_shards->valuedouble;
+        }
+
+        cJSON* parity_array = cJSON_GetObjectItem(erasure, "parity_chunks");
+        cJSON* parity_json = NULL;
+        cJSON_ArrayForEach(parity_json, parity_array)
+        {
+            netchunk_chunk_t parity;
+            if (netchunk_chunk_from_json(parity_json, &parity) == NETCHUNK_SUCCESS
+                && netchunk_manifest_add_parity_chunk(manifest, &parity) != NETCHUNK_SUCCESS) {
+                cJSON_Delete(root);
+                netchunk_file_manifest_cleanup(manifest);
+                return NETCHUNK_ERROR_OUT_OF_MEMORY;
+            }
         }
     }
 
@@ -388,13 +461,31 @@ cJSON* netchunk_chunk_to_json(const netchunk_chunk_t* chunk)
     cJSON_AddStringToObject(chunk_json, "id", chunk->id);
     cJSON_AddNumberToObject(chunk_json, "sequence_number", chunk->sequence_number);
     cJSON_AddNumberToObject(chunk_json, "size", (double)chunk->size);
+    cJSON_AddNumberToObject(chunk_json, "offset", (double)chunk->offset);
     cJSON_AddNumberToObject(chunk_json, "created_timestamp", (double)chunk->created_timestamp);
 
+    // Raw chunks leave the encoding out, as before compression existed
+    if (chunk->codec != NETCHUNK_COMPRESSION_NONE) {
+        cJSON_AddStringToObject(chunk_json, "codec", netchunk_compression_to_string(chunk->codec));
+    }
+    if (netchunk_key_id_is_set(chunk->key_id)) {
+        char key_id_hex[NETCHUNK_KEY_ID_LENGTH * 2 + 1];
+        netchunk_hash_to_hex_string(chunk->key_id, NETCHUNK_KEY_ID_LENGTH, key_id_hex);
+        cJSON_AddStringToObject(chunk_json, "key_id", key_id_hex);
+    }
+    if (netchunk_chunk_is_encoded(chunk)) {
+        cJSON_AddNumberToObject(chunk_json, "stored_size", (double)chunk->stored_size);
+    }
+
     // Hash as hex string
     char hash_hex[NETCHUNK_HASH_LENGTH * 2 + 1];
     netchunk_hash_to_hex_string(chunk->hash, NETCHUNK_HASH_LENGTH, hash_hex);
     cJSON_AddStringToObject(chunk_json, "hash", hash_hex);
 
+    // Remote paths are derived from the ID but still exported for readers
+    char remote_path[NETCHUNK_MAX_PATH_LEN] = "";
+    netchunk_ftp_chunk_path(chunk, remote_path, sizeof(remote_path));
+
     // Locations array
     cJSON* locations_array = cJSON_CreateArray();
     if (locations_array) {
@@ -404,7 +495,7 @@ cJSON* netchunk_chunk_to_json(const netchunk_chunk_t* chunk)
             cJSON* location_json = cJSON_CreateObject();
             if (location_json) {
                 cJSON_AddStringToObject(location_json, "server_id", location->server_id);
-                cJSON_AddStringToObject(location_json, "remote_path", location->remote_path);
+                cJSON_AddStringToObject(location_json, "remote_path", remote_path);
                 cJSON_AddNumberToObject(location_json, "upload_time", (double)location->upload_time);
                 cJSON_AddBoolToObject(location_json, "verified", location->verified);
                 cJSON_AddNumberToObject(location_json, "last_verified", (double)location->last_verified);
@@ -443,11 +534,37 @@ netchunk_error_t netchunk_chunk_from_json(const cJSON* json, netchunk_chunk_t* c
         chunk->size = (size_t)size->valuedouble;
     }
 
+    cJSON* offset = cJSON_GetObjectItem(json, "offset");
+    if (offset && cJSON_IsNumber(offset)) {
+        chunk->offset = (size_t)offset->valuedouble;
+    }
+
     cJSON* created = cJSON_GetObjectItem(json, "created_timestamp");
     if (created && cJSON_IsNumber(created)) {
         chunk->created_timestamp = (time_t)created->valuedouble;
     }
 
+    cJSON* codec = cJSON_GetObjectItem(json, "codec");
+    if (codec && cJSON_IsString(codec)) {
+        // An unknown codec cannot be decoded; refuse the chunk rather than misread it
+        chunk->codec = netchunk_compression_from_string(codec->valuestring);
+        if (chunk->codec == NETCHUNK_COMPRESSION_NONE && strcmp(codec->valuestring, "none") != 0) {
+            return NETCHUNK_ERROR_MANIFEST_CORRUPT;
+        }
+    }
+
+    cJSON* key_id = cJSON_GetObjectItem(json, "key_id");
+    if (key_id && cJSON_IsString(key_id)) {
+        if (netchunk_hex_string_to_hash(key_id->valuestring, chunk->key_id, NETCHUNK_KEY_ID_LENGTH) != NETCHUNK_SUCCESS) {
+            return NETCHUNK_ERROR_MANIFEST_CORRUPT;
+        }
+    }
+
+    cJSON* stored_size = cJSON_GetObjectItem(json, "stored_size");
+    if (stored_size && cJSON_IsNumber(stored_size)) {
+        chunk->stored_size = (size_t)stored_size->valuedouble;
+    }
+
     // Hash from hex string
     cJSON* hash_hex = cJSON_GetObjectItem(json, "hash");
     if (hash_hex && cJSON_IsString(hash_hex)) {
@@ -470,11 +587,6 @@ netchunk_error_t netchunk_chunk_from_json(const cJSON* json, netchunk_chunk_t* c
                     strncpy(location->server_id, server_id->valuestring, sizeof(location->server_id) - 1);
                 }
 
-                cJSON* remote_path = cJSON_GetObjectItem(location_json, "remote_path");
-                if (remote_path && cJSON_IsString(remote_path)) {
-                    strncpy(location->remote_path, remote_path->valuestring, NETCHUNK_MAX_PATH_LEN - 1);
-                }
-
                 cJSON* uploaded = cJSON_GetObjectItem(location_json, "upload_time");
                 if (uploaded && cJSON_IsNumber(uploaded)) {
                     location->upload_time = (time_t)uploaded->valuedouble;
@@ -523,18 +635,17 @@ netchunk_error_t netchunk_manifest_save_to_file(netchunk_manifest_manager_t* man
         netchunk_manifest_backup(manager, filename);
     }
 
-    // Convert manifest to JSON
-    char* json_content;
-    netchunk_error_t json_error = netchunk_file_manifest_to_json(manifest, &json_content);
-    if (json_error != NETCHUNK_SUCCESS) {
-        return json_error;
+    // Stored packed; JSON is only produced for export
+    netchunk_packed_manifest_t packed;
+    netchunk_error_t pack_error = netchunk_manifest_pack(manifest, &packed);
+    if (pack_error != NETCHUNK_SUCCESS) {
+        return pack_error;
     }
 
     // Write file atomically
-    netchunk_error_t write_error = write_file_atomically(full_path, json_content);
+    netchunk_error_t write_error = netchunk_packed_manifest_save(&packed, full_path);
 
-    // Cleanup JSON string
-    free(json_content);
+    netchunk_packed_manifest_close(&packed);
 
     return write_error;
 }
@@ -554,12 +665,29 @@ netchunk_error_t netchunk_manifest_load_from_file(netchunk_manifest_manager_t* m
         return path_error;
     }
 
+    // Packed manifests are mapped; anything else is read as JSON
+    netchunk_packed_manifest_t packed;
+    netchunk_error_t open_error = netchunk_packed_manifest_open(&packed, full_path);
+    if (open_error == NETCHUNK_SUCCESS) {
+        netchunk_error_t unpack_error = netchunk_packed_manifest_unpack(&packed, manifest);
+        netchunk_packed_manifest_close(&packed);
+        return unpack_error;
+    }
+    if (open_error != NETCHUNK_ERROR_MANIFEST_CORRUPT) {
+        return open_error;
+    }
+
     // Read file content
     char* json_content;
-    netchunk_error_t read_error = read_file_content(full_path, &json_content);
+    size_t json_size;
+    netchunk_error_t read_error = netchunk_manifest_read_file(full_path, &json_content, &json_size);
     if (read_error != NETCHUNK_SUCCESS) {
         return read_error;
     }
+    if (netchunk_packed_manifest_detect(json_content, json_size)) {
+        free(json_content);
+        return NETCHUNK_ERROR_MANIFEST_CORRUPT;
+    }
 
     // Parse JSON
     netchunk_error_t parse_error = netchunk_file_manifest_from_json(json_content, manifest);
@@ -687,14 +815,17 @@ netchunk_error_t netchunk_manifest_validate(const netchunk_file_manifest_t* mani
         return NETCHUNK_ERROR_CONFIG_VALIDATION;
     }
 
-    // Check chunk count consistency
-    uint32_t expected_chunks = netchunk_calculate_chunk_count(manifest->total_size, manifest->chunk_size);
-    if (manifest->chunk_count != expected_chunks) {
-        return NETCHUNK_ERROR_MANIFEST_CORRUPT;
+    // Check chunk count consistency (content-defined chunk counts depend on the data)
+    if (manifest->chunking_mode == NETCHUNK_CHUNKING_FIXED) {
+        uint32_t expected_chunks = netchunk_calculate_chunk_count(manifest->total_size, manifest->chunk_size);
+        if (manifest->chunk_count != expected_chunks) {
+            return NETCHUNK_ERROR_MANIFEST_CORRUPT;
+        }
     }
 
     // Validate chunks if present
     if (manifest->chunks) {
+        size_t expected_offset = 0;
         for (uint32_t i = 0; i < manifest->chunk_count; i++) {
             const netchunk_chunk_t* chunk = &manifest->chunks[i];
 
@@ -705,6 +836,45 @@ netchunk_error_t netchunk_manifest_validate(const netchunk_file_manifest_t* mani
             if (chunk->location_count < 0 || chunk->location_count > NETCHUNK_MAX_CHUNK_LOCATIONS) {
                 return NETCHUNK_ERROR_MANIFEST_CORRUPT;
             }
+
+            // Chunks must cover the file back to back
+            if (chunk->size == 0 || chunk->offset != expected_offset) {
+                return NETCHUNK_ERROR_MANIFEST_CORRUPT;
+            }
+
+            if (!chunk_encoding_valid(chunk)) {
+                return NETCHUNK_ERROR_MANIFEST_CORRUPT;
+            }
+            expected_offset += chunk->size;
+        }
+
+        if (expected_offset != manifest->total_size) {
+            return NETCHUNK_ERROR_MANIFEST_CORRUPT;
+        }
+    }
+
+    // Every stripe needs all its parity, each at least as large as its data
+    if (manifest->ec_data_shards != 0 || manifest->ec_parity_shards != 0) {
+        if (!netchunk_ec_layout_valid(manifest->ec_data_shards, manifest->ec_parity_shards)
+            || manifest->parity_count != netchunk_manifest_stripe_count(manifest) * (uint32_t)manifest->ec_parity_shards) {
+            return NETCHUNK_ERROR_MANIFEST_CORRUPT;
+        }
+
+        for (uint32_t i = 0; i < manifest->parity_count; i++) {
+            const netchunk_chunk_t* parity = &manifest->parity_chunks[i];
+            if (strlen(parity->id) == 0 || parity->sequence_number != i
+                || parity->location_count < 0 || parity->location_count > NETCHUNK_MAX_CHUNK_LOCATIONS
+                || !chunk_encoding_valid(parity)) {
+                return NETCHUNK_ERROR_MANIFEST_CORRUPT;
+            }
+
+            uint32_t stripe = i / (uint32_t)manifest->ec_parity_shards;
+            for (int d = 0; d < manifest->ec_data_shards && manifest->chunks; d++) {
+                const netchunk_chunk_t* data = netchunk_manifest_stripe_shard(manifest, stripe, d);
+                if (data && data->size > parity->size) {
+                    return NETCHUNK_ERROR_MANIFEST_CORRUPT;
+                }
+            }
         }
     }
 
@@ -747,6 +917,44 @@ netchunk_error_t netchunk_manifest_init(netchunk_file_manifest_t* manifest,
     return NETCHUNK_SUCCESS;
 }
 
+netchunk_error_t netchunk_manifest_reserve_chunks(netchunk_file_manifest_t* manifest,
+    uint32_t count)
+{
+    if (!manifest) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    // A borrowed array is copied into an owned one on first growth
+    uint32_t capacity = manifest->chunks_owned ? manifest->chunk_capacity : 0;
+    if (manifest->chunks && capacity >= count) {
+        return NETCHUNK_SUCCESS;
+    }
+    if (count < manifest->chunk_count) {
+        count = manifest->chunk_count;
+    }
+    if (count == 0) {
+        count = 1;
+    }
+
+    netchunk_chunk_t* new_chunks;
+    if (manifest->chunks_owned) {
+        new_chunks = realloc(manifest->chunks, sizeof(netchunk_chunk_t) * count);
+    } else {
+        new_chunks = malloc(sizeof(netchunk_chunk_t) * count);
+        if (new_chunks && manifest->chunks && manifest->chunk_count > 0) {
+            memcpy(new_chunks, manifest->chunks, sizeof(netchunk_chunk_t) * manifest->chunk_count);
+        }
+    }
+    if (!new_chunks) {
+        return NETCHUNK_ERROR_OUT_OF_MEMORY;
+    }
+
+    manifest->chunks = new_chunks;
+    manifest->chunks_owned = true;
+    manifest->chunk_capacity = count;
+    return NETCHUNK_SUCCESS;
+}
+
 netchunk_error_t netchunk_manifest_add_chunk(netchunk_file_manifest_t* manifest,
     const netchunk_chunk_t* chunk)
 {
@@ -754,49 +962,93 @@ netchunk_error_t netchunk_manifest_add_chunk(netchunk_file_manifest_t* manifest,
         return NETCHUNK_ERROR_INVALID_ARGUMENT;
     }
 
-    // Allocate or expand chunks array
-    if (!manifest->chunks) {
-        manifest->chunks = malloc(sizeof(netchunk_chunk_t));
-        if (!manifest->chunks) {
-            return NETCHUNK_ERROR_OUT_OF_MEMORY;
+    // Double the array when full so adding N chunks costs O(N) copies
+    uint32_t capacity = manifest->chunks_owned ? manifest->chunk_capacity : 0;
+    if (!manifest->chunks || capacity <= manifest->chunk_count) {
+        uint32_t new_capacity = manifest->chunk_count < 16 ? 32 : manifest->chunk_count * 2;
+        netchunk_error_t error = netchunk_manifest_reserve_chunks(manifest, new_capacity);
+        if (error != NETCHUNK_SUCCESS) {
+            return error;
         }
-        manifest->chunks_owned = true;
-        manifest->chunk_count = 0;
-    } else {
-        // Reallocate for one more chunk
-        netchunk_chunk_t* new_chunks = realloc(manifest->chunks,
-            sizeof(netchunk_chunk_t) * (manifest->chunk_count + 1));
-        if (!new_chunks) {
-            return NETCHUNK_ERROR_OUT_OF_MEMORY;
-        }
-        manifest->chunks = new_chunks;
     }
 
-    // Copy chunk data
-    manifest->chunks[manifest->chunk_count] = *chunk;
+    // Copy the metadata only; the payload stays with the caller
+    netchunk_chunk_t* entry = &manifest->chunks[manifest->chunk_count];
+    *entry = *chunk;
+    entry->data = NULL;
+    entry->data_owned = false;
 
-    // If chunk owns data, we need to copy it
-    if (chunk->data_owned && chunk->data) {
-        manifest->chunks[manifest->chunk_count].data = malloc(chunk->size);
-        if (!manifest->chunks[manifest->chunk_count].data) {
+    manifest->chunk_count++;
+    return NETCHUNK_SUCCESS;
+}
+
+netchunk_error_t netchunk_manifest_add_parity_chunk(netchunk_file_manifest_t* manifest,
+    const netchunk_chunk_t* chunk)
+{
+    if (!manifest || !chunk) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    if (manifest->parity_count >= manifest->parity_capacity) {
+        uint32_t new_capacity = manifest->parity_capacity < 16 ? 32 : manifest->parity_capacity * 2;
+        netchunk_chunk_t* grown = realloc(manifest->parity_chunks, sizeof(netchunk_chunk_t) * new_capacity);
+        if (!grown) {
             return NETCHUNK_ERROR_OUT_OF_MEMORY;
         }
-        memcpy(manifest->chunks[manifest->chunk_count].data, chunk->data, chunk->size);
-        manifest->chunks[manifest->chunk_count].data_owned = true;
+        manifest->parity_chunks = grown;
+        manifest->parity_capacity = new_capacity;
     }
 
-    manifest->chunk_count++;
+    netchunk_chunk_t* entry = &manifest->parity_chunks[manifest->parity_count];
+    *entry = *chunk;
+    entry->data = NULL;
+    entry->data_owned = false;
+
+    manifest->parity_count++;
     return NETCHUNK_SUCCESS;
 }
 
+bool netchunk_manifest_is_erasure_coded(const netchunk_file_manifest_t* manifest)
+{
+    return manifest && manifest->ec_data_shards > 0 && manifest->ec_parity_shards > 0;
+}
+
+uint32_t netchunk_manifest_stripe_count(const netchunk_file_manifest_t* manifest)
+{
+    if (!netchunk_manifest_is_erasure_coded(manifest)) {
+        return 0;
+    }
+
+    uint32_t data_shards = (uint32_t)manifest->ec_data_shards;
+    return manifest->chunk_count / data_shards + (manifest->chunk_count % data_shards != 0);
+}
+
+netchunk_chunk_t* netchunk_manifest_stripe_shard(const netchunk_file_manifest_t* manifest,
+    uint32_t stripe,
+    int shard)
+{
+    if (!netchunk_manifest_is_erasure_coded(manifest) || shard < 0
+        || shard >= manifest->ec_data_shards + manifest->ec_parity_shards) {
+        return NULL;
+    }
+
+    if (shard < manifest->ec_data_shards) {
+        uint64_t index = (uint64_t)stripe * (uint64_t)manifest->ec_data_shards + (uint64_t)shard;
+        return manifest->chunks && index < manifest->chunk_count ? &manifest->chunks[index] : NULL;
+    }
+
+    uint64_t index = (uint64_t)stripe * (uint64_t)manifest->ec_parity_shards + (uint64_t)(shard - manifest->ec_data_shards);
+    return manifest->parity_chunks && index < manifest->parity_count ? &manifest->parity_chunks[index] : NULL;
+}
+
 void netchunk_manifest_cleanup(netchunk_file_manifest_t* manifest)
 {
     netchunk_file_manifest_cleanup(manifest);
 }
 
-// Internal helper functions
+// Atomic File Helpers
 
-static netchunk_error_t write_file_atomically(const char* file_path, const char* content)
+netchunk_error_t netchunk_manifest_write_atomic(const char* file_path, const char* content, size_t size)
 {
     if (!file_path || !content) {
         return NETCHUNK_ERROR_INVALID_ARGUMENT;
@@ -807,24 +1059,27 @@ static netchunk_error_t write_file_atomically(const char* file_path, const char*
     snprintf(temp_path, sizeof(temp_path), "%s%s", file_path, NETCHUNK_MANIFEST_TEMP_SUFFIX);
 
     // Write to temporary file
-    FILE* temp_file = fopen(temp_path, "w");
+    FILE* temp_file = fopen(temp_path, "wb");
     if (!temp_file) {
         return NETCHUNK_ERROR_FILE_ACCESS;
     }
 
-    if (fprintf(temp_file, "%s", content) < 0) {
+    if (fwrite(content, 1, size, temp_file) != size) {
         fclose(temp_file);
         unlink(temp_path);
         return NETCHUNK_ERROR_FILE_ACCESS;
     }
 
-    if (fflush(temp_file) != 0) {
+    if (fflush(temp_file) != 0 || fsync(fileno(temp_file)) != 0) {
         fclose(temp_file);
         unlink(temp_path);
         return NETCHUNK_ERROR_FILE_ACCESS;
     }
 
-    fclose(temp_file);
+    if (fclose(temp_file) != 0) {
+        unlink(temp_path);
+        return NETCHUNK_ERROR_FILE_ACCESS;
+    }
 
     // Atomically move temporary file to final location
     if (rename(temp_path, file_path) != 0) {
@@ -835,13 +1090,13 @@ static netchunk_error_t write_file_atomically(const char* file_path, const char*
     return NETCHUNK_SUCCESS;
 }
 
-static netchunk_error_t read_file_content(const char* file_path, char** content)
+netchunk_error_t netchunk_manifest_read_file(const char* file_path, char** content, size_t* size)
 {
-    if (!file_path || !content) {
+    if (!file_path || !content || !size) {
         return NETCHUNK_ERROR_INVALID_ARGUMENT;
     }
 
-    FILE* file = fopen(file_path, "r");
+    FILE* file = fopen(file_path, "rb");
     if (!file) {
         return NETCHUNK_ERROR_FILE_NOT_FOUND;
     }
@@ -874,10 +1129,13 @@ static netchunk_error_t read_file_content(const char* file_path, char** content)
 
     buffer[file_size] = '\0';
     *content = buffer;
+    *size = (size_t)file_size;
 
     return NETCHUNK_SUCCESS;
 }
 
+// Internal helper functions
+
 static int compare_timestamps(const void* a, const void* b)
 {
     time_t time_a = *(const time_t*)a;
@@ -963,13 +1221,14 @@ netchunk_error_t netchunk_manifest_backup(netchunk_manifest_manager_t* manager,
 
     // Read source file
     char* content;
-    netchunk_error_t read_error = read_file_content(source_path, &content);
+    size_t content_size;
+    netchunk_error_t read_error = netchunk_manifest_read_file(source_path, &content, &content_size);
     if (read_error != NETCHUNK_SUCCESS) {
         return read_error;
     }
 
     // Write backup file
-    netchunk_error_t write_error = write_file_atomically(backup_path, content);
+    netchunk_error_t write_error = netchunk_manifest_write_atomic(backup_path, content, content_size);
     free(content);
 
     return write_error;
@@ -1071,3 +1330,25 @@ netchunk_error_t netchunk_manifest_find_under_replicated_chunks(const netchunk_f
 
     return NETCHUNK_SUCCESS;
 }
+
+/**
+ * @brief Check that a chunk's stored form can be decoded at the recorded size
+ */
+static bool chunk_encoding_valid(const netchunk_chunk_t* chunk)
+{
+    if (chunk->codec != NETCHUNK_COMPRESSION_NONE
+        && (chunk->codec != NETCHUNK_COMPRESSION_ZSTD || chunk->stored_size == 0)) {
+        return false;
+    }
+
+    // Encrypted data carries the cipher trailer after at least one byte
+    if (netchunk_key_id_is_set(chunk->key_id)) {
+        if (chunk->stored_size <= NETCHUNK_CIPHER_OVERHEAD) {
+            return false;
+        }
+        if (chunk->codec == NETCHUNK_COMPRESSION_NONE && chunk->stored_size != chunk->size + NETCHUNK_CIPHER_OVERHEAD) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,756 @@
+/**
+ * @file manifest_pack.c
+ * @brief Compact binary manifest format
+ *
+ * Lays a manifest out as a header followed by per-chunk arrays in one
+ * flat buffer that is written to disk as is and mmap()ed back, so large
+ * manifests open without parsing and are expanded one chunk at a time.
+ */
+
+#include "manifest_pack.h"
+#include "compress.h"
+#include "crypto.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define PACKED_BYTE_ORDER 0x01020304u // Written natively, rejected if swapped
+#define PACKED_ALIGNMENT 8
+#define PACKED_TEMP_SUFFIX ".tmp"
+
+// Sections following the header, in file order
+typedef enum {
+    PACKED_SECTION_SERVERS,
+    PACKED_SECTION_HASHES,
+    PACKED_SECTION_SIZES,
+    PACKED_SECTION_OFFSETS,
+    PACKED_SECTION_SEQUENCES,
+    PACKED_SECTION_CREATED,
+    PACKED_SECTION_IDS,
+    PACKED_SECTION_LOCATION_INDEX,
+    PACKED_SECTION_LOCATIONS,
+    PACKED_SECTION_STRINGS,
+    PACKED_SECTION_CODECS, // Version 3 on
+    PACKED_SECTION_STORED_SIZES, // Version 3 on
+    PACKED_SECTION_KEY_IDS, // Version 4 on
+    PACKED_SECTION_COUNT
+} packed_section_t;
+
+#define PACKED_SECTION_COUNT_V2 PACKED_SECTION_CODECS // Sections of versions 1 and 2
+#define PACKED_SECTION_COUNT_V3 PACKED_SECTION_KEY_IDS // Sections of version 3
+
+/**
+ * @brief On-disk header of a packed manifest (format version 4)
+ *
+ * Older versions end after the section offsets they have (see
+ * packed_section_count()); version 1 also has the erasure fields zero.
+ */
+typedef struct packed_header {
+    uint32_t magic;
+    uint32_t byte_order;
+    uint16_t version;
+    uint16_t header_size;
+    uint16_t ec_data_shards; // Zero for replicated files
+    uint16_t ec_parity_shards;
+    uint64_t packed_size; // Total bytes including the header
+    uint64_t total_size;
+    uint64_t chunk_size;
+    int64_t created_timestamp;
+    int64_t last_accessed;
+    int64_t last_modified;
+    int64_t last_verified;
+    uint8_t file_hash[NETCHUNK_HASH_LENGTH];
+    uint32_t chunking_mode;
+    int32_t replication_factor;
+    int32_t min_replicas_required;
+    uint32_t chunk_count;
+    uint32_t server_count;
+    uint32_t location_count;
+    uint32_t filename_string;
+    uint32_t manifest_id_string;
+    uint32_t version_string;
+    uint32_t creator_info_string;
+    uint32_t comment_string;
+    uint32_t parity_count; // Parity entries following the chunk entries
+    uint64_t strings_size;
+    uint64_t section_offsets[PACKED_SECTION_COUNT];
+} packed_header_t;
+
+// Internal helper functions
+static uint64_t packed_align(uint64_t value);
+static uint16_t packed_header_size(uint16_t version);
+static int packed_section_count(uint16_t version);
+static uint64_t packed_section_bytes(const packed_header_t* header, packed_section_t section);
+static netchunk_error_t packed_attach(netchunk_packed_manifest_t* packed, const uint8_t* base, size_t size);
+static int packed_intern_server(char (*server_ids)[NETCHUNK_MAX_SERVER_ID_LEN], uint32_t* server_count, uint32_t capacity, const char* server_id);
+static uint32_t packed_add_string(char* strings, uint64_t* used, const char* value);
+static netchunk_error_t packed_get_entry(const netchunk_packed_manifest_t* packed, uint32_t entry, netchunk_chunk_t* chunk);
+
+// Packing Functions
+
+netchunk_error_t netchunk_manifest_pack(const netchunk_file_manifest_t* manifest,
+    netchunk_packed_manifest_t* packed)
+{
+    if (!manifest || !packed || (manifest->chunk_count > 0 && !manifest->chunks)
+        || (manifest->parity_count > 0 && !manifest->parity_chunks)
+        || manifest->ec_data_shards < 0 || manifest->ec_data_shards > UINT16_MAX
+        || manifest->ec_parity_shards < 0 || manifest->ec_parity_shards > UINT16_MAX
+        || manifest->parity_count > UINT32_MAX - 1 - manifest->chunk_count) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    memset(packed, 0, sizeof(netchunk_packed_manifest_t));
+
+    // First pass: intern server IDs and size the string table
+    packed_header_t header;
+    memset(&header, 0, sizeof(header));
+    header.chunk_count = manifest->chunk_count;
+    header.parity_count = manifest->parity_count;
+    header.strings_size = strlen(manifest->original_filename) + strlen(manifest->manifest_id)
+        + strlen(manifest->version) + strlen(manifest->creator_info) + strlen(manifest->comment) + 5;
+
+    uint32_t server_capacity = NETCHUNK_MAX_SERVERS;
+    char (*server_ids)[NETCHUNK_MAX_SERVER_ID_LEN] = calloc(server_capacity, NETCHUNK_MAX_SERVER_ID_LEN);
+    if (!server_ids) {
+        return NETCHUNK_ERROR_OUT_OF_MEMORY;
+    }
+
+    bool compressed = false;
+    bool encrypted = false;
+    uint32_t entry_count = manifest->chunk_count + manifest->parity_count;
+    for (uint32_t i = 0; i < entry_count; i++) {
+        const netchunk_chunk_t* chunk = i < manifest->chunk_count
+            ? &manifest->chunks[i]
+            : &manifest->parity_chunks[i - manifest->chunk_count];
+
+        if (chunk->codec != NETCHUNK_COMPRESSION_NONE) {
+            compressed = true;
+        }
+        if (netchunk_key_id_is_set(chunk->key_id)) {
+            encrypted = true;
+        }
+
+        if (!netchunk_chunk_is_content_addressed(chunk)) {
+            header.strings_size += strlen(chunk->id) + 1;
+        }
+
+        for (int l = 0; l < chunk->location_count; l++) {
+            if (server_capacity <= header.server_count && server_capacity <= UINT16_MAX) {
+                uint32_t new_capacity = server_capacity * 2;
+                char (*grown)[NETCHUNK_MAX_SERVER_ID_LEN] = realloc(server_ids, (size_t)new_capacity * NETCHUNK_MAX_SERVER_ID_LEN);
+                if (!grown) {
+                    free(server_ids);
+                    return NETCHUNK_ERROR_OUT_OF_MEMORY;
+                }
+                server_ids = grown;
+                server_capacity = new_capacity;
+            }
+            if (packed_intern_server(server_ids, &header.server_count, server_capacity,
+                    chunk->locations[l].server_id) < 0) {
+                free(server_ids);
+                return NETCHUNK_ERROR_INVALID_ARGUMENT;
+            }
+        }
+        header.location_count += (uint32_t)chunk->location_count;
+    }
+
+    // String offsets are 32-bit
+    if (header.strings_size > UINT32_MAX) {
+        free(server_ids);
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    // Lay the sections out after the header
+    header.magic = NETCHUNK_PACKED_MANIFEST_MAGIC;
+    header.byte_order = PACKED_BYTE_ORDER;
+    // Use the oldest version that can hold the manifest, so older readers keep working
+    if (encrypted) {
+        header.version = NETCHUNK_PACKED_MANIFEST_VERSION;
+    } else if (compressed) {
+        header.version = 3;
+    } else {
+        header.version = manifest->parity_count > 0 || manifest->ec_data_shards > 0 ? 2 : 1;
+    }
+    header.header_size = packed_header_size(header.version);
+
+    uint64_t cursor = packed_align(header.header_size);
+    for (int s = 0; s < packed_section_count(header.version); s++) {
+        header.section_offsets[s] = cursor;
+        cursor = packed_align(cursor + packed_section_bytes(&header, (packed_section_t)s));
+    }
+    header.packed_size = cursor;
+
+    uint8_t* buffer = calloc(1, (size_t)header.packed_size);
+    if (!buffer) {
+        free(server_ids);
+        return NETCHUNK_ERROR_OUT_OF_MEMORY;
+    }
+
+    // File metadata
+    header.total_size = manifest->total_size;
+    header.chunk_size = manifest->chunk_size;
+    header.created_timestamp = manifest->created_timestamp;
+    header.last_accessed = manifest->last_accessed;
+    header.last_modified = manifest->last_modified;
+    header.last_verified = manifest->last_verified;
+    memcpy(header.file_hash, manifest->file_hash, NETCHUNK_HASH_LENGTH);
+    header.chunking_mode = (uint32_t)manifest->chunking_mode;
+    header.replication_factor = manifest->replication_factor;
+    header.min_replicas_required = manifest->min_replicas_required;
+    header.ec_data_shards = (uint16_t)manifest->ec_data_shards;
+    header.ec_parity_shards = (uint16_t)manifest->ec_parity_shards;
+
+    char* strings = (char*)(buffer + header.section_offsets[PACKED_SECTION_STRINGS]);
+    uint64_t strings_used = 0;
+    header.filename_string = packed_add_string(strings, &strings_used, manifest->original_filename);
+    header.manifest_id_string = packed_add_string(strings, &strings_used, manifest->manifest_id);
+    header.version_string = packed_add_string(strings, &strings_used, manifest->version);
+    header.creator_info_string = packed_add_string(strings, &strings_used, manifest->creator_info);
+    header.comment_string = packed_add_string(strings, &strings_used, manifest->comment);
+
+    memcpy(buffer + header.section_offsets[PACKED_SECTION_SERVERS], server_ids,
+        (size_t)header.server_count * NETCHUNK_MAX_SERVER_ID_LEN);
+
+    // Second pass: fill the per-chunk arrays
+    uint8_t (*hashes)[NETCHUNK_HASH_LENGTH] = (void*)(buffer + header.section_offsets[PACKED_SECTION_HASHES]);
+    uint64_t* sizes = (uint64_t*)(buffer + header.section_offsets[PACKED_SECTION_SIZES]);
+    uint64_t* offsets = (uint64_t*)(buffer + header.section_offsets[PACKED_SECTION_OFFSETS]);
+    uint32_t* sequences = (uint32_t*)(buffer + header.section_offsets[PACKED_SECTION_SEQUENCES]);
+    int64_t* created = (int64_t*)(buffer + header.section_offsets[PACKED_SECTION_CREATED]);
+    uint32_t* ids = (uint32_t*)(buffer + header.section_offsets[PACKED_SECTION_IDS]);
+    uint32_t* location_index = (uint32_t*)(buffer + header.section_offsets[PACKED_SECTION_LOCATION_INDEX]);
+    netchunk_packed_location_t* locations = (netchunk_packed_location_t*)(buffer + header.section_offsets[PACKED_SECTION_LOCATIONS]);
+    uint8_t* codecs = header.version >= 3 ? buffer + header.section_offsets[PACKED_SECTION_CODECS] : NULL;
+    uint64_t* stored_sizes = header.version >= 3 ? (uint64_t*)(buffer + header.section_offsets[PACKED_SECTION_STORED_SIZES]) : NULL;
+    uint8_t (*key_ids)[NETCHUNK_KEY_ID_LENGTH] = header.version >= 4 ? (void*)(buffer + header.section_offsets[PACKED_SECTION_KEY_IDS]) : NULL;
+
+    uint32_t location = 0;
+    for (uint32_t i = 0; i < entry_count; i++) {
+        const netchunk_chunk_t* chunk = i < manifest->chunk_count
+            ? &manifest->chunks[i]
+            : &manifest->parity_chunks[i - manifest->chunk_count];
+
+        memcpy(hashes[i], chunk->hash, NETCHUNK_HASH_LENGTH);
+        sizes[i] = chunk->size;
+        if (codecs) {
+            codecs[i] = (uint8_t)chunk->codec;
+            stored_sizes[i] = netchunk_chunk_stored_size(chunk);
+        }
+        if (key_ids) {
+            memcpy(key_ids[i], chunk->key_id, NETCHUNK_KEY_ID_LENGTH);
+        }
+        offsets[i] = chunk->offset;
+        sequences[i] = chunk->sequence_number;
+        created[i] = chunk->created_timestamp;
+        ids[i] = netchunk_chunk_is_content_addressed(chunk)
+            ? NETCHUNK_PACKED_NO_STRING
+            : packed_add_string(strings, &strings_used, chunk->id);
+
+        location_index[i] = location;
+        for (int l = 0; l < chunk->location_count; l++) {
+            netchunk_packed_location_t* entry = &locations[location++];
+            entry->server = (uint16_t)packed_intern_server(server_ids, &header.server_count, server_capacity,
+                chunk->locations[l].server_id);
+            entry->upload_time = chunk->locations[l].upload_time;
+            entry->last_verified = chunk->locations[l].last_verified;
+            entry->verified = chunk->locations[l].verified ? 1 : 0;
+        }
+    }
+    location_index[entry_count] = location;
+    free(server_ids);
+
+    memcpy(buffer, &header, header.header_size);
+
+    netchunk_error_t error = packed_attach(packed, buffer, (size_t)header.packed_size);
+    if (error != NETCHUNK_SUCCESS) {
+        free(buffer);
+        return error;
+    }
+    packed->buffer = buffer;
+    return NETCHUNK_SUCCESS;
+}
+
+netchunk_error_t netchunk_packed_manifest_unpack(const netchunk_packed_manifest_t* packed,
+    netchunk_file_manifest_t* manifest)
+{
+    if (!packed || !packed->base || !manifest) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    const packed_header_t* header = (const packed_header_t*)packed->base;
+
+    memset(manifest, 0, sizeof(netchunk_file_manifest_t));
+    strncpy(manifest->original_filename, packed->original_filename, sizeof(manifest->original_filename) - 1);
+    strncpy(manifest->manifest_id, packed->strings + header->manifest_id_string, sizeof(manifest->manifest_id) - 1);
+    strncpy(manifest->version, packed->strings + header->version_string, sizeof(manifest->version) - 1);
+    strncpy(manifest->creator_info, packed->strings + header->creator_info_string, sizeof(manifest->creator_info) - 1);
+    strncpy(manifest->comment, packed->strings + header->comment_string, sizeof(manifest->comment) - 1);
+
+    manifest->total_size = (size_t)header->total_size;
+    manifest->original_size = (size_t)header->total_size;
+    memcpy(manifest->file_hash, header->file_hash, NETCHUNK_HASH_LENGTH);
+    manifest->chunk_size = (size_t)header->chunk_size;
+    manifest->chunking_mode = header->chunking_mode == NETCHUNK_CHUNKING_CDC ? NETCHUNK_CHUNKING_CDC : NETCHUNK_CHUNKING_FIXED;
+    manifest->created_timestamp = (time_t)header->created_timestamp;
+    manifest->last_accessed = (time_t)header->last_accessed;
+    manifest->last_modified = (time_t)header->last_modified;
+    manifest->last_verified = (time_t)header->last_verified;
+    manifest->replication_factor = header->replication_factor;
+    manifest->min_replicas_required = header->min_replicas_required;
+    manifest->ec_data_shards = packed->ec_data_shards;
+    manifest->ec_parity_shards = packed->ec_parity_shards;
+
+    if (packed->chunk_count > 0) {
+        manifest->chunks = malloc(sizeof(netchunk_chunk_t) * packed->chunk_count);
+        if (!manifest->chunks) {
+            return NETCHUNK_ERROR_OUT_OF_MEMORY;
+        }
+        manifest->chunks_owned = true;
+        manifest->chunk_capacity = packed->chunk_count;
+    }
+
+    for (uint32_t i = 0; i < packed->chunk_count; i++) {
+        netchunk_error_t error = netchunk_packed_manifest_get_chunk(packed, i, &manifest->chunks[i]);
+        if (error != NETCHUNK_SUCCESS) {
+            netchunk_file_manifest_cleanup(manifest);
+            return error;
+        }
+        manifest->chunk_count++;
+    }
+
+    if (packed->parity_count > 0) {
+        manifest->parity_chunks = malloc(sizeof(netchunk_chunk_t) * packed->parity_count);
+        if (!manifest->parity_chunks) {
+            netchunk_file_manifest_cleanup(manifest);
+            return NETCHUNK_ERROR_OUT_OF_MEMORY;
+        }
+        manifest->parity_capacity = packed->parity_count;
+    }
+
+    for (uint32_t i = 0; i < packed->parity_count; i++) {
+        netchunk_error_t error = netchunk_packed_manifest_get_parity_chunk(packed, i, &manifest->parity_chunks[i]);
+        if (error != NETCHUNK_SUCCESS) {
+            netchunk_file_manifest_cleanup(manifest);
+            return error;
+        }
+        manifest->parity_count++;
+    }
+
+    return NETCHUNK_SUCCESS;
+}
+
+netchunk_error_t netchunk_packed_manifest_get_chunk(const netchunk_packed_manifest_t* packed,
+    uint32_t index,
+    netchunk_chunk_t* chunk)
+{
+    if (!packed || !packed->base || !chunk || index >= packed->chunk_count) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    return packed_get_entry(packed, index, chunk);
+}
+
+netchunk_error_t netchunk_packed_manifest_get_parity_chunk(const netchunk_packed_manifest_t* packed,
+    uint32_t index,
+    netchunk_chunk_t* chunk)
+{
+    if (!packed || !packed->base || !chunk || index >= packed->parity_count) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    return packed_get_entry(packed, packed->chunk_count + index, chunk);
+}
+
+// Storage Functions
+
+bool netchunk_packed_manifest_detect(const void* data, size_t size)
+{
+    uint32_t magic;
+    if (!data || size < sizeof(magic)) {
+        return false;
+    }
+
+    memcpy(&magic, data, sizeof(magic));
+    return magic == NETCHUNK_PACKED_MANIFEST_MAGIC;
+}
+
+netchunk_error_t netchunk_packed_manifest_open(netchunk_packed_manifest_t* packed, const char* path)
+{
+    if (!packed || !path) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    memset(packed, 0, sizeof(netchunk_packed_manifest_t));
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return errno == ENOENT ? NETCHUNK_ERROR_FILE_NOT_FOUND : NETCHUNK_ERROR_FILE_ACCESS;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return NETCHUNK_ERROR_FILE_ACCESS;
+    }
+    if (st.st_size < (off_t)packed_header_size(1)) {
+        close(fd);
+        return NETCHUNK_ERROR_MANIFEST_CORRUPT;
+    }
+
+    void* mapping = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        return NETCHUNK_ERROR_FILE_ACCESS;
+    }
+
+    netchunk_error_t error = packed_attach(packed, mapping, (size_t)st.st_size);
+    if (error != NETCHUNK_SUCCESS) {
+        munmap(mapping, (size_t)st.st_size);
+        return error;
+    }
+    packed->mapping = mapping;
+    return NETCHUNK_SUCCESS;
+}
+
+netchunk_error_t netchunk_packed_manifest_from_buffer(netchunk_packed_manifest_t* packed,
+    const void* data,
+    size_t size)
+{
+    if (!packed || !data) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    memset(packed, 0, sizeof(netchunk_packed_manifest_t));
+    if (size < packed_header_size(1)) {
+        return NETCHUNK_ERROR_MANIFEST_CORRUPT;
+    }
+
+    // Copy so the arrays are aligned and outlive the caller's buffer
+    uint8_t* buffer = malloc(size);
+    if (!buffer) {
+        return NETCHUNK_ERROR_OUT_OF_MEMORY;
+    }
+    memcpy(buffer, data, size);
+
+    netchunk_error_t error = packed_attach(packed, buffer, size);
+    if (error != NETCHUNK_SUCCESS) {
+        free(buffer);
+        return error;
+    }
+    packed->buffer = buffer;
+    return NETCHUNK_SUCCESS;
+}
+
+netchunk_error_t netchunk_packed_manifest_save(const netchunk_packed_manifest_t* packed, const char* path)
+{
+    if (!packed || !packed->base || !path) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    // Write to a temporary file and rename so readers never map a torn file
+    char temp_path[NETCHUNK_MAX_PATH_LEN + sizeof(PACKED_TEMP_SUFFIX)];
+    int result = snprintf(temp_path, sizeof(temp_path), "%s%s", path, PACKED_TEMP_SUFFIX);
+    if (result < 0 || (size_t)result >= sizeof(temp_path)) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    int fd = open(temp_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return NETCHUNK_ERROR_FILE_ACCESS;
+    }
+
+    size_t written = 0;
+    while (written < packed->size) {
+        ssize_t n = write(fd, packed->base + written, packed->size - written);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        written += (size_t)n;
+    }
+
+    bool ok = written == packed->size && fsync(fd) == 0;
+    if (close(fd) != 0) {
+        ok = false;
+    }
+    if (!ok || rename(temp_path, path) != 0) {
+        unlink(temp_path);
+        return NETCHUNK_ERROR_FILE_ACCESS;
+    }
+
+    return NETCHUNK_SUCCESS;
+}
+
+void netchunk_packed_manifest_close(netchunk_packed_manifest_t* packed)
+{
+    if (!packed) {
+        return;
+    }
+
+    if (packed->mapping) {
+        munmap(packed->mapping, packed->size);
+    }
+    free(packed->buffer);
+    memset(packed, 0, sizeof(netchunk_packed_manifest_t));
+}
+
+// Internal helper functions
+
+/**
+ * @brief Round up to the section alignment
+ */
+static uint64_t packed_align(uint64_t value)
+{
+    return (value + PACKED_ALIGNMENT - 1) & ~(uint64_t)(PACKED_ALIGNMENT - 1);
+}
+
+/**
+ * @brief Header bytes of a format version (sections offsets end the header)
+ */
+static uint16_t packed_header_size(uint16_t version)
+{
+    return (uint16_t)(offsetof(packed_header_t, section_offsets)
+        + (size_t)packed_section_count(version) * sizeof(uint64_t));
+}
+
+/**
+ * @brief Number of sections a format version has
+ */
+static int packed_section_count(uint16_t version)
+{
+    if (version >= 4) {
+        return PACKED_SECTION_COUNT;
+    }
+    return version == 3 ? PACKED_SECTION_COUNT_V3 : PACKED_SECTION_COUNT_V2;
+}
+
+/**
+ * @brief Size of a section given the header's counts
+ *
+ * Counts are 32-bit, so none of these products can overflow.
+ */
+static uint64_t packed_section_bytes(const packed_header_t* header, packed_section_t section)
+{
+    uint64_t chunks = (uint64_t)header->chunk_count + header->parity_count;
+
+    switch (section) {
+    case PACKED_SECTION_SERVERS:
+        return (uint64_t)header->server_count * NETCHUNK_MAX_SERVER_ID_LEN;
+    case PACKED_SECTION_HASHES:
+        return chunks * NETCHUNK_HASH_LENGTH;
+    case PACKED_SECTION_SIZES:
+    case PACKED_SECTION_OFFSETS:
+    case PACKED_SECTION_CREATED:
+    case PACKED_SECTION_STORED_SIZES:
+        return chunks * sizeof(uint64_t);
+    case PACKED_SECTION_CODECS:
+        return chunks;
+    case PACKED_SECTION_KEY_IDS:
+        return chunks * NETCHUNK_KEY_ID_LENGTH;
+    case PACKED_SECTION_SEQUENCES:
+    case PACKED_SECTION_IDS:
+        return chunks * sizeof(uint32_t);
+    case PACKED_SECTION_LOCATION_INDEX:
+        return (chunks + 1) * sizeof(uint32_t);
+    case PACKED_SECTION_LOCATIONS:
+        return (uint64_t)header->location_count * sizeof(netchunk_packed_location_t);
+    case PACKED_SECTION_STRINGS:
+        return header->strings_size;
+    default:
+        return 0;
+    }
+}
+
+/**
+ * @brief Validate the header and section bounds, then point the arrays into base
+ *
+ * Only checks that take constant time per section run here; per-chunk
+ * entries are checked when the chunk is expanded.
+ */
+static netchunk_error_t packed_attach(netchunk_packed_manifest_t* packed, const uint8_t* base, size_t size)
+{
+    if (size < packed_header_size(1)) {
+        return NETCHUNK_ERROR_MANIFEST_CORRUPT;
+    }
+
+    // Older headers are shorter; only their own section offsets are read
+    const packed_header_t* header = (const packed_header_t*)base;
+    if (header->magic != NETCHUNK_PACKED_MANIFEST_MAGIC || header->byte_order != PACKED_BYTE_ORDER
+        || header->version < 1 || header->version > NETCHUNK_PACKED_MANIFEST_VERSION
+        || header->header_size != packed_header_size(header->version) || size < header->header_size
+        || header->packed_size != size) {
+        return NETCHUNK_ERROR_MANIFEST_CORRUPT;
+    }
+
+    if (header->version == 1 && (header->parity_count != 0 || header->ec_data_shards != 0 || header->ec_parity_shards != 0)) {
+        return NETCHUNK_ERROR_MANIFEST_CORRUPT;
+    }
+
+    // Keep chunk_count + parity_count + 1 location index entries addressable
+    if (header->parity_count > UINT32_MAX - 1 - header->chunk_count) {
+        return NETCHUNK_ERROR_MANIFEST_CORRUPT;
+    }
+
+    int section_count = packed_section_count(header->version);
+    for (int s = 0; s < section_count; s++) {
+        uint64_t offset = header->section_offsets[s];
+        uint64_t bytes = packed_section_bytes(header, (packed_section_t)s);
+        if (offset % PACKED_ALIGNMENT != 0 || offset < header->header_size || offset > size || bytes > size - offset) {
+            return NETCHUNK_ERROR_MANIFEST_CORRUPT;
+        }
+    }
+
+    const char* strings = (const char*)(base + header->section_offsets[PACKED_SECTION_STRINGS]);
+    if (header->strings_size == 0 || strings[header->strings_size - 1] != '\0'
+        || header->filename_string >= header->strings_size || header->manifest_id_string >= header->strings_size
+        || header->version_string >= header->strings_size || header->creator_info_string >= header->strings_size
+        || header->comment_string >= header->strings_size) {
+        return NETCHUNK_ERROR_MANIFEST_CORRUPT;
+    }
+
+    const char (*server_ids)[NETCHUNK_MAX_SERVER_ID_LEN] = (const char (*)[NETCHUNK_MAX_SERVER_ID_LEN])(base + header->section_offsets[PACKED_SECTION_SERVERS]);
+    for (uint32_t s = 0; s < header->server_count; s++) {
+        if (memchr(server_ids[s], '\0', NETCHUNK_MAX_SERVER_ID_LEN) == NULL) {
+            return NETCHUNK_ERROR_MANIFEST_CORRUPT;
+        }
+    }
+
+    const uint32_t* location_index = (const uint32_t*)(base + header->section_offsets[PACKED_SECTION_LOCATION_INDEX]);
+    if (location_index[0] != 0 || location_index[header->chunk_count + header->parity_count] != header->location_count) {
+        return NETCHUNK_ERROR_MANIFEST_CORRUPT;
+    }
+
+    packed->base = base;
+    packed->size = size;
+    packed->original_filename = strings + header->filename_string;
+    packed->total_size = header->total_size;
+    packed->file_hash = header->file_hash;
+    packed->chunk_count = header->chunk_count;
+    packed->ec_data_shards = header->ec_data_shards;
+    packed->ec_parity_shards = header->ec_parity_shards;
+    packed->parity_count = header->parity_count;
+    packed->server_count = header->server_count;
+    packed->server_ids = server_ids;
+    packed->hashes = (const uint8_t (*)[NETCHUNK_HASH_LENGTH])(base + header->section_offsets[PACKED_SECTION_HASHES]);
+    packed->sizes = (const uint64_t*)(base + header->section_offsets[PACKED_SECTION_SIZES]);
+    packed->offsets = (const uint64_t*)(base + header->section_offsets[PACKED_SECTION_OFFSETS]);
+    packed->sequence_numbers = (const uint32_t*)(base + header->section_offsets[PACKED_SECTION_SEQUENCES]);
+    packed->created_timestamps = (const int64_t*)(base + header->section_offsets[PACKED_SECTION_CREATED]);
+    packed->id_strings = (const uint32_t*)(base + header->section_offsets[PACKED_SECTION_IDS]);
+    packed->location_index = location_index;
+    packed->location_count = header->location_count;
+    packed->locations = (const netchunk_packed_location_t*)(base + header->section_offsets[PACKED_SECTION_LOCATIONS]);
+    packed->strings = strings;
+    packed->strings_size = header->strings_size;
+    if (section_count > PACKED_SECTION_CODECS) {
+        packed->codecs = base + header->section_offsets[PACKED_SECTION_CODECS];
+        packed->stored_sizes = (const uint64_t*)(base + header->section_offsets[PACKED_SECTION_STORED_SIZES]);
+    }
+    if (section_count > PACKED_SECTION_KEY_IDS) {
+        packed->key_ids = (const uint8_t (*)[NETCHUNK_KEY_ID_LENGTH])(base + header->section_offsets[PACKED_SECTION_KEY_IDS]);
+    }
+
+    return NETCHUNK_SUCCESS;
+}
+
+/**
+ * @brief Expand one entry of the per-chunk arrays (data chunks, then parity)
+ */
+static netchunk_error_t packed_get_entry(const netchunk_packed_manifest_t* packed, uint32_t index, netchunk_chunk_t* chunk)
+{
+    memset(chunk, 0, sizeof(netchunk_chunk_t));
+
+    // Entries are only checked when their chunk is expanded
+    uint32_t first = packed->location_index[index];
+    uint32_t last = packed->location_index[index + 1];
+    if (first > last || last > packed->location_count || last - first > NETCHUNK_MAX_CHUNK_LOCATIONS) {
+        return NETCHUNK_ERROR_MANIFEST_CORRUPT;
+    }
+
+    uint32_t id_string = packed->id_strings[index];
+    if (id_string == NETCHUNK_PACKED_NO_STRING) {
+        netchunk_hash_to_hex_string(packed->hashes[index], NETCHUNK_HASH_LENGTH, chunk->id);
+    } else if (id_string < packed->strings_size) {
+        strncpy(chunk->id, packed->strings + id_string, sizeof(chunk->id) - 1);
+    } else {
+        return NETCHUNK_ERROR_MANIFEST_CORRUPT;
+    }
+
+    memcpy(chunk->hash, packed->hashes[index], NETCHUNK_HASH_LENGTH);
+    chunk->size = (size_t)packed->sizes[index];
+    chunk->offset = (size_t)packed->offsets[index];
+    chunk->sequence_number = packed->sequence_numbers[index];
+    chunk->created_timestamp = (time_t)packed->created_timestamps[index];
+    if (packed->codecs) {
+        if (packed->codecs[index] > NETCHUNK_COMPRESSION_ZSTD) {
+            return NETCHUNK_ERROR_MANIFEST_CORRUPT;
+        }
+        chunk->codec = (netchunk_compression_t)packed->codecs[index];
+    }
+    if (packed->key_ids) {
+        memcpy(chunk->key_id, packed->key_ids[index], NETCHUNK_KEY_ID_LENGTH);
+    }
+    if (netchunk_chunk_is_encoded(chunk)) {
+        if (packed->stored_sizes[index] == 0) {
+            return NETCHUNK_ERROR_MANIFEST_CORRUPT;
+        }
+        chunk->stored_size = (size_t)packed->stored_sizes[index];
+    }
+
+    for (uint32_t l = first; l < last; l++) {
+        const netchunk_packed_location_t* entry = &packed->locations[l];
+        if (entry->server >= packed->server_count) {
+            return NETCHUNK_ERROR_MANIFEST_CORRUPT;
+        }
+
+        netchunk_chunk_location_t* location = &chunk->locations[chunk->location_count++];
+        strcpy(location->server_id, packed->server_ids[entry->server]);
+        location->upload_time = (time_t)entry->upload_time;
+        location->verified = entry->verified != 0;
+        location->last_verified = (time_t)entry->last_verified;
+    }
+
+    return NETCHUNK_SUCCESS;
+}
+
+/**
+ * @brief Find a server ID in the intern table, adding it if missing
+ * @return Index of the server ID, or -1 if the table is full
+ */
+static int packed_intern_server(char (*server_ids)[NETCHUNK_MAX_SERVER_ID_LEN], uint32_t* server_count, uint32_t capacity, const char* server_id)
+{
+    for (uint32_t s = 0; s < *server_count; s++) {
+        if (strncmp(server_ids[s], server_id, NETCHUNK_MAX_SERVER_ID_LEN) == 0) {
+            return (int)s;
+        }
+    }
+
+    if (*server_count >= capacity || *server_count > UINT16_MAX) {
+        return -1;
+    }
+
+    strncpy(server_ids[*server_count], server_id, NETCHUNK_MAX_SERVER_ID_LEN - 1);
+    return (int)(*server_count)++;
+}
+
+/**
+ * @brief Append a string to the string table
+ * @return Offset of the string in the table
+ */
+static uint32_t packed_add_string(char* strings, uint64_t* used, const char* value)
+{
+    uint32_t offset = (uint32_t)*used;
+    size_t length = strlen(value) + 1;
+
+    memcpy(strings + offset, value, length);
+    *used += length;
+    return offset;
+}
@@ -0,0 +1,506 @@
+/**
+ * @file metrics.c
+ * @brief Phase latency histograms and counters with Prometheus and JSON dumps
+ *
+ * Recording touches no locks: each observation is a few relaxed atomic
+ * adds on the collector, so the engine thread, verifiers and callers can
+ * record concurrently without contending on anything but cache lines.
+ */
+
+#include "metrics.h"
+#include <errno.h>
+#include <stddef.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define METRICS_TEMP_SUFFIX ".tmp"
+
+// Internal helper functions
+static int metrics_bucket(uint64_t duration_ns);
+static void metrics_observe(netchunk_metrics_histogram_t* histogram, uint64_t duration_ns);
+static void metrics_copy_histogram(netchunk_metrics_histogram_t* copy, const netchunk_metrics_histogram_t* histogram);
+static void metrics_write_label(FILE* output, const char* value, bool json);
+static void metrics_write_prometheus_histogram(FILE* output,
+    const char* name,
+    const char* label,
+    const char* value,
+    const netchunk_metrics_histogram_t* histogram);
+static void metrics_write_json_histogram(FILE* output, const netchunk_metrics_histogram_t* histogram);
+static void metrics_write_prometheus(const netchunk_metrics_snapshot_t* snapshot, FILE* output);
+static void metrics_write_json(const netchunk_metrics_snapshot_t* snapshot, FILE* output);
+static netchunk_error_t metrics_ensure_directory(const char* path);
+static netchunk_error_t metrics_dump_locked(netchunk_metrics_t* metrics);
+
+static const char* const phase_names[NETCHUNK_METRICS_PHASE_COUNT] = {
+    "read", "hash", "compress", "encrypt", "transfer", "decode", "verify", "write", "manifest"
+};
+
+static const char* const counter_names[NETCHUNK_METRICS_COUNTER_COUNT] = {
+    "bytes_read", "bytes_written", "bytes_sent", "bytes_received", "retries", "cache_hits", "cache_misses"
+};
+
+netchunk_error_t netchunk_metrics_init(netchunk_metrics_t* metrics, const netchunk_config_t* config)
+{
+    if (!metrics || !config) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    memset(metrics, 0, sizeof(netchunk_metrics_t));
+    metrics->values.started_at = time(NULL);
+    metrics->values.server_count = config->server_count;
+    for (int i = 0; i < config->server_count && i < NETCHUNK_MAX_SERVERS; i++) {
+        strncpy(metrics->values.servers[i].id, config->servers[i].id, sizeof(metrics->values.servers[i].id) - 1);
+    }
+    metrics->format = config->monitoring_format;
+
+    netchunk_error_t error = netchunk_config_expand_path(config->monitoring_data_path,
+        metrics->output_dir, sizeof(metrics->output_dir));
+    if (error != NETCHUNK_SUCCESS) {
+        return error;
+    }
+
+    if (pthread_mutex_init(&metrics->dump_mutex, NULL) != 0) {
+        return NETCHUNK_ERROR_OUT_OF_MEMORY;
+    }
+
+    return NETCHUNK_SUCCESS;
+}
+
+uint64_t netchunk_metrics_now_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+}
+
+uint64_t netchunk_metrics_start(const netchunk_metrics_t* metrics)
+{
+    return metrics ? netchunk_metrics_now_ns() : 0;
+}
+
+void netchunk_metrics_record(netchunk_metrics_t* metrics, netchunk_metrics_phase_t phase, uint64_t start_ns)
+{
+    if (!metrics) {
+        return;
+    }
+
+    netchunk_metrics_record_duration(metrics, phase, netchunk_metrics_now_ns() - start_ns);
+}
+
+void netchunk_metrics_record_duration(netchunk_metrics_t* metrics, netchunk_metrics_phase_t phase, uint64_t duration_ns)
+{
+    if (!metrics || phase < 0 || phase >= NETCHUNK_METRICS_PHASE_COUNT) {
+        return;
+    }
+
+    metrics_observe(&metrics->values.phases[phase], duration_ns);
+}
+
+void netchunk_metrics_record_transfer(netchunk_metrics_t* metrics,
+    int server_index,
+    bool success,
+    uint64_t duration_ns,
+    uint64_t bytes_sent,
+    uint64_t bytes_received)
+{
+    if (!metrics) {
+        return;
+    }
+
+    metrics_observe(&metrics->values.phases[NETCHUNK_METRICS_TRANSFER], duration_ns);
+    netchunk_metrics_add(metrics, NETCHUNK_METRICS_BYTES_SENT, bytes_sent);
+    netchunk_metrics_add(metrics, NETCHUNK_METRICS_BYTES_RECEIVED, bytes_received);
+
+    if (server_index < 0 || server_index >= metrics->values.server_count) {
+        return;
+    }
+
+    netchunk_metrics_server_t* server = &metrics->values.servers[server_index];
+    metrics_observe(&server->transfer, duration_ns);
+    if (bytes_sent > 0) {
+        __atomic_fetch_add(&server->bytes_sent, bytes_sent, __ATOMIC_RELAXED);
+    }
+    if (bytes_received > 0) {
+        __atomic_fetch_add(&server->bytes_received, bytes_received, __ATOMIC_RELAXED);
+    }
+    if (!success) {
+        __atomic_fetch_add(&server->failures, 1, __ATOMIC_RELAXED);
+    }
+}
+
+void netchunk_metrics_add(netchunk_metrics_t* metrics, netchunk_metrics_counter_t counter, uint64_t value)
+{
+    if (!metrics || value == 0 || counter < 0 || counter >= NETCHUNK_METRICS_COUNTER_COUNT) {
+        return;
+    }
+
+    __atomic_fetch_add(&metrics->values.counters[counter], value, __ATOMIC_RELAXED);
+}
+
+void netchunk_metrics_read(const netchunk_metrics_t* metrics, netchunk_metrics_snapshot_t* snapshot)
+{
+    if (!metrics || !snapshot) {
+        return;
+    }
+
+    memset(snapshot, 0, sizeof(netchunk_metrics_snapshot_t));
+    snapshot->started_at = metrics->values.started_at;
+    snapshot->taken_at = time(NULL);
+
+    for (int p = 0; p < NETCHUNK_METRICS_PHASE_COUNT; p++) {
+        metrics_copy_histogram(&snapshot->phases[p], &metrics->values.phases[p]);
+    }
+    for (int c = 0; c < NETCHUNK_METRICS_COUNTER_COUNT; c++) {
+        snapshot->counters[c] = __atomic_load_n(&metrics->values.counters[c], __ATOMIC_RELAXED);
+    }
+
+    snapshot->server_count = metrics->values.server_count;
+    for (int i = 0; i < snapshot->server_count; i++) {
+        const netchunk_metrics_server_t* server = &metrics->values.servers[i];
+        netchunk_metrics_server_t* copy = &snapshot->servers[i];
+        memcpy(copy->id, server->id, sizeof(copy->id));
+        metrics_copy_histogram(&copy->transfer, &server->transfer);
+        copy->bytes_sent = __atomic_load_n(&server->bytes_sent, __ATOMIC_RELAXED);
+        copy->bytes_received = __atomic_load_n(&server->bytes_received, __ATOMIC_RELAXED);
+        copy->failures = __atomic_load_n(&server->failures, __ATOMIC_RELAXED);
+    }
+}
+
+uint64_t netchunk_metrics_histogram_count(const netchunk_metrics_histogram_t* histogram)
+{
+    if (!histogram) {
+        return 0;
+    }
+
+    uint64_t count = 0;
+    for (int b = 0; b < NETCHUNK_METRICS_BUCKETS; b++) {
+        count += histogram->buckets[b];
+    }
+    return count;
+}
+
+double netchunk_metrics_bucket_bound(int bucket)
+{
+    if (bucket < 0 || bucket >= NETCHUNK_METRICS_BUCKETS - 1) {
+        return -1.0;
+    }
+
+    return (double)(1ULL << bucket) / 1e6;
+}
+
+netchunk_error_t netchunk_metrics_write(const netchunk_metrics_snapshot_t* snapshot,
+    netchunk_monitoring_format_t format,
+    FILE* output)
+{
+    if (!snapshot || !output) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    if (format == NETCHUNK_MONITORING_JSON) {
+        metrics_write_json(snapshot, output);
+    } else {
+        metrics_write_prometheus(snapshot, output);
+    }
+
+    return ferror(output) ? NETCHUNK_ERROR_FILE_ACCESS : NETCHUNK_SUCCESS;
+}
+
+netchunk_error_t netchunk_metrics_dump(netchunk_metrics_t* metrics)
+{
+    if (!metrics) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    pthread_mutex_lock(&metrics->dump_mutex);
+    netchunk_error_t error = metrics_dump_locked(metrics);
+    pthread_mutex_unlock(&metrics->dump_mutex);
+    return error;
+}
+
+netchunk_error_t netchunk_metrics_dump_if_due(netchunk_metrics_t* metrics)
+{
+    if (!metrics) {
+        return NETCHUNK_SUCCESS;
+    }
+
+    netchunk_error_t error = NETCHUNK_SUCCESS;
+    pthread_mutex_lock(&metrics->dump_mutex);
+    if (time(NULL) - metrics->dumped_at >= NETCHUNK_METRICS_DUMP_INTERVAL) {
+        error = metrics_dump_locked(metrics);
+    }
+    pthread_mutex_unlock(&metrics->dump_mutex);
+    return error;
+}
+
+const char* netchunk_metrics_phase_name(netchunk_metrics_phase_t phase)
+{
+    if (phase < 0 || phase >= NETCHUNK_METRICS_PHASE_COUNT) {
+        return "unknown";
+    }
+    return phase_names[phase];
+}
+
+const char* netchunk_metrics_counter_name(netchunk_metrics_counter_t counter)
+{
+    if (counter < 0 || counter >= NETCHUNK_METRICS_COUNTER_COUNT) {
+        return "unknown";
+    }
+    return counter_names[counter];
+}
+
+void netchunk_metrics_cleanup(netchunk_metrics_t* metrics)
+{
+    if (!metrics) {
+        return;
+    }
+
+    pthread_mutex_destroy(&metrics->dump_mutex);
+}
+
+/**
+ * @brief Bucket of a duration: the smallest power of two microseconds holding it
+ */
+static int metrics_bucket(uint64_t duration_ns)
+{
+    uint64_t micros = (duration_ns + 999) / 1000;
+    if (micros <= 1) {
+        return 0;
+    }
+
+    int bucket = 64 - __builtin_clzll(micros - 1);
+    return bucket < NETCHUNK_METRICS_BUCKETS - 1 ? bucket : NETCHUNK_METRICS_BUCKETS - 1;
+}
+
+static void metrics_observe(netchunk_metrics_histogram_t* histogram, uint64_t duration_ns)
+{
+    __atomic_fetch_add(&histogram->buckets[metrics_bucket(duration_ns)], 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&histogram->sum_ns, duration_ns, __ATOMIC_RELAXED);
+
+    uint64_t max_ns = __atomic_load_n(&histogram->max_ns, __ATOMIC_RELAXED);
+    while (duration_ns > max_ns
+        && !__atomic_compare_exchange_n(&histogram->max_ns, &max_ns, duration_ns, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+static void metrics_copy_histogram(netchunk_metrics_histogram_t* copy, const netchunk_metrics_histogram_t* histogram)
+{
+    for (int b = 0; b < NETCHUNK_METRICS_BUCKETS; b++) {
+        copy->buckets[b] = __atomic_load_n(&histogram->buckets[b], __ATOMIC_RELAXED);
+    }
+    copy->sum_ns = __atomic_load_n(&histogram->sum_ns, __ATOMIC_RELAXED);
+    copy->max_ns = __atomic_load_n(&histogram->max_ns, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Write a quoted label or string value
+ *
+ * Server IDs come from the configuration, so quotes, backslashes and
+ * control characters are escaped for either format.
+ */
+static void metrics_write_label(FILE* output, const char* value, bool json)
+{
+    fputc('"', output);
+    for (const unsigned char* c = (const unsigned char*)value; *c; c++) {
+        if (*c == '"' || *c == '\\') {
+            fputc('\\', output);
+            fputc(*c, output);
+        } else if (*c == '\n') {
+            fputs("\\n", output);
+        } else if (*c < 0x20 && json) {
+            fprintf(output, "\\u%04x", *c);
+        } else {
+            fputc(*c, output);
+        }
+    }
+    fputc('"', output);
+}
+
+static void metrics_write_prometheus_histogram(FILE* output,
+    const char* name,
+    const char* label,
+    const char* value,
+    const netchunk_metrics_histogram_t* histogram)
+{
+    uint64_t cumulative = 0;
+    for (int b = 0; b < NETCHUNK_METRICS_BUCKETS; b++) {
+        cumulative += histogram->buckets[b];
+        fprintf(output, "%s_bucket{%s=", name, label);
+        metrics_write_label(output, value, false);
+        if (b < NETCHUNK_METRICS_BUCKETS - 1) {
+            fprintf(output, ",le=\"%.9g\"} %llu\n", netchunk_metrics_bucket_bound(b), (unsigned long long)cumulative);
+        } else {
+            fprintf(output, ",le=\"+Inf\"} %llu\n", (unsigned long long)cumulative);
+        }
+    }
+
+    fprintf(output, "%s_sum{%s=", name, label);
+    metrics_write_label(output, value, false);
+    fprintf(output, "} %.9f\n", (double)histogram->sum_ns / 1e9);
+    fprintf(output, "%s_count{%s=", name, label);
+    metrics_write_label(output, value, false);
+    fprintf(output, "} %llu\n", (unsigned long long)cumulative);
+}
+
+static void metrics_write_json_histogram(FILE* output, const netchunk_metrics_histogram_t* histogram)
+{
+    fprintf(output, "{\"count\":%llu,\"sum_seconds\":%.9f,\"max_seconds\":%.9f,\"buckets\":[",
+        (unsigned long long)netchunk_metrics_histogram_count(histogram),
+        (double)histogram->sum_ns / 1e9, (double)histogram->max_ns / 1e9);
+    for (int b = 0; b < NETCHUNK_METRICS_BUCKETS; b++) {
+        fprintf(output, "%s%llu", b > 0 ? "," : "", (unsigned long long)histogram->buckets[b]);
+    }
+    fputs("]}", output);
+}
+
+static void metrics_write_prometheus(const netchunk_metrics_snapshot_t* snapshot, FILE* output)
+{
+    fputs("# HELP netchunk_phase_duration_seconds Time spent in each upload and download phase\n"
+          "# TYPE netchunk_phase_duration_seconds histogram\n",
+        output);
+    for (int p = 0; p < NETCHUNK_METRICS_PHASE_COUNT; p++) {
+        metrics_write_prometheus_histogram(output, "netchunk_phase_duration_seconds", "phase",
+            phase_names[p], &snapshot->phases[p]);
+    }
+
+    fputs("# HELP netchunk_phase_duration_max_seconds Longest single observation of each phase\n"
+          "# TYPE netchunk_phase_duration_max_seconds gauge\n",
+        output);
+    for (int p = 0; p < NETCHUNK_METRICS_PHASE_COUNT; p++) {
+        fprintf(output, "netchunk_phase_duration_max_seconds{phase=\"%s\"} %.9f\n",
+            phase_names[p], (double)snapshot->phases[p].max_ns / 1e9);
+    }
+
+    for (int c = 0; c < NETCHUNK_METRICS_COUNTER_COUNT; c++) {
+        fprintf(output, "# TYPE netchunk_%s_total counter\nnetchunk_%s_total %llu\n",
+            counter_names[c], counter_names[c], (unsigned long long)snapshot->counters[c]);
+    }
+
+    fputs("# HELP netchunk_server_transfer_duration_seconds Duration of chunk transfer attempts per server\n"
+          "# TYPE netchunk_server_transfer_duration_seconds histogram\n",
+        output);
+    for (int i = 0; i < snapshot->server_count; i++) {
+        metrics_write_prometheus_histogram(output, "netchunk_server_transfer_duration_seconds", "server",
+            snapshot->servers[i].id, &snapshot->servers[i].transfer);
+    }
+
+    const struct {
+        const char* name;
+        size_t offset;
+    } server_counters[] = {
+        { "netchunk_server_bytes_sent_total", offsetof(netchunk_metrics_server_t, bytes_sent) },
+        { "netchunk_server_bytes_received_total", offsetof(netchunk_metrics_server_t, bytes_received) },
+        { "netchunk_server_transfer_failures_total", offsetof(netchunk_metrics_server_t, failures) },
+    };
+    for (size_t c = 0; c < sizeof(server_counters) / sizeof(server_counters[0]); c++) {
+        fprintf(output, "# TYPE %s counter\n", server_counters[c].name);
+        for (int i = 0; i < snapshot->server_count; i++) {
+            const netchunk_metrics_server_t* server = &snapshot->servers[i];
+            uint64_t value;
+            memcpy(&value, (const char*)server + server_counters[c].offset, sizeof(value));
+            fprintf(output, "%s{server=", server_counters[c].name);
+            metrics_write_label(output, server->id, false);
+            fprintf(output, "} %llu\n", (unsigned long long)value);
+        }
+    }
+
+    fprintf(output, "# TYPE netchunk_start_time_seconds gauge\nnetchunk_start_time_seconds %lld\n",
+        (long long)snapshot->started_at);
+}
+
+static void metrics_write_json(const netchunk_metrics_snapshot_t* snapshot, FILE* output)
+{
+    fprintf(output, "{\"started_at\":%lld,\"taken_at\":%lld,\"bucket_bounds_seconds\":[",
+        (long long)snapshot->started_at, (long long)snapshot->taken_at);
+    for (int b = 0; b < NETCHUNK_METRICS_BUCKETS - 1; b++) {
+        fprintf(output, "%s%.9g", b > 0 ? "," : "", netchunk_metrics_bucket_bound(b));
+    }
+
+    fputs("],\"counters\":{", output);
+    for (int c = 0; c < NETCHUNK_METRICS_COUNTER_COUNT; c++) {
+        fprintf(output, "%s\"%s\":%llu", c > 0 ? "," : "", counter_names[c],
+            (unsigned long long)snapshot->counters[c]);
+    }
+
+    fputs("},\"phases\":{", output);
+    for (int p = 0; p < NETCHUNK_METRICS_PHASE_COUNT; p++) {
+        fprintf(output, "%s\"%s\":", p > 0 ? "," : "", phase_names[p]);
+        metrics_write_json_histogram(output, &snapshot->phases[p]);
+    }
+
+    fputs("},\"servers\":[", output);
+    for (int i = 0; i < snapshot->server_count; i++) {
+        const netchunk_metrics_server_t* server = &snapshot->servers[i];
+        fputs(i > 0 ? ",{\"id\":" : "{\"id\":", output);
+        metrics_write_label(output, server->id, true);
+        fprintf(output, ",\"bytes_sent\":%llu,\"bytes_received\":%llu,\"failures\":%llu,\"transfer\":",
+            (unsigned long long)server->bytes_sent, (unsigned long long)server->bytes_received,
+            (unsigned long long)server->failures);
+        metrics_write_json_histogram(output, &server->transfer);
+        fputc('}', output);
+    }
+    fputs("]}\n", output);
+}
+
+static netchunk_error_t metrics_ensure_directory(const char* path)
+{
+    char path_copy[NETCHUNK_MAX_PATH_LEN];
+    strncpy(path_copy, path, sizeof(path_copy) - 1);
+    path_copy[sizeof(path_copy) - 1] = '\0';
+
+    for (char* p = path_copy + 1; *p; p++) {
+        if (*p == '/') {
+            *p = '\0';
+            if (mkdir(path_copy, 0755) != 0 && errno != EEXIST) {
+                return NETCHUNK_ERROR_FILE_ACCESS;
+            }
+            *p = '/';
+        }
+    }
+
+    if (mkdir(path_copy, 0755) != 0 && errno != EEXIST) {
+        return NETCHUNK_ERROR_FILE_ACCESS;
+    }
+
+    return NETCHUNK_SUCCESS;
+}
+
+static netchunk_error_t metrics_dump_locked(netchunk_metrics_t* metrics)
+{
+    metrics->dumped_at = time(NULL);
+
+    netchunk_error_t error = metrics_ensure_directory(metrics->output_dir);
+    if (error != NETCHUNK_SUCCESS) {
+        return error;
+    }
+
+    const char* file_name = metrics->format == NETCHUNK_MONITORING_JSON
+        ? NETCHUNK_METRICS_JSON_FILE
+        : NETCHUNK_METRICS_PROMETHEUS_FILE;
+    char path[NETCHUNK_MAX_PATH_LEN];
+    char temp_path[NETCHUNK_MAX_PATH_LEN + sizeof(METRICS_TEMP_SUFFIX)];
+    if (snprintf(path, sizeof(path), "%s/%s", metrics->output_dir, file_name) >= (int)sizeof(path)) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+    snprintf(temp_path, sizeof(temp_path), "%s%s", path, METRICS_TEMP_SUFFIX);
+
+    FILE* file = fopen(temp_path, "w");
+    if (!file) {
+        return NETCHUNK_ERROR_FILE_ACCESS;
+    }
+
+    netchunk_metrics_snapshot_t snapshot;
+    netchunk_metrics_read(metrics, &snapshot);
+    error = netchunk_metrics_write(&snapshot, metrics->format, file);
+
+    // Scrapers pick the file up by name; only a complete one is renamed over it
+    if (fclose(file) != 0 && error == NETCHUNK_SUCCESS) {
+        error = NETCHUNK_ERROR_FILE_ACCESS;
+    }
+    if (error != NETCHUNK_SUCCESS || rename(temp_path, path) != 0) {
+        unlink(temp_path);
+        return error != NETCHUNK_SUCCESS ? error : NETCHUNK_ERROR_FILE_ACCESS;
+    }
+
+    return NETCHUNK_SUCCESS;
+}
@@ -7,12 +7,21 @@
  */
 
 #include "netchunk.h"
+#include "chunk_cache.h"
+#include "cipher.h"
+#include "compress.h"
+#include "erasure.h"
+#include "journal.h"
+#include "placement.h"
 #include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
 #include <time.h>
+#include <unistd.h>
 
 /**
  * @brief Internal helper to call progress callback safely
@@ -29,73 +38,2472 @@ static void call_progress_callback(netchunk_context_t* context,
 }
 
 /**
- * @brief Internal helper to get file size
+ * @brief Load the dedup index on first use
  */
-static int64_t get_file_size(const char* filepath)
+static netchunk_error_t load_dedup_index(netchunk_context_t* context)
+{
+    if (context->dedup_index) {
+        return NETCHUNK_SUCCESS;
+    }
+
+    netchunk_dedup_index_t* index = calloc(1, sizeof(netchunk_dedup_index_t));
+    if (!index) {
+        return NETCHUNK_ERROR_OUT_OF_MEMORY;
+    }
+
+    netchunk_error_t error = netchunk_dedup_index_init(index, context->config->dedup_index_path);
+    if (error == NETCHUNK_SUCCESS) {
+        error = netchunk_dedup_index_load(index);
+    }
+    if (error != NETCHUNK_SUCCESS) {
+        netchunk_dedup_index_cleanup(index);
+        free(index);
+        return error;
+    }
+
+    context->dedup_index = index;
+    return NETCHUNK_SUCCESS;
+}
+
+/**
+ * @brief Discard in-memory index changes so the next use reloads from disk
+ */
+static void drop_dedup_index(netchunk_context_t* context)
+{
+    if (context->dedup_index) {
+        netchunk_dedup_index_cleanup(context->dedup_index);
+        free(context->dedup_index);
+        context->dedup_index = NULL;
+    }
+}
+
+/**
+ * @brief Load the file catalog on first use
+ */
+static netchunk_error_t load_catalog(netchunk_context_t* context)
+{
+    if (context->catalog) {
+        return NETCHUNK_SUCCESS;
+    }
+
+    char path[NETCHUNK_MAX_PATH_LEN];
+    int written = snprintf(path, sizeof(path), "%s/%s", context->config->local_storage_path, NETCHUNK_CATALOG_FILENAME);
+    if (written < 0 || (size_t)written >= sizeof(path)) {
+        return NETCHUNK_ERROR_CONFIG;
+    }
+
+    netchunk_catalog_t* catalog = calloc(1, sizeof(netchunk_catalog_t));
+    if (!catalog) {
+        return NETCHUNK_ERROR_OUT_OF_MEMORY;
+    }
+
+    netchunk_error_t error = netchunk_catalog_init(catalog, path);
+    if (error == NETCHUNK_SUCCESS) {
+        error = netchunk_catalog_load(catalog);
+    }
+    if (error != NETCHUNK_SUCCESS) {
+        netchunk_catalog_cleanup(catalog);
+        free(catalog);
+        return error;
+    }
+
+    context->catalog = catalog;
+    return NETCHUNK_SUCCESS;
+}
+
+/**
+ * @brief Discard in-memory catalog changes so the next use reloads from disk
+ */
+static void drop_catalog(netchunk_context_t* context)
+{
+    if (context->catalog) {
+        netchunk_catalog_cleanup(context->catalog);
+        free(context->catalog);
+        context->catalog = NULL;
+    }
+}
+
+/**
+ * @brief Load the catalog and sync it if it is older than catalog_sync_interval
+ *
+ * A catalog synced before keeps answering while the servers are unreachable.
+ */
+static netchunk_error_t refresh_catalog(netchunk_context_t* context)
+{
+    netchunk_error_t error = load_catalog(context);
+    if (error != NETCHUNK_SUCCESS) {
+        return error;
+    }
+
+    netchunk_catalog_t* catalog = context->catalog;
+    time_t now = time(NULL);
+    if (catalog->last_sync != 0 && now >= catalog->last_sync
+        && now - catalog->last_sync < context->config->catalog_sync_interval) {
+        return NETCHUNK_SUCCESS;
+    }
+
+    error = netchunk_catalog_sync(catalog, context->ftp_context, context->config, NULL);
+    return (error != NETCHUNK_SUCCESS && catalog->last_sync == 0) ? error : NETCHUNK_SUCCESS;
+}
+
+/**
+ * @brief Record a change to one file in the catalog
+ *
+ * Best effort: the servers already hold the change and the next sync picks
+ * it up, so a failure only drops the in-memory catalog. A NULL manifest
+ * removes the file.
+ */
+static void update_catalog(netchunk_context_t* context, const char* remote_name,
+    const netchunk_file_manifest_t* manifest)
+{
+    if (load_catalog(context) != NETCHUNK_SUCCESS) {
+        return;
+    }
+
+    netchunk_error_t error = NETCHUNK_SUCCESS;
+    if (manifest) {
+        // The remote copy's listing time is unknown, so the next sync reads it once
+        error = netchunk_catalog_put(context->catalog, manifest, 0, 0);
+    } else {
+        netchunk_catalog_remove(context->catalog, remote_name);
+    }
+
+    if (error == NETCHUNK_SUCCESS && context->catalog->dirty) {
+        error = netchunk_catalog_save(context->catalog);
+    }
+    if (error != NETCHUNK_SUCCESS) {
+        drop_catalog(context);
+    }
+}
+
+/**
+ * @brief Fill a summary manifest (no chunks) from a catalog entry
+ */
+static void catalog_entry_to_summary(const netchunk_catalog_entry_t* entry, netchunk_file_manifest_t* summary)
+{
+    memset(summary, 0, sizeof(netchunk_file_manifest_t));
+    strncpy(summary->original_filename, entry->name, sizeof(summary->original_filename) - 1);
+    strncpy(summary->version, NETCHUNK_MANIFEST_VERSION, sizeof(summary->version) - 1);
+    summary->total_size = (size_t)entry->total_size;
+    summary->original_size = (size_t)entry->total_size;
+    memcpy(summary->file_hash, entry->file_hash, NETCHUNK_HASH_LENGTH);
+    summary->chunk_count = entry->chunk_count;
+    summary->created_timestamp = entry->created_timestamp;
+    summary->last_modified = entry->last_modified;
+}
+
+/**
+ * @brief Internal helper to find a configured server index by its ID
+ */
+static int find_server_index(netchunk_context_t* context, const char* server_id)
+{
+    for (int s = 0; s < context->config->server_count; s++) {
+        if (strcmp(context->config->servers[s].id, server_id) == 0) {
+            return s;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief Move servers the health monitor found unavailable to the end of a ranking
+ *
+ * Keeps the order within both groups, so they stay as alternates.
+ */
+static void demote_unavailable_servers(netchunk_context_t* context, int* server_indices, int count)
+{
+    if (!context->health_monitor) {
+        return;
+    }
+
+    int unavailable[NETCHUNK_MAX_SERVERS];
+    int unavailable_count = 0;
+    int kept = 0;
+    for (int i = 0; i < count; i++) {
+        if (netchunk_health_monitor_usable(context->health_monitor, server_indices[i])) {
+            server_indices[kept++] = server_indices[i];
+        } else {
+            unavailable[unavailable_count++] = server_indices[i];
+        }
+    }
+    memcpy(server_indices + kept, unavailable, (size_t)unavailable_count * sizeof(int));
+}
+
+/**
+ * @brief Open the journal of one transfer under local_storage_path
+ *
+ * Best effort: without a journal the transfer still runs, it just cannot
+ * be resumed. A journal that cannot be read starts out empty.
+ */
+static netchunk_journal_t* open_journal(netchunk_context_t* context,
+    netchunk_journal_t* journal,
+    netchunk_journal_operation_t operation,
+    const char* remote_name,
+    const char* local_path)
+{
+    char directory[NETCHUNK_MAX_PATH_LEN];
+    int written = snprintf(directory, sizeof(directory), "%s/%s", context->config->local_storage_path,
+        NETCHUNK_JOURNAL_DIRECTORY);
+    if (written < 0 || (size_t)written >= sizeof(directory)) {
+        return NULL;
+    }
+
+    if (netchunk_journal_init(journal, directory, operation, remote_name, local_path) != NETCHUNK_SUCCESS) {
+        netchunk_journal_cleanup(journal);
+        return NULL;
+    }
+
+    if (netchunk_journal_load(journal) != NETCHUNK_SUCCESS) {
+        netchunk_journal_reset(journal);
+    }
+
+    return journal;
+}
+
+/**
+ * @brief Open the upload journal of a local file, reset if the file or chunking changed
+ */
+static netchunk_journal_t* begin_upload_journal(netchunk_context_t* context,
+    netchunk_journal_t* storage,
+    const char* local_path,
+    const char* remote_name)
 {
     struct stat st;
-    if (stat(filepath, &st) == 0) {
-        return st.st_size;
+    if (stat(local_path, &st) != 0 || !S_ISREG(st.st_mode)) {
+        return NULL;
+    }
+
+    netchunk_journal_t* journal = open_journal(context, storage, NETCHUNK_JOURNAL_UPLOAD, remote_name, local_path);
+    if (!journal) {
+        return NULL;
+    }
+
+    netchunk_config_t* config = context->config;
+    if (journal->source_size != (uint64_t)st.st_size || journal->source_modified != st.st_mtime
+        || journal->chunk_size != config->chunk_size || journal->chunking_mode != config->chunking_mode
+        || journal->content_addressed != config->content_addressed) {
+        netchunk_journal_reset(journal);
+        journal->source_size = (uint64_t)st.st_size;
+        journal->source_modified = st.st_mtime;
+        journal->chunk_size = config->chunk_size;
+        journal->chunking_mode = config->chunking_mode;
+        journal->content_addressed = config->content_addressed;
+    }
+
+    return journal;
+}
+
+/**
+ * @brief Remove a finished transfer's journal, or save it so a retry can resume
+ */
+static void finish_journal(netchunk_journal_t* journal, bool completed)
+{
+    if (!journal) {
+        return;
+    }
+
+    if (completed || !netchunk_journal_has_progress(journal)) {
+        netchunk_journal_discard(journal);
+    } else {
+        netchunk_journal_save(journal);
+    }
+    netchunk_journal_cleanup(journal);
+}
+
+/**
+ * @brief Per-chunk state tracked by the upload pipeline
+ *
+ * One slot exists for every chunk inside the in-flight window. Slots are
+ * reused round-robin once the assembler has committed their chunk, and so
+ * are their payload buffers, which bounds upload memory to the window.
+ * Erasure-coded uploads queue a stripe's parity chunks in the slots after
+ * its last data chunk.
+ */
+typedef struct upload_slot {
+    struct upload_pipeline* pipeline;
+    netchunk_chunk_t chunk; // Chunk read and hashed by the reader stage
+    uint8_t* buffer; // Payload buffer the chunk borrows, allocated on first use
+    uint8_t* compressed; // Compressed form of the chunk, allocated on first use
+    char remote_path[NETCHUNK_MAX_PATH_LEN]; // Chunk path on every server
+    netchunk_ftp_transfer_t transfers[NETCHUNK_MAX_REPLICATION_FACTOR]; // One per replica
+    int ranking[NETCHUNK_MAX_SERVERS]; // Servers to store the chunk on, best first
+    bool claimed[NETCHUNK_MAX_SERVERS]; // Servers already attempted for this chunk
+    bool stored[NETCHUNK_MAX_SERVERS]; // Servers holding a replica
+    time_t stored_at[NETCHUNK_MAX_SERVERS]; // Replica upload times
+    int pending_replicas; // Replica transfers not yet finished
+    int successful_replicas; // Replicas stored successfully
+    bool parity; // Holds a parity chunk rather than file data
+    uint32_t stripe; // Stripe of an erasure-coded chunk
+    int shard; // Position in the stripe, data first then parity
+} upload_slot_t;
+
+/**
+ * @brief Shared state of the concurrent upload pipeline
+ *
+ * The calling thread reads chunks into the window and commits finished
+ * chunks to the manifest in sequence order; the FTP transfer engine fans
+ * each chunk out to distinct servers.
+ */
+typedef struct upload_pipeline {
+    netchunk_context_t* context;
+    upload_slot_t* slots; // In-flight window
+    int window; // Maximum chunks in flight
+    size_t buffer_size; // Size of each slot's payload buffer
+    netchunk_compression_t compression; // Codec chunks are offered to
+    int compression_level;
+    size_t stored_buffer_size; // Size of each slot's compressed buffer
+    uint32_t compressed_chunks; // Chunks stored compressed
+    uint64_t bytes_stored; // File data bytes stored per replica after compression and encryption
+    uint8_t key_id[NETCHUNK_KEY_ID_LENGTH]; // Key chunks are encrypted with, all zero if not
+    size_t trailer_size; // Room for the cipher trailer after every payload
+    int target_replicas; // Replicas requested per chunk
+    netchunk_placement_t placement; // Ranks servers for replicated chunks
+    const netchunk_dedup_index_t* dedup_index; // Set when chunks are content-addressed
+    uint32_t dedup_chunks; // Chunks already stored at full replication
+    uint64_t dedup_bytes; // Bytes of those chunks
+    uint32_t resumed_chunks; // Chunks whose journaled replicas were reused
+    uint64_t resumed_bytes; // Bytes of those chunks
+    int data_shards; // Chunks per erasure-coded stripe (0 = replicate instead)
+    int parity_shards;
+    uint8_t* parity[NETCHUNK_EC_MAX_SHARDS]; // Parity of the current stripe's data read so far
+    uint32_t stripe; // Stripe being read
+    int stripe_data_read; // Data chunks of it read
+    size_t stripe_shard_size; // Largest of them, the stripe's parity size
+    int parity_pending; // Parity chunks of a finished stripe not yet queued
+    pthread_mutex_t mutex;
+    pthread_cond_t slot_done; // Signalled when a chunk has no pending replicas
+    uint32_t retries; // Failed upload attempts
+    uint32_t under_replicated_chunks; // Chunks committed with fewer than target_replicas replicas
+    bool aborted; // Skip remaining uploads after a fatal error
+} upload_pipeline_t;
+
+/**
+ * @brief Claim the best-ranked untried server for a chunk
+ *
+ * Servers the health monitor found unavailable rank last, so they are
+ * only tried once every other server has been.
+ */
+static int upload_claim_server(upload_pipeline_t* pipeline, upload_slot_t* slot)
+{
+    int server_count = pipeline->context->config->server_count;
+
+    for (int i = 0; i < server_count; i++) {
+        int server_idx = slot->ranking[i];
+        if (!slot->claimed[server_idx]) {
+            slot->claimed[server_idx] = true;
+            return server_idx;
+        }
     }
     return -1;
 }
 
-netchunk_error_t netchunk_init(netchunk_context_t* context, const char* config_path)
-{
-    if (!context) {
-        return NETCHUNK_ERROR_INVALID_ARGUMENT;
-    }
+/**
+ * @brief Reweigh the servers when the health monitor has published a new round
+ */
+static void upload_refresh_placement(upload_pipeline_t* pipeline)
+{
+    const netchunk_health_monitor_t* monitor = pipeline->context->health_monitor;
+    if (!monitor) {
+        return;
+    }
+
+    netchunk_health_snapshot_t snapshot;
+    netchunk_health_monitor_read(monitor, &snapshot);
+    if (snapshot.generation != pipeline->placement.generation) {
+        netchunk_placement_init(&pipeline->placement, pipeline->context->config, &snapshot);
+    }
+}
+
+/**
+ * @brief Queue one replica upload of a slot's chunk on the transfer engine
+ */
+static netchunk_error_t upload_submit_replica(upload_pipeline_t* pipeline,
+    upload_slot_t* slot,
+    netchunk_ftp_transfer_t* transfer,
+    int server_idx);
+
+/**
+ * @brief Transfer completion: record the replica or retry on another server
+ *
+ * Runs on the engine thread. A failed replica falls through to the next
+ * unclaimed server in the chunk's ranking, so each chunk still ends up on
+ * distinct servers.
+ */
+static void upload_transfer_done(netchunk_ftp_transfer_t* transfer, void* userdata)
+{
+    upload_slot_t* slot = (upload_slot_t*)userdata;
+    upload_pipeline_t* pipeline = slot->pipeline;
+    int server_idx = transfer->server_index;
+
+    pthread_mutex_lock(&pipeline->mutex);
+
+    if (transfer->result == NETCHUNK_SUCCESS) {
+        pipeline->retries += (uint32_t)(transfer->attempts - 1);
+        slot->stored[server_idx] = true;
+        slot->stored_at[server_idx] = time(NULL);
+        slot->successful_replicas++;
+    } else {
+        pipeline->retries += (uint32_t)transfer->attempts;
+
+        while (!pipeline->aborted) {
+            int next_idx = upload_claim_server(pipeline, slot);
+            if (next_idx < 0) {
+                break;
+            }
+            if (upload_submit_replica(pipeline, slot, transfer, next_idx) == NETCHUNK_SUCCESS) {
+                netchunk_metrics_add(pipeline->context->metrics, NETCHUNK_METRICS_RETRIES, 1);
+                pthread_mutex_unlock(&pipeline->mutex);
+                return;
+            }
+            server_idx = next_idx;
+        }
+    }
+
+    slot->pending_replicas--;
+    if (slot->pending_replicas == 0) {
+        pthread_cond_broadcast(&pipeline->slot_done);
+    }
+
+    pthread_mutex_unlock(&pipeline->mutex);
+}
+
+static netchunk_error_t upload_submit_replica(upload_pipeline_t* pipeline,
+    upload_slot_t* slot,
+    netchunk_ftp_transfer_t* transfer,
+    int server_idx)
+{
+    netchunk_ftp_segment_t segment = { slot->chunk.data, netchunk_chunk_stored_size(&slot->chunk) };
+
+    netchunk_error_t error = netchunk_ftp_transfer_init_upload(transfer, server_idx, slot->remote_path,
+        &segment, 1, upload_transfer_done, slot);
+    if (error != NETCHUNK_SUCCESS) {
+        return error;
+    }
+
+    return netchunk_ftp_engine_submit(pipeline->context->ftp_context->engine, transfer);
+}
+
+/**
+ * @brief Initialize the upload pipeline
+ */
+static netchunk_error_t upload_pipeline_init(upload_pipeline_t* pipeline,
+    netchunk_context_t* context,
+    size_t buffer_size)
+{
+    memset(pipeline, 0, sizeof(upload_pipeline_t));
+
+    int concurrency = context->config->max_concurrent_operations;
+    if (concurrency < 1) {
+        concurrency = 1;
+    }
+
+    pipeline->context = context;
+    pipeline->buffer_size = buffer_size;
+    pipeline->target_replicas = context->config->replication_factor;
+    pipeline->compression = context->config->compression;
+    pipeline->compression_level = context->config->compression_level;
+    if (pipeline->compression != NETCHUNK_COMPRESSION_NONE) {
+        pipeline->stored_buffer_size = netchunk_compress_bound(pipeline->compression, buffer_size);
+    }
+    if (context->config->encrypt_chunks) {
+        memcpy(pipeline->key_id, context->encryption_key_id, NETCHUNK_KEY_ID_LENGTH);
+        pipeline->trailer_size = NETCHUNK_CIPHER_OVERHEAD;
+    }
+
+    // Stripe parity replaces replicas
+    if (context->config->erasure_data_shards > 0) {
+        pipeline->data_shards = context->config->erasure_data_shards;
+        pipeline->parity_shards = context->config->erasure_parity_shards;
+        pipeline->target_replicas = 1;
+    }
+    if (pipeline->target_replicas > context->config->server_count) {
+        pipeline->target_replicas = context->config->server_count;
+    }
+    if (pipeline->target_replicas > NETCHUNK_MAX_REPLICATION_FACTOR) {
+        pipeline->target_replicas = NETCHUNK_MAX_REPLICATION_FACTOR;
+    }
+    if (pipeline->target_replicas < 1) {
+        pipeline->target_replicas = 1;
+    }
+
+    // Enough chunks in flight to keep every server at its concurrency cap
+    pipeline->window = concurrency * context->config->server_count / pipeline->target_replicas;
+    if (pipeline->window < concurrency) {
+        pipeline->window = concurrency;
+    }
+
+    // Weigh by a probe, as repair and rebalancing do, even before the
+    // monitor's first round; otherwise the first chunks land where a
+    // rebalance would move them from
+    netchunk_error_t error;
+    if (context->health_monitor && netchunk_health_monitor_ensure_probed(context->health_monitor) == NETCHUNK_SUCCESS) {
+        netchunk_health_snapshot_t snapshot;
+        netchunk_health_monitor_read(context->health_monitor, &snapshot);
+        error = netchunk_placement_init(&pipeline->placement, context->config, &snapshot);
+    } else {
+        error = netchunk_placement_init(&pipeline->placement, context->config, NULL);
+    }
+    if (error != NETCHUNK_SUCCESS) {
+        return error;
+    }
+
+    pipeline->slots = calloc((size_t)pipeline->window, sizeof(upload_slot_t));
+    if (!pipeline->slots) {
+        return NETCHUNK_ERROR_OUT_OF_MEMORY;
+    }
+
+    for (int i = 0; i < pipeline->window; i++) {
+        pipeline->slots[i].pipeline = pipeline;
+    }
+
+    for (int p = 0; p < pipeline->parity_shards; p++) {
+        pipeline->parity[p] = calloc(1, buffer_size + pipeline->trailer_size);
+        if (!pipeline->parity[p]) {
+            for (int q = 0; q < p; q++) {
+                free(pipeline->parity[q]);
+            }
+            free(pipeline->slots);
+            return NETCHUNK_ERROR_OUT_OF_MEMORY;
+        }
+    }
+
+    pthread_mutex_init(&pipeline->mutex, NULL);
+    pthread_cond_init(&pipeline->slot_done, NULL);
+
+    return NETCHUNK_SUCCESS;
+}
+
+/**
+ * @brief Release pipeline resources once every slot has drained
+ */
+static void upload_pipeline_cleanup(upload_pipeline_t* pipeline)
+{
+    pthread_mutex_destroy(&pipeline->mutex);
+    pthread_cond_destroy(&pipeline->slot_done);
+
+    for (int i = 0; i < pipeline->window; i++) {
+        free(pipeline->slots[i].buffer);
+        free(pipeline->slots[i].compressed);
+    }
+    free(pipeline->slots);
+
+    for (int p = 0; p < pipeline->parity_shards; p++) {
+        free(pipeline->parity[p]);
+    }
+}
+
+/**
+ * @brief Record that a chunk will be stored encrypted, if encryption is on
+ *
+ * Only sets the key and the stored size, so a journaled chunk can be
+ * compared before it has an ID; upload_pipeline_submit() encrypts.
+ */
+static void upload_mark_encrypted(upload_pipeline_t* pipeline, upload_slot_t* slot)
+{
+    if (!netchunk_key_id_is_set(pipeline->key_id)) {
+        return;
+    }
+
+    size_t plain_size = netchunk_chunk_stored_size(&slot->chunk);
+    memcpy(slot->chunk.key_id, pipeline->key_id, NETCHUNK_KEY_ID_LENGTH);
+    slot->chunk.stored_size = plain_size + NETCHUNK_CIPHER_OVERHEAD;
+}
+
+/**
+ * @brief Compress a freshly read chunk if it pays off
+ *
+ * Runs on the reader while the chunk is still in cache from hashing. The
+ * chunk keeps its raw size and hash and borrows the slot's compressed
+ * buffer as its data; chunks that do not shrink are sent as read.
+ */
+static netchunk_error_t upload_compress_chunk(upload_pipeline_t* pipeline, upload_slot_t* slot)
+{
+    if (pipeline->compression == NETCHUNK_COMPRESSION_NONE) {
+        upload_mark_encrypted(pipeline, slot);
+        pipeline->bytes_stored += netchunk_chunk_stored_size(&slot->chunk);
+        return NETCHUNK_SUCCESS;
+    }
+
+    if (!slot->compressed) {
+        slot->compressed = malloc(pipeline->stored_buffer_size + pipeline->trailer_size);
+        if (!slot->compressed) {
+            return NETCHUNK_ERROR_OUT_OF_MEMORY;
+        }
+    }
+
+    size_t stored_size;
+    uint64_t start_ns = netchunk_metrics_start(pipeline->context->metrics);
+    netchunk_error_t error = netchunk_compress(pipeline->compression, pipeline->compression_level,
+        slot->chunk.data, slot->chunk.size, slot->compressed, pipeline->stored_buffer_size, &stored_size);
+    if (error != NETCHUNK_SUCCESS) {
+        return error;
+    }
+    netchunk_metrics_record(pipeline->context->metrics, NETCHUNK_METRICS_COMPRESS, start_ns);
+
+    if (stored_size > 0) {
+        slot->chunk.data = slot->compressed;
+        slot->chunk.codec = pipeline->compression;
+        slot->chunk.stored_size = stored_size;
+        pipeline->compressed_chunks++;
+    }
+    upload_mark_encrypted(pipeline, slot);
+    pipeline->bytes_stored += netchunk_chunk_stored_size(&slot->chunk);
+    return NETCHUNK_SUCCESS;
+}
+
+/**
+ * @brief Fold a freshly read data chunk into its stripe's parity
+ *
+ * Parity is accumulated chunk by chunk, so a stripe never has to be held
+ * in memory; once the stripe is complete its parity chunks are queued.
+ */
+static void upload_stripe_add_data(upload_pipeline_t* pipeline, upload_slot_t* slot)
+{
+    slot->parity = false;
+    slot->stripe = pipeline->stripe;
+    slot->shard = pipeline->stripe_data_read;
+
+    for (int p = 0; p < pipeline->parity_shards; p++) {
+        netchunk_gf_mul_add_region(pipeline->parity[p], slot->chunk.data,
+            netchunk_ec_coefficient(pipeline->data_shards, p, slot->shard), slot->chunk.size);
+    }
+
+    if (slot->chunk.size > pipeline->stripe_shard_size) {
+        pipeline->stripe_shard_size = slot->chunk.size;
+    }
+
+    pipeline->stripe_data_read++;
+    if (pipeline->stripe_data_read == pipeline->data_shards) {
+        pipeline->parity_pending = pipeline->parity_shards;
+    }
+}
+
+/**
+ * @brief Move the next parity chunk of a finished stripe into a slot
+ *
+ * The slot's free buffer becomes the accumulator for the next stripe, so
+ * parity is handed over without copying.
+ */
+static netchunk_error_t upload_stripe_take_parity(upload_pipeline_t* pipeline,
+    upload_slot_t* slot,
+    const uint8_t* upload_id)
+{
+    int p = pipeline->parity_shards - pipeline->parity_pending;
+    uint32_t sequence = pipeline->stripe * (uint32_t)pipeline->parity_shards + (uint32_t)p;
+
+    uint8_t* parity = pipeline->parity[p];
+    pipeline->parity[p] = slot->buffer;
+    slot->buffer = parity;
+    memset(pipeline->parity[p], 0, pipeline->buffer_size);
+
+    netchunk_error_t error = netchunk_chunk_init(&slot->chunk, sequence, pipeline->stripe_shard_size);
+    if (error == NETCHUNK_SUCCESS) {
+        error = netchunk_generate_chunk_id(slot->chunk.id, sequence | NETCHUNK_EC_PARITY_ID_FLAG, upload_id);
+    }
+    if (error == NETCHUNK_SUCCESS) {
+        slot->chunk.data = slot->buffer;
+        error = netchunk_sha256_hash(slot->chunk.data, slot->chunk.size, slot->chunk.hash);
+    }
+    if (error != NETCHUNK_SUCCESS) {
+        return error;
+    }
+
+    upload_mark_encrypted(pipeline, slot);
+    slot->parity = true;
+    slot->stripe = pipeline->stripe;
+    slot->shard = pipeline->data_shards + p;
+
+    pipeline->parity_pending--;
+    if (pipeline->parity_pending == 0) {
+        pipeline->stripe++;
+        pipeline->stripe_data_read = 0;
+        pipeline->stripe_shard_size = 0;
+    }
+
+    return NETCHUNK_SUCCESS;
+}
+
+/**
+ * @brief Queue replica uploads for a freshly read chunk
+ *
+ * Replicas go to the servers the placement ranks highest for the chunk's
+ * ID; the shards of an erasure-coded stripe each get their own server and
+ * never fail over onto another shard's. Replicas an earlier attempt
+ * committed (committed, from the journal) or that the dedup index already
+ * places on configured servers count as stored; only missing replicas are
+ * sent.
+ */
+static netchunk_error_t upload_pipeline_submit(upload_pipeline_t* pipeline,
+    upload_slot_t* slot,
+    const netchunk_chunk_t* committed)
+{
+    netchunk_error_t error;
+
+    // Reused replicas live under the ID they were uploaded with
+    if (committed) {
+        memcpy(slot->chunk.id, committed->id, sizeof(slot->chunk.id));
+    } else if (pipeline->dedup_index) {
+        error = netchunk_chunk_set_content_id(&slot->chunk);
+        if (error != NETCHUNK_SUCCESS) {
+            return error;
+        }
+    }
+
+    // In place, once the chunk has the ID it is authenticated under
+    if (netchunk_key_id_is_set(slot->chunk.key_id)) {
+        uint64_t start_ns = netchunk_metrics_start(pipeline->context->metrics);
+        error = netchunk_cipher_encrypt(slot->chunk.key_id, slot->chunk.id, slot->chunk.data,
+            slot->chunk.stored_size - NETCHUNK_CIPHER_OVERHEAD);
+        if (error != NETCHUNK_SUCCESS) {
+            return error;
+        }
+        netchunk_metrics_record(pipeline->context->metrics, NETCHUNK_METRICS_ENCRYPT, start_ns);
+    }
+
+    error = netchunk_ftp_chunk_path(&slot->chunk, slot->remote_path, sizeof(slot->remote_path));
+    if (error != NETCHUNK_SUCCESS) {
+        return error;
+    }
+
+    netchunk_config_t* config = pipeline->context->config;
+    int server_count = config->server_count;
+
+    pthread_mutex_lock(&pipeline->mutex);
+
+    memset(slot->claimed, 0, sizeof(slot->claimed));
+    memset(slot->stored, 0, sizeof(slot->stored));
+    slot->successful_replicas = 0;
+    slot->pending_replicas = 0;
+
+    // A stripe's shards rotate over consecutive servers so they never share
+    // one; replicated chunks go where their ID hashes to
+    if (pipeline->data_shards > 0) {
+        int width = pipeline->data_shards + pipeline->parity_shards;
+        int stripe_start = (int)(((uint64_t)slot->stripe * (uint64_t)width) % (uint64_t)server_count);
+        for (int j = 0; j < width; j++) {
+            if (j != slot->shard) {
+                slot->claimed[(stripe_start + j) % server_count] = true;
+            }
+        }
+        for (int i = 0; i < server_count; i++) {
+            slot->ranking[i] = (stripe_start + slot->shard + i) % server_count;
+        }
+        demote_unavailable_servers(pipeline->context, slot->ranking, server_count);
+    } else {
+        upload_refresh_placement(pipeline);
+        netchunk_placement_rank(&pipeline->placement, slot->chunk.id, slot->ranking, server_count);
+    }
+
+    const netchunk_dedup_entry_t* entry = NULL;
+    if (committed) {
+        for (int i = 0; i < committed->location_count && slot->successful_replicas < pipeline->target_replicas; i++) {
+            int s = find_server_index(pipeline->context, committed->locations[i].server_id);
+            if (s >= 0 && !slot->stored[s]) {
+                slot->claimed[s] = true;
+                slot->stored[s] = true;
+                slot->stored_at[s] = committed->locations[i].upload_time;
+                slot->successful_replicas++;
+            }
+        }
+
+        if (slot->successful_replicas > 0) {
+            pipeline->resumed_chunks++;
+            pipeline->resumed_bytes += slot->chunk.size;
+        }
+    } else {
+        entry = netchunk_dedup_index_lookup(pipeline->dedup_index, slot->chunk.hash);
+    }
+
+    if (entry && entry->size == slot->chunk.size) {
+        time_t now = time(NULL);
+        for (int s = 0; s < server_count && slot->successful_replicas < pipeline->target_replicas; s++) {
+            if (netchunk_dedup_entry_has_server(pipeline->dedup_index, entry, config->servers[s].id)) {
+                slot->claimed[s] = true;
+                slot->stored[s] = true;
+                slot->stored_at[s] = now;
+                slot->successful_replicas++;
+            }
+        }
+
+        if (slot->successful_replicas == pipeline->target_replicas) {
+            pipeline->dedup_chunks++;
+            pipeline->dedup_bytes += slot->chunk.size;
+        }
+    }
+
+    for (int r = slot->successful_replicas; r < pipeline->target_replicas; r++) {
+        int server_idx;
+
+        // Skip servers the engine refuses outright; the chunk still gets the rest
+        while ((server_idx = upload_claim_server(pipeline, slot)) >= 0) {
+            if (upload_submit_replica(pipeline, slot, &slot->transfers[r], server_idx) == NETCHUNK_SUCCESS) {
+                slot->pending_replicas++;
+                break;
+            }
+        }
+    }
+
+    pthread_mutex_unlock(&pipeline->mutex);
+    return NETCHUNK_SUCCESS;
+}
+
+/**
+ * @brief Block until every replica transfer of a slot has finished
+ */
+static void upload_pipeline_wait(upload_pipeline_t* pipeline, upload_slot_t* slot)
+{
+    pthread_mutex_lock(&pipeline->mutex);
+    while (slot->pending_replicas > 0) {
+        pthread_cond_wait(&pipeline->slot_done, &pipeline->mutex);
+    }
+    pthread_mutex_unlock(&pipeline->mutex);
+}
+
+/**
+ * @brief Stop failed replicas from being retried after a fatal error
+ */
+static void upload_pipeline_abort(upload_pipeline_t* pipeline)
+{
+    pthread_mutex_lock(&pipeline->mutex);
+    pipeline->aborted = true;
+    pthread_mutex_unlock(&pipeline->mutex);
+}
+
+/**
+ * @brief Record replica locations in server order and add the chunk to the manifest
+ *
+ * Locations are emitted by server index rather than completion order so the
+ * manifest does not depend on transfer scheduling. Parity chunks go to the
+ * manifest's parity list.
+ */
+static netchunk_error_t upload_commit_chunk(netchunk_context_t* context,
+    upload_slot_t* slot,
+    netchunk_file_manifest_t* manifest)
+{
+    netchunk_chunk_t* chunk = &slot->chunk;
+
+    for (int s = 0; s < context->config->server_count && chunk->location_count < NETCHUNK_MAX_CHUNK_LOCATIONS; s++) {
+        if (!slot->stored[s]) {
+            continue;
+        }
+
+        netchunk_chunk_location_t* location = &chunk->locations[chunk->location_count];
+        memset(location, 0, sizeof(netchunk_chunk_location_t));
+        strncpy(location->server_id, context->config->servers[s].id,
+            sizeof(location->server_id) - 1);
+        location->upload_time = slot->stored_at[s];
+        chunk->location_count++;
+    }
+
+    return slot->parity ? netchunk_manifest_add_parity_chunk(manifest, chunk) : netchunk_manifest_add_chunk(manifest, chunk);
+}
+
+/**
+ * @brief One chunk fetch in flight in the download pipeline
+ */
+typedef struct download_slot {
+    struct download_pipeline* pipeline;
+    netchunk_chunk_t chunk; // Private copy of the manifest entry
+    char remote_path[NETCHUNK_MAX_PATH_LEN];
+    netchunk_ftp_transfer_t transfer;
+    uint32_t index; // Position of the chunk in the manifest
+    bool tried[NETCHUNK_MAX_SERVERS]; // Servers already fetched from
+    bool from_cache; // Queued to be read from the local chunk cache
+    struct download_slot* next; // Free list or verify queue link
+} download_slot_t;
+
+/**
+ * @brief Shared state of the parallel download pipeline
+ *
+ * The calling thread submits chunk fetches to the FTP transfer engine and
+ * reports progress. Fetched buffers are handed to verifier threads, which
+ * check the chunk hash and write it at its final offset, keeping hashing
+ * off the engine's event loop. Chunks in the local chunk cache skip the
+ * engine and are read by the verifiers directly; fetched chunks are added
+ * to it once verified.
+ */
+typedef struct download_pipeline {
+    netchunk_context_t* context;
+    const netchunk_file_manifest_t* manifest;
+    int output_fd; // Preallocated output file
+    netchunk_journal_t* journal; // Written chunks, NULL for descriptor downloads
+    download_slot_t* slots;
+    download_slot_t* free_slots;
+    download_slot_t* verify_head; // Fetched, waiting for a verifier
+    download_slot_t* verify_tail;
+    pthread_t* verifiers;
+    int verifier_count;
+    size_t verify_batch; // Chunks a verifier hashes together
+    int in_flight; // Slots not on the free list
+    uint32_t next_chunk; // Next manifest index to submit
+    uint32_t chunks_completed;
+    uint64_t bytes_completed; // Bytes verified and written so far
+    uint32_t retries; // Failed download attempts
+    uint32_t cache_hits; // Chunks read from the local chunk cache
+    uint64_t bytes_from_cache;
+    uint32_t cache_misses; // Chunks fetched because they were not cached
+    uint32_t hedged; // Chunks delivered by a backup request
+    bool* lost; // Per chunk: no replica delivered it; set for erasure-coded files only
+    uint32_t lost_count; // Chunks to rebuild from their stripe once the pipeline drains
+    netchunk_error_t error; // First fatal error, stops further submissions
+    bool shutdown; // Verifiers exit once the queue is drained
+    pthread_mutex_t mutex;
+    pthread_cond_t progress; // Signalled when a slot is released
+    pthread_cond_t verify_ready; // Signalled when a buffer is queued or on shutdown
+} download_pipeline_t;
+
+/**
+ * @brief Internal helper to read a whole buffer from a file offset
+ * @return true if all size bytes were read
+ */
+static bool read_at_offset(int fd, uint8_t* data, size_t size, off_t offset)
+{
+    size_t have = 0;
+    while (have < size) {
+        ssize_t n = pread(fd, data + have, size - have, offset + (off_t)have);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        have += (size_t)n;
+    }
+    return true;
+}
+
+/**
+ * @brief Internal helper to write a whole buffer at a file offset
+ */
+static netchunk_error_t write_at_offset(int fd, const uint8_t* data, size_t size, off_t offset)
+{
+    while (size > 0) {
+        ssize_t written = pwrite(fd, data, size, offset);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return NETCHUNK_ERROR_FILE_ACCESS;
+        }
+        data += written;
+        size -= (size_t)written;
+        offset += written;
+    }
+    return NETCHUNK_SUCCESS;
+}
+
+/**
+ * @brief Write a verified chunk at its offset in the output file
+ */
+static netchunk_error_t download_write_chunk(download_pipeline_t* pipeline, const uint8_t* data, const netchunk_chunk_t* chunk)
+{
+    netchunk_metrics_t* metrics = pipeline->context->metrics;
+    uint64_t start_ns = netchunk_metrics_start(metrics);
+    netchunk_error_t error = write_at_offset(pipeline->output_fd, data, chunk->size, (off_t)chunk->offset);
+    if (error == NETCHUNK_SUCCESS && metrics) {
+        netchunk_metrics_record(metrics, NETCHUNK_METRICS_WRITE, start_ns);
+        netchunk_metrics_add(metrics, NETCHUNK_METRICS_BYTES_WRITTEN, chunk->size);
+    }
+    return error;
+}
+
+/**
+ * @brief Return a slot to the free list; records error if it failed
+ *
+ * Must be called with the pipeline lock held.
+ */
+static void download_release_slot(download_pipeline_t* pipeline, download_slot_t* slot, netchunk_error_t error)
+{
+    if (error == NETCHUNK_SUCCESS) {
+        pipeline->chunks_completed++;
+        pipeline->bytes_completed += slot->chunk.size;
+        netchunk_journal_set_completed(pipeline->journal, slot->index, true);
+    } else if (pipeline->lost && error != NETCHUNK_ERROR_FILE_ACCESS && pipeline->error == NETCHUNK_SUCCESS) {
+        // Decoded from the rest of its stripe once the other chunks are in
+        pipeline->lost[slot->index] = true;
+        pipeline->lost_count++;
+    } else if (pipeline->error == NETCHUNK_SUCCESS) {
+        pipeline->error = error;
+    }
+
+    netchunk_ftp_transfer_cleanup(&slot->transfer);
+    slot->next = pipeline->free_slots;
+    pipeline->free_slots = slot;
+    pipeline->in_flight--;
+    pthread_cond_broadcast(&pipeline->progress);
+}
+
+/**
+ * @brief Hand a slot to the verifiers
+ *
+ * Must be called with the pipeline lock held.
+ */
+static void download_queue_verify(download_pipeline_t* pipeline, download_slot_t* slot)
+{
+    slot->next = NULL;
+    if (pipeline->verify_tail) {
+        pipeline->verify_tail->next = slot;
+    } else {
+        pipeline->verify_head = slot;
+    }
+    pipeline->verify_tail = slot;
+    pthread_cond_signal(&pipeline->verify_ready);
+}
+
+static void download_transfer_done(netchunk_ftp_transfer_t* transfer, void* userdata);
+
+/**
+ * @brief Submit a fetch of the slot's chunk from its untried replicas
+ *
+ * Replicas are ranked by the engine's server scores, so the one expected
+ * to deliver first given its latency, throughput, error rate and current
+ * load is preferred. Ties rotate with the sequence number so chunks are
+ * spread across servers that look alike. The others are passed as
+ * alternates so the engine can fall through to them while the preferred
+ * server is saturated. Must be called with the pipeline lock held.
+ */
+static netchunk_error_t download_submit_next(download_pipeline_t* pipeline, download_slot_t* slot)
+{
+    netchunk_chunk_t* chunk = &slot->chunk;
+    int candidates[NETCHUNK_MAX_CHUNK_LOCATIONS];
+    int candidate_count = 0;
+
+    if (pipeline->error != NETCHUNK_SUCCESS) {
+        return NETCHUNK_ERROR_DOWNLOAD_FAILED;
+    }
+
+    for (int i = 0; i < chunk->location_count; i++) {
+        int loc_idx = (int)((chunk->sequence_number + (uint32_t)i) % (uint32_t)chunk->location_count);
+        int server_idx = find_server_index(pipeline->context, chunk->locations[loc_idx].server_id);
+        if (server_idx >= 0 && !slot->tried[server_idx]) {
+            candidates[candidate_count++] = server_idx;
+        }
+    }
+
+    if (candidate_count == 0) {
+        return NETCHUNK_ERROR_DOWNLOAD_FAILED;
+    }
+    size_t stored_size = netchunk_chunk_stored_size(chunk);
+    netchunk_ftp_engine_rank_servers(pipeline->context->ftp_context->engine, candidates, candidate_count, stored_size);
+    demote_unavailable_servers(pipeline->context, candidates, candidate_count);
+
+    netchunk_ftp_transfer_cleanup(&slot->transfer);
+    netchunk_error_t error = netchunk_ftp_transfer_init_download(&slot->transfer, candidates[0],
+        slot->remote_path, stored_size, download_transfer_done, slot);
+    if (error == NETCHUNK_SUCCESS) {
+        error = netchunk_ftp_transfer_set_alternates(&slot->transfer, candidates + 1, candidate_count - 1);
+    }
+    if (error == NETCHUNK_SUCCESS) {
+        error = netchunk_ftp_engine_submit(pipeline->context->ftp_context->engine, &slot->transfer);
+    }
+
+    return error;
+}
+
+/**
+ * @brief Transfer completion: queue the buffer for verification or try another replica
+ *
+ * Runs on the engine thread.
+ */
+static void download_transfer_done(netchunk_ftp_transfer_t* transfer, void* userdata)
+{
+    download_slot_t* slot = (download_slot_t*)userdata;
+    download_pipeline_t* pipeline = slot->pipeline;
+
+    pthread_mutex_lock(&pipeline->mutex);
+
+    // The engine may have moved the fetch to an alternate replica
+    slot->tried[transfer->server_index] = true;
+
+    if (transfer->result == NETCHUNK_SUCCESS) {
+        pipeline->retries += (uint32_t)(transfer->attempts - 1);
+        if (transfer->hedged) {
+            pipeline->hedged++;
+        }
+        download_queue_verify(pipeline, slot);
+    } else {
+        pipeline->retries += (uint32_t)transfer->attempts;
+        netchunk_error_t error = download_submit_next(pipeline, slot);
+        if (error == NETCHUNK_SUCCESS) {
+            netchunk_metrics_add(pipeline->context->metrics, NETCHUNK_METRICS_RETRIES, 1);
+        } else {
+            download_release_slot(pipeline, slot, error);
+        }
+    }
+
+    pthread_mutex_unlock(&pipeline->mutex);
+}
+
+/**
+ * @brief Verifier: hash fetched chunks and write them at their offsets
+ *
+ * With a multi-buffer hash backend, several queued chunks are taken at once
+ * and hashed in a single batch. Compressed chunks are decoded first, so the
+ * hash, the output file and the chunk cache all see raw bytes. Cached
+ * chunks are read from the local chunk cache, which verifies them itself;
+ * if that fails they are fetched instead.
+ */
+static void* download_verifier(void* arg)
+{
+    download_pipeline_t* pipeline = (download_pipeline_t*)arg;
+
+    pthread_mutex_lock(&pipeline->mutex);
+    for (;;) {
+        while (!pipeline->verify_head && !pipeline->shutdown) {
+            pthread_cond_wait(&pipeline->verify_ready, &pipeline->mutex);
+        }
+        if (!pipeline->verify_head) {
+            break;
+        }
+
+        download_slot_t* batch[NETCHUNK_SHA256_MAX_LANES];
+        size_t batch_count = 0;
+        while (pipeline->verify_head && batch_count < pipeline->verify_batch) {
+            download_slot_t* slot = pipeline->verify_head;
+            pipeline->verify_head = slot->next;
+            batch[batch_count++] = slot;
+        }
+        if (!pipeline->verify_head) {
+            pipeline->verify_tail = NULL;
+        }
+        pthread_mutex_unlock(&pipeline->mutex);
+
+        // Verify the engine's buffers in place rather than copying them
+        const netchunk_chunk_t* hashed[NETCHUNK_SHA256_MAX_LANES];
+        size_t hashed_index[NETCHUNK_SHA256_MAX_LANES];
+        netchunk_error_t hash_results[NETCHUNK_SHA256_MAX_LANES];
+        netchunk_error_t errors[NETCHUNK_SHA256_MAX_LANES];
+        bool cache_missed[NETCHUNK_SHA256_MAX_LANES];
+        uint8_t* decoded[NETCHUNK_SHA256_MAX_LANES]; // Raw bytes of compressed or encrypted chunks
+        netchunk_compression_t codecs[NETCHUNK_SHA256_MAX_LANES];
+        uint8_t key_ids[NETCHUNK_SHA256_MAX_LANES][NETCHUNK_KEY_ID_LENGTH];
+        size_t hashed_count = 0;
+        netchunk_disk_cache_t* chunk_cache = pipeline->context->chunk_cache;
+
+        for (size_t i = 0; i < batch_count; i++) {
+            netchunk_chunk_t* chunk = &batch[i]->chunk;
+            errors[i] = NETCHUNK_ERROR_CHUNK_INTEGRITY;
+            cache_missed[i] = false;
+            decoded[i] = NULL;
+            codecs[i] = chunk->codec;
+            memcpy(key_ids[i], chunk->key_id, NETCHUNK_KEY_ID_LENGTH);
+            if (batch[i]->from_cache) {
+                uint8_t* data = NULL;
+                if (netchunk_disk_cache_get(chunk_cache, chunk->hash, chunk->size, &data) == NETCHUNK_SUCCESS) {
+                    errors[i] = download_write_chunk(pipeline, data, chunk);
+                    free(data);
+                } else {
+                    cache_missed[i] = true;
+                }
+            } else if (batch[i]->transfer.buffer.size == netchunk_chunk_stored_size(chunk)) {
+                chunk->data = batch[i]->transfer.buffer.data;
+                if (netchunk_chunk_is_encoded(chunk)) {
+                    // Until the batch is written the chunk stands for its raw bytes
+                    decoded[i] = malloc(chunk->size);
+                    if (!decoded[i]) {
+                        errors[i] = NETCHUNK_ERROR_OUT_OF_MEMORY;
+                        chunk->data = NULL;
+                        continue;
+                    }
+                    uint64_t decode_start = netchunk_metrics_start(pipeline->context->metrics);
+                    errors[i] = netchunk_chunk_decode(chunk, decoded[i]);
+                    netchunk_metrics_record(pipeline->context->metrics, NETCHUNK_METRICS_DECODE, decode_start);
+                    if (errors[i] != NETCHUNK_SUCCESS) {
+                        chunk->data = NULL;
+                        continue;
+                    }
+                    chunk->data = decoded[i];
+                    chunk->codec = NETCHUNK_COMPRESSION_NONE;
+                    memset(chunk->key_id, 0, NETCHUNK_KEY_ID_LENGTH);
+                }
+                hashed[hashed_count] = chunk;
+                hashed_index[hashed_count++] = i;
+            }
+        }
+
+        if (hashed_count > 0) {
+            uint64_t verify_start = netchunk_metrics_start(pipeline->context->metrics);
+            netchunk_error_t error = netchunk_chunk_verify_batch(hashed, hashed_count, hash_results);
+            netchunk_metrics_record(pipeline->context->metrics, NETCHUNK_METRICS_VERIFY, verify_start);
+            for (size_t j = 0; j < hashed_count; j++) {
+                errors[hashed_index[j]] = (error == NETCHUNK_SUCCESS) ? hash_results[j] : error;
+            }
+        }
+
+        for (size_t i = 0; i < batch_count; i++) {
+            netchunk_chunk_t* chunk = &batch[i]->chunk;
+            if (batch[i]->from_cache) {
+                continue;
+            }
+            if (errors[i] == NETCHUNK_SUCCESS) {
+                errors[i] = download_write_chunk(pipeline, chunk->data, chunk);
+            }
+            if (errors[i] == NETCHUNK_SUCCESS && chunk_cache) {
+                // Best effort: a full or read-only cache must not fail the download
+                netchunk_disk_cache_put(chunk_cache, chunk->hash, chunk->data, chunk->size);
+            }
+            chunk->data = NULL;
+            chunk->codec = codecs[i];
+            memcpy(chunk->key_id, key_ids[i], NETCHUNK_KEY_ID_LENGTH);
+            free(decoded[i]);
+        }
+
+        pthread_mutex_lock(&pipeline->mutex);
+
+        for (size_t i = 0; i < batch_count; i++) {
+            download_slot_t* slot = batch[i];
+
+            if (slot->from_cache) {
+                slot->from_cache = false;
+                if (!cache_missed[i]) {
+                    if (errors[i] == NETCHUNK_SUCCESS) {
+                        pipeline->cache_hits++;
+                        pipeline->bytes_from_cache += slot->chunk.size;
+                        netchunk_metrics_add(pipeline->context->metrics, NETCHUNK_METRICS_CACHE_HITS, 1);
+                    }
+                    download_release_slot(pipeline, slot, errors[i]);
+                    continue;
+                }
+
+                // Evicted or damaged since it was looked up: fetch it after all
+                pipeline->cache_misses++;
+                netchunk_metrics_add(pipeline->context->metrics, NETCHUNK_METRICS_CACHE_MISSES, 1);
+                netchunk_error_t error = download_submit_next(pipeline, slot);
+                if (error != NETCHUNK_SUCCESS) {
+                    download_release_slot(pipeline, slot, error);
+                }
+                continue;
+            }
+
+            // Local write failures and missing keys will not improve with another replica
+            if (errors[i] == NETCHUNK_SUCCESS || errors[i] == NETCHUNK_ERROR_FILE_ACCESS
+                || errors[i] == NETCHUNK_ERROR_CRYPTO) {
+                download_release_slot(pipeline, slot, errors[i]);
+                continue;
+            }
+
+            // Corrupt replica: move on to the next location
+            pipeline->retries++;
+            netchunk_metrics_add(pipeline->context->metrics, NETCHUNK_METRICS_RETRIES, 1);
+            netchunk_error_t error = download_submit_next(pipeline, slot);
+            if (error != NETCHUNK_SUCCESS) {
+                download_release_slot(pipeline, slot, error);
+            }
+        }
+    }
+    pthread_mutex_unlock(&pipeline->mutex);
+
+    return NULL;
+}
+
+/**
+ * @brief Manifest of a file read through netchunk_read_range(), shared by concurrent reads
+ */
+typedef struct read_manifest {
+    netchunk_file_manifest_t manifest;
+    int refs; // Open-file slot plus reads in progress
+} read_manifest_t;
+
+/**
+ * @brief Recently read file: its manifest and access pattern
+ */
+typedef struct read_file {
+    char name[NETCHUNK_MAX_PATH_LEN];
+    read_manifest_t* manifest; // NULL if the slot is unused
+    time_t loaded_at; // When the manifest was downloaded
+    uint64_t last_used; // Read sequence number, for slot replacement
+    uint64_t last_end; // Offset just past the previous read
+    uint32_t window; // Readahead window in chunks, 0 until reads are sequential
+} read_file_t;
+
+/**
+ * @brief One chunk fetch in flight for ranged reads
+ *
+ * Readers needing a chunk that is already being fetched wait for it
+ * instead of fetching it again. The last one to see it done frees it;
+ * readahead fetches nobody waits for are freed by their completion.
+ */
+typedef struct read_fetch {
+    netchunk_read_state_t* state;
+    netchunk_chunk_t chunk; // Private copy of the manifest entry, no data
+    char remote_path[NETCHUNK_MAX_PATH_LEN];
+    netchunk_ftp_transfer_t transfer;
+    bool tried[NETCHUNK_MAX_SERVERS]; // Servers already fetched from
+    bool done;
+    netchunk_error_t error;
+    netchunk_chunk_cache_entry_t* entry; // Pinned cache entry once fetched
+    int waiters; // Readers waiting for this fetch
+    struct read_fetch* next; // Pending list link
+} read_fetch_t;
+
+/**
+ * @brief Shared state of ranged reads
+ *
+ * Fetched chunks go straight into the cache unverified; the reader that
+ * first copies out of a chunk hashes it outside the lock, so hashing stays
+ * off the engine's event loop and readahead nobody reads is never hashed.
+ * Chunks in the local chunk cache are read from there rather than fetched,
+ * and fetched chunks are added to it once verified.
+ */
+struct netchunk_read_state {
+    netchunk_context_t* context;
+    netchunk_chunk_cache_t cache;
+    read_file_t files[NETCHUNK_READ_OPEN_FILES];
+    uint64_t read_sequence; // Reads started
+    read_fetch_t* pending; // Fetches not yet completed
+    size_t pending_bytes; // Chunk bytes of those fetches
+    pthread_mutex_t mutex;
+    pthread_cond_t fetched; // Broadcast when a waited-for fetch completes
+};
+
+/**
+ * @brief Create the ranged read state of a context
+ */
+static netchunk_error_t create_read_state(netchunk_context_t* context)
+{
+    netchunk_read_state_t* state = calloc(1, sizeof(netchunk_read_state_t));
+    if (!state) {
+        return NETCHUNK_ERROR_OUT_OF_MEMORY;
+    }
+
+    netchunk_error_t error = netchunk_chunk_cache_init(&state->cache, context->config->read_cache_size);
+    if (error != NETCHUNK_SUCCESS) {
+        free(state);
+        return error;
+    }
+
+    state->context = context;
+    pthread_mutex_init(&state->mutex, NULL);
+    pthread_cond_init(&state->fetched, NULL);
+    context->read_state = state;
+    return NETCHUNK_SUCCESS;
+}
+
+/**
+ * @brief Drop one reference to a shared manifest
+ *
+ * Must be called with the read state lock held.
+ */
+static void read_manifest_unref(read_manifest_t* manifest)
+{
+    if (manifest && --manifest->refs == 0) {
+        netchunk_manifest_cleanup(&manifest->manifest);
+        free(manifest);
+    }
+}
+
+/**
+ * @brief Free the ranged read state; no reads or fetches may be in flight
+ */
+static void destroy_read_state(netchunk_context_t* context)
+{
+    netchunk_read_state_t* state = context->read_state;
+    if (!state) {
+        return;
+    }
+
+    for (int i = 0; i < NETCHUNK_READ_OPEN_FILES; i++) {
+        read_manifest_unref(state->files[i].manifest);
+    }
+    netchunk_chunk_cache_cleanup(&state->cache);
+    pthread_mutex_destroy(&state->mutex);
+    pthread_cond_destroy(&state->fetched);
+    free(state);
+    context->read_state = NULL;
+}
+
+/**
+ * @brief Open the persistent chunk cache under local_storage_path if it is enabled
+ */
+static netchunk_error_t open_chunk_cache(netchunk_context_t* context)
+{
+    if (context->config->chunk_cache_size == 0) {
+        return NETCHUNK_SUCCESS;
+    }
+
+    char directory[NETCHUNK_MAX_PATH_LEN];
+    int written = snprintf(directory, sizeof(directory), "%s/%s",
+        context->config->local_storage_path, NETCHUNK_DISK_CACHE_DIRECTORY);
+    if (written < 0 || (size_t)written >= sizeof(directory)) {
+        return NETCHUNK_ERROR_CONFIG;
+    }
+
+    netchunk_disk_cache_t* cache = calloc(1, sizeof(netchunk_disk_cache_t));
+    if (!cache) {
+        return NETCHUNK_ERROR_OUT_OF_MEMORY;
+    }
+
+    netchunk_error_t error = netchunk_disk_cache_init(cache, directory, context->config->chunk_cache_size);
+    if (error != NETCHUNK_SUCCESS) {
+        free(cache);
+        return error;
+    }
+
+    context->chunk_cache = cache;
+    return NETCHUNK_SUCCESS;
+}
+
+/**
+ * @brief Close the persistent chunk cache; its files stay for the next run
+ */
+static void close_chunk_cache(netchunk_context_t* context)
+{
+    if (context->chunk_cache) {
+        netchunk_disk_cache_cleanup(context->chunk_cache);
+        free(context->chunk_cache);
+        context->chunk_cache = NULL;
+    }
+}
+
+/**
+ * @brief Start the background delete queue if background_delete is set
+ */
+static netchunk_error_t open_delete_queue(netchunk_context_t* context)
+{
+    if (!context->config->background_delete) {
+        return NETCHUNK_SUCCESS;
+    }
+
+    netchunk_delete_queue_t* queue = calloc(1, sizeof(netchunk_delete_queue_t));
+    if (!queue) {
+        return NETCHUNK_ERROR_OUT_OF_MEMORY;
+    }
+
+    netchunk_error_t error = netchunk_delete_queue_init(queue, context->ftp_context);
+    if (error == NETCHUNK_SUCCESS) {
+        error = netchunk_delete_queue_start(queue);
+        if (error != NETCHUNK_SUCCESS) {
+            netchunk_delete_queue_cleanup(queue);
+        }
+    }
+    if (error != NETCHUNK_SUCCESS) {
+        free(queue);
+        return error;
+    }
+
+    context->delete_queue = queue;
+    return NETCHUNK_SUCCESS;
+}
+
+/**
+ * @brief Send the removals still queued and stop the delete queue
+ */
+static void close_delete_queue(netchunk_context_t* context)
+{
+    if (context->delete_queue) {
+        netchunk_delete_queue_flush(context->delete_queue);
+        netchunk_delete_queue_cleanup(context->delete_queue);
+        free(context->delete_queue);
+        context->delete_queue = NULL;
+    }
+}
+
+/**
+ * @brief Start the background health monitor if health_monitoring_enabled is set
+ */
+static netchunk_error_t open_health_monitor(netchunk_context_t* context)
+{
+    if (!context->config->health_monitoring_enabled || context->config->health_check_interval <= 0) {
+        return NETCHUNK_SUCCESS;
+    }
+
+    netchunk_health_monitor_t* monitor = calloc(1, sizeof(netchunk_health_monitor_t));
+    if (!monitor) {
+        return NETCHUNK_ERROR_OUT_OF_MEMORY;
+    }
+
+    netchunk_error_t error = netchunk_health_monitor_init(monitor, context->config, context->ftp_context);
+    if (error == NETCHUNK_SUCCESS) {
+        error = netchunk_health_monitor_start(monitor);
+        if (error != NETCHUNK_SUCCESS) {
+            netchunk_health_monitor_cleanup(monitor);
+        }
+    }
+    if (error != NETCHUNK_SUCCESS) {
+        free(monitor);
+        return error;
+    }
+
+    // Repairs reach the monitor through the FTP context they are given
+    context->health_monitor = monitor;
+    context->ftp_context->health_monitor = monitor;
+    return NETCHUNK_SUCCESS;
+}
+
+/**
+ * @brief Stop the health monitor, waiting for a probe still in progress
+ */
+static void close_health_monitor(netchunk_context_t* context)
+{
+    if (context->health_monitor) {
+        if (context->ftp_context) {
+            context->ftp_context->health_monitor = NULL;
+        }
+        netchunk_health_monitor_cleanup(context->health_monitor);
+        free(context->health_monitor);
+        context->health_monitor = NULL;
+    }
+}
+
+/**
+ * @brief Start collecting metrics if performance_logging is set
+ *
+ * The FTP context and the transfer engine record into the same collector.
+ */
+static netchunk_error_t open_metrics(netchunk_context_t* context)
+{
+    if (!context->config->performance_logging) {
+        return NETCHUNK_SUCCESS;
+    }
+
+    netchunk_metrics_t* metrics = calloc(1, sizeof(netchunk_metrics_t));
+    if (!metrics) {
+        return NETCHUNK_ERROR_OUT_OF_MEMORY;
+    }
+
+    netchunk_error_t error = netchunk_metrics_init(metrics, context->config);
+    if (error != NETCHUNK_SUCCESS) {
+        free(metrics);
+        return error;
+    }
+
+    context->metrics = metrics;
+    context->ftp_context->metrics = metrics;
+    context->ftp_context->engine->metrics = metrics;
+    return NETCHUNK_SUCCESS;
+}
+
+/**
+ * @brief Write the final metrics and stop collecting
+ *
+ * Called once the engine has stopped, so no transfer records any more.
+ */
+static void close_metrics(netchunk_context_t* context)
+{
+    if (context->metrics) {
+        // Best effort, like the dumps after operations
+        netchunk_metrics_dump(context->metrics);
+        netchunk_metrics_cleanup(context->metrics);
+        free(context->metrics);
+        context->metrics = NULL;
+    }
+}
+
+/**
+ * @brief Bookkeeping after a public file operation
+ *
+ * Metrics are dumped at most every NETCHUNK_METRICS_DUMP_INTERVAL seconds,
+ * so a daemon keeps its file fresh without writing it per request. A
+ * failed dump never fails the operation.
+ */
+static void finish_operation(netchunk_context_t* context)
+{
+    netchunk_metrics_dump_if_due(context->metrics);
+}
+
+/**
+ * @brief Forget the manifest kept for a file after this context changed it
+ */
+static void forget_open_file(netchunk_context_t* context, const char* remote_name)
+{
+    netchunk_read_state_t* state = context->read_state;
+    if (!state) {
+        return;
+    }
+
+    pthread_mutex_lock(&state->mutex);
+    for (int i = 0; i < NETCHUNK_READ_OPEN_FILES; i++) {
+        read_file_t* file = &state->files[i];
+        if (file->manifest && strcmp(file->name, remote_name) == 0) {
+            read_manifest_unref(file->manifest);
+            memset(file, 0, sizeof(read_file_t));
+        }
+    }
+    pthread_mutex_unlock(&state->mutex);
+}
+
+/**
+ * @brief Get the manifest of a file being read and update its readahead window
+ *
+ * A kept manifest is reused while younger than catalog_sync_interval.
+ * The returned manifest holds a reference for the caller. A read starting
+ * where the previous one ended opens or doubles the window; any other read
+ * closes it.
+ */
+static netchunk_error_t read_open_file(netchunk_read_state_t* state,
+    const char* remote_name,
+    uint64_t offset,
+    uint64_t end,
+    read_manifest_t** manifest_out,
+    uint32_t* window_out)
+{
+    netchunk_context_t* context = state->context;
+    read_manifest_t* fresh = NULL;
+
+    if (strlen(remote_name) >= NETCHUNK_MAX_PATH_LEN) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    for (;;) {
+        pthread_mutex_lock(&state->mutex);
+        time_t now = time(NULL);
+
+        read_file_t* file = NULL;
+        read_file_t* victim = NULL;
+        for (int i = 0; i < NETCHUNK_READ_OPEN_FILES; i++) {
+            read_file_t* candidate = &state->files[i];
+            if (candidate->manifest && strcmp(candidate->name, remote_name) == 0) {
+                file = candidate;
+                break;
+            }
+            if (!victim || !candidate->manifest
+                || (victim->manifest && candidate->last_used < victim->last_used)) {
+                victim = candidate;
+            }
+        }
+
+        bool stale = !file || now - file->loaded_at >= context->config->catalog_sync_interval;
+        if (stale && fresh) {
+            // Install the manifest just downloaded, keeping the access pattern
+            if (!file) {
+                file = victim;
+                read_manifest_unref(file->manifest);
+                memset(file, 0, sizeof(read_file_t));
+                strcpy(file->name, remote_name);
+            } else {
+                read_manifest_unref(file->manifest);
+            }
+            file->manifest = fresh;
+            file->loaded_at = now;
+            fresh = NULL;
+            stale = false;
+        }
+
+        if (!stale) {
+            if (fresh) {
+                // Another read installed a manifest meanwhile
+                read_manifest_unref(fresh);
+                fresh = NULL;
+            }
+            if (offset > 0 && offset == file->last_end) {
+                file->window = file->window == 0 ? 1 : file->window * 2;
+                if (file->window > NETCHUNK_READ_AHEAD_MAX_CHUNKS) {
+                    file->window = NETCHUNK_READ_AHEAD_MAX_CHUNKS;
+                }
+            } else {
+                file->window = 0;
+            }
+            file->last_end = end;
+            file->last_used = ++state->read_sequence;
+
+            file->manifest->refs++;
+            *manifest_out = file->manifest;
+            *window_out = file->window;
+            pthread_mutex_unlock(&state->mutex);
+            return NETCHUNK_SUCCESS;
+        }
+        pthread_mutex_unlock(&state->mutex);
+
+        // Download outside the lock; the slot's reference is taken above
+        fresh = calloc(1, sizeof(read_manifest_t));
+        if (!fresh) {
+            return NETCHUNK_ERROR_OUT_OF_MEMORY;
+        }
+        netchunk_error_t error = netchunk_ftp_download_manifest(context->ftp_context, context->config,
+            remote_name, &fresh->manifest);
+        if (error != NETCHUNK_SUCCESS) {
+            free(fresh);
+            return error;
+        }
+        fresh->refs = 1;
+    }
+}
+
+/**
+ * @brief Index of the chunk holding a file offset, by binary search
+ */
+static uint32_t read_find_chunk(const netchunk_file_manifest_t* manifest, uint64_t offset)
+{
+    uint32_t low = 0;
+    uint32_t high = manifest->chunk_count;
+    while (high - low > 1) {
+        uint32_t mid = low + (high - low) / 2;
+        if (manifest->chunks[mid].offset <= offset) {
+            low = mid;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+static void read_fetch_done(netchunk_ftp_transfer_t* transfer, void* userdata);
+
+/**
+ * @brief Submit a ranged read fetch to its untried replicas
+ *
+ * Same replica order as downloads. Must be called with the read state
+ * lock held.
+ */
+static netchunk_error_t read_fetch_submit(netchunk_read_state_t* state, read_fetch_t* fetch)
+{
+    netchunk_chunk_t* chunk = &fetch->chunk;
+    int candidates[NETCHUNK_MAX_CHUNK_LOCATIONS];
+    int candidate_count = 0;
+
+    for (int i = 0; i < chunk->location_count; i++) {
+        int loc_idx = (int)((chunk->sequence_number + (uint32_t)i) % (uint32_t)chunk->location_count);
+        int server_idx = find_server_index(state->context, chunk->locations[loc_idx].server_id);
+        if (server_idx >= 0 && !fetch->tried[server_idx]) {
+            candidates[candidate_count++] = server_idx;
+        }
+    }
+
+    if (candidate_count == 0) {
+        return NETCHUNK_ERROR_DOWNLOAD_FAILED;
+    }
+    size_t stored_size = netchunk_chunk_stored_size(chunk);
+    netchunk_ftp_engine_rank_servers(state->context->ftp_context->engine, candidates, candidate_count, stored_size);
+    demote_unavailable_servers(state->context, candidates, candidate_count);
+
+    netchunk_ftp_transfer_cleanup(&fetch->transfer);
+    netchunk_error_t error = netchunk_ftp_transfer_init_download(&fetch->transfer, candidates[0],
+        fetch->remote_path, stored_size, read_fetch_done, fetch);
+    if (error == NETCHUNK_SUCCESS) {
+        error = netchunk_ftp_transfer_set_alternates(&fetch->transfer, candidates + 1, candidate_count - 1);
+    }
+    if (error == NETCHUNK_SUCCESS) {
+        error = netchunk_ftp_engine_submit(state->context->ftp_context->engine, &fetch->transfer);
+    }
+
+    return error;
+}
+
+/**
+ * @brief Free a completed fetch and its pin on the cache entry
+ *
+ * Must be called with the read state lock held.
+ */
+static void read_fetch_free(netchunk_read_state_t* state, read_fetch_t* fetch)
+{
+    if (fetch->entry) {
+        netchunk_chunk_cache_release(&state->cache, fetch->entry);
+    }
+    netchunk_ftp_transfer_cleanup(&fetch->transfer);
+    free(fetch);
+}
+
+/**
+ * @brief Complete a fetch: take it off the pending list and wake its waiters
+ *
+ * Must be called with the read state lock held.
+ */
+static void read_fetch_finish(netchunk_read_state_t* state, read_fetch_t* fetch, netchunk_error_t error)
+{
+    read_fetch_t** link = &state->pending;
+    while (*link && *link != fetch) {
+        link = &(*link)->next;
+    }
+    if (*link) {
+        *link = fetch->next;
+    }
+    state->pending_bytes -= fetch->chunk.size;
+
+    fetch->done = true;
+    fetch->error = error;
+    if (fetch->waiters == 0) {
+        read_fetch_free(state, fetch);
+    } else {
+        pthread_cond_broadcast(&state->fetched);
+    }
+}
+
+/**
+ * @brief Transfer completion: cache the chunk or try another replica
+ *
+ * Runs on the engine thread. The engine's buffer moves into the cache
+ * without a copy; compressed or encrypted chunks are decoded first, outside
+ * the lock, since the cache holds raw bytes.
+ */
+static void read_fetch_done(netchunk_ftp_transfer_t* transfer, void* userdata)
+{
+    read_fetch_t* fetch = (read_fetch_t*)userdata;
+    netchunk_read_state_t* state = fetch->state;
+
+    uint8_t* data = NULL;
+    if (transfer->result == NETCHUNK_SUCCESS && transfer->buffer.size == netchunk_chunk_stored_size(&fetch->chunk)) {
+        if (!netchunk_chunk_is_encoded(&fetch->chunk)) {
+            data = transfer->buffer.data;
+            transfer->buffer.data = NULL;
+            transfer->buffer.size = 0;
+            transfer->buffer.capacity = 0;
+        } else {
+            netchunk_chunk_t stored = fetch->chunk;
+            stored.data = transfer->buffer.data;
+
+            // Undecodable data is treated like a failed transfer
+            uint64_t start_ns = netchunk_metrics_start(state->context->metrics);
+            data = malloc(fetch->chunk.size);
+            if (data && netchunk_chunk_decode(&stored, data) != NETCHUNK_SUCCESS) {
+                free(data);
+                data = NULL;
+            }
+            netchunk_metrics_record(state->context->metrics, NETCHUNK_METRICS_DECODE, start_ns);
+        }
+    }
+
+    pthread_mutex_lock(&state->mutex);
+
+    // The engine may have moved the fetch to an alternate replica
+    fetch->tried[transfer->server_index] = true;
+
+    if (data) {
+
+        fetch->entry = netchunk_chunk_cache_insert(&state->cache, fetch->chunk.hash, data,
+            fetch->chunk.size, transfer->server_index, false);
+        read_fetch_finish(state, fetch, fetch->entry ? NETCHUNK_SUCCESS : NETCHUNK_ERROR_OUT_OF_MEMORY);
+    } else if (read_fetch_submit(state, fetch) != NETCHUNK_SUCCESS) {
+        read_fetch_finish(state, fetch, NETCHUNK_ERROR_DOWNLOAD_FAILED);
+    }
+
+    pthread_mutex_unlock(&state->mutex);
+}
+
+/**
+ * @brief Find the pending fetch of a chunk
+ *
+ * Must be called with the read state lock held.
+ */
+static read_fetch_t* read_find_fetch(netchunk_read_state_t* state, const uint8_t* hash)
+{
+    for (read_fetch_t* fetch = state->pending; fetch; fetch = fetch->next) {
+        if (memcmp(fetch->chunk.hash, hash, NETCHUNK_HASH_LENGTH) == 0) {
+            return fetch;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Start fetching a chunk, skipping the servers in tried (can be NULL)
+ *
+ * Must be called with the read state lock held.
+ */
+static netchunk_error_t read_start_fetch(netchunk_read_state_t* state,
+    const netchunk_chunk_t* chunk,
+    const bool* tried,
+    read_fetch_t** fetch_out)
+{
+    read_fetch_t* fetch = calloc(1, sizeof(read_fetch_t));
+    if (!fetch) {
+        return NETCHUNK_ERROR_OUT_OF_MEMORY;
+    }
+
+    fetch->state = state;
+    fetch->chunk = *chunk;
+    fetch->chunk.data = NULL;
+    fetch->chunk.data_owned = false;
+    if (tried) {
+        memcpy(fetch->tried, tried, sizeof(fetch->tried));
+    }
+
+    netchunk_error_t error = netchunk_ftp_chunk_path(&fetch->chunk, fetch->remote_path, sizeof(fetch->remote_path));
+    if (error == NETCHUNK_SUCCESS) {
+        error = read_fetch_submit(state, fetch);
+    }
+    if (error != NETCHUNK_SUCCESS) {
+        netchunk_ftp_transfer_cleanup(&fetch->transfer);
+        free(fetch);
+        return error;
+    }
+
+    fetch->next = state->pending;
+    state->pending = fetch;
+    state->pending_bytes += chunk->size;
+    if (fetch_out) {
+        *fetch_out = fetch;
+    }
+    return NETCHUNK_SUCCESS;
+}
+
+/**
+ * @brief Start fetches for chunks first..last that are neither cached nor pending
+ *
+ * Stops once the pending fetches would exceed budget bytes, but always
+ * starts one when nothing is pending. Failures are left to the reader that
+ * needs the chunk. Must be called with the read state lock held.
+ */
+static void read_prefetch(netchunk_read_state_t* state,
+    const netchunk_file_manifest_t* manifest,
+    uint32_t first,
+    uint32_t last,
+    size_t budget)
+{
+    netchunk_disk_cache_t* chunk_cache = state->context->chunk_cache;
+
+    for (uint32_t i = first; i <= last && i < manifest->chunk_count; i++) {
+        const netchunk_chunk_t* chunk = &manifest->chunks[i];
+        if (netchunk_chunk_cache_contains(&state->cache, chunk->hash) || read_find_fetch(state, chunk->hash)) {
+            continue;
+        }
+        if (state->pending_bytes > 0 && state->pending_bytes + chunk->size > budget) {
+            break;
+        }
+        // Chunks cached on disk are read when needed
+        if (netchunk_disk_cache_lookup(chunk_cache, chunk->hash)) {
+            continue;
+        }
+        if (read_start_fetch(state, chunk, NULL, NULL) != NETCHUNK_SUCCESS) {
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Get a pinned cache entry for a chunk, fetching it if needed
+ *
+ * Must be called with the read state lock held; drops it while reading the
+ * local chunk cache and while waiting for the fetch.
+ */
+static netchunk_error_t read_get_chunk(netchunk_read_state_t* state,
+    const netchunk_chunk_t* chunk,
+    const bool* tried,
+    netchunk_chunk_cache_entry_t** entry_out)
+{
+    netchunk_metrics_t* metrics = state->context->metrics;
+    netchunk_chunk_cache_entry_t* entry = netchunk_chunk_cache_acquire(&state->cache, chunk->hash);
+    if (entry) {
+        netchunk_metrics_add(metrics, NETCHUNK_METRICS_CACHE_HITS, 1);
+        *entry_out = entry;
+        return NETCHUNK_SUCCESS;
+    }
+
+    read_fetch_t* fetch = read_find_fetch(state, chunk->hash);
+    netchunk_disk_cache_t* chunk_cache = state->context->chunk_cache;
+    if (!fetch && chunk_cache && netchunk_disk_cache_lookup(chunk_cache, chunk->hash)) {
+        uint8_t* data = NULL;
+        pthread_mutex_unlock(&state->mutex);
+        netchunk_error_t error = netchunk_disk_cache_get(chunk_cache, chunk->hash, chunk->size, &data);
+        pthread_mutex_lock(&state->mutex);
+
+        if (error == NETCHUNK_SUCCESS) {
+            // Already verified by the disk cache
+            entry = netchunk_chunk_cache_insert(&state->cache, chunk->hash, data, chunk->size, -1, true);
+            if (!entry) {
+                return NETCHUNK_ERROR_OUT_OF_MEMORY;
+            }
+            netchunk_metrics_add(metrics, NETCHUNK_METRICS_CACHE_HITS, 1);
+            *entry_out = entry;
+            return NETCHUNK_SUCCESS;
+        }
+
+        // Another reader may have started a fetch meanwhile
+        fetch = read_find_fetch(state, chunk->hash);
+    }
+    if (!fetch) {
+        netchunk_error_t error = read_start_fetch(state, chunk, tried, &fetch);
+        if (error != NETCHUNK_SUCCESS) {
+            return error;
+        }
+        netchunk_metrics_add(metrics, NETCHUNK_METRICS_CACHE_MISSES, 1);
+    }
+
+    fetch->waiters++;
+    while (!fetch->done) {
+        pthread_cond_wait(&state->fetched, &state->mutex);
+    }
+    fetch->waiters--;
+
+    netchunk_error_t error = fetch->error;
+    if (error == NETCHUNK_SUCCESS) {
+        netchunk_chunk_cache_pin(&state->cache, fetch->entry);
+        *entry_out = fetch->entry;
+    }
+    if (fetch->waiters == 0) {
+        read_fetch_free(state, fetch);
+    }
+    return error;
+}
+
+/**
+ * @brief Copy part of a chunk out of the cache, verifying it on first use
+ *
+ * A chunk failing verification is dropped from the cache and fetched again
+ * from a replica other than the one it came from.
+ */
+static netchunk_error_t read_copy_chunk(netchunk_read_state_t* state,
+    const netchunk_chunk_t* chunk,
+    uint64_t from,
+    size_t length,
+    uint8_t* out)
+{
+    bool tried[NETCHUNK_MAX_SERVERS] = { false };
+    netchunk_error_t error = NETCHUNK_ERROR_DOWNLOAD_FAILED;
+
+    for (int attempt = 0; attempt <= chunk->location_count; attempt++) {
+        netchunk_chunk_cache_entry_t* entry = NULL;
+
+        pthread_mutex_lock(&state->mutex);
+        error = read_get_chunk(state, chunk, attempt > 0 ? tried : NULL, &entry);
+        bool verified = entry && entry->verified;
+        pthread_mutex_unlock(&state->mutex);
+        if (error != NETCHUNK_SUCCESS) {
+            return error;
+        }
+
+        // Pinned entries stay put, so hashing and copying need no lock
+        error = NETCHUNK_SUCCESS;
+        if (!verified) {
+            // Cache entries hold raw bytes
+            netchunk_chunk_t check = *chunk;
+            check.data = entry->data;
+            check.codec = NETCHUNK_COMPRESSION_NONE;
+            memset(check.key_id, 0, NETCHUNK_KEY_ID_LENGTH);
+            uint64_t start_ns = netchunk_metrics_start(state->context->metrics);
+            error = entry->size == chunk->size ? netchunk_chunk_verify_integrity(&check) : NETCHUNK_ERROR_CHUNK_INTEGRITY;
+            netchunk_metrics_record(state->context->metrics, NETCHUNK_METRICS_VERIFY, start_ns);
+        }
+        if (error == NETCHUNK_SUCCESS) {
+            memcpy(out, entry->data + from, length);
+            if (!verified && entry->server_index >= 0 && state->context->chunk_cache) {
+                netchunk_disk_cache_put(state->context->chunk_cache, entry->hash, entry->data, entry->size);
+            }
+        }
+
+        pthread_mutex_lock(&state->mutex);
+        if (error == NETCHUNK_SUCCESS) {
+            entry->verified = true;
+        } else {
+            if (entry->server_index >= 0) {
+                tried[entry->server_index] = true;
+            }
+            netchunk_chunk_cache_remove(&state->cache, entry);
+        }
+        netchunk_chunk_cache_release(&state->cache, entry);
+        pthread_mutex_unlock(&state->mutex);
+
+        if (error != NETCHUNK_ERROR_CHUNK_INTEGRITY) {
+            return error;
+        }
+    }
+
+    return error;
+}
+
+/**
+ * @brief Load the key file into the key ring
+ *
+ * Without a key file encrypted files cannot be read, which is only an
+ * error if new chunks are to be encrypted.
+ */
+static netchunk_error_t load_encryption_keys(netchunk_context_t* context)
+{
+    char path[NETCHUNK_MAX_PATH_LEN];
+    netchunk_error_t error = netchunk_config_expand_path(context->config->encryption_key_file, path, sizeof(path));
+    if (error != NETCHUNK_SUCCESS) {
+        return error;
+    }
+
+    error = netchunk_keyring_load_file(path, context->encryption_key_id);
+    if (error == NETCHUNK_ERROR_FILE_NOT_FOUND) {
+        return context->config->encrypt_chunks ? NETCHUNK_ERROR_CONFIG_VALIDATION : NETCHUNK_SUCCESS;
+    }
+    return error;
+}
+
+netchunk_error_t netchunk_init(netchunk_context_t* context, const char* config_path)
+{
+    if (!context) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    // Initialize context to zero
+    memset(context, 0, sizeof(netchunk_context_t));
+
+    // Allocate and initialize configuration
+    context->config = calloc(1, sizeof(netchunk_config_t));
+    if (!context->config) {
+        return NETCHUNK_ERROR_OUT_OF_MEMORY;
+    }
+
+    // Load configuration
+    netchunk_error_t error = netchunk_config_load(context->config, config_path);
+    if (error != NETCHUNK_SUCCESS) {
+        free(context->config);
+        context->config = NULL;
+        return error;
+    }
+
+    // A codec this build lacks would leave uploads unreadable by it
+    if (!netchunk_compress_available(context->config->compression)) {
+        netchunk_config_cleanup(context->config);
+        free(context->config);
+        context->config = NULL;
+        return NETCHUNK_ERROR_CONFIG_VALIDATION;
+    }
+
+    error = load_encryption_keys(context);
+    if (error != NETCHUNK_SUCCESS) {
+        netchunk_config_cleanup(context->config);
+        free(context->config);
+        context->config = NULL;
+        return error;
+    }
+
+    // Initialize FTP context
+    context->ftp_context = calloc(1, sizeof(netchunk_ftp_context_t));
+    if (!context->ftp_context) {
+        netchunk_config_cleanup(context->config);
+        free(context->config);
+        context->config = NULL;
+        return NETCHUNK_ERROR_OUT_OF_MEMORY;
+    }
+
+    error = netchunk_ftp_init(context->ftp_context, context->config);
+    if (error != NETCHUNK_SUCCESS) {
+        free(context->ftp_context);
+        context->ftp_context = NULL;
+        netchunk_config_cleanup(context->config);
+        free(context->config);
+        context->config = NULL;
+        return error;
+    }
+
+    // Created up front so concurrent operations share them without racing
+    error = create_read_state(context);
+    if (error == NETCHUNK_SUCCESS) {
+        error = open_chunk_cache(context);
+    }
+    if (error == NETCHUNK_SUCCESS) {
+        error = open_delete_queue(context);
+    }
+    if (error == NETCHUNK_SUCCESS) {
+        error = open_health_monitor(context);
+    }
+    if (error == NETCHUNK_SUCCESS) {
+        error = open_metrics(context);
+    }
+    if (error != NETCHUNK_SUCCESS) {
+        close_health_monitor(context);
+        close_delete_queue(context);
+        close_chunk_cache(context);
+        destroy_read_state(context);
+        netchunk_ftp_cleanup(context->ftp_context);
+        free(context->ftp_context);
+        context->ftp_context = NULL;
+        netchunk_config_cleanup(context->config);
+        free(context->config);
+        context->config = NULL;
+        return error;
+    }
+
+    context->initialized = true;
+    return NETCHUNK_SUCCESS;
+}
+
+netchunk_error_t netchunk_set_progress_callback(netchunk_context_t* context,
+    netchunk_progress_callback_t callback,
+    void* userdata)
+{
+    if (!context || !context->initialized) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    context->progress_cb = callback;
+    context->progress_userdata = userdata;
+    return NETCHUNK_SUCCESS;
+}
+
+/**
+ * @brief Chunk, replicate and record a file read through an initialized chunker
+ *
+ * Shared by path and stream uploads. Always cleans up the chunker. Uploads
+ * of a local_path are journaled; streams pass NULL and cannot resume.
+ */
+static netchunk_error_t upload_from_chunker(netchunk_context_t* context,
+    netchunk_chunker_context_t* chunker_ctx,
+    const char* local_path,
+    const char* remote_name,
+    netchunk_stats_t* stats)
+{
+    netchunk_error_t error;
+    netchunk_file_manifest_t manifest;
+    upload_pipeline_t pipeline;
+    uint64_t start_ns = netchunk_metrics_now_ns();
+
+    // Initialize stats if provided
+    if (stats) {
+        memset(stats, 0, sizeof(netchunk_stats_t));
+    }
+
+    error = netchunk_chunker_set_mode(chunker_ctx, context->config->chunking_mode);
+    if (error != NETCHUNK_SUCCESS) {
+        netchunk_chunker_cleanup(chunker_ctx);
+        return error;
+    }
+    chunker_ctx->metrics = context->metrics;
+
+    // Zero for streams; the real size is only known once the chunker hits EOF
+    uint64_t file_size = chunker_ctx->total_file_size;
+
+    call_progress_callback(context, "Preparing upload", 0, 1, 0, file_size);
+
+    // Initialize manifest; it only keeps chunk metadata, sized up front
+    error = netchunk_manifest_init(&manifest, remote_name, file_size);
+    if (error == NETCHUNK_SUCCESS && chunker_ctx->total_chunks > 0) {
+        error = netchunk_manifest_reserve_chunks(&manifest, chunker_ctx->total_chunks);
+        if (error != NETCHUNK_SUCCESS) {
+            netchunk_manifest_cleanup(&manifest);
+        }
+    }
+    if (error != NETCHUNK_SUCCESS) {
+        netchunk_chunker_cleanup(chunker_ctx);
+        return error;
+    }
+
+    // Content-addressed uploads consult the index for chunks already stored
+    if (context->config->content_addressed) {
+        error = load_dedup_index(context);
+        if (error != NETCHUNK_SUCCESS) {
+            netchunk_manifest_cleanup(&manifest);
+            netchunk_chunker_cleanup(chunker_ctx);
+            return error;
+        }
+    }
+
+    // Set up the replica fan-out window
+    error = upload_pipeline_init(&pipeline, context, netchunk_chunker_buffer_size(chunker_ctx));
+    if (error != NETCHUNK_SUCCESS) {
+        netchunk_manifest_cleanup(&manifest);
+        netchunk_chunker_cleanup(chunker_ctx);
+        return error;
+    }
+    if (context->config->content_addressed) {
+        pipeline.dedup_index = context->dedup_index;
+    }
+
+    // Pick up where an earlier attempt at the same file stopped
+    netchunk_journal_t journal_storage;
+    netchunk_journal_t* journal = local_path ? begin_upload_journal(context, &journal_storage, local_path, remote_name) : NULL;
+
+    uint32_t next_sequence = 0;
+    uint32_t commit_sequence = 0;
+    uint32_t chunks_committed = 0;
+    uint64_t bytes_processed = 0;
+    bool reading = true;
+    netchunk_error_t result = NETCHUNK_SUCCESS;
+
+    call_progress_callback(context, "Uploading chunks", 0, chunker_ctx->total_chunks, 0, file_size);
+
+    for (;;) {
+        // Read and hash chunks until the in-flight window is full
+        while ((reading || pipeline.parity_pending > 0) && result == NETCHUNK_SUCCESS
+            && next_sequence - commit_sequence < (uint32_t)pipeline.window) {
+            upload_slot_t* slot = &pipeline.slots[next_sequence % (uint32_t)pipeline.window];
+
+            if (!slot->buffer) {
+                slot->buffer = malloc(pipeline.buffer_size + pipeline.trailer_size);
+                if (!slot->buffer) {
+                    result = NETCHUNK_ERROR_OUT_OF_MEMORY;
+                    upload_pipeline_abort(&pipeline);
+                    break;
+                }
+            }
+
+            // A finished stripe's parity goes out before the next stripe is read
+            if (pipeline.parity_pending > 0) {
+                error = upload_stripe_take_parity(&pipeline, slot, chunker_ctx->upload_id);
+                if (error == NETCHUNK_SUCCESS) {
+                    error = upload_pipeline_submit(&pipeline, slot, NULL);
+                }
+                if (error != NETCHUNK_SUCCESS) {
+                    netchunk_chunk_cleanup(&slot->chunk);
+                    result = error;
+                    upload_pipeline_abort(&pipeline);
+                    break;
+                }
+                next_sequence++;
+                continue;
+            }
+
+            error = netchunk_chunker_next_chunk_into(chunker_ctx, &slot->chunk, slot->buffer, pipeline.buffer_size);
+            if (error == NETCHUNK_ERROR_EOF) {
+                reading = false;
+
+                // The last stripe may be short; its missing data counts as zeros
+                if (pipeline.stripe_data_read > 0) {
+                    pipeline.parity_pending = pipeline.parity_shards;
+                }
+                continue;
+            }
+            if (error != NETCHUNK_SUCCESS) {
+                result = error;
+                upload_pipeline_abort(&pipeline);
+                break;
+            }
+
+            if (pipeline.data_shards > 0) {
+                upload_stripe_add_data(&pipeline, slot);
+            }
+
+            error = upload_compress_chunk(&pipeline, slot);
+            if (error != NETCHUNK_SUCCESS) {
+                netchunk_chunk_cleanup(&slot->chunk);
+                result = error;
+                upload_pipeline_abort(&pipeline);
+                break;
+            }
+
+            // Journaled replicas are only reused if the chunk still reads and is stored the same
+            const netchunk_chunk_t* committed = netchunk_journal_find_chunk(journal, slot->chunk.sequence_number);
+            if (committed && (committed->size != slot->chunk.size || committed->offset != slot->chunk.offset
+                                 || committed->codec != slot->chunk.codec
+                                 || memcmp(committed->key_id, slot->chunk.key_id, NETCHUNK_KEY_ID_LENGTH) != 0
+                                 || netchunk_chunk_stored_size(committed) != netchunk_chunk_stored_size(&slot->chunk)
+                                 || !netchunk_hash_compare(committed->hash, slot->chunk.hash, NETCHUNK_HASH_LENGTH))) {
+                committed = NULL;
+            }
+
+            error = upload_pipeline_submit(&pipeline, slot, committed);
+            if (error != NETCHUNK_SUCCESS) {
+                netchunk_chunk_cleanup(&slot->chunk);
+                result = error;
+                upload_pipeline_abort(&pipeline);
+                break;
+            }
+            next_sequence++;
+        }
+
+        // Everything read has been committed
+        if (commit_sequence == next_sequence) {
+            break;
+        }
+
+        // Commit the oldest chunk so the manifest stays in sequence order
+        upload_slot_t* slot = &pipeline.slots[commit_sequence % (uint32_t)pipeline.window];
+        upload_pipeline_wait(&pipeline, slot);
+
+        if (result == NETCHUNK_SUCCESS) {
+            if (slot->successful_replicas == 0) {
+                result = NETCHUNK_ERROR_UPLOAD_FAILED;
+            } else {
+                // Committed anyway so one bad server does not fail the
+                // upload; reported so the caller can repair the file
+                if (slot->successful_replicas < pipeline.target_replicas) {
+                    pipeline.under_replicated_chunks++;
+                }
+                result = upload_commit_chunk(context, slot, &manifest);
+            }
+
+            // Parity is not journaled; a resumed upload recomputes it
+            if (result == NETCHUNK_SUCCESS && !slot->parity) {
+                if (journal && netchunk_journal_record_chunk(journal, &slot->chunk) == NETCHUNK_SUCCESS) {
+                    netchunk_journal_checkpoint(journal);
+                }
+                chunks_committed++;
+                bytes_processed += slot->chunk.size;
+                call_progress_callback(context, "Uploading chunks", chunks_committed,
+                    chunker_ctx->total_chunks, bytes_processed, file_size);
+            } else if (result != NETCHUNK_SUCCESS) {
+                upload_pipeline_abort(&pipeline);
+            }
+        }
 
-    // Initialize context to zero
-    memset(context, 0, sizeof(netchunk_context_t));
+        netchunk_chunk_cleanup(&slot->chunk);
+        commit_sequence++;
+    }
 
-    // Allocate and initialize configuration
-    context->config = calloc(1, sizeof(netchunk_config_t));
-    if (!context->config) {
-        return NETCHUNK_ERROR_OUT_OF_MEMORY;
+    uint32_t retries = pipeline.retries;
+    uint32_t under_replicated_chunks = pipeline.under_replicated_chunks;
+    uint32_t dedup_chunks = pipeline.dedup_chunks;
+    uint64_t dedup_bytes = pipeline.dedup_bytes;
+    uint32_t resumed_chunks = pipeline.resumed_chunks;
+    uint64_t resumed_bytes = pipeline.resumed_bytes;
+    uint32_t compressed_chunks = pipeline.compressed_chunks;
+    uint64_t bytes_stored = pipeline.bytes_stored;
+    int data_shards = pipeline.data_shards;
+    int parity_shards = pipeline.parity_shards;
+    upload_pipeline_cleanup(&pipeline);
+
+    if (result != NETCHUNK_SUCCESS) {
+        finish_journal(journal, false);
+        netchunk_manifest_cleanup(&manifest);
+        netchunk_chunker_cleanup(chunker_ctx);
+        return result;
     }
 
-    // Load configuration
-    netchunk_error_t error = netchunk_config_load(context->config, config_path);
+    // Whole-file hash and size were accumulated while chunking
+    error = netchunk_chunker_get_file_hash(chunker_ctx, manifest.file_hash);
     if (error != NETCHUNK_SUCCESS) {
-        free(context->config);
-        context->config = NULL;
+        finish_journal(journal, false);
+        netchunk_manifest_cleanup(&manifest);
+        netchunk_chunker_cleanup(chunker_ctx);
         return error;
     }
+    manifest.total_size = bytes_processed;
+    manifest.original_size = bytes_processed;
+    manifest.chunk_size = context->config->chunk_size;
+    manifest.chunking_mode = context->config->chunking_mode;
+    if (data_shards > 0) {
+        manifest.ec_data_shards = data_shards;
+        manifest.ec_parity_shards = parity_shards;
+        manifest.replication_factor = 1;
+    }
+    file_size = bytes_processed;
 
-    // Initialize FTP context
-    context->ftp_context = calloc(1, sizeof(netchunk_ftp_context_t));
-    if (!context->ftp_context) {
-        netchunk_config_cleanup(context->config);
-        free(context->config);
-        context->config = NULL;
-        return NETCHUNK_ERROR_OUT_OF_MEMORY;
+    // Record references before the manifest exists: a failure in between
+    // only leaks chunks, never lets a delete remove chunks still in use
+    if (context->config->content_addressed) {
+        for (uint32_t i = 0; i < manifest.chunk_count && error == NETCHUNK_SUCCESS; i++) {
+            error = netchunk_dedup_index_add_ref(context->dedup_index, &manifest.chunks[i]);
+        }
+        if (error == NETCHUNK_SUCCESS) {
+            error = netchunk_dedup_index_save(context->dedup_index);
+        }
+        if (error != NETCHUNK_SUCCESS) {
+            drop_dedup_index(context);
+            finish_journal(journal, false);
+            netchunk_manifest_cleanup(&manifest);
+            netchunk_chunker_cleanup(chunker_ctx);
+            return error;
+        }
     }
 
-    error = netchunk_ftp_init(context->ftp_context, context->config);
+    call_progress_callback(context, "Saving manifest", 1, 1, bytes_processed, file_size);
+
+    // Upload manifest to servers
+    error = netchunk_ftp_upload_manifest(context->ftp_context, context->config, &manifest);
     if (error != NETCHUNK_SUCCESS) {
-        free(context->ftp_context);
-        context->ftp_context = NULL;
-        netchunk_config_cleanup(context->config);
-        free(context->config);
-        context->config = NULL;
+        finish_journal(journal, false);
+        netchunk_manifest_cleanup(&manifest);
+        netchunk_chunker_cleanup(chunker_ctx);
         return error;
     }
 
-    context->initialized = true;
-    return NETCHUNK_SUCCESS;
-}
+    finish_journal(journal, true);
+    update_catalog(context, remote_name, &manifest);
+    forget_open_file(context, remote_name);
 
-netchunk_error_t netchunk_set_progress_callback(netchunk_context_t* context,
-    netchunk_progress_callback_t callback,
-    void* userdata)
-{
-    if (!context || !context->initialized) {
-        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    // Fill stats if provided
+    if (stats) {
+        stats->bytes_processed = bytes_processed;
+        stats->chunks_processed = chunks_committed;
+        stats->servers_used = context->config->server_count;
+        stats->elapsed_seconds = (double)(netchunk_metrics_now_ns() - start_ns) / 1e9;
+        stats->retries_performed = retries;
+        stats->chunks_deduplicated = dedup_chunks;
+        stats->bytes_deduplicated = dedup_bytes;
+        stats->chunks_resumed = resumed_chunks;
+        stats->bytes_resumed = resumed_bytes;
+        stats->chunks_compressed = compressed_chunks;
+        stats->bytes_stored = bytes_stored;
+        stats->chunks_under_replicated = under_replicated_chunks;
     }
 
-    context->progress_cb = callback;
-    context->progress_userdata = userdata;
+    call_progress_callback(context, "Upload complete", 1, 1, bytes_processed, file_size);
+
+    netchunk_manifest_cleanup(&manifest);
+    netchunk_chunker_cleanup(chunker_ctx);
     return NETCHUNK_SUCCESS;
 }
 
@@ -108,134 +2516,484 @@ netchunk_error_t netchunk_upload(netchunk_context_t* context,
         return NETCHUNK_ERROR_INVALID_ARGUMENT;
     }
 
-    netchunk_error_t error;
-    netchunk_chunker_context_t chunker_ctx;
-    netchunk_file_manifest_t manifest;
-    time_t start_time = time(NULL);
-    uint32_t retries = 0;
+    if (context->config->server_count <= 0) {
+        return NETCHUNK_ERROR_INSUFFICIENT_SERVERS;
+    }
 
-    // Initialize stats if provided
-    if (stats) {
-        memset(stats, 0, sizeof(netchunk_stats_t));
+    // Initialize chunker ("-" streams standard input)
+    netchunk_chunker_context_t chunker_ctx;
+    netchunk_error_t error = netchunk_chunker_init(&chunker_ctx, local_path, context->config->chunk_size);
+    if (error != NETCHUNK_SUCCESS) {
+        return error;
     }
 
-    // Check if file exists and get size
-    int64_t file_size = get_file_size(local_path);
-    if (file_size < 0) {
-        return NETCHUNK_ERROR_FILE_NOT_FOUND;
+    const char* journal_path = strcmp(local_path, "-") == 0 ? NULL : local_path;
+    error = upload_from_chunker(context, &chunker_ctx, journal_path, remote_name, stats);
+    finish_operation(context);
+    return error;
+}
+
+netchunk_error_t netchunk_upload_stream(netchunk_context_t* context,
+    FILE* input,
+    const char* remote_name,
+    netchunk_stats_t* stats)
+{
+    if (!context || !context->initialized || !input || !remote_name) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
     }
 
-    call_progress_callback(context, "Preparing upload", 0, 1, 0, file_size);
+    if (context->config->server_count <= 0) {
+        return NETCHUNK_ERROR_INSUFFICIENT_SERVERS;
+    }
 
-    // Initialize chunker
-    error = netchunk_chunker_init(&chunker_ctx, local_path, context->config->chunk_size);
+    netchunk_chunker_context_t chunker_ctx;
+    netchunk_error_t error = netchunk_chunker_init_stream(&chunker_ctx, input, remote_name,
+        context->config->chunk_size);
     if (error != NETCHUNK_SUCCESS) {
         return error;
     }
 
-    // Initialize manifest
-    error = netchunk_manifest_init(&manifest, remote_name, file_size);
-    if (error != NETCHUNK_SUCCESS) {
-        netchunk_chunker_cleanup(&chunker_ctx);
-        return error;
+    error = upload_from_chunker(context, &chunker_ctx, NULL, remote_name, stats);
+    finish_operation(context);
+    return error;
+}
+
+/**
+ * @brief Open the download journal of a local path, reset unless it belongs to this manifest
+ */
+static netchunk_journal_t* begin_download_journal(netchunk_context_t* context,
+    netchunk_journal_t* storage,
+    const char* remote_name,
+    const char* local_path,
+    const netchunk_file_manifest_t* manifest)
+{
+    netchunk_journal_t* journal = open_journal(context, storage, NETCHUNK_JOURNAL_DOWNLOAD, remote_name, local_path);
+    if (!journal) {
+        return NULL;
     }
 
-    // Process chunks
-    netchunk_chunk_t chunk;
-    uint32_t chunk_number = 0;
-    uint64_t bytes_processed = 0;
+    // A re-uploaded file gets a new manifest, and its chunks no longer line up
+    if (strcmp(journal->manifest_id, manifest->manifest_id) != 0
+        || !netchunk_hash_compare(journal->file_hash, manifest->file_hash, NETCHUNK_HASH_LENGTH)
+        || journal->total_size != (uint64_t)manifest->original_size
+        || journal->completed_length != manifest->chunk_count) {
+        if (netchunk_journal_set_chunk_count(journal, manifest->chunk_count) != NETCHUNK_SUCCESS) {
+            netchunk_journal_cleanup(journal);
+            return NULL;
+        }
+        strncpy(journal->manifest_id, manifest->manifest_id, sizeof(journal->manifest_id) - 1);
+        journal->manifest_id[sizeof(journal->manifest_id) - 1] = '\0';
+        memcpy(journal->file_hash, manifest->file_hash, NETCHUNK_HASH_LENGTH);
+        journal->total_size = (uint64_t)manifest->original_size;
+    }
 
-    call_progress_callback(context, "Uploading chunks", 0, chunker_ctx.total_chunks, 0, file_size);
+    return journal;
+}
 
-    while ((error = netchunk_chunker_next_chunk(&chunker_ctx, &chunk)) == NETCHUNK_SUCCESS) {
-        // Distribute chunk to servers with replication
-        int successful_replicas = 0;
-        int target_replicas = context->config->replication_factor;
+/**
+ * @brief Check journaled chunk ranges of a partial file against their hashes
+ *
+ * Ranges that no longer match are cleared from the journal and fetched again.
+ */
+static netchunk_error_t verify_written_chunks(int fd,
+    const netchunk_file_manifest_t* manifest,
+    netchunk_journal_t* journal,
+    uint32_t* chunks_verified,
+    uint64_t* bytes_verified)
+{
+    uint8_t* buffer = NULL;
+    size_t buffer_size = 0;
 
-        for (int server_idx = 0; server_idx < context->config->server_count && successful_replicas < target_replicas; server_idx++) {
+    *chunks_verified = 0;
+    *bytes_verified = 0;
 
-            // Try to upload to this server
-            for (int attempt = 0; attempt < context->config->max_retry_attempts; attempt++) {
-                error = netchunk_ftp_upload_chunk(context->ftp_context,
-                    &context->config->servers[server_idx],
-                    &chunk);
-                if (error == NETCHUNK_SUCCESS) {
-                    // Add location to chunk
-                    netchunk_chunk_location_t location;
-                    strncpy(location.server_id, context->config->servers[server_idx].id,
-                        sizeof(location.server_id) - 1);
-                    location.server_id[sizeof(location.server_id) - 1] = '\0';
-                    location.upload_time = time(NULL);
-
-                    if (chunk.location_count < NETCHUNK_MAX_CHUNK_LOCATIONS) {
-                        chunk.locations[chunk.location_count] = location;
-                        chunk.location_count++;
-                    }
+    for (uint32_t i = 0; i < manifest->chunk_count; i++) {
+        const netchunk_chunk_t* chunk = &manifest->chunks[i];
+        if (!netchunk_journal_is_completed(journal, i)) {
+            continue;
+        }
 
-                    successful_replicas++;
-                    break;
+        if (chunk->size > buffer_size) {
+            uint8_t* grown = realloc(buffer, chunk->size);
+            if (!grown) {
+                free(buffer);
+                return NETCHUNK_ERROR_OUT_OF_MEMORY;
+            }
+            buffer = grown;
+            buffer_size = chunk->size;
+        }
+
+        uint8_t hash[NETCHUNK_HASH_LENGTH];
+        if (read_at_offset(fd, buffer, chunk->size, (off_t)chunk->offset)
+            && netchunk_sha256_hash(buffer, chunk->size, hash) == NETCHUNK_SUCCESS
+            && netchunk_hash_compare(hash, chunk->hash, NETCHUNK_HASH_LENGTH)) {
+            (*chunks_verified)++;
+            *bytes_verified += chunk->size;
+        } else {
+            netchunk_journal_set_completed(journal, i, false);
+        }
+    }
+
+    free(buffer);
+    return NETCHUNK_SUCCESS;
+}
+
+/**
+ * @brief Rebuild chunks no replica could deliver from the rest of their stripe
+ *
+ * Chunks of the stripe already in the output are read back rather than
+ * downloaded again; parity is fetched only as far as decoding needs it.
+ * Runs once the pipeline has drained, so no locking is needed.
+ */
+static netchunk_error_t download_rebuild_lost(download_pipeline_t* pipeline)
+{
+    const netchunk_file_manifest_t* manifest = pipeline->manifest;
+    int data_shards = manifest->ec_data_shards;
+    int total = data_shards + manifest->ec_parity_shards;
+    uint8_t* shards[NETCHUNK_EC_MAX_SHARDS] = { NULL };
+    size_t capacity = 0;
+    netchunk_error_t error = NETCHUNK_SUCCESS;
+
+    uint32_t stripe_count = netchunk_manifest_stripe_count(manifest);
+    for (uint32_t stripe = 0; stripe < stripe_count && pipeline->lost_count > 0 && error == NETCHUNK_SUCCESS; stripe++) {
+        uint32_t first = stripe * (uint32_t)data_shards;
+        bool affected = false;
+        for (int d = 0; d < data_shards && first + (uint32_t)d < manifest->chunk_count; d++) {
+            affected = affected || pipeline->lost[first + (uint32_t)d];
+        }
+        if (!affected) {
+            continue;
+        }
+
+        size_t shard_size = netchunk_manifest_stripe_shard(manifest, stripe, data_shards)->size;
+        if (shard_size > capacity) {
+            for (int i = 0; i < total && error == NETCHUNK_SUCCESS; i++) {
+                uint8_t* grown = realloc(shards[i], shard_size);
+                if (grown) {
+                    shards[i] = grown;
                 } else {
-                    retries++;
+                    error = NETCHUNK_ERROR_OUT_OF_MEMORY;
                 }
             }
+            if (error != NETCHUNK_SUCCESS) {
+                break;
+            }
+            capacity = shard_size;
         }
 
-        // Check if we got enough replicas
-        if (successful_replicas == 0) {
-            netchunk_chunk_cleanup(&chunk);
-            netchunk_manifest_cleanup(&manifest);
-            netchunk_chunker_cleanup(&chunker_ctx);
-            return NETCHUNK_ERROR_UPLOAD_FAILED;
+        bool present[NETCHUNK_EC_MAX_SHARDS] = { false };
+        for (int d = 0; d < data_shards; d++) {
+            const netchunk_chunk_t* chunk = netchunk_manifest_stripe_shard(manifest, stripe, d);
+            if (chunk && !pipeline->lost[first + (uint32_t)d] && chunk->size <= shard_size
+                && read_at_offset(pipeline->output_fd, shards[d], chunk->size, (off_t)chunk->offset)) {
+                memset(shards[d] + chunk->size, 0, shard_size - chunk->size);
+                present[d] = true;
+            }
         }
 
-        // Add chunk to manifest
-        error = netchunk_manifest_add_chunk(&manifest, &chunk);
-        if (error != NETCHUNK_SUCCESS) {
-            netchunk_chunk_cleanup(&chunk);
-            netchunk_manifest_cleanup(&manifest);
-            netchunk_chunker_cleanup(&chunker_ctx);
-            return error;
+        error = netchunk_ec_recover_stripe(pipeline->context->ftp_context, manifest, stripe, shards, present, shard_size);
+
+        for (int d = 0; d < data_shards && error == NETCHUNK_SUCCESS; d++) {
+            const netchunk_chunk_t* chunk = netchunk_manifest_stripe_shard(manifest, stripe, d);
+            if (!chunk || !pipeline->lost[first + (uint32_t)d]) {
+                continue;
+            }
+
+            error = netchunk_chunk_verify_raw(chunk, shards[d]);
+            if (error == NETCHUNK_SUCCESS) {
+                error = download_write_chunk(pipeline, shards[d], chunk);
+            }
+            if (error == NETCHUNK_SUCCESS) {
+                pipeline->lost[first + (uint32_t)d] = false;
+                pipeline->lost_count--;
+                pipeline->chunks_completed++;
+                pipeline->bytes_completed += chunk->size;
+                netchunk_journal_set_completed(pipeline->journal, first + (uint32_t)d, true);
+            }
         }
+    }
 
-        bytes_processed += chunk.size;
-        chunk_number++;
+    for (int i = 0; i < total; i++) {
+        free(shards[i]);
+    }
 
-        call_progress_callback(context, "Uploading chunks", chunk_number,
-            chunker_ctx.total_chunks, bytes_processed, file_size);
+    return error == NETCHUNK_SUCCESS ? NETCHUNK_SUCCESS : NETCHUNK_ERROR_DOWNLOAD_FAILED;
+}
 
-        netchunk_chunk_cleanup(&chunk);
+/**
+ * @brief Advance past chunks already written, true while any remain to submit
+ *
+ * Must be called with the pipeline lock held.
+ */
+static bool download_has_next(download_pipeline_t* pipeline)
+{
+    while (pipeline->next_chunk < pipeline->manifest->chunk_count
+        && netchunk_journal_is_completed(pipeline->journal, pipeline->next_chunk)) {
+        pipeline->next_chunk++;
     }
+    return pipeline->next_chunk < pipeline->manifest->chunk_count;
+}
 
-    // Check if chunking completed successfully (EOF expected)
-    if (error != NETCHUNK_ERROR_EOF) {
-        netchunk_manifest_cleanup(&manifest);
-        netchunk_chunker_cleanup(&chunker_ctx);
+/**
+ * @brief Fetch a file into a local path, or into an open descriptor when local_path is NULL
+ *
+ * A path is only opened once the manifest is known, so a missing file never
+ * clobbers an existing one. If the download fails, the file is kept with a
+ * journal when some chunks were written and removed otherwise. A matching
+ * journal from an earlier attempt resumes into the existing file.
+ */
+static netchunk_error_t download_to_output(netchunk_context_t* context,
+    const char* remote_name,
+    const char* local_path,
+    int output_fd,
+    netchunk_stats_t* stats)
+{
+    netchunk_error_t error;
+    netchunk_file_manifest_t manifest;
+    download_pipeline_t pipeline;
+    uint64_t start_ns = netchunk_metrics_now_ns();
+
+    // Initialize stats if provided
+    if (stats) {
+        memset(stats, 0, sizeof(netchunk_stats_t));
+    }
+
+    call_progress_callback(context, "Loading manifest", 0, 1, 0, 0);
+
+    // Download manifest
+    error = netchunk_ftp_download_manifest(context->ftp_context, context->config,
+        remote_name, &manifest);
+    if (error != NETCHUNK_SUCCESS) {
         return error;
     }
 
-    call_progress_callback(context, "Saving manifest", 1, 1, bytes_processed, file_size);
+    call_progress_callback(context, "Downloading chunks", 0, manifest.chunk_count,
+        0, manifest.original_size);
 
-    // Upload manifest to servers
-    error = netchunk_ftp_upload_manifest(context->ftp_context, context->config, &manifest);
+    // Only a journal of this very manifest lets the existing file be reused
+    netchunk_journal_t journal_storage;
+    netchunk_journal_t* journal = NULL;
+    bool resuming = false;
+    if (local_path) {
+        journal = begin_download_journal(context, &journal_storage, remote_name, local_path, &manifest);
+        resuming = journal && netchunk_journal_has_progress(journal);
+    }
+
+    // Open and preallocate output file so chunks can land at their offsets
+    if (local_path) {
+        // Readable too, so erasure-coded stripes can be decoded from chunks already written
+        output_fd = open(local_path, resuming ? O_RDWR | O_CREAT : O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (output_fd < 0) {
+            finish_journal(journal, false);
+            netchunk_manifest_cleanup(&manifest);
+            return NETCHUNK_ERROR_FILE_ACCESS;
+        }
+    }
+
+    uint32_t resumed_chunks = 0;
+    uint64_t resumed_bytes = 0;
+    error = NETCHUNK_SUCCESS;
+    if (ftruncate(output_fd, (off_t)manifest.original_size) != 0) {
+        error = NETCHUNK_ERROR_FILE_ACCESS;
+    } else if (resuming) {
+        call_progress_callback(context, "Verifying partial file", 0, manifest.chunk_count, 0, manifest.original_size);
+        error = verify_written_chunks(output_fd, &manifest, journal, &resumed_chunks, &resumed_bytes);
+    }
     if (error != NETCHUNK_SUCCESS) {
+        if (local_path) {
+            close(output_fd);
+            remove(local_path);
+        }
+        netchunk_journal_discard(journal);
+        netchunk_journal_cleanup(journal);
         netchunk_manifest_cleanup(&manifest);
-        netchunk_chunker_cleanup(&chunker_ctx);
         return error;
     }
 
+    memset(&pipeline, 0, sizeof(download_pipeline_t));
+    pipeline.context = context;
+    pipeline.manifest = &manifest;
+    pipeline.output_fd = output_fd;
+    pipeline.journal = journal;
+    pipeline.chunks_completed = resumed_chunks;
+    pipeline.bytes_completed = resumed_bytes;
+    pipeline.error = NETCHUNK_SUCCESS;
+    pthread_mutex_init(&pipeline.mutex, NULL);
+    pthread_cond_init(&pipeline.progress, NULL);
+    pthread_cond_init(&pipeline.verify_ready, NULL);
+
+    // Chunks of erasure-coded files survive the loss of all their replicas
+    if (netchunk_manifest_is_erasure_coded(&manifest) && manifest.chunk_count > 0) {
+        pipeline.lost = calloc(manifest.chunk_count, sizeof(bool));
+        if (!pipeline.lost) {
+            pipeline.error = NETCHUNK_ERROR_OUT_OF_MEMORY;
+        }
+    }
+
+    // Enough fetches in flight to keep every server at its concurrency cap
+    int concurrency = context->config->max_concurrent_operations;
+    if (concurrency < 1) {
+        concurrency = 1;
+    }
+    int window = concurrency * (context->config->server_count > 0 ? context->config->server_count : 1);
+    if ((uint32_t)window > manifest.chunk_count - resumed_chunks) {
+        window = (int)(manifest.chunk_count - resumed_chunks);
+    }
+
+    // Hashing is CPU bound, so verifiers need not exceed the core count
+    int verifier_target = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (verifier_target < 1) {
+        verifier_target = 1;
+    }
+    if (verifier_target > window) {
+        verifier_target = window;
+    }
+
+    // Only a multi-buffer hash backend gains from verifying chunks together
+    pipeline.verify_batch = 1;
+    if (netchunk_sha256_get_batch_backend() == NETCHUNK_SHA256_BACKEND_AVX2) {
+        pipeline.verify_batch = NETCHUNK_SHA256_MAX_LANES;
+    }
+
+    if (window > 0) {
+        pipeline.slots = calloc((size_t)window, sizeof(download_slot_t));
+        pipeline.verifiers = calloc((size_t)verifier_target, sizeof(pthread_t));
+        if (!pipeline.slots || !pipeline.verifiers) {
+            pipeline.error = NETCHUNK_ERROR_OUT_OF_MEMORY;
+            window = 0;
+            verifier_target = 0;
+        }
+    }
+
+    for (int i = window - 1; i >= 0; i--) {
+        pipeline.slots[i].pipeline = &pipeline;
+        pipeline.slots[i].next = pipeline.free_slots;
+        pipeline.free_slots = &pipeline.slots[i];
+    }
+
+    for (int i = 0; i < verifier_target; i++) {
+        if (pthread_create(&pipeline.verifiers[i], NULL, download_verifier, &pipeline) != 0) {
+            break;
+        }
+        pipeline.verifier_count++;
+    }
+    if (verifier_target > 0 && pipeline.verifier_count == 0) {
+        pipeline.error = NETCHUNK_ERROR_UNKNOWN;
+    }
+
+    // Keep the window full and report completed bytes until everything drains
+    uint32_t reported = 0;
+    pthread_mutex_lock(&pipeline.mutex);
+    for (;;) {
+        while (pipeline.error == NETCHUNK_SUCCESS && pipeline.free_slots && download_has_next(&pipeline)) {
+            download_slot_t* slot = pipeline.free_slots;
+            pipeline.free_slots = slot->next;
+            pipeline.in_flight++;
+
+            slot->index = pipeline.next_chunk;
+            slot->chunk = manifest.chunks[pipeline.next_chunk++];
+            slot->chunk.data = NULL;
+            slot->chunk.data_owned = false;
+            slot->from_cache = false;
+            memset(slot->tried, 0, sizeof(slot->tried));
+
+            error = netchunk_ftp_chunk_path(&slot->chunk, slot->remote_path, sizeof(slot->remote_path));
+            if (error == NETCHUNK_SUCCESS && context->chunk_cache
+                && netchunk_disk_cache_lookup(context->chunk_cache, slot->chunk.hash)) {
+                slot->from_cache = true;
+                download_queue_verify(&pipeline, slot);
+            } else if (error == NETCHUNK_SUCCESS) {
+                if (context->chunk_cache) {
+                    pipeline.cache_misses++;
+                    netchunk_metrics_add(context->metrics, NETCHUNK_METRICS_CACHE_MISSES, 1);
+                }
+                error = download_submit_next(&pipeline, slot);
+            }
+            if (error != NETCHUNK_SUCCESS) {
+                download_release_slot(&pipeline, slot, error);
+            }
+        }
+
+        if (reported != pipeline.chunks_completed) {
+            reported = pipeline.chunks_completed;
+            uint64_t bytes_completed = pipeline.bytes_completed;
+            if (journal) {
+                netchunk_journal_checkpoint(journal);
+            }
+
+            pthread_mutex_unlock(&pipeline.mutex);
+            call_progress_callback(context, "Downloading chunks", reported, manifest.chunk_count,
+                bytes_completed, manifest.original_size);
+            pthread_mutex_lock(&pipeline.mutex);
+            continue;
+        }
+
+        bool submitting = pipeline.error == NETCHUNK_SUCCESS && download_has_next(&pipeline);
+        if (pipeline.in_flight == 0 && !submitting) {
+            break;
+        }
+        pthread_cond_wait(&pipeline.progress, &pipeline.mutex);
+    }
+
+    pipeline.shutdown = true;
+    pthread_cond_broadcast(&pipeline.verify_ready);
+    pthread_mutex_unlock(&pipeline.mutex);
+
+    for (int i = 0; i < pipeline.verifier_count; i++) {
+        pthread_join(pipeline.verifiers[i], NULL);
+    }
+    free(pipeline.verifiers);
+    free(pipeline.slots);
+
+    pthread_mutex_destroy(&pipeline.mutex);
+    pthread_cond_destroy(&pipeline.progress);
+    pthread_cond_destroy(&pipeline.verify_ready);
+
+    if (pipeline.error == NETCHUNK_SUCCESS && pipeline.lost_count > 0) {
+        call_progress_callback(context, "Rebuilding lost chunks", pipeline.chunks_completed, manifest.chunk_count,
+            pipeline.bytes_completed, manifest.original_size);
+        pipeline.error = download_rebuild_lost(&pipeline);
+        if (journal) {
+            netchunk_journal_checkpoint(journal);
+        }
+    }
+    free(pipeline.lost);
+
+    if (local_path && close(output_fd) != 0 && pipeline.error == NETCHUNK_SUCCESS) {
+        pipeline.error = NETCHUNK_ERROR_FILE_ACCESS;
+    }
+
+    if (pipeline.error != NETCHUNK_SUCCESS) {
+        // Keep what was written for a retry; without progress there is nothing to keep
+        if (local_path && !netchunk_journal_has_progress(journal)) {
+            remove(local_path);
+        }
+        finish_journal(journal, false);
+        netchunk_manifest_cleanup(&manifest);
+        return pipeline.error;
+    }
+
+    finish_journal(journal, true);
+
     // Fill stats if provided
     if (stats) {
-        stats->bytes_processed = bytes_processed;
-        stats->chunks_processed = chunk_number;
+        stats->bytes_processed = pipeline.bytes_completed;
+        stats->chunks_processed = manifest.chunk_count;
         stats->servers_used = context->config->server_count;
-        stats->elapsed_seconds = difftime(time(NULL), start_time);
-        stats->retries_performed = retries;
+        stats->elapsed_seconds = (double)(netchunk_metrics_now_ns() - start_ns) / 1e9;
+        stats->retries_performed = pipeline.retries;
+        stats->chunks_resumed = resumed_chunks;
+        stats->bytes_resumed = resumed_bytes;
+        stats->cache_hits = pipeline.cache_hits;
+        stats->bytes_from_cache = pipeline.bytes_from_cache;
+        stats->cache_misses = pipeline.cache_misses;
+        stats->chunks_hedged = pipeline.hedged;
     }
 
-    call_progress_callback(context, "Upload complete", 1, 1, bytes_processed, file_size);
+    call_progress_callback(context, "Download complete", 1, 1,
+        manifest.original_size, manifest.original_size);
 
     netchunk_manifest_cleanup(&manifest);
-    netchunk_chunker_cleanup(&chunker_ctx);
     return NETCHUNK_SUCCESS;
 }
 
@@ -248,104 +3006,102 @@ netchunk_error_t netchunk_download(netchunk_context_t* context,
         return NETCHUNK_ERROR_INVALID_ARGUMENT;
     }
 
-    netchunk_error_t error;
-    netchunk_file_manifest_t manifest;
-    time_t start_time = time(NULL);
-    uint32_t retries = 0;
+    netchunk_error_t error = download_to_output(context, remote_name, local_path, -1, stats);
+    finish_operation(context);
+    return error;
+}
 
-    // Initialize stats if provided
-    if (stats) {
-        memset(stats, 0, sizeof(netchunk_stats_t));
+netchunk_error_t netchunk_download_fd(netchunk_context_t* context,
+    const char* remote_name,
+    int output_fd,
+    netchunk_stats_t* stats)
+{
+    if (!context || !context->initialized || !remote_name || output_fd < 0) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    netchunk_error_t error = download_to_output(context, remote_name, NULL, output_fd, stats);
+    finish_operation(context);
+    return error;
+}
+
+netchunk_error_t netchunk_read_range(netchunk_context_t* context,
+    const char* remote_name,
+    uint64_t offset,
+    size_t length,
+    void* buffer,
+    size_t* bytes_read)
+{
+    if (bytes_read) {
+        *bytes_read = 0;
+    }
+    if (!context || !context->initialized || !context->read_state || !remote_name || (!buffer && length > 0)) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
     }
 
-    call_progress_callback(context, "Loading manifest", 0, 1, 0, 0);
+    netchunk_read_state_t* state = context->read_state;
+    read_manifest_t* shared = NULL;
+    uint32_t window = 0;
+    uint64_t end = (length > UINT64_MAX - offset) ? UINT64_MAX : offset + length;
 
-    // Download manifest
-    error = netchunk_ftp_download_manifest(context->ftp_context, context->config,
-        remote_name, &manifest);
+    netchunk_error_t error = read_open_file(state, remote_name, offset, end, &shared, &window);
     if (error != NETCHUNK_SUCCESS) {
         return error;
     }
 
-    call_progress_callback(context, "Downloading chunks", 0, manifest.chunk_count,
-        0, manifest.original_size);
-
-    // Open output file
-    FILE* output_file = fopen(local_path, "wb");
-    if (!output_file) {
-        netchunk_manifest_cleanup(&manifest);
-        return NETCHUNK_ERROR_FILE_ACCESS;
+    const netchunk_file_manifest_t* manifest = &shared->manifest;
+    uint64_t file_size = manifest->original_size;
+    if (end > file_size) {
+        end = file_size;
+    }
+    if (offset >= end || manifest->chunk_count == 0) {
+        pthread_mutex_lock(&state->mutex);
+        read_manifest_unref(shared);
+        pthread_mutex_unlock(&state->mutex);
+        return NETCHUNK_SUCCESS;
     }
 
-    // Download and write chunks in sequence
-    uint64_t bytes_processed = 0;
-    for (uint32_t i = 0; i < manifest.chunk_count; i++) {
-        netchunk_chunk_t* chunk = &manifest.chunks[i];
-        bool chunk_downloaded = false;
-
-        // Try to download from any available location
-        for (int loc_idx = 0; loc_idx < chunk->location_count && !chunk_downloaded; loc_idx++) {
-            const char* server_id = chunk->locations[loc_idx].server_id;
-
-            // Find server config
-            netchunk_server_t* server = NULL;
-            for (int s = 0; s < context->config->server_count; s++) {
-                if (strcmp(context->config->servers[s].id, server_id) == 0) {
-                    server = &context->config->servers[s];
-                    break;
-                }
-            }
+    uint32_t first = read_find_chunk(manifest, offset);
+    uint32_t last = read_find_chunk(manifest, end - 1);
 
-            if (!server)
-                continue;
+    // Fetch ahead within half the cache so chunks are not evicted before
+    // they are copied; readahead gets a quarter
+    size_t capacity = state->cache.capacity_bytes;
+    uint8_t* out = (uint8_t*)buffer;
+    uint64_t position = offset;
 
-            // Try to download chunk with retries
-            for (int attempt = 0; attempt < context->config->max_retry_attempts; attempt++) {
-                error = netchunk_ftp_download_chunk(context->ftp_context, server, chunk);
-                if (error == NETCHUNK_SUCCESS) {
-                    // Verify chunk integrity
-                    error = netchunk_chunk_verify_integrity(chunk);
-                    if (error == NETCHUNK_SUCCESS) {
-                        // Write chunk to file
-                        size_t written = fwrite(chunk->data, 1, chunk->size, output_file);
-                        if (written == chunk->size) {
-                            chunk_downloaded = true;
-                            bytes_processed += chunk->size;
-                            break;
-                        }
-                    }
-                } else {
-                    retries++;
-                }
-            }
+    for (uint32_t i = first; i <= last && error == NETCHUNK_SUCCESS; i++) {
+        pthread_mutex_lock(&state->mutex);
+        read_prefetch(state, manifest, i, last, capacity / 2);
+        if (i == first && window > 0) {
+            read_prefetch(state, manifest, last + 1, last + window, capacity / 4);
         }
+        pthread_mutex_unlock(&state->mutex);
 
-        if (!chunk_downloaded) {
-            fclose(output_file);
-            remove(local_path);
-            netchunk_manifest_cleanup(&manifest);
-            return NETCHUNK_ERROR_DOWNLOAD_FAILED;
+        const netchunk_chunk_t* chunk = &manifest->chunks[i];
+        uint64_t chunk_end = chunk->offset + chunk->size;
+        if (chunk->offset > position || chunk_end <= position) {
+            error = NETCHUNK_ERROR_MANIFEST_CORRUPT;
+            break;
         }
+        size_t span = (size_t)((chunk_end < end ? chunk_end : end) - position);
 
-        call_progress_callback(context, "Downloading chunks", i + 1, manifest.chunk_count,
-            bytes_processed, manifest.original_size);
+        error = read_copy_chunk(state, chunk, position - chunk->offset, span, out);
+        out += span;
+        position += span;
     }
 
-    fclose(output_file);
+    pthread_mutex_lock(&state->mutex);
+    read_manifest_unref(shared);
+    pthread_mutex_unlock(&state->mutex);
 
-    // Fill stats if provided
-    if (stats) {
-        stats->bytes_processed = bytes_processed;
-        stats->chunks_processed = manifest.chunk_count;
-        stats->servers_used = context->config->server_count;
-        stats->elapsed_seconds = difftime(time(NULL), start_time);
-        stats->retries_performed = retries;
+    if (error != NETCHUNK_SUCCESS) {
+        return error;
     }
 
-    call_progress_callback(context, "Download complete", 1, 1,
-        manifest.original_size, manifest.original_size);
-
-    netchunk_manifest_cleanup(&manifest);
+    if (bytes_read) {
+        *bytes_read = (size_t)(end - offset);
+    }
     return NETCHUNK_SUCCESS;
 }
 
@@ -357,7 +3113,63 @@ netchunk_error_t netchunk_list_files(netchunk_context_t* context,
         return NETCHUNK_ERROR_INVALID_ARGUMENT;
     }
 
-    return netchunk_ftp_list_manifests(context->ftp_context, context->config, files, count);
+    *files = NULL;
+    *count = 0;
+
+    netchunk_error_t error = refresh_catalog(context);
+    if (error != NETCHUNK_SUCCESS) {
+        return error;
+    }
+
+    const netchunk_catalog_t* catalog = context->catalog;
+    netchunk_file_manifest_t* list = calloc(catalog->count > 0 ? catalog->count : 1, sizeof(netchunk_file_manifest_t));
+    if (!list) {
+        return NETCHUNK_ERROR_OUT_OF_MEMORY;
+    }
+
+    for (size_t i = 0; i < catalog->count; i++) {
+        catalog_entry_to_summary(&catalog->entries[i], &list[i]);
+    }
+
+    *files = list;
+    *count = catalog->count;
+    return NETCHUNK_SUCCESS;
+}
+
+netchunk_error_t netchunk_lookup_file(netchunk_context_t* context,
+    const char* remote_name,
+    netchunk_file_manifest_t* summary)
+{
+    if (!context || !context->initialized || !remote_name || !summary) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    netchunk_error_t error = refresh_catalog(context);
+    if (error != NETCHUNK_SUCCESS) {
+        return error;
+    }
+
+    const netchunk_catalog_entry_t* entry = netchunk_catalog_lookup(context->catalog, remote_name);
+    if (!entry) {
+        return NETCHUNK_ERROR_FILE_NOT_FOUND;
+    }
+
+    catalog_entry_to_summary(entry, summary);
+    return NETCHUNK_SUCCESS;
+}
+
+netchunk_error_t netchunk_sync_catalog(netchunk_context_t* context, netchunk_catalog_sync_stats_t* stats)
+{
+    if (!context || !context->initialized) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    netchunk_error_t error = load_catalog(context);
+    if (error != NETCHUNK_SUCCESS) {
+        return error;
+    }
+
+    return netchunk_catalog_sync(context->catalog, context->ftp_context, context->config, stats);
 }
 
 void netchunk_free_file_list(netchunk_file_manifest_t* files, size_t count)
@@ -371,6 +3183,97 @@ void netchunk_free_file_list(netchunk_file_manifest_t* files, size_t count)
     free(files);
 }
 
+// Chunk removals of one netchunk_delete() call
+typedef struct delete_plan {
+    netchunk_ftp_delete_request_t* requests; // Shared chunks first
+    size_t count;
+    size_t shared_count; // Removals of content-addressed chunks
+    char** paths; // Per manifest entry, shared by its replicas' requests
+} delete_plan_t;
+
+static void free_delete_plan(delete_plan_t* plan, uint32_t entry_count)
+{
+    if (plan->paths) {
+        for (uint32_t i = 0; i < entry_count; i++) {
+            free(plan->paths[i]);
+        }
+    }
+    free(plan->paths);
+    free(plan->requests);
+    memset(plan, 0, sizeof(delete_plan_t));
+}
+
+/**
+ * @brief List every replica of the manifest's unreferenced chunks and parity
+ */
+static netchunk_error_t plan_chunk_removals(netchunk_context_t* context,
+    const netchunk_file_manifest_t* manifest,
+    const bool* unreferenced,
+    delete_plan_t* plan)
+{
+    memset(plan, 0, sizeof(delete_plan_t));
+
+    uint32_t entry_count = manifest->chunk_count + manifest->parity_count;
+    size_t location_total = 0;
+    for (uint32_t i = 0; i < entry_count; i++) {
+        const netchunk_chunk_t* chunk = i < manifest->chunk_count
+            ? &manifest->chunks[i]
+            : &manifest->parity_chunks[i - manifest->chunk_count];
+        location_total += (size_t)chunk->location_count;
+    }
+
+    plan->paths = calloc(entry_count > 0 ? entry_count : 1, sizeof(char*));
+    plan->requests = malloc((location_total > 0 ? location_total : 1) * sizeof(netchunk_ftp_delete_request_t));
+    if (!plan->paths || !plan->requests) {
+        free_delete_plan(plan, entry_count);
+        return NETCHUNK_ERROR_OUT_OF_MEMORY;
+    }
+
+    // Shared chunks in the first pass, the file's own in the second
+    for (int pass = 0; pass < 2; pass++) {
+        for (uint32_t i = 0; i < entry_count; i++) {
+            const netchunk_chunk_t* chunk = i < manifest->chunk_count
+                ? &manifest->chunks[i]
+                : &manifest->parity_chunks[i - manifest->chunk_count];
+
+            if (i < manifest->chunk_count && !unreferenced[i]) {
+                continue;
+            }
+            if (netchunk_chunk_is_content_addressed(chunk) != (pass == 0)) {
+                continue;
+            }
+
+            char remote_path[NETCHUNK_MAX_PATH_LEN];
+            if (netchunk_ftp_chunk_path(chunk, remote_path, sizeof(remote_path)) != NETCHUNK_SUCCESS) {
+                continue;
+            }
+            plan->paths[i] = strdup(remote_path);
+            if (!plan->paths[i]) {
+                free_delete_plan(plan, entry_count);
+                return NETCHUNK_ERROR_OUT_OF_MEMORY;
+            }
+
+            for (int loc_idx = 0; loc_idx < chunk->location_count; loc_idx++) {
+                int server_idx = find_server_index(context, chunk->locations[loc_idx].server_id);
+                if (server_idx < 0) {
+                    continue;
+                }
+
+                netchunk_ftp_delete_request_t* request = &plan->requests[plan->count++];
+                request->server_index = server_idx;
+                request->remote_path = plan->paths[i];
+                request->result = NETCHUNK_SUCCESS;
+            }
+        }
+
+        if (pass == 0) {
+            plan->shared_count = plan->count;
+        }
+    }
+
+    return NETCHUNK_SUCCESS;
+}
+
 netchunk_error_t netchunk_delete(netchunk_context_t* context, const char* remote_name)
 {
     if (!context || !context->initialized || !remote_name) {
@@ -387,35 +3290,137 @@ netchunk_error_t netchunk_delete(netchunk_context_t* context, const char* remote
         return error;
     }
 
-    // Delete all chunks from all servers
+    // The manifest goes first and holds the file's references until then:
+    // a failed delete leaves both, so retrying cannot release them twice
+    error = netchunk_ftp_delete_manifest(context->ftp_context, context->config, remote_name);
+    if (error != NETCHUNK_SUCCESS) {
+        netchunk_manifest_cleanup(&manifest);
+        return error;
+    }
+    update_catalog(context, remote_name, NULL);
+    forget_open_file(context, remote_name);
+
+    bool* unreferenced = calloc(manifest.chunk_count > 0 ? manifest.chunk_count : 1, sizeof(bool));
+    if (!unreferenced) {
+        netchunk_manifest_cleanup(&manifest);
+        return NETCHUNK_ERROR_OUT_OF_MEMORY;
+    }
+
+    // Content-addressed chunks may be shared with other files: drop this
+    // manifest's references and only delete chunks nobody else uses. Chunks
+    // unknown to the index are kept, since their other users cannot be ruled out.
+    // From here on a failure only leaks chunks.
+    bool index_changed = false;
     for (uint32_t i = 0; i < manifest.chunk_count; i++) {
         netchunk_chunk_t* chunk = &manifest.chunks[i];
 
-        for (int loc_idx = 0; loc_idx < chunk->location_count; loc_idx++) {
-            const char* server_id = chunk->locations[loc_idx].server_id;
+        if (!netchunk_chunk_is_content_addressed(chunk)) {
+            unreferenced[i] = true;
+            continue;
+        }
 
-            // Find server config
-            netchunk_server_t* server = NULL;
-            for (int s = 0; s < context->config->server_count; s++) {
-                if (strcmp(context->config->servers[s].id, server_id) == 0) {
-                    server = &context->config->servers[s];
-                    break;
-                }
-            }
+        error = load_dedup_index(context);
+        if (error != NETCHUNK_SUCCESS) {
+            free(unreferenced);
+            netchunk_manifest_cleanup(&manifest);
+            return error;
+        }
 
-            if (server) {
-                netchunk_ftp_delete_chunk(context->ftp_context, server, chunk);
-            }
+        uint32_t remaining = 0;
+        if (netchunk_dedup_index_release(context->dedup_index, chunk->hash, &remaining) == NETCHUNK_SUCCESS) {
+            unreferenced[i] = remaining == 0;
+            index_changed = true;
         }
     }
 
-    // Delete manifest from all servers
-    error = netchunk_ftp_delete_manifest(context->ftp_context, context->config, remote_name);
+    // Persist the new counts before deleting any chunk, so the index
+    // never points at deleted ones
+    if (index_changed) {
+        error = netchunk_dedup_index_save(context->dedup_index);
+        if (error != NETCHUNK_SUCCESS) {
+            drop_dedup_index(context);
+            free(unreferenced);
+            netchunk_manifest_cleanup(&manifest);
+            return error;
+        }
+    }
+
+    // Remove unreferenced chunks and any stripe parity from all servers
+    delete_plan_t plan;
+    error = plan_chunk_removals(context, &manifest, unreferenced, &plan);
+    free(unreferenced);
+    if (error != NETCHUNK_SUCCESS) {
+        netchunk_manifest_cleanup(&manifest);
+        return error;
+    }
+
+    // Shared chunks go right away: an upload could start using one again
+    // while its removal waits in the queue
+    size_t now_count = context->delete_queue ? plan.shared_count : plan.count;
+    netchunk_ftp_delete_many(context->ftp_context, plan.requests, now_count);
+
+    // The file is gone; its own chunks can follow at the queue's pace
+    for (size_t i = now_count; i < plan.count; i++) {
+        const netchunk_ftp_delete_request_t* request = &plan.requests[i];
+        if (netchunk_delete_queue_push(context->delete_queue, request->server_index, request->remote_path) != NETCHUNK_SUCCESS) {
+            netchunk_ftp_delete_many(context->ftp_context, &plan.requests[i], plan.count - i);
+            break;
+        }
+    }
 
+    free_delete_plan(&plan, manifest.chunk_count + manifest.parity_count);
     netchunk_manifest_cleanup(&manifest);
     return error;
 }
 
+/**
+ * @brief Decode one data chunk of an erasure-coded file from its stripe
+ *
+ * On success the chunk owns its verified data, in its stored form again.
+ */
+static netchunk_error_t decode_from_stripe(netchunk_context_t* context,
+    netchunk_file_manifest_t* manifest,
+    uint32_t index)
+{
+    netchunk_chunk_t* chunk = &manifest->chunks[index];
+    uint32_t stripe = index / (uint32_t)manifest->ec_data_shards;
+    int total = manifest->ec_data_shards + manifest->ec_parity_shards;
+    size_t shard_size = netchunk_manifest_stripe_shard(manifest, stripe, manifest->ec_data_shards)->size;
+
+    uint8_t* shards[NETCHUNK_EC_MAX_SHARDS] = { NULL };
+    bool present[NETCHUNK_EC_MAX_SHARDS] = { false };
+    netchunk_error_t error = NETCHUNK_SUCCESS;
+    for (int i = 0; i < total && error == NETCHUNK_SUCCESS; i++) {
+        shards[i] = malloc(shard_size > 0 ? shard_size : 1);
+        if (!shards[i]) {
+            error = NETCHUNK_ERROR_OUT_OF_MEMORY;
+        }
+    }
+
+    if (error == NETCHUNK_SUCCESS) {
+        error = netchunk_ec_recover_stripe(context->ftp_context, manifest, stripe, shards, present, shard_size);
+    }
+
+    int shard = (int)(index % (uint32_t)manifest->ec_data_shards);
+    if (error == NETCHUNK_SUCCESS) {
+        error = netchunk_chunk_verify_raw(chunk, shards[shard]);
+    }
+    if (error == NETCHUNK_SUCCESS) {
+        if (chunk->data && chunk->data_owned) {
+            free(chunk->data);
+        }
+        chunk->data = NULL;
+        chunk->data_owned = false;
+        error = netchunk_chunk_restore_stored(chunk, context->config->compression_level, shards[shard]);
+        shards[shard] = NULL;
+    }
+
+    for (int i = 0; i < total; i++) {
+        free(shards[i]);
+    }
+    return error;
+}
+
 netchunk_error_t netchunk_verify(netchunk_context_t* context,
     const char* remote_name,
     bool repair,
@@ -482,11 +3487,53 @@ netchunk_error_t netchunk_verify(netchunk_context_t* context,
 
         verified_count++;
 
+        // No replica is intact: restore them in place from a locally cached copy
+        uint8_t* cached = NULL;
+        if (repair && !chunk_ok && context->chunk_cache
+            && netchunk_disk_cache_get(context->chunk_cache, chunk->hash, chunk->size, &cached) == NETCHUNK_SUCCESS) {
+            if (chunk->data && chunk->data_owned) {
+                free(chunk->data);
+            }
+            chunk->data = NULL;
+            chunk->data_owned = false;
+
+            if (netchunk_chunk_restore_stored(chunk, context->config->compression_level, cached) == NETCHUNK_SUCCESS) {
+                for (int loc_idx = 0; loc_idx < chunk->location_count; loc_idx++) {
+                    int server_idx = find_server_index(context, chunk->locations[loc_idx].server_id);
+                    if (server_idx >= 0
+                        && netchunk_ftp_upload_chunk(context->ftp_context, &context->config->servers[server_idx], chunk) == NETCHUNK_SUCCESS) {
+                        healthy_replicas++;
+                        repaired_count++;
+                    }
+                }
+            }
+            chunk_ok = healthy_replicas > 0;
+        }
+
+        // Erasure-coded chunks can be decoded from the rest of their stripe instead
+        if (repair && !chunk_ok && netchunk_manifest_is_erasure_coded(&manifest)
+            && decode_from_stripe(context, &manifest, i) == NETCHUNK_SUCCESS) {
+            for (int loc_idx = 0; loc_idx < chunk->location_count; loc_idx++) {
+                int server_idx = find_server_index(context, chunk->locations[loc_idx].server_id);
+                if (server_idx >= 0
+                    && netchunk_ftp_upload_chunk(context->ftp_context, &context->config->servers[server_idx], chunk) == NETCHUNK_SUCCESS) {
+                    healthy_replicas++;
+                    repaired_count++;
+                }
+            }
+            chunk_ok = healthy_replicas > 0;
+        }
+
+        // Stripe parity stands in for replicas of erasure-coded chunks
+        int replication_target = netchunk_manifest_is_erasure_coded(&manifest)
+            ? manifest.replication_factor
+            : context->config->replication_factor;
+
         // If repair is enabled and chunk needs repair
-        if (repair && (healthy_replicas < context->config->replication_factor) && chunk_ok) {
+        if (repair && (healthy_replicas < replication_target) && chunk_ok) {
             // Re-replicate chunk to meet replication factor
             // This is a simplified repair - a full repair engine would be more sophisticated
-            int target_replicas = context->config->replication_factor - healthy_replicas;
+            int target_replicas = replication_target - healthy_replicas;
 
             for (int server_idx = 0; server_idx < context->config->server_count && target_replicas > 0; server_idx++) {
 
@@ -527,6 +3574,29 @@ netchunk_error_t netchunk_verify(netchunk_context_t* context,
     return NETCHUNK_SUCCESS;
 }
 
+netchunk_error_t netchunk_scrub(netchunk_context_t* context,
+    bool deep,
+    netchunk_scrub_stats_t* stats)
+{
+    if (!context || !context->initialized) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    netchunk_scrubber_t scrubber;
+    netchunk_error_t error = netchunk_scrubber_init(&scrubber, context->config, context->ftp_context, deep);
+    if (error != NETCHUNK_SUCCESS) {
+        return error;
+    }
+
+    error = netchunk_scrubber_run_pass(&scrubber);
+    if (stats) {
+        netchunk_scrubber_get_stats(&scrubber, stats);
+    }
+
+    netchunk_scrubber_cleanup(&scrubber);
+    return error;
+}
+
 netchunk_error_t netchunk_health_check(netchunk_context_t* context,
     uint32_t* healthy_servers,
     uint32_t* total_servers)
@@ -538,11 +3608,26 @@ netchunk_error_t netchunk_health_check(netchunk_context_t* context,
     uint32_t healthy_count = 0;
     uint32_t total_count = context->config->server_count;
 
-    for (int i = 0; i < context->config->server_count; i++) {
-        netchunk_error_t error = netchunk_ftp_test_connection(
-            context->ftp_context, &context->config->servers[i]);
-        if (error == NETCHUNK_SUCCESS) {
-            healthy_count++;
+    if (context->health_monitor) {
+        netchunk_error_t error = netchunk_health_monitor_ensure_probed(context->health_monitor);
+        if (error != NETCHUNK_SUCCESS) {
+            return error;
+        }
+
+        netchunk_health_snapshot_t snapshot;
+        netchunk_health_monitor_read(context->health_monitor, &snapshot);
+        for (int i = 0; i < snapshot.server_count; i++) {
+            if (snapshot.servers[i].checked_at != 0 && snapshot.servers[i].consecutive_failures == 0) {
+                healthy_count++;
+            }
+        }
+    } else {
+        for (int i = 0; i < context->config->server_count; i++) {
+            netchunk_error_t error = netchunk_ftp_test_connection(
+                context->ftp_context, &context->config->servers[i]);
+            if (error == NETCHUNK_SUCCESS) {
+                healthy_count++;
+            }
         }
     }
 
@@ -554,6 +3639,79 @@ netchunk_error_t netchunk_health_check(netchunk_context_t* context,
     return NETCHUNK_SUCCESS;
 }
 
+netchunk_error_t netchunk_get_server_scores(netchunk_context_t* context,
+    netchunk_server_score_t* scores,
+    int max_scores,
+    int* count)
+{
+    if (!context || !context->initialized || !scores || max_scores < 0 || !count) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    *count = 0;
+    for (int i = 0; i < context->config->server_count && i < max_scores; i++) {
+        netchunk_error_t error = netchunk_ftp_engine_get_score(context->ftp_context->engine, i, &scores[i]);
+        if (error != NETCHUNK_SUCCESS) {
+            return error;
+        }
+        (*count)++;
+    }
+
+    return NETCHUNK_SUCCESS;
+}
+
+netchunk_error_t netchunk_get_cache_stats(netchunk_context_t* context, netchunk_cache_stats_t* stats)
+{
+    if (!context || !context->initialized || !context->read_state || !stats) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    memset(stats, 0, sizeof(netchunk_cache_stats_t));
+
+    netchunk_read_state_t* state = context->read_state;
+    pthread_mutex_lock(&state->mutex);
+    stats->memory_hits = state->cache.hits;
+    stats->memory_misses = state->cache.misses;
+    stats->memory_evictions = state->cache.evictions;
+    stats->memory_bytes_used = state->cache.used_bytes;
+    stats->memory_capacity = state->cache.capacity_bytes;
+    pthread_mutex_unlock(&state->mutex);
+
+    if (context->chunk_cache) {
+        netchunk_disk_cache_get_stats(context->chunk_cache, &stats->disk);
+        stats->disk_capacity = context->chunk_cache->capacity_bytes;
+    }
+
+    return NETCHUNK_SUCCESS;
+}
+
+netchunk_error_t netchunk_get_metrics(netchunk_context_t* context, netchunk_metrics_snapshot_t* snapshot)
+{
+    if (!context || !context->initialized || !snapshot) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    if (!context->metrics) {
+        return NETCHUNK_ERROR_CONFIG;
+    }
+
+    netchunk_metrics_read(context->metrics, snapshot);
+    return NETCHUNK_SUCCESS;
+}
+
+netchunk_error_t netchunk_dump_metrics(netchunk_context_t* context)
+{
+    if (!context || !context->initialized) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    if (!context->metrics) {
+        return NETCHUNK_ERROR_CONFIG;
+    }
+
+    return netchunk_metrics_dump(context->metrics);
+}
+
 void netchunk_get_version(int* major, int* minor, int* patch, const char** version_string)
 {
     if (major)
@@ -571,11 +3729,22 @@ void netchunk_cleanup(netchunk_context_t* context)
     if (!context)
         return;
 
+    // Queued removals and probes still need the FTP context
+    close_health_monitor(context);
+    close_delete_queue(context);
+
     if (context->ftp_context) {
         netchunk_ftp_cleanup(context->ftp_context);
         free(context->ftp_context);
         context->ftp_context = NULL;
     }
+    close_metrics(context);
+
+    // Readahead completions ran while the engine drained above
+    destroy_read_state(context);
+    close_chunk_cache(context);
+    drop_dedup_index(context);
+    drop_catalog(context);
 
     if (context->config) {
         netchunk_config_cleanup(context->config);
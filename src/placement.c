@@ -0,0 +1,186 @@
+/**
+ * @file placement.c
+ * @brief Weighted rendezvous hashing of chunks onto servers
+ *
+ * Placements are stored in manifests, but rebalancing recomputes them:
+ * the hashes and the score formula must never change.
+ */
+
+#include "placement.h"
+#include <math.h>
+#include <string.h>
+
+// Internal helper functions
+static uint64_t placement_hash_string(const char* text);
+static uint64_t placement_mix(uint64_t value);
+static bool placement_ranks_before(const netchunk_placement_t* placement,
+    int left,
+    double left_score,
+    int right,
+    double right_score);
+
+netchunk_error_t netchunk_placement_init(netchunk_placement_t* placement,
+    const netchunk_config_t* config,
+    const netchunk_health_snapshot_t* health)
+{
+    if (!placement || !config || config->server_count < 0 || config->server_count > NETCHUNK_MAX_SERVERS) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    memset(placement, 0, sizeof(netchunk_placement_t));
+    placement->server_count = config->server_count;
+
+    if (health && health->server_count != config->server_count) {
+        health = NULL;
+    }
+    if (health) {
+        placement->generation = health->generation;
+    }
+
+    // Servers that did not report free space count as the average bucket
+    int steps[NETCHUNK_MAX_SERVERS] = { 0 };
+    double known_steps = 0.0;
+    int known_count = 0;
+    for (int s = 0; health && s < health->server_count; s++) {
+        const netchunk_server_health_t* server_health = &health->servers[s];
+        steps[s] = netchunk_placement_capacity_step(server_health->bytes_available, server_health->capacity_step);
+        if (steps[s] > 0 && server_health->status != NETCHUNK_SERVER_UNAVAILABLE) {
+            known_steps += steps[s];
+            known_count++;
+        }
+    }
+    double average_step = known_count > 0 ? round(known_steps / known_count) : 0.0;
+
+    for (int s = 0; s < config->server_count; s++) {
+        const netchunk_server_t* server = &config->servers[s];
+        double weight = 1.0;
+
+        if (health) {
+            const netchunk_server_health_t* server_health = &health->servers[s];
+            if (known_count > 0) {
+                // Relative to the average so the weights stay near 1
+                double step = steps[s] > 0 ? steps[s] : average_step;
+                weight = exp2((step - average_step) / NETCHUNK_PLACEMENT_CAPACITY_STEPS);
+            }
+            if (server_health->status == NETCHUNK_SERVER_DEGRADED) {
+                weight *= NETCHUNK_PLACEMENT_DEGRADED_WEIGHT;
+            }
+            placement->usable[s] = server_health->status != NETCHUNK_SERVER_UNAVAILABLE;
+        } else {
+            placement->usable[s] = true;
+        }
+
+        // Lower numbers are preferred; 0 (unset) and 1 weigh the same
+        if (server->priority > 1) {
+            weight /= server->priority;
+        }
+
+        // A full server still orders the unusable tail instead of tying at 0
+        placement->weights[s] = weight > 1e-9 ? weight : 1e-9;
+        placement->seeds[s] = placement_mix(placement_hash_string(server->id));
+    }
+
+    return NETCHUNK_SUCCESS;
+}
+
+double netchunk_placement_score(const netchunk_placement_t* placement, const char* chunk_id, int server_index)
+{
+    if (!placement || !chunk_id || server_index < 0 || server_index >= placement->server_count) {
+        return 0.0;
+    }
+
+    // Uniform draw in (0, 1) from the top 53 bits; -w / ln(u) makes the
+    // chance of the highest score proportional to w
+    uint64_t draw = placement_mix(placement_hash_string(chunk_id) ^ placement->seeds[server_index]);
+    double uniform = ((double)(draw >> 11) + 0.5) / 9007199254740992.0;
+    return -placement->weights[server_index] / log(uniform);
+}
+
+int netchunk_placement_rank(const netchunk_placement_t* placement,
+    const char* chunk_id,
+    int* servers,
+    int max_servers)
+{
+    if (!placement || !chunk_id || !servers || max_servers <= 0) {
+        return 0;
+    }
+
+    int order[NETCHUNK_MAX_SERVERS];
+    double scores[NETCHUNK_MAX_SERVERS];
+    int count = 0;
+
+    // Insertion sort; there are never more than NETCHUNK_MAX_SERVERS
+    for (int s = 0; s < placement->server_count; s++) {
+        double score = netchunk_placement_score(placement, chunk_id, s);
+        int position = count;
+        while (position > 0 && placement_ranks_before(placement, s, score, order[position - 1], scores[position - 1])) {
+            order[position] = order[position - 1];
+            scores[position] = scores[position - 1];
+            position--;
+        }
+        order[position] = s;
+        scores[position] = score;
+        count++;
+    }
+
+    if (count > max_servers) {
+        count = max_servers;
+    }
+    memcpy(servers, order, (size_t)count * sizeof(int));
+    return count;
+}
+
+int netchunk_placement_capacity_step(uint64_t bytes_available, int previous_step)
+{
+    if (bytes_available == 0) {
+        return 0;
+    }
+
+    // A bucket is kept until free space is past its edge by the margin,
+    // so a server hovering at an edge does not flip on every probe
+    double exact = log2((double)bytes_available) * NETCHUNK_PLACEMENT_CAPACITY_STEPS;
+    if (previous_step > 0 && fabs(exact - previous_step) < 0.5 + NETCHUNK_PLACEMENT_CAPACITY_HYSTERESIS) {
+        return previous_step;
+    }
+    return (int)lround(exact);
+}
+
+/**
+ * @brief 64-bit FNV-1a of a string
+ */
+static uint64_t placement_hash_string(const char* text)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    for (const unsigned char* p = (const unsigned char*)text; *p; p++) {
+        hash = (hash ^ *p) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+/**
+ * @brief splitmix64 finalizer, so related inputs give unrelated draws
+ */
+static uint64_t placement_mix(uint64_t value)
+{
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+    return value ^ (value >> 31);
+}
+
+/**
+ * @brief Ranking order: usable servers first, then by score, then by index
+ */
+static bool placement_ranks_before(const netchunk_placement_t* placement,
+    int left,
+    double left_score,
+    int right,
+    double right_score)
+{
+    if (placement->usable[left] != placement->usable[right]) {
+        return placement->usable[left];
+    }
+    if (left_score != right_score) {
+        return left_score > right_score;
+    }
+    return left < right;
+}
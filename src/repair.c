@@ -8,24 +8,18 @@
  */
 
 #include "repair.h"
+#include "compress.h"
+#include "erasure.h"
+#include "fxp.h"
+#include "health_monitor.h"
+#include "netchunk.h"
+#include "placement.h"
+#include "repair_scheduler.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
 
-/**
- * @brief Internal helper to call progress callback safely
- */
-static void call_repair_progress_callback(netchunk_repair_context_t* context,
-    uint32_t current_chunk,
-    uint32_t total_chunks,
-    const netchunk_repair_stats_t* stats)
-{
-    if (context->progress_cb) {
-        context->progress_cb(context->progress_userdata, current_chunk, total_chunks, stats);
-    }
-}
-
 /**
  * @brief Find server configuration by ID
  */
@@ -39,8 +33,54 @@ static netchunk_server_t* find_server_by_id(netchunk_config_t* config, const cha
     return NULL;
 }
 
+/**
+ * @brief Wait for the context's throttle, if any, before a request to a server
+ */
+static void throttle_begin(netchunk_repair_context_t* context, const netchunk_server_t* server, uint64_t bytes)
+{
+    if (context->throttle) {
+        netchunk_repair_throttle_acquire(context->throttle, (int)(server - context->config->servers), bytes);
+    }
+}
+
+/**
+ * @brief Release the throttle slot taken by throttle_begin()
+ */
+static void throttle_end(netchunk_repair_context_t* context, const netchunk_server_t* server)
+{
+    if (context->throttle) {
+        netchunk_repair_throttle_release(context->throttle, (int)(server - context->config->servers));
+    }
+}
+
+/**
+ * @brief Weigh the servers for placement
+ *
+ * Uses the health monitor's snapshot when the FTP context has one.
+ *
+ * @return true if the weights include health, false if by priority alone
+ */
+static bool repair_placement_init(netchunk_repair_context_t* context, netchunk_placement_t* placement)
+{
+    netchunk_health_monitor_t* monitor = context->ftp_context->health_monitor;
+    if (monitor && netchunk_health_monitor_ensure_probed(monitor) == NETCHUNK_SUCCESS) {
+        netchunk_health_snapshot_t snapshot;
+        netchunk_health_monitor_read(monitor, &snapshot);
+        return netchunk_placement_init(placement, context->config, &snapshot) == NETCHUNK_SUCCESS;
+    }
+
+    netchunk_placement_init(placement, context->config, NULL);
+    return false;
+}
+
 /**
  * @brief Select best server for new chunk replica
+ *
+ * The best-ranked server of the chunk's placement that holds no replica
+ * yet, so repaired replicas land where an upload would have put them.
+ * With a health monitor on the FTP context the ranking already puts the
+ * servers it found unavailable last, and those are skipped. Without one
+ * each candidate is probed in rank order.
  */
 static netchunk_server_t* select_server_for_replica(netchunk_repair_context_t* context,
     netchunk_chunk_t* chunk)
@@ -57,23 +97,102 @@ static netchunk_server_t* select_server_for_replica(netchunk_repair_context_t* c
         }
     }
 
-    // Find server with least usage that doesn't already have this chunk
-    int best_server_idx = -1;
-    int min_usage = INT_MAX;
+    netchunk_placement_t placement;
+    bool monitored = repair_placement_init(context, &placement);
+    int ranking[NETCHUNK_MAX_SERVERS];
+    int ranked = netchunk_placement_rank(&placement, chunk->id, ranking, NETCHUNK_MAX_SERVERS);
 
-    for (int s = 0; s < context->config->server_count; s++) {
-        if (server_usage[s] == 0 && server_usage[s] < min_usage) {
-            // Test if server is healthy
-            netchunk_error_t test_result = netchunk_ftp_test_connection(
-                context->ftp_context, &context->config->servers[s]);
-            if (test_result == NETCHUNK_SUCCESS) {
-                min_usage = server_usage[s];
-                best_server_idx = s;
-            }
+    for (int i = 0; i < ranked; i++) {
+        int s = ranking[i];
+        if (server_usage[s] > 0) {
+            continue;
+        }
+        if (monitored) {
+            return placement.usable[s] ? &context->config->servers[s] : NULL;
+        }
+
+        // Test if server is healthy
+        throttle_begin(context, &context->config->servers[s], 0);
+        netchunk_error_t test_result = netchunk_ftp_test_connection(
+            context->ftp_context, &context->config->servers[s]);
+        throttle_end(context, &context->config->servers[s]);
+        if (test_result == NETCHUNK_SUCCESS) {
+            return &context->config->servers[s];
         }
     }
 
-    return (best_server_idx >= 0) ? &context->config->servers[best_server_idx] : NULL;
+    return NULL;
+}
+
+/**
+ * @brief Copy a replica directly from one server to another and verify it
+ *
+ * The verified copy is appended to the chunk's locations. A copy that does
+ * not verify is deleted again and the chunk is left as it was.
+ *
+ * @return true if the target now holds a verified replica
+ */
+static bool copy_replica_fxp(netchunk_repair_context_t* context,
+    netchunk_chunk_t* chunk,
+    netchunk_server_t* source,
+    netchunk_server_t* target)
+{
+    char remote_path[NETCHUNK_MAX_PATH_LEN];
+    if (!netchunk_fxp_supported(source, target) || chunk->location_count >= NETCHUNK_MAX_CHUNK_LOCATIONS
+        || netchunk_ftp_chunk_path(chunk, remote_path, sizeof(remote_path)) != NETCHUNK_SUCCESS) {
+        return false;
+    }
+
+    // The copy loads both servers; take their slots in index order so two
+    // copies in opposite directions cannot wait on each other
+    netchunk_server_t* first = source < target ? source : target;
+    netchunk_server_t* second = source < target ? target : source;
+    size_t stored_size = netchunk_chunk_stored_size(chunk);
+    throttle_begin(context, first, stored_size);
+    throttle_begin(context, second, stored_size);
+    netchunk_error_t error = netchunk_fxp_copy(source, target, remote_path, stored_size,
+        context->config->ftp_timeout);
+    throttle_end(context, second);
+    throttle_end(context, first);
+
+    if (error != NETCHUNK_SUCCESS) {
+        return false;
+    }
+
+    // The source copy was never read here, so check the result like any replica
+    int index = chunk->location_count;
+    netchunk_chunk_location_t* location = &chunk->locations[index];
+    memset(location, 0, sizeof(*location));
+    snprintf(location->server_id, sizeof(location->server_id), "%s", target->id);
+    location->upload_time = time(NULL);
+    chunk->location_count++;
+
+    netchunk_replica_status_t status = NETCHUNK_REPLICA_UNREACHABLE;
+    netchunk_repair_check_replica(context, chunk, index, true, &status, NULL);
+    if (status == NETCHUNK_REPLICA_VERIFIED) {
+        return true;
+    }
+
+    chunk->location_count--;
+    throttle_begin(context, target, 0);
+    netchunk_ftp_delete_chunk(context->ftp_context, target, chunk);
+    throttle_end(context, target);
+    return false;
+}
+
+/**
+ * @brief Map a failed remote check to a replica status
+ */
+static netchunk_replica_status_t replica_status_from_error(netchunk_error_t error)
+{
+    switch (error) {
+    case NETCHUNK_ERROR_FILE_NOT_FOUND:
+        return NETCHUNK_REPLICA_MISSING;
+    case NETCHUNK_ERROR_CHUNK_INTEGRITY:
+        return NETCHUNK_REPLICA_CORRUPT;
+    default:
+        return NETCHUNK_REPLICA_UNREACHABLE;
+    }
 }
 
 netchunk_error_t netchunk_repair_init(netchunk_repair_context_t* context,
@@ -88,6 +207,7 @@ netchunk_error_t netchunk_repair_init(netchunk_repair_context_t* context,
     context->config = config;
     context->ftp_context = ftp_context;
     context->repair_mode = NETCHUNK_REPAIR_AUTO;
+    context->verify_level = NETCHUNK_VERIFY_DEEP;
     context->initialized = true;
 
     return NETCHUNK_SUCCESS;
@@ -106,6 +226,137 @@ netchunk_error_t netchunk_repair_set_progress_callback(netchunk_repair_context_t
     return NETCHUNK_SUCCESS;
 }
 
+netchunk_error_t netchunk_repair_set_chunk_cache(netchunk_repair_context_t* context,
+    netchunk_disk_cache_t* chunk_cache)
+{
+    if (!context || !context->initialized) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    context->chunk_cache = chunk_cache;
+    return NETCHUNK_SUCCESS;
+}
+
+netchunk_error_t netchunk_repair_set_verify_level(netchunk_repair_context_t* context,
+    netchunk_verify_level_t level)
+{
+    if (!context || !context->initialized || level < NETCHUNK_VERIFY_FAST || level > NETCHUNK_VERIFY_FULL) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    context->verify_level = level;
+    return NETCHUNK_SUCCESS;
+}
+
+netchunk_error_t netchunk_repair_check_replica(netchunk_repair_context_t* context,
+    netchunk_chunk_t* chunk,
+    int location_index,
+    bool download,
+    netchunk_replica_status_t* status,
+    uint64_t* bytes_downloaded)
+{
+    if (!context || !context->initialized || !chunk || !status
+        || location_index < 0 || location_index >= chunk->location_count) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    netchunk_chunk_location_t* location = &chunk->locations[location_index];
+    netchunk_server_t* server = find_server_by_id(context->config, location->server_id);
+
+    if (!server) {
+        *status = NETCHUNK_REPLICA_MISSING;
+    } else {
+        // Existence and size cost one round trip and no data
+        uint64_t remote_size = 0;
+        throttle_begin(context, server, 0);
+        netchunk_error_t error = netchunk_ftp_stat_chunk(context->ftp_context, server, chunk, &remote_size);
+        throttle_end(context, server);
+
+        if (error != NETCHUNK_SUCCESS) {
+            *status = replica_status_from_error(error);
+        } else if (remote_size != netchunk_chunk_stored_size(chunk)) {
+            *status = NETCHUNK_REPLICA_CORRUPT;
+        } else {
+            uint8_t remote_hash[NETCHUNK_HASH_LENGTH];
+            *status = NETCHUNK_REPLICA_PRESENT;
+
+            // A server hashes the stored bytes, but compressed or encrypted chunks are hashed raw
+            error = NETCHUNK_ERROR_FTP;
+            if (!netchunk_chunk_is_encoded(chunk)) {
+                throttle_begin(context, server, 0);
+                error = netchunk_ftp_hash_chunk(context->ftp_context, server, chunk, remote_hash);
+                throttle_end(context, server);
+            }
+
+            if (error == NETCHUNK_SUCCESS) {
+                *status = netchunk_hash_compare(remote_hash, chunk->hash, NETCHUNK_HASH_LENGTH)
+                    ? NETCHUNK_REPLICA_VERIFIED
+                    : NETCHUNK_REPLICA_CORRUPT;
+            } else if (download) {
+                // Download into a copy so the caller's chunk data is left alone
+                netchunk_chunk_t copy = *chunk;
+                copy.data = NULL;
+                copy.data_owned = false;
+
+                size_t stored_size = netchunk_chunk_stored_size(&copy);
+                throttle_begin(context, server, stored_size);
+                error = netchunk_ftp_download_chunk(context->ftp_context, server, &copy);
+                throttle_end(context, server);
+                if (error == NETCHUNK_SUCCESS) {
+                    if (bytes_downloaded) {
+                        *bytes_downloaded += stored_size;
+                    }
+                    // Without the chunk's key the copy can be neither trusted nor condemned
+                    error = netchunk_chunk_verify_integrity(&copy);
+                    if (error == NETCHUNK_SUCCESS) {
+                        *status = NETCHUNK_REPLICA_VERIFIED;
+                    } else if (error != NETCHUNK_ERROR_CRYPTO) {
+                        *status = NETCHUNK_REPLICA_CORRUPT;
+                    }
+                    free(copy.data);
+                } else {
+                    *status = replica_status_from_error(error);
+                }
+            }
+        }
+    }
+
+    // Record what was learned; an unreachable server says nothing about its copy
+    if (*status == NETCHUNK_REPLICA_VERIFIED) {
+        location->verified = true;
+        location->last_verified = time(NULL);
+    } else if (*status == NETCHUNK_REPLICA_MISSING || *status == NETCHUNK_REPLICA_CORRUPT) {
+        location->verified = false;
+    }
+
+    return NETCHUNK_SUCCESS;
+}
+
+int netchunk_repair_select_sample(const netchunk_chunk_t* chunk,
+    const netchunk_replica_status_t* statuses)
+{
+    if (!chunk || !statuses) {
+        return -1;
+    }
+
+    int sample = -1;
+    time_t sample_time = 0;
+
+    for (int i = 0; i < chunk->location_count; i++) {
+        if (statuses[i] != NETCHUNK_REPLICA_PRESENT) {
+            continue;
+        }
+
+        time_t verified_at = chunk->locations[i].verified ? chunk->locations[i].last_verified : 0;
+        if (sample < 0 || verified_at < sample_time) {
+            sample = i;
+            sample_time = verified_at;
+        }
+    }
+
+    return sample;
+}
+
 netchunk_error_t netchunk_repair_check_chunk_health(netchunk_repair_context_t* context,
     netchunk_chunk_t* chunk,
     netchunk_chunk_health_t* health,
@@ -115,32 +366,32 @@ netchunk_error_t netchunk_repair_check_chunk_health(netchunk_repair_context_t* c
         return NETCHUNK_ERROR_INVALID_ARGUMENT;
     }
 
-    int healthy_count = 0;
-    int total_locations = chunk->location_count;
+    netchunk_replica_status_t statuses[NETCHUNK_MAX_CHUNK_LOCATIONS];
+    bool download_all = context->verify_level == NETCHUNK_VERIFY_FULL;
 
-    // Check each replica
+    // Check each replica remotely, downloading only at the full level
     for (int i = 0; i < chunk->location_count; i++) {
-        netchunk_server_t* server = find_server_by_id(context->config,
-            chunk->locations[i].server_id);
-        if (!server) {
-            continue;
+        if (netchunk_repair_check_replica(context, chunk, i, download_all, &statuses[i], NULL) != NETCHUNK_SUCCESS) {
+            statuses[i] = NETCHUNK_REPLICA_UNREACHABLE;
         }
+    }
 
-        // Try to download and verify chunk
-        netchunk_chunk_t temp_chunk = *chunk;
-        netchunk_error_t download_result = netchunk_ftp_download_chunk(
-            context->ftp_context, server, &temp_chunk);
+    // Deep checks download one replica the servers could not hash, rotating
+    // through them by verification time
+    if (context->verify_level == NETCHUNK_VERIFY_DEEP) {
+        int sample = netchunk_repair_select_sample(chunk, statuses);
+        netchunk_replica_status_t sample_status;
+        if (sample >= 0
+            && netchunk_repair_check_replica(context, chunk, sample, true, &sample_status, NULL) == NETCHUNK_SUCCESS
+            && sample_status != NETCHUNK_REPLICA_UNREACHABLE) {
+            statuses[sample] = sample_status;
+        }
+    }
 
-        if (download_result == NETCHUNK_SUCCESS) {
-            netchunk_error_t verify_result = netchunk_chunk_verify_integrity(&temp_chunk);
-            if (verify_result == NETCHUNK_SUCCESS) {
-                healthy_count++;
-            }
-            // Clean up temporary chunk data
-            if (temp_chunk.data && temp_chunk.data != chunk->data) {
-                free(temp_chunk.data);
-                temp_chunk.data = NULL;
-            }
+    int healthy_count = 0;
+    for (int i = 0; i < chunk->location_count; i++) {
+        if (statuses[i] == NETCHUNK_REPLICA_PRESENT || statuses[i] == NETCHUNK_REPLICA_VERIFIED) {
+            healthy_count++;
         }
     }
 
@@ -183,8 +434,10 @@ netchunk_error_t netchunk_repair_cleanup_chunk(netchunk_repair_context_t* contex
 
         // Try to verify replica
         netchunk_chunk_t temp_chunk = *chunk;
+        throttle_begin(context, server, netchunk_chunk_stored_size(chunk));
         netchunk_error_t download_result = netchunk_ftp_download_chunk(
             context->ftp_context, server, &temp_chunk);
+        throttle_end(context, server);
 
         bool replica_valid = false;
         if (download_result == NETCHUNK_SUCCESS) {
@@ -205,7 +458,9 @@ netchunk_error_t netchunk_repair_cleanup_chunk(netchunk_repair_context_t* contex
             valid_locations++;
         } else {
             // Remove corrupted replica from server
+            throttle_begin(context, server, 0);
             netchunk_ftp_delete_chunk(context->ftp_context, server, chunk);
+            throttle_end(context, server);
             (*replicas_removed)++;
         }
     }
@@ -234,36 +489,29 @@ netchunk_error_t netchunk_repair_chunk(netchunk_repair_context_t* context,
     netchunk_chunk_t working_chunk = *chunk;
     bool have_valid_data = false;
 
-    // Try to get valid chunk data from existing replicas
-    for (int i = 0; i < chunk->location_count && !have_valid_data; i++) {
-        netchunk_server_t* server = find_server_by_id(context->config,
-            chunk->locations[i].server_id);
-        if (!server)
-            continue;
-
-        netchunk_error_t download_result = netchunk_ftp_download_chunk(
-            context->ftp_context, server, &working_chunk);
-
-        if (download_result == NETCHUNK_SUCCESS) {
-            netchunk_error_t verify_result = netchunk_chunk_verify_integrity(&working_chunk);
-            if (verify_result == NETCHUNK_SUCCESS) {
-                have_valid_data = true;
-            } else {
-                // Clean up bad data
-                if (working_chunk.data && working_chunk.data != chunk->data) {
-                    free(working_chunk.data);
-                    working_chunk.data = NULL;
-                }
-            }
+    // A locally cached copy saves downloading one; it is verified on read
+    if (context->chunk_cache) {
+        uint8_t* cached = NULL;
+        if (netchunk_disk_cache_get(context->chunk_cache, chunk->hash, chunk->size, &cached) == NETCHUNK_SUCCESS
+            && netchunk_chunk_restore_stored(&working_chunk, context->config->compression_level, cached) == NETCHUNK_SUCCESS) {
+            have_valid_data = true;
         }
     }
 
-    if (!have_valid_data) {
-        return NETCHUNK_ERROR_CHUNK_INTEGRITY;
+    // Try existing replicas, the one expected to answer fastest first
+    int sources[NETCHUNK_MAX_SERVERS];
+    int source_count = 0;
+    for (int i = 0; i < chunk->location_count && source_count < NETCHUNK_MAX_SERVERS; i++) {
+        netchunk_server_t* server = find_server_by_id(context->config,
+            chunk->locations[i].server_id);
+        if (server)
+            sources[source_count++] = (int)(server - context->config->servers);
     }
+    netchunk_ftp_engine_rank_servers(context->ftp_context->engine, sources, source_count, netchunk_chunk_stored_size(chunk));
 
     // Now create additional replicas as needed
     int replicas_needed = target_replication - chunk->location_count;
+    bool data_fetched = have_valid_data;
 
     for (int i = 0; i < replicas_needed; i++) {
         netchunk_server_t* target_server = select_server_for_replica(context, chunk);
@@ -271,9 +519,50 @@ netchunk_error_t netchunk_repair_chunk(netchunk_repair_context_t* context,
             break; // No more suitable servers available
         }
 
+        // Servers that accept FXP copy between themselves, bypassing the client
+        bool copied = false;
+        for (int s = 0; s < source_count && !copied; s++) {
+            copied = copy_replica_fxp(context, chunk, &context->config->servers[sources[s]], target_server);
+        }
+        if (copied) {
+            (*replicas_added)++;
+            continue;
+        }
+
+        // Otherwise relay through the client, fetching the data once
+        if (!data_fetched) {
+            data_fetched = true;
+            for (int s = 0; s < source_count && !have_valid_data; s++) {
+                netchunk_server_t* server = &context->config->servers[sources[s]];
+
+                throttle_begin(context, server, netchunk_chunk_stored_size(chunk));
+                netchunk_error_t download_result = netchunk_ftp_download_chunk(
+                    context->ftp_context, server, &working_chunk);
+                throttle_end(context, server);
+
+                if (download_result == NETCHUNK_SUCCESS) {
+                    netchunk_error_t verify_result = netchunk_chunk_verify_integrity(&working_chunk);
+                    if (verify_result == NETCHUNK_SUCCESS) {
+                        have_valid_data = true;
+                    } else {
+                        // Clean up bad data
+                        if (working_chunk.data && working_chunk.data != chunk->data) {
+                            free(working_chunk.data);
+                            working_chunk.data = NULL;
+                        }
+                    }
+                }
+            }
+        }
+        if (!have_valid_data) {
+            break;
+        }
+
         // Upload chunk to selected server
+        throttle_begin(context, target_server, netchunk_chunk_stored_size(&working_chunk));
         netchunk_error_t upload_result = netchunk_ftp_upload_chunk(
             context->ftp_context, target_server, &working_chunk);
+        throttle_end(context, target_server);
 
         if (upload_result == NETCHUNK_SUCCESS) {
             // Add new location to chunk
@@ -296,97 +585,217 @@ netchunk_error_t netchunk_repair_chunk(netchunk_repair_context_t* context,
         free(working_chunk.data);
     }
 
+    // Without a verified copy or readable data there was nothing to repair from
+    if (*replicas_added == 0 && data_fetched && !have_valid_data) {
+        return NETCHUNK_ERROR_CHUNK_INTEGRITY;
+    }
+
     return NETCHUNK_SUCCESS;
 }
 
-netchunk_error_t netchunk_repair_file(netchunk_repair_context_t* context,
-    const char* remote_name,
-    netchunk_repair_mode_t repair_mode,
-    netchunk_repair_stats_t* stats)
+/**
+ * @brief Health of a stripe given how many of its shards are lost
+ */
+static netchunk_chunk_health_t stripe_health(const netchunk_file_manifest_t* manifest, int lost_shards)
 {
-    if (!context || !context->initialized || !remote_name) {
+    if (lost_shards == 0) {
+        return NETCHUNK_CHUNK_HEALTHY;
+    } else if (lost_shards > manifest->ec_parity_shards) {
+        return NETCHUNK_CHUNK_LOST;
+    } else if (lost_shards == manifest->ec_parity_shards) {
+        return NETCHUNK_CHUNK_CRITICAL;
+    }
+    return NETCHUNK_CHUNK_DEGRADED;
+}
+
+netchunk_error_t netchunk_repair_check_stripe_health(netchunk_repair_context_t* context,
+    netchunk_file_manifest_t* manifest,
+    uint32_t stripe,
+    netchunk_chunk_health_t* health,
+    int* healthy_shards)
+{
+    if (!context || !context->initialized || !netchunk_manifest_is_erasure_coded(manifest) || !health
+        || !healthy_shards || stripe >= netchunk_manifest_stripe_count(manifest)) {
         return NETCHUNK_ERROR_INVALID_ARGUMENT;
     }
 
-    netchunk_repair_stats_t local_stats = { 0 };
-    time_t start_time = time(NULL);
-    netchunk_error_t error;
-    netchunk_file_manifest_t manifest;
+    int total = manifest->ec_data_shards + manifest->ec_parity_shards;
+    int lost = 0;
 
-    // Download manifest
-    error = netchunk_ftp_download_manifest(context->ftp_context, context->config,
-        remote_name, &manifest);
-    if (error != NETCHUNK_SUCCESS) {
-        return error;
+    // Data shards past the end of a short stripe are zeros and cannot be lost
+    for (int i = 0; i < total; i++) {
+        netchunk_chunk_t* chunk = netchunk_manifest_stripe_shard(manifest, stripe, i);
+        if (!chunk) {
+            continue;
+        }
+
+        netchunk_chunk_health_t shard_health;
+        int healthy_replicas = 0;
+        netchunk_error_t error = netchunk_repair_check_chunk_health(context, chunk, &shard_health, &healthy_replicas);
+        if (error != NETCHUNK_SUCCESS) {
+            return error;
+        }
+        if (healthy_replicas == 0) {
+            lost++;
+        }
     }
 
-    local_stats.chunks_verified = manifest.chunk_count;
+    *healthy_shards = total - lost;
+    *health = stripe_health(manifest, lost);
+    return NETCHUNK_SUCCESS;
+}
 
-    // Process each chunk
-    for (uint32_t i = 0; i < manifest.chunk_count; i++) {
-        netchunk_chunk_t* chunk = &manifest.chunks[i];
-        netchunk_chunk_health_t health;
-        int healthy_replicas;
+netchunk_error_t netchunk_repair_stripe(netchunk_repair_context_t* context,
+    netchunk_file_manifest_t* manifest,
+    uint32_t stripe,
+    int* shards_rebuilt,
+    int* replicas_removed)
+{
+    if (!context || !context->initialized || !netchunk_manifest_is_erasure_coded(manifest) || !shards_rebuilt
+        || !replicas_removed || stripe >= netchunk_manifest_stripe_count(manifest)) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
 
-        call_repair_progress_callback(context, i, manifest.chunk_count, &local_stats);
+    *shards_rebuilt = 0;
+    *replicas_removed = 0;
 
-        // Check chunk health
-        error = netchunk_repair_check_chunk_health(context, chunk, &health, &healthy_replicas);
-        if (error != NETCHUNK_SUCCESS) {
-            continue; // Skip problematic chunks
+    int total = manifest->ec_data_shards + manifest->ec_parity_shards;
+    bool lost[NETCHUNK_EC_MAX_SHARDS] = { false };
+    int lost_count = 0;
+
+    // Find the lost shards and drop their bad replicas
+    for (int i = 0; i < total; i++) {
+        netchunk_chunk_t* chunk = netchunk_manifest_stripe_shard(manifest, stripe, i);
+        netchunk_chunk_health_t shard_health;
+        int healthy_replicas = 0;
+        if (!chunk || netchunk_repair_check_chunk_health(context, chunk, &shard_health, &healthy_replicas) != NETCHUNK_SUCCESS
+            || healthy_replicas > 0) {
+            continue;
         }
 
-        // Update statistics based on health
-        switch (health) {
-        case NETCHUNK_CHUNK_HEALTHY:
-            local_stats.chunks_healthy++;
-            break;
-        case NETCHUNK_CHUNK_DEGRADED:
-            local_stats.chunks_degraded++;
-            break;
-        case NETCHUNK_CHUNK_CRITICAL:
-            local_stats.chunks_critical++;
-            break;
-        case NETCHUNK_CHUNK_LOST:
-            local_stats.chunks_lost++;
-            break;
+        int removed = 0;
+        netchunk_repair_cleanup_chunk(context, chunk, &removed);
+        *replicas_removed += removed;
+        lost[i] = true;
+        lost_count++;
+    }
+
+    if (lost_count == 0) {
+        return NETCHUNK_SUCCESS;
+    }
+    if (lost_count > manifest->ec_parity_shards) {
+        return NETCHUNK_ERROR_CHUNK_INTEGRITY;
+    }
+
+    size_t shard_size = netchunk_manifest_stripe_shard(manifest, stripe, manifest->ec_data_shards)->size;
+    uint8_t* shards[NETCHUNK_EC_MAX_SHARDS] = { NULL };
+    bool present[NETCHUNK_EC_MAX_SHARDS] = { false };
+    netchunk_error_t error = NETCHUNK_SUCCESS;
+    for (int i = 0; i < total && error == NETCHUNK_SUCCESS; i++) {
+        shards[i] = malloc(shard_size > 0 ? shard_size : 1);
+        if (!shards[i]) {
+            error = NETCHUNK_ERROR_OUT_OF_MEMORY;
         }
+    }
+
+    if (error == NETCHUNK_SUCCESS) {
+        error = netchunk_ec_recover_stripe(context->ftp_context, manifest, stripe, shards, present, shard_size);
+    }
 
-        // Perform repair if needed and enabled
-        if (repair_mode != NETCHUNK_REPAIR_VERIFY_ONLY && health != NETCHUNK_CHUNK_HEALTHY) {
-            // Clean up corrupted replicas first
-            int replicas_removed;
-            netchunk_repair_cleanup_chunk(context, chunk, &replicas_removed);
-            local_stats.replicas_removed += replicas_removed;
-
-            // Add missing replicas if we have valid data
-            if (health != NETCHUNK_CHUNK_LOST) {
-                int replicas_added;
-                error = netchunk_repair_chunk(context, chunk, context->config->replication_factor,
-                    &replicas_added);
-                if (error == NETCHUNK_SUCCESS && replicas_added > 0) {
-                    local_stats.replicas_added += replicas_added;
-                    local_stats.chunks_repaired++;
+    // A stripe survives as many server losses as it has parity only while
+    // its shards stay on distinct servers
+    bool used[NETCHUNK_MAX_SERVERS] = { false };
+    for (int i = 0; i < total && error == NETCHUNK_SUCCESS; i++) {
+        netchunk_chunk_t* chunk = netchunk_manifest_stripe_shard(manifest, stripe, i);
+        for (int l = 0; chunk && l < chunk->location_count; l++) {
+            netchunk_server_t* server = find_server_by_id(context->config, chunk->locations[l].server_id);
+            if (server) {
+                used[server - context->config->servers] = true;
+            }
+        }
+    }
+
+    for (int i = 0; i < total && error == NETCHUNK_SUCCESS; i++) {
+        netchunk_chunk_t* chunk = netchunk_manifest_stripe_shard(manifest, stripe, i);
+        if (!lost[i] || chunk->location_count >= NETCHUNK_MAX_CHUNK_LOCATIONS) {
+            continue;
+        }
+
+        netchunk_chunk_t rebuilt = *chunk;
+        rebuilt.data = shards[i];
+        rebuilt.data_owned = false;
+
+        // Shards are rebuilt raw; encrypted ones get their stored form back first
+        if (netchunk_chunk_is_encoded(chunk)) {
+            rebuilt.data = NULL;
+            error = netchunk_chunk_restore_stored(&rebuilt, context->config->compression_level, shards[i]);
+            shards[i] = NULL;
+            if (error != NETCHUNK_SUCCESS) {
+                break;
+            }
+        }
+
+        // Spare servers first, then any other, rotating with the stripe
+        int server_count = context->config->server_count;
+        netchunk_server_t* target = NULL;
+        for (int pass = 0; pass < 2 && !target; pass++) {
+            for (int n = 0; n < server_count && !target; n++) {
+                int s = (int)((stripe * (uint32_t)total + (uint32_t)i + (uint32_t)n) % (uint32_t)server_count);
+                if (pass == 0 && used[s]) {
+                    continue;
+                }
+
+                netchunk_server_t* server = &context->config->servers[s];
+                throttle_begin(context, server, netchunk_chunk_stored_size(&rebuilt));
+                netchunk_error_t upload_result = netchunk_ftp_upload_chunk(context->ftp_context, server, &rebuilt);
+                throttle_end(context, server);
+                if (upload_result == NETCHUNK_SUCCESS) {
+                    target = server;
+                    used[s] = true;
                 }
             }
         }
+        netchunk_chunk_cleanup(&rebuilt);
+        if (!target) {
+            continue;
+        }
+
+        netchunk_chunk_location_t* location = &chunk->locations[chunk->location_count++];
+        memset(location, 0, sizeof(*location));
+        snprintf(location->server_id, sizeof(location->server_id), "%s", target->id);
+        location->upload_time = time(NULL);
+        (*shards_rebuilt)++;
     }
 
-    // Update manifest with any location changes if repairs were made
-    if (repair_mode != NETCHUNK_REPAIR_VERIFY_ONLY && local_stats.chunks_repaired > 0) {
-        netchunk_ftp_upload_manifest(context->ftp_context, context->config, &manifest);
+    for (int i = 0; i < total; i++) {
+        free(shards[i]);
     }
 
-    local_stats.elapsed_seconds = difftime(time(NULL), start_time);
+    return error;
+}
 
-    call_repair_progress_callback(context, manifest.chunk_count, manifest.chunk_count, &local_stats);
+netchunk_error_t netchunk_repair_file(netchunk_repair_context_t* context,
+    const char* remote_name,
+    netchunk_repair_mode_t repair_mode,
+    netchunk_repair_stats_t* stats)
+{
+    if (!context || !context->initialized || !remote_name) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
 
-    if (stats) {
-        *stats = local_stats;
+    netchunk_file_manifest_t manifest;
+
+    // Download manifest
+    netchunk_error_t error = netchunk_ftp_download_manifest(context->ftp_context, context->config,
+        remote_name, &manifest);
+    if (error != NETCHUNK_SUCCESS) {
+        return error;
     }
 
+    error = netchunk_repair_schedule(context, &manifest, 1, repair_mode, stats);
+
     netchunk_manifest_cleanup(&manifest);
-    return NETCHUNK_SUCCESS;
+    return error;
 }
 
 netchunk_error_t netchunk_repair_all_files(netchunk_repair_context_t* context,
@@ -399,8 +808,6 @@ netchunk_error_t netchunk_repair_all_files(netchunk_repair_context_t* context,
 
     netchunk_file_manifest_t* files;
     size_t file_count;
-    netchunk_repair_stats_t total_stats = { 0 };
-    time_t start_time = time(NULL);
 
     // Get list of all files
     netchunk_error_t error = netchunk_ftp_list_manifests(context->ftp_context,
@@ -409,32 +816,11 @@ netchunk_error_t netchunk_repair_all_files(netchunk_repair_context_t* context,
         return error;
     }
 
-    // Repair each file
-    for (size_t i = 0; i < file_count; i++) {
-        netchunk_repair_stats_t file_stats;
-
-        error = netchunk_repair_file(context, files[i].original_filename, repair_mode, &file_stats);
-        if (error == NETCHUNK_SUCCESS) {
-            // Aggregate statistics
-            total_stats.chunks_verified += file_stats.chunks_verified;
-            total_stats.chunks_healthy += file_stats.chunks_healthy;
-            total_stats.chunks_degraded += file_stats.chunks_degraded;
-            total_stats.chunks_critical += file_stats.chunks_critical;
-            total_stats.chunks_lost += file_stats.chunks_lost;
-            total_stats.chunks_repaired += file_stats.chunks_repaired;
-            total_stats.replicas_added += file_stats.replicas_added;
-            total_stats.replicas_removed += file_stats.replicas_removed;
-        }
-    }
-
-    total_stats.elapsed_seconds = difftime(time(NULL), start_time);
-
-    if (stats) {
-        *stats = total_stats;
-    }
+    // One schedule across all files, so urgent chunks of any file go first
+    error = netchunk_repair_schedule(context, files, file_count, repair_mode, stats);
 
     netchunk_free_file_list(files, file_count);
-    return NETCHUNK_SUCCESS;
+    return error;
 }
 
 netchunk_error_t netchunk_repair_rebalance_chunks(netchunk_repair_context_t* context,
@@ -447,113 +833,78 @@ netchunk_error_t netchunk_repair_rebalance_chunks(netchunk_repair_context_t* con
 
     *moves_performed = 0;
 
-    // Count chunks per server
-    int server_chunk_count[NETCHUNK_MAX_SERVERS] = { 0 };
-    int total_chunks = 0;
+    // Stripe shards are placed by rotation so they never share a server
+    if (netchunk_manifest_is_erasure_coded(manifest)) {
+        return NETCHUNK_SUCCESS;
+    }
+
+    netchunk_config_t* config = context->config;
+    netchunk_placement_t placement;
+    repair_placement_init(context, &placement);
 
     for (uint32_t i = 0; i < manifest->chunk_count; i++) {
         netchunk_chunk_t* chunk = &manifest->chunks[i];
-        for (int j = 0; j < chunk->location_count; j++) {
-            for (int s = 0; s < context->config->server_count; s++) {
-                if (strcmp(chunk->locations[j].server_id,
-                        context->config->servers[s].id)
-                    == 0) {
-                    server_chunk_count[s]++;
-                    total_chunks++;
-                    break;
-                }
+        int ranking[NETCHUNK_MAX_SERVERS];
+        int ranked = netchunk_placement_rank(&placement, chunk->id, ranking, NETCHUNK_MAX_SERVERS);
+
+        // The chunk belongs on the best-ranked usable servers
+        bool wanted[NETCHUNK_MAX_SERVERS] = { false };
+        for (int r = 0, wanted_count = 0; r < ranked && wanted_count < config->replication_factor; r++) {
+            if (placement.usable[ranking[r]]) {
+                wanted[ranking[r]] = true;
+                wanted_count++;
             }
         }
-    }
 
-    if (total_chunks == 0) {
-        return NETCHUNK_SUCCESS;
-    }
+        bool held[NETCHUNK_MAX_SERVERS] = { false };
+        for (int j = 0; j < chunk->location_count; j++) {
+            netchunk_server_t* server = find_server_by_id(config, chunk->locations[j].server_id);
+            if (server) {
+                held[server - config->servers] = true;
+            }
+        }
 
-    // Calculate target distribution
-    int avg_chunks_per_server = total_chunks / context->config->server_count;
-    int remainder = total_chunks % context->config->server_count;
+        // Only replicas off their servers move; missing ones are for repair
+        int misplaced = 0;
+        int vacant = 0;
+        for (int s = 0; s < config->server_count; s++) {
+            misplaced += held[s] && !wanted[s];
+            vacant += wanted[s] && !held[s];
+        }
+        int moves = misplaced < vacant ? misplaced : vacant;
+        if (moves == 0 || chunk->location_count + moves > NETCHUNK_MAX_CHUNK_LOCATIONS) {
+            continue;
+        }
 
-    // Find overloaded and underloaded servers
-    for (int from_server = 0; from_server < context->config->server_count; from_server++) {
-        int target_count = avg_chunks_per_server + (from_server < remainder ? 1 : 0);
+        // New replicas go to the best-ranked servers without one, the vacant ones
+        int added = 0;
+        netchunk_repair_chunk(context, chunk, chunk->location_count + moves, &added);
 
-        while (server_chunk_count[from_server] > target_count) {
-            // Find an underloaded server
-            int to_server = -1;
-            for (int s = 0; s < context->config->server_count; s++) {
-                int s_target = avg_chunks_per_server + (s < remainder ? 1 : 0);
-                if (server_chunk_count[s] < s_target) {
-                    to_server = s;
-                    break;
-                }
+        // Then the worst-ranked misplaced replicas make way for them
+        for (int r = ranked - 1; r >= 0 && added > 0; r--) {
+            int s = ranking[r];
+            if (!held[s] || wanted[s]) {
+                continue;
             }
 
-            if (to_server < 0)
-                break; // No underloaded servers found
-
-            // Find a chunk to move from from_server
-            bool moved = false;
-            for (uint32_t i = 0; i < manifest->chunk_count && !moved; i++) {
-                netchunk_chunk_t* chunk = &manifest->chunks[i];
-
-                // Check if this chunk is on from_server and not on to_server
-                bool on_from_server = false;
-                bool on_to_server = false;
-                int from_location_idx = -1;
-
-                for (int j = 0; j < chunk->location_count; j++) {
-                    if (strcmp(chunk->locations[j].server_id,
-                            context->config->servers[from_server].id)
-                        == 0) {
-                        on_from_server = true;
-                        from_location_idx = j;
-                    }
-                    if (strcmp(chunk->locations[j].server_id,
-                            context->config->servers[to_server].id)
-                        == 0) {
-                        on_to_server = true;
-                    }
-                }
-
-                if (on_from_server && !on_to_server && chunk->location_count < NETCHUNK_MAX_CHUNK_LOCATIONS) {
-                    // Move this chunk replica
-                    netchunk_error_t upload_result = netchunk_ftp_upload_chunk(
-                        context->ftp_context, &context->config->servers[to_server], chunk);
-
-                    if (upload_result == NETCHUNK_SUCCESS) {
-                        // Add new location
-                        netchunk_chunk_location_t new_location;
-                        strncpy(new_location.server_id, context->config->servers[to_server].id,
-                            sizeof(new_location.server_id) - 1);
-                        new_location.server_id[sizeof(new_location.server_id) - 1] = '\0';
-                        new_location.upload_time = time(NULL);
-
-                        chunk->locations[chunk->location_count] = new_location;
-                        chunk->location_count++;
-
-                        // Remove from from_server if we have enough replicas
-                        if (chunk->location_count > context->config->replication_factor) {
-                            netchunk_ftp_delete_chunk(context->ftp_context,
-                                &context->config->servers[from_server], chunk);
-
-                            // Remove location from array
-                            for (int k = from_location_idx; k < chunk->location_count - 1; k++) {
-                                chunk->locations[k] = chunk->locations[k + 1];
-                            }
-                            chunk->location_count--;
-                        }
+            netchunk_server_t* server = &config->servers[s];
+            throttle_begin(context, server, 0);
+            netchunk_error_t error = netchunk_ftp_delete_chunk(context->ftp_context, server, chunk);
+            throttle_end(context, server);
+            if (error != NETCHUNK_SUCCESS) {
+                continue;
+            }
 
-                        server_chunk_count[from_server]--;
-                        server_chunk_count[to_server]++;
-                        (*moves_performed)++;
-                        moved = true;
-                    }
+            for (int j = 0; j < chunk->location_count; j++) {
+                if (strcmp(chunk->locations[j].server_id, server->id) == 0) {
+                    memmove(&chunk->locations[j], &chunk->locations[j + 1],
+                        (size_t)(chunk->location_count - j - 1) * sizeof(netchunk_chunk_location_t));
+                    chunk->location_count--;
+                    break;
                 }
             }
-
-            if (!moved)
-                break; // Couldn't find any chunks to move
+            added--;
+            (*moves_performed)++;
         }
     }
 
@@ -0,0 +1,623 @@
+/**
+ * @file repair_scheduler.c
+ * @brief NetChunk repair scheduler implementation
+ *
+ * Worker threads take the most urgent queued chunk, or else check the next
+ * chunk not looked at yet; a check that finds a chunk unhealthy queues it
+ * so it is repaired ahead of the chunks still unchecked. Erasure-coded
+ * files are checked and repaired a stripe at a time instead of per chunk.
+ */
+
+#include "repair_scheduler.h"
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Shared state of one netchunk_repair_schedule() call
+typedef struct repair_run {
+    netchunk_repair_context_t context; // Copy used by the workers, throttle set
+    netchunk_file_manifest_t* manifests;
+    size_t manifest_count;
+    netchunk_repair_mode_t repair_mode;
+    netchunk_repair_queue_t queue;
+    netchunk_repair_throttle_t throttle;
+    bool* changed; // Per manifest: chunk locations were updated
+
+    // Next chunk to check for the first time
+    size_t scan_file;
+    uint32_t scan_chunk;
+
+    int busy; // Workers running a task
+    int workers_running;
+    uint32_t chunks_done;
+    uint32_t total_chunks;
+    netchunk_repair_stats_t stats;
+
+    pthread_mutex_t mutex;
+    pthread_cond_t work_ready; // A task was queued, or all work is done
+    pthread_cond_t progress; // A chunk finished or a worker exited
+} repair_run_t;
+
+// Internal helper functions
+static bool task_before(const netchunk_repair_task_t* a, const netchunk_repair_task_t* b);
+static uint32_t unit_count(const netchunk_file_manifest_t* manifest);
+static bool recorded_health(const repair_run_t* run, const netchunk_file_manifest_t* manifest, uint32_t index, netchunk_chunk_health_t* health);
+static bool scan_next(repair_run_t* run, netchunk_repair_task_t* task);
+static void run_task(repair_run_t* run, netchunk_repair_task_t* task, bool from_scan);
+static void finish_chunk(repair_run_t* run);
+static void* repair_worker(void* arg);
+static int reserve_locked(netchunk_repair_throttle_t* throttle, int server_index, uint64_t bytes, double now_ms);
+static double monotonic_ms(void);
+
+void netchunk_repair_queue_init(netchunk_repair_queue_t* queue)
+{
+    if (queue) {
+        memset(queue, 0, sizeof(netchunk_repair_queue_t));
+    }
+}
+
+netchunk_error_t netchunk_repair_queue_push(netchunk_repair_queue_t* queue,
+    uint32_t file_index,
+    uint32_t chunk_index,
+    netchunk_chunk_health_t health,
+    bool checked)
+{
+    if (!queue) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    if (queue->count == queue->capacity) {
+        size_t new_capacity = queue->capacity ? queue->capacity * 2 : NETCHUNK_REPAIR_QUEUE_INITIAL_CAPACITY;
+        netchunk_repair_task_t* grown = realloc(queue->tasks, new_capacity * sizeof(netchunk_repair_task_t));
+        if (!grown) {
+            return NETCHUNK_ERROR_OUT_OF_MEMORY;
+        }
+        queue->tasks = grown;
+        queue->capacity = new_capacity;
+    }
+
+    netchunk_repair_task_t task = {
+        .file_index = file_index,
+        .chunk_index = chunk_index,
+        .health = health,
+        .checked = checked,
+        .sequence = queue->next_sequence++
+    };
+
+    // Sift up
+    size_t i = queue->count++;
+    while (i > 0) {
+        size_t parent = (i - 1) / 2;
+        if (!task_before(&task, &queue->tasks[parent])) {
+            break;
+        }
+        queue->tasks[i] = queue->tasks[parent];
+        i = parent;
+    }
+    queue->tasks[i] = task;
+
+    return NETCHUNK_SUCCESS;
+}
+
+bool netchunk_repair_queue_pop(netchunk_repair_queue_t* queue, netchunk_repair_task_t* task)
+{
+    if (!queue || !task || queue->count == 0) {
+        return false;
+    }
+
+    *task = queue->tasks[0];
+    netchunk_repair_task_t last = queue->tasks[--queue->count];
+
+    // Sift the last task down from the root
+    size_t i = 0;
+    for (;;) {
+        size_t child = 2 * i + 1;
+        if (child >= queue->count) {
+            break;
+        }
+        if (child + 1 < queue->count && task_before(&queue->tasks[child + 1], &queue->tasks[child])) {
+            child++;
+        }
+        if (!task_before(&queue->tasks[child], &last)) {
+            break;
+        }
+        queue->tasks[i] = queue->tasks[child];
+        i = child;
+    }
+    if (queue->count > 0) {
+        queue->tasks[i] = last;
+    }
+
+    return true;
+}
+
+void netchunk_repair_queue_cleanup(netchunk_repair_queue_t* queue)
+{
+    if (!queue) {
+        return;
+    }
+
+    free(queue->tasks);
+    memset(queue, 0, sizeof(netchunk_repair_queue_t));
+}
+
+netchunk_error_t netchunk_repair_throttle_init(netchunk_repair_throttle_t* throttle,
+    int max_per_server,
+    uint64_t bandwidth)
+{
+    if (!throttle || max_per_server < 1) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    memset(throttle, 0, sizeof(netchunk_repair_throttle_t));
+    throttle->max_per_server = max_per_server;
+    throttle->bandwidth = bandwidth;
+
+    if (pthread_mutex_init(&throttle->mutex, NULL) != 0) {
+        return NETCHUNK_ERROR_UNKNOWN;
+    }
+    if (pthread_cond_init(&throttle->slot_free, NULL) != 0) {
+        pthread_mutex_destroy(&throttle->mutex);
+        return NETCHUNK_ERROR_UNKNOWN;
+    }
+
+    return NETCHUNK_SUCCESS;
+}
+
+void netchunk_repair_throttle_acquire(netchunk_repair_throttle_t* throttle, int server_index, uint64_t bytes)
+{
+    if (!throttle || server_index < 0 || server_index >= NETCHUNK_MAX_SERVERS) {
+        return;
+    }
+
+    pthread_mutex_lock(&throttle->mutex);
+    while (throttle->active[server_index] >= throttle->max_per_server) {
+        pthread_cond_wait(&throttle->slot_free, &throttle->mutex);
+    }
+    throttle->active[server_index]++;
+    int delay_ms = reserve_locked(throttle, server_index, bytes, monotonic_ms());
+    pthread_mutex_unlock(&throttle->mutex);
+
+    // Sleep with the slot held so the server sees no more than its share
+    if (delay_ms > 0) {
+        struct timespec delay = { delay_ms / 1000, (long)(delay_ms % 1000) * 1000000L };
+        nanosleep(&delay, NULL);
+    }
+}
+
+void netchunk_repair_throttle_release(netchunk_repair_throttle_t* throttle, int server_index)
+{
+    if (!throttle || server_index < 0 || server_index >= NETCHUNK_MAX_SERVERS) {
+        return;
+    }
+
+    pthread_mutex_lock(&throttle->mutex);
+    if (throttle->active[server_index] > 0) {
+        throttle->active[server_index]--;
+    }
+    pthread_cond_broadcast(&throttle->slot_free);
+    pthread_mutex_unlock(&throttle->mutex);
+}
+
+int netchunk_repair_throttle_reserve(netchunk_repair_throttle_t* throttle,
+    int server_index,
+    uint64_t bytes,
+    double now_ms)
+{
+    if (!throttle || server_index < 0 || server_index >= NETCHUNK_MAX_SERVERS) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&throttle->mutex);
+    int delay_ms = reserve_locked(throttle, server_index, bytes, now_ms);
+    pthread_mutex_unlock(&throttle->mutex);
+
+    return delay_ms;
+}
+
+void netchunk_repair_throttle_cleanup(netchunk_repair_throttle_t* throttle)
+{
+    if (!throttle) {
+        return;
+    }
+
+    pthread_cond_destroy(&throttle->slot_free);
+    pthread_mutex_destroy(&throttle->mutex);
+}
+
+netchunk_error_t netchunk_repair_schedule(netchunk_repair_context_t* context,
+    netchunk_file_manifest_t* manifests,
+    size_t manifest_count,
+    netchunk_repair_mode_t repair_mode,
+    netchunk_repair_stats_t* stats)
+{
+    if (!context || !context->initialized || (!manifests && manifest_count > 0)) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    time_t start_time = time(NULL);
+    repair_run_t* run = calloc(1, sizeof(repair_run_t));
+    if (!run) {
+        return NETCHUNK_ERROR_OUT_OF_MEMORY;
+    }
+
+    run->context = *context;
+    run->manifests = manifests;
+    run->manifest_count = manifest_count;
+    run->repair_mode = repair_mode;
+    run->changed = calloc(manifest_count > 0 ? manifest_count : 1, sizeof(bool));
+    netchunk_repair_queue_init(&run->queue);
+
+    netchunk_error_t error = run->changed ? NETCHUNK_SUCCESS : NETCHUNK_ERROR_OUT_OF_MEMORY;
+    if (error == NETCHUNK_SUCCESS) {
+        error = netchunk_repair_throttle_init(&run->throttle, context->config->repair_max_per_server,
+            context->config->repair_bandwidth);
+    }
+    if (error != NETCHUNK_SUCCESS) {
+        free(run->changed);
+        free(run);
+        return error;
+    }
+    run->context.throttle = &run->throttle;
+
+    // Chunks the manifests already show as under-replicated go first
+    for (size_t f = 0; f < manifest_count && error == NETCHUNK_SUCCESS; f++) {
+        uint32_t units = unit_count(&manifests[f]);
+        run->total_chunks += units;
+        for (uint32_t c = 0; c < units; c++) {
+            netchunk_chunk_health_t health;
+            if (recorded_health(run, &manifests[f], c, &health)) {
+                error = netchunk_repair_queue_push(&run->queue, (uint32_t)f, c, health, false);
+                if (error != NETCHUNK_SUCCESS) {
+                    break;
+                }
+            }
+        }
+    }
+    run->stats.chunks_verified = run->total_chunks;
+
+    if (error == NETCHUNK_SUCCESS) {
+        pthread_mutex_init(&run->mutex, NULL);
+        pthread_cond_init(&run->work_ready, NULL);
+        pthread_cond_init(&run->progress, NULL);
+
+        int worker_target = context->config->repair_workers;
+        if (worker_target < 1) {
+            worker_target = 1;
+        }
+        if ((uint32_t)worker_target > run->total_chunks) {
+            worker_target = (int)run->total_chunks;
+        }
+
+        pthread_t workers[NETCHUNK_MAX_REPAIR_WORKERS];
+        int worker_count = 0;
+
+        // Workers wait for the lock, so none can exit before it is counted
+        pthread_mutex_lock(&run->mutex);
+        for (int i = 0; i < worker_target && i < NETCHUNK_MAX_REPAIR_WORKERS; i++) {
+            if (pthread_create(&workers[worker_count], NULL, repair_worker, run) != 0) {
+                break;
+            }
+            worker_count++;
+            run->workers_running++;
+        }
+        pthread_mutex_unlock(&run->mutex);
+
+        if (worker_count == 0 && worker_target > 0) {
+            // No threads to be had; do the work on this one
+            run->workers_running = 1;
+            repair_worker(run);
+        }
+
+        // Report chunks as they finish until every worker is done
+        uint32_t reported = 0;
+        pthread_mutex_lock(&run->mutex);
+        for (;;) {
+            if (reported != run->chunks_done && context->progress_cb) {
+                reported = run->chunks_done;
+                netchunk_repair_stats_t snapshot = run->stats;
+                pthread_mutex_unlock(&run->mutex);
+                context->progress_cb(context->progress_userdata, reported, run->total_chunks, &snapshot);
+                pthread_mutex_lock(&run->mutex);
+                continue;
+            }
+            if (run->workers_running == 0) {
+                break;
+            }
+            pthread_cond_wait(&run->progress, &run->mutex);
+        }
+        pthread_mutex_unlock(&run->mutex);
+
+        for (int i = 0; i < worker_count; i++) {
+            pthread_join(workers[i], NULL);
+        }
+
+        pthread_cond_destroy(&run->progress);
+        pthread_cond_destroy(&run->work_ready);
+        pthread_mutex_destroy(&run->mutex);
+
+        // Update manifests with any location changes
+        if (repair_mode != NETCHUNK_REPAIR_VERIFY_ONLY) {
+            for (size_t f = 0; f < manifest_count; f++) {
+                if (run->changed[f]) {
+                    netchunk_ftp_upload_manifest(context->ftp_context, context->config, &manifests[f]);
+                }
+            }
+        }
+
+        run->stats.elapsed_seconds = difftime(time(NULL), start_time);
+
+        if (context->progress_cb) {
+            context->progress_cb(context->progress_userdata, run->total_chunks, run->total_chunks, &run->stats);
+        }
+
+        if (stats) {
+            *stats = run->stats;
+        }
+    }
+
+    netchunk_repair_throttle_cleanup(&run->throttle);
+    netchunk_repair_queue_cleanup(&run->queue);
+    free(run->changed);
+    free(run);
+
+    return error;
+}
+
+/**
+ * @brief Whether a should be repaired before b
+ */
+static bool task_before(const netchunk_repair_task_t* a, const netchunk_repair_task_t* b)
+{
+    if (a->health != b->health) {
+        return a->health > b->health;
+    }
+    return a->sequence < b->sequence;
+}
+
+/**
+ * @brief Chunks of a manifest to schedule, or stripes if it is erasure-coded
+ */
+static uint32_t unit_count(const netchunk_file_manifest_t* manifest)
+{
+    return netchunk_manifest_is_erasure_coded(manifest) ? netchunk_manifest_stripe_count(manifest) : manifest->chunk_count;
+}
+
+/**
+ * @brief Health a chunk's (or stripe's) manifest entries imply, if it needs repair
+ */
+static bool recorded_health(const repair_run_t* run, const netchunk_file_manifest_t* manifest, uint32_t index, netchunk_chunk_health_t* health)
+{
+    // A stripe needs repair once any shard has no replica left
+    if (netchunk_manifest_is_erasure_coded(manifest)) {
+        int total = manifest->ec_data_shards + manifest->ec_parity_shards;
+        int lost = 0;
+        for (int i = 0; i < total; i++) {
+            const netchunk_chunk_t* shard = netchunk_manifest_stripe_shard(manifest, index, i);
+            if (shard && shard->location_count == 0) {
+                lost++;
+            }
+        }
+
+        if (lost == 0) {
+            return false;
+        } else if (lost > manifest->ec_parity_shards) {
+            *health = NETCHUNK_CHUNK_LOST;
+        } else if (lost == manifest->ec_parity_shards) {
+            *health = NETCHUNK_CHUNK_CRITICAL;
+        } else {
+            *health = NETCHUNK_CHUNK_DEGRADED;
+        }
+        return true;
+    }
+
+    const netchunk_chunk_t* chunk = &manifest->chunks[index];
+    if (chunk->location_count >= run->context.config->replication_factor) {
+        return false;
+    }
+
+    if (chunk->location_count == 0) {
+        *health = NETCHUNK_CHUNK_LOST;
+    } else if (chunk->location_count == 1) {
+        *health = NETCHUNK_CHUNK_CRITICAL;
+    } else {
+        *health = NETCHUNK_CHUNK_DEGRADED;
+    }
+    return true;
+}
+
+/**
+ * @brief Take the next chunk not queued from its manifest entry; call with the lock held
+ */
+static bool scan_next(repair_run_t* run, netchunk_repair_task_t* task)
+{
+    while (run->scan_file < run->manifest_count) {
+        netchunk_file_manifest_t* manifest = &run->manifests[run->scan_file];
+        while (run->scan_chunk < unit_count(manifest)) {
+            uint32_t index = run->scan_chunk++;
+            netchunk_chunk_health_t health;
+            if (!recorded_health(run, manifest, index, &health)) {
+                memset(task, 0, sizeof(netchunk_repair_task_t));
+                task->file_index = (uint32_t)run->scan_file;
+                task->chunk_index = index;
+                task->health = NETCHUNK_CHUNK_HEALTHY;
+                return true;
+            }
+        }
+        run->scan_file++;
+        run->scan_chunk = 0;
+    }
+    return false;
+}
+
+/**
+ * @brief Check a chunk if its health is not known yet, then repair it if needed
+ */
+static void run_task(repair_run_t* run, netchunk_repair_task_t* task, bool from_scan)
+{
+    netchunk_repair_context_t* context = &run->context;
+    netchunk_file_manifest_t* manifest = &run->manifests[task->file_index];
+    bool striped = netchunk_manifest_is_erasure_coded(manifest);
+    netchunk_chunk_t* chunk = striped ? NULL : &manifest->chunks[task->chunk_index];
+    bool repairing = run->repair_mode != NETCHUNK_REPAIR_VERIFY_ONLY;
+
+    if (!task->checked) {
+        int healthy_replicas;
+        netchunk_error_t error = striped
+            ? netchunk_repair_check_stripe_health(context, manifest, task->chunk_index, &task->health, &healthy_replicas)
+            : netchunk_repair_check_chunk_health(context, chunk, &task->health, &healthy_replicas);
+
+        pthread_mutex_lock(&run->mutex);
+        if (error != NETCHUNK_SUCCESS) {
+            pthread_mutex_unlock(&run->mutex);
+            finish_chunk(run); // Skip problematic chunks
+            return;
+        }
+
+        // Update statistics based on health
+        switch (task->health) {
+        case NETCHUNK_CHUNK_HEALTHY:
+            run->stats.chunks_healthy++;
+            break;
+        case NETCHUNK_CHUNK_DEGRADED:
+            run->stats.chunks_degraded++;
+            break;
+        case NETCHUNK_CHUNK_CRITICAL:
+            run->stats.chunks_critical++;
+            break;
+        case NETCHUNK_CHUNK_LOST:
+            run->stats.chunks_lost++;
+            break;
+        }
+
+        // Found unhealthy while checking: wait behind more urgent chunks
+        if (from_scan && repairing && task->health != NETCHUNK_CHUNK_HEALTHY
+            && netchunk_repair_queue_push(&run->queue, task->file_index, task->chunk_index, task->health, true)
+                == NETCHUNK_SUCCESS) {
+            pthread_cond_signal(&run->work_ready);
+            pthread_mutex_unlock(&run->mutex);
+            return;
+        }
+        pthread_mutex_unlock(&run->mutex);
+    }
+
+    // Perform repair if needed and enabled
+    if (repairing && task->health != NETCHUNK_CHUNK_HEALTHY) {
+        int replicas_removed = 0;
+        int replicas_added = 0;
+
+        if (striped) {
+            // Lost shards are decoded from the rest of the stripe
+            if (netchunk_repair_stripe(context, manifest, task->chunk_index, &replicas_added, &replicas_removed)
+                != NETCHUNK_SUCCESS) {
+                replicas_added = 0;
+            }
+        } else {
+            // Clean up corrupted replicas first
+            netchunk_repair_cleanup_chunk(context, chunk, &replicas_removed);
+        }
+
+        // Add missing replicas if we have valid data
+        if (!striped && task->health != NETCHUNK_CHUNK_LOST) {
+            if (netchunk_repair_chunk(context, chunk, context->config->replication_factor, &replicas_added)
+                != NETCHUNK_SUCCESS) {
+                replicas_added = 0;
+            }
+        }
+
+        pthread_mutex_lock(&run->mutex);
+        run->stats.replicas_removed += replicas_removed;
+        run->stats.replicas_added += replicas_added;
+        if (replicas_added > 0) {
+            run->stats.chunks_repaired++;
+        }
+        if (replicas_added > 0 || replicas_removed > 0) {
+            run->changed[task->file_index] = true;
+        }
+        pthread_mutex_unlock(&run->mutex);
+    }
+
+    finish_chunk(run);
+}
+
+/**
+ * @brief Count a chunk as done and wake the progress reporter
+ */
+static void finish_chunk(repair_run_t* run)
+{
+    pthread_mutex_lock(&run->mutex);
+    run->chunks_done++;
+    pthread_cond_signal(&run->progress);
+    pthread_mutex_unlock(&run->mutex);
+}
+
+/**
+ * @brief Worker thread: run queued tasks first, then check unchecked chunks
+ */
+static void* repair_worker(void* arg)
+{
+    repair_run_t* run = (repair_run_t*)arg;
+
+    pthread_mutex_lock(&run->mutex);
+    for (;;) {
+        netchunk_repair_task_t task;
+        bool from_scan = false;
+
+        if (!netchunk_repair_queue_pop(&run->queue, &task)) {
+            from_scan = scan_next(run, &task);
+            if (!from_scan) {
+                // Busy workers may still queue repairs
+                if (run->busy == 0) {
+                    pthread_cond_broadcast(&run->work_ready);
+                    break;
+                }
+                pthread_cond_wait(&run->work_ready, &run->mutex);
+                continue;
+            }
+        }
+
+        run->busy++;
+        pthread_mutex_unlock(&run->mutex);
+
+        run_task(run, &task, from_scan);
+
+        pthread_mutex_lock(&run->mutex);
+        run->busy--;
+        if (run->busy == 0 && run->queue.count == 0) {
+            pthread_cond_broadcast(&run->work_ready);
+        }
+    }
+
+    run->workers_running--;
+    pthread_cond_signal(&run->progress);
+    pthread_mutex_unlock(&run->mutex);
+
+    return NULL;
+}
+
+/**
+ * @brief Reserve a server's bandwidth for a request; call with the lock held
+ */
+static int reserve_locked(netchunk_repair_throttle_t* throttle, int server_index, uint64_t bytes, double now_ms)
+{
+    if (throttle->bandwidth == 0 || bytes == 0) {
+        return 0;
+    }
+
+    double start_ms = throttle->next_free_ms[server_index] > now_ms ? throttle->next_free_ms[server_index] : now_ms;
+    throttle->next_free_ms[server_index] = start_ms + (double)bytes * 1000.0 / (double)throttle->bandwidth;
+
+    double delay_ms = start_ms - now_ms;
+    return delay_ms >= (double)INT_MAX ? INT_MAX : (int)delay_ms;
+}
+
+/**
+ * @brief Current monotonic time in milliseconds
+ */
+static double monotonic_ms(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec * 1000.0 + (double)now.tv_nsec / 1000000.0;
+}
@@ -0,0 +1,382 @@
+/**
+ * @file scrub.c
+ * @brief Rate-limited background verification of stored replicas
+ *
+ * Re-checks every replica once per scrub interval, using server-side
+ * checks wherever possible so that verifying a store costs a few round
+ * trips per replica instead of downloading all of it.
+ */
+
+#include "scrub.h"
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Internal helper functions
+static netchunk_error_t scrub_start_pass(netchunk_scrubber_t* scrubber, time_t now, int* delay_ms);
+static void scrub_finish_pass(netchunk_scrubber_t* scrubber, time_t now);
+static uint64_t scrub_chunk(netchunk_scrubber_t* scrubber, netchunk_chunk_t* chunk, time_t now);
+static void scrub_count_status(netchunk_scrub_stats_t* stats, netchunk_replica_status_t status);
+static void scrub_save_manifest(netchunk_scrubber_t* scrubber);
+static void scrub_close_manifest(netchunk_scrubber_t* scrubber);
+static int scrub_seconds_to_ms(time_t seconds);
+
+netchunk_error_t netchunk_scrubber_init(netchunk_scrubber_t* scrubber,
+    netchunk_config_t* config,
+    netchunk_ftp_context_t* ftp_context,
+    bool deep)
+{
+    if (!scrubber || !config || !ftp_context) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    memset(scrubber, 0, sizeof(netchunk_scrubber_t));
+
+    netchunk_error_t error = netchunk_repair_init(&scrubber->repair, config, ftp_context);
+    if (error != NETCHUNK_SUCCESS) {
+        return error;
+    }
+
+    scrubber->config = config;
+    scrubber->ftp_context = ftp_context;
+    scrubber->deep = deep;
+    scrubber->interval = config->scrub_interval;
+    scrubber->bandwidth = config->scrub_bandwidth;
+
+    return NETCHUNK_SUCCESS;
+}
+
+netchunk_error_t netchunk_scrubber_step(netchunk_scrubber_t* scrubber, int* delay_ms)
+{
+    if (!scrubber || !scrubber->config || !delay_ms) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    *delay_ms = 0;
+    time_t now = time(NULL);
+
+    if (!scrubber->pass_active) {
+        if (now < scrubber->next_pass) {
+            *delay_ms = scrub_seconds_to_ms(scrubber->next_pass - now);
+            return NETCHUNK_SUCCESS;
+        }
+        return scrub_start_pass(scrubber, now, delay_ms);
+    }
+
+    if (!scrubber->manifest_loaded) {
+        if (scrubber->file_index >= scrubber->file_count) {
+            scrub_finish_pass(scrubber, now);
+            *delay_ms = scrub_seconds_to_ms(scrubber->next_pass - now);
+            return NETCHUNK_SUCCESS;
+        }
+
+        const netchunk_ftp_manifest_entry_t* entry = &scrubber->files[scrubber->file_index];
+        const netchunk_server_t* server = &scrubber->config->servers[entry->server_index];
+        if (netchunk_ftp_download_manifest_from(scrubber->ftp_context, server, entry->name,
+                &scrubber->manifest)
+            == NETCHUNK_SUCCESS) {
+            scrubber->manifest_loaded = true;
+            scrubber->chunk_index = 0;
+            scrubber->chunks_changed = 0;
+        } else {
+            // Deleted since the listing, or unreadable until the next pass
+            scrubber->file_index++;
+        }
+
+        *delay_ms = netchunk_scrub_delay_ms(entry->size, scrubber->bandwidth);
+        return NETCHUNK_SUCCESS;
+    }
+
+    if (scrubber->chunk_index >= scrubber->manifest.chunk_count) {
+        scrub_close_manifest(scrubber);
+        return NETCHUNK_SUCCESS;
+    }
+
+    netchunk_chunk_t* chunk = &scrubber->manifest.chunks[scrubber->chunk_index++];
+    uint64_t cost = scrub_chunk(scrubber, chunk, now);
+
+    // Keep work on large files from being lost if the scrubber stops
+    if (scrubber->chunks_changed >= NETCHUNK_SCRUB_SAVE_INTERVAL) {
+        scrub_save_manifest(scrubber);
+    }
+
+    *delay_ms = netchunk_scrub_delay_ms(cost, scrubber->bandwidth);
+    return NETCHUNK_SUCCESS;
+}
+
+netchunk_error_t netchunk_scrubber_run_pass(netchunk_scrubber_t* scrubber)
+{
+    if (!scrubber || !scrubber->config) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    // Start now rather than when the schedule says
+    if (!scrubber->pass_active) {
+        scrubber->next_pass = 0;
+    }
+
+    uint32_t passes = scrubber->stats.passes_completed;
+    while (scrubber->stats.passes_completed == passes) {
+        int delay_ms;
+        netchunk_error_t error = netchunk_scrubber_step(scrubber, &delay_ms);
+        if (error != NETCHUNK_SUCCESS) {
+            return error;
+        }
+
+        if (scrubber->stats.passes_completed == passes && delay_ms > 0) {
+            struct timespec pause = { .tv_sec = delay_ms / 1000, .tv_nsec = (long)(delay_ms % 1000) * 1000000L };
+            nanosleep(&pause, NULL);
+        }
+    }
+
+    return NETCHUNK_SUCCESS;
+}
+
+void netchunk_scrubber_get_stats(const netchunk_scrubber_t* scrubber, netchunk_scrub_stats_t* stats)
+{
+    if (!scrubber || !stats) {
+        return;
+    }
+
+    *stats = scrubber->stats;
+}
+
+void netchunk_scrubber_cleanup(netchunk_scrubber_t* scrubber)
+{
+    if (!scrubber || !scrubber->config) {
+        return;
+    }
+
+    if (scrubber->manifest_loaded) {
+        scrub_save_manifest(scrubber);
+        netchunk_manifest_cleanup(&scrubber->manifest);
+        scrubber->manifest_loaded = false;
+    }
+
+    free(scrubber->files);
+    scrubber->files = NULL;
+    scrubber->file_count = 0;
+    scrubber->pass_active = false;
+
+    netchunk_repair_cleanup(&scrubber->repair);
+    scrubber->config = NULL;
+    scrubber->ftp_context = NULL;
+}
+
+bool netchunk_scrub_replica_due(const netchunk_chunk_location_t* location, time_t now, int interval)
+{
+    if (!location) {
+        return false;
+    }
+
+    if (!location->verified || interval <= 0) {
+        return true;
+    }
+
+    // A timestamp from the future cannot be trusted to be recent
+    if (location->last_verified > now) {
+        return true;
+    }
+
+    return now - location->last_verified >= (time_t)interval;
+}
+
+int netchunk_scrub_delay_ms(uint64_t cost_bytes, uint64_t bandwidth)
+{
+    if (bandwidth == 0 || cost_bytes == 0) {
+        return 0;
+    }
+
+    uint64_t seconds = cost_bytes / bandwidth;
+    if (seconds >= (uint64_t)(INT_MAX / 1000)) {
+        return INT_MAX;
+    }
+
+    // The remainder is below bandwidth, so scaling it cannot overflow
+    uint64_t delay = seconds * 1000 + (cost_bytes % bandwidth) * 1000 / bandwidth;
+    return delay > (uint64_t)INT_MAX ? INT_MAX : (int)delay;
+}
+
+/**
+ * @brief List the manifests to scrub and begin a pass
+ */
+static netchunk_error_t scrub_start_pass(netchunk_scrubber_t* scrubber, time_t now, int* delay_ms)
+{
+    netchunk_ftp_manifest_entry_t* files = NULL;
+    size_t file_count = 0;
+    netchunk_error_t error = netchunk_ftp_list_manifest_entries(scrubber->ftp_context, scrubber->config,
+        &files, &file_count, NULL);
+    if (error != NETCHUNK_SUCCESS) {
+        scrubber->next_pass = now + NETCHUNK_SCRUB_RETRY_DELAY;
+        *delay_ms = scrub_seconds_to_ms(NETCHUNK_SCRUB_RETRY_DELAY);
+        return error;
+    }
+
+    scrubber->files = files;
+    scrubber->file_count = file_count;
+    scrubber->file_index = 0;
+    scrubber->pass_active = true;
+    scrubber->pass_started = now;
+
+    *delay_ms = netchunk_scrub_delay_ms(NETCHUNK_SCRUB_REQUEST_COST * (uint64_t)scrubber->config->server_count,
+        scrubber->bandwidth);
+    return NETCHUNK_SUCCESS;
+}
+
+/**
+ * @brief End a pass and schedule the next one an interval after it started
+ */
+static void scrub_finish_pass(netchunk_scrubber_t* scrubber, time_t now)
+{
+    free(scrubber->files);
+    scrubber->files = NULL;
+    scrubber->file_count = 0;
+    scrubber->file_index = 0;
+    scrubber->pass_active = false;
+    scrubber->stats.passes_completed++;
+
+    scrubber->next_pass = scrubber->interval > 0 ? scrubber->pass_started + scrubber->interval : now;
+}
+
+/**
+ * @brief Check the due replicas of one chunk; returns the bytes charged
+ */
+static uint64_t scrub_chunk(netchunk_scrubber_t* scrubber, netchunk_chunk_t* chunk, time_t now)
+{
+    netchunk_replica_status_t statuses[NETCHUNK_MAX_CHUNK_LOCATIONS];
+    bool checked[NETCHUNK_MAX_CHUNK_LOCATIONS];
+    netchunk_chunk_location_t before[NETCHUNK_MAX_CHUNK_LOCATIONS];
+    int location_count = chunk->location_count;
+    uint64_t cost = 0;
+
+    memcpy(before, chunk->locations, (size_t)location_count * sizeof(netchunk_chunk_location_t));
+
+    for (int i = 0; i < location_count; i++) {
+        // Skipped replicas must not be picked for download either
+        statuses[i] = NETCHUNK_REPLICA_UNREACHABLE;
+        checked[i] = netchunk_scrub_replica_due(&chunk->locations[i], now, scrubber->interval);
+        if (!checked[i]) {
+            scrubber->stats.replicas_skipped++;
+            continue;
+        }
+
+        if (netchunk_repair_check_replica(&scrubber->repair, chunk, i, false, &statuses[i], NULL) != NETCHUNK_SUCCESS) {
+            statuses[i] = NETCHUNK_REPLICA_UNREACHABLE;
+        }
+        cost += NETCHUNK_SCRUB_REQUEST_COST;
+    }
+
+    // One download per chunk and pass; the replica verified longest ago goes next
+    if (scrubber->deep) {
+        int sample = netchunk_repair_select_sample(chunk, statuses);
+        netchunk_replica_status_t sample_status;
+        uint64_t downloaded = 0;
+        if (sample >= 0
+            && netchunk_repair_check_replica(&scrubber->repair, chunk, sample, true, &sample_status, &downloaded) == NETCHUNK_SUCCESS
+            && sample_status != NETCHUNK_REPLICA_UNREACHABLE) {
+            statuses[sample] = sample_status;
+        }
+        scrubber->stats.bytes_downloaded += downloaded;
+        cost += downloaded;
+    }
+
+    bool changed = false;
+    for (int i = 0; i < location_count; i++) {
+        if (!checked[i]) {
+            continue;
+        }
+        scrub_count_status(&scrubber->stats, statuses[i]);
+
+        if (chunk->locations[i].verified != before[i].verified
+            || chunk->locations[i].last_verified != before[i].last_verified) {
+            changed = true;
+        }
+    }
+
+    scrubber->stats.chunks_scrubbed++;
+    if (changed) {
+        scrubber->chunks_changed++;
+    }
+
+    return cost;
+}
+
+/**
+ * @brief Count one checked replica under its outcome
+ */
+static void scrub_count_status(netchunk_scrub_stats_t* stats, netchunk_replica_status_t status)
+{
+    stats->replicas_checked++;
+
+    switch (status) {
+    case NETCHUNK_REPLICA_VERIFIED:
+        stats->replicas_verified++;
+        break;
+    case NETCHUNK_REPLICA_PRESENT:
+        stats->replicas_present++;
+        break;
+    case NETCHUNK_REPLICA_MISSING:
+        stats->replicas_missing++;
+        break;
+    case NETCHUNK_REPLICA_CORRUPT:
+        stats->replicas_corrupt++;
+        break;
+    case NETCHUNK_REPLICA_UNREACHABLE:
+        stats->replicas_unreachable++;
+        break;
+    }
+}
+
+/**
+ * @brief Write verification times back into the file's manifest
+ *
+ * Only if the stored manifest is still the one that was scrubbed; a file
+ * uploaded again in the meantime keeps its new manifest.
+ */
+static void scrub_save_manifest(netchunk_scrubber_t* scrubber)
+{
+    if (scrubber->chunks_changed == 0) {
+        return;
+    }
+
+    netchunk_file_manifest_t current;
+    if (netchunk_ftp_download_manifest(scrubber->ftp_context, scrubber->config,
+            scrubber->manifest.original_filename, &current)
+        == NETCHUNK_SUCCESS) {
+        bool unchanged = strcmp(current.manifest_id, scrubber->manifest.manifest_id) == 0
+            && current.created_timestamp == scrubber->manifest.created_timestamp
+            && current.chunk_count == scrubber->manifest.chunk_count;
+        netchunk_manifest_cleanup(&current);
+
+        if (unchanged) {
+            netchunk_ftp_upload_manifest(scrubber->ftp_context, scrubber->config, &scrubber->manifest);
+        }
+    }
+
+    scrubber->chunks_changed = 0;
+}
+
+/**
+ * @brief Finish the current file and move on to the next one
+ */
+static void scrub_close_manifest(netchunk_scrubber_t* scrubber)
+{
+    scrub_save_manifest(scrubber);
+    netchunk_manifest_cleanup(&scrubber->manifest);
+    scrubber->manifest_loaded = false;
+    scrubber->stats.files_scrubbed++;
+    scrubber->file_index++;
+}
+
+/**
+ * @brief Convert a wait in seconds to a step delay
+ */
+static int scrub_seconds_to_ms(time_t seconds)
+{
+    if (seconds <= 0) {
+        return 0;
+    }
+
+    return seconds > (time_t)(INT_MAX / 1000) ? INT_MAX : (int)(seconds * 1000);
+}
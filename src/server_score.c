@@ -0,0 +1,296 @@
+/**
+ * @file server_score.c
+ * @brief Latency, throughput and error scoring of FTP servers
+ *
+ * Keeps moving averages of how each server has been performing so reads
+ * can pick the replica that is expected to answer first.
+ */
+
+#include "server_score.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Internal helper functions
+static double score_ewma(double average, double sample, uint64_t samples);
+static bool score_valid_index(const netchunk_scoreboard_t* board, int server_index);
+static void score_add_latency(netchunk_server_score_t* score, double latency_ms);
+static void score_end_transfer(netchunk_server_score_t* score);
+static void score_add_duration(netchunk_scoreboard_t* board, int server_index, double duration_ms);
+static int compare_durations(const void* a, const void* b);
+
+void netchunk_scoreboard_init(netchunk_scoreboard_t* board, int server_count)
+{
+    if (!board) {
+        return;
+    }
+
+    memset(board, 0, sizeof(netchunk_scoreboard_t));
+    if (server_count < 0) {
+        server_count = 0;
+    }
+    board->server_count = server_count < NETCHUNK_MAX_SERVERS ? server_count : NETCHUNK_MAX_SERVERS;
+}
+
+void netchunk_scoreboard_begin(netchunk_scoreboard_t* board, int server_index)
+{
+    if (!score_valid_index(board, server_index)) {
+        return;
+    }
+
+    board->servers[server_index].in_flight++;
+}
+
+void netchunk_scoreboard_record_success(netchunk_scoreboard_t* board,
+    int server_index,
+    double latency_ms,
+    uint64_t bytes,
+    double transfer_ms)
+{
+    if (!score_valid_index(board, server_index)) {
+        return;
+    }
+
+    netchunk_server_score_t* score = &board->servers[server_index];
+
+    // The transfer shared the server with the others still in flight
+    int concurrency = score->in_flight > 0 ? score->in_flight : 1;
+    score_end_transfer(score);
+
+    score_add_latency(score, latency_ms);
+
+    if (bytes >= NETCHUNK_SCORE_MIN_THROUGHPUT_BYTES && transfer_ms >= 1.0) {
+        double rate = (double)bytes * 1000.0 / transfer_ms * (double)concurrency;
+        score->throughput_bps = score->throughput_bps > 0.0
+            ? score_ewma(score->throughput_bps, rate, score->successes)
+            : rate;
+        score_add_duration(board, server_index, latency_ms + transfer_ms);
+    }
+
+    score->error_rate = score_ewma(score->error_rate, 0.0, score->samples);
+    score->consecutive_failures = 0;
+    score->samples++;
+}
+
+void netchunk_scoreboard_record_failure(netchunk_scoreboard_t* board, int server_index, double now_ms)
+{
+    if (!score_valid_index(board, server_index)) {
+        return;
+    }
+
+    netchunk_server_score_t* score = &board->servers[server_index];
+    score_end_transfer(score);
+    netchunk_scoreboard_record_probe(board, server_index, false, 0.0, now_ms);
+}
+
+void netchunk_scoreboard_cancel(netchunk_scoreboard_t* board, int server_index, double elapsed_ms)
+{
+    if (!score_valid_index(board, server_index)) {
+        return;
+    }
+
+    netchunk_server_score_t* score = &board->servers[server_index];
+    score_end_transfer(score);
+
+    // Only a lower bound, so it can raise the estimate but never lower it
+    if (score->successes > 0 && elapsed_ms > score->latency_ms) {
+        score->latency_ms = score_ewma(score->latency_ms, elapsed_ms, score->successes);
+    }
+}
+
+void netchunk_scoreboard_record_probe(netchunk_scoreboard_t* board,
+    int server_index,
+    bool success,
+    double latency_ms,
+    double now_ms)
+{
+    if (!score_valid_index(board, server_index)) {
+        return;
+    }
+
+    netchunk_server_score_t* score = &board->servers[server_index];
+
+    if (success) {
+        score_add_latency(score, latency_ms);
+        score->error_rate = score_ewma(score->error_rate, 0.0, score->samples);
+        score->consecutive_failures = 0;
+    } else {
+        score->error_rate = score_ewma(score->error_rate, 1.0, score->samples);
+        score->consecutive_failures++;
+        score->last_failure_ms = now_ms;
+    }
+    score->samples++;
+}
+
+bool netchunk_server_score_healthy(const netchunk_server_score_t* score, double now_ms)
+{
+    if (!score) {
+        return false;
+    }
+
+    if (score->consecutive_failures < NETCHUNK_SCORE_FAILURE_THRESHOLD) {
+        return true;
+    }
+
+    return now_ms - score->last_failure_ms >= (double)NETCHUNK_SCORE_RETRY_INTERVAL_MS;
+}
+
+double netchunk_server_score_cost(const netchunk_server_score_t* score, size_t size)
+{
+    if (!score || score->samples == 0) {
+        return 0.0;
+    }
+    if (score->successes == 0) {
+        return HUGE_VAL;
+    }
+
+    double cost = score->latency_ms;
+    if (score->throughput_bps > 0.0) {
+        // A new transfer gets an equal share of the server with those running
+        cost += (double)size * 1000.0 * (double)(score->in_flight + 1) / score->throughput_bps;
+    }
+
+    // Expected number of attempts until one succeeds
+    double error_rate = score->error_rate < NETCHUNK_SCORE_MAX_ERROR_RATE ? score->error_rate : NETCHUNK_SCORE_MAX_ERROR_RATE;
+    return cost / (1.0 - error_rate);
+}
+
+void netchunk_scoreboard_rank(const netchunk_scoreboard_t* board,
+    int* server_indices,
+    int count,
+    size_t size,
+    double now_ms)
+{
+    if (!board || !server_indices || count < 2 || count > NETCHUNK_MAX_SERVERS) {
+        return;
+    }
+
+    bool healthy[NETCHUNK_MAX_SERVERS];
+    double cost[NETCHUNK_MAX_SERVERS];
+    for (int i = 0; i < count; i++) {
+        if (score_valid_index(board, server_indices[i])) {
+            const netchunk_server_score_t* score = &board->servers[server_indices[i]];
+            healthy[i] = netchunk_server_score_healthy(score, now_ms);
+            cost[i] = netchunk_server_score_cost(score, size);
+        } else {
+            healthy[i] = false;
+            cost[i] = 0.0;
+        }
+    }
+
+    // Insertion sort: replica lists are short and the order must be stable
+    for (int i = 1; i < count; i++) {
+        int server = server_indices[i];
+        bool server_healthy = healthy[i];
+        double server_cost = cost[i];
+        int j = i - 1;
+        while (j >= 0 && ((server_healthy && !healthy[j]) || (server_healthy == healthy[j] && server_cost < cost[j]))) {
+            server_indices[j + 1] = server_indices[j];
+            healthy[j + 1] = healthy[j];
+            cost[j + 1] = cost[j];
+            j--;
+        }
+        server_indices[j + 1] = server;
+        healthy[j + 1] = server_healthy;
+        cost[j + 1] = server_cost;
+    }
+}
+
+double netchunk_scoreboard_p95(const netchunk_scoreboard_t* board, int server_index)
+{
+    if (!score_valid_index(board, server_index)) {
+        return 0.0;
+    }
+
+    return board->servers[server_index].p95_ms;
+}
+
+netchunk_error_t netchunk_scoreboard_get(const netchunk_scoreboard_t* board,
+    int server_index,
+    double now_ms,
+    netchunk_server_score_t* score)
+{
+    if (!score_valid_index(board, server_index) || !score) {
+        return NETCHUNK_ERROR_INVALID_ARGUMENT;
+    }
+
+    *score = board->servers[server_index];
+    score->healthy = netchunk_server_score_healthy(score, now_ms);
+    return NETCHUNK_SUCCESS;
+}
+
+/**
+ * @brief Fold a sample into a moving average; the first sample sets it
+ */
+static double score_ewma(double average, double sample, uint64_t samples)
+{
+    if (samples == 0) {
+        return sample;
+    }
+    return average + NETCHUNK_SCORE_EWMA_ALPHA * (sample - average);
+}
+
+/**
+ * @brief Check a server index against the board
+ */
+static bool score_valid_index(const netchunk_scoreboard_t* board, int server_index)
+{
+    return board && server_index >= 0 && server_index < board->server_count;
+}
+
+/**
+ * @brief Fold in the latency of a successful attempt
+ */
+static void score_add_latency(netchunk_server_score_t* score, double latency_ms)
+{
+    if (latency_ms < 0.0) {
+        latency_ms = 0.0;
+    }
+    score->latency_ms = score_ewma(score->latency_ms, latency_ms, score->successes);
+    score->successes++;
+}
+
+/**
+ * @brief Take a finished transfer off the server's load
+ */
+static void score_end_transfer(netchunk_server_score_t* score)
+{
+    if (score->in_flight > 0) {
+        score->in_flight--;
+    }
+}
+
+/**
+ * @brief Add a transfer duration to the history and refresh the p95
+ */
+static void score_add_duration(netchunk_scoreboard_t* board, int server_index, double duration_ms)
+{
+    netchunk_score_history_t* history = &board->history[server_index];
+
+    history->durations_ms[history->next] = duration_ms;
+    history->next = (history->next + 1) % NETCHUNK_SCORE_HISTORY;
+    if (history->count < NETCHUNK_SCORE_HISTORY) {
+        history->count++;
+    }
+
+    if (history->count < NETCHUNK_SCORE_MIN_HISTORY) {
+        return;
+    }
+
+    // Nearest rank on a sorted copy; the history is small
+    double sorted[NETCHUNK_SCORE_HISTORY];
+    memcpy(sorted, history->durations_ms, (size_t)history->count * sizeof(double));
+    qsort(sorted, (size_t)history->count, sizeof(double), compare_durations);
+    int rank = (int)ceil(0.95 * (double)history->count) - 1;
+    board->servers[server_index].p95_ms = sorted[rank];
+}
+
+/**
+ * @brief qsort comparator for durations, ascending
+ */
+static int compare_durations(const void* a, const void* b)
+{
+    double first = *(const double*)a;
+    double second = *(const double*)b;
+    return (first > second) - (first < second);
+}
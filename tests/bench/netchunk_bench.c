@@ -0,0 +1,1001 @@
+/**
+ * NetChunk benchmark suite
+ *
+ * Measures the library's hot paths and prints one JSON object per result
+ * line on stdout, so runs can be collected and compared between releases:
+ *
+ *   sha256    single-stream and batch hashing on every available backend
+ *   chunker   netchunk_chunker_next_chunk() over a file, fixed and CDC
+ *   manifest  JSON and packed manifest encoding and decoding
+ *   e2e       netchunk_upload() and netchunk_download() of a file against
+ *             mock FTP servers with injected latency, bandwidth and failures
+ *
+ * The mock servers listen on loopback, so the end-to-end run measures the
+ * public entry points with the real FTP client, transfer pipeline,
+ * placement and codecs; only the far end of the connection is simulated.
+ */
+
+#include "chunker.h"
+#include "cipher.h"
+#include "compress.h"
+#include "config.h"
+#include "crypto.h"
+#include "manifest.h"
+#include "manifest_pack.h"
+#include "metrics.h"
+#include "mock_ftp.h"
+#include "netchunk.h"
+#include <dirent.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define BENCH_MAX_MANIFEST_SIZES 8
+#define BENCH_FILL_BLOCK (1024 * 1024)
+#define BENCH_REMOTE_NAME "bench.bin"
+#define BENCH_USERNAME "bench"
+#define BENCH_PASSWORD "bench"
+#define BENCH_PORT 21
+#define BENCH_BASE_PATH "/netchunk"
+
+// Benchmark selection
+#define BENCH_SHA256 0x1
+#define BENCH_CHUNKER 0x2
+#define BENCH_MANIFEST 0x4
+#define BENCH_E2E 0x8
+#define BENCH_ALL (BENCH_SHA256 | BENCH_CHUNKER | BENCH_MANIFEST | BENCH_E2E)
+
+typedef struct bench_options {
+    int suites; // BENCH_* flags
+    double min_time; // Seconds each hashing measurement runs for at least
+    size_t sha_size; // Message size for hashing
+    size_t file_size; // Input size for the chunker and end-to-end runs
+    size_t chunk_size; // Target chunk size
+    bool text_data; // Compressible text instead of random bytes
+    uint32_t manifest_chunks[BENCH_MAX_MANIFEST_SIZES];
+    int manifest_sizes;
+    int servers;
+    int replicas;
+    uint32_t latency_min_ms;
+    uint32_t latency_max_ms;
+    uint64_t bandwidth; // Bytes per second per server, 0 = unlimited
+    double failure_rate; // Connection, upload and download failure probability
+    netchunk_compression_t compression;
+    bool encrypt;
+    uint64_t seed;
+    char temp_dir[NETCHUNK_MAX_PATH_LEN];
+} bench_options_t;
+
+// Mock servers of an end-to-end run and the library context using them
+typedef struct bench_cluster {
+    int server_count;
+    mock_ftp_server_t* servers[MOCK_FTP_MAX_SERVERS];
+    netchunk_context_t context;
+    bool initialized;
+    char storage_path[NETCHUNK_MAX_PATH_LEN]; // Temporary local_storage_path, holds the config too
+    char config_path[NETCHUNK_MAX_PATH_LEN + 16];
+    char key_path[NETCHUNK_MAX_PATH_LEN + 16];
+} bench_cluster_t;
+
+// Helpers
+
+static uint64_t bench_random(uint64_t* state)
+{
+    // xorshift64*
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return *state * 2685821657736338717ULL;
+}
+
+static void bench_fill(uint8_t* data, size_t size, bool text, uint64_t* state)
+{
+    static const char* const words[] = {
+        "chunk ", "server ", "replica ", "manifest ", "upload ", "download ",
+        "verify ", "repair ", "stripe ", "parity ", "hash ", "the ", "of ", "\n"
+    };
+    const size_t word_count = sizeof(words) / sizeof(words[0]);
+
+    size_t i = 0;
+    if (!text) {
+        for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+            uint64_t value = bench_random(state);
+            memcpy(data + i, &value, sizeof(value));
+        }
+    }
+    while (i < size) {
+        if (text) {
+            const char* word = words[bench_random(state) % word_count];
+            size_t length = strlen(word);
+            if (length > size - i) {
+                length = size - i;
+            }
+            memcpy(data + i, word, length);
+            i += length;
+        } else {
+            data[i++] = (uint8_t)bench_random(state);
+        }
+    }
+}
+
+static double bench_seconds_since(uint64_t start_ns)
+{
+    return (double)(netchunk_metrics_now_ns() - start_ns) / 1e9;
+}
+
+static double bench_mb_per_s(uint64_t bytes, double seconds)
+{
+    return seconds > 0 ? (double)bytes / 1e6 / seconds : 0.0;
+}
+
+static bool parse_size(const char* text, uint64_t* value)
+{
+    char* end;
+    unsigned long long number = strtoull(text, &end, 10);
+    if (end == text) {
+        return false;
+    }
+
+    uint64_t scale = 1;
+    switch (*end) {
+    case 'k':
+    case 'K':
+        scale = 1024ULL;
+        end++;
+        break;
+    case 'm':
+    case 'M':
+        scale = 1024ULL * 1024;
+        end++;
+        break;
+    case 'g':
+    case 'G':
+        scale = 1024ULL * 1024 * 1024;
+        end++;
+        break;
+    default:
+        break;
+    }
+    if (*end != '\0') {
+        return false;
+    }
+
+    *value = (uint64_t)number * scale;
+    return true;
+}
+
+static bool parse_suites(const char* text, int* suites)
+{
+    char list[256];
+    snprintf(list, sizeof(list), "%s", text);
+
+    *suites = 0;
+    for (char* name = strtok(list, ","); name; name = strtok(NULL, ",")) {
+        if (strcmp(name, "all") == 0) {
+            *suites |= BENCH_ALL;
+        } else if (strcmp(name, "sha256") == 0) {
+            *suites |= BENCH_SHA256;
+        } else if (strcmp(name, "chunker") == 0) {
+            *suites |= BENCH_CHUNKER;
+        } else if (strcmp(name, "manifest") == 0) {
+            *suites |= BENCH_MANIFEST;
+        } else if (strcmp(name, "e2e") == 0) {
+            *suites |= BENCH_E2E;
+        } else {
+            return false;
+        }
+    }
+    return *suites != 0;
+}
+
+static bool parse_manifest_sizes(const char* text, bench_options_t* options)
+{
+    char list[256];
+    snprintf(list, sizeof(list), "%s", text);
+
+    options->manifest_sizes = 0;
+    for (char* item = strtok(list, ","); item; item = strtok(NULL, ",")) {
+        uint64_t count;
+        if (options->manifest_sizes == BENCH_MAX_MANIFEST_SIZES || !parse_size(item, &count) || count == 0 || count > UINT32_MAX) {
+            return false;
+        }
+        options->manifest_chunks[options->manifest_sizes++] = (uint32_t)count;
+    }
+    return options->manifest_sizes > 0;
+}
+
+static bool parse_latency(const char* text, bench_options_t* options)
+{
+    unsigned int min_ms, max_ms;
+    int fields = sscanf(text, "%u-%u", &min_ms, &max_ms);
+    if (fields < 1) {
+        return false;
+    }
+    if (fields == 1) {
+        max_ms = min_ms;
+    }
+    if (max_ms < min_ms) {
+        return false;
+    }
+
+    options->latency_min_ms = min_ms;
+    options->latency_max_ms = max_ms;
+    return true;
+}
+
+/**
+ * @brief Create an empty file to work in, removed by the caller
+ */
+static bool bench_temp_path(const bench_options_t* options, const char* suffix, char* path, size_t size)
+{
+    snprintf(path, size, "%s/netchunk-bench-%s-XXXXXX", options->temp_dir, suffix);
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        return false;
+    }
+    close(fd);
+    return true;
+}
+
+/**
+ * @brief Write file_size bytes of benchmark data to a new temporary file
+ */
+static bool bench_write_input(const bench_options_t* options, char* path, size_t size)
+{
+    if (!bench_temp_path(options, "input", path, size)) {
+        return false;
+    }
+
+    FILE* file = fopen(path, "wb");
+    uint8_t* block = malloc(BENCH_FILL_BLOCK);
+    bool ok = file && block;
+
+    uint64_t state = options->seed;
+    for (size_t written = 0; ok && written < options->file_size; written += BENCH_FILL_BLOCK) {
+        size_t length = options->file_size - written < BENCH_FILL_BLOCK ? options->file_size - written : BENCH_FILL_BLOCK;
+        bench_fill(block, length, options->text_data, &state);
+        ok = fwrite(block, 1, length, file) == length;
+    }
+
+    free(block);
+    if (file && fclose(file) != 0) {
+        ok = false;
+    }
+    if (!ok) {
+        unlink(path);
+    }
+    return ok;
+}
+
+// SHA-256
+
+static void bench_sha256_stream(const bench_options_t* options, netchunk_sha256_backend_t backend, const uint8_t* data)
+{
+    uint8_t hash[NETCHUNK_SHA256_DIGEST_LENGTH];
+    uint64_t iterations = 0;
+    uint64_t start_ns = netchunk_metrics_now_ns();
+    double seconds;
+    do {
+        netchunk_sha256_hash(data, options->sha_size, hash);
+        iterations++;
+        seconds = bench_seconds_since(start_ns);
+    } while (seconds < options->min_time);
+
+    uint64_t bytes = iterations * options->sha_size;
+    printf("{\"bench\":\"sha256\",\"backend\":\"%s\",\"mode\":\"stream\",\"message_size\":%zu,"
+           "\"iterations\":%llu,\"seconds\":%.6f,\"mb_per_s\":%.2f}\n",
+        netchunk_sha256_backend_name(backend), options->sha_size, (unsigned long long)iterations,
+        seconds, bench_mb_per_s(bytes, seconds));
+}
+
+static void bench_sha256_batch(const bench_options_t* options, netchunk_sha256_backend_t backend, const uint8_t* data)
+{
+    const uint8_t* messages[NETCHUNK_SHA256_MAX_LANES];
+    size_t lengths[NETCHUNK_SHA256_MAX_LANES];
+    uint8_t digests[NETCHUNK_SHA256_MAX_LANES][NETCHUNK_SHA256_DIGEST_LENGTH];
+    uint8_t* hashes[NETCHUNK_SHA256_MAX_LANES];
+    for (int lane = 0; lane < NETCHUNK_SHA256_MAX_LANES; lane++) {
+        messages[lane] = data + (size_t)lane * options->sha_size;
+        lengths[lane] = options->sha_size;
+        hashes[lane] = digests[lane];
+    }
+
+    uint64_t iterations = 0;
+    uint64_t start_ns = netchunk_metrics_now_ns();
+    double seconds;
+    do {
+        netchunk_sha256_hash_batch(messages, lengths, NETCHUNK_SHA256_MAX_LANES, hashes);
+        iterations++;
+        seconds = bench_seconds_since(start_ns);
+    } while (seconds < options->min_time);
+
+    uint64_t bytes = iterations * NETCHUNK_SHA256_MAX_LANES * options->sha_size;
+    printf("{\"bench\":\"sha256\",\"backend\":\"%s\",\"mode\":\"batch\",\"message_size\":%zu,"
+           "\"messages\":%d,\"iterations\":%llu,\"seconds\":%.6f,\"mb_per_s\":%.2f}\n",
+        netchunk_sha256_backend_name(backend), options->sha_size, NETCHUNK_SHA256_MAX_LANES,
+        (unsigned long long)iterations, seconds, bench_mb_per_s(bytes, seconds));
+}
+
+static int bench_sha256(const bench_options_t* options)
+{
+    uint8_t* data = malloc(options->sha_size * NETCHUNK_SHA256_MAX_LANES);
+    if (!data) {
+        fprintf(stderr, "sha256: out of memory\n");
+        return 1;
+    }
+    uint64_t state = options->seed;
+    bench_fill(data, options->sha_size * NETCHUNK_SHA256_MAX_LANES, false, &state);
+
+    for (int b = 0; b < NETCHUNK_SHA256_BACKEND_COUNT; b++) {
+        netchunk_sha256_backend_t backend = (netchunk_sha256_backend_t)b;
+        if (!netchunk_sha256_backend_available(backend)) {
+            continue;
+        }
+
+        // AVX2 only replaces batch hashing; keep the detected single-stream backend under it
+        netchunk_sha256_set_backend(NETCHUNK_SHA256_BACKEND_AUTO);
+        if (netchunk_sha256_set_backend(backend) != NETCHUNK_SUCCESS) {
+            continue;
+        }
+        if (backend != NETCHUNK_SHA256_BACKEND_AVX2) {
+            bench_sha256_stream(options, backend, data);
+        }
+        bench_sha256_batch(options, backend, data);
+        fflush(stdout);
+    }
+
+    netchunk_sha256_set_backend(NETCHUNK_SHA256_BACKEND_AUTO);
+    free(data);
+    return 0;
+}
+
+// Chunker
+
+static int bench_chunker_mode(const bench_options_t* options, const char* path, netchunk_chunking_mode_t mode)
+{
+    netchunk_chunker_context_t chunker;
+    netchunk_error_t error = netchunk_chunker_init(&chunker, path, options->chunk_size);
+    if (error == NETCHUNK_SUCCESS) {
+        error = netchunk_chunker_set_mode(&chunker, mode);
+    }
+    if (error != NETCHUNK_SUCCESS) {
+        fprintf(stderr, "chunker: %s\n", netchunk_error_string(error));
+        return 1;
+    }
+
+    uint32_t chunks = 0;
+    uint64_t bytes = 0;
+    uint64_t start_ns = netchunk_metrics_now_ns();
+    for (;;) {
+        netchunk_chunk_t chunk;
+        error = netchunk_chunker_next_chunk(&chunker, &chunk);
+        if (error != NETCHUNK_SUCCESS) {
+            break;
+        }
+        chunks++;
+        bytes += chunk.size;
+        netchunk_chunk_cleanup(&chunk);
+    }
+    double seconds = bench_seconds_since(start_ns);
+    netchunk_chunker_cleanup(&chunker);
+
+    if (error != NETCHUNK_ERROR_EOF) {
+        fprintf(stderr, "chunker: %s\n", netchunk_error_string(error));
+        return 1;
+    }
+
+    printf("{\"bench\":\"chunker\",\"mode\":\"%s\",\"file_size\":%llu,\"chunk_size\":%zu,"
+           "\"chunks\":%u,\"average_chunk\":%.0f,\"seconds\":%.6f,\"mb_per_s\":%.2f}\n",
+        netchunk_chunking_mode_to_string(mode), (unsigned long long)bytes, options->chunk_size, chunks,
+        chunks > 0 ? (double)bytes / chunks : 0.0, seconds, bench_mb_per_s(bytes, seconds));
+    fflush(stdout);
+    return 0;
+}
+
+static int bench_chunker(const bench_options_t* options)
+{
+    char path[NETCHUNK_MAX_PATH_LEN];
+    if (!bench_write_input(options, path, sizeof(path))) {
+        fprintf(stderr, "chunker: cannot write input file in %s\n", options->temp_dir);
+        return 1;
+    }
+
+    // Chunking reads the file right after it was written, so it runs from the page cache
+    int failed = bench_chunker_mode(options, path, NETCHUNK_CHUNKING_FIXED);
+    failed |= bench_chunker_mode(options, path, NETCHUNK_CHUNKING_CDC);
+
+    unlink(path);
+    return failed;
+}
+
+// Manifest
+
+/**
+ * @brief Build a manifest of replicated chunks with random hashes
+ */
+static netchunk_error_t bench_build_manifest(const bench_options_t* options,
+    uint32_t chunk_count,
+    netchunk_file_manifest_t* manifest)
+{
+    netchunk_error_t error = netchunk_manifest_init(manifest, BENCH_REMOTE_NAME,
+        (size_t)chunk_count * options->chunk_size);
+    if (error == NETCHUNK_SUCCESS) {
+        error = netchunk_manifest_reserve_chunks(manifest, chunk_count);
+    }
+    if (error != NETCHUNK_SUCCESS) {
+        return error;
+    }
+    manifest->chunk_size = options->chunk_size;
+    manifest->replication_factor = options->replicas;
+
+    uint64_t state = options->seed;
+    time_t now = time(NULL);
+    for (uint32_t i = 0; i < chunk_count && error == NETCHUNK_SUCCESS; i++) {
+        netchunk_chunk_t chunk;
+        netchunk_chunk_init(&chunk, i, options->chunk_size);
+        bench_fill(chunk.hash, NETCHUNK_HASH_LENGTH, false, &state);
+        netchunk_chunk_set_content_id(&chunk);
+        chunk.offset = (size_t)i * options->chunk_size;
+
+        for (int r = 0; r < options->replicas && r < NETCHUNK_MAX_CHUNK_LOCATIONS; r++) {
+            netchunk_chunk_location_t* location = &chunk.locations[chunk.location_count++];
+            snprintf(location->server_id, sizeof(location->server_id), "bench_%d",
+                (int)((i + (uint32_t)r) % (uint32_t)options->servers) + 1);
+            location->upload_time = now;
+        }
+
+        error = netchunk_manifest_add_chunk(manifest, &chunk);
+    }
+
+    bench_fill(manifest->file_hash, NETCHUNK_HASH_LENGTH, false, &state);
+    return error;
+}
+
+static void bench_manifest_report(const char* format, const char* op, uint32_t chunks, size_t bytes, double seconds)
+{
+    printf("{\"bench\":\"manifest\",\"format\":\"%s\",\"op\":\"%s\",\"chunks\":%u,\"bytes\":%zu,"
+           "\"seconds\":%.6f,\"chunks_per_s\":%.0f,\"mb_per_s\":%.2f}\n",
+        format, op, chunks, bytes, seconds, seconds > 0 ? chunks / seconds : 0.0,
+        bench_mb_per_s(bytes, seconds));
+    fflush(stdout);
+}
+
+static int bench_manifest_size(const bench_options_t* options, uint32_t chunk_count)
+{
+    netchunk_file_manifest_t manifest;
+    netchunk_error_t error = bench_build_manifest(options, chunk_count, &manifest);
+    if (error != NETCHUNK_SUCCESS) {
+        fprintf(stderr, "manifest: %u chunks: %s\n", chunk_count, netchunk_error_string(error));
+        netchunk_file_manifest_cleanup(&manifest);
+        return 1;
+    }
+
+    // JSON export format
+    char* json = NULL;
+    uint64_t start_ns = netchunk_metrics_now_ns();
+    error = netchunk_file_manifest_to_json(&manifest, &json);
+    double seconds = bench_seconds_since(start_ns);
+    if (error == NETCHUNK_SUCCESS) {
+        size_t json_size = strlen(json);
+        bench_manifest_report("json", "encode", chunk_count, json_size, seconds);
+
+        netchunk_file_manifest_t parsed;
+        start_ns = netchunk_metrics_now_ns();
+        error = netchunk_file_manifest_from_json(json, &parsed);
+        seconds = bench_seconds_since(start_ns);
+        if (error == NETCHUNK_SUCCESS) {
+            bench_manifest_report("json", "decode", chunk_count, json_size, seconds);
+            netchunk_file_manifest_cleanup(&parsed);
+        }
+        free(json);
+    }
+
+    // Packed storage format
+    netchunk_packed_manifest_t packed;
+    if (error == NETCHUNK_SUCCESS) {
+        start_ns = netchunk_metrics_now_ns();
+        error = netchunk_manifest_pack(&manifest, &packed);
+        seconds = bench_seconds_since(start_ns);
+    }
+    if (error == NETCHUNK_SUCCESS) {
+        bench_manifest_report("packed", "encode", chunk_count, packed.size, seconds);
+
+        // What opening a downloaded manifest costs
+        netchunk_packed_manifest_t loaded;
+        start_ns = netchunk_metrics_now_ns();
+        error = netchunk_packed_manifest_from_buffer(&loaded, packed.base, packed.size);
+        seconds = bench_seconds_since(start_ns);
+        if (error == NETCHUNK_SUCCESS) {
+            bench_manifest_report("packed", "load", chunk_count, packed.size, seconds);
+            netchunk_packed_manifest_close(&loaded);
+        }
+
+        netchunk_file_manifest_t unpacked;
+        if (error == NETCHUNK_SUCCESS) {
+            start_ns = netchunk_metrics_now_ns();
+            error = netchunk_packed_manifest_unpack(&packed, &unpacked);
+            seconds = bench_seconds_since(start_ns);
+        }
+        if (error == NETCHUNK_SUCCESS) {
+            bench_manifest_report("packed", "decode", chunk_count, packed.size, seconds);
+            netchunk_file_manifest_cleanup(&unpacked);
+        }
+        netchunk_packed_manifest_close(&packed);
+    }
+
+    netchunk_file_manifest_cleanup(&manifest);
+    if (error != NETCHUNK_SUCCESS) {
+        fprintf(stderr, "manifest: %u chunks: %s\n", chunk_count, netchunk_error_string(error));
+        return 1;
+    }
+    return 0;
+}
+
+static int bench_manifest(const bench_options_t* options)
+{
+    int failed = 0;
+    for (int i = 0; i < options->manifest_sizes; i++) {
+        failed |= bench_manifest_size(options, options->manifest_chunks[i]);
+    }
+    return failed;
+}
+
+// End to end
+
+/**
+ * @brief Remove a directory the library wrote its local state into
+ */
+static void bench_remove_tree(const char* path)
+{
+    DIR* dir = opendir(path);
+    if (dir) {
+        struct dirent* entry;
+        while ((entry = readdir(dir)) != NULL) {
+            if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+                continue;
+            }
+            char child[NETCHUNK_MAX_PATH_LEN * 2];
+            snprintf(child, sizeof(child), "%s/%s", path, entry->d_name);
+            struct stat st;
+            if (lstat(child, &st) == 0 && S_ISDIR(st.st_mode)) {
+                bench_remove_tree(child);
+            } else {
+                unlink(child);
+            }
+        }
+        closedir(dir);
+    }
+    rmdir(path);
+}
+
+/**
+ * @brief Write the client configuration and, when encrypting, its key file
+ */
+static bool bench_write_config(const bench_options_t* options, bench_cluster_t* cluster)
+{
+    if (options->encrypt) {
+        uint8_t key[NETCHUNK_CIPHER_KEY_LENGTH];
+        char key_hex[NETCHUNK_CIPHER_KEY_LENGTH * 2 + 1];
+        uint64_t state = options->seed ^ 0x6b6579ULL;
+        bench_fill(key, sizeof(key), false, &state);
+        for (size_t i = 0; i < sizeof(key); i++) {
+            snprintf(key_hex + i * 2, 3, "%02x", key[i]);
+        }
+
+        // The library refuses key files others can read
+        snprintf(cluster->key_path, sizeof(cluster->key_path), "%s/encryption.key", cluster->storage_path);
+        int fd = open(cluster->key_path, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+        bool written = fd >= 0 && dprintf(fd, "%s\n", key_hex) > 0;
+        if (fd >= 0 && close(fd) != 0) {
+            written = false;
+        }
+        if (!written) {
+            return false;
+        }
+    }
+
+    snprintf(cluster->config_path, sizeof(cluster->config_path), "%s/netchunk.conf", cluster->storage_path);
+    FILE* file = fopen(cluster->config_path, "w");
+    if (!file) {
+        return false;
+    }
+
+    fprintf(file, "[general]\n");
+    fprintf(file, "chunk_size = %zu\n", options->chunk_size);
+    fprintf(file, "replication_factor = %d\n", options->replicas);
+    fprintf(file, "compression = %s\n", netchunk_compression_to_string(options->compression));
+    fprintf(file, "local_storage_path = %s\n", cluster->storage_path);
+    fprintf(file, "log_level = ERROR\n");
+    fprintf(file, "log_file = %s/netchunk.log\n", cluster->storage_path);
+    fprintf(file, "health_monitoring_enabled = false\n\n");
+    if (options->encrypt) {
+        fprintf(file, "[security]\n");
+        fprintf(file, "encrypt_chunks = true\n");
+        fprintf(file, "encryption_key_file = %s\n\n", cluster->key_path);
+    }
+    bool ok = mock_ftp_write_server_config(file, BENCH_BASE_PATH) == cluster->server_count;
+
+    if (fclose(file) != 0) {
+        ok = false;
+    }
+    return ok;
+}
+
+/**
+ * @brief Start the mock servers on loopback and a library context using them
+ */
+static netchunk_error_t bench_cluster_init(const bench_options_t* options, bench_cluster_t* cluster)
+{
+    memset(cluster, 0, sizeof(bench_cluster_t));
+    mock_ftp_init();
+
+    snprintf(cluster->storage_path, sizeof(cluster->storage_path), "%s/netchunk-bench-XXXXXX", options->temp_dir);
+    if (!mkdtemp(cluster->storage_path)) {
+        cluster->storage_path[0] = '\0';
+        return NETCHUNK_ERROR_FILE_ACCESS;
+    }
+
+    for (int s = 0; s < options->servers; s++) {
+        char host[64];
+        snprintf(host, sizeof(host), "bench%d.test", s + 1);
+        mock_ftp_server_t* server = mock_ftp_create_server(host, BENCH_PORT, BENCH_USERNAME, BENCH_PASSWORD);
+        if (!server) {
+            return NETCHUNK_ERROR_OUT_OF_MEMORY;
+        }
+
+        server->storage_capacity = SIZE_MAX;
+        mock_ftp_set_latency(server, options->latency_min_ms, options->latency_max_ms);
+        mock_ftp_set_bandwidth(server, options->bandwidth);
+        mock_ftp_set_failure_rates(server, options->failure_rate, options->failure_rate, options->failure_rate);
+        if (mock_ftp_server_listen(server) != MOCK_FTP_SUCCESS) {
+            return NETCHUNK_ERROR_NETWORK;
+        }
+
+        cluster->servers[s] = server;
+        cluster->server_count++;
+    }
+
+    if (!bench_write_config(options, cluster)) {
+        return NETCHUNK_ERROR_FILE_ACCESS;
+    }
+
+    netchunk_error_t error = netchunk_init(&cluster->context, cluster->config_path);
+    cluster->initialized = error == NETCHUNK_SUCCESS;
+    return error;
+}
+
+static void bench_cluster_cleanup(bench_cluster_t* cluster)
+{
+    if (cluster->initialized) {
+        netchunk_cleanup(&cluster->context);
+    }
+    mock_ftp_cleanup();
+    if (cluster->storage_path[0]) {
+        bench_remove_tree(cluster->storage_path);
+    }
+}
+
+/**
+ * @brief Bytes the mock servers received and sent so far
+ */
+static void bench_cluster_traffic(const bench_cluster_t* cluster, uint64_t* bytes_sent, uint64_t* bytes_received)
+{
+    *bytes_sent = 0;
+    *bytes_received = 0;
+    for (int s = 0; s < cluster->server_count; s++) {
+        *bytes_sent += cluster->servers[s]->bytes_uploaded;
+        *bytes_received += cluster->servers[s]->bytes_downloaded;
+    }
+}
+
+static void bench_e2e_report(const bench_options_t* options,
+    const char* op,
+    const netchunk_stats_t* stats,
+    uint64_t bytes,
+    uint64_t stored_bytes,
+    uint64_t bytes_sent,
+    uint64_t bytes_received,
+    double seconds,
+    bool verified)
+{
+    printf("{\"bench\":\"e2e\",\"op\":\"%s\",\"file_size\":%llu,\"stored_bytes\":%llu,\"chunks\":%u,"
+           "\"servers\":%d,\"replicas\":%d,\"latency_ms_min\":%u,\"latency_ms_max\":%u,"
+           "\"bandwidth\":%llu,\"failure_rate\":%.4f,\"compression\":\"%s\",\"encrypted\":%s,"
+           "\"retries\":%u,\"hedged\":%u,\"bytes_sent\":%llu,\"bytes_received\":%llu,"
+           "\"seconds\":%.6f,\"mb_per_s\":%.2f,\"verified\":%s}\n",
+        op, (unsigned long long)bytes, (unsigned long long)stored_bytes, stats->chunks_processed,
+        options->servers, options->replicas, options->latency_min_ms, options->latency_max_ms,
+        (unsigned long long)options->bandwidth, options->failure_rate,
+        netchunk_compression_to_string(options->compression), options->encrypt ? "true" : "false",
+        stats->retries_performed, stats->chunks_hedged,
+        (unsigned long long)bytes_sent, (unsigned long long)bytes_received,
+        seconds, bench_mb_per_s(bytes, seconds), verified ? "true" : "false");
+    fflush(stdout);
+}
+
+static int bench_e2e(const bench_options_t* options)
+{
+    // Every replica and the manifest must fit in the mock's file table
+    size_t chunks = (options->file_size + options->chunk_size - 1) / options->chunk_size;
+    size_t per_server = (chunks * (size_t)options->replicas + (size_t)options->servers - 1) / (size_t)options->servers + 1;
+    if (per_server > MOCK_FTP_MAX_FILES_PER_SERVER) {
+        fprintf(stderr, "e2e: %zu chunks per server exceed the mock's limit of %d; use a larger chunk size or more servers\n",
+            per_server, MOCK_FTP_MAX_FILES_PER_SERVER);
+        return 1;
+    }
+    if (options->compression != NETCHUNK_COMPRESSION_NONE && !netchunk_compress_available(options->compression)) {
+        fprintf(stderr, "e2e: compression %s is not compiled in\n", netchunk_compression_to_string(options->compression));
+        return 1;
+    }
+
+    char input_path[NETCHUNK_MAX_PATH_LEN];
+    char output_path[NETCHUNK_MAX_PATH_LEN];
+    if (!bench_write_input(options, input_path, sizeof(input_path))) {
+        fprintf(stderr, "e2e: cannot write input file in %s\n", options->temp_dir);
+        return 1;
+    }
+    if (!bench_temp_path(options, "output", output_path, sizeof(output_path))) {
+        fprintf(stderr, "e2e: cannot create output file in %s\n", options->temp_dir);
+        unlink(input_path);
+        return 1;
+    }
+
+    bench_cluster_t cluster;
+    netchunk_error_t error = bench_cluster_init(options, &cluster);
+
+    uint64_t stored_bytes = 0;
+    uint64_t bytes_sent = 0;
+    uint64_t bytes_received = 0;
+    if (error == NETCHUNK_SUCCESS) {
+        netchunk_stats_t stats;
+        memset(&stats, 0, sizeof(stats));
+        uint64_t start_ns = netchunk_metrics_now_ns();
+        error = netchunk_upload(&cluster.context, input_path, BENCH_REMOTE_NAME, &stats);
+        double seconds = bench_seconds_since(start_ns);
+        if (error == NETCHUNK_SUCCESS) {
+            stored_bytes = stats.bytes_stored;
+            bench_cluster_traffic(&cluster, &bytes_sent, &bytes_received);
+            bench_e2e_report(options, "upload", &stats, options->file_size, stored_bytes, bytes_sent,
+                bytes_received, seconds, false);
+        }
+    }
+
+    if (error == NETCHUNK_SUCCESS) {
+        netchunk_stats_t stats;
+        memset(&stats, 0, sizeof(stats));
+        uint64_t start_ns = netchunk_metrics_now_ns();
+        error = netchunk_download(&cluster.context, BENCH_REMOTE_NAME, output_path, &stats);
+        double seconds = bench_seconds_since(start_ns);
+
+        // Whole-file check outside the timed part
+        uint8_t input_hash[NETCHUNK_HASH_LENGTH];
+        uint8_t output_hash[NETCHUNK_HASH_LENGTH];
+        if (error == NETCHUNK_SUCCESS) {
+            error = netchunk_sha256_hash_file(input_path, input_hash);
+        }
+        if (error == NETCHUNK_SUCCESS) {
+            error = netchunk_sha256_hash_file(output_path, output_hash);
+        }
+        if (error == NETCHUNK_SUCCESS && memcmp(input_hash, output_hash, NETCHUNK_HASH_LENGTH) != 0) {
+            error = NETCHUNK_ERROR_CHUNK_INTEGRITY;
+        }
+        if (error == NETCHUNK_SUCCESS) {
+            uint64_t total_sent;
+            uint64_t total_received;
+            bench_cluster_traffic(&cluster, &total_sent, &total_received);
+            bench_e2e_report(options, "download", &stats, options->file_size, stored_bytes,
+                total_sent - bytes_sent, total_received - bytes_received, seconds, true);
+        }
+    }
+
+    bench_cluster_cleanup(&cluster);
+    unlink(input_path);
+    unlink(output_path);
+
+    if (error != NETCHUNK_SUCCESS) {
+        fprintf(stderr, "e2e: %s\n", netchunk_error_string(error));
+        return 1;
+    }
+    return 0;
+}
+
+// Driver
+
+static void print_usage(const char* program)
+{
+    printf("Usage: %s [options]\n", program);
+    printf("\n");
+    printf("Prints one JSON object per result on stdout.\n");
+    printf("\n");
+    printf("Options:\n");
+    printf("  -b, --bench LIST            Benchmarks to run: sha256,chunker,manifest,e2e or all (default)\n");
+    printf("  -t, --min-time SECONDS      Minimum duration of each hashing measurement (default 1)\n");
+    printf("      --sha-size SIZE         Message size for hashing (default 1M)\n");
+    printf("  -f, --file-size SIZE        Input size for chunker and e2e (default 64M)\n");
+    printf("  -c, --chunk-size SIZE       Target chunk size (default 4M)\n");
+    printf("      --text                  Generate compressible text instead of random bytes\n");
+    printf("  -m, --manifest-chunks LIST  Manifest sizes in chunks (default 10000,100000,1000000)\n");
+    printf("  -s, --servers N             Mock servers for e2e (default 4)\n");
+    printf("  -r, --replicas N            Replicas per chunk for e2e (default %d)\n", NETCHUNK_DEFAULT_REPLICATION_FACTOR);
+    printf("  -l, --latency MS[-MAX]      Injected latency per operation (default 0)\n");
+    printf("  -w, --bandwidth SIZE        Bytes per second per server, 0 for unlimited (default 0)\n");
+    printf("  -e, --failure-rate P        Connection, upload and download failure probability (default 0)\n");
+    printf("  -z, --compression CODEC     Chunk compression for e2e: none or zstd (default none)\n");
+    printf("  -E, --encrypt               Encrypt chunks in e2e\n");
+    printf("      --seed N                Seed of the generated data (default 1)\n");
+    printf("  -d, --temp-dir DIR          Directory for temporary files (default /tmp)\n");
+    printf("  -h, --help                  Show this help\n");
+}
+
+static int parse_arguments(int argc, char* argv[], bench_options_t* options)
+{
+    memset(options, 0, sizeof(bench_options_t));
+    options->suites = BENCH_ALL;
+    options->min_time = 1.0;
+    options->sha_size = 1024 * 1024;
+    options->file_size = 64 * 1024 * 1024;
+    options->chunk_size = NETCHUNK_DEFAULT_CHUNK_SIZE;
+    options->manifest_chunks[0] = 10000;
+    options->manifest_chunks[1] = 100000;
+    options->manifest_chunks[2] = 1000000;
+    options->manifest_sizes = 3;
+    options->servers = 4;
+    options->replicas = NETCHUNK_DEFAULT_REPLICATION_FACTOR;
+    options->compression = NETCHUNK_COMPRESSION_NONE;
+    options->seed = 1;
+    strcpy(options->temp_dir, "/tmp");
+
+    enum {
+        OPTION_SHA_SIZE = 256,
+        OPTION_TEXT,
+        OPTION_SEED
+    };
+    static struct option long_options[] = {
+        { "bench", required_argument, 0, 'b' },
+        { "min-time", required_argument, 0, 't' },
+        { "sha-size", required_argument, 0, OPTION_SHA_SIZE },
+        { "file-size", required_argument, 0, 'f' },
+        { "chunk-size", required_argument, 0, 'c' },
+        { "text", no_argument, 0, OPTION_TEXT },
+        { "manifest-chunks", required_argument, 0, 'm' },
+        { "servers", required_argument, 0, 's' },
+        { "replicas", required_argument, 0, 'r' },
+        { "latency", required_argument, 0, 'l' },
+        { "bandwidth", required_argument, 0, 'w' },
+        { "failure-rate", required_argument, 0, 'e' },
+        { "compression", required_argument, 0, 'z' },
+        { "encrypt", no_argument, 0, 'E' },
+        { "seed", required_argument, 0, OPTION_SEED },
+        { "temp-dir", required_argument, 0, 'd' },
+        { "help", no_argument, 0, 'h' },
+        { 0, 0, 0, 0 }
+    };
+
+    int opt;
+    uint64_t value;
+    while ((opt = getopt_long(argc, argv, "b:t:f:c:m:s:r:l:w:e:z:Ed:h", long_options, NULL)) != -1) {
+        switch (opt) {
+        case 'b':
+            if (!parse_suites(optarg, &options->suites)) {
+                return -1;
+            }
+            break;
+        case 't':
+            options->min_time = atof(optarg);
+            break;
+        case OPTION_SHA_SIZE:
+            if (!parse_size(optarg, &value) || value == 0) {
+                return -1;
+            }
+            options->sha_size = (size_t)value;
+            break;
+        case 'f':
+            if (!parse_size(optarg, &value) || value == 0) {
+                return -1;
+            }
+            options->file_size = (size_t)value;
+            break;
+        case 'c':
+            if (!parse_size(optarg, &value) || value < NETCHUNK_MIN_CHUNK_SIZE || value > NETCHUNK_MAX_CHUNK_SIZE) {
+                return -1;
+            }
+            options->chunk_size = (size_t)value;
+            break;
+        case OPTION_TEXT:
+            options->text_data = true;
+            break;
+        case 'm':
+            if (!parse_manifest_sizes(optarg, options)) {
+                return -1;
+            }
+            break;
+        case 's':
+            options->servers = atoi(optarg);
+            break;
+        case 'r':
+            options->replicas = atoi(optarg);
+            break;
+        case 'l':
+            if (!parse_latency(optarg, options)) {
+                return -1;
+            }
+            break;
+        case 'w':
+            if (!parse_size(optarg, &options->bandwidth)) {
+                return -1;
+            }
+            break;
+        case 'e':
+            options->failure_rate = atof(optarg);
+            break;
+        case 'z':
+            options->compression = netchunk_compression_from_string(optarg);
+            break;
+        case 'E':
+            options->encrypt = true;
+            break;
+        case OPTION_SEED:
+            options->seed = strtoull(optarg, NULL, 10);
+            break;
+        case 'd':
+            snprintf(options->temp_dir, sizeof(options->temp_dir), "%s", optarg);
+            break;
+        case 'h':
+            print_usage(argv[0]);
+            exit(0);
+        default:
+            return -1;
+        }
+    }
+
+    if (optind < argc || options->servers < 1 || options->servers > MOCK_FTP_MAX_SERVERS
+        || options->replicas < 1 || options->replicas > options->servers
+        || options->replicas > NETCHUNK_MAX_CHUNK_LOCATIONS
+        || options->failure_rate < 0.0 || options->failure_rate >= 1.0) {
+        return -1;
+    }
+    if (options->seed == 0) {
+        options->seed = 1; // xorshift state must not be zero
+    }
+
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    bench_options_t options;
+    if (parse_arguments(argc, argv, &options) != 0) {
+        print_usage(argv[0]);
+        return 2;
+    }
+
+    printf("{\"bench\":\"info\",\"version\":\"%d.%d.%d\",\"timestamp\":%lld,"
+           "\"sha256_backend\":\"%s\",\"sha256_batch_backend\":\"%s\",\"data\":\"%s\"}\n",
+        NETCHUNK_VERSION_MAJOR, NETCHUNK_VERSION_MINOR, NETCHUNK_VERSION_PATCH, (long long)time(NULL),
+        netchunk_sha256_backend_name(netchunk_sha256_get_backend()),
+        netchunk_sha256_backend_name(netchunk_sha256_get_batch_backend()),
+        options.text_data ? "text" : "random");
+    fflush(stdout);
+
+    int failed = 0;
+    if (options.suites & BENCH_SHA256) {
+        failed |= bench_sha256(&options);
+    }
+    if (options.suites & BENCH_CHUNKER) {
+        failed |= bench_chunker(&options);
+    }
+    if (options.suites & BENCH_MANIFEST) {
+        failed |= bench_manifest(&options);
+    }
+    if (options.suites & BENCH_E2E) {
+        failed |= bench_e2e(&options);
+    }
+
+    return failed ? 1 : 0;
+}
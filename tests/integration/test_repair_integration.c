@@ -0,0 +1,205 @@
+#include "unity.h"
+#include "test_utils.h"
+#include "mock_ftp.h"
+#include "netchunk.h"
+#include "config.h"
+#include "ftp_client.h"
+#include "manifest.h"
+#include "repair.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define TEST_SERVERS 5
+#define TEST_REPLICAS 2
+#define TEST_CHUNK_SIZE (1024 * 1024)
+#define TEST_CHUNKS 64
+#define TEST_FILE_SIZE (TEST_CHUNKS * TEST_CHUNK_SIZE)
+#define TEST_GIB ((size_t)1 << 30)
+
+// Test data and fixtures
+static test_file_context_t test_files;
+static netchunk_context_t netchunk_ctx;
+static bool netchunk_initialized;
+static mock_ftp_server_t* servers[TEST_SERVERS];
+static int server_count;
+static char input_path[TEST_MAX_PATH_LEN];
+static char output_path[TEST_MAX_PATH_LEN];
+
+void setUp(void) {
+    // Initialize test environment
+    test_setup_environment();
+    TEST_ASSERT_EQUAL_INT(0, create_temp_test_directory(&test_files));
+    mock_ftp_init();
+
+    memset(&netchunk_ctx, 0, sizeof(netchunk_ctx));
+    netchunk_initialized = false;
+    server_count = 0;
+
+    snprintf(input_path, sizeof(input_path), "%s/input.bin", test_files.temp_dir);
+    snprintf(output_path, sizeof(output_path), "%s/output.bin", test_files.temp_dir);
+    TEST_ASSERT_EQUAL_INT(0, generate_random_test_file(input_path, TEST_FILE_SIZE));
+}
+
+void tearDown(void) {
+    // Cleanup test environment
+    if (netchunk_initialized) {
+        netchunk_cleanup(&netchunk_ctx);
+    }
+    mock_ftp_cleanup();
+    cleanup_temp_test_directory(&test_files);
+    test_cleanup_environment();
+}
+
+// Helpers
+
+// Start one more mock server reporting the given free space
+static void add_server(size_t capacity) {
+    TEST_ASSERT_TRUE(server_count < TEST_SERVERS);
+
+    char host[32];
+    snprintf(host, sizeof(host), "server%d.test", server_count + 1);
+    mock_ftp_server_t* server = mock_ftp_create_server(host, 21, "test", "test");
+    TEST_ASSERT_NOT_NULL(server);
+    server->storage_capacity = capacity;
+    TEST_ASSERT_EQUAL_INT(MOCK_FTP_SUCCESS, mock_ftp_server_listen(server));
+    servers[server_count++] = server;
+}
+
+// (Re)initialize a monitored client on every listening mock server
+static void init_client(void) {
+    if (netchunk_initialized) {
+        netchunk_cleanup(&netchunk_ctx);
+        netchunk_initialized = false;
+    }
+
+    char config_path[TEST_MAX_PATH_LEN];
+    snprintf(config_path, sizeof(config_path), "%s/netchunk.conf", test_files.temp_dir);
+    FILE* file = fopen(config_path, "w");
+    TEST_ASSERT_NOT_NULL(file);
+    fprintf(file, "[general]\n");
+    fprintf(file, "chunk_size = %d\n", TEST_CHUNK_SIZE);
+    fprintf(file, "replication_factor = %d\n", TEST_REPLICAS);
+    fprintf(file, "local_storage_path = %s\n", test_files.temp_dir);
+    fprintf(file, "log_level = ERROR\n");
+    fprintf(file, "log_file = %s/netchunk.log\n", test_files.temp_dir);
+    fprintf(file, "health_monitoring_enabled = true\n");
+    fprintf(file, "health_check_interval = 300\n\n");
+    TEST_ASSERT_EQUAL_INT(server_count, mock_ftp_write_server_config(file, "/netchunk"));
+    TEST_ASSERT_EQUAL_INT(0, fclose(file));
+
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_init(&netchunk_ctx, config_path));
+    netchunk_initialized = true;
+}
+
+// Chunk files stored on one server; manifests live in another directory
+static size_t chunk_files_on(int server) {
+    size_t count = 0;
+    for (size_t f = 0; f < servers[server]->file_count; f++) {
+        if (strstr(servers[server]->files[f].filename, "/chunks/")) {
+            count++;
+        }
+    }
+    return count;
+}
+
+static size_t count_chunk_files(void) {
+    size_t count = 0;
+    for (int s = 0; s < server_count; s++) {
+        count += chunk_files_on(s);
+    }
+    return count;
+}
+
+// Rebalance a stored file with a fresh repair context and store the result
+static int rebalance(const char* remote_name) {
+    netchunk_file_manifest_t manifest;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS,
+        netchunk_ftp_download_manifest(netchunk_ctx.ftp_context, netchunk_ctx.config, remote_name, &manifest));
+
+    netchunk_repair_context_t repair;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_repair_init(&repair, netchunk_ctx.config, netchunk_ctx.ftp_context));
+
+    int moves = -1;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_repair_rebalance_chunks(&repair, &manifest, &moves));
+    if (moves > 0) {
+        TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS,
+            netchunk_ftp_upload_manifest(netchunk_ctx.ftp_context, netchunk_ctx.config, &manifest));
+    }
+
+    netchunk_repair_cleanup(&repair);
+    netchunk_manifest_cleanup(&manifest);
+    return moves;
+}
+
+static void upload_input(const char* remote_name) {
+    netchunk_stats_t stats;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_upload(&netchunk_ctx, input_path, remote_name, &stats));
+    TEST_ASSERT_EQUAL_UINT32(TEST_CHUNKS, stats.chunks_processed);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.chunks_under_replicated);
+    TEST_ASSERT_EQUAL_size_t(TEST_CHUNKS * TEST_REPLICAS, count_chunk_files());
+}
+
+// Test that uploads weigh servers by free space the way rebalancing does, so nothing moves afterwards
+void test_rebalance_after_upload_moves_nothing(void) {
+    add_server(32 * TEST_GIB);
+    add_server(64 * TEST_GIB);
+    add_server(64 * TEST_GIB);
+    add_server(128 * TEST_GIB);
+    init_client();
+
+    upload_input("weighted.bin");
+    TEST_ASSERT_EQUAL_INT(0, rebalance("weighted.bin"));
+    TEST_ASSERT_EQUAL_size_t(TEST_CHUNKS * TEST_REPLICAS, count_chunk_files());
+
+    // The largest server takes the most, the smallest the least
+    TEST_ASSERT_TRUE(chunk_files_on(3) > chunk_files_on(0));
+}
+
+// Test that a new server takes over about its share of replicas and nothing else moves
+void test_rebalance_new_server_moves_its_share(void) {
+    for (int s = 0; s < TEST_SERVERS - 1; s++) {
+        add_server(64 * TEST_GIB);
+    }
+    init_client();
+
+    upload_input("grown.bin");
+    TEST_ASSERT_EQUAL_INT(0, rebalance("grown.bin"));
+
+    size_t before[TEST_SERVERS];
+    for (int s = 0; s < server_count; s++) {
+        before[s] = chunk_files_on(s);
+    }
+
+    add_server(64 * TEST_GIB);
+    init_client();
+
+    // About 1/5 of the 128 replicas; the bounds are four standard deviations
+    int moves = rebalance("grown.bin");
+    TEST_ASSERT_INT_WITHIN(18, TEST_CHUNKS * TEST_REPLICAS / TEST_SERVERS, moves);
+
+    // Every move went to the new server, and no chunk lost a replica
+    TEST_ASSERT_EQUAL_size_t((size_t)moves, chunk_files_on(TEST_SERVERS - 1));
+    for (int s = 0; s < TEST_SERVERS - 1; s++) {
+        TEST_ASSERT_TRUE(chunk_files_on(s) <= before[s]);
+    }
+    TEST_ASSERT_EQUAL_size_t(TEST_CHUNKS * TEST_REPLICAS, count_chunk_files());
+
+    // Settled: a second pass moves nothing, and the file still reads back
+    TEST_ASSERT_EQUAL_INT(0, rebalance("grown.bin"));
+    netchunk_stats_t stats;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_download(&netchunk_ctx, "grown.bin", output_path, &stats));
+    TEST_ASSERT_EQUAL_INT(0, compare_files(input_path, output_path));
+}
+
+// Unity test runner
+int main(void) {
+    UNITY_BEGIN();
+
+    // Rebalancing tests
+    RUN_TEST(test_rebalance_after_upload_moves_nothing);
+    RUN_TEST(test_rebalance_new_server_moves_its_share);
+
+    return UNITY_END();
+}
@@ -0,0 +1,226 @@
+#include "unity.h"
+#include "test_utils.h"
+#include "mock_ftp.h"
+#include "netchunk.h"
+#include "config.h"
+#include "dedup.h"
+#include "ftp_client.h"
+#include "manifest.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define TEST_SERVERS 4
+#define TEST_CHUNK_SIZE (1024 * 1024)
+#define TEST_FILE_SIZE (3 * TEST_CHUNK_SIZE + 4096) // Three full chunks and a short one
+#define TEST_CHUNKS 4
+
+// Test data and fixtures
+static test_file_context_t test_files;
+static netchunk_context_t netchunk_ctx;
+static bool netchunk_initialized;
+static mock_ftp_server_t* servers[TEST_SERVERS];
+static bool content_addressed;
+static char input_path[TEST_MAX_PATH_LEN];
+static char output_path[TEST_MAX_PATH_LEN];
+
+void setUp(void) {
+    // Initialize test environment
+    test_setup_environment();
+    TEST_ASSERT_EQUAL_INT(0, create_temp_test_directory(&test_files));
+    mock_ftp_init();
+
+    memset(&netchunk_ctx, 0, sizeof(netchunk_ctx));
+    netchunk_initialized = false;
+    content_addressed = false;
+
+    // Mock servers the real FTP client reaches over loopback
+    for (int s = 0; s < TEST_SERVERS; s++) {
+        char host[32];
+        snprintf(host, sizeof(host), "server%d.test", s + 1);
+        servers[s] = mock_ftp_create_server(host, 21, "test", "test");
+        TEST_ASSERT_NOT_NULL(servers[s]);
+        TEST_ASSERT_EQUAL_INT(MOCK_FTP_SUCCESS, mock_ftp_server_listen(servers[s]));
+    }
+
+    snprintf(input_path, sizeof(input_path), "%s/input.bin", test_files.temp_dir);
+    snprintf(output_path, sizeof(output_path), "%s/output.bin", test_files.temp_dir);
+    TEST_ASSERT_EQUAL_INT(0, generate_random_test_file(input_path, TEST_FILE_SIZE));
+}
+
+void tearDown(void) {
+    // Cleanup test environment
+    if (netchunk_initialized) {
+        netchunk_cleanup(&netchunk_ctx);
+    }
+    mock_ftp_cleanup();
+    cleanup_temp_test_directory(&test_files);
+    test_cleanup_environment();
+}
+
+// Helpers
+
+// Point a client at the first server_count mock servers and initialize it
+static void init_client(int server_count, int replication_factor) {
+    for (int s = server_count; s < TEST_SERVERS; s++) {
+        mock_ftp_server_stop(servers[s]);
+    }
+
+    char config_path[TEST_MAX_PATH_LEN];
+    snprintf(config_path, sizeof(config_path), "%s/netchunk.conf", test_files.temp_dir);
+    FILE* file = fopen(config_path, "w");
+    TEST_ASSERT_NOT_NULL(file);
+    fprintf(file, "[general]\n");
+    fprintf(file, "chunk_size = %d\n", TEST_CHUNK_SIZE);
+    fprintf(file, "replication_factor = %d\n", replication_factor);
+    fprintf(file, "local_storage_path = %s\n", test_files.temp_dir);
+    fprintf(file, "log_level = ERROR\n");
+    fprintf(file, "log_file = %s/netchunk.log\n", test_files.temp_dir);
+    fprintf(file, "health_monitoring_enabled = false\n");
+    if (content_addressed) {
+        fprintf(file, "content_addressed = true\n");
+        fprintf(file, "dedup_index_path = %s/dedup-index.json\n", test_files.temp_dir);
+    }
+    fprintf(file, "\n");
+    TEST_ASSERT_EQUAL_INT(server_count, mock_ftp_write_server_config(file, "/netchunk"));
+    TEST_ASSERT_EQUAL_INT(0, fclose(file));
+
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_init(&netchunk_ctx, config_path));
+    netchunk_initialized = true;
+}
+
+// Chunk files stored on one server; manifests live in another directory
+static size_t chunk_files_on(int server) {
+    size_t count = 0;
+    for (size_t f = 0; f < servers[server]->file_count; f++) {
+        if (strstr(servers[server]->files[f].filename, "/chunks/")) {
+            count++;
+        }
+    }
+    return count;
+}
+
+static size_t count_chunk_files(int server_count) {
+    size_t count = 0;
+    for (int s = 0; s < server_count; s++) {
+        count += chunk_files_on(s);
+    }
+    return count;
+}
+
+// Test that a file survives the round trip through the real client and every chunk is fully replicated
+void test_upload_download_round_trip(void) {
+    init_client(TEST_SERVERS, 3);
+
+    netchunk_stats_t stats;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_upload(&netchunk_ctx, input_path, "round_trip.bin", &stats));
+    TEST_ASSERT_EQUAL_UINT32(TEST_CHUNKS, stats.chunks_processed);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.chunks_under_replicated);
+    TEST_ASSERT_EQUAL_size_t(TEST_CHUNKS * 3, count_chunk_files(TEST_SERVERS));
+
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_download(&netchunk_ctx, "round_trip.bin", output_path, &stats));
+    TEST_ASSERT_EQUAL_INT(0, compare_files(input_path, output_path));
+}
+
+// Test that chunks a failing server refused are stored elsewhere and reported as under-replicated
+void test_upload_reports_under_replication(void) {
+    // Every server is needed for three replicas, and one refuses all puts
+    mock_ftp_set_failure_rates(servers[2], 0.0, 1.0, 0.0);
+    init_client(3, 3);
+
+    netchunk_stats_t stats;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_upload(&netchunk_ctx, input_path, "degraded.bin", &stats));
+    TEST_ASSERT_EQUAL_UINT32(TEST_CHUNKS, stats.chunks_processed);
+    TEST_ASSERT_EQUAL_UINT32(TEST_CHUNKS, stats.chunks_under_replicated);
+    TEST_ASSERT_TRUE(servers[2]->failed_uploads > 0);
+    TEST_ASSERT_EQUAL_size_t(0, chunk_files_on(2));
+    TEST_ASSERT_EQUAL_size_t(TEST_CHUNKS * 2, count_chunk_files(2));
+
+    // Two replicas are still enough to read the file back
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_download(&netchunk_ctx, "degraded.bin", output_path, &stats));
+    TEST_ASSERT_EQUAL_INT(0, compare_files(input_path, output_path));
+
+    // Once the server accepts puts again, repair restores the missing replicas
+    mock_ftp_set_failure_rates(servers[2], 0.0, 0.0, 0.0);
+    uint32_t verified = 0;
+    uint32_t repaired = 0;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_verify(&netchunk_ctx, "degraded.bin", true, &verified, &repaired));
+    TEST_ASSERT_EQUAL_UINT32(TEST_CHUNKS, repaired);
+    TEST_ASSERT_EQUAL_size_t(TEST_CHUNKS * 3, count_chunk_files(3));
+}
+
+// Test that a chunk no server accepts fails the upload
+void test_upload_fails_without_any_replica(void) {
+    for (int s = 0; s < 2; s++) {
+        mock_ftp_set_failure_rates(servers[s], 0.0, 1.0, 0.0);
+    }
+    init_client(2, 2);
+
+    netchunk_stats_t stats;
+    TEST_ASSERT_NOT_EQUAL(NETCHUNK_SUCCESS, netchunk_upload(&netchunk_ctx, input_path, "failed.bin", &stats));
+    TEST_ASSERT_EQUAL_size_t(0, count_chunk_files(2));
+}
+
+// Dedup references every chunk of a stored file holds
+static void assert_refcounts(const char* remote_name, uint32_t expected) {
+    netchunk_file_manifest_t manifest;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS,
+        netchunk_ftp_download_manifest(netchunk_ctx.ftp_context, netchunk_ctx.config, remote_name, &manifest));
+    TEST_ASSERT_NOT_NULL(netchunk_ctx.dedup_index);
+    for (uint32_t i = 0; i < manifest.chunk_count; i++) {
+        const netchunk_dedup_entry_t* entry = netchunk_dedup_index_lookup(netchunk_ctx.dedup_index, manifest.chunks[i].hash);
+        TEST_ASSERT_NOT_NULL(entry);
+        TEST_ASSERT_EQUAL_UINT32(expected, entry->refcount);
+    }
+    netchunk_manifest_cleanup(&manifest);
+}
+
+// Test that a delete whose manifest cannot be removed keeps the file's chunk references
+void test_delete_keeps_references_when_manifest_survives(void) {
+    content_addressed = true;
+    init_client(TEST_SERVERS, 2);
+
+    netchunk_stats_t stats;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_upload(&netchunk_ctx, input_path, "first.bin", &stats));
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_upload(&netchunk_ctx, input_path, "second.bin", &stats));
+    TEST_ASSERT_EQUAL_size_t(TEST_CHUNKS * 2, count_chunk_files(TEST_SERVERS));
+    assert_refcounts("first.bin", 2);
+
+    // No server lets the manifest go, however often the delete is retried
+    for (int s = 0; s < TEST_SERVERS; s++) {
+        servers[s]->delete_failure_rate = 1.0;
+    }
+    for (int attempt = 0; attempt < 2; attempt++) {
+        TEST_ASSERT_NOT_EQUAL(NETCHUNK_SUCCESS, netchunk_delete(&netchunk_ctx, "first.bin"));
+        assert_refcounts("first.bin", 2);
+    }
+
+    // Once it goes, only its own reference does: the chunks stay for the other file
+    for (int s = 0; s < TEST_SERVERS; s++) {
+        servers[s]->delete_failure_rate = 0.0;
+    }
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_delete(&netchunk_ctx, "first.bin"));
+    assert_refcounts("second.bin", 1);
+    TEST_ASSERT_EQUAL_size_t(TEST_CHUNKS * 2, count_chunk_files(TEST_SERVERS));
+
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_download(&netchunk_ctx, "second.bin", output_path, &stats));
+    TEST_ASSERT_EQUAL_INT(0, compare_files(input_path, output_path));
+}
+
+// Unity test runner
+int main(void) {
+    UNITY_BEGIN();
+
+    // Round trip tests
+    RUN_TEST(test_upload_download_round_trip);
+
+    // Replication tests
+    RUN_TEST(test_upload_reports_under_replication);
+    RUN_TEST(test_upload_fails_without_any_replica);
+
+    // Delete tests
+    RUN_TEST(test_delete_keeps_references_when_manifest_survives);
+
+    return UNITY_END();
+}
@@ -1,8 +1,14 @@
 #include "mock_ftp.h"
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <sys/socket.h>
 #include <sys/time.h>
 
 // Global mock FTP server registry
@@ -14,12 +20,20 @@ static bool g_detailed_logging = false;
 static uint32_t g_global_latency_min = 0;
 static uint32_t g_global_latency_max = 0;
 
+// Guards the file tables and the random state; the loopback front end
+// serves every control connection on its own thread
+static pthread_mutex_t g_mock_ftp_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_mock_ftp_session_done = PTHREAD_COND_INITIALIZER;
+
 // Random number generation for failure simulation
 static uint64_t g_mock_random_state = 12345;
 
 static uint32_t mock_ftp_random_uint32(void) {
+    pthread_mutex_lock(&g_mock_ftp_lock);
     g_mock_random_state = g_mock_random_state * 1664525ULL + 1013904223ULL;
-    return (uint32_t)(g_mock_random_state >> 16);
+    uint32_t value = (uint32_t)(g_mock_random_state >> 16);
+    pthread_mutex_unlock(&g_mock_ftp_lock);
+    return value;
 }
 
 static double mock_ftp_random_double(void) {
@@ -39,6 +53,15 @@ static void mock_ftp_simulate_delay(uint32_t min_ms, uint32_t max_ms) {
     }
 }
 
+static void mock_ftp_simulate_transfer(uint64_t bytes_per_sec, size_t size) {
+    if (bytes_per_sec == 0 || size == 0) return;
+    
+    uint64_t delay_us = (uint64_t)size * 1000000ULL / bytes_per_sec;
+    if (delay_us > 0) {
+        usleep((useconds_t)delay_us);
+    }
+}
+
 /**
  * Mock FTP system initialization
  */
@@ -74,6 +97,7 @@ void mock_ftp_cleanup(void) {
  */
 void mock_ftp_reset_all_servers(void) {
     for (size_t i = 0; i < g_mock_ftp_server_count; i++) {
+        mock_ftp_server_stop(&g_mock_ftp_servers[i]);
         mock_ftp_server_clear_files(&g_mock_ftp_servers[i]);
     }
     
@@ -177,12 +201,27 @@ void mock_ftp_set_latency(mock_ftp_server_t* server, uint32_t min_ms, uint32_t m
     }
 }
 
+/**
+ * Set bandwidth for server
+ */
+void mock_ftp_set_bandwidth(mock_ftp_server_t* server, uint64_t bytes_per_sec) {
+    if (server) {
+        server->bandwidth_bytes_per_sec = bytes_per_sec;
+        
+        if (g_detailed_logging) {
+            printf("Server %s:%d bandwidth set: %llu bytes/s\n",
+                   server->host, server->port, (unsigned long long)bytes_per_sec);
+        }
+    }
+}
+
 /**
  * Clear all files from server
  */
 void mock_ftp_server_clear_files(mock_ftp_server_t* server) {
     if (!server) return;
     
+    pthread_mutex_lock(&g_mock_ftp_lock);
     for (size_t i = 0; i < server->file_count; i++) {
         if (server->files[i].data) {
             free(server->files[i].data);
@@ -192,6 +231,106 @@ void mock_ftp_server_clear_files(mock_ftp_server_t* server) {
     
     server->file_count = 0;
     server->storage_used = 0;
+    pthread_mutex_unlock(&g_mock_ftp_lock);
+}
+
+/**
+ * Number of files stored on a server
+ */
+size_t mock_ftp_server_get_file_count(const mock_ftp_server_t* server) {
+    if (!server) return 0;
+    
+    pthread_mutex_lock(&g_mock_ftp_lock);
+    size_t count = server->file_count;
+    pthread_mutex_unlock(&g_mock_ftp_lock);
+    return count;
+}
+
+/**
+ * Bytes stored on a server
+ */
+size_t mock_ftp_server_get_storage_used(const mock_ftp_server_t* server) {
+    if (!server) return 0;
+    
+    pthread_mutex_lock(&g_mock_ftp_lock);
+    size_t used = server->storage_used;
+    pthread_mutex_unlock(&g_mock_ftp_lock);
+    return used;
+}
+
+/**
+ * Find a file by path; call with g_mock_ftp_lock held
+ */
+static mock_ftp_file_t* mock_ftp_find_file_locked(mock_ftp_server_t* server, const char* path) {
+    for (size_t i = 0; i < server->file_count; i++) {
+        if (strcmp(server->files[i].filename, path) == 0) {
+            return &server->files[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Store a file, taking ownership of data; call with g_mock_ftp_lock held
+ */
+static mock_ftp_result_t mock_ftp_store_locked(mock_ftp_server_t* server, const char* path,
+                                              uint8_t* data, size_t size) {
+    mock_ftp_file_t* file = mock_ftp_find_file_locked(server, path);
+    size_t replaced = file ? file->size : 0;
+    
+    // Check storage capacity
+    if (server->storage_used - replaced + size > server->storage_capacity) {
+        return MOCK_FTP_ERROR_STORAGE_FULL;
+    }
+    
+    // Check if we have space for another file
+    if (!file && server->file_count >= MOCK_FTP_MAX_FILES_PER_SERVER) {
+        return MOCK_FTP_ERROR_STORAGE_FULL;
+    }
+    
+    // Create new file entry if not found
+    if (!file) {
+        file = &server->files[server->file_count];
+        memset(file, 0, sizeof(*file));
+        server->file_count++;
+        strncpy(file->filename, path, sizeof(file->filename) - 1);
+    } else {
+        server->storage_used -= file->size;
+        free(file->data);
+    }
+    
+    file->data = data;
+    file->size = size;
+    file->created_time = time(NULL);
+    file->modified_time = file->created_time;
+    file->is_corrupted = false;
+    
+    // Update server statistics
+    server->storage_used += size;
+    server->total_uploads++;
+    server->bytes_uploaded += size;
+    
+    return MOCK_FTP_SUCCESS;
+}
+
+/**
+ * Remove a file; call with g_mock_ftp_lock held
+ */
+static mock_ftp_result_t mock_ftp_remove_locked(mock_ftp_server_t* server, const char* path) {
+    mock_ftp_file_t* file = mock_ftp_find_file_locked(server, path);
+    if (!file) {
+        return MOCK_FTP_ERROR_FILE_NOT_FOUND;
+    }
+    
+    server->storage_used -= file->size;
+    free(file->data);
+    
+    // Move last file to this position
+    *file = server->files[server->file_count - 1];
+    server->file_count--;
+    server->total_deletes++;
+    
+    return MOCK_FTP_SUCCESS;
 }
 
 /**
@@ -311,59 +450,26 @@ int mock_ftp_upload_data(mock_ftp_client_context_t* ctx, const uint8_t* data, si
         return MOCK_FTP_ERROR_UPLOAD_FAILED;
     }
     
-    // Check storage capacity
-    if (server->storage_used + size > server->storage_capacity) {
-        strncpy(ctx->last_error, "Storage full", sizeof(ctx->last_error) - 1);
-        return MOCK_FTP_ERROR_STORAGE_FULL;
-    }
-    
-    // Check if we have space for another file
-    if (server->file_count >= MOCK_FTP_MAX_FILES_PER_SERVER) {
-        strncpy(ctx->last_error, "Too many files", sizeof(ctx->last_error) - 1);
-        return MOCK_FTP_ERROR_STORAGE_FULL;
-    }
-    
-    // Simulate latency
+    // Simulate latency and transfer time
     mock_ftp_simulate_delay(server->latency_ms_min, server->latency_ms_max);
-    
-    // Find existing file or create new one
-    mock_ftp_file_t* file = NULL;
-    for (size_t i = 0; i < server->file_count; i++) {
-        if (strcmp(server->files[i].filename, remote_path) == 0) {
-            file = &server->files[i];
-            // Free existing data
-            if (file->data) {
-                server->storage_used -= file->size;
-                free(file->data);
-            }
-            break;
-        }
-    }
-    
-    // Create new file entry if not found
-    if (!file) {
-        file = &server->files[server->file_count];
-        server->file_count++;
-        strncpy(file->filename, remote_path, sizeof(file->filename) - 1);
-    }
+    mock_ftp_simulate_transfer(server->bandwidth_bytes_per_sec, size);
     
     // Allocate and copy data
-    file->data = malloc(size);
-    if (!file->data) {
+    uint8_t* copy = malloc(size > 0 ? size : 1);
+    if (!copy) {
         strncpy(ctx->last_error, "Memory allocation failed", sizeof(ctx->last_error) - 1);
         return MOCK_FTP_ERROR_UPLOAD_FAILED;
     }
+    memcpy(copy, data, size);
     
-    memcpy(file->data, data, size);
-    file->size = size;
-    file->created_time = time(NULL);
-    file->modified_time = file->created_time;
-    file->is_corrupted = false;
-    
-    // Update server statistics
-    server->storage_used += size;
-    server->total_uploads++;
-    server->bytes_uploaded += size;
+    pthread_mutex_lock(&g_mock_ftp_lock);
+    mock_ftp_result_t result = mock_ftp_store_locked(server, remote_path, copy, size);
+    pthread_mutex_unlock(&g_mock_ftp_lock);
+    if (result != MOCK_FTP_SUCCESS) {
+        free(copy);
+        strncpy(ctx->last_error, "Storage full", sizeof(ctx->last_error) - 1);
+        return result;
+    }
     
     if (g_detailed_logging) {
         printf("Mock FTP uploaded %zu bytes to %s:%d%s\n", 
@@ -392,32 +498,27 @@ int mock_ftp_download_data(mock_ftp_client_context_t* ctx, const char* remote_pa
         return MOCK_FTP_ERROR_DOWNLOAD_FAILED;
     }
     
-    // Find file
-    mock_ftp_file_t* file = NULL;
-    for (size_t i = 0; i < server->file_count; i++) {
-        if (strcmp(server->files[i].filename, remote_path) == 0) {
-            file = &server->files[i];
-            break;
-        }
-    }
+    // Find file and copy it out
+    pthread_mutex_lock(&g_mock_ftp_lock);
+    mock_ftp_file_t* file = mock_ftp_find_file_locked(server, remote_path);
     
     if (!file) {
+        pthread_mutex_unlock(&g_mock_ftp_lock);
         snprintf(ctx->last_error, sizeof(ctx->last_error), "File not found: %s", remote_path);
         return MOCK_FTP_ERROR_FILE_NOT_FOUND;
     }
     
     // Check for corruption
     if (file->is_corrupted) {
+        pthread_mutex_unlock(&g_mock_ftp_lock);
         strncpy(ctx->last_error, "File corrupted", sizeof(ctx->last_error) - 1);
         return MOCK_FTP_ERROR_CORRUPTED_DATA;
     }
     
-    // Simulate latency
-    mock_ftp_simulate_delay(server->latency_ms_min, server->latency_ms_max);
-    
     // Allocate and copy data
-    *data = malloc(file->size);
+    *data = malloc(file->size > 0 ? file->size : 1);
     if (!*data) {
+        pthread_mutex_unlock(&g_mock_ftp_lock);
         strncpy(ctx->last_error, "Memory allocation failed", sizeof(ctx->last_error) - 1);
         return MOCK_FTP_ERROR_DOWNLOAD_FAILED;
     }
@@ -428,10 +529,15 @@ int mock_ftp_download_data(mock_ftp_client_context_t* ctx, const char* remote_pa
     // Update server statistics
     server->total_downloads++;
     server->bytes_downloaded += file->size;
+    pthread_mutex_unlock(&g_mock_ftp_lock);
+    
+    // Simulate latency and transfer time
+    mock_ftp_simulate_delay(server->latency_ms_min, server->latency_ms_max);
+    mock_ftp_simulate_transfer(server->bandwidth_bytes_per_sec, *size);
     
     if (g_detailed_logging) {
         printf("Mock FTP downloaded %zu bytes from %s:%d%s\n", 
-               file->size, server->host, server->port, remote_path);
+               *size, server->host, server->port, remote_path);
     }
     
     return MOCK_FTP_SUCCESS;
@@ -449,28 +555,16 @@ int mock_ftp_delete_file(mock_ftp_client_context_t* ctx, const char* remote_path
     mock_ftp_server_t* server = ctx->connected_server;
     
     // Find and remove file
-    for (size_t i = 0; i < server->file_count; i++) {
-        if (strcmp(server->files[i].filename, remote_path) == 0) {
-            // Free data
-            if (server->files[i].data) {
-                server->storage_used -= server->files[i].size;
-                free(server->files[i].data);
-            }
-            
-            // Move last file to this position
-            if (i < server->file_count - 1) {
-                server->files[i] = server->files[server->file_count - 1];
-            }
-            
-            server->file_count--;
-            
-            if (g_detailed_logging) {
-                printf("Mock FTP deleted %s from %s:%d\n", 
-                       remote_path, server->host, server->port);
-            }
-            
-            return MOCK_FTP_SUCCESS;
+    pthread_mutex_lock(&g_mock_ftp_lock);
+    mock_ftp_result_t result = mock_ftp_remove_locked(server, remote_path);
+    pthread_mutex_unlock(&g_mock_ftp_lock);
+    
+    if (result == MOCK_FTP_SUCCESS) {
+        if (g_detailed_logging) {
+            printf("Mock FTP deleted %s from %s:%d\n", 
+                   remote_path, server->host, server->port);
         }
+        return MOCK_FTP_SUCCESS;
     }
     
     snprintf(ctx->last_error, sizeof(ctx->last_error), "File not found: %s", remote_path);
@@ -485,15 +579,659 @@ bool mock_ftp_file_exists(mock_ftp_client_context_t* ctx, const char* remote_pat
         return false;
     }
     
-    mock_ftp_server_t* server = ctx->connected_server;
+    pthread_mutex_lock(&g_mock_ftp_lock);
+    bool exists = mock_ftp_find_file_locked(ctx->connected_server, remote_path) != NULL;
+    pthread_mutex_unlock(&g_mock_ftp_lock);
     
-    for (size_t i = 0; i < server->file_count; i++) {
-        if (strcmp(server->files[i].filename, remote_path) == 0) {
+    return exists;
+}
+
+/*
+ * Loopback FTP front end
+ *
+ * Enough of RFC 959/3659 for libcurl's FTP client: login, CWD/PWD,
+ * EPSV/PASV, TYPE, SIZE, MDTM, REST, RETR, STOR, DELE, MLSD/NLST/LIST
+ * and AVBL. Directories are implicit: CWD always succeeds and a
+ * directory holds the files whose paths start with it.
+ */
+
+typedef struct mock_ftp_session {
+    mock_ftp_server_t* server;
+    int control_fd;
+    int passive_fd;
+    char cwd[MOCK_FTP_MAX_PATH_LEN];
+    char line[MOCK_FTP_MAX_PATH_LEN + 64];
+    char buffer[1024];
+    size_t buffered;
+    bool user_ok;
+    bool logged_in;
+} mock_ftp_session_t;
+
+#define MOCK_FTP_DATA_TIMEOUT_MS 5000
+
+static void mock_ftp_reply(mock_ftp_session_t* session, const char* format, ...) {
+    char reply[MOCK_FTP_MAX_PATH_LEN + 128];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(reply, sizeof(reply) - 2, format, args);
+    va_end(args);
+    if (length < 0) return;
+    if ((size_t)length > sizeof(reply) - 3) length = (int)sizeof(reply) - 3;
+    reply[length++] = '\r';
+    reply[length++] = '\n';
+    
+    for (int sent = 0; sent < length; ) {
+        ssize_t n = send(session->control_fd, reply + sent, (size_t)(length - sent), MSG_NOSIGNAL);
+        if (n <= 0) return;
+        sent += (int)n;
+    }
+}
+
+static bool mock_ftp_send_all(int fd, const uint8_t* data, size_t size) {
+    while (size > 0) {
+        ssize_t n = send(fd, data, size, MSG_NOSIGNAL);
+        if (n <= 0) return false;
+        data += n;
+        size -= (size_t)n;
+    }
+    return true;
+}
+
+/**
+ * Read one command line, without its CRLF; false once the client is gone
+ */
+static bool mock_ftp_read_line(mock_ftp_session_t* session) {
+    for (;;) {
+        char* end = memchr(session->buffer, '\n', session->buffered);
+        if (end) {
+            size_t length = (size_t)(end - session->buffer);
+            size_t copy = length < sizeof(session->line) - 1 ? length : sizeof(session->line) - 1;
+            memcpy(session->line, session->buffer, copy);
+            session->line[copy] = '\0';
+            if (copy > 0 && session->line[copy - 1] == '\r') {
+                session->line[copy - 1] = '\0';
+            }
+            session->buffered -= length + 1;
+            memmove(session->buffer, end + 1, session->buffered);
             return true;
         }
+        if (session->buffered == sizeof(session->buffer)) {
+            session->buffered = 0; // Overlong line, drop it
+        }
+        ssize_t n = recv(session->control_fd, session->buffer + session->buffered,
+                         sizeof(session->buffer) - session->buffered, 0);
+        if (n <= 0) return false;
+        session->buffered += (size_t)n;
+    }
+}
+
+/**
+ * Resolve a path argument against the session's directory, collapsing
+ * ".", ".." and repeated slashes
+ */
+static void mock_ftp_resolve_path(const mock_ftp_session_t* session, const char* arg,
+                                  char* path, size_t path_size) {
+    char joined[MOCK_FTP_MAX_PATH_LEN * 2];
+    if (arg[0] == '/') {
+        snprintf(joined, sizeof(joined), "%s", arg);
+    } else {
+        snprintf(joined, sizeof(joined), "%s/%s", session->cwd, arg);
+    }
+    
+    size_t length = 0;
+    path[length++] = '/';
+    const char* p = joined;
+    while (*p) {
+        while (*p == '/') p++;
+        const char* segment = p;
+        while (*p && *p != '/') p++;
+        size_t segment_len = (size_t)(p - segment);
+        
+        if (segment_len == 0 || (segment_len == 1 && segment[0] == '.')) {
+            continue;
+        }
+        if (segment_len == 2 && segment[0] == '.' && segment[1] == '.') {
+            while (length > 1 && path[length - 1] != '/') length--;
+            if (length > 1) length--;
+            continue;
+        }
+        if (length > 1 && length < path_size - 1) {
+            path[length++] = '/';
+        }
+        for (size_t i = 0; i < segment_len && length < path_size - 1; i++) {
+            path[length++] = segment[i];
+        }
+    }
+    path[length] = '\0';
+}
+
+/**
+ * Open the passive data socket and return its port
+ */
+static int mock_ftp_open_passive(mock_ftp_session_t* session) {
+    if (session->passive_fd >= 0) {
+        close(session->passive_fd);
+        session->passive_fd = -1;
+    }
+    
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t address_len = sizeof(address);
+    if (bind(fd, (struct sockaddr*)&address, sizeof(address)) != 0 || listen(fd, 1) != 0 ||
+        getsockname(fd, (struct sockaddr*)&address, &address_len) != 0) {
+        close(fd);
+        return -1;
+    }
+    
+    session->passive_fd = fd;
+    return ntohs(address.sin_port);
+}
+
+/**
+ * Accept the client's data connection on the passive socket
+ */
+static int mock_ftp_accept_data(mock_ftp_session_t* session) {
+    if (session->passive_fd < 0) return -1;
+    
+    struct pollfd pfd = { .fd = session->passive_fd, .events = POLLIN, .revents = 0 };
+    int fd = -1;
+    if (poll(&pfd, 1, MOCK_FTP_DATA_TIMEOUT_MS) == 1) {
+        fd = accept(session->passive_fd, NULL, NULL);
+    }
+    
+    close(session->passive_fd);
+    session->passive_fd = -1;
+    return fd;
+}
+
+static void mock_ftp_session_retr(mock_ftp_session_t* session, const char* path) {
+    mock_ftp_server_t* server = session->server;
+    
+    // Copy the file out so the transfer runs without the lock
+    pthread_mutex_lock(&g_mock_ftp_lock);
+    mock_ftp_file_t* file = mock_ftp_find_file_locked(server, path);
+    uint8_t* data = NULL;
+    size_t size = 0;
+    bool corrupted = file && file->is_corrupted;
+    if (file) {
+        size = file->size;
+        data = malloc(size > 0 ? size : 1);
+        if (data) memcpy(data, file->data, size);
+    }
+    pthread_mutex_unlock(&g_mock_ftp_lock);
+    
+    if (!file) {
+        mock_ftp_reply(session, "550 %s: No such file", path);
+        return;
+    }
+    if (!data || mock_ftp_random_double() < server->download_failure_rate) {
+        free(data);
+        pthread_mutex_lock(&g_mock_ftp_lock);
+        server->failed_downloads++;
+        pthread_mutex_unlock(&g_mock_ftp_lock);
+        mock_ftp_reply(session, "451 Download failed (simulated)");
+        return;
+    }
+    if (corrupted && size > 0) {
+        data[size / 2] ^= 0xFF;
+    }
+    
+    mock_ftp_reply(session, "150 Opening BINARY mode data connection (%zu bytes)", size);
+    int data_fd = mock_ftp_accept_data(session);
+    if (data_fd < 0) {
+        free(data);
+        mock_ftp_reply(session, "425 Can't open data connection");
+        return;
+    }
+    
+    mock_ftp_simulate_delay(server->latency_ms_min, server->latency_ms_max);
+    mock_ftp_simulate_transfer(server->bandwidth_bytes_per_sec, size);
+    bool sent = mock_ftp_send_all(data_fd, data, size);
+    close(data_fd);
+    free(data);
+    
+    if (!sent) {
+        mock_ftp_reply(session, "426 Connection closed; transfer aborted");
+        return;
+    }
+    
+    pthread_mutex_lock(&g_mock_ftp_lock);
+    server->total_downloads++;
+    server->bytes_downloaded += size;
+    pthread_mutex_unlock(&g_mock_ftp_lock);
+    mock_ftp_reply(session, "226 Transfer complete");
+}
+
+static void mock_ftp_session_stor(mock_ftp_session_t* session, const char* path) {
+    mock_ftp_server_t* server = session->server;
+    
+    if (mock_ftp_random_double() < server->upload_failure_rate) {
+        pthread_mutex_lock(&g_mock_ftp_lock);
+        server->failed_uploads++;
+        pthread_mutex_unlock(&g_mock_ftp_lock);
+        if (session->passive_fd >= 0) {
+            close(session->passive_fd);
+            session->passive_fd = -1;
+        }
+        mock_ftp_reply(session, "451 Upload failed (simulated)");
+        return;
+    }
+    
+    mock_ftp_reply(session, "150 Ok to send data");
+    int data_fd = mock_ftp_accept_data(session);
+    if (data_fd < 0) {
+        mock_ftp_reply(session, "425 Can't open data connection");
+        return;
+    }
+    
+    size_t capacity = 64 * 1024;
+    size_t size = 0;
+    uint8_t* data = malloc(capacity);
+    bool ok = data != NULL;
+    while (ok) {
+        if (size == capacity) {
+            uint8_t* grown = realloc(data, capacity * 2);
+            if (!grown) {
+                ok = false;
+                break;
+            }
+            data = grown;
+            capacity *= 2;
+        }
+        ssize_t n = recv(data_fd, data + size, capacity - size, 0);
+        if (n < 0) ok = false;
+        if (n <= 0) break;
+        size += (size_t)n;
+    }
+    close(data_fd);
+    
+    if (!ok) {
+        free(data);
+        mock_ftp_reply(session, "426 Connection closed; transfer aborted");
+        return;
+    }
+    
+    mock_ftp_simulate_delay(server->latency_ms_min, server->latency_ms_max);
+    mock_ftp_simulate_transfer(server->bandwidth_bytes_per_sec, size);
+    
+    pthread_mutex_lock(&g_mock_ftp_lock);
+    mock_ftp_result_t result = mock_ftp_store_locked(server, path, data, size);
+    pthread_mutex_unlock(&g_mock_ftp_lock);
+    if (result != MOCK_FTP_SUCCESS) {
+        free(data);
+        mock_ftp_reply(session, "552 Storage full");
+        return;
+    }
+    
+    mock_ftp_reply(session, "226 Transfer complete");
+}
+
+/**
+ * Send a listing of the files directly under dir; style is 'M' for MLSD,
+ * 'N' for NLST and 'L' for LIST
+ */
+static void mock_ftp_session_list(mock_ftp_session_t* session, const char* dir, char style) {
+    mock_ftp_server_t* server = session->server;
+    size_t dir_len = strlen(dir);
+    
+    // Build the listing under the lock, send it without
+    size_t capacity = 4096;
+    size_t length = 0;
+    char* listing = malloc(capacity);
+    if (!listing) {
+        mock_ftp_reply(session, "451 Out of memory");
+        return;
+    }
+    
+    pthread_mutex_lock(&g_mock_ftp_lock);
+    for (size_t i = 0; i < server->file_count; i++) {
+        const mock_ftp_file_t* file = &server->files[i];
+        const char* name = file->filename;
+        if (dir_len > 1) {
+            if (strncmp(name, dir, dir_len) != 0 || name[dir_len] != '/') continue;
+            name += dir_len + 1;
+        } else {
+            name += 1;
+        }
+        if (strchr(name, '/')) continue;
+        
+        char entry[MOCK_FTP_MAX_PATH_LEN + 128];
+        int entry_len;
+        struct tm modified;
+        gmtime_r(&file->modified_time, &modified);
+        if (style == 'M') {
+            entry_len = snprintf(entry, sizeof(entry),
+                                 "type=file;size=%zu;modify=%04d%02d%02d%02d%02d%02d; %s\r\n",
+                                 file->size, modified.tm_year + 1900, modified.tm_mon + 1,
+                                 modified.tm_mday, modified.tm_hour, modified.tm_min,
+                                 modified.tm_sec, name);
+        } else if (style == 'L') {
+            entry_len = snprintf(entry, sizeof(entry),
+                                 "-rw-r--r-- 1 ftp ftp %zu Jan 01 00:00 %s\r\n", file->size, name);
+        } else {
+            entry_len = snprintf(entry, sizeof(entry), "%s\r\n", name);
+        }
+        if (entry_len < 0 || (size_t)entry_len >= sizeof(entry)) continue;
+        
+        if (length + (size_t)entry_len > capacity) {
+            char* grown = realloc(listing, capacity * 2 + (size_t)entry_len);
+            if (!grown) break;
+            listing = grown;
+            capacity = capacity * 2 + (size_t)entry_len;
+        }
+        memcpy(listing + length, entry, (size_t)entry_len);
+        length += (size_t)entry_len;
+    }
+    pthread_mutex_unlock(&g_mock_ftp_lock);
+    
+    mock_ftp_reply(session, "150 Here comes the directory listing");
+    int data_fd = mock_ftp_accept_data(session);
+    if (data_fd < 0) {
+        free(listing);
+        mock_ftp_reply(session, "425 Can't open data connection");
+        return;
+    }
+    bool sent = mock_ftp_send_all(data_fd, (const uint8_t*)listing, length);
+    close(data_fd);
+    free(listing);
+    
+    mock_ftp_reply(session, sent ? "226 Directory send OK" : "426 Connection closed; transfer aborted");
+}
+
+/**
+ * Answer one command; false to end the session
+ */
+static bool mock_ftp_session_command(mock_ftp_session_t* session) {
+    mock_ftp_server_t* server = session->server;
+    char* command = session->line;
+    char* arg = strchr(command, ' ');
+    if (arg) {
+        *arg++ = '\0';
+    } else {
+        arg = command + strlen(command);
+    }
+    for (char* p = command; *p; p++) {
+        if (*p >= 'a' && *p <= 'z') *p = (char)(*p - 'a' + 'A');
+    }
+    
+    char path[MOCK_FTP_MAX_PATH_LEN];
+    
+    if (strcmp(command, "QUIT") == 0) {
+        mock_ftp_reply(session, "221 Goodbye");
+        return false;
+    }
+    if (strcmp(command, "USER") == 0) {
+        session->user_ok = strcmp(arg, server->username) == 0;
+        session->logged_in = false;
+        mock_ftp_reply(session, "331 Please specify the password");
+        return true;
+    }
+    if (strcmp(command, "PASS") == 0) {
+        session->logged_in = session->user_ok && strcmp(arg, server->password) == 0;
+        mock_ftp_reply(session, session->logged_in ? "230 Login successful" : "530 Login incorrect");
+        return true;
+    }
+    if (!session->logged_in) {
+        mock_ftp_reply(session, "530 Please login with USER and PASS");
+        return true;
+    }
+    
+    if (strcmp(command, "PWD") == 0 || strcmp(command, "XPWD") == 0) {
+        mock_ftp_reply(session, "257 \"%s\" is the current directory", session->cwd);
+    } else if (strcmp(command, "CWD") == 0 || strcmp(command, "CDUP") == 0) {
+        mock_ftp_resolve_path(session, strcmp(command, "CDUP") == 0 ? ".." : arg, path, sizeof(path));
+        snprintf(session->cwd, sizeof(session->cwd), "%s", path);
+        mock_ftp_reply(session, "250 Directory successfully changed");
+    } else if (strcmp(command, "MKD") == 0) {
+        mock_ftp_resolve_path(session, arg, path, sizeof(path));
+        mock_ftp_reply(session, "257 \"%s\" created", path);
+    } else if (strcmp(command, "SYST") == 0) {
+        mock_ftp_reply(session, "215 UNIX Type: L8");
+    } else if (strcmp(command, "FEAT") == 0) {
+        mock_ftp_reply(session, "211-Features:\r\n EPSV\r\n MDTM\r\n MLST type*;size*;modify*;\r\n"
+                                " PASV\r\n REST STREAM\r\n SIZE\r\n211 End");
+    } else if (strcmp(command, "TYPE") == 0 || strcmp(command, "MODE") == 0 ||
+               strcmp(command, "STRU") == 0 || strcmp(command, "NOOP") == 0 ||
+               strcmp(command, "OPTS") == 0) {
+        mock_ftp_reply(session, "200 OK");
+    } else if (strcmp(command, "EPSV") == 0) {
+        int port = mock_ftp_open_passive(session);
+        if (port < 0) {
+            mock_ftp_reply(session, "425 Can't open passive connection");
+        } else {
+            mock_ftp_reply(session, "229 Entering Extended Passive Mode (|||%d|)", port);
+        }
+    } else if (strcmp(command, "PASV") == 0) {
+        int port = mock_ftp_open_passive(session);
+        if (port < 0) {
+            mock_ftp_reply(session, "425 Can't open passive connection");
+        } else {
+            mock_ftp_reply(session, "227 Entering Passive Mode (127,0,0,1,%d,%d)", port >> 8, port & 0xFF);
+        }
+    } else if (strcmp(command, "SIZE") == 0 || strcmp(command, "MDTM") == 0) {
+        mock_ftp_resolve_path(session, arg, path, sizeof(path));
+        pthread_mutex_lock(&g_mock_ftp_lock);
+        mock_ftp_file_t* file = mock_ftp_find_file_locked(server, path);
+        size_t size = file ? file->size : 0;
+        time_t modified_time = file ? file->modified_time : 0;
+        pthread_mutex_unlock(&g_mock_ftp_lock);
+        
+        if (!file) {
+            mock_ftp_reply(session, "550 Could not get file size");
+        } else if (command[0] == 'S') {
+            mock_ftp_reply(session, "213 %zu", size);
+        } else {
+            struct tm modified;
+            gmtime_r(&modified_time, &modified);
+            mock_ftp_reply(session, "213 %04d%02d%02d%02d%02d%02d", modified.tm_year + 1900,
+                           modified.tm_mon + 1, modified.tm_mday, modified.tm_hour,
+                           modified.tm_min, modified.tm_sec);
+        }
+    } else if (strcmp(command, "REST") == 0) {
+        mock_ftp_reply(session, "350 Restart position accepted");
+    } else if (strcmp(command, "RETR") == 0) {
+        mock_ftp_resolve_path(session, arg, path, sizeof(path));
+        mock_ftp_session_retr(session, path);
+    } else if (strcmp(command, "STOR") == 0) {
+        mock_ftp_resolve_path(session, arg, path, sizeof(path));
+        mock_ftp_session_stor(session, path);
+    } else if (strcmp(command, "DELE") == 0) {
+        mock_ftp_resolve_path(session, arg, path, sizeof(path));
+        mock_ftp_result_t result = MOCK_FTP_ERROR_NETWORK;
+        if (mock_ftp_random_double() >= server->delete_failure_rate) {
+            pthread_mutex_lock(&g_mock_ftp_lock);
+            result = mock_ftp_remove_locked(server, path);
+            pthread_mutex_unlock(&g_mock_ftp_lock);
+        }
+        mock_ftp_reply(session, result == MOCK_FTP_SUCCESS ? "250 Delete operation successful"
+                                                           : "550 Delete operation failed");
+    } else if (strcmp(command, "MLSD") == 0 || strcmp(command, "NLST") == 0 ||
+               strcmp(command, "LIST") == 0) {
+        // Skip LIST options such as -a
+        const char* target = (arg[0] == '-') ? "" : arg;
+        mock_ftp_resolve_path(session, target, path, sizeof(path));
+        mock_ftp_session_list(session, path, command[0] == 'M' ? 'M' : (command[0] == 'N' ? 'N' : 'L'));
+    } else if (strcmp(command, "AVBL") == 0) {
+        pthread_mutex_lock(&g_mock_ftp_lock);
+        size_t available = server->storage_capacity > server->storage_used
+                               ? server->storage_capacity - server->storage_used : 0;
+        pthread_mutex_unlock(&g_mock_ftp_lock);
+        mock_ftp_reply(session, "213 %zu", available);
+    } else if (strcmp(command, "ABOR") == 0) {
+        mock_ftp_reply(session, "226 Abort successful");
+    } else {
+        // Includes HASH and XSHA256, so hash verification falls back
+        mock_ftp_reply(session, "502 Command not implemented");
+    }
+    
+    return true;
+}
+
+static void* mock_ftp_session_thread(void* arg) {
+    mock_ftp_session_t* session = arg;
+    mock_ftp_server_t* server = session->server;
+    
+    if (!server->is_available || mock_ftp_random_double() < server->connection_failure_rate) {
+        mock_ftp_reply(session, "421 Service not available");
+    } else {
+        mock_ftp_reply(session, "220 Mock FTP server ready");
+        while (mock_ftp_read_line(session) && mock_ftp_session_command(session)) {
+        }
+    }
+    
+    if (session->passive_fd >= 0) {
+        close(session->passive_fd);
+    }
+    
+    pthread_mutex_lock(&g_mock_ftp_lock);
+    for (int i = 0; i < server->session_count; i++) {
+        if (server->session_fds[i] == session->control_fd) {
+            server->session_fds[i] = server->session_fds[--server->session_count];
+            break;
+        }
+    }
+    close(session->control_fd);
+    pthread_cond_broadcast(&g_mock_ftp_session_done);
+    pthread_mutex_unlock(&g_mock_ftp_lock);
+    
+    free(session);
+    return NULL;
+}
+
+static void* mock_ftp_listen_thread(void* arg) {
+    mock_ftp_server_t* server = arg;
+    
+    for (;;) {
+        int fd = accept(server->listen_fd, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            break; // Listening socket shut down
+        }
+        
+        mock_ftp_session_t* session = calloc(1, sizeof(mock_ftp_session_t));
+        pthread_mutex_lock(&g_mock_ftp_lock);
+        bool accepted = session && server->listening && server->session_count < MOCK_FTP_MAX_SESSIONS;
+        if (accepted) {
+            session->server = server;
+            session->control_fd = fd;
+            session->passive_fd = -1;
+            strcpy(session->cwd, "/");
+            
+            pthread_t thread;
+            pthread_attr_t attributes;
+            pthread_attr_init(&attributes);
+            pthread_attr_setdetachstate(&attributes, PTHREAD_CREATE_DETACHED);
+            accepted = pthread_create(&thread, &attributes, mock_ftp_session_thread, session) == 0;
+            pthread_attr_destroy(&attributes);
+            if (accepted) {
+                server->session_fds[server->session_count++] = fd;
+            }
+        }
+        pthread_mutex_unlock(&g_mock_ftp_lock);
+        
+        if (!accepted) {
+            free(session);
+            close(fd);
+        }
+    }
+    
+    return NULL;
+}
+
+/**
+ * Serve a mock server over FTP on 127.0.0.1; the port is in listen_port
+ */
+int mock_ftp_server_listen(mock_ftp_server_t* server) {
+    if (!server) return MOCK_FTP_ERROR_CONNECTION_FAILED;
+    if (server->listening) return MOCK_FTP_SUCCESS;
+    
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return MOCK_FTP_ERROR_NETWORK;
+    
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t address_len = sizeof(address);
+    if (bind(fd, (struct sockaddr*)&address, sizeof(address)) != 0 ||
+        listen(fd, MOCK_FTP_MAX_SESSIONS) != 0 ||
+        getsockname(fd, (struct sockaddr*)&address, &address_len) != 0) {
+        close(fd);
+        return MOCK_FTP_ERROR_NETWORK;
+    }
+    
+    server->listen_fd = fd;
+    server->listen_port = ntohs(address.sin_port);
+    server->session_count = 0;
+    server->listening = true;
+    if (pthread_create(&server->listen_thread, NULL, mock_ftp_listen_thread, server) != 0) {
+        server->listening = false;
+        close(fd);
+        return MOCK_FTP_ERROR_NETWORK;
+    }
+    
+    if (g_detailed_logging) {
+        printf("Mock FTP %s:%d listening on 127.0.0.1:%d\n", server->host, server->port, server->listen_port);
+    }
+    
+    return MOCK_FTP_SUCCESS;
+}
+
+/**
+ * Stop serving a mock server and wait for its sessions to end
+ */
+void mock_ftp_server_stop(mock_ftp_server_t* server) {
+    if (!server) return;
+    
+    pthread_mutex_lock(&g_mock_ftp_lock);
+    bool listening = server->listening;
+    server->listening = false;
+    pthread_mutex_unlock(&g_mock_ftp_lock);
+    if (!listening) return;
+    
+    shutdown(server->listen_fd, SHUT_RDWR);
+    pthread_join(server->listen_thread, NULL);
+    close(server->listen_fd);
+    server->listen_fd = -1;
+    
+    pthread_mutex_lock(&g_mock_ftp_lock);
+    for (int i = 0; i < server->session_count; i++) {
+        shutdown(server->session_fds[i], SHUT_RDWR);
+    }
+    while (server->session_count > 0) {
+        pthread_cond_wait(&g_mock_ftp_session_done, &g_mock_ftp_lock);
+    }
+    pthread_mutex_unlock(&g_mock_ftp_lock);
+}
+
+/**
+ * Write a [server_N] section for every listening server, numbered in
+ * registry order, so netchunk_init() can load them
+ */
+int mock_ftp_write_server_config(FILE* file, const char* base_path) {
+    if (!file) return -1;
+    
+    int written = 0;
+    for (size_t i = 0; i < g_mock_ftp_server_count; i++) {
+        const mock_ftp_server_t* server = &g_mock_ftp_servers[i];
+        if (!server->listening) continue;
+        
+        written++;
+        fprintf(file, "[server_%d]\n", written);
+        fprintf(file, "host = 127.0.0.1\n");
+        fprintf(file, "port = %d\n", server->listen_port);
+        fprintf(file, "username = %s\n", server->username);
+        fprintf(file, "password = %s\n", server->password);
+        fprintf(file, "base_path = %s\n", base_path ? base_path : "/");
+        fprintf(file, "passive_mode = true\n\n");
     }
     
-    return false;
+    return ferror(file) ? -1 : written;
 }
 
 /**
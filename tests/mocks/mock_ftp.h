@@ -1,14 +1,17 @@
 #ifndef NETCHUNK_MOCK_FTP_H
 #define NETCHUNK_MOCK_FTP_H
 
+#include <pthread.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include <stdio.h>
 #include <time.h>
 
 // Maximum limits for mock FTP server
 #define MOCK_FTP_MAX_SERVERS 20
-#define MOCK_FTP_MAX_FILES_PER_SERVER 100
+#define MOCK_FTP_MAX_FILES_PER_SERVER 1024
+#define MOCK_FTP_MAX_SESSIONS 64 // Control connections served at once by one listening server
 #define MOCK_FTP_MAX_HOST_LEN 256
 #define MOCK_FTP_MAX_PATH_LEN 512
 #define MOCK_FTP_MAX_USERNAME_LEN 64
@@ -47,8 +50,10 @@ typedef struct mock_ftp_server {
     double connection_failure_rate;
     double upload_failure_rate;
     double download_failure_rate;
+    double delete_failure_rate;
     uint32_t latency_ms_min;
     uint32_t latency_ms_max;
+    uint64_t bandwidth_bytes_per_sec; // 0 = unlimited
     
     // Storage simulation
     size_t storage_capacity;
@@ -68,6 +73,15 @@ typedef struct mock_ftp_server {
     bool simulate_concurrent_access;
     uint32_t max_concurrent_connections;
     uint32_t current_connections;
+
+    // Loopback FTP front end (mock_ftp_server_listen)
+    bool listening;
+    int listen_fd;
+    uint16_t listen_port; // Port on 127.0.0.1 the real FTP client connects to
+    pthread_t listen_thread;
+    int session_fds[MOCK_FTP_MAX_SESSIONS];
+    int session_count;
+    uint64_t total_deletes;
 } mock_ftp_server_t;
 
 /**
@@ -119,6 +133,7 @@ void mock_ftp_set_server_availability(mock_ftp_server_t* server, bool available)
 void mock_ftp_set_failure_rates(mock_ftp_server_t* server, 
                                double connection_rate, double upload_rate, double download_rate);
 void mock_ftp_set_latency(mock_ftp_server_t* server, uint32_t min_ms, uint32_t max_ms);
+void mock_ftp_set_bandwidth(mock_ftp_server_t* server, uint64_t bytes_per_sec);
 void mock_ftp_set_storage_capacity(mock_ftp_server_t* server, size_t capacity);
 void mock_ftp_simulate_corruption(mock_ftp_server_t* server, const char* filename, bool corrupted);
 
@@ -145,6 +160,13 @@ int mock_ftp_list_files(mock_ftp_client_context_t* ctx, char*** filenames, size_
 bool mock_ftp_file_exists(mock_ftp_client_context_t* ctx, const char* remote_path);
 size_t mock_ftp_get_file_size(mock_ftp_client_context_t* ctx, const char* remote_path);
 
+// Loopback FTP front end: serves a mock server's files to the real FTP
+// client over 127.0.0.1 (passive mode only), applying the server's
+// availability, failure rates, latency and bandwidth to every transfer
+int mock_ftp_server_listen(mock_ftp_server_t* server);
+void mock_ftp_server_stop(mock_ftp_server_t* server);
+int mock_ftp_write_server_config(FILE* file, const char* base_path);
+
 // Mock FTP server utilities
 void mock_ftp_server_clear_files(mock_ftp_server_t* server);
 void mock_ftp_server_print_stats(const mock_ftp_server_t* server);
@@ -0,0 +1,260 @@
+#include "unity.h"
+#include "test_utils.h"
+#include "catalog.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TEST_FILE_COUNT 2000
+
+// Test data and fixtures
+static test_file_context_t test_files;
+static netchunk_catalog_t test_catalog;
+static char catalog_path[TEST_MAX_PATH_LEN];
+
+void setUp(void) {
+    // Initialize test environment
+    test_setup_environment();
+
+    // Create temporary directory for the catalog file
+    TEST_ASSERT_EQUAL_INT(0, create_temp_test_directory(&test_files));
+    snprintf(catalog_path, sizeof(catalog_path), "%s/data/%s", test_files.temp_dir, NETCHUNK_CATALOG_FILENAME);
+
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_catalog_init(&test_catalog, catalog_path));
+}
+
+void tearDown(void) {
+    netchunk_catalog_cleanup(&test_catalog);
+
+    // Remove temporary test files
+    cleanup_temp_test_directory(&test_files);
+
+    // Cleanup test environment
+    test_cleanup_environment();
+}
+
+// Helpers
+
+static void make_manifest(netchunk_file_manifest_t* manifest, const char* name, uint32_t seed) {
+    memset(manifest, 0, sizeof(netchunk_file_manifest_t));
+    strcpy(manifest->original_filename, name);
+
+    test_seed_random(seed);
+    for (int i = 0; i < NETCHUNK_HASH_LENGTH; i++) {
+        manifest->file_hash[i] = (uint8_t)test_random_uint32();
+    }
+    manifest->total_size = 1000 + seed;
+    manifest->original_size = manifest->total_size;
+    manifest->chunk_count = seed % 17;
+    manifest->created_timestamp = 1700000000 + seed;
+    manifest->last_modified = 1700000100 + seed;
+}
+
+// Test adding, replacing, finding and removing files
+void test_catalog_put_lookup_remove(void) {
+    netchunk_file_manifest_t manifest;
+    const char* names[] = { "photos/b.jpg", "a.txt", "notes.md", "photos/a.jpg" };
+
+    for (uint32_t i = 0; i < 4; i++) {
+        make_manifest(&manifest, names[i], i + 1);
+        TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_catalog_put(&test_catalog, &manifest, 0, 0));
+    }
+    TEST_ASSERT_EQUAL_size_t(4, test_catalog.count);
+    TEST_ASSERT_TRUE(test_catalog.dirty);
+
+    // Entries stay in name order
+    TEST_ASSERT_EQUAL_STRING("a.txt", test_catalog.entries[0].name);
+    TEST_ASSERT_EQUAL_STRING("notes.md", test_catalog.entries[1].name);
+    TEST_ASSERT_EQUAL_STRING("photos/a.jpg", test_catalog.entries[2].name);
+    TEST_ASSERT_EQUAL_STRING("photos/b.jpg", test_catalog.entries[3].name);
+
+    const netchunk_catalog_entry_t* entry = netchunk_catalog_lookup(&test_catalog, "notes.md");
+    TEST_ASSERT_NOT_NULL(entry);
+    TEST_ASSERT_EQUAL_UINT64(1003, entry->total_size);
+    TEST_ASSERT_EQUAL_UINT32(3, entry->chunk_count);
+    TEST_ASSERT_NULL(netchunk_catalog_lookup(&test_catalog, "missing.txt"));
+
+    // Putting a known name replaces its entry
+    make_manifest(&manifest, "notes.md", 42);
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_catalog_put(&test_catalog, &manifest, 1700000500, 321));
+    TEST_ASSERT_EQUAL_size_t(4, test_catalog.count);
+    entry = netchunk_catalog_lookup(&test_catalog, "notes.md");
+    TEST_ASSERT_EQUAL_UINT64(1042, entry->total_size);
+    TEST_ASSERT_EQUAL_MEMORY(manifest.file_hash, entry->file_hash, NETCHUNK_HASH_LENGTH);
+    TEST_ASSERT_EQUAL_INT64(1700000500, (int64_t)entry->remote_modified);
+    TEST_ASSERT_EQUAL_UINT64(321, entry->remote_size);
+
+    TEST_ASSERT_TRUE(netchunk_catalog_remove(&test_catalog, "photos/a.jpg"));
+    TEST_ASSERT_FALSE(netchunk_catalog_remove(&test_catalog, "photos/a.jpg"));
+    TEST_ASSERT_EQUAL_size_t(3, test_catalog.count);
+    TEST_ASSERT_EQUAL_STRING("photos/b.jpg", test_catalog.entries[2].name);
+}
+
+// Test that the catalog round-trips through its backing file
+void test_catalog_save_and_load(void) {
+    netchunk_file_manifest_t manifest;
+    char name[64];
+
+    for (uint32_t i = 0; i < TEST_FILE_COUNT; i++) {
+        snprintf(name, sizeof(name), "dir%u/file%05u.bin", i % 7, i);
+        make_manifest(&manifest, name, i);
+        TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_catalog_put(&test_catalog, &manifest, 1700001000 + i, 200 + i));
+    }
+    test_catalog.last_sync = 1700002000;
+
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_catalog_save(&test_catalog));
+    TEST_ASSERT_FALSE(test_catalog.dirty);
+    TEST_ASSERT_TRUE(file_exists(catalog_path));
+
+    netchunk_catalog_t loaded;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_catalog_init(&loaded, catalog_path));
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_catalog_load(&loaded));
+    TEST_ASSERT_EQUAL_size_t(TEST_FILE_COUNT, loaded.count);
+    TEST_ASSERT_EQUAL_INT64(1700002000, (int64_t)loaded.last_sync);
+    TEST_ASSERT_FALSE(loaded.dirty);
+
+    for (uint32_t i = 0; i < TEST_FILE_COUNT; i += 97) {
+        snprintf(name, sizeof(name), "dir%u/file%05u.bin", i % 7, i);
+        make_manifest(&manifest, name, i);
+
+        const netchunk_catalog_entry_t* entry = netchunk_catalog_lookup(&loaded, name);
+        TEST_ASSERT_NOT_NULL(entry);
+        TEST_ASSERT_EQUAL_UINT64(manifest.total_size, entry->total_size);
+        TEST_ASSERT_EQUAL_MEMORY(manifest.file_hash, entry->file_hash, NETCHUNK_HASH_LENGTH);
+        TEST_ASSERT_EQUAL_UINT32(manifest.chunk_count, entry->chunk_count);
+        TEST_ASSERT_EQUAL_INT64((int64_t)manifest.created_timestamp, (int64_t)entry->created_timestamp);
+        TEST_ASSERT_EQUAL_INT64((int64_t)manifest.last_modified, (int64_t)entry->last_modified);
+        TEST_ASSERT_EQUAL_INT64(1700001000 + i, (int64_t)entry->remote_modified);
+        TEST_ASSERT_EQUAL_UINT64(200 + i, entry->remote_size);
+    }
+
+    netchunk_catalog_cleanup(&loaded);
+}
+
+// Test loading before any catalog was written
+void test_catalog_load_missing_file(void) {
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_catalog_load(&test_catalog));
+    TEST_ASSERT_EQUAL_size_t(0, test_catalog.count);
+    TEST_ASSERT_EQUAL_INT64(0, (int64_t)test_catalog.last_sync);
+}
+
+// Test that remote manifest names encode and decode losslessly
+void test_catalog_manifest_names(void) {
+    const char* names[] = { "report.pdf", "photos/2024/img 01.jpg", ".hidden", "a=b", "..", "caf\xc3\xa9.txt" };
+    char path[NETCHUNK_MAX_PATH_LEN];
+    char decoded[NETCHUNK_FTP_MAX_NAME_LEN];
+
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_ftp_manifest_path(names[i], path, sizeof(path)));
+
+        // One flat file inside the manifest directory
+        const char* entry_name = path + strlen(NETCHUNK_FTP_MANIFEST_DIR) + 1;
+        TEST_ASSERT_EQUAL_INT(0, strncmp(path, NETCHUNK_FTP_MANIFEST_DIR "/", strlen(NETCHUNK_FTP_MANIFEST_DIR) + 1));
+        TEST_ASSERT_NULL(strchr(entry_name, '/'));
+        TEST_ASSERT_NOT_EQUAL('.', entry_name[0]);
+
+        TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_ftp_manifest_name(entry_name, decoded, sizeof(decoded)));
+        TEST_ASSERT_EQUAL_STRING(names[i], decoded);
+    }
+
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_ftp_manifest_path("photos/img 01.jpg", path, sizeof(path)));
+    TEST_ASSERT_EQUAL_STRING("manifests/photos=2Fimg=2001.jpg.manifest", path);
+
+    // Anything the encoder would not have written is not a manifest
+    TEST_ASSERT_NOT_EQUAL(NETCHUNK_SUCCESS, netchunk_ftp_manifest_name("file.chunk", decoded, sizeof(decoded)));
+    TEST_ASSERT_NOT_EQUAL(NETCHUNK_SUCCESS, netchunk_ftp_manifest_name(".manifest", decoded, sizeof(decoded)));
+    TEST_ASSERT_NOT_EQUAL(NETCHUNK_SUCCESS, netchunk_ftp_manifest_name("a.manifest.part42", decoded, sizeof(decoded)));
+    TEST_ASSERT_NOT_EQUAL(NETCHUNK_SUCCESS, netchunk_ftp_manifest_name("=61.manifest", decoded, sizeof(decoded)));
+    TEST_ASSERT_NOT_EQUAL(NETCHUNK_SUCCESS, netchunk_ftp_manifest_name("a=2f.manifest", decoded, sizeof(decoded)));
+    TEST_ASSERT_NOT_EQUAL(NETCHUNK_SUCCESS, netchunk_ftp_manifest_name("a=2.manifest", decoded, sizeof(decoded)));
+
+    // Names whose manifest file name would be too long are rejected
+    char long_name[NETCHUNK_FTP_MAX_NAME_LEN];
+    memset(long_name, 'x', sizeof(long_name) - 1);
+    long_name[sizeof(long_name) - 1] = '\0';
+    TEST_ASSERT_EQUAL(NETCHUNK_ERROR_INVALID_ARGUMENT, netchunk_ftp_manifest_path(long_name, path, sizeof(path)));
+}
+
+// Test parsing of MLSD listings
+void test_catalog_parse_mlsd(void) {
+    const char* listing =
+        "type=cdir;modify=20240101000000; .\r\n"
+        "type=pdir;modify=20240101000000; ..\r\n"
+        "type=file;size=1234;modify=20240315103000; a.txt.manifest\r\n"
+        "type=dir;modify=20240101000000; sub\r\n"
+        "Type=File;Size=99;Modify=20240315103001.250;UNIX.mode=0644; with space.manifest\n"
+        "garbage-without-space\r\n";
+
+    netchunk_ftp_dir_entry_t* entries = NULL;
+    size_t count = 0;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_ftp_parse_mlsd(listing, strlen(listing), &entries, &count));
+    TEST_ASSERT_EQUAL_size_t(2, count);
+
+    TEST_ASSERT_EQUAL_STRING("a.txt.manifest", entries[0].name);
+    TEST_ASSERT_EQUAL_UINT64(1234, entries[0].size);
+    TEST_ASSERT_EQUAL_INT64(1710498600, (int64_t)entries[0].modified); // 2024-03-15 10:30:00 UTC
+
+    TEST_ASSERT_EQUAL_STRING("with space.manifest", entries[1].name);
+    TEST_ASSERT_EQUAL_UINT64(99, entries[1].size);
+    TEST_ASSERT_EQUAL_INT64(1710498601, (int64_t)entries[1].modified);
+
+    free(entries);
+
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_ftp_parse_mlsd("", 0, &entries, &count));
+    TEST_ASSERT_EQUAL_size_t(0, count);
+    free(entries);
+}
+
+// Test that a failed sync leaves the catalog untouched
+void test_catalog_sync_without_servers(void) {
+    netchunk_config_t config;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_config_init_defaults(&config));
+
+    // One server on a port nothing listens on
+    config.server_count = 1;
+    strcpy(config.servers[0].id, "server_1");
+    strcpy(config.servers[0].host, "127.0.0.1");
+    config.servers[0].port = 1;
+    strcpy(config.servers[0].username, "test");
+    strcpy(config.servers[0].password, "test");
+    strcpy(config.servers[0].base_path, "/netchunk");
+    config.servers[0].passive_mode = true;
+
+    netchunk_ftp_context_t ftp_context;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_ftp_init(&ftp_context, &config));
+
+    netchunk_file_manifest_t manifest;
+    make_manifest(&manifest, "kept.txt", 7);
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_catalog_put(&test_catalog, &manifest, 0, 0));
+
+    netchunk_catalog_sync_stats_t stats;
+    TEST_ASSERT_EQUAL(NETCHUNK_ERROR_SERVER_UNAVAILABLE,
+        netchunk_catalog_sync(&test_catalog, &ftp_context, &config, &stats));
+    TEST_ASSERT_EQUAL_size_t(1, test_catalog.count);
+    TEST_ASSERT_NOT_NULL(netchunk_catalog_lookup(&test_catalog, "kept.txt"));
+    TEST_ASSERT_EQUAL_INT64(0, (int64_t)test_catalog.last_sync);
+
+    netchunk_ftp_cleanup(&ftp_context);
+    netchunk_config_cleanup(&config);
+}
+
+// Unity test runner
+int main(void) {
+    UNITY_BEGIN();
+
+    // Index tests
+    RUN_TEST(test_catalog_put_lookup_remove);
+
+    // Persistence tests
+    RUN_TEST(test_catalog_save_and_load);
+    RUN_TEST(test_catalog_load_missing_file);
+
+    // Remote layout tests
+    RUN_TEST(test_catalog_manifest_names);
+    RUN_TEST(test_catalog_parse_mlsd);
+
+    // Sync tests
+    RUN_TEST(test_catalog_sync_without_servers);
+
+    return UNITY_END();
+}
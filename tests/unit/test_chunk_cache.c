@@ -0,0 +1,189 @@
+#include "unity.h"
+#include "test_utils.h"
+#include "chunk_cache.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TEST_CHUNK_SIZE 1024
+
+// Test data and fixtures
+static netchunk_chunk_cache_t cache;
+
+void setUp(void) {
+    // Initialize test environment
+    test_setup_environment();
+    memset(&cache, 0, sizeof(cache));
+}
+
+void tearDown(void) {
+    netchunk_chunk_cache_cleanup(&cache);
+
+    // Cleanup test environment
+    test_cleanup_environment();
+}
+
+// Helpers
+
+static void make_hash(uint8_t* hash, uint32_t key) {
+    test_seed_random(key);
+    for (int i = 0; i < NETCHUNK_HASH_LENGTH; i++) {
+        hash[i] = (uint8_t)test_random_uint32();
+    }
+}
+
+static uint8_t* make_data(uint8_t fill) {
+    uint8_t* data = malloc(TEST_CHUNK_SIZE);
+    TEST_ASSERT_NOT_NULL(data);
+    memset(data, fill, TEST_CHUNK_SIZE);
+    return data;
+}
+
+static void insert_and_release(uint32_t key) {
+    uint8_t hash[NETCHUNK_HASH_LENGTH];
+    make_hash(hash, key);
+    netchunk_chunk_cache_entry_t* entry = netchunk_chunk_cache_insert(&cache, hash, make_data((uint8_t)key),
+        TEST_CHUNK_SIZE, 0, true);
+    TEST_ASSERT_NOT_NULL(entry);
+    netchunk_chunk_cache_release(&cache, entry);
+}
+
+static bool cached(uint32_t key) {
+    uint8_t hash[NETCHUNK_HASH_LENGTH];
+    make_hash(hash, key);
+    return netchunk_chunk_cache_contains(&cache, hash);
+}
+
+// Test that inserted chunks are found with their data and counted
+void test_chunk_cache_insert_acquire(void) {
+    uint8_t hash[NETCHUNK_HASH_LENGTH];
+
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_chunk_cache_init(&cache, 4 * TEST_CHUNK_SIZE));
+
+    make_hash(hash, 1);
+    TEST_ASSERT_NULL(netchunk_chunk_cache_acquire(&cache, hash));
+    TEST_ASSERT_EQUAL_UINT64(1, cache.misses);
+
+    insert_and_release(1);
+    netchunk_chunk_cache_entry_t* entry = netchunk_chunk_cache_acquire(&cache, hash);
+    TEST_ASSERT_NOT_NULL(entry);
+    TEST_ASSERT_EQUAL_UINT64(1, cache.hits);
+    TEST_ASSERT_EQUAL_size_t(TEST_CHUNK_SIZE, entry->size);
+    TEST_ASSERT_EQUAL_UINT8(1, entry->data[TEST_CHUNK_SIZE - 1]);
+    TEST_ASSERT_TRUE(entry->verified);
+
+    // A second insert of the same hash returns the cached entry
+    netchunk_chunk_cache_entry_t* again = netchunk_chunk_cache_insert(&cache, hash, make_data(9),
+        TEST_CHUNK_SIZE, 1, false);
+    TEST_ASSERT_TRUE(entry == again);
+    TEST_ASSERT_EQUAL_UINT8(1, again->data[0]);
+    TEST_ASSERT_EQUAL_size_t(1, cache.count);
+
+    netchunk_chunk_cache_release(&cache, again);
+    netchunk_chunk_cache_release(&cache, entry);
+    TEST_ASSERT_EQUAL_size_t(TEST_CHUNK_SIZE, cache.used_bytes);
+}
+
+// Test that the least recently used chunks are evicted first
+void test_chunk_cache_lru_eviction(void) {
+    uint8_t hash[NETCHUNK_HASH_LENGTH];
+
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_chunk_cache_init(&cache, 3 * TEST_CHUNK_SIZE));
+
+    insert_and_release(1);
+    insert_and_release(2);
+    insert_and_release(3);
+
+    // Touch chunk 1 so chunk 2 becomes the oldest
+    make_hash(hash, 1);
+    netchunk_chunk_cache_release(&cache, netchunk_chunk_cache_acquire(&cache, hash));
+
+    insert_and_release(4);
+    TEST_ASSERT_TRUE(cached(1));
+    TEST_ASSERT_FALSE(cached(2));
+    TEST_ASSERT_TRUE(cached(3));
+    TEST_ASSERT_TRUE(cached(4));
+    TEST_ASSERT_EQUAL_UINT64(1, cache.evictions);
+    TEST_ASSERT_EQUAL_size_t(3 * TEST_CHUNK_SIZE, cache.used_bytes);
+}
+
+// Test that pinned chunks outlive the budget until released
+void test_chunk_cache_pinned_entries(void) {
+    uint8_t hash[NETCHUNK_HASH_LENGTH];
+
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_chunk_cache_init(&cache, 0));
+
+    make_hash(hash, 7);
+    netchunk_chunk_cache_entry_t* entry = netchunk_chunk_cache_insert(&cache, hash, make_data(7),
+        TEST_CHUNK_SIZE, 2, false);
+    TEST_ASSERT_NOT_NULL(entry);
+    TEST_ASSERT_TRUE(cached(7));
+    TEST_ASSERT_EQUAL_INT(2, entry->server_index);
+
+    netchunk_chunk_cache_pin(&cache, entry);
+    netchunk_chunk_cache_release(&cache, entry);
+    TEST_ASSERT_TRUE(cached(7));
+
+    netchunk_chunk_cache_release(&cache, entry);
+    TEST_ASSERT_FALSE(cached(7));
+    TEST_ASSERT_EQUAL_size_t(0, cache.used_bytes);
+}
+
+// Test that removed chunks miss at once but stay readable while pinned
+void test_chunk_cache_remove(void) {
+    uint8_t hash[NETCHUNK_HASH_LENGTH];
+
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_chunk_cache_init(&cache, 4 * TEST_CHUNK_SIZE));
+
+    make_hash(hash, 5);
+    netchunk_chunk_cache_entry_t* entry = netchunk_chunk_cache_insert(&cache, hash, make_data(5),
+        TEST_CHUNK_SIZE, 0, false);
+    TEST_ASSERT_NOT_NULL(entry);
+
+    netchunk_chunk_cache_remove(&cache, entry);
+    TEST_ASSERT_FALSE(cached(5));
+    TEST_ASSERT_EQUAL_size_t(0, cache.count);
+    TEST_ASSERT_EQUAL_UINT8(5, entry->data[0]);
+
+    // A fresh copy can be cached while the removed one is still pinned
+    insert_and_release(5);
+    TEST_ASSERT_TRUE(cached(5));
+
+    netchunk_chunk_cache_release(&cache, entry);
+    TEST_ASSERT_TRUE(cached(5));
+    TEST_ASSERT_EQUAL_size_t(1, cache.count);
+}
+
+// Test that the table grows and keeps every chunk reachable
+void test_chunk_cache_grow(void) {
+    uint32_t total = NETCHUNK_CHUNK_CACHE_INITIAL_BUCKETS * 4;
+
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_chunk_cache_init(&cache, (size_t)total * TEST_CHUNK_SIZE));
+
+    for (uint32_t key = 0; key < total; key++) {
+        insert_and_release(key);
+    }
+
+    TEST_ASSERT_EQUAL_size_t(total, cache.count);
+    TEST_ASSERT_TRUE(cache.bucket_count > NETCHUNK_CHUNK_CACHE_INITIAL_BUCKETS);
+    for (uint32_t key = 0; key < total; key++) {
+        TEST_ASSERT_TRUE(cached(key));
+    }
+    TEST_ASSERT_EQUAL_UINT64(0, cache.evictions);
+}
+
+// Unity test runner
+int main(void) {
+    UNITY_BEGIN();
+
+    // Lookup tests
+    RUN_TEST(test_chunk_cache_insert_acquire);
+    RUN_TEST(test_chunk_cache_grow);
+
+    // Eviction tests
+    RUN_TEST(test_chunk_cache_lru_eviction);
+    RUN_TEST(test_chunk_cache_pinned_entries);
+    RUN_TEST(test_chunk_cache_remove);
+
+    return UNITY_END();
+}
@@ -0,0 +1,278 @@
+#include "unity.h"
+#include "test_utils.h"
+#include "chunker.h"
+#include "crypto.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TEST_CHUNK_SIZE NETCHUNK_MIN_CHUNK_SIZE
+#define TEST_MAX_CHUNKS 256
+
+// Chunk boundaries recorded from one pass over a file
+typedef struct chunk_layout {
+    uint8_t hashes[TEST_MAX_CHUNKS][NETCHUNK_HASH_LENGTH];
+    size_t sizes[TEST_MAX_CHUNKS];
+    size_t offsets[TEST_MAX_CHUNKS];
+    uint32_t count;
+    uint8_t file_hash[NETCHUNK_HASH_LENGTH];
+} chunk_layout_t;
+
+// Test data and fixtures
+static test_file_context_t test_files;
+static chunk_layout_t layout_a;
+static chunk_layout_t layout_b;
+
+void setUp(void) {
+    // Initialize test environment
+    test_setup_environment();
+
+    // Create temporary directory for test files
+    TEST_ASSERT_EQUAL_INT(0, create_temp_test_directory(&test_files));
+
+    memset(&layout_a, 0, sizeof(layout_a));
+    memset(&layout_b, 0, sizeof(layout_b));
+}
+
+void tearDown(void) {
+    // Remove temporary test files
+    cleanup_temp_test_directory(&test_files);
+
+    // Cleanup test environment
+    test_cleanup_environment();
+}
+
+// Helpers
+
+static uint8_t* make_random_data(size_t size, uint32_t seed) {
+    uint8_t* data = malloc(size + 1);
+    TEST_ASSERT_NOT_NULL(data);
+
+    test_seed_random(seed);
+    for (size_t i = 0; i < size; i++) {
+        data[i] = (uint8_t)test_random_uint32();
+    }
+    return data;
+}
+
+static void write_data_file(const char* path, const uint8_t* data, size_t size) {
+    FILE* fp = fopen(path, "wb");
+    TEST_ASSERT_NOT_NULL(fp);
+    TEST_ASSERT_EQUAL_size_t(size, fwrite(data, 1, size, fp));
+    fclose(fp);
+}
+
+static void chunk_file(const char* path, netchunk_chunking_mode_t mode, chunk_layout_t* layout) {
+    netchunk_chunker_context_t context;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_chunker_init(&context, path, TEST_CHUNK_SIZE));
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_chunker_set_mode(&context, mode));
+
+    netchunk_chunk_t chunk;
+    netchunk_error_t result;
+    while ((result = netchunk_chunker_next_chunk(&context, &chunk)) == NETCHUNK_SUCCESS) {
+        TEST_ASSERT_TRUE(layout->count < TEST_MAX_CHUNKS);
+        TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_chunk_verify_integrity(&chunk));
+        TEST_ASSERT_EQUAL_UINT32(layout->count, chunk.sequence_number);
+
+        memcpy(layout->hashes[layout->count], chunk.hash, NETCHUNK_HASH_LENGTH);
+        layout->sizes[layout->count] = chunk.size;
+        layout->offsets[layout->count] = chunk.offset;
+        layout->count++;
+        netchunk_chunk_cleanup(&chunk);
+    }
+    TEST_ASSERT_EQUAL(NETCHUNK_ERROR_EOF, result);
+    TEST_ASSERT_EQUAL_UINT32(layout->count, context.total_chunks);
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_chunker_get_file_hash(&context, layout->file_hash));
+
+    netchunk_chunker_cleanup(&context);
+}
+
+static void assert_contiguous(const chunk_layout_t* layout, size_t file_size) {
+    size_t expected_offset = 0;
+    for (uint32_t i = 0; i < layout->count; i++) {
+        TEST_ASSERT_EQUAL_size_t(expected_offset, layout->offsets[i]);
+        expected_offset += layout->sizes[i];
+    }
+    TEST_ASSERT_EQUAL_size_t(file_size, expected_offset);
+}
+
+static uint32_t count_shared_chunks(const chunk_layout_t* from, const chunk_layout_t* in) {
+    uint32_t shared = 0;
+    for (uint32_t i = 0; i < from->count; i++) {
+        for (uint32_t j = 0; j < in->count; j++) {
+            if (memcmp(from->hashes[i], in->hashes[j], NETCHUNK_HASH_LENGTH) == 0) {
+                shared++;
+                break;
+            }
+        }
+    }
+    return shared;
+}
+
+// Test fixed-size chunking offsets and the single-pass file hash
+void test_chunker_fixed_offsets(void) {
+    char path[TEST_MAX_PATH_LEN];
+    snprintf(path, sizeof(path), "%s/fixed.dat", test_files.temp_dir);
+
+    size_t file_size = TEST_CHUNK_SIZE * 2 + TEST_CHUNK_SIZE / 2;
+    uint8_t* data = make_random_data(file_size, 1);
+    write_data_file(path, data, file_size);
+
+    chunk_file(path, NETCHUNK_CHUNKING_FIXED, &layout_a);
+
+    TEST_ASSERT_EQUAL_UINT32(3, layout_a.count);
+    TEST_ASSERT_EQUAL_size_t(TEST_CHUNK_SIZE, layout_a.sizes[0]);
+    TEST_ASSERT_EQUAL_size_t(TEST_CHUNK_SIZE, layout_a.sizes[1]);
+    TEST_ASSERT_EQUAL_size_t(TEST_CHUNK_SIZE / 2, layout_a.sizes[2]);
+    assert_contiguous(&layout_a, file_size);
+
+    uint8_t expected_hash[NETCHUNK_HASH_LENGTH];
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_sha256_hash(data, file_size, expected_hash));
+    TEST_ASSERT_EQUAL_MEMORY(expected_hash, layout_a.file_hash, NETCHUNK_HASH_LENGTH);
+
+    free(data);
+}
+
+// Test content-defined chunk sizes stay within bounds and tile the file
+void test_chunker_cdc_bounds(void) {
+    char path[TEST_MAX_PATH_LEN];
+    snprintf(path, sizeof(path), "%s/cdc.dat", test_files.temp_dir);
+
+    size_t file_size = TEST_CHUNK_SIZE * 16 + 12345;
+    uint8_t* data = make_random_data(file_size, 2);
+    write_data_file(path, data, file_size);
+
+    chunk_file(path, NETCHUNK_CHUNKING_CDC, &layout_a);
+
+    assert_contiguous(&layout_a, file_size);
+    TEST_ASSERT_TRUE(layout_a.count > 4);
+    TEST_ASSERT_TRUE(layout_a.count < 64);
+    for (uint32_t i = 0; i + 1 < layout_a.count; i++) {
+        TEST_ASSERT_TRUE(layout_a.sizes[i] >= NETCHUNK_CDC_MIN_CHUNK_SIZE);
+        TEST_ASSERT_TRUE(layout_a.sizes[i] <= TEST_CHUNK_SIZE * 4);
+    }
+
+    uint8_t expected_hash[NETCHUNK_HASH_LENGTH];
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_sha256_hash(data, file_size, expected_hash));
+    TEST_ASSERT_EQUAL_MEMORY(expected_hash, layout_a.file_hash, NETCHUNK_HASH_LENGTH);
+
+    free(data);
+}
+
+// Test that an insertion near the start only changes the chunks around it
+void test_chunker_cdc_resyncs_after_insert(void) {
+    char path_a[TEST_MAX_PATH_LEN];
+    char path_b[TEST_MAX_PATH_LEN];
+    snprintf(path_a, sizeof(path_a), "%s/original.dat", test_files.temp_dir);
+    snprintf(path_b, sizeof(path_b), "%s/edited.dat", test_files.temp_dir);
+
+    size_t file_size = TEST_CHUNK_SIZE * 12;
+    uint8_t* data = make_random_data(file_size, 3);
+    write_data_file(path_a, data, file_size);
+
+    // Same content with one byte inserted at offset 100
+    memmove(data + 101, data + 100, file_size - 100);
+    data[100] = 0x5a;
+    write_data_file(path_b, data, file_size + 1);
+
+    chunk_file(path_a, NETCHUNK_CHUNKING_CDC, &layout_a);
+    chunk_file(path_b, NETCHUNK_CHUNKING_CDC, &layout_b);
+    assert_contiguous(&layout_b, file_size + 1);
+    TEST_ASSERT_TRUE(count_shared_chunks(&layout_b, &layout_a) + 2 >= layout_b.count);
+
+    // Fixed-size chunking shifts every boundary
+    memset(&layout_a, 0, sizeof(layout_a));
+    memset(&layout_b, 0, sizeof(layout_b));
+    chunk_file(path_a, NETCHUNK_CHUNKING_FIXED, &layout_a);
+    chunk_file(path_b, NETCHUNK_CHUNKING_FIXED, &layout_b);
+    TEST_ASSERT_EQUAL_UINT32(0, count_shared_chunks(&layout_b, &layout_a));
+
+    free(data);
+}
+
+// Test that the mode cannot change once chunking has started
+void test_chunker_set_mode_after_read(void) {
+    char path[TEST_MAX_PATH_LEN];
+    snprintf(path, sizeof(path), "%s/mode.dat", test_files.temp_dir);
+    TEST_ASSERT_EQUAL_INT(0, generate_test_file(path, TEST_CHUNK_SIZE * 2, TEST_PATTERN_INCREMENTAL));
+
+    netchunk_chunker_context_t context;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_chunker_init(&context, path, TEST_CHUNK_SIZE));
+
+    netchunk_chunk_t chunk;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_chunker_next_chunk(&context, &chunk));
+    netchunk_chunk_cleanup(&chunk);
+
+    TEST_ASSERT_EQUAL(NETCHUNK_ERROR_INVALID_ARGUMENT, netchunk_chunker_set_mode(&context, NETCHUNK_CHUNKING_CDC));
+    TEST_ASSERT_EQUAL(NETCHUNK_ERROR_INVALID_ARGUMENT, netchunk_chunker_set_mode(NULL, NETCHUNK_CHUNKING_CDC));
+
+    netchunk_chunker_cleanup(&context);
+}
+
+// Test reading chunks into one reused caller-owned buffer
+void test_chunker_next_chunk_into(void) {
+    char path[TEST_MAX_PATH_LEN];
+    snprintf(path, sizeof(path), "%s/into.dat", test_files.temp_dir);
+
+    size_t file_size = TEST_CHUNK_SIZE * 8 + 123;
+    uint8_t* data = make_random_data(file_size, 3);
+    write_data_file(path, data, file_size);
+
+    // Both modes must produce the same chunks as netchunk_chunker_next_chunk()
+    netchunk_chunking_mode_t modes[] = { NETCHUNK_CHUNKING_FIXED, NETCHUNK_CHUNKING_CDC };
+    for (int m = 0; m < 2; m++) {
+        memset(&layout_a, 0, sizeof(layout_a));
+        chunk_file(path, modes[m], &layout_a);
+
+        netchunk_chunker_context_t context;
+        TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_chunker_init(&context, path, TEST_CHUNK_SIZE));
+        TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_chunker_set_mode(&context, modes[m]));
+
+        size_t buffer_size = netchunk_chunker_buffer_size(&context);
+        uint8_t* buffer = malloc(buffer_size);
+        TEST_ASSERT_NOT_NULL(buffer);
+
+        netchunk_chunk_t chunk;
+        TEST_ASSERT_EQUAL(NETCHUNK_ERROR_INVALID_ARGUMENT,
+            netchunk_chunker_next_chunk_into(&context, &chunk, buffer, buffer_size - 1));
+
+        uint32_t count = 0;
+        while (netchunk_chunker_next_chunk_into(&context, &chunk, buffer, buffer_size) == NETCHUNK_SUCCESS) {
+            TEST_ASSERT_TRUE(count < layout_a.count);
+            TEST_ASSERT_TRUE(chunk.data == buffer);
+            TEST_ASSERT_FALSE(chunk.data_owned);
+            TEST_ASSERT_EQUAL_size_t(layout_a.offsets[count], chunk.offset);
+            TEST_ASSERT_EQUAL_size_t(layout_a.sizes[count], chunk.size);
+            TEST_ASSERT_EQUAL_MEMORY(layout_a.hashes[count], chunk.hash, NETCHUNK_HASH_LENGTH);
+            TEST_ASSERT_EQUAL_MEMORY(data + chunk.offset, buffer, chunk.size);
+
+            // Cleanup must leave the borrowed buffer alone
+            netchunk_chunk_cleanup(&chunk);
+            count++;
+        }
+        TEST_ASSERT_EQUAL_UINT32(layout_a.count, count);
+
+        free(buffer);
+        netchunk_chunker_cleanup(&context);
+    }
+
+    free(data);
+}
+
+// Unity test runner
+int main(void) {
+    UNITY_BEGIN();
+
+    // Fixed-size chunking tests
+    RUN_TEST(test_chunker_fixed_offsets);
+
+    // Content-defined chunking tests
+    RUN_TEST(test_chunker_cdc_bounds);
+    RUN_TEST(test_chunker_cdc_resyncs_after_insert);
+    RUN_TEST(test_chunker_set_mode_after_read);
+
+    // Buffer reuse tests
+    RUN_TEST(test_chunker_next_chunk_into);
+
+    return UNITY_END();
+}
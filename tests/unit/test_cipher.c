@@ -0,0 +1,237 @@
+#include "unity.h"
+#include "test_utils.h"
+#include "cipher.h"
+#include "compress.h"
+#include "crypto.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define TEST_CHUNK_SIZE (256 * 1024)
+#define TEST_CHUNK_ID "0123456789abcdef"
+
+// Test data and fixtures
+static uint8_t key[NETCHUNK_CIPHER_KEY_LENGTH];
+static uint8_t key_id[NETCHUNK_KEY_ID_LENGTH];
+static uint8_t* raw;
+static uint8_t* stored;
+
+void setUp(void) {
+    test_setup_environment();
+
+    for (int i = 0; i < NETCHUNK_CIPHER_KEY_LENGTH; i++) {
+        key[i] = (uint8_t)(i * 7 + 1);
+    }
+    netchunk_keyring_clear();
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_keyring_add(key, key_id));
+
+    raw = malloc(TEST_CHUNK_SIZE);
+    stored = malloc(TEST_CHUNK_SIZE + NETCHUNK_CIPHER_OVERHEAD);
+    TEST_ASSERT_NOT_NULL(raw);
+    TEST_ASSERT_NOT_NULL(stored);
+
+    test_seed_random(7);
+    for (size_t i = 0; i < TEST_CHUNK_SIZE; i++) {
+        raw[i] = (uint8_t)test_random_uint32();
+    }
+}
+
+void tearDown(void) {
+    free(raw);
+    free(stored);
+    raw = NULL;
+    stored = NULL;
+    netchunk_keyring_clear();
+
+    test_cleanup_environment();
+}
+
+// Test that a chunk decrypts to the same bytes and is never stored in the clear
+void test_cipher_round_trip(void) {
+    TEST_ASSERT_TRUE(netchunk_key_id_is_set(key_id));
+    TEST_ASSERT_TRUE(netchunk_keyring_has(key_id));
+
+    memcpy(stored, raw, TEST_CHUNK_SIZE);
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_cipher_encrypt(key_id, TEST_CHUNK_ID, stored, TEST_CHUNK_SIZE));
+    TEST_ASSERT_TRUE(memcmp(raw, stored, TEST_CHUNK_SIZE) != 0);
+
+    // Decrypts in place
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_cipher_decrypt(key_id, TEST_CHUNK_ID, stored,
+        TEST_CHUNK_SIZE + NETCHUNK_CIPHER_OVERHEAD, stored));
+    TEST_ASSERT_EQUAL_MEMORY(raw, stored, TEST_CHUNK_SIZE);
+
+    // Every encryption uses a fresh nonce
+    uint8_t* again = malloc(TEST_CHUNK_SIZE + NETCHUNK_CIPHER_OVERHEAD);
+    TEST_ASSERT_NOT_NULL(again);
+    memcpy(stored, raw, TEST_CHUNK_SIZE);
+    memcpy(again, raw, TEST_CHUNK_SIZE);
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_cipher_encrypt(key_id, TEST_CHUNK_ID, stored, TEST_CHUNK_SIZE));
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_cipher_encrypt(key_id, TEST_CHUNK_ID, again, TEST_CHUNK_SIZE));
+    TEST_ASSERT_TRUE(memcmp(stored + TEST_CHUNK_SIZE, again + TEST_CHUNK_SIZE, NETCHUNK_CIPHER_NONCE_LENGTH) != 0);
+    free(again);
+}
+
+// Test that tampered data, a different chunk ID or an unknown key are refused
+void test_cipher_rejects_tampering(void) {
+    size_t stored_size = TEST_CHUNK_SIZE + NETCHUNK_CIPHER_OVERHEAD;
+    memcpy(stored, raw, TEST_CHUNK_SIZE);
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_cipher_encrypt(key_id, TEST_CHUNK_ID, stored, TEST_CHUNK_SIZE));
+
+    uint8_t* out = malloc(TEST_CHUNK_SIZE);
+    TEST_ASSERT_NOT_NULL(out);
+
+    TEST_ASSERT_EQUAL(NETCHUNK_ERROR_CHUNK_INTEGRITY, netchunk_cipher_decrypt(key_id, "fedcba9876543210",
+        stored, stored_size, out));
+    TEST_ASSERT_EQUAL(NETCHUNK_ERROR_CHUNK_INTEGRITY, netchunk_cipher_decrypt(key_id, TEST_CHUNK_ID,
+        stored, NETCHUNK_CIPHER_OVERHEAD - 1, out));
+
+    stored[TEST_CHUNK_SIZE / 2] ^= 0x01;
+    TEST_ASSERT_EQUAL(NETCHUNK_ERROR_CHUNK_INTEGRITY, netchunk_cipher_decrypt(key_id, TEST_CHUNK_ID,
+        stored, stored_size, out));
+    stored[TEST_CHUNK_SIZE / 2] ^= 0x01;
+
+    stored[stored_size - 1] ^= 0x01;
+    TEST_ASSERT_EQUAL(NETCHUNK_ERROR_CHUNK_INTEGRITY, netchunk_cipher_decrypt(key_id, TEST_CHUNK_ID,
+        stored, stored_size, out));
+    stored[stored_size - 1] ^= 0x01;
+
+    netchunk_keyring_clear();
+    TEST_ASSERT_FALSE(netchunk_keyring_has(key_id));
+    TEST_ASSERT_EQUAL(NETCHUNK_ERROR_CRYPTO, netchunk_cipher_decrypt(key_id, TEST_CHUNK_ID,
+        stored, stored_size, out));
+
+    free(out);
+}
+
+// Test that an encrypted chunk verifies and is rebuilt from raw bytes
+void test_chunk_encrypted_stored_form(void) {
+    netchunk_chunk_t chunk;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_chunk_init(&chunk, 0, TEST_CHUNK_SIZE));
+    strcpy(chunk.id, TEST_CHUNK_ID);
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_sha256_hash(raw, TEST_CHUNK_SIZE, chunk.hash));
+    TEST_ASSERT_FALSE(netchunk_chunk_is_encoded(&chunk));
+
+    memcpy(chunk.key_id, key_id, NETCHUNK_KEY_ID_LENGTH);
+    chunk.stored_size = TEST_CHUNK_SIZE + NETCHUNK_CIPHER_OVERHEAD;
+    TEST_ASSERT_TRUE(netchunk_chunk_is_encoded(&chunk));
+    TEST_ASSERT_EQUAL_size_t(chunk.stored_size, netchunk_chunk_stored_size(&chunk));
+
+    uint8_t* copy = malloc(TEST_CHUNK_SIZE);
+    TEST_ASSERT_NOT_NULL(copy);
+    memcpy(copy, raw, TEST_CHUNK_SIZE);
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_chunk_restore_stored(&chunk, NETCHUNK_DEFAULT_COMPRESSION_LEVEL, copy));
+    TEST_ASSERT_TRUE(chunk.data_owned);
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_chunk_verify_integrity(&chunk));
+
+    uint8_t* decoded = malloc(TEST_CHUNK_SIZE);
+    TEST_ASSERT_NOT_NULL(decoded);
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_chunk_decode(&chunk, decoded));
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_chunk_verify_raw(&chunk, decoded));
+    TEST_ASSERT_EQUAL_MEMORY(raw, decoded, TEST_CHUNK_SIZE);
+
+    chunk.data[0] ^= 0xff;
+    TEST_ASSERT_EQUAL(NETCHUNK_ERROR_CHUNK_INTEGRITY, netchunk_chunk_verify_integrity(&chunk));
+
+    free(decoded);
+    netchunk_chunk_cleanup(&chunk);
+}
+
+// Test that a chunk is compressed before it is encrypted
+void test_chunk_compressed_and_encrypted(void) {
+    if (!netchunk_compress_available(NETCHUNK_COMPRESSION_ZSTD)) {
+        TEST_IGNORE_MESSAGE("Built without zstd");
+    }
+
+    memset(raw, 'a', TEST_CHUNK_SIZE);
+    netchunk_chunk_t chunk;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_chunk_init(&chunk, 0, TEST_CHUNK_SIZE));
+    strcpy(chunk.id, TEST_CHUNK_ID);
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_sha256_hash(raw, TEST_CHUNK_SIZE, chunk.hash));
+
+    size_t capacity = netchunk_compress_bound(NETCHUNK_COMPRESSION_ZSTD, TEST_CHUNK_SIZE) + NETCHUNK_CIPHER_OVERHEAD;
+    uint8_t* buffer = malloc(capacity);
+    TEST_ASSERT_NOT_NULL(buffer);
+    size_t compressed_size = 0;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_compress(NETCHUNK_COMPRESSION_ZSTD, NETCHUNK_DEFAULT_COMPRESSION_LEVEL,
+        raw, TEST_CHUNK_SIZE, buffer, capacity, &compressed_size));
+    TEST_ASSERT_TRUE(compressed_size > 0);
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_cipher_encrypt(key_id, TEST_CHUNK_ID, buffer, compressed_size));
+
+    chunk.codec = NETCHUNK_COMPRESSION_ZSTD;
+    memcpy(chunk.key_id, key_id, NETCHUNK_KEY_ID_LENGTH);
+    chunk.stored_size = compressed_size + NETCHUNK_CIPHER_OVERHEAD;
+    chunk.data = buffer;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_chunk_verify_integrity(&chunk));
+
+    // Rebuilt from raw bytes at the same stored size
+    uint8_t* copy = malloc(TEST_CHUNK_SIZE);
+    TEST_ASSERT_NOT_NULL(copy);
+    memcpy(copy, raw, TEST_CHUNK_SIZE);
+    chunk.data = NULL;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_chunk_restore_stored(&chunk, NETCHUNK_DEFAULT_COMPRESSION_LEVEL, copy));
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_chunk_verify_integrity(&chunk));
+
+    free(buffer);
+    netchunk_chunk_cleanup(&chunk);
+}
+
+// Test loading keys from a key file
+void test_keyring_load_file(void) {
+    char path[256];
+    snprintf(path, sizeof(path), "%s", test_create_temp_filename("netchunk_key", ".key"));
+
+    FILE* file = fopen(path, "w");
+    TEST_ASSERT_NOT_NULL(file);
+    fprintf(file, "# Current key first\n\n");
+    for (int i = 0; i < NETCHUNK_CIPHER_KEY_LENGTH; i++) {
+        fprintf(file, "%02x", 0xa0 + i);
+    }
+    fprintf(file, "\n");
+    for (int i = 0; i < NETCHUNK_CIPHER_KEY_LENGTH; i++) {
+        fprintf(file, "%02X", key[i]);
+    }
+    fprintf(file, "  \n");
+    fclose(file);
+
+    // Readable by others: refused
+    uint8_t current[NETCHUNK_KEY_ID_LENGTH];
+    chmod(path, 0644);
+    TEST_ASSERT_EQUAL(NETCHUNK_ERROR_CONFIG_VALIDATION, netchunk_keyring_load_file(path, current));
+
+    chmod(path, 0600);
+    netchunk_keyring_clear();
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_keyring_load_file(path, current));
+    TEST_ASSERT_TRUE(netchunk_keyring_has(current));
+    TEST_ASSERT_TRUE(netchunk_keyring_has(key_id));
+    TEST_ASSERT_TRUE(memcmp(current, key_id, NETCHUNK_KEY_ID_LENGTH) != 0);
+
+    // Malformed keys are refused
+    file = fopen(path, "w");
+    TEST_ASSERT_NOT_NULL(file);
+    fprintf(file, "not-a-key\n");
+    fclose(file);
+    TEST_ASSERT_EQUAL(NETCHUNK_ERROR_CONFIG_VALIDATION, netchunk_keyring_load_file(path, current));
+
+    unlink(path);
+    TEST_ASSERT_EQUAL(NETCHUNK_ERROR_FILE_NOT_FOUND, netchunk_keyring_load_file(path, current));
+}
+
+// Unity test runner
+int main(void) {
+    UNITY_BEGIN();
+
+    // Cipher tests
+    RUN_TEST(test_cipher_round_trip);
+    RUN_TEST(test_cipher_rejects_tampering);
+
+    // Chunk tests
+    RUN_TEST(test_chunk_encrypted_stored_form);
+    RUN_TEST(test_chunk_compressed_and_encrypted);
+
+    // Key ring tests
+    RUN_TEST(test_keyring_load_file);
+
+    return UNITY_END();
+}
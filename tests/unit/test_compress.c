@@ -0,0 +1,177 @@
+#include "unity.h"
+#include "test_utils.h"
+#include "compress.h"
+#include "crypto.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TEST_CHUNK_SIZE (1024 * 1024) // Large enough to be sampled
+
+// Test data and fixtures
+static uint8_t* raw;
+static uint8_t* stored;
+static uint8_t* decoded;
+static size_t capacity;
+
+void setUp(void) {
+    test_setup_environment();
+
+    if (!netchunk_compress_available(NETCHUNK_COMPRESSION_ZSTD)) {
+        TEST_IGNORE_MESSAGE("Built without zstd");
+    }
+
+    capacity = netchunk_compress_bound(NETCHUNK_COMPRESSION_ZSTD, TEST_CHUNK_SIZE);
+    raw = malloc(TEST_CHUNK_SIZE);
+    stored = malloc(capacity);
+    decoded = malloc(TEST_CHUNK_SIZE);
+    TEST_ASSERT_NOT_NULL(raw);
+    TEST_ASSERT_NOT_NULL(stored);
+    TEST_ASSERT_NOT_NULL(decoded);
+}
+
+void tearDown(void) {
+    free(raw);
+    free(stored);
+    free(decoded);
+    raw = NULL;
+    stored = NULL;
+    decoded = NULL;
+
+    test_cleanup_environment();
+}
+
+// Helpers
+
+static void fill_text(uint8_t* data, size_t size) {
+    static const char line[] = "2026-10-15 12:00:00 INFO chunk uploaded to server_1\n";
+    for (size_t i = 0; i < size; i++) {
+        data[i] = (uint8_t)line[i % (sizeof(line) - 1)];
+    }
+}
+
+static void fill_random(uint8_t* data, size_t size, uint32_t seed) {
+    test_seed_random(seed);
+    for (size_t i = 0; i < size; i++) {
+        data[i] = (uint8_t)test_random_uint32();
+    }
+}
+
+// Test that compressible data shrinks and decodes to the same bytes
+void test_compress_round_trip(void) {
+    fill_text(raw, TEST_CHUNK_SIZE);
+
+    size_t stored_size = 0;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_compress(NETCHUNK_COMPRESSION_ZSTD, NETCHUNK_DEFAULT_COMPRESSION_LEVEL,
+        raw, TEST_CHUNK_SIZE, stored, capacity, &stored_size));
+    TEST_ASSERT_TRUE(stored_size > 0);
+    TEST_ASSERT_TRUE(stored_size < TEST_CHUNK_SIZE / 10);
+
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_decompress(NETCHUNK_COMPRESSION_ZSTD,
+        stored, stored_size, decoded, TEST_CHUNK_SIZE));
+    TEST_ASSERT_EQUAL_MEMORY(raw, decoded, TEST_CHUNK_SIZE);
+}
+
+// Test that incompressible data is left to be stored raw
+void test_compress_skips_incompressible(void) {
+    fill_random(raw, TEST_CHUNK_SIZE, 42);
+
+    size_t stored_size = 1;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_compress(NETCHUNK_COMPRESSION_ZSTD, NETCHUNK_DEFAULT_COMPRESSION_LEVEL,
+        raw, TEST_CHUNK_SIZE, stored, capacity, &stored_size));
+    TEST_ASSERT_EQUAL_size_t(0, stored_size);
+
+    // Too small to sample, judged by the full pass instead
+    stored_size = 1;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_compress(NETCHUNK_COMPRESSION_ZSTD, NETCHUNK_DEFAULT_COMPRESSION_LEVEL,
+        raw, 4096, stored, capacity, &stored_size));
+    TEST_ASSERT_EQUAL_size_t(0, stored_size);
+}
+
+// Test that damaged or mis-sized data is reported as an integrity failure
+void test_decompress_rejects_bad_data(void) {
+    fill_text(raw, TEST_CHUNK_SIZE);
+
+    size_t stored_size = 0;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_compress(NETCHUNK_COMPRESSION_ZSTD, NETCHUNK_DEFAULT_COMPRESSION_LEVEL,
+        raw, TEST_CHUNK_SIZE, stored, capacity, &stored_size));
+    TEST_ASSERT_TRUE(stored_size > 0);
+
+    TEST_ASSERT_EQUAL(NETCHUNK_ERROR_CHUNK_INTEGRITY, netchunk_decompress(NETCHUNK_COMPRESSION_ZSTD,
+        stored, stored_size, decoded, TEST_CHUNK_SIZE - 1));
+    TEST_ASSERT_EQUAL(NETCHUNK_ERROR_CHUNK_INTEGRITY, netchunk_decompress(NETCHUNK_COMPRESSION_ZSTD,
+        stored, stored_size / 2, decoded, TEST_CHUNK_SIZE));
+
+    memset(stored, 0xa5, 16);
+    TEST_ASSERT_EQUAL(NETCHUNK_ERROR_CHUNK_INTEGRITY, netchunk_decompress(NETCHUNK_COMPRESSION_ZSTD,
+        stored, stored_size, decoded, TEST_CHUNK_SIZE));
+}
+
+// Test that a compressed chunk verifies against the hash of its raw bytes
+void test_chunk_verify_compressed(void) {
+    fill_text(raw, TEST_CHUNK_SIZE);
+
+    netchunk_chunk_t chunk;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_chunk_init(&chunk, 0, TEST_CHUNK_SIZE));
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_sha256_hash(raw, TEST_CHUNK_SIZE, chunk.hash));
+    TEST_ASSERT_EQUAL_size_t(TEST_CHUNK_SIZE, netchunk_chunk_stored_size(&chunk));
+
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_compress(NETCHUNK_COMPRESSION_ZSTD, NETCHUNK_DEFAULT_COMPRESSION_LEVEL,
+        raw, TEST_CHUNK_SIZE, stored, capacity, &chunk.stored_size));
+    chunk.codec = NETCHUNK_COMPRESSION_ZSTD;
+    chunk.data = stored;
+    TEST_ASSERT_EQUAL_size_t(chunk.stored_size, netchunk_chunk_stored_size(&chunk));
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_chunk_verify_integrity(&chunk));
+
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_chunk_decode(&chunk, decoded));
+    TEST_ASSERT_EQUAL_MEMORY(raw, decoded, TEST_CHUNK_SIZE);
+
+    stored[chunk.stored_size / 2] ^= 0xff;
+    TEST_ASSERT_NOT_EQUAL(NETCHUNK_SUCCESS, netchunk_chunk_verify_integrity(&chunk));
+}
+
+// Test that a raw copy is turned back into the recorded stored form
+void test_chunk_restore_stored(void) {
+    fill_text(raw, TEST_CHUNK_SIZE);
+
+    netchunk_chunk_t chunk;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_chunk_init(&chunk, 0, TEST_CHUNK_SIZE));
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_sha256_hash(raw, TEST_CHUNK_SIZE, chunk.hash));
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_compress(NETCHUNK_COMPRESSION_ZSTD, NETCHUNK_DEFAULT_COMPRESSION_LEVEL,
+        raw, TEST_CHUNK_SIZE, stored, capacity, &chunk.stored_size));
+    chunk.codec = NETCHUNK_COMPRESSION_ZSTD;
+
+    uint8_t* copy = malloc(TEST_CHUNK_SIZE);
+    TEST_ASSERT_NOT_NULL(copy);
+    memcpy(copy, raw, TEST_CHUNK_SIZE);
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_chunk_restore_stored(&chunk, NETCHUNK_DEFAULT_COMPRESSION_LEVEL, copy));
+    TEST_ASSERT_TRUE(chunk.data_owned);
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_chunk_verify_integrity(&chunk));
+    netchunk_chunk_cleanup(&chunk);
+
+    // A stored size the copy cannot reproduce is refused
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_chunk_init(&chunk, 0, TEST_CHUNK_SIZE));
+    chunk.codec = NETCHUNK_COMPRESSION_ZSTD;
+    chunk.stored_size = 1;
+    copy = malloc(TEST_CHUNK_SIZE);
+    TEST_ASSERT_NOT_NULL(copy);
+    memcpy(copy, raw, TEST_CHUNK_SIZE);
+    TEST_ASSERT_EQUAL(NETCHUNK_ERROR_CHUNK_INTEGRITY, netchunk_chunk_restore_stored(&chunk, NETCHUNK_DEFAULT_COMPRESSION_LEVEL, copy));
+    TEST_ASSERT_NULL(chunk.data);
+}
+
+// Unity test runner
+int main(void) {
+    UNITY_BEGIN();
+
+    // Codec tests
+    RUN_TEST(test_compress_round_trip);
+    RUN_TEST(test_compress_skips_incompressible);
+    RUN_TEST(test_decompress_rejects_bad_data);
+
+    // Chunk tests
+    RUN_TEST(test_chunk_verify_compressed);
+    RUN_TEST(test_chunk_restore_stored);
+
+    return UNITY_END();
+}
@@ -38,10 +38,20 @@ void test_config_init_defaults(void) {
     
     TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, result);
     TEST_ASSERT_EQUAL_size_t(NETCHUNK_DEFAULT_CHUNK_SIZE, test_config.chunk_size);
+    TEST_ASSERT_EQUAL(NETCHUNK_CHUNKING_FIXED, test_config.chunking_mode);
+    TEST_ASSERT_EQUAL(NETCHUNK_COMPRESSION_NONE, test_config.compression);
+    TEST_ASSERT_EQUAL_INT(NETCHUNK_DEFAULT_COMPRESSION_LEVEL, test_config.compression_level);
+    TEST_ASSERT_FALSE(test_config.content_addressed);
+    TEST_ASSERT_EQUAL_STRING("~/.netchunk/data/dedup-index.json", test_config.dedup_index_path);
     TEST_ASSERT_EQUAL_INT(NETCHUNK_DEFAULT_REPLICATION_FACTOR, test_config.replication_factor);
+    TEST_ASSERT_EQUAL_INT(0, test_config.erasure_data_shards);
+    TEST_ASSERT_EQUAL_INT(0, test_config.erasure_parity_shards);
     TEST_ASSERT_EQUAL_INT(4, test_config.max_concurrent_operations);
     TEST_ASSERT_EQUAL_INT(30, test_config.ftp_timeout);
+    TEST_ASSERT_EQUAL_INT(60, test_config.connection_idle_timeout);
+    TEST_ASSERT_EQUAL_INT(5, test_config.hedge_budget_percent);
     TEST_ASSERT_EQUAL_STRING("~/.netchunk/data", test_config.local_storage_path);
+    TEST_ASSERT_EQUAL_STRING("~/.netchunk/netchunk.sock", test_config.daemon_socket_path);
     TEST_ASSERT_EQUAL(NETCHUNK_LOG_INFO, test_config.log_level);
     TEST_ASSERT_EQUAL_STRING("~/.netchunk/netchunk.log", test_config.log_file);
     TEST_ASSERT_TRUE(test_config.health_monitoring_enabled);
@@ -51,6 +61,12 @@ void test_config_init_defaults(void) {
     TEST_ASSERT_EQUAL_INT(3, test_config.max_repair_attempts);
     TEST_ASSERT_EQUAL_INT(10, test_config.repair_delay);
     TEST_ASSERT_TRUE(test_config.rebalancing_enabled);
+    TEST_ASSERT_EQUAL_INT(NETCHUNK_DEFAULT_SCRUB_INTERVAL, test_config.scrub_interval);
+    TEST_ASSERT_EQUAL_size_t(NETCHUNK_DEFAULT_SCRUB_BANDWIDTH, test_config.scrub_bandwidth);
+    TEST_ASSERT_TRUE(test_config.scrub_deep);
+    TEST_ASSERT_EQUAL_INT(NETCHUNK_DEFAULT_REPAIR_WORKERS, test_config.repair_workers);
+    TEST_ASSERT_EQUAL_INT(NETCHUNK_DEFAULT_REPAIR_MAX_PER_SERVER, test_config.repair_max_per_server);
+    TEST_ASSERT_EQUAL_size_t(0, test_config.repair_bandwidth);
     TEST_ASSERT_EQUAL_INT(85, test_config.storage_alert_threshold);
     TEST_ASSERT_EQUAL_INT(1000, test_config.latency_alert_threshold);
     TEST_ASSERT_FALSE(test_config.performance_logging);
@@ -58,6 +74,7 @@ void test_config_init_defaults(void) {
     TEST_ASSERT_TRUE(test_config.verify_ssl_certificates);
     TEST_ASSERT_TRUE(test_config.always_verify_integrity);
     TEST_ASSERT_FALSE(test_config.encrypt_chunks);
+    TEST_ASSERT_EQUAL_STRING("~/.netchunk/encryption.key", test_config.encryption_key_file);
 }
 
 void test_config_init_defaults_null_pointer(void) {
@@ -167,6 +184,90 @@ void test_config_validate_insufficient_servers(void) {
     TEST_ASSERT_EQUAL(NETCHUNK_ERROR_INSUFFICIENT_SERVERS, result);
 }
 
+void test_config_validate_erasure_layout(void) {
+    netchunk_config_init_defaults(&test_config);
+    test_config.replication_factor = 1;
+    test_config.server_count = 4;
+    for (int i = 0; i < 4; i++) {
+        snprintf(test_config.servers[i].host, sizeof(test_config.servers[i].host), "ftp%d.example.com", i+1);
+        test_config.servers[i].port = 21;
+        strcpy(test_config.servers[i].username, "testuser");
+        strcpy(test_config.servers[i].base_path, "/upload");
+    }
+
+    test_config.erasure_data_shards = 3;
+    test_config.erasure_parity_shards = 1;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_config_validate(&test_config));
+
+    // Every shard of a stripe needs its own server
+    test_config.erasure_parity_shards = 2;
+    TEST_ASSERT_EQUAL(NETCHUNK_ERROR_INSUFFICIENT_SERVERS, netchunk_config_validate(&test_config));
+
+    // Both counts are needed
+    test_config.erasure_parity_shards = 0;
+    TEST_ASSERT_EQUAL(NETCHUNK_ERROR_CONFIG_VALIDATION, netchunk_config_validate(&test_config));
+
+    test_config.erasure_parity_shards = 1;
+    test_config.content_addressed = true;
+    TEST_ASSERT_EQUAL(NETCHUNK_ERROR_CONFIG_VALIDATION, netchunk_config_validate(&test_config));
+}
+
+void test_config_validate_compression(void) {
+    netchunk_config_init_defaults(&test_config);
+    test_config.replication_factor = 1;
+    test_config.server_count = 2;
+    for (int i = 0; i < 2; i++) {
+        snprintf(test_config.servers[i].host, sizeof(test_config.servers[i].host), "ftp%d.example.com", i+1);
+        test_config.servers[i].port = 21;
+        strcpy(test_config.servers[i].username, "testuser");
+        strcpy(test_config.servers[i].base_path, "/upload");
+    }
+
+    test_config.compression = netchunk_compression_from_string("zstd");
+    TEST_ASSERT_EQUAL(NETCHUNK_COMPRESSION_ZSTD, test_config.compression);
+    TEST_ASSERT_EQUAL_STRING("zstd", netchunk_compression_to_string(test_config.compression));
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_config_validate(&test_config));
+
+    test_config.compression_level = NETCHUNK_MAX_COMPRESSION_LEVEL + 1;
+    TEST_ASSERT_EQUAL(NETCHUNK_ERROR_CONFIG_VALIDATION, netchunk_config_validate(&test_config));
+
+    // Shared and striped chunks have no single stored form
+    test_config.compression_level = NETCHUNK_DEFAULT_COMPRESSION_LEVEL;
+    test_config.content_addressed = true;
+    TEST_ASSERT_EQUAL(NETCHUNK_ERROR_CONFIG_VALIDATION, netchunk_config_validate(&test_config));
+
+    test_config.content_addressed = false;
+    test_config.erasure_data_shards = 1;
+    test_config.erasure_parity_shards = 1;
+    TEST_ASSERT_EQUAL(NETCHUNK_ERROR_CONFIG_VALIDATION, netchunk_config_validate(&test_config));
+}
+
+void test_config_validate_encryption(void) {
+    netchunk_config_init_defaults(&test_config);
+    test_config.replication_factor = 1;
+    test_config.server_count = 2;
+    for (int i = 0; i < 2; i++) {
+        snprintf(test_config.servers[i].host, sizeof(test_config.servers[i].host), "ftp%d.example.com", i+1);
+        test_config.servers[i].port = 21;
+        strcpy(test_config.servers[i].username, "testuser");
+        strcpy(test_config.servers[i].base_path, "/upload");
+    }
+
+    test_config.encrypt_chunks = true;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_config_validate(&test_config));
+
+    // Stripes are encrypted shard by shard
+    test_config.erasure_data_shards = 1;
+    test_config.erasure_parity_shards = 1;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_config_validate(&test_config));
+
+    // Deduplicated chunks are shared across files
+    test_config.erasure_data_shards = 0;
+    test_config.erasure_parity_shards = 0;
+    test_config.content_addressed = true;
+    TEST_ASSERT_EQUAL(NETCHUNK_ERROR_CONFIG_VALIDATION, netchunk_config_validate(&test_config));
+}
+
 void test_config_validate_invalid_server_config(void) {
     netchunk_config_init_defaults(&test_config);
     test_config.server_count = 1;
@@ -202,6 +303,16 @@ void test_config_validate_invalid_server_config(void) {
     test_config.servers[0].base_path[0] = '\0';
     result = netchunk_config_validate(&test_config);
     TEST_ASSERT_EQUAL(NETCHUNK_ERROR_CONFIG_VALIDATION, result);
+    
+    // Test out of range connection count
+    strcpy(test_config.servers[0].base_path, "/upload");
+    test_config.servers[0].max_connections = 33;
+    result = netchunk_config_validate(&test_config);
+    TEST_ASSERT_EQUAL(NETCHUNK_ERROR_CONFIG_VALIDATION, result);
+    
+    test_config.servers[0].max_connections = 8;
+    result = netchunk_config_validate(&test_config);
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, result);
 }
 
 // Test error string function
@@ -303,6 +414,8 @@ void test_config_load_valid_file(void) {
     
     fprintf(fp, "[general]\n");
     fprintf(fp, "chunk_size=8MB\n");
+    fprintf(fp, "chunking=cdc\n");
+    fprintf(fp, "content_addressed=true\n");
     fprintf(fp, "replication_factor=2\n");
     fprintf(fp, "log_level=DEBUG\n");
     fprintf(fp, "\n");
@@ -322,6 +435,8 @@ void test_config_load_valid_file(void) {
     fprintf(fp, "password=pass2\n");
     fprintf(fp, "base_path=/data\n");
     fprintf(fp, "priority=5\n");
+    fprintf(fp, "max_connections=8\n");
+    fprintf(fp, "fxp=true\n");
     
     fclose(fp);
     
@@ -331,6 +446,8 @@ void test_config_load_valid_file(void) {
     
     // Verify parsed values
     TEST_ASSERT_EQUAL_size_t(8 * 1024 * 1024, test_config.chunk_size);
+    TEST_ASSERT_EQUAL(NETCHUNK_CHUNKING_CDC, test_config.chunking_mode);
+    TEST_ASSERT_TRUE(test_config.content_addressed);
     TEST_ASSERT_EQUAL_INT(2, test_config.replication_factor);
     TEST_ASSERT_EQUAL(NETCHUNK_LOG_DEBUG, test_config.log_level);
     TEST_ASSERT_EQUAL_INT(2, test_config.server_count);
@@ -343,6 +460,7 @@ void test_config_load_valid_file(void) {
     TEST_ASSERT_EQUAL_STRING("/upload", test_config.servers[0].base_path);
     TEST_ASSERT_TRUE(test_config.servers[0].use_ssl);
     TEST_ASSERT_FALSE(test_config.servers[0].passive_mode);
+    TEST_ASSERT_FALSE(test_config.servers[0].fxp);
     
     // Verify server 2
     TEST_ASSERT_EQUAL_STRING("ftp2.example.com", test_config.servers[1].host);
@@ -351,6 +469,9 @@ void test_config_load_valid_file(void) {
     TEST_ASSERT_EQUAL_STRING("pass2", test_config.servers[1].password);
     TEST_ASSERT_EQUAL_STRING("/data", test_config.servers[1].base_path);
     TEST_ASSERT_EQUAL_INT(5, test_config.servers[1].priority);
+    TEST_ASSERT_EQUAL_INT(8, test_config.servers[1].max_connections);
+    TEST_ASSERT_EQUAL_INT(0, test_config.servers[0].max_connections);
+    TEST_ASSERT_TRUE(test_config.servers[1].fxp);
 }
 
 // Test config file finding
@@ -396,6 +517,9 @@ int main(void) {
     RUN_TEST(test_config_validate_invalid_replication_factor);
     RUN_TEST(test_config_validate_no_servers);
     RUN_TEST(test_config_validate_insufficient_servers);
+    RUN_TEST(test_config_validate_erasure_layout);
+    RUN_TEST(test_config_validate_compression);
+    RUN_TEST(test_config_validate_encryption);
     RUN_TEST(test_config_validate_invalid_server_config);
     
     // Error string tests
@@ -23,6 +23,9 @@ void setUp(void) {
 void tearDown(void) {
     // Remove temporary test files
     cleanup_temp_test_directory(&test_files);
+
+    // Undo any backend forced by a test
+    netchunk_sha256_set_backend(NETCHUNK_SHA256_BACKEND_AUTO);
     
     // Cleanup test environment
     test_cleanup_environment();
@@ -480,6 +483,122 @@ void test_sha256_edge_cases(void) {
     TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, result);
 }
 
+// Test every SHA-256 backend the CPU supports against the known vectors
+void test_sha256_backends_known_answers(void) {
+    const char* messages[] = {
+        "",
+        "abc",
+        "The quick brown fox jumps over the lazy dog",
+        "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq"
+    };
+    const char* expected_hex[] = {
+        "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855",
+        "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad",
+        "d7a8fbb307d7809469ca9abcb0082e4f8d5651e46d3cdb762d02d0bf37c9e592",
+        "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1"
+    };
+    const size_t vector_count = sizeof(messages) / sizeof(messages[0]);
+
+    for (int backend = 0; backend < NETCHUNK_SHA256_BACKEND_COUNT; backend++) {
+        if (!netchunk_sha256_backend_available((netchunk_sha256_backend_t)backend)) {
+            continue;
+        }
+        TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_sha256_set_backend((netchunk_sha256_backend_t)backend));
+
+        const uint8_t* data[4];
+        size_t lengths[4];
+        uint8_t batch_hashes[4][NETCHUNK_SHA256_DIGEST_LENGTH];
+        uint8_t* outputs[4];
+
+        for (size_t i = 0; i < vector_count; i++) {
+            uint8_t expected[NETCHUNK_SHA256_DIGEST_LENGTH];
+            uint8_t hash[NETCHUNK_SHA256_DIGEST_LENGTH];
+            TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_hex_string_to_hash(expected_hex[i], expected, sizeof(expected)));
+
+            data[i] = (const uint8_t*)messages[i];
+            lengths[i] = strlen(messages[i]);
+            outputs[i] = batch_hashes[i];
+
+            TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_sha256_hash(data[i], lengths[i], hash));
+            TEST_ASSERT_EQUAL_MEMORY_MESSAGE(expected, hash, NETCHUNK_SHA256_DIGEST_LENGTH,
+                netchunk_sha256_backend_name((netchunk_sha256_backend_t)backend));
+        }
+
+        TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_sha256_hash_batch(data, lengths, vector_count, outputs));
+        for (size_t i = 0; i < vector_count; i++) {
+            uint8_t expected[NETCHUNK_SHA256_DIGEST_LENGTH];
+            netchunk_hex_string_to_hash(expected_hex[i], expected, sizeof(expected));
+            TEST_ASSERT_EQUAL_MEMORY_MESSAGE(expected, batch_hashes[i], NETCHUNK_SHA256_DIGEST_LENGTH,
+                netchunk_sha256_backend_name((netchunk_sha256_backend_t)backend));
+        }
+    }
+}
+
+// Hardware backends must agree with the generic code on long and odd-sized input
+void test_sha256_backends_match_generic(void) {
+    size_t data_size = 256 * 1024 + 37;
+    uint8_t* large_data = malloc(data_size);
+    TEST_ASSERT_NOT_NULL(large_data);
+    for (size_t i = 0; i < data_size; i++) {
+        large_data[i] = (uint8_t)((i * 131) & 0xFF);
+    }
+
+    // More messages than lanes, with lengths around the padding boundaries
+    const size_t lengths[] = { 0, 1, 55, 56, 63, 64, 65, 119, 120, 4096, data_size, 1000 };
+    const size_t count = sizeof(lengths) / sizeof(lengths[0]);
+    const uint8_t* data[12];
+    uint8_t reference[12][NETCHUNK_SHA256_DIGEST_LENGTH];
+    uint8_t batch_hashes[12][NETCHUNK_SHA256_DIGEST_LENGTH];
+    uint8_t* outputs[12];
+
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_sha256_set_backend(NETCHUNK_SHA256_BACKEND_GENERIC));
+    for (size_t i = 0; i < count; i++) {
+        data[i] = large_data + (i % 3);
+        if (lengths[i] == data_size) {
+            data[i] = large_data;
+        }
+        outputs[i] = batch_hashes[i];
+        TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_sha256_hash(data[i], lengths[i], reference[i]));
+    }
+
+    for (int backend = 0; backend < NETCHUNK_SHA256_BACKEND_COUNT; backend++) {
+        if (!netchunk_sha256_backend_available((netchunk_sha256_backend_t)backend)) {
+            continue;
+        }
+        TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_sha256_set_backend((netchunk_sha256_backend_t)backend));
+
+        // Streaming in uneven pieces crosses block boundaries mid-update
+        netchunk_sha256_context_t context;
+        uint8_t hash[NETCHUNK_SHA256_DIGEST_LENGTH];
+        TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_sha256_init(&context));
+        for (size_t offset = 0; offset < data_size; offset += 1000) {
+            size_t piece = (offset + 1000 > data_size) ? (data_size - offset) : 1000;
+            TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_sha256_update(&context, large_data + offset, piece));
+        }
+        TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_sha256_final(&context, hash));
+        TEST_ASSERT_EQUAL_MEMORY(reference[10], hash, NETCHUNK_SHA256_DIGEST_LENGTH);
+
+        TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_sha256_hash_batch(data, lengths, count, outputs));
+        for (size_t i = 0; i < count; i++) {
+            TEST_ASSERT_EQUAL_MEMORY_MESSAGE(reference[i], batch_hashes[i], NETCHUNK_SHA256_DIGEST_LENGTH,
+                netchunk_sha256_backend_name((netchunk_sha256_backend_t)backend));
+        }
+    }
+
+    free(large_data);
+}
+
+void test_sha256_set_backend_invalid(void) {
+    TEST_ASSERT_TRUE(netchunk_sha256_backend_available(NETCHUNK_SHA256_BACKEND_GENERIC));
+    TEST_ASSERT_EQUAL(NETCHUNK_ERROR_INVALID_ARGUMENT, netchunk_sha256_set_backend(NETCHUNK_SHA256_BACKEND_COUNT));
+
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_sha256_set_backend(NETCHUNK_SHA256_BACKEND_GENERIC));
+    TEST_ASSERT_EQUAL(NETCHUNK_SHA256_BACKEND_GENERIC, netchunk_sha256_get_backend());
+
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_sha256_set_backend(NETCHUNK_SHA256_BACKEND_AUTO));
+    TEST_ASSERT_TRUE(netchunk_sha256_backend_available(netchunk_sha256_get_backend()));
+}
+
 // Unity test runner
 int main(void) {
     UNITY_BEGIN();
@@ -522,6 +641,11 @@ int main(void) {
     // Performance and edge case tests
     RUN_TEST(test_sha256_large_data_performance);
     RUN_TEST(test_sha256_edge_cases);
+
+    // Backend dispatch tests
+    RUN_TEST(test_sha256_backends_known_answers);
+    RUN_TEST(test_sha256_backends_match_generic);
+    RUN_TEST(test_sha256_set_backend_invalid);
     
     return UNITY_END();
 }
@@ -0,0 +1,169 @@
+#include "unity.h"
+#include "test_utils.h"
+#include "daemon.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// Test data and fixtures
+static test_file_context_t test_files;
+static netchunk_context_t test_context;
+static netchunk_daemon_t test_daemon;
+static pthread_t daemon_thread;
+static bool daemon_running;
+static netchunk_error_t daemon_result;
+static char config_path[TEST_MAX_PATH_LEN];
+static char socket_path[TEST_MAX_PATH_LEN];
+
+static void* daemon_thread_main(void* arg) {
+    (void)arg;
+    daemon_result = netchunk_daemon_run(&test_daemon);
+    return NULL;
+}
+
+void setUp(void) {
+    // Initialize test environment
+    test_setup_environment();
+
+    // Create temporary directory for the config and socket
+    TEST_ASSERT_EQUAL_INT(0, create_temp_test_directory(&test_files));
+    snprintf(config_path, sizeof(config_path), "%s/netchunk.conf", test_files.temp_dir);
+    snprintf(socket_path, sizeof(socket_path), "%s/netchunk.sock", test_files.temp_dir);
+
+    // One server on a port nothing listens on, so it is always unhealthy
+    FILE* file = fopen(config_path, "w");
+    TEST_ASSERT_NOT_NULL(file);
+    fprintf(file, "[general]\n");
+    fprintf(file, "replication_factor = 1\n");
+    fprintf(file, "local_storage_path = %s\n", test_files.temp_dir);
+    fprintf(file, "daemon_socket_path = %s\n", socket_path);
+    fprintf(file, "[server_1]\n");
+    fprintf(file, "host = 127.0.0.1\n");
+    fprintf(file, "port = 1\n");
+    fprintf(file, "username = test\n");
+    fprintf(file, "password = test\n");
+    fprintf(file, "base_path = /netchunk\n");
+    fclose(file);
+
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_init(&test_context, config_path));
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_daemon_init(&test_daemon, &test_context, socket_path));
+    TEST_ASSERT_EQUAL_INT(0, pthread_create(&daemon_thread, NULL, daemon_thread_main, NULL));
+    daemon_running = true;
+}
+
+void tearDown(void) {
+    if (daemon_running) {
+        netchunk_daemon_stop(&test_daemon);
+        pthread_join(daemon_thread, NULL);
+        daemon_running = false;
+    }
+    netchunk_daemon_cleanup(&test_daemon);
+    netchunk_cleanup(&test_context);
+
+    // Remove temporary test files
+    cleanup_temp_test_directory(&test_files);
+
+    // Cleanup test environment
+    test_cleanup_environment();
+}
+
+// Test that requests run against the daemon's context
+void test_daemon_health_check(void) {
+    netchunk_daemon_client_t client;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_daemon_connect(&client, socket_path));
+
+    uint32_t healthy = 99, total = 0;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_daemon_health_check(&client, &healthy, &total));
+    TEST_ASSERT_EQUAL_UINT32(0, healthy);
+    TEST_ASSERT_EQUAL_UINT32(1, total);
+
+    netchunk_daemon_disconnect(&client);
+}
+
+// Test that health check probes show up in the daemon's server scores
+void test_daemon_health_report(void) {
+    netchunk_daemon_client_t client;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_daemon_connect(&client, socket_path));
+
+    netchunk_server_score_t scores[NETCHUNK_MAX_SERVERS];
+    int count = 0;
+    uint32_t healthy = 99;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS,
+        netchunk_daemon_health_report(&client, &healthy, NULL, scores, NETCHUNK_MAX_SERVERS, &count));
+    TEST_ASSERT_EQUAL_UINT32(0, healthy);
+    TEST_ASSERT_EQUAL_INT(1, count);
+    TEST_ASSERT_EQUAL_UINT64(1, scores[0].samples);
+    TEST_ASSERT_EQUAL_UINT64(0, scores[0].successes);
+    TEST_ASSERT_EQUAL_UINT32(1, scores[0].consecutive_failures);
+    TEST_ASSERT_TRUE(scores[0].error_rate > 0.99);
+
+    netchunk_daemon_disconnect(&client);
+}
+
+// Test that errors from the daemon reach the client
+void test_daemon_forwards_errors(void) {
+    netchunk_daemon_client_t client;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_daemon_connect(&client, socket_path));
+
+    // Download needs a regular file descriptor
+    int pipe_fds[2];
+    TEST_ASSERT_EQUAL_INT(0, pipe(pipe_fds));
+    TEST_ASSERT_NOT_EQUAL(NETCHUNK_SUCCESS, netchunk_daemon_download(&client, "missing.txt", pipe_fds[1], NULL));
+    close(pipe_fds[0]);
+    close(pipe_fds[1]);
+
+    netchunk_daemon_disconnect(&client);
+}
+
+// Test that a second daemon cannot take over a live socket
+void test_daemon_rejects_second_instance(void) {
+    netchunk_daemon_t second;
+    TEST_ASSERT_EQUAL(NETCHUNK_ERROR_CONFIG, netchunk_daemon_init(&second, &test_context, socket_path));
+    TEST_ASSERT_TRUE(file_exists(socket_path));
+}
+
+// Test connecting when no daemon is listening
+void test_daemon_connect_without_daemon(void) {
+    char missing_path[TEST_MAX_PATH_LEN];
+    snprintf(missing_path, sizeof(missing_path), "%s/missing.sock", test_files.temp_dir);
+
+    netchunk_daemon_client_t client;
+    TEST_ASSERT_EQUAL(NETCHUNK_ERROR_SERVER_UNAVAILABLE, netchunk_daemon_connect(&client, missing_path));
+}
+
+// Test the shutdown request
+void test_daemon_shutdown(void) {
+    netchunk_daemon_client_t client;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_daemon_connect(&client, socket_path));
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_daemon_shutdown(&client));
+    netchunk_daemon_disconnect(&client);
+
+    pthread_join(daemon_thread, NULL);
+    daemon_running = false;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, daemon_result);
+    TEST_ASSERT_EQUAL_UINT64(1, test_daemon.requests_served);
+
+    // The socket is gone once the daemon is cleaned up
+    netchunk_daemon_cleanup(&test_daemon);
+    TEST_ASSERT_FALSE(file_exists(socket_path));
+    TEST_ASSERT_EQUAL(NETCHUNK_ERROR_SERVER_UNAVAILABLE, netchunk_daemon_connect(&client, socket_path));
+}
+
+// Unity test runner
+int main(void) {
+    UNITY_BEGIN();
+
+    // Request forwarding tests
+    RUN_TEST(test_daemon_health_check);
+    RUN_TEST(test_daemon_health_report);
+    RUN_TEST(test_daemon_forwards_errors);
+
+    // Lifecycle tests
+    RUN_TEST(test_daemon_rejects_second_instance);
+    RUN_TEST(test_daemon_connect_without_daemon);
+    RUN_TEST(test_daemon_shutdown);
+
+    return UNITY_END();
+}
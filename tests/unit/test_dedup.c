@@ -0,0 +1,210 @@
+#include "unity.h"
+#include "test_utils.h"
+#include "dedup.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TEST_CHUNK_COUNT 5000
+
+// Test data and fixtures
+static test_file_context_t test_files;
+static netchunk_dedup_index_t test_index;
+static char index_path[TEST_MAX_PATH_LEN];
+
+void setUp(void) {
+    // Initialize test environment
+    test_setup_environment();
+
+    // Create temporary directory for the index file
+    TEST_ASSERT_EQUAL_INT(0, create_temp_test_directory(&test_files));
+    snprintf(index_path, sizeof(index_path), "%s/index/dedup-index.json", test_files.temp_dir);
+
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_dedup_index_init(&test_index, index_path));
+}
+
+void tearDown(void) {
+    netchunk_dedup_index_cleanup(&test_index);
+
+    // Remove temporary test files
+    cleanup_temp_test_directory(&test_files);
+
+    // Cleanup test environment
+    test_cleanup_environment();
+}
+
+// Helpers
+
+static void make_chunk(netchunk_chunk_t* chunk, uint32_t seed, const char* server_a, const char* server_b) {
+    memset(chunk, 0, sizeof(netchunk_chunk_t));
+
+    test_seed_random(seed);
+    for (int i = 0; i < NETCHUNK_HASH_LENGTH; i++) {
+        chunk->hash[i] = (uint8_t)test_random_uint32();
+    }
+    chunk->size = 1024 + seed;
+
+    if (server_a) {
+        strcpy(chunk->locations[chunk->location_count++].server_id, server_a);
+    }
+    if (server_b) {
+        strcpy(chunk->locations[chunk->location_count++].server_id, server_b);
+    }
+}
+
+// Test reference counting on a single chunk
+void test_dedup_add_and_release(void) {
+    netchunk_chunk_t chunk;
+    make_chunk(&chunk, 1, "server1", "server2");
+
+    TEST_ASSERT_NULL(netchunk_dedup_index_lookup(&test_index, chunk.hash));
+
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_dedup_index_add_ref(&test_index, &chunk));
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_dedup_index_add_ref(&test_index, &chunk));
+
+    const netchunk_dedup_entry_t* entry = netchunk_dedup_index_lookup(&test_index, chunk.hash);
+    TEST_ASSERT_NOT_NULL(entry);
+    TEST_ASSERT_EQUAL_UINT32(2, entry->refcount);
+    TEST_ASSERT_EQUAL_size_t(chunk.size, entry->size);
+    TEST_ASSERT_TRUE(netchunk_dedup_entry_has_server(&test_index, entry, "server1"));
+    TEST_ASSERT_TRUE(netchunk_dedup_entry_has_server(&test_index, entry, "server2"));
+    TEST_ASSERT_FALSE(netchunk_dedup_entry_has_server(&test_index, entry, "server3"));
+
+    uint32_t remaining = 0;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_dedup_index_release(&test_index, chunk.hash, &remaining));
+    TEST_ASSERT_EQUAL_UINT32(1, remaining);
+    TEST_ASSERT_NOT_NULL(netchunk_dedup_index_lookup(&test_index, chunk.hash));
+
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_dedup_index_release(&test_index, chunk.hash, &remaining));
+    TEST_ASSERT_EQUAL_UINT32(0, remaining);
+    TEST_ASSERT_NULL(netchunk_dedup_index_lookup(&test_index, chunk.hash));
+
+    TEST_ASSERT_EQUAL(NETCHUNK_ERROR_FILE_NOT_FOUND, netchunk_dedup_index_release(&test_index, chunk.hash, &remaining));
+}
+
+// Test that later references merge new replica locations
+void test_dedup_merges_locations(void) {
+    netchunk_chunk_t chunk;
+    make_chunk(&chunk, 2, "server1", NULL);
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_dedup_index_add_ref(&test_index, &chunk));
+
+    make_chunk(&chunk, 2, "server3", NULL);
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_dedup_index_add_ref(&test_index, &chunk));
+
+    const netchunk_dedup_entry_t* entry = netchunk_dedup_index_lookup(&test_index, chunk.hash);
+    TEST_ASSERT_NOT_NULL(entry);
+    TEST_ASSERT_TRUE(netchunk_dedup_entry_has_server(&test_index, entry, "server1"));
+    TEST_ASSERT_TRUE(netchunk_dedup_entry_has_server(&test_index, entry, "server3"));
+}
+
+// Test growth past the initial capacity and removals in long probe chains
+void test_dedup_many_chunks(void) {
+    netchunk_chunk_t chunk;
+
+    for (uint32_t i = 0; i < TEST_CHUNK_COUNT; i++) {
+        make_chunk(&chunk, i, "server1", NULL);
+        TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_dedup_index_add_ref(&test_index, &chunk));
+    }
+    TEST_ASSERT_EQUAL_size_t(TEST_CHUNK_COUNT, test_index.count);
+    TEST_ASSERT_TRUE(test_index.capacity > NETCHUNK_DEDUP_INITIAL_CAPACITY);
+
+    // Remove every other chunk, then check the rest are still reachable
+    for (uint32_t i = 0; i < TEST_CHUNK_COUNT; i += 2) {
+        make_chunk(&chunk, i, NULL, NULL);
+        TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_dedup_index_release(&test_index, chunk.hash, NULL));
+    }
+    TEST_ASSERT_EQUAL_size_t(TEST_CHUNK_COUNT / 2, test_index.count);
+
+    for (uint32_t i = 0; i < TEST_CHUNK_COUNT; i++) {
+        make_chunk(&chunk, i, NULL, NULL);
+        const netchunk_dedup_entry_t* entry = netchunk_dedup_index_lookup(&test_index, chunk.hash);
+        if (i % 2 == 0) {
+            TEST_ASSERT_NULL(entry);
+        } else {
+            TEST_ASSERT_NOT_NULL(entry);
+            TEST_ASSERT_EQUAL_size_t(chunk.size, entry->size);
+        }
+    }
+}
+
+// Test that the index survives a save and reload
+void test_dedup_save_and_load(void) {
+    netchunk_chunk_t chunk;
+
+    // A missing file loads as an empty index
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_dedup_index_load(&test_index));
+    TEST_ASSERT_EQUAL_size_t(0, test_index.count);
+
+    for (uint32_t i = 0; i < 100; i++) {
+        make_chunk(&chunk, i, "server1", (i % 2) ? "server2" : NULL);
+        TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_dedup_index_add_ref(&test_index, &chunk));
+    }
+    make_chunk(&chunk, 7, "server1", NULL);
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_dedup_index_add_ref(&test_index, &chunk));
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_dedup_index_save(&test_index));
+    TEST_ASSERT_FALSE(test_index.dirty);
+
+    netchunk_dedup_index_t loaded;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_dedup_index_init(&loaded, index_path));
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_dedup_index_load(&loaded));
+    TEST_ASSERT_EQUAL_size_t(100, loaded.count);
+
+    for (uint32_t i = 0; i < 100; i++) {
+        make_chunk(&chunk, i, NULL, NULL);
+        const netchunk_dedup_entry_t* entry = netchunk_dedup_index_lookup(&loaded, chunk.hash);
+        TEST_ASSERT_NOT_NULL(entry);
+        TEST_ASSERT_EQUAL_size_t(chunk.size, entry->size);
+        TEST_ASSERT_EQUAL_UINT32(i == 7 ? 2 : 1, entry->refcount);
+        TEST_ASSERT_TRUE(netchunk_dedup_entry_has_server(&loaded, entry, "server1"));
+        TEST_ASSERT_EQUAL(i % 2 == 1, netchunk_dedup_entry_has_server(&loaded, entry, "server2"));
+    }
+
+    netchunk_dedup_index_cleanup(&loaded);
+}
+
+// Test content-addressed chunk naming
+void test_dedup_content_id(void) {
+    netchunk_chunk_t chunk;
+    make_chunk(&chunk, 3, NULL, NULL);
+    strcpy(chunk.id, "0000000012345678");
+    TEST_ASSERT_FALSE(netchunk_chunk_is_content_addressed(&chunk));
+
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_chunk_set_content_id(&chunk));
+    TEST_ASSERT_EQUAL_size_t(NETCHUNK_CHUNK_ID_LENGTH, strlen(chunk.id));
+    TEST_ASSERT_TRUE(netchunk_chunk_is_content_addressed(&chunk));
+
+    // Different data under the same name is not content-addressed
+    chunk.hash[0] ^= 0xff;
+    TEST_ASSERT_FALSE(netchunk_chunk_is_content_addressed(&chunk));
+}
+
+// Test invalid arguments
+void test_dedup_invalid_arguments(void) {
+    netchunk_chunk_t chunk;
+    make_chunk(&chunk, 4, NULL, NULL);
+
+    TEST_ASSERT_EQUAL(NETCHUNK_ERROR_INVALID_ARGUMENT, netchunk_dedup_index_init(NULL, index_path));
+    TEST_ASSERT_EQUAL(NETCHUNK_ERROR_INVALID_ARGUMENT, netchunk_dedup_index_add_ref(NULL, &chunk));
+    TEST_ASSERT_EQUAL(NETCHUNK_ERROR_INVALID_ARGUMENT, netchunk_dedup_index_add_ref(&test_index, NULL));
+    TEST_ASSERT_EQUAL(NETCHUNK_ERROR_INVALID_ARGUMENT, netchunk_dedup_index_release(&test_index, NULL, NULL));
+    TEST_ASSERT_NULL(netchunk_dedup_index_lookup(NULL, chunk.hash));
+}
+
+// Unity test runner
+int main(void) {
+    UNITY_BEGIN();
+
+    // Reference counting tests
+    RUN_TEST(test_dedup_add_and_release);
+    RUN_TEST(test_dedup_merges_locations);
+    RUN_TEST(test_dedup_many_chunks);
+
+    // Persistence tests
+    RUN_TEST(test_dedup_save_and_load);
+
+    // Naming and argument tests
+    RUN_TEST(test_dedup_content_id);
+    RUN_TEST(test_dedup_invalid_arguments);
+
+    return UNITY_END();
+}
@@ -0,0 +1,160 @@
+#include "unity.h"
+#include "test_utils.h"
+#include "delete_queue.h"
+#include <string.h>
+
+#define TEST_NOW ((time_t)1700000000)
+
+// Test data and fixtures
+static netchunk_ftp_context_t ftp_context; // Never connected; removals through it fail
+static netchunk_delete_queue_t queue;
+
+void setUp(void) {
+    // Initialize test environment
+    test_setup_environment();
+    memset(&ftp_context, 0, sizeof(ftp_context));
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_delete_queue_init(&queue, &ftp_context));
+}
+
+void tearDown(void) {
+    netchunk_delete_queue_cleanup(&queue);
+
+    // Cleanup test environment
+    test_cleanup_environment();
+}
+
+// Test that each DELE is matched with its own reply, login replies skipped
+void test_parse_delete_replies(void) {
+    const char* replies =
+        "220 Welcome\r\n"
+        "230 Logged in\r\n"
+        "257 \"/\" is the current directory\r\n"
+        "250 DELE command successful\r\n"
+        "550-chunks/b.chunk:\r\n"
+        "550 No such file\r\n"
+        "250 DELE command successful\r\n"
+        "450 File busy\r\n";
+
+    netchunk_error_t results[5];
+    TEST_ASSERT_EQUAL_size_t(4, netchunk_ftp_parse_delete_replies(replies, strlen(replies), results, 5));
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, results[0]);
+    TEST_ASSERT_EQUAL(NETCHUNK_ERROR_FILE_NOT_FOUND, results[1]);
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, results[2]);
+    TEST_ASSERT_EQUAL(NETCHUNK_ERROR_FTP, results[3]);
+
+    TEST_ASSERT_EQUAL_size_t(2, netchunk_ftp_parse_delete_replies(replies, strlen(replies), results, 2));
+    TEST_ASSERT_EQUAL_size_t(0, netchunk_ftp_parse_delete_replies(replies, 0, results, 5));
+    TEST_ASSERT_EQUAL_size_t(0, netchunk_ftp_parse_delete_replies(NULL, 10, results, 5));
+}
+
+// Test that only due removals are taken and outcomes are settled
+void test_delete_queue_take_and_settle(void) {
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_delete_queue_push(&queue, 0, "chunks/a.chunk"));
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_delete_queue_push(&queue, 1, "chunks/b.chunk"));
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_delete_queue_push(&queue, 2, "chunks/c.chunk"));
+    TEST_ASSERT_EQUAL(NETCHUNK_ERROR_INVALID_ARGUMENT, netchunk_delete_queue_push(&queue, -1, "chunks/d.chunk"));
+
+    netchunk_delete_item_t items[4];
+    TEST_ASSERT_EQUAL_size_t(2, netchunk_delete_queue_take(&queue, TEST_NOW, items, 2));
+    TEST_ASSERT_EQUAL_size_t(1, netchunk_delete_queue_take(&queue, TEST_NOW, items + 2, 2));
+
+    netchunk_delete_queue_stats_t stats;
+    netchunk_delete_queue_get_stats(&queue, &stats);
+    TEST_ASSERT_EQUAL_UINT64(3, stats.queued);
+    TEST_ASSERT_EQUAL_UINT64(3, stats.pending);
+
+    // A missing file counts as deleted; a failure comes back after the delay
+    netchunk_error_t results[3] = { NETCHUNK_SUCCESS, NETCHUNK_ERROR_FILE_NOT_FOUND, NETCHUNK_ERROR_NETWORK };
+    netchunk_delete_queue_settle(&queue, items, results, 3, TEST_NOW);
+
+    netchunk_delete_queue_get_stats(&queue, &stats);
+    TEST_ASSERT_EQUAL_UINT64(2, stats.deleted);
+    TEST_ASSERT_EQUAL_UINT64(1, stats.retried);
+    TEST_ASSERT_EQUAL_UINT64(1, stats.pending);
+
+    TEST_ASSERT_EQUAL_size_t(0, netchunk_delete_queue_take(&queue, TEST_NOW, items, 4));
+    TEST_ASSERT_EQUAL_size_t(0, netchunk_delete_queue_take(&queue,
+        TEST_NOW + NETCHUNK_DELETE_QUEUE_RETRY_DELAY - 1, items, 4));
+    TEST_ASSERT_EQUAL_size_t(1, netchunk_delete_queue_take(&queue,
+        TEST_NOW + NETCHUNK_DELETE_QUEUE_RETRY_DELAY, items, 4));
+    TEST_ASSERT_EQUAL_STRING("chunks/c.chunk", items[0].remote_path);
+    TEST_ASSERT_EQUAL_INT(2, items[0].server_index);
+    TEST_ASSERT_EQUAL_INT(1, items[0].attempts);
+
+    results[0] = NETCHUNK_SUCCESS;
+    netchunk_delete_queue_settle(&queue, items, results, 1, TEST_NOW);
+    netchunk_delete_queue_get_stats(&queue, &stats);
+    TEST_ASSERT_EQUAL_UINT64(3, stats.deleted);
+    TEST_ASSERT_EQUAL_UINT64(0, stats.pending);
+}
+
+// Test that the retry delay doubles and removals are given up eventually
+void test_delete_queue_backoff(void) {
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_delete_queue_push(&queue, 0, "chunks/a.chunk"));
+
+    netchunk_delete_item_t item;
+    netchunk_error_t failure = NETCHUNK_ERROR_TIMEOUT;
+    time_t now = TEST_NOW;
+    time_t delay = NETCHUNK_DELETE_QUEUE_RETRY_DELAY;
+    for (int attempt = 1; attempt < NETCHUNK_DELETE_QUEUE_MAX_ATTEMPTS; attempt++) {
+        TEST_ASSERT_EQUAL_size_t(1, netchunk_delete_queue_take(&queue, now, &item, 1));
+        netchunk_delete_queue_settle(&queue, &item, &failure, 1, now);
+
+        TEST_ASSERT_EQUAL_size_t(0, netchunk_delete_queue_take(&queue, now + delay - 1, &item, 1));
+        now += delay;
+        delay *= 2;
+    }
+
+    TEST_ASSERT_EQUAL_size_t(1, netchunk_delete_queue_take(&queue, now, &item, 1));
+    netchunk_delete_queue_settle(&queue, &item, &failure, 1, now);
+
+    netchunk_delete_queue_stats_t stats;
+    netchunk_delete_queue_get_stats(&queue, &stats);
+    TEST_ASSERT_EQUAL_UINT64(1, stats.abandoned);
+    TEST_ASSERT_EQUAL_UINT64(NETCHUNK_DELETE_QUEUE_MAX_ATTEMPTS - 1, stats.retried);
+    TEST_ASSERT_EQUAL_UINT64(0, stats.pending);
+}
+
+// Test that a flush tries every removal without waiting out the backoff
+void test_delete_queue_flush(void) {
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_delete_queue_flush(&queue));
+
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_delete_queue_push(&queue, 0, "chunks/a.chunk"));
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_delete_queue_push(&queue, 1, "chunks/b.chunk"));
+
+    // The context has no connections, so every attempt fails
+    TEST_ASSERT_EQUAL(NETCHUNK_ERROR_FTP, netchunk_delete_queue_flush(&queue));
+
+    netchunk_delete_queue_stats_t stats;
+    netchunk_delete_queue_get_stats(&queue, &stats);
+    TEST_ASSERT_EQUAL_UINT64(2, stats.abandoned);
+    TEST_ASSERT_EQUAL_UINT64(0, stats.pending);
+}
+
+// Test that the worker thread drains the queue while flush waits
+void test_delete_queue_worker(void) {
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_delete_queue_start(&queue));
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_delete_queue_push(&queue, 0, "chunks/a.chunk"));
+    TEST_ASSERT_EQUAL(NETCHUNK_ERROR_FTP, netchunk_delete_queue_flush(&queue));
+
+    netchunk_delete_queue_stats_t stats;
+    netchunk_delete_queue_get_stats(&queue, &stats);
+    TEST_ASSERT_EQUAL_UINT64(1, stats.abandoned);
+    TEST_ASSERT_EQUAL_UINT64(0, stats.pending);
+}
+
+// Unity test runner
+int main(void) {
+    UNITY_BEGIN();
+
+    // Reply parsing tests
+    RUN_TEST(test_parse_delete_replies);
+
+    // Queue tests
+    RUN_TEST(test_delete_queue_take_and_settle);
+    RUN_TEST(test_delete_queue_backoff);
+    RUN_TEST(test_delete_queue_flush);
+    RUN_TEST(test_delete_queue_worker);
+
+    return UNITY_END();
+}
@@ -0,0 +1,211 @@
+#include "unity.h"
+#include "test_utils.h"
+#include "crypto.h"
+#include "disk_cache.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define TEST_CHUNK_SIZE 4096
+
+// Test data and fixtures
+static test_file_context_t test_files;
+static char cache_dir[TEST_MAX_PATH_LEN];
+static netchunk_disk_cache_t cache;
+
+void setUp(void) {
+    // Initialize test environment
+    test_setup_environment();
+
+    // The cache directory is created on first insert
+    TEST_ASSERT_EQUAL_INT(0, create_temp_test_directory(&test_files));
+    snprintf(cache_dir, sizeof(cache_dir), "%s/data/%s", test_files.temp_dir, NETCHUNK_DISK_CACHE_DIRECTORY);
+    memset(&cache, 0, sizeof(cache));
+}
+
+void tearDown(void) {
+    netchunk_disk_cache_cleanup(&cache);
+
+    // Remove temporary test files
+    cleanup_temp_test_directory(&test_files);
+
+    // Cleanup test environment
+    test_cleanup_environment();
+}
+
+// Helpers
+
+static void make_chunk(uint32_t key, uint8_t* data, uint8_t* hash) {
+    test_seed_random(key);
+    for (size_t i = 0; i < TEST_CHUNK_SIZE; i++) {
+        data[i] = (uint8_t)test_random_uint32();
+    }
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_sha256_hash(data, TEST_CHUNK_SIZE, hash));
+}
+
+static void put_chunk(uint32_t key) {
+    uint8_t data[TEST_CHUNK_SIZE];
+    uint8_t hash[NETCHUNK_HASH_LENGTH];
+    make_chunk(key, data, hash);
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_disk_cache_put(&cache, hash, data, TEST_CHUNK_SIZE));
+}
+
+static netchunk_error_t get_chunk(uint32_t key) {
+    uint8_t data[TEST_CHUNK_SIZE];
+    uint8_t hash[NETCHUNK_HASH_LENGTH];
+    uint8_t* cached = NULL;
+    make_chunk(key, data, hash);
+
+    netchunk_error_t error = netchunk_disk_cache_get(&cache, hash, TEST_CHUNK_SIZE, &cached);
+    if (error == NETCHUNK_SUCCESS) {
+        TEST_ASSERT_EQUAL_MEMORY(data, cached, TEST_CHUNK_SIZE);
+        free(cached);
+    }
+    return error;
+}
+
+static void chunk_file_path(uint32_t key, char* path, size_t size) {
+    uint8_t data[TEST_CHUNK_SIZE];
+    uint8_t hash[NETCHUNK_HASH_LENGTH];
+    char hex[NETCHUNK_HASH_LENGTH * 2 + 1];
+    make_chunk(key, data, hash);
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_hash_to_hex_string(hash, NETCHUNK_HASH_LENGTH, hex));
+    snprintf(path, size, "%s/%.2s/%s", cache_dir, hex, hex);
+}
+
+// Test that stored chunks are read back and counted
+void test_disk_cache_put_get(void) {
+    netchunk_disk_cache_stats_t stats;
+
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_disk_cache_init(&cache, cache_dir, 16 * TEST_CHUNK_SIZE));
+    TEST_ASSERT_EQUAL(NETCHUNK_ERROR_FILE_NOT_FOUND, get_chunk(1));
+
+    put_chunk(1);
+    put_chunk(1);
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, get_chunk(1));
+
+    netchunk_disk_cache_get_stats(&cache, &stats);
+    TEST_ASSERT_EQUAL_UINT64(1, stats.hits);
+    TEST_ASSERT_EQUAL_UINT64(1, stats.misses);
+    TEST_ASSERT_EQUAL_UINT64(1, stats.insertions);
+    TEST_ASSERT_EQUAL_UINT64(1, stats.entries);
+    TEST_ASSERT_EQUAL_UINT64(TEST_CHUNK_SIZE, stats.bytes_used);
+}
+
+// Test that a damaged file is dropped instead of returned
+void test_disk_cache_verifies_reads(void) {
+    char path[TEST_MAX_PATH_LEN];
+    netchunk_disk_cache_stats_t stats;
+
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_disk_cache_init(&cache, cache_dir, 16 * TEST_CHUNK_SIZE));
+    put_chunk(2);
+
+    chunk_file_path(2, path, sizeof(path));
+    FILE* file = fopen(path, "r+b");
+    TEST_ASSERT_NOT_NULL(file);
+    fseek(file, 100, SEEK_SET);
+    fputc(0, file);
+    fputc(1, file);
+    fclose(file);
+
+    TEST_ASSERT_EQUAL(NETCHUNK_ERROR_CHUNK_INTEGRITY, get_chunk(2));
+    TEST_ASSERT_NOT_EQUAL(0, access(path, F_OK));
+    TEST_ASSERT_EQUAL(NETCHUNK_ERROR_FILE_NOT_FOUND, get_chunk(2));
+
+    netchunk_disk_cache_get_stats(&cache, &stats);
+    TEST_ASSERT_EQUAL_UINT64(1, stats.corrupt);
+    TEST_ASSERT_EQUAL_UINT64(0, stats.entries);
+}
+
+// Test that the clock spares recently read chunks
+void test_disk_cache_clock_eviction(void) {
+    char path[TEST_MAX_PATH_LEN];
+    netchunk_disk_cache_stats_t stats;
+
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_disk_cache_init(&cache, cache_dir, 3 * TEST_CHUNK_SIZE));
+    put_chunk(1);
+    put_chunk(2);
+    put_chunk(3);
+
+    // Reading chunk 1 sets its reference bit, so chunk 2 goes first
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, get_chunk(1));
+    put_chunk(4);
+
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, get_chunk(1));
+    TEST_ASSERT_EQUAL(NETCHUNK_ERROR_FILE_NOT_FOUND, get_chunk(2));
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, get_chunk(3));
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, get_chunk(4));
+
+    chunk_file_path(2, path, sizeof(path));
+    TEST_ASSERT_NOT_EQUAL(0, access(path, F_OK));
+
+    netchunk_disk_cache_get_stats(&cache, &stats);
+    TEST_ASSERT_EQUAL_UINT64(1, stats.evictions);
+    TEST_ASSERT_EQUAL_UINT64(3 * TEST_CHUNK_SIZE, stats.bytes_used);
+
+    // Chunks larger than the whole budget are not cached
+    uint8_t* big = calloc(1, 4 * TEST_CHUNK_SIZE);
+    uint8_t hash[NETCHUNK_HASH_LENGTH];
+    TEST_ASSERT_NOT_NULL(big);
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_sha256_hash(big, 4 * TEST_CHUNK_SIZE, hash));
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_disk_cache_put(&cache, hash, big, 4 * TEST_CHUNK_SIZE));
+    TEST_ASSERT_FALSE(netchunk_disk_cache_contains(&cache, hash));
+    free(big);
+}
+
+// Test that a reopened cache finds its chunks and honours a smaller budget
+void test_disk_cache_reopen(void) {
+    char leftover[TEST_MAX_PATH_LEN + 8];
+    netchunk_disk_cache_stats_t stats;
+
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_disk_cache_init(&cache, cache_dir, 16 * TEST_CHUNK_SIZE));
+    for (uint32_t key = 1; key <= 4; key++) {
+        put_chunk(key);
+    }
+    netchunk_disk_cache_cleanup(&cache);
+
+    // An interrupted write leaves a temporary file behind
+    chunk_file_path(5, leftover, sizeof(leftover));
+    strcat(leftover, ".AbCdEf");
+    FILE* file = fopen(leftover, "wb");
+    if (!file) {
+        // Chunk 5 may hash into a subdirectory that does not exist yet
+        char dir[TEST_MAX_PATH_LEN];
+        snprintf(dir, sizeof(dir), "%.*s", (int)(strrchr(leftover, '/') - leftover), leftover);
+        TEST_ASSERT_EQUAL_INT(0, mkdir(dir, 0755));
+        file = fopen(leftover, "wb");
+    }
+    TEST_ASSERT_NOT_NULL(file);
+    fclose(file);
+
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_disk_cache_init(&cache, cache_dir, 2 * TEST_CHUNK_SIZE));
+    netchunk_disk_cache_get_stats(&cache, &stats);
+    TEST_ASSERT_EQUAL_UINT64(2, stats.entries);
+    TEST_ASSERT_EQUAL_UINT64(2, stats.evictions);
+    TEST_ASSERT_NOT_EQUAL(0, access(leftover, F_OK));
+
+    uint32_t found = 0;
+    for (uint32_t key = 1; key <= 4; key++) {
+        if (get_chunk(key) == NETCHUNK_SUCCESS) {
+            found++;
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT32(2, found);
+}
+
+// Unity test runner
+int main(void) {
+    UNITY_BEGIN();
+
+    // Read and write tests
+    RUN_TEST(test_disk_cache_put_get);
+    RUN_TEST(test_disk_cache_verifies_reads);
+
+    // Eviction tests
+    RUN_TEST(test_disk_cache_clock_eviction);
+    RUN_TEST(test_disk_cache_reopen);
+
+    return UNITY_END();
+}
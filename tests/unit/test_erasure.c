@@ -0,0 +1,187 @@
+#include "unity.h"
+#include "test_utils.h"
+#include "erasure.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TEST_SHARD_SIZE 1000 // Not a multiple of any vector width
+
+// Test data and fixtures
+static uint8_t* shards[NETCHUNK_EC_MAX_SHARDS];
+
+void setUp(void) {
+    test_setup_environment();
+    memset(shards, 0, sizeof(shards));
+}
+
+void tearDown(void) {
+    for (int i = 0; i < NETCHUNK_EC_MAX_SHARDS; i++) {
+        free(shards[i]);
+    }
+
+    // Undo any backend forced by a test
+    netchunk_gf_set_backend(NETCHUNK_GF_BACKEND_AUTO);
+
+    test_cleanup_environment();
+}
+
+// Helpers
+
+static void fill_stripe(int data_shards, int parity_shards, uint32_t seed) {
+    test_seed_random(seed);
+    for (int i = 0; i < data_shards + parity_shards; i++) {
+        shards[i] = malloc(TEST_SHARD_SIZE);
+        TEST_ASSERT_NOT_NULL(shards[i]);
+        for (int b = 0; b < TEST_SHARD_SIZE; b++) {
+            shards[i][b] = i < data_shards ? (uint8_t)test_random_uint32() : 0;
+        }
+    }
+
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_ec_encode(data_shards, parity_shards,
+        (const uint8_t* const*)shards, shards + data_shards, TEST_SHARD_SIZE));
+}
+
+// Test field arithmetic against known products and inverses
+void test_gf_arithmetic(void) {
+    TEST_ASSERT_EQUAL_UINT8(0, netchunk_gf_mul(0, 0x53));
+    TEST_ASSERT_EQUAL_UINT8(0x53, netchunk_gf_mul(1, 0x53));
+    TEST_ASSERT_EQUAL_UINT8(0x1d, netchunk_gf_mul(0x80, 2)); // Reduction by 0x11d
+    TEST_ASSERT_EQUAL_UINT8(0, netchunk_gf_inverse(0));
+
+    for (int a = 1; a < 256; a++) {
+        TEST_ASSERT_EQUAL_UINT8(1, netchunk_gf_mul((uint8_t)a, netchunk_gf_inverse((uint8_t)a)));
+    }
+}
+
+// Test that every backend the CPU supports matches the generic kernel
+void test_gf_backends_match_generic(void) {
+    uint8_t src[TEST_SHARD_SIZE];
+    uint8_t expected[TEST_SHARD_SIZE];
+    uint8_t actual[TEST_SHARD_SIZE];
+
+    test_seed_random(7);
+    for (int b = 0; b < TEST_SHARD_SIZE; b++) {
+        src[b] = (uint8_t)test_random_uint32();
+    }
+
+    for (int backend = 0; backend < NETCHUNK_GF_BACKEND_COUNT; backend++) {
+        if (!netchunk_gf_backend_available((netchunk_gf_backend_t)backend)) {
+            continue;
+        }
+
+        const uint8_t coefficients[] = { 0, 1, 2, 0x8e, 0xff };
+        for (size_t c = 0; c < sizeof(coefficients); c++) {
+            // Odd lengths exercise the scalar tails
+            for (size_t size = TEST_SHARD_SIZE - 37; size <= TEST_SHARD_SIZE; size += 37) {
+                memset(expected, 0x5a, sizeof(expected));
+                memset(actual, 0x5a, sizeof(actual));
+
+                TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_gf_set_backend(NETCHUNK_GF_BACKEND_GENERIC));
+                netchunk_gf_mul_add_region(expected, src, coefficients[c], size);
+
+                TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_gf_set_backend((netchunk_gf_backend_t)backend));
+                netchunk_gf_mul_add_region(actual, src, coefficients[c], size);
+
+                TEST_ASSERT_EQUAL_MEMORY_MESSAGE(expected, actual, sizeof(expected),
+                    netchunk_gf_backend_name((netchunk_gf_backend_t)backend));
+            }
+        }
+    }
+}
+
+// Test that any parity_shards lost shards of a stripe are rebuilt exactly
+void test_ec_reconstruct_any_erasures(void) {
+    const int data_shards = 6;
+    const int parity_shards = 3;
+    const int total = data_shards + parity_shards;
+    fill_stripe(data_shards, parity_shards, 42);
+
+    uint8_t* originals[NETCHUNK_EC_MAX_SHARDS];
+    for (int i = 0; i < total; i++) {
+        originals[i] = malloc(TEST_SHARD_SIZE);
+        TEST_ASSERT_NOT_NULL(originals[i]);
+        memcpy(originals[i], shards[i], TEST_SHARD_SIZE);
+    }
+
+    for (int a = 0; a < total; a++) {
+        for (int b = a + 1; b < total; b++) {
+            for (int c = b + 1; c < total; c++) {
+                bool present[NETCHUNK_EC_MAX_SHARDS];
+                for (int i = 0; i < total; i++) {
+                    present[i] = i != a && i != b && i != c;
+                    if (!present[i]) {
+                        memset(shards[i], 0xee, TEST_SHARD_SIZE);
+                    }
+                }
+
+                TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_ec_reconstruct(data_shards, parity_shards,
+                    shards, present, TEST_SHARD_SIZE));
+                for (int i = 0; i < total; i++) {
+                    TEST_ASSERT_EQUAL_MEMORY(originals[i], shards[i], TEST_SHARD_SIZE);
+                }
+            }
+        }
+    }
+
+    for (int i = 0; i < total; i++) {
+        free(originals[i]);
+    }
+}
+
+// Test that losing more shards than there is parity is reported
+void test_ec_reconstruct_too_many_erasures(void) {
+    fill_stripe(4, 2, 3);
+
+    bool present[NETCHUNK_EC_MAX_SHARDS] = { false, true, false, true, false, true };
+    TEST_ASSERT_EQUAL(NETCHUNK_ERROR_CHUNK_INTEGRITY, netchunk_ec_reconstruct(4, 2, shards, present, TEST_SHARD_SIZE));
+}
+
+// Test that parity accumulated one data shard at a time matches encoding
+void test_ec_incremental_parity(void) {
+    const int data_shards = 5;
+    const int parity_shards = 2;
+    fill_stripe(data_shards, parity_shards, 11);
+
+    for (int p = 0; p < parity_shards; p++) {
+        uint8_t parity[TEST_SHARD_SIZE] = { 0 };
+        for (int d = 0; d < data_shards; d++) {
+            netchunk_gf_mul_add_region(parity, shards[d], netchunk_ec_coefficient(data_shards, p, d), TEST_SHARD_SIZE);
+        }
+        TEST_ASSERT_EQUAL_MEMORY(shards[data_shards + p], parity, TEST_SHARD_SIZE);
+    }
+}
+
+// Test layout limits and argument checks
+void test_ec_layout_and_arguments(void) {
+    TEST_ASSERT_TRUE(netchunk_ec_layout_valid(6, 3));
+    TEST_ASSERT_TRUE(netchunk_ec_layout_valid(1, 1));
+    TEST_ASSERT_FALSE(netchunk_ec_layout_valid(0, 3));
+    TEST_ASSERT_FALSE(netchunk_ec_layout_valid(6, 0));
+    TEST_ASSERT_FALSE(netchunk_ec_layout_valid(NETCHUNK_EC_MAX_SHARDS, 1));
+
+    bool present[2] = { true, true };
+    TEST_ASSERT_EQUAL(NETCHUNK_ERROR_INVALID_ARGUMENT, netchunk_ec_reconstruct(0, 2, shards, present, 1));
+    TEST_ASSERT_EQUAL(NETCHUNK_ERROR_INVALID_ARGUMENT, netchunk_ec_reconstruct(1, 1, NULL, present, 1));
+
+    TEST_ASSERT_EQUAL(NETCHUNK_ERROR_INVALID_ARGUMENT, netchunk_gf_set_backend(NETCHUNK_GF_BACKEND_COUNT));
+    TEST_ASSERT_TRUE(netchunk_gf_backend_available(NETCHUNK_GF_BACKEND_GENERIC));
+    TEST_ASSERT_EQUAL_STRING("unknown", netchunk_gf_backend_name(NETCHUNK_GF_BACKEND_COUNT));
+}
+
+// Unity test runner
+int main(void) {
+    UNITY_BEGIN();
+
+    // Field arithmetic tests
+    RUN_TEST(test_gf_arithmetic);
+    RUN_TEST(test_gf_backends_match_generic);
+
+    // Reed-Solomon coding tests
+    RUN_TEST(test_ec_reconstruct_any_erasures);
+    RUN_TEST(test_ec_reconstruct_too_many_erasures);
+    RUN_TEST(test_ec_incremental_parity);
+    RUN_TEST(test_ec_layout_and_arguments);
+
+    return UNITY_END();
+}
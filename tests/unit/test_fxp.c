@@ -0,0 +1,91 @@
+#include "unity.h"
+#include "test_utils.h"
+#include "fxp.h"
+#include <string.h>
+
+// Test data and fixtures
+static netchunk_server_t source;
+static netchunk_server_t target;
+
+void setUp(void) {
+    // Initialize test environment
+    test_setup_environment();
+    memset(&source, 0, sizeof(source));
+    memset(&target, 0, sizeof(target));
+    snprintf(source.id, sizeof(source.id), "server_1");
+    snprintf(target.id, sizeof(target.id), "server_2");
+    source.fxp = true;
+    target.fxp = true;
+}
+
+void tearDown(void) {
+    // Cleanup test environment
+    test_cleanup_environment();
+}
+
+// Test that both servers must opt in to FXP over plain FTP
+void test_fxp_supported(void) {
+    TEST_ASSERT_TRUE(netchunk_fxp_supported(&source, &target));
+    TEST_ASSERT_FALSE(netchunk_fxp_supported(&source, &source));
+    TEST_ASSERT_FALSE(netchunk_fxp_supported(NULL, &target));
+    TEST_ASSERT_FALSE(netchunk_fxp_supported(&source, NULL));
+
+    target.fxp = false;
+    TEST_ASSERT_FALSE(netchunk_fxp_supported(&source, &target));
+
+    target.fxp = true;
+    source.use_ssl = true;
+    TEST_ASSERT_FALSE(netchunk_fxp_supported(&source, &target));
+}
+
+// Test parsing of PASV replies in the forms servers send
+void test_fxp_parse_pasv(void) {
+    int numbers[6];
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS,
+        netchunk_fxp_parse_pasv("227 Entering Passive Mode (10,0,0,5,195,80).", numbers));
+    int expected[6] = { 10, 0, 0, 5, 195, 80 };
+    TEST_ASSERT_EQUAL_INT_ARRAY(expected, numbers, 6);
+
+    // Some servers leave out the parentheses
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS,
+        netchunk_fxp_parse_pasv("227 Entering Passive Mode 192,168,1,2,4,1", numbers));
+    TEST_ASSERT_EQUAL_INT(192, numbers[0]);
+    TEST_ASSERT_EQUAL_INT(1, numbers[5]);
+}
+
+// Test that malformed PASV replies are rejected
+void test_fxp_parse_pasv_invalid(void) {
+    int numbers[6];
+    TEST_ASSERT_EQUAL(NETCHUNK_ERROR_INVALID_ARGUMENT, netchunk_fxp_parse_pasv(NULL, numbers));
+    TEST_ASSERT_EQUAL(NETCHUNK_ERROR_FTP, netchunk_fxp_parse_pasv("227 Entering Passive Mode", numbers));
+    TEST_ASSERT_EQUAL(NETCHUNK_ERROR_FTP, netchunk_fxp_parse_pasv("227 (10,0,0,5,195)", numbers));
+    TEST_ASSERT_EQUAL(NETCHUNK_ERROR_FTP, netchunk_fxp_parse_pasv("227 (10,0,0,256,195,80)", numbers));
+}
+
+// Test that copies between servers without FXP are refused up front
+void test_fxp_copy_invalid_args(void) {
+    target.fxp = false;
+    TEST_ASSERT_EQUAL(NETCHUNK_ERROR_INVALID_ARGUMENT,
+        netchunk_fxp_copy(&source, &target, "chunks/a.chunk", 1024, 30));
+
+    target.fxp = true;
+    TEST_ASSERT_EQUAL(NETCHUNK_ERROR_INVALID_ARGUMENT,
+        netchunk_fxp_copy(&source, &target, NULL, 1024, 30));
+    TEST_ASSERT_EQUAL(NETCHUNK_ERROR_INVALID_ARGUMENT,
+        netchunk_fxp_copy(&source, &target, "chunks/a.chunk", 1024, 0));
+}
+
+// Unity test runner
+int main(void) {
+    UNITY_BEGIN();
+
+    // Eligibility tests
+    RUN_TEST(test_fxp_supported);
+    RUN_TEST(test_fxp_copy_invalid_args);
+
+    // Reply parsing tests
+    RUN_TEST(test_fxp_parse_pasv);
+    RUN_TEST(test_fxp_parse_pasv_invalid);
+
+    return UNITY_END();
+}
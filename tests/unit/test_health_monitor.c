@@ -0,0 +1,218 @@
+#include "unity.h"
+#include "test_utils.h"
+#include "health_monitor.h"
+#include <pthread.h>
+#include <string.h>
+
+#define TEST_NOW ((time_t)1700000000)
+#define TEST_PUBLISH_ROUNDS 20000
+
+// Test data and fixtures
+static netchunk_config_t config;
+static netchunk_ftp_context_t ftp_context; // No engine; probes only reach the servers
+static netchunk_health_monitor_t monitor;
+
+void setUp(void) {
+    // Initialize test environment
+    test_setup_environment();
+
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_config_init_defaults(&config));
+    config.server_count = 2;
+    for (int i = 0; i < config.server_count; i++) {
+        snprintf(config.servers[i].id, sizeof(config.servers[i].id), "server_%d", i + 1);
+        strcpy(config.servers[i].host, "127.0.0.1");
+        config.servers[i].port = 1; // Nothing listens here
+        strcpy(config.servers[i].username, "test");
+        strcpy(config.servers[i].password, "test");
+        strcpy(config.servers[i].base_path, "/netchunk");
+        config.servers[i].passive_mode = true;
+    }
+
+    memset(&ftp_context, 0, sizeof(ftp_context));
+    ftp_context.config = &config;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_health_monitor_init(&monitor, &config, &ftp_context));
+}
+
+void tearDown(void) {
+    netchunk_health_monitor_cleanup(&monitor);
+
+    // Cleanup test environment
+    test_cleanup_environment();
+}
+
+// Helpers
+
+static void publish_round(uint64_t round) {
+    netchunk_health_snapshot_t snapshot;
+    memset(&snapshot, 0, sizeof(snapshot));
+    snapshot.server_count = NETCHUNK_MAX_SERVERS;
+    for (int i = 0; i < NETCHUNK_MAX_SERVERS; i++) {
+        snapshot.servers[i].bytes_used = round;
+        snapshot.servers[i].bytes_available = round;
+    }
+    netchunk_health_monitor_publish(&monitor, &snapshot);
+}
+
+static void* publisher_main(void* arg) {
+    (void)arg;
+    for (uint64_t round = 1; round <= TEST_PUBLISH_ROUNDS; round++) {
+        publish_round(round);
+    }
+    return NULL;
+}
+
+// Test that the free space is read from the AVBL reply only
+void test_parse_avbl_reply(void) {
+    const char* replies =
+        "220 Welcome\r\n"
+        "230 Logged in\r\n"
+        "257 \"/\" is the current directory\r\n"
+        "213 1073741824\r\n";
+
+    uint64_t bytes = 0;
+    TEST_ASSERT_TRUE(netchunk_ftp_parse_avbl_reply(replies, strlen(replies), &bytes));
+    TEST_ASSERT_EQUAL_UINT64(1073741824ULL, bytes);
+
+    const char* refused = "220 Welcome\r\n230 Logged in\r\n500 AVBL not understood\r\n";
+    TEST_ASSERT_FALSE(netchunk_ftp_parse_avbl_reply(refused, strlen(refused), &bytes));
+    TEST_ASSERT_FALSE(netchunk_ftp_parse_avbl_reply(NULL, 10, &bytes));
+}
+
+// Test how probe results map to a server status
+void test_health_classify(void) {
+    netchunk_server_health_t health;
+    memset(&health, 0, sizeof(health));
+    TEST_ASSERT_EQUAL(NETCHUNK_SERVER_UNKNOWN, netchunk_health_classify(&config, &health));
+
+    health.checked_at = TEST_NOW;
+    health.latency_ms = 20.0;
+    TEST_ASSERT_EQUAL(NETCHUNK_SERVER_AVAILABLE, netchunk_health_classify(&config, &health));
+
+    health.latency_ms = config.latency_alert_threshold + 1.0;
+    TEST_ASSERT_EQUAL(NETCHUNK_SERVER_DEGRADED, netchunk_health_classify(&config, &health));
+    health.latency_ms = 20.0;
+
+    // Full past storage_alert_threshold
+    health.bytes_used = (uint64_t)config.storage_alert_threshold;
+    health.bytes_available = 100 - (uint64_t)config.storage_alert_threshold;
+    TEST_ASSERT_EQUAL(NETCHUNK_SERVER_DEGRADED, netchunk_health_classify(&config, &health));
+    health.bytes_used = 10;
+    health.bytes_available = 90;
+    TEST_ASSERT_EQUAL(NETCHUNK_SERVER_AVAILABLE, netchunk_health_classify(&config, &health));
+
+    health.consecutive_failures = 1;
+    TEST_ASSERT_EQUAL(NETCHUNK_SERVER_DEGRADED, netchunk_health_classify(&config, &health));
+    health.consecutive_failures = NETCHUNK_HEALTH_FAILURE_LIMIT;
+    TEST_ASSERT_EQUAL(NETCHUNK_SERVER_UNAVAILABLE, netchunk_health_classify(&config, &health));
+}
+
+// Test that a published snapshot is read back and reaches the configuration on cleanup only
+void test_health_monitor_publish_and_read(void) {
+    // Nothing probed yet: every server may be used
+    TEST_ASSERT_TRUE(netchunk_health_monitor_usable(&monitor, 0));
+    TEST_ASSERT_TRUE(netchunk_health_monitor_usable(NULL, 0));
+
+    netchunk_health_snapshot_t snapshot;
+    memset(&snapshot, 0, sizeof(snapshot));
+    snapshot.server_count = 2;
+    snapshot.servers[0].status = NETCHUNK_SERVER_AVAILABLE;
+    snapshot.servers[0].latency_ms = 12.5;
+    snapshot.servers[0].bytes_available = 4096;
+    snapshot.servers[0].checked_at = TEST_NOW;
+    snapshot.servers[1].status = NETCHUNK_SERVER_UNAVAILABLE;
+    snapshot.servers[1].consecutive_failures = NETCHUNK_HEALTH_FAILURE_LIMIT;
+    snapshot.servers[1].checked_at = TEST_NOW;
+    netchunk_health_monitor_publish(&monitor, &snapshot);
+
+    netchunk_health_snapshot_t read;
+    netchunk_health_monitor_read(&monitor, &read);
+    TEST_ASSERT_EQUAL_UINT64(1, read.generation);
+    TEST_ASSERT_EQUAL_INT(2, read.server_count);
+    TEST_ASSERT_EQUAL_UINT64(4096, read.servers[0].bytes_available);
+
+    netchunk_server_health_t health;
+    TEST_ASSERT_TRUE(netchunk_health_monitor_read_server(&monitor, 1, &health));
+    TEST_ASSERT_EQUAL(NETCHUNK_SERVER_UNAVAILABLE, health.status);
+    TEST_ASSERT_FALSE(netchunk_health_monitor_read_server(&monitor, 2, &health));
+    TEST_ASSERT_FALSE(netchunk_health_monitor_read_server(&monitor, -1, &health));
+
+    TEST_ASSERT_TRUE(netchunk_health_monitor_usable(&monitor, 0));
+    TEST_ASSERT_FALSE(netchunk_health_monitor_usable(&monitor, 1));
+
+    // A published snapshot counts as a round, so nothing is probed
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_health_monitor_ensure_probed(&monitor));
+    netchunk_health_monitor_read(&monitor, &read);
+    TEST_ASSERT_EQUAL_UINT64(1, read.generation);
+
+    // Other threads read the configuration unlocked; it changes only once stopped
+    TEST_ASSERT_EQUAL(NETCHUNK_SERVER_UNKNOWN, config.servers[0].status);
+    TEST_ASSERT_EQUAL_UINT64(0, config.servers[0].bytes_available);
+
+    netchunk_health_monitor_cleanup(&monitor);
+    TEST_ASSERT_EQUAL(NETCHUNK_SERVER_AVAILABLE, config.servers[0].status);
+    TEST_ASSERT_EQUAL_UINT64(4096, config.servers[0].bytes_available);
+    TEST_ASSERT_EQUAL(NETCHUNK_SERVER_UNAVAILABLE, config.servers[1].status);
+    TEST_ASSERT_TRUE(config.servers[1].last_health_check == TEST_NOW);
+
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_health_monitor_init(&monitor, &config, &ftp_context));
+}
+
+// Test that servers that cannot be reached become unavailable
+void test_health_monitor_probe_unreachable(void) {
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_health_monitor_ensure_probed(&monitor));
+
+    netchunk_server_health_t health;
+    TEST_ASSERT_TRUE(netchunk_health_monitor_read_server(&monitor, 0, &health));
+    TEST_ASSERT_EQUAL_INT(1, health.consecutive_failures);
+    TEST_ASSERT_EQUAL(NETCHUNK_SERVER_DEGRADED, health.status);
+    TEST_ASSERT_TRUE(netchunk_health_monitor_usable(&monitor, 0));
+
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_health_monitor_probe_all(&monitor));
+    for (int i = 0; i < config.server_count; i++) {
+        TEST_ASSERT_TRUE(netchunk_health_monitor_read_server(&monitor, i, &health));
+        TEST_ASSERT_EQUAL(NETCHUNK_SERVER_UNAVAILABLE, health.status);
+        TEST_ASSERT_FALSE(netchunk_health_monitor_usable(&monitor, i));
+    }
+}
+
+// Test that readers never see a snapshot that is being replaced
+void test_health_monitor_concurrent_read(void) {
+    pthread_t publisher;
+    TEST_ASSERT_EQUAL_INT(0, pthread_create(&publisher, NULL, publisher_main, NULL));
+
+    uint64_t last_round = 0;
+    while (last_round < TEST_PUBLISH_ROUNDS) {
+        netchunk_health_snapshot_t snapshot;
+        netchunk_health_monitor_read(&monitor, &snapshot);
+
+        // Every field of one round carries the same value
+        uint64_t round = snapshot.servers[0].bytes_used;
+        for (int i = 0; i < NETCHUNK_MAX_SERVERS; i++) {
+            TEST_ASSERT_EQUAL_UINT64(round, snapshot.servers[i].bytes_used);
+            TEST_ASSERT_EQUAL_UINT64(round, snapshot.servers[i].bytes_available);
+        }
+        TEST_ASSERT_TRUE(round >= last_round);
+        TEST_ASSERT_EQUAL_UINT64(round, snapshot.generation);
+        last_round = round;
+    }
+
+    pthread_join(publisher, NULL);
+}
+
+// Unity test runner
+int main(void) {
+    UNITY_BEGIN();
+
+    // Reply parsing tests
+    RUN_TEST(test_parse_avbl_reply);
+
+    // Status tests
+    RUN_TEST(test_health_classify);
+
+    // Snapshot tests
+    RUN_TEST(test_health_monitor_publish_and_read);
+    RUN_TEST(test_health_monitor_probe_unreachable);
+    RUN_TEST(test_health_monitor_concurrent_read);
+
+    return UNITY_END();
+}
@@ -0,0 +1,253 @@
+#include "unity.h"
+#include "test_utils.h"
+#include "journal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define TEST_CHUNK_COUNT 500
+
+// Test data and fixtures
+static test_file_context_t test_files;
+static char journal_dir[TEST_MAX_PATH_LEN];
+
+void setUp(void) {
+    // Initialize test environment
+    test_setup_environment();
+
+    // Journals live in a directory created on first save
+    TEST_ASSERT_EQUAL_INT(0, create_temp_test_directory(&test_files));
+    snprintf(journal_dir, sizeof(journal_dir), "%s/data/%s", test_files.temp_dir, NETCHUNK_JOURNAL_DIRECTORY);
+}
+
+void tearDown(void) {
+    // Remove temporary test files
+    cleanup_temp_test_directory(&test_files);
+
+    // Cleanup test environment
+    test_cleanup_environment();
+}
+
+// Helpers
+
+static void make_chunk(netchunk_chunk_t* chunk, uint32_t sequence) {
+    memset(chunk, 0, sizeof(netchunk_chunk_t));
+    snprintf(chunk->id, sizeof(chunk->id), "%064x", sequence + 1);
+    chunk->sequence_number = sequence;
+    chunk->size = 4096;
+    chunk->offset = (size_t)sequence * 4096;
+    chunk->created_timestamp = 1700000000;
+
+    test_seed_random(sequence);
+    for (int i = 0; i < NETCHUNK_HASH_LENGTH; i++) {
+        chunk->hash[i] = (uint8_t)test_random_uint32();
+    }
+
+    chunk->location_count = 2;
+    strcpy(chunk->locations[0].server_id, "server1");
+    chunk->locations[0].upload_time = 1700000001;
+    strcpy(chunk->locations[1].server_id, "server3");
+    chunk->locations[1].upload_time = 1700000002;
+}
+
+// Test that committed upload chunks survive a save and load
+void test_journal_upload_round_trip(void) {
+    netchunk_journal_t journal;
+    netchunk_chunk_t chunk;
+
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS,
+        netchunk_journal_init(&journal, journal_dir, NETCHUNK_JOURNAL_UPLOAD, "big.bin", "/data/big.bin"));
+    TEST_ASSERT_EQUAL(NETCHUNK_ERROR_FILE_NOT_FOUND, netchunk_journal_load(&journal));
+    TEST_ASSERT_FALSE(netchunk_journal_has_progress(&journal));
+
+    journal.source_size = (uint64_t)TEST_CHUNK_COUNT * 4096;
+    journal.source_modified = 1700000000;
+    journal.chunk_size = 4096;
+    journal.chunking_mode = NETCHUNK_CHUNKING_CDC;
+    journal.content_addressed = true;
+
+    for (uint32_t i = 0; i < TEST_CHUNK_COUNT; i++) {
+        make_chunk(&chunk, i);
+        TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_journal_record_chunk(&journal, &chunk));
+    }
+    TEST_ASSERT_TRUE(journal.dirty);
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_journal_save(&journal));
+    TEST_ASSERT_FALSE(journal.dirty);
+    netchunk_journal_cleanup(&journal);
+
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS,
+        netchunk_journal_init(&journal, journal_dir, NETCHUNK_JOURNAL_UPLOAD, "big.bin", "/data/big.bin"));
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_journal_load(&journal));
+    TEST_ASSERT_EQUAL_UINT32(TEST_CHUNK_COUNT, journal.chunk_count);
+    TEST_ASSERT_EQUAL_UINT64((uint64_t)TEST_CHUNK_COUNT * 4096, journal.source_size);
+    TEST_ASSERT_EQUAL_INT64(1700000000, (int64_t)journal.source_modified);
+    TEST_ASSERT_EQUAL_size_t(4096, journal.chunk_size);
+    TEST_ASSERT_EQUAL(NETCHUNK_CHUNKING_CDC, journal.chunking_mode);
+    TEST_ASSERT_TRUE(journal.content_addressed);
+
+    for (uint32_t i = 0; i < TEST_CHUNK_COUNT; i += 97) {
+        make_chunk(&chunk, i);
+        const netchunk_chunk_t* loaded = netchunk_journal_find_chunk(&journal, i);
+        TEST_ASSERT_NOT_NULL(loaded);
+        TEST_ASSERT_EQUAL_STRING(chunk.id, loaded->id);
+        TEST_ASSERT_EQUAL_size_t(chunk.offset, loaded->offset);
+        TEST_ASSERT_EQUAL_MEMORY(chunk.hash, loaded->hash, NETCHUNK_HASH_LENGTH);
+        TEST_ASSERT_EQUAL_INT(2, loaded->location_count);
+        TEST_ASSERT_EQUAL_STRING("server3", loaded->locations[1].server_id);
+        TEST_ASSERT_EQUAL_INT64(1700000002, (int64_t)loaded->locations[1].upload_time);
+    }
+    TEST_ASSERT_NULL(netchunk_journal_find_chunk(&journal, TEST_CHUNK_COUNT));
+
+    // Discarding removes the file for good
+    netchunk_journal_discard(&journal);
+    netchunk_journal_cleanup(&journal);
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS,
+        netchunk_journal_init(&journal, journal_dir, NETCHUNK_JOURNAL_UPLOAD, "big.bin", "/data/big.bin"));
+    TEST_ASSERT_EQUAL(NETCHUNK_ERROR_FILE_NOT_FOUND, netchunk_journal_load(&journal));
+    netchunk_journal_cleanup(&journal);
+}
+
+// Test that chunks replace their own entry and cannot leave gaps
+void test_journal_record_chunk_order(void) {
+    netchunk_journal_t journal;
+    netchunk_chunk_t chunk;
+
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS,
+        netchunk_journal_init(&journal, journal_dir, NETCHUNK_JOURNAL_UPLOAD, "f", "/f"));
+
+    make_chunk(&chunk, 1);
+    TEST_ASSERT_EQUAL(NETCHUNK_ERROR_INVALID_ARGUMENT, netchunk_journal_record_chunk(&journal, &chunk));
+
+    make_chunk(&chunk, 0);
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_journal_record_chunk(&journal, &chunk));
+    make_chunk(&chunk, 1);
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_journal_record_chunk(&journal, &chunk));
+
+    // A retry re-commits chunk 0 with a different replica set
+    make_chunk(&chunk, 0);
+    chunk.location_count = 1;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_journal_record_chunk(&journal, &chunk));
+    TEST_ASSERT_EQUAL_UINT32(2, journal.chunk_count);
+    TEST_ASSERT_EQUAL_INT(1, netchunk_journal_find_chunk(&journal, 0)->location_count);
+
+    netchunk_journal_reset(&journal);
+    TEST_ASSERT_FALSE(netchunk_journal_has_progress(&journal));
+    TEST_ASSERT_NULL(netchunk_journal_find_chunk(&journal, 0));
+
+    netchunk_journal_cleanup(&journal);
+}
+
+// Test that download progress is stored as ranges and restored exactly
+void test_journal_download_round_trip(void) {
+    netchunk_journal_t journal;
+    uint8_t file_hash[NETCHUNK_HASH_LENGTH];
+
+    test_seed_random(7);
+    for (int i = 0; i < NETCHUNK_HASH_LENGTH; i++) {
+        file_hash[i] = (uint8_t)test_random_uint32();
+    }
+
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS,
+        netchunk_journal_init(&journal, journal_dir, NETCHUNK_JOURNAL_DOWNLOAD, "big.bin", "/tmp/out.bin"));
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_journal_set_chunk_count(&journal, TEST_CHUNK_COUNT));
+    strcpy(journal.manifest_id, "manifest-1234");
+    memcpy(journal.file_hash, file_hash, NETCHUNK_HASH_LENGTH);
+    journal.total_size = 123456789;
+
+    for (uint32_t i = 0; i < TEST_CHUNK_COUNT; i++) {
+        if (i % 7 != 3 && (i < 100 || i > 120)) {
+            netchunk_journal_set_completed(&journal, i, true);
+        }
+    }
+    netchunk_journal_set_completed(&journal, TEST_CHUNK_COUNT, true);
+    TEST_ASSERT_TRUE(netchunk_journal_has_progress(&journal));
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_journal_save(&journal));
+    netchunk_journal_cleanup(&journal);
+
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS,
+        netchunk_journal_init(&journal, journal_dir, NETCHUNK_JOURNAL_DOWNLOAD, "big.bin", "/tmp/out.bin"));
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_journal_load(&journal));
+    TEST_ASSERT_EQUAL_STRING("manifest-1234", journal.manifest_id);
+    TEST_ASSERT_EQUAL_MEMORY(file_hash, journal.file_hash, NETCHUNK_HASH_LENGTH);
+    TEST_ASSERT_EQUAL_UINT64(123456789, journal.total_size);
+    TEST_ASSERT_EQUAL_UINT32(TEST_CHUNK_COUNT, journal.completed_length);
+
+    for (uint32_t i = 0; i < TEST_CHUNK_COUNT; i++) {
+        bool expected = i % 7 != 3 && (i < 100 || i > 120);
+        TEST_ASSERT_EQUAL(expected, netchunk_journal_is_completed(&journal, i));
+    }
+    TEST_ASSERT_FALSE(netchunk_journal_is_completed(&journal, TEST_CHUNK_COUNT));
+
+    netchunk_journal_discard(&journal);
+    netchunk_journal_cleanup(&journal);
+}
+
+// Test that each transfer gets its own journal
+void test_journal_keys(void) {
+    netchunk_journal_t upload;
+    netchunk_journal_t download;
+    netchunk_journal_t other;
+
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS,
+        netchunk_journal_init(&upload, journal_dir, NETCHUNK_JOURNAL_UPLOAD, "a.bin", "/x/a.bin"));
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS,
+        netchunk_journal_init(&download, journal_dir, NETCHUNK_JOURNAL_DOWNLOAD, "a.bin", "/x/a.bin"));
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS,
+        netchunk_journal_init(&other, journal_dir, NETCHUNK_JOURNAL_UPLOAD, "a.bin", "/y/a.bin"));
+
+    TEST_ASSERT_TRUE(strcmp(upload.path, download.path) != 0);
+    TEST_ASSERT_TRUE(strcmp(upload.path, other.path) != 0);
+    TEST_ASSERT_EQUAL_INT(0, strncmp(upload.path, journal_dir, strlen(journal_dir)));
+
+    // A journal saved for one transfer is never loaded for another
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_journal_save(&upload));
+    strcpy(other.path, upload.path);
+    TEST_ASSERT_EQUAL(NETCHUNK_ERROR_MANIFEST_CORRUPT, netchunk_journal_load(&other));
+
+    netchunk_journal_discard(&upload);
+    netchunk_journal_cleanup(&upload);
+    netchunk_journal_cleanup(&download);
+    netchunk_journal_cleanup(&other);
+}
+
+// Test that a damaged journal is reported rather than half loaded
+void test_journal_corrupt_file(void) {
+    netchunk_journal_t journal;
+
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS,
+        netchunk_journal_init(&journal, journal_dir, NETCHUNK_JOURNAL_DOWNLOAD, "a.bin", "/x/a.bin"));
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_journal_set_chunk_count(&journal, 4));
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_journal_save(&journal));
+
+    FILE* file = fopen(journal.path, "w");
+    TEST_ASSERT_NOT_NULL(file);
+    fputs("{\"operation\":\"download\",\"remote_name\":\"a.bin\",\"local_path\":\"/x/a.bin\","
+          "\"manifest_id\":\"m\",\"file_hash\":\"00\",\"total_size\":1,\"chunk_count\":4,\"completed\":[[0,9]]}",
+        file);
+    fclose(file);
+
+    TEST_ASSERT_EQUAL(NETCHUNK_ERROR_MANIFEST_CORRUPT, netchunk_journal_load(&journal));
+    TEST_ASSERT_FALSE(netchunk_journal_has_progress(&journal));
+
+    netchunk_journal_discard(&journal);
+    netchunk_journal_cleanup(&journal);
+}
+
+// Unity test runner
+int main(void) {
+    UNITY_BEGIN();
+
+    // Upload journal tests
+    RUN_TEST(test_journal_upload_round_trip);
+    RUN_TEST(test_journal_record_chunk_order);
+
+    // Download journal tests
+    RUN_TEST(test_journal_download_round_trip);
+
+    // File handling tests
+    RUN_TEST(test_journal_keys);
+    RUN_TEST(test_journal_corrupt_file);
+
+    return UNITY_END();
+}
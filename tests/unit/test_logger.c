@@ -0,0 +1,210 @@
+#include "unity.h"
+#include "test_utils.h"
+#include "logger.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TEST_THREADS 8
+#define TEST_LINES_PER_THREAD 2000
+
+// Test data and fixtures
+static test_file_context_t test_files;
+static netchunk_logger_context_t logger;
+static netchunk_logger_config_t config;
+static char log_path[TEST_MAX_PATH_LEN];
+static int argument_evaluations;
+
+void setUp(void) {
+    // Initialize test environment
+    test_setup_environment();
+
+    // Create temporary directory for the log files
+    TEST_ASSERT_EQUAL_INT(0, create_temp_test_directory(&test_files));
+    snprintf(log_path, sizeof(log_path), "%s/netchunk.log", test_files.temp_dir);
+
+    memset(&config, 0, sizeof(config));
+    strcpy(config.log_file_path, log_path);
+    config.level = NETCHUNK_LOG_INFO;
+    config.log_to_file = true;
+    config.max_file_size = 10 * 1024 * 1024;
+    config.max_backup_files = 3;
+    config.include_timestamp = true;
+    config.include_level = true;
+    config.async_queue_lines = 1024;
+
+    argument_evaluations = 0;
+}
+
+void tearDown(void) {
+    netchunk_logger_cleanup(&logger);
+
+    // Remove temporary test files
+    cleanup_temp_test_directory(&test_files);
+
+    // Cleanup test environment
+    test_cleanup_environment();
+}
+
+// Helpers
+
+static char* read_log(const char* path) {
+    FILE* file = fopen(path, "r");
+    TEST_ASSERT_NOT_NULL(file);
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    char* text = malloc((size_t)size + 1);
+    TEST_ASSERT_NOT_NULL(text);
+    TEST_ASSERT_EQUAL_size_t((size_t)size, fread(text, 1, (size_t)size, file));
+    text[size] = '\0';
+    fclose(file);
+    return text;
+}
+
+static int counted_argument(void) {
+    return ++argument_evaluations;
+}
+
+static void* log_lines_main(void* arg) {
+    int thread = (int)(intptr_t)arg;
+    for (int i = 0; i < TEST_LINES_PER_THREAD; i++) {
+        NETCHUNK_LOG_INFO_MSG(&logger, "thread %d line %d", thread, i);
+    }
+    return NULL;
+}
+
+// Test that lines are written with their prefix and filtered by level
+void test_logger_sync_writes_lines(void) {
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_logger_init(&logger, &config));
+
+    NETCHUNK_LOG_INFO_MSG(&logger, "hello %d", 42);
+    NETCHUNK_LOG_DEBUG_MSG(&logger, "hidden");
+    netchunk_logger_flush(&logger);
+
+    char* text = read_log(log_path);
+    TEST_ASSERT_NOT_NULL(strstr(text, " [INFO ]: hello 42\n"));
+    TEST_ASSERT_NULL(strstr(text, "hidden"));
+    // "YYYY-MM-DD HH:MM:SS " before the level
+    TEST_ASSERT_EQUAL_INT('[', text[20]);
+    free(text);
+}
+
+// Test that filtered messages do not evaluate their arguments
+void test_logger_level_check_skips_arguments(void) {
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_logger_init(&logger, &config));
+
+    NETCHUNK_LOG_DEBUG_MSG(&logger, "value %d", counted_argument());
+    TEST_ASSERT_EQUAL_INT(0, argument_evaluations);
+
+    NETCHUNK_LOG_INFO_MSG(&logger, "value %d", counted_argument());
+    TEST_ASSERT_EQUAL_INT(1, argument_evaluations);
+
+    TEST_ASSERT_FALSE(netchunk_logger_enabled(NULL, NETCHUNK_LOG_ERROR));
+    TEST_ASSERT_TRUE(netchunk_logger_enabled(&logger, NETCHUNK_LOG_WARN));
+}
+
+// Test that lines from many threads all arrive whole and in order per thread
+void test_logger_async_many_threads(void) {
+    config.async = true;
+    config.async_queue_lines = TEST_THREADS * TEST_LINES_PER_THREAD;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_logger_init(&logger, &config));
+
+    pthread_t threads[TEST_THREADS];
+    for (int t = 0; t < TEST_THREADS; t++) {
+        TEST_ASSERT_EQUAL_INT(0, pthread_create(&threads[t], NULL, log_lines_main, (void*)(intptr_t)t));
+    }
+    for (int t = 0; t < TEST_THREADS; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    netchunk_logger_flush(&logger);
+    TEST_ASSERT_EQUAL_UINT64(0, netchunk_logger_dropped(&logger));
+
+    char* text = read_log(log_path);
+    int next_line[TEST_THREADS] = { 0 };
+    int lines = 0;
+    for (char* line = strtok(text, "\n"); line; line = strtok(NULL, "\n")) {
+        int thread, number;
+        const char* message = strstr(line, "]: ");
+        TEST_ASSERT_NOT_NULL(message);
+        TEST_ASSERT_EQUAL_INT(2, sscanf(message, "]: thread %d line %d", &thread, &number));
+        TEST_ASSERT_TRUE(thread >= 0 && thread < TEST_THREADS);
+        TEST_ASSERT_EQUAL_INT(next_line[thread], number);
+        next_line[thread]++;
+        lines++;
+    }
+    TEST_ASSERT_EQUAL_INT(TEST_THREADS * TEST_LINES_PER_THREAD, lines);
+    free(text);
+}
+
+// Test that a full queue drops lines and says so instead of blocking
+void test_logger_async_drops_when_full(void) {
+    config.async = true;
+    config.async_queue_lines = 2;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_logger_init(&logger, &config));
+
+    pthread_t threads[TEST_THREADS];
+    for (int t = 0; t < TEST_THREADS; t++) {
+        TEST_ASSERT_EQUAL_INT(0, pthread_create(&threads[t], NULL, log_lines_main, (void*)(intptr_t)t));
+    }
+    for (int t = 0; t < TEST_THREADS; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    NETCHUNK_LOG_ERROR_MSG(&logger, "last");
+    netchunk_logger_cleanup(&logger);
+
+    uint64_t dropped = netchunk_logger_dropped(&logger);
+    char* text = read_log(log_path);
+    int lines = 0;
+    for (char* line = strstr(text, "thread "); line; line = strstr(line + 1, "thread ")) {
+        lines++;
+    }
+    TEST_ASSERT_EQUAL_UINT64(TEST_THREADS * TEST_LINES_PER_THREAD, (uint64_t)lines + dropped);
+    if (dropped > 0) {
+        TEST_ASSERT_NOT_NULL(strstr(text, "log messages dropped"));
+    }
+    // Errors wait for room rather than being dropped
+    TEST_ASSERT_NOT_NULL(strstr(text, "[ERROR]: last\n"));
+    free(text);
+}
+
+// Test that the writer rotates between lines and keeps files under the limit
+void test_logger_async_rotation(void) {
+    config.async = true;
+    config.max_file_size = 4096;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_logger_init(&logger, &config));
+
+    for (int i = 0; i < 300; i++) {
+        NETCHUNK_LOG_INFO_MSG(&logger, "rotation line %d", i);
+    }
+    netchunk_logger_flush(&logger);
+
+    char backup_path[TEST_MAX_PATH_LEN + 8];
+    snprintf(backup_path, sizeof(backup_path), "%s.1", log_path);
+    TEST_ASSERT_TRUE(file_exists(backup_path));
+    TEST_ASSERT_TRUE(get_file_size(backup_path) <= 4096);
+    TEST_ASSERT_TRUE(get_file_size(log_path) <= 4096);
+
+    // The newest line ends the current file whole
+    char* text = read_log(log_path);
+    TEST_ASSERT_NOT_NULL(strstr(text, ": rotation line 299\n"));
+    free(text);
+}
+
+// Unity test runner
+int main(void) {
+    UNITY_BEGIN();
+
+    // Synchronous logging tests
+    RUN_TEST(test_logger_sync_writes_lines);
+    RUN_TEST(test_logger_level_check_skips_arguments);
+
+    // Asynchronous logging tests
+    RUN_TEST(test_logger_async_many_threads);
+    RUN_TEST(test_logger_async_drops_when_full);
+    RUN_TEST(test_logger_async_rotation);
+
+    return UNITY_END();
+}
@@ -0,0 +1,430 @@
+#include "unity.h"
+#include "test_utils.h"
+#include "erasure.h"
+#include "manifest.h"
+#include "manifest_pack.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TEST_CHUNK_COUNT 1000
+
+// Test data and fixtures
+static test_file_context_t test_files;
+static netchunk_file_manifest_t test_manifest;
+
+void setUp(void) {
+    // Initialize test environment
+    test_setup_environment();
+
+    // Create temporary directory for manifest files
+    TEST_ASSERT_EQUAL_INT(0, create_temp_test_directory(&test_files));
+
+    memset(&test_manifest, 0, sizeof(test_manifest));
+}
+
+void tearDown(void) {
+    netchunk_file_manifest_cleanup(&test_manifest);
+
+    // Remove temporary test files
+    cleanup_temp_test_directory(&test_files);
+
+    // Cleanup test environment
+    test_cleanup_environment();
+}
+
+// Helpers
+
+static void build_manifest(netchunk_file_manifest_t* manifest, uint32_t chunk_count) {
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_manifest_init(manifest, "backup.tar", (size_t)chunk_count * 4096));
+    manifest->chunk_size = 4096;
+    manifest->replication_factor = 2;
+    strcpy(manifest->comment, "packed manifest test");
+
+    const char* servers[] = { "server1", "server2", "server3" };
+    for (uint32_t i = 0; i < chunk_count; i++) {
+        netchunk_chunk_t chunk;
+        memset(&chunk, 0, sizeof(chunk));
+
+        test_seed_random(i);
+        for (int b = 0; b < NETCHUNK_HASH_LENGTH; b++) {
+            chunk.hash[b] = (uint8_t)test_random_uint32();
+        }
+        chunk.size = 4096 - (i % 7);
+        chunk.offset = (size_t)i * 4096;
+        chunk.sequence_number = i;
+        chunk.created_timestamp = 1700000000 + i;
+
+        // Mix random and content-addressed IDs
+        if (i % 2 == 0) {
+            snprintf(chunk.id, sizeof(chunk.id), "%08x%08x", i, 0xabcdu);
+        } else {
+            TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_chunk_set_content_id(&chunk));
+        }
+
+        for (uint32_t r = 0; r < 2; r++) {
+            netchunk_chunk_location_t* location = &chunk.locations[chunk.location_count++];
+            strcpy(location->server_id, servers[(i + r) % 3]);
+            location->upload_time = 1700000000 + i + r;
+            location->verified = (i % 3) == 0;
+        }
+
+        TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_manifest_add_chunk(manifest, &chunk));
+    }
+}
+
+// A fixture netchunk_manifest_validate() accepts: full chunks back to back and a short last one
+static void build_valid_manifest(netchunk_file_manifest_t* manifest, uint32_t chunk_count) {
+    build_manifest(manifest, chunk_count);
+    manifest->chunk_size = NETCHUNK_MIN_CHUNK_SIZE;
+
+    size_t offset = 0;
+    for (uint32_t i = 0; i < chunk_count; i++) {
+        netchunk_chunk_t* chunk = &manifest->chunks[i];
+        chunk->size = i + 1 < chunk_count ? NETCHUNK_MIN_CHUNK_SIZE : NETCHUNK_MIN_CHUNK_SIZE / 2 + 123;
+        chunk->offset = offset;
+        offset += chunk->size;
+    }
+    manifest->total_size = offset;
+}
+
+static void assert_chunks_equal(const netchunk_chunk_t* expected, const netchunk_chunk_t* actual) {
+    TEST_ASSERT_EQUAL_STRING(expected->id, actual->id);
+    TEST_ASSERT_EQUAL_MEMORY(expected->hash, actual->hash, NETCHUNK_HASH_LENGTH);
+    TEST_ASSERT_EQUAL_size_t(expected->size, actual->size);
+    TEST_ASSERT_EQUAL_size_t(expected->offset, actual->offset);
+    TEST_ASSERT_EQUAL_UINT32(expected->sequence_number, actual->sequence_number);
+    TEST_ASSERT_EQUAL(expected->codec, actual->codec);
+    TEST_ASSERT_EQUAL_MEMORY(expected->key_id, actual->key_id, NETCHUNK_KEY_ID_LENGTH);
+    TEST_ASSERT_EQUAL_size_t(expected->stored_size, actual->stored_size);
+    TEST_ASSERT_EQUAL_INT(expected->location_count, actual->location_count);
+    for (int l = 0; l < expected->location_count; l++) {
+        TEST_ASSERT_EQUAL_STRING(expected->locations[l].server_id, actual->locations[l].server_id);
+        TEST_ASSERT_EQUAL_INT64(expected->locations[l].upload_time, actual->locations[l].upload_time);
+        TEST_ASSERT_EQUAL(expected->locations[l].verified, actual->locations[l].verified);
+    }
+}
+
+// Test that chunks added to a manifest keep metadata only
+void test_manifest_add_chunk_drops_payload(void) {
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_manifest_init(&test_manifest, "file.bin", 100));
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_manifest_reserve_chunks(&test_manifest, 4));
+    TEST_ASSERT_EQUAL_UINT32(4, test_manifest.chunk_capacity);
+
+    uint8_t payload[100] = { 0 };
+    netchunk_chunk_t chunk;
+    memset(&chunk, 0, sizeof(chunk));
+    chunk.data = payload;
+    chunk.size = sizeof(payload);
+
+    for (int i = 0; i < 40; i++) {
+        chunk.sequence_number = (uint32_t)i;
+        TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_manifest_add_chunk(&test_manifest, &chunk));
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(40, test_manifest.chunk_count);
+    TEST_ASSERT_TRUE(test_manifest.chunk_capacity >= 40);
+    for (uint32_t i = 0; i < test_manifest.chunk_count; i++) {
+        TEST_ASSERT_NULL(test_manifest.chunks[i].data);
+        TEST_ASSERT_EQUAL_UINT32(i, test_manifest.chunks[i].sequence_number);
+    }
+}
+
+// Test that packing and unpacking preserves every field
+void test_manifest_pack_round_trip(void) {
+    build_manifest(&test_manifest, TEST_CHUNK_COUNT);
+
+    netchunk_packed_manifest_t packed;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_manifest_pack(&test_manifest, &packed));
+    TEST_ASSERT_EQUAL_UINT32(TEST_CHUNK_COUNT, packed.chunk_count);
+    TEST_ASSERT_EQUAL_UINT32(3, packed.server_count);
+    TEST_ASSERT_EQUAL_STRING("backup.tar", packed.original_filename);
+
+    // Far smaller than the in-memory chunk array
+    TEST_ASSERT_TRUE(packed.size < TEST_CHUNK_COUNT * 200);
+
+    netchunk_file_manifest_t unpacked;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_packed_manifest_unpack(&packed, &unpacked));
+    TEST_ASSERT_EQUAL_STRING(test_manifest.manifest_id, unpacked.manifest_id);
+    TEST_ASSERT_EQUAL_STRING(test_manifest.comment, unpacked.comment);
+    TEST_ASSERT_EQUAL_size_t(test_manifest.total_size, unpacked.total_size);
+    TEST_ASSERT_EQUAL_UINT32(test_manifest.chunk_count, unpacked.chunk_count);
+    TEST_ASSERT_EQUAL_INT(test_manifest.replication_factor, unpacked.replication_factor);
+
+    for (uint32_t i = 0; i < test_manifest.chunk_count; i++) {
+        assert_chunks_equal(&test_manifest.chunks[i], &unpacked.chunks[i]);
+    }
+
+    netchunk_file_manifest_cleanup(&unpacked);
+    netchunk_packed_manifest_close(&packed);
+}
+
+// Test saving, mapping and lazily expanding single chunks
+void test_manifest_pack_save_and_open(void) {
+    build_manifest(&test_manifest, TEST_CHUNK_COUNT);
+
+    char path[TEST_MAX_PATH_LEN];
+    snprintf(path, sizeof(path), "%s/backup.netchunk", test_files.temp_dir);
+
+    netchunk_packed_manifest_t packed;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_manifest_pack(&test_manifest, &packed));
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_packed_manifest_save(&packed, path));
+    netchunk_packed_manifest_close(&packed);
+
+    netchunk_packed_manifest_t mapped;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_packed_manifest_open(&mapped, path));
+    TEST_ASSERT_NOT_NULL(mapped.mapping);
+    TEST_ASSERT_EQUAL_UINT32(TEST_CHUNK_COUNT, mapped.chunk_count);
+
+    uint32_t picks[] = { 0, 1, 499, TEST_CHUNK_COUNT - 1 };
+    for (int p = 0; p < 4; p++) {
+        netchunk_chunk_t chunk;
+        TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_packed_manifest_get_chunk(&mapped, picks[p], &chunk));
+        assert_chunks_equal(&test_manifest.chunks[picks[p]], &chunk);
+    }
+
+    netchunk_chunk_t chunk;
+    TEST_ASSERT_EQUAL(NETCHUNK_ERROR_INVALID_ARGUMENT, netchunk_packed_manifest_get_chunk(&mapped, TEST_CHUNK_COUNT, &chunk));
+
+    netchunk_packed_manifest_close(&mapped);
+}
+
+// Test that damaged packed manifests are rejected
+void test_manifest_pack_rejects_corruption(void) {
+    build_manifest(&test_manifest, 10);
+
+    netchunk_packed_manifest_t packed;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_manifest_pack(&test_manifest, &packed));
+    TEST_ASSERT_TRUE(netchunk_packed_manifest_detect(packed.base, packed.size));
+
+    uint8_t* copy = malloc(packed.size);
+    TEST_ASSERT_NOT_NULL(copy);
+    memcpy(copy, packed.base, packed.size);
+
+    netchunk_packed_manifest_t loaded;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_packed_manifest_from_buffer(&loaded, copy, packed.size));
+    netchunk_packed_manifest_close(&loaded);
+
+    // Truncated
+    TEST_ASSERT_EQUAL(NETCHUNK_ERROR_MANIFEST_CORRUPT, netchunk_packed_manifest_from_buffer(&loaded, copy, packed.size - 8));
+
+    // Unknown version
+    copy[8] = 99;
+    TEST_ASSERT_EQUAL(NETCHUNK_ERROR_MANIFEST_CORRUPT, netchunk_packed_manifest_from_buffer(&loaded, copy, packed.size));
+
+    // Not a packed manifest at all
+    const char* json = "{\"version\": \"1.0\"}";
+    TEST_ASSERT_FALSE(netchunk_packed_manifest_detect(json, strlen(json)));
+    TEST_ASSERT_EQUAL(NETCHUNK_ERROR_MANIFEST_CORRUPT, netchunk_packed_manifest_from_buffer(&loaded, json, strlen(json)));
+
+    free(copy);
+    netchunk_packed_manifest_close(&packed);
+}
+
+// Test that erasure-coded manifests keep their stripe layout and parity when packed
+void test_manifest_pack_erasure_coded(void) {
+    build_manifest(&test_manifest, 10);
+    test_manifest.ec_data_shards = 4;
+    test_manifest.ec_parity_shards = 2;
+
+    // Three stripes, the last one short
+    for (uint32_t i = 0; i < 6; i++) {
+        netchunk_chunk_t parity;
+        memset(&parity, 0, sizeof(parity));
+        snprintf(parity.id, sizeof(parity.id), "%08x%08x", i | NETCHUNK_EC_PARITY_ID_FLAG, 0xabcdu);
+        memset(parity.hash, (int)i + 1, NETCHUNK_HASH_LENGTH);
+        parity.size = 4096;
+        parity.sequence_number = i;
+        netchunk_chunk_location_t* location = &parity.locations[parity.location_count++];
+        strcpy(location->server_id, "server4");
+        location->upload_time = 1700000100 + i;
+        TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_manifest_add_parity_chunk(&test_manifest, &parity));
+    }
+
+    TEST_ASSERT_TRUE(netchunk_manifest_is_erasure_coded(&test_manifest));
+    TEST_ASSERT_EQUAL_UINT32(3, netchunk_manifest_stripe_count(&test_manifest));
+    TEST_ASSERT_EQUAL_PTR(&test_manifest.chunks[9], netchunk_manifest_stripe_shard(&test_manifest, 2, 1));
+    TEST_ASSERT_NULL(netchunk_manifest_stripe_shard(&test_manifest, 2, 2));
+    TEST_ASSERT_EQUAL_PTR(&test_manifest.parity_chunks[5], netchunk_manifest_stripe_shard(&test_manifest, 2, 5));
+
+    netchunk_packed_manifest_t packed;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_manifest_pack(&test_manifest, &packed));
+    TEST_ASSERT_EQUAL_UINT32(10, packed.chunk_count);
+    TEST_ASSERT_EQUAL_UINT32(6, packed.parity_count);
+    TEST_ASSERT_EQUAL_UINT32(4, packed.server_count);
+
+    netchunk_chunk_t chunk;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_packed_manifest_get_parity_chunk(&packed, 3, &chunk));
+    assert_chunks_equal(&test_manifest.parity_chunks[3], &chunk);
+    TEST_ASSERT_EQUAL(NETCHUNK_ERROR_INVALID_ARGUMENT, netchunk_packed_manifest_get_parity_chunk(&packed, 6, &chunk));
+
+    netchunk_file_manifest_t unpacked;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_packed_manifest_unpack(&packed, &unpacked));
+    TEST_ASSERT_EQUAL_INT(4, unpacked.ec_data_shards);
+    TEST_ASSERT_EQUAL_INT(2, unpacked.ec_parity_shards);
+    TEST_ASSERT_EQUAL_UINT32(6, unpacked.parity_count);
+    for (uint32_t i = 0; i < unpacked.parity_count; i++) {
+        assert_chunks_equal(&test_manifest.parity_chunks[i], &unpacked.parity_chunks[i]);
+    }
+    assert_chunks_equal(&test_manifest.chunks[9], &unpacked.chunks[9]);
+    netchunk_file_manifest_cleanup(&unpacked);
+
+    // JSON carries the same layout
+    char* json;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_file_manifest_to_json(&test_manifest, &json));
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_file_manifest_from_json(json, &unpacked));
+    TEST_ASSERT_EQUAL_UINT32(6, unpacked.parity_count);
+    assert_chunks_equal(&test_manifest.parity_chunks[5], &unpacked.parity_chunks[5]);
+    netchunk_file_manifest_cleanup(&unpacked);
+    free(json);
+
+    netchunk_packed_manifest_close(&packed);
+}
+
+// Test that compressed chunks keep their codec and stored size in both formats
+void test_manifest_pack_compressed(void) {
+    build_manifest(&test_manifest, 10);
+
+    // Plain manifests stay readable by older readers
+    netchunk_packed_manifest_t packed;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_manifest_pack(&test_manifest, &packed));
+    TEST_ASSERT_NULL(packed.codecs);
+    netchunk_packed_manifest_close(&packed);
+
+    for (uint32_t i = 0; i < test_manifest.chunk_count; i += 3) {
+        test_manifest.chunks[i].codec = NETCHUNK_COMPRESSION_ZSTD;
+        test_manifest.chunks[i].stored_size = 1000 + i;
+    }
+
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_manifest_pack(&test_manifest, &packed));
+    TEST_ASSERT_NOT_NULL(packed.codecs);
+    TEST_ASSERT_NULL(packed.key_ids);
+
+    netchunk_chunk_t chunk;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_packed_manifest_get_chunk(&packed, 3, &chunk));
+    assert_chunks_equal(&test_manifest.chunks[3], &chunk);
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_packed_manifest_get_chunk(&packed, 4, &chunk));
+    TEST_ASSERT_EQUAL(NETCHUNK_COMPRESSION_NONE, chunk.codec);
+
+    netchunk_file_manifest_t unpacked;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_packed_manifest_unpack(&packed, &unpacked));
+    for (uint32_t i = 0; i < unpacked.chunk_count; i++) {
+        assert_chunks_equal(&test_manifest.chunks[i], &unpacked.chunks[i]);
+    }
+    netchunk_file_manifest_cleanup(&unpacked);
+    netchunk_packed_manifest_close(&packed);
+
+    char* json;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_file_manifest_to_json(&test_manifest, &json));
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_file_manifest_from_json(json, &unpacked));
+    for (uint32_t i = 0; i < unpacked.chunk_count; i++) {
+        assert_chunks_equal(&test_manifest.chunks[i], &unpacked.chunks[i]);
+    }
+    netchunk_file_manifest_cleanup(&unpacked);
+    free(json);
+}
+
+// Test that encrypted chunks keep their key ID and stored size in both formats
+void test_manifest_pack_encrypted(void) {
+    static const uint8_t key_id[NETCHUNK_KEY_ID_LENGTH] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+    build_valid_manifest(&test_manifest, 10);
+
+    for (uint32_t i = 0; i < test_manifest.chunk_count; i += 2) {
+        netchunk_chunk_t* chunk = &test_manifest.chunks[i];
+        memcpy(chunk->key_id, key_id, NETCHUNK_KEY_ID_LENGTH);
+        chunk->stored_size = chunk->size + NETCHUNK_CIPHER_OVERHEAD;
+    }
+    test_manifest.chunks[4].codec = NETCHUNK_COMPRESSION_ZSTD;
+    test_manifest.chunks[4].stored_size = 500 + NETCHUNK_CIPHER_OVERHEAD;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_manifest_validate(&test_manifest));
+
+    netchunk_packed_manifest_t packed;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_manifest_pack(&test_manifest, &packed));
+    TEST_ASSERT_NOT_NULL(packed.key_ids);
+
+    netchunk_file_manifest_t unpacked;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_packed_manifest_unpack(&packed, &unpacked));
+    for (uint32_t i = 0; i < unpacked.chunk_count; i++) {
+        assert_chunks_equal(&test_manifest.chunks[i], &unpacked.chunks[i]);
+    }
+    netchunk_file_manifest_cleanup(&unpacked);
+    netchunk_packed_manifest_close(&packed);
+
+    char* json;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_file_manifest_to_json(&test_manifest, &json));
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_file_manifest_from_json(json, &unpacked));
+    for (uint32_t i = 0; i < unpacked.chunk_count; i++) {
+        assert_chunks_equal(&test_manifest.chunks[i], &unpacked.chunks[i]);
+    }
+    netchunk_file_manifest_cleanup(&unpacked);
+    free(json);
+
+    // A compressed chunk still needs a byte besides the cipher trailer
+    test_manifest.chunks[4].stored_size = NETCHUNK_CIPHER_OVERHEAD;
+    TEST_ASSERT_EQUAL(NETCHUNK_ERROR_MANIFEST_CORRUPT, netchunk_manifest_validate(&test_manifest));
+    test_manifest.chunks[4].stored_size = 500 + NETCHUNK_CIPHER_OVERHEAD;
+
+    // An uncompressed chunk is stored exactly one cipher trailer larger
+    test_manifest.chunks[2].stored_size = test_manifest.chunks[2].size;
+    TEST_ASSERT_EQUAL(NETCHUNK_ERROR_MANIFEST_CORRUPT, netchunk_manifest_validate(&test_manifest));
+}
+
+// Test that the manifest manager stores packed manifests and still reads JSON
+void test_manifest_manager_formats(void) {
+    netchunk_config_t config;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_config_init_defaults(&config));
+
+    netchunk_manifest_manager_t manager;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_manifest_manager_init(&manager, test_files.temp_dir, &config));
+    manager.auto_backup = false;
+
+    build_manifest(&test_manifest, 50);
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_manifest_save_to_file(&manager, &test_manifest, "packed"));
+
+    netchunk_file_manifest_t loaded;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_manifest_load_from_file(&manager, "packed", &loaded));
+    TEST_ASSERT_EQUAL_UINT32(50, loaded.chunk_count);
+    assert_chunks_equal(&test_manifest.chunks[49], &loaded.chunks[49]);
+    netchunk_file_manifest_cleanup(&loaded);
+
+    // JSON export still loads, and carries the derived remote paths
+    char* json;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_file_manifest_to_json(&test_manifest, &json));
+    TEST_ASSERT_NOT_NULL(strstr(json, "\"remote_path\""));
+
+    char path[TEST_MAX_PATH_LEN];
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_manifest_build_path(&manager, "exported", path, sizeof(path)));
+    FILE* file = fopen(path, "w");
+    TEST_ASSERT_NOT_NULL(file);
+    fputs(json, file);
+    fclose(file);
+    free(json);
+
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_manifest_load_from_file(&manager, "exported", &loaded));
+    TEST_ASSERT_EQUAL_UINT32(50, loaded.chunk_count);
+    assert_chunks_equal(&test_manifest.chunks[10], &loaded.chunks[10]);
+    netchunk_file_manifest_cleanup(&loaded);
+
+    netchunk_manifest_manager_cleanup(&manager);
+}
+
+// Unity test runner
+int main(void) {
+    UNITY_BEGIN();
+
+    // Manifest construction tests
+    RUN_TEST(test_manifest_add_chunk_drops_payload);
+
+    // Packed format tests
+    RUN_TEST(test_manifest_pack_round_trip);
+    RUN_TEST(test_manifest_pack_save_and_open);
+    RUN_TEST(test_manifest_pack_rejects_corruption);
+    RUN_TEST(test_manifest_pack_erasure_coded);
+    RUN_TEST(test_manifest_pack_compressed);
+    RUN_TEST(test_manifest_pack_encrypted);
+
+    // Storage tests
+    RUN_TEST(test_manifest_manager_formats);
+
+    return UNITY_END();
+}
@@ -0,0 +1,266 @@
+#include "unity.h"
+#include "test_utils.h"
+#include "chunker.h"
+#include "metrics.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TEST_THREADS 8
+#define TEST_RECORDS_PER_THREAD 10000
+
+// Test data and fixtures
+static test_file_context_t test_files;
+static netchunk_config_t config;
+static netchunk_metrics_t metrics;
+
+void setUp(void) {
+    // Initialize test environment
+    test_setup_environment();
+
+    // Create temporary directory for the dumps
+    TEST_ASSERT_EQUAL_INT(0, create_temp_test_directory(&test_files));
+
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_config_init_defaults(&config));
+    config.server_count = 2;
+    strcpy(config.servers[0].id, "server_1");
+    strcpy(config.servers[1].id, "quote\"d");
+    config.performance_logging = true;
+    snprintf(config.monitoring_data_path, sizeof(config.monitoring_data_path), "%s/monitoring/data",
+        test_files.temp_dir);
+
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_metrics_init(&metrics, &config));
+}
+
+void tearDown(void) {
+    netchunk_metrics_cleanup(&metrics);
+
+    // Remove temporary test files
+    cleanup_temp_test_directory(&test_files);
+
+    // Cleanup test environment
+    test_cleanup_environment();
+}
+
+// Helpers
+
+static char* write_to_string(netchunk_monitoring_format_t format) {
+    netchunk_metrics_snapshot_t snapshot;
+    netchunk_metrics_read(&metrics, &snapshot);
+
+    FILE* output = tmpfile();
+    TEST_ASSERT_NOT_NULL(output);
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_metrics_write(&snapshot, format, output));
+
+    long size = ftell(output);
+    rewind(output);
+    char* text = malloc((size_t)size + 1);
+    TEST_ASSERT_NOT_NULL(text);
+    TEST_ASSERT_EQUAL_size_t((size_t)size, fread(text, 1, (size_t)size, output));
+    text[size] = '\0';
+    fclose(output);
+    return text;
+}
+
+static void* record_main(void* arg) {
+    int server_index = (int)(intptr_t)arg % 2;
+    for (int i = 0; i < TEST_RECORDS_PER_THREAD; i++) {
+        netchunk_metrics_record_duration(&metrics, NETCHUNK_METRICS_HASH, (uint64_t)i * 1000);
+        netchunk_metrics_record_transfer(&metrics, server_index, true, 1000, 1, 0);
+        netchunk_metrics_add(&metrics, NETCHUNK_METRICS_CACHE_HITS, 1);
+    }
+    return NULL;
+}
+
+// Test that durations land in the smallest power-of-two bucket holding them
+void test_metrics_histogram_buckets(void) {
+    netchunk_metrics_record_duration(&metrics, NETCHUNK_METRICS_READ, 500); // Up to 1us
+    netchunk_metrics_record_duration(&metrics, NETCHUNK_METRICS_READ, 2000); // Up to 2us
+    netchunk_metrics_record_duration(&metrics, NETCHUNK_METRICS_READ, 2001); // Up to 4us
+    netchunk_metrics_record_duration(&metrics, NETCHUNK_METRICS_READ, 600ULL * 1000000000ULL); // Past the last bound
+
+    netchunk_metrics_snapshot_t snapshot;
+    netchunk_metrics_read(&metrics, &snapshot);
+    const netchunk_metrics_histogram_t* read = &snapshot.phases[NETCHUNK_METRICS_READ];
+    TEST_ASSERT_EQUAL_UINT64(1, read->buckets[0]);
+    TEST_ASSERT_EQUAL_UINT64(1, read->buckets[1]);
+    TEST_ASSERT_EQUAL_UINT64(1, read->buckets[2]);
+    TEST_ASSERT_EQUAL_UINT64(1, read->buckets[NETCHUNK_METRICS_BUCKETS - 1]);
+    TEST_ASSERT_EQUAL_UINT64(4, netchunk_metrics_histogram_count(read));
+    TEST_ASSERT_EQUAL_UINT64(500 + 2000 + 2001 + 600ULL * 1000000000ULL, read->sum_ns);
+    TEST_ASSERT_EQUAL_UINT64(600ULL * 1000000000ULL, read->max_ns);
+    TEST_ASSERT_EQUAL_UINT64(0, netchunk_metrics_histogram_count(&snapshot.phases[NETCHUNK_METRICS_HASH]));
+
+    TEST_ASSERT_TRUE(netchunk_metrics_bucket_bound(0) == 1e-6);
+    TEST_ASSERT_TRUE(netchunk_metrics_bucket_bound(NETCHUNK_METRICS_BUCKETS - 1) < 0.0);
+}
+
+// Test that a missing collector records nothing and reads no clock
+void test_metrics_disabled(void) {
+    TEST_ASSERT_EQUAL_UINT64(0, netchunk_metrics_start(NULL));
+    netchunk_metrics_record(NULL, NETCHUNK_METRICS_READ, 0);
+    netchunk_metrics_record_duration(NULL, NETCHUNK_METRICS_READ, 1);
+    netchunk_metrics_record_transfer(NULL, 0, true, 1, 1, 1);
+    netchunk_metrics_add(NULL, NETCHUNK_METRICS_RETRIES, 1);
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_metrics_dump_if_due(NULL));
+
+    TEST_ASSERT_TRUE(netchunk_metrics_start(&metrics) > 0);
+}
+
+// Test that transfers count per server and in the global totals
+void test_metrics_transfers(void) {
+    netchunk_metrics_record_transfer(&metrics, 0, true, 3000000, 4096, 0);
+    netchunk_metrics_record_transfer(&metrics, 1, false, 1000000, 0, 0);
+    netchunk_metrics_record_transfer(&metrics, 1, true, 2000000, 0, 1024);
+    netchunk_metrics_record_transfer(&metrics, 7, true, 1000000, 0, 1); // Unknown server: totals only
+    netchunk_metrics_add(&metrics, NETCHUNK_METRICS_RETRIES, 1);
+
+    netchunk_metrics_snapshot_t snapshot;
+    netchunk_metrics_read(&metrics, &snapshot);
+    TEST_ASSERT_EQUAL_INT(2, snapshot.server_count);
+    TEST_ASSERT_EQUAL_STRING("server_1", snapshot.servers[0].id);
+    TEST_ASSERT_EQUAL_UINT64(4096, snapshot.servers[0].bytes_sent);
+    TEST_ASSERT_EQUAL_UINT64(0, snapshot.servers[0].failures);
+    TEST_ASSERT_EQUAL_UINT64(1024, snapshot.servers[1].bytes_received);
+    TEST_ASSERT_EQUAL_UINT64(1, snapshot.servers[1].failures);
+    TEST_ASSERT_EQUAL_UINT64(2, netchunk_metrics_histogram_count(&snapshot.servers[1].transfer));
+    TEST_ASSERT_EQUAL_UINT64(4, netchunk_metrics_histogram_count(&snapshot.phases[NETCHUNK_METRICS_TRANSFER]));
+    TEST_ASSERT_EQUAL_UINT64(4096, snapshot.counters[NETCHUNK_METRICS_BYTES_SENT]);
+    TEST_ASSERT_EQUAL_UINT64(1025, snapshot.counters[NETCHUNK_METRICS_BYTES_RECEIVED]);
+    TEST_ASSERT_EQUAL_UINT64(1, snapshot.counters[NETCHUNK_METRICS_RETRIES]);
+}
+
+// Test the Prometheus text exposition output
+void test_metrics_prometheus_format(void) {
+    netchunk_metrics_record_duration(&metrics, NETCHUNK_METRICS_MANIFEST, 1500000); // 1.5ms
+    netchunk_metrics_record_transfer(&metrics, 1, true, 1000, 10, 0);
+    netchunk_metrics_add(&metrics, NETCHUNK_METRICS_CACHE_HITS, 3);
+
+    char* text = write_to_string(NETCHUNK_MONITORING_PROMETHEUS);
+    TEST_ASSERT_NOT_NULL(strstr(text, "# TYPE netchunk_phase_duration_seconds histogram\n"));
+    TEST_ASSERT_NOT_NULL(strstr(text, "netchunk_phase_duration_seconds_bucket{phase=\"manifest\",le=\"0.001024\"} 0\n"));
+    TEST_ASSERT_NOT_NULL(strstr(text, "netchunk_phase_duration_seconds_bucket{phase=\"manifest\",le=\"0.002048\"} 1\n"));
+    TEST_ASSERT_NOT_NULL(strstr(text, "netchunk_phase_duration_seconds_bucket{phase=\"manifest\",le=\"+Inf\"} 1\n"));
+    TEST_ASSERT_NOT_NULL(strstr(text, "netchunk_phase_duration_seconds_sum{phase=\"manifest\"} 0.001500000\n"));
+    TEST_ASSERT_NOT_NULL(strstr(text, "netchunk_phase_duration_seconds_count{phase=\"read\"} 0\n"));
+    TEST_ASSERT_NOT_NULL(strstr(text, "netchunk_cache_hits_total 3\n"));
+    TEST_ASSERT_NOT_NULL(strstr(text, "netchunk_server_bytes_sent_total{server=\"quote\\\"d\"} 10\n"));
+    TEST_ASSERT_NOT_NULL(strstr(text, "netchunk_server_transfer_duration_seconds_count{server=\"server_1\"} 0\n"));
+    free(text);
+}
+
+// Test the JSON output
+void test_metrics_json_format(void) {
+    netchunk_metrics_record_duration(&metrics, NETCHUNK_METRICS_VERIFY, 1000);
+    netchunk_metrics_add(&metrics, NETCHUNK_METRICS_BYTES_WRITTEN, 42);
+
+    char* text = write_to_string(NETCHUNK_MONITORING_JSON);
+    TEST_ASSERT_EQUAL_INT('{', text[0]);
+    TEST_ASSERT_NOT_NULL(strstr(text, "\"bytes_written\":42"));
+    TEST_ASSERT_NOT_NULL(strstr(text, "\"verify\":{\"count\":1,\"sum_seconds\":0.000001000,\"max_seconds\":0.000001000,\"buckets\":[1,0,"));
+    TEST_ASSERT_NOT_NULL(strstr(text, "{\"id\":\"quote\\\"d\",\"bytes_sent\":0,"));
+    TEST_ASSERT_NOT_NULL(strstr(text, "]}\n"));
+    free(text);
+}
+
+// Test that dumps create the directory and replace the file whole
+void test_metrics_dump(void) {
+    netchunk_metrics_add(&metrics, NETCHUNK_METRICS_BYTES_READ, 7);
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_metrics_dump(&metrics));
+
+    char path[TEST_MAX_PATH_LEN + 64];
+    snprintf(path, sizeof(path), "%s/monitoring/data/%s", test_files.temp_dir, NETCHUNK_METRICS_PROMETHEUS_FILE);
+    TEST_ASSERT_TRUE(file_exists(path));
+    TEST_ASSERT_TRUE(get_file_size(path) > 0);
+
+    char temp_path[TEST_MAX_PATH_LEN + 64];
+    snprintf(temp_path, sizeof(temp_path), "%s.tmp", path);
+    TEST_ASSERT_FALSE(file_exists(temp_path));
+
+    // Just dumped: nothing is due
+    remove(path);
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_metrics_dump_if_due(&metrics));
+    TEST_ASSERT_FALSE(file_exists(path));
+
+    // JSON goes to its own file
+    netchunk_metrics_cleanup(&metrics);
+    config.monitoring_format = NETCHUNK_MONITORING_JSON;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_metrics_init(&metrics, &config));
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_metrics_dump_if_due(&metrics));
+    snprintf(path, sizeof(path), "%s/monitoring/data/%s", test_files.temp_dir, NETCHUNK_METRICS_JSON_FILE);
+    TEST_ASSERT_TRUE(file_exists(path));
+}
+
+// Test that concurrent recording loses no observation
+void test_metrics_concurrent_record(void) {
+    pthread_t threads[TEST_THREADS];
+    for (int t = 0; t < TEST_THREADS; t++) {
+        TEST_ASSERT_EQUAL_INT(0, pthread_create(&threads[t], NULL, record_main, (void*)(intptr_t)t));
+    }
+    for (int t = 0; t < TEST_THREADS; t++) {
+        pthread_join(threads[t], NULL);
+    }
+
+    netchunk_metrics_snapshot_t snapshot;
+    netchunk_metrics_read(&metrics, &snapshot);
+    uint64_t total = (uint64_t)TEST_THREADS * TEST_RECORDS_PER_THREAD;
+    TEST_ASSERT_EQUAL_UINT64(total, netchunk_metrics_histogram_count(&snapshot.phases[NETCHUNK_METRICS_HASH]));
+    TEST_ASSERT_EQUAL_UINT64((uint64_t)(TEST_RECORDS_PER_THREAD - 1) * 1000, snapshot.phases[NETCHUNK_METRICS_HASH].max_ns);
+    TEST_ASSERT_EQUAL_UINT64(total, snapshot.counters[NETCHUNK_METRICS_CACHE_HITS]);
+    TEST_ASSERT_EQUAL_UINT64(total, snapshot.counters[NETCHUNK_METRICS_BYTES_SENT]);
+    TEST_ASSERT_EQUAL_UINT64(total / 2, snapshot.servers[0].bytes_sent);
+    TEST_ASSERT_EQUAL_UINT64(total / 2, snapshot.servers[1].bytes_sent);
+}
+
+// Test that the chunker times reading and hashing once per chunk
+void test_metrics_chunker_phases(void) {
+    char input_path[TEST_MAX_PATH_LEN + 16];
+    snprintf(input_path, sizeof(input_path), "%s/input.bin", test_files.temp_dir);
+    FILE* input = fopen(input_path, "wb");
+    TEST_ASSERT_NOT_NULL(input);
+    size_t file_size = 3 * NETCHUNK_MIN_CHUNK_SIZE + 100;
+    for (size_t i = 0; i < file_size; i++) {
+        fputc((int)(i * 31 % 251), input);
+    }
+    fclose(input);
+
+    netchunk_chunker_context_t chunker;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_chunker_init(&chunker, input_path, NETCHUNK_MIN_CHUNK_SIZE));
+    chunker.metrics = &metrics;
+
+    netchunk_chunk_t chunk;
+    int chunks = 0;
+    while (netchunk_chunker_next_chunk(&chunker, &chunk) == NETCHUNK_SUCCESS) {
+        netchunk_chunk_cleanup(&chunk);
+        chunks++;
+    }
+    netchunk_chunker_cleanup(&chunker);
+    TEST_ASSERT_EQUAL_INT(4, chunks);
+
+    netchunk_metrics_snapshot_t snapshot;
+    netchunk_metrics_read(&metrics, &snapshot);
+    TEST_ASSERT_EQUAL_UINT64(4, netchunk_metrics_histogram_count(&snapshot.phases[NETCHUNK_METRICS_READ]));
+    TEST_ASSERT_EQUAL_UINT64(4, netchunk_metrics_histogram_count(&snapshot.phases[NETCHUNK_METRICS_HASH]));
+    TEST_ASSERT_TRUE(snapshot.phases[NETCHUNK_METRICS_HASH].sum_ns > 0);
+    TEST_ASSERT_EQUAL_UINT64(file_size, snapshot.counters[NETCHUNK_METRICS_BYTES_READ]);
+}
+
+// Unity test runner
+int main(void) {
+    UNITY_BEGIN();
+
+    // Recording tests
+    RUN_TEST(test_metrics_histogram_buckets);
+    RUN_TEST(test_metrics_disabled);
+    RUN_TEST(test_metrics_transfers);
+    RUN_TEST(test_metrics_concurrent_record);
+    RUN_TEST(test_metrics_chunker_phases);
+
+    // Output tests
+    RUN_TEST(test_metrics_prometheus_format);
+    RUN_TEST(test_metrics_json_format);
+    RUN_TEST(test_metrics_dump);
+
+    return UNITY_END();
+}
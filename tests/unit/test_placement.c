@@ -0,0 +1,317 @@
+#include "unity.h"
+#include "test_utils.h"
+#include "chunker.h"
+#include "placement.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#define TEST_CHUNKS 20000
+#define TEST_REPLICAS 3
+#define TEST_GIB ((uint64_t)1 << 30)
+
+// Test data and fixtures
+static netchunk_config_t config;
+static netchunk_health_snapshot_t health;
+static netchunk_placement_t placement;
+
+void setUp(void) {
+    // Initialize test environment
+    test_setup_environment();
+
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_config_init_defaults(&config));
+    memset(&health, 0, sizeof(health));
+    health.generation = 1;
+}
+
+void tearDown(void) {
+    // Cleanup test environment
+    test_cleanup_environment();
+}
+
+// Helpers
+
+static void add_servers(int count) {
+    for (int i = config.server_count; i < config.server_count + count; i++) {
+        snprintf(config.servers[i].id, sizeof(config.servers[i].id), "server_%d", i + 1);
+        health.servers[i].status = NETCHUNK_SERVER_AVAILABLE;
+        health.servers[i].bytes_available = 100 * TEST_GIB;
+    }
+    config.server_count += count;
+    health.server_count = config.server_count;
+}
+
+// Chunk IDs shaped like the random ones uploads generate
+static const char* chunk_id(int chunk) {
+    static char id[NETCHUNK_RANDOM_CHUNK_ID_LENGTH + 1];
+    snprintf(id, sizeof(id), "%08x%08x", (unsigned)chunk * 2654435761u, (unsigned)chunk);
+    return id;
+}
+
+// Share of first replicas each server receives
+static void first_replica_shares(double* shares) {
+    memset(shares, 0, sizeof(double) * (size_t)config.server_count);
+    for (int c = 0; c < TEST_CHUNKS; c++) {
+        int ranking[NETCHUNK_MAX_SERVERS];
+        TEST_ASSERT_EQUAL_INT(config.server_count,
+            netchunk_placement_rank(&placement, chunk_id(c), ranking, NETCHUNK_MAX_SERVERS));
+        shares[ranking[0]] += 1.0 / TEST_CHUNKS;
+    }
+}
+
+// Test that a ranking lists every server once and is the same every time
+void test_placement_ranks_distinct_servers(void) {
+    add_servers(8);
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_placement_init(&placement, &config, NULL));
+
+    for (int c = 0; c < 1000; c++) {
+        int ranking[NETCHUNK_MAX_SERVERS];
+        int again[NETCHUNK_MAX_SERVERS];
+        bool seen[NETCHUNK_MAX_SERVERS] = { false };
+
+        TEST_ASSERT_EQUAL_INT(8, netchunk_placement_rank(&placement, chunk_id(c), ranking, NETCHUNK_MAX_SERVERS));
+        for (int r = 0; r < 8; r++) {
+            TEST_ASSERT_TRUE(ranking[r] >= 0 && ranking[r] < 8);
+            TEST_ASSERT_FALSE(seen[ranking[r]]);
+            seen[ranking[r]] = true;
+        }
+
+        TEST_ASSERT_EQUAL_INT(TEST_REPLICAS, netchunk_placement_rank(&placement, chunk_id(c), again, TEST_REPLICAS));
+        TEST_ASSERT_EQUAL_INT_ARRAY(ranking, again, TEST_REPLICAS);
+    }
+}
+
+// Test that chunks spread evenly over equal servers instead of piling on the first
+void test_placement_spreads_evenly(void) {
+    add_servers(5);
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_placement_init(&placement, &config, &health));
+
+    double shares[NETCHUNK_MAX_SERVERS];
+    first_replica_shares(shares);
+    for (int s = 0; s < 5; s++) {
+        TEST_ASSERT_DOUBLE_WITHIN(0.02, 0.2, shares[s]);
+    }
+}
+
+// Test that placement follows server IDs, not their order in the configuration
+void test_placement_ignores_server_order(void) {
+    add_servers(6);
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_placement_init(&placement, &config, NULL));
+
+    netchunk_config_t reversed = config;
+    for (int s = 0; s < config.server_count; s++) {
+        reversed.servers[s] = config.servers[config.server_count - 1 - s];
+    }
+    netchunk_placement_t reversed_placement;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_placement_init(&reversed_placement, &reversed, NULL));
+
+    for (int c = 0; c < 1000; c++) {
+        int ranking[NETCHUNK_MAX_SERVERS];
+        int reversed_ranking[NETCHUNK_MAX_SERVERS];
+        netchunk_placement_rank(&placement, chunk_id(c), ranking, NETCHUNK_MAX_SERVERS);
+        netchunk_placement_rank(&reversed_placement, chunk_id(c), reversed_ranking, NETCHUNK_MAX_SERVERS);
+        for (int r = 0; r < config.server_count; r++) {
+            TEST_ASSERT_EQUAL_STRING(config.servers[ranking[r]].id, reversed.servers[reversed_ranking[r]].id);
+        }
+    }
+}
+
+// Test that servers receive chunks in proportion to their free space
+void test_placement_weights_by_free_space(void) {
+    add_servers(4);
+    health.servers[0].bytes_available = 64 * TEST_GIB;
+    health.servers[1].bytes_available = 64 * TEST_GIB;
+    health.servers[2].bytes_available = 0; // Not reported, counts as average
+    health.servers[3].bytes_available = 256 * TEST_GIB;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_placement_init(&placement, &config, &health));
+
+    double shares[NETCHUNK_MAX_SERVERS];
+    first_replica_shares(shares);
+    // Buckets 72, 72, 76 average to 73 (90.5 GiB), so weights 1 : 1 : sqrt(2) : 4
+    double total = 6.0 + sqrt(2.0);
+    TEST_ASSERT_DOUBLE_WITHIN(0.02, 1.0 / total, shares[0]);
+    TEST_ASSERT_DOUBLE_WITHIN(0.02, 1.0 / total, shares[1]);
+    TEST_ASSERT_DOUBLE_WITHIN(0.02, sqrt(2.0) / total, shares[2]);
+    TEST_ASSERT_DOUBLE_WITHIN(0.02, 4.0 / total, shares[3]);
+}
+
+// Test that free space drifting between probes does not re-rank any chunk
+void test_placement_ignores_free_space_drift(void) {
+    add_servers(5);
+    for (int s = 0; s < 5; s++) {
+        health.servers[s].bytes_available = 90 * TEST_GIB;
+    }
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_placement_init(&placement, &config, &health));
+
+    static int before[TEST_CHUNKS][TEST_REPLICAS];
+    for (int c = 0; c < TEST_CHUNKS; c++) {
+        netchunk_placement_rank(&placement, chunk_id(c), before[c], TEST_REPLICAS);
+    }
+
+    // Uploads and deletes since the last probe, all within 10%
+    const uint64_t drifted[] = { 85, 93, 81, 99, 90 };
+    for (int s = 0; s < 5; s++) {
+        health.servers[s].bytes_available = drifted[s] * TEST_GIB - (uint64_t)s * 4096;
+    }
+    health.generation++;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_placement_init(&placement, &config, &health));
+    TEST_ASSERT_EQUAL_UINT64(health.generation, placement.generation);
+
+    for (int c = 0; c < TEST_CHUNKS; c++) {
+        int after[TEST_REPLICAS];
+        netchunk_placement_rank(&placement, chunk_id(c), after, TEST_REPLICAS);
+        TEST_ASSERT_EQUAL_INT_ARRAY(before[c], after, TEST_REPLICAS);
+    }
+}
+
+// Publish free space like a health monitor round, keeping each server's bucket
+static void probe_round(const double* free_gib) {
+    for (int s = 0; s < health.server_count; s++) {
+        netchunk_server_health_t* server_health = &health.servers[s];
+        server_health->bytes_available = (uint64_t)(free_gib[s] * TEST_GIB);
+        server_health->capacity_step = netchunk_placement_capacity_step(server_health->bytes_available,
+            server_health->capacity_step);
+    }
+    health.generation++;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_placement_init(&placement, &config, &health));
+}
+
+// Test that a server hovering at a bucket edge keeps its bucket until it is well past it
+void test_placement_bucket_edge_hysteresis(void) {
+    add_servers(5);
+
+    // 76.1 GiB is the edge between buckets 72 and 73
+    TEST_ASSERT_EQUAL_INT(72, netchunk_placement_capacity_step((uint64_t)(75.0 * TEST_GIB), 0));
+    TEST_ASSERT_EQUAL_INT(73, netchunk_placement_capacity_step((uint64_t)(77.5 * TEST_GIB), 0));
+
+    double free_gib[] = { 75.0, 90.0, 90.0, 90.0, 90.0 };
+    probe_round(free_gib);
+    TEST_ASSERT_EQUAL_INT(72, health.servers[0].capacity_step);
+
+    static int before[TEST_CHUNKS][TEST_REPLICAS];
+    for (int c = 0; c < TEST_CHUNKS; c++) {
+        netchunk_placement_rank(&placement, chunk_id(c), before[c], TEST_REPLICAS);
+    }
+
+    // Crossing the edge back and forth re-ranks nothing
+    const double hovering[] = { 77.5, 75.5, 76.5, 74.0, 80.0, 76.0 };
+    for (size_t r = 0; r < sizeof(hovering) / sizeof(hovering[0]); r++) {
+        free_gib[0] = hovering[r];
+        probe_round(free_gib);
+        TEST_ASSERT_EQUAL_INT(72, health.servers[0].capacity_step);
+
+        for (int c = 0; c < TEST_CHUNKS; c++) {
+            int after[TEST_REPLICAS];
+            netchunk_placement_rank(&placement, chunk_id(c), after, TEST_REPLICAS);
+            TEST_ASSERT_EQUAL_INT_ARRAY(before[c], after, TEST_REPLICAS);
+        }
+    }
+
+    // A quarter step past the edge, the server moves up and weighs like the rest
+    free_gib[0] = 84.0;
+    probe_round(free_gib);
+    TEST_ASSERT_EQUAL_INT(73, health.servers[0].capacity_step);
+    TEST_ASSERT_DOUBLE_WITHIN(1e-12, placement.weights[1], placement.weights[0]);
+}
+
+// Test that priorities above 1 and degraded servers take less
+void test_placement_priority_and_degraded(void) {
+    add_servers(3);
+    config.servers[0].priority = 1;
+    config.servers[1].priority = 2;
+    health.servers[2].status = NETCHUNK_SERVER_DEGRADED;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_placement_init(&placement, &config, &health));
+
+    double shares[NETCHUNK_MAX_SERVERS];
+    first_replica_shares(shares);
+    TEST_ASSERT_DOUBLE_WITHIN(0.02, 1.0 / 1.75, shares[0]);
+    TEST_ASSERT_DOUBLE_WITHIN(0.02, 0.5 / 1.75, shares[1]);
+    TEST_ASSERT_DOUBLE_WITHIN(0.02, 0.25 / 1.75, shares[2]);
+}
+
+// Test that unavailable servers come after every usable one
+void test_placement_unavailable_ranked_last(void) {
+    add_servers(5);
+    health.servers[1].status = NETCHUNK_SERVER_UNAVAILABLE;
+    health.servers[3].status = NETCHUNK_SERVER_UNAVAILABLE;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_placement_init(&placement, &config, &health));
+    TEST_ASSERT_FALSE(placement.usable[1]);
+    TEST_ASSERT_TRUE(placement.usable[2]);
+
+    for (int c = 0; c < 1000; c++) {
+        int ranking[NETCHUNK_MAX_SERVERS];
+        netchunk_placement_rank(&placement, chunk_id(c), ranking, NETCHUNK_MAX_SERVERS);
+        for (int r = 0; r < 3; r++) {
+            TEST_ASSERT_TRUE(ranking[r] != 1 && ranking[r] != 3);
+        }
+    }
+
+    // A snapshot for other servers is ignored rather than misread
+    health.server_count = 4;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_placement_init(&placement, &config, &health));
+    TEST_ASSERT_TRUE(placement.usable[1]);
+    TEST_ASSERT_EQUAL_UINT64(0, placement.generation);
+}
+
+// Test that a new server takes over about its share of replicas and nothing else moves
+void test_placement_adding_server_moves_its_share(void) {
+    add_servers(5);
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_placement_init(&placement, &config, &health));
+
+    static int before[TEST_CHUNKS][TEST_REPLICAS];
+    for (int c = 0; c < TEST_CHUNKS; c++) {
+        netchunk_placement_rank(&placement, chunk_id(c), before[c], TEST_REPLICAS);
+    }
+
+    add_servers(1);
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_placement_init(&placement, &config, &health));
+
+    int moved = 0;
+    for (int c = 0; c < TEST_CHUNKS; c++) {
+        int after[TEST_REPLICAS];
+        netchunk_placement_rank(&placement, chunk_id(c), after, TEST_REPLICAS);
+
+        for (int r = 0; r < TEST_REPLICAS; r++) {
+            bool kept = false;
+            for (int k = 0; k < TEST_REPLICAS; k++) {
+                kept = kept || before[c][r] == after[k];
+            }
+            if (!kept) {
+                moved++;
+            }
+        }
+
+        // Whatever moved went to the new server
+        for (int k = 0; k < TEST_REPLICAS; k++) {
+            bool old = false;
+            for (int r = 0; r < TEST_REPLICAS; r++) {
+                old = old || before[c][r] == after[k];
+            }
+            TEST_ASSERT_TRUE(old || after[k] == 5);
+        }
+    }
+
+    TEST_ASSERT_DOUBLE_WITHIN(0.02, 1.0 / 6.0, (double)moved / (TEST_CHUNKS * TEST_REPLICAS));
+}
+
+// Unity test runner
+int main(void) {
+    UNITY_BEGIN();
+
+    // Ranking tests
+    RUN_TEST(test_placement_ranks_distinct_servers);
+    RUN_TEST(test_placement_spreads_evenly);
+    RUN_TEST(test_placement_ignores_server_order);
+
+    // Weighting tests
+    RUN_TEST(test_placement_weights_by_free_space);
+    RUN_TEST(test_placement_ignores_free_space_drift);
+    RUN_TEST(test_placement_bucket_edge_hysteresis);
+    RUN_TEST(test_placement_priority_and_degraded);
+    RUN_TEST(test_placement_unavailable_ranked_last);
+
+    // Rebalancing tests
+    RUN_TEST(test_placement_adding_server_moves_its_share);
+
+    return UNITY_END();
+}
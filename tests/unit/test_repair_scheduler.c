@@ -0,0 +1,206 @@
+#include "unity.h"
+#include "test_utils.h"
+#include "repair_scheduler.h"
+#include <pthread.h>
+#include <string.h>
+#include <unistd.h>
+
+#define TEST_MB (1024 * 1024)
+
+// Test data and fixtures
+static netchunk_repair_queue_t queue;
+static netchunk_repair_throttle_t throttle;
+static bool throttle_ready;
+
+void setUp(void) {
+    // Initialize test environment
+    test_setup_environment();
+    netchunk_repair_queue_init(&queue);
+    throttle_ready = false;
+}
+
+void tearDown(void) {
+    // Cleanup test environment
+    netchunk_repair_queue_cleanup(&queue);
+    if (throttle_ready) {
+        netchunk_repair_throttle_cleanup(&throttle);
+    }
+    test_cleanup_environment();
+}
+
+// Helpers
+
+static void init_throttle(int max_per_server, uint64_t bandwidth) {
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_repair_throttle_init(&throttle, max_per_server, bandwidth));
+    throttle_ready = true;
+}
+
+static void expect_pop(uint32_t chunk_index, netchunk_chunk_health_t health) {
+    netchunk_repair_task_t task;
+    TEST_ASSERT_TRUE(netchunk_repair_queue_pop(&queue, &task));
+    TEST_ASSERT_EQUAL_UINT32(chunk_index, task.chunk_index);
+    TEST_ASSERT_EQUAL(health, task.health);
+}
+
+static volatile bool acquired_in_thread;
+
+static void* acquire_server_zero(void* arg) {
+    (void)arg;
+    netchunk_repair_throttle_acquire(&throttle, 0, 0);
+    acquired_in_thread = true;
+    netchunk_repair_throttle_release(&throttle, 0);
+    return NULL;
+}
+
+static uint32_t progress_calls;
+static uint32_t progress_total;
+
+static void record_progress(void* userdata, uint32_t current_chunk, uint32_t total_chunks,
+    const netchunk_repair_stats_t* stats) {
+    (void)userdata;
+    (void)current_chunk;
+    (void)stats;
+    progress_calls++;
+    progress_total = total_chunks;
+}
+
+// Test that the worst health comes out first and ties keep arrival order
+void test_repair_queue_priority_order(void) {
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_repair_queue_push(&queue, 0, 0, NETCHUNK_CHUNK_DEGRADED, false));
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_repair_queue_push(&queue, 0, 1, NETCHUNK_CHUNK_LOST, false));
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_repair_queue_push(&queue, 0, 2, NETCHUNK_CHUNK_CRITICAL, true));
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_repair_queue_push(&queue, 0, 3, NETCHUNK_CHUNK_LOST, true));
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_repair_queue_push(&queue, 0, 4, NETCHUNK_CHUNK_DEGRADED, true));
+
+    expect_pop(1, NETCHUNK_CHUNK_LOST);
+    expect_pop(3, NETCHUNK_CHUNK_LOST);
+    expect_pop(2, NETCHUNK_CHUNK_CRITICAL);
+    expect_pop(0, NETCHUNK_CHUNK_DEGRADED);
+    expect_pop(4, NETCHUNK_CHUNK_DEGRADED);
+
+    netchunk_repair_task_t task;
+    TEST_ASSERT_FALSE(netchunk_repair_queue_pop(&queue, &task));
+    TEST_ASSERT_EQUAL(NETCHUNK_ERROR_INVALID_ARGUMENT,
+        netchunk_repair_queue_push(NULL, 0, 0, NETCHUNK_CHUNK_LOST, false));
+}
+
+// Test that the queue grows past its initial capacity and stays ordered
+void test_repair_queue_grows(void) {
+    int count = NETCHUNK_REPAIR_QUEUE_INITIAL_CAPACITY * 3;
+    for (int i = 0; i < count; i++) {
+        netchunk_chunk_health_t health = (netchunk_chunk_health_t)(1 + i % 3);
+        TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_repair_queue_push(&queue, 1, (uint32_t)i, health, false));
+    }
+    TEST_ASSERT_EQUAL_size_t((size_t)count, queue.count);
+
+    netchunk_repair_task_t previous;
+    TEST_ASSERT_TRUE(netchunk_repair_queue_pop(&queue, &previous));
+    TEST_ASSERT_EQUAL(NETCHUNK_CHUNK_LOST, previous.health);
+    for (int i = 1; i < count; i++) {
+        netchunk_repair_task_t task;
+        TEST_ASSERT_TRUE(netchunk_repair_queue_pop(&queue, &task));
+        TEST_ASSERT_TRUE(task.health < previous.health
+            || (task.health == previous.health && task.sequence > previous.sequence));
+        previous = task;
+    }
+    TEST_ASSERT_EQUAL_size_t(0, queue.count);
+}
+
+// Test that transfers to one server are paced to its bandwidth
+void test_repair_throttle_bandwidth(void) {
+    init_throttle(2, TEST_MB);
+
+    TEST_ASSERT_EQUAL_INT(0, netchunk_repair_throttle_reserve(&throttle, 0, TEST_MB, 0.0));
+    TEST_ASSERT_EQUAL_INT(1000, netchunk_repair_throttle_reserve(&throttle, 0, TEST_MB, 0.0));
+    TEST_ASSERT_EQUAL_INT(500, netchunk_repair_throttle_reserve(&throttle, 0, TEST_MB / 2, 1500.0));
+
+    // Other servers have budgets of their own; metadata requests are free
+    TEST_ASSERT_EQUAL_INT(0, netchunk_repair_throttle_reserve(&throttle, 1, TEST_MB, 0.0));
+    TEST_ASSERT_EQUAL_INT(0, netchunk_repair_throttle_reserve(&throttle, 0, 0, 1500.0));
+
+    // Unused budget does not accumulate
+    TEST_ASSERT_EQUAL_INT(0, netchunk_repair_throttle_reserve(&throttle, 0, TEST_MB, 10000.0));
+    TEST_ASSERT_EQUAL_INT(1000, netchunk_repair_throttle_reserve(&throttle, 0, TEST_MB, 10000.0));
+}
+
+// Test that no bandwidth limit means no waiting
+void test_repair_throttle_unlimited(void) {
+    init_throttle(1, 0);
+
+    TEST_ASSERT_EQUAL_INT(0, netchunk_repair_throttle_reserve(&throttle, 0, 64 * TEST_MB, 0.0));
+    TEST_ASSERT_EQUAL_INT(0, netchunk_repair_throttle_reserve(&throttle, 0, 64 * TEST_MB, 0.0));
+    TEST_ASSERT_EQUAL_INT(0, netchunk_repair_throttle_reserve(&throttle, NETCHUNK_MAX_SERVERS, TEST_MB, 0.0));
+    TEST_ASSERT_EQUAL(NETCHUNK_ERROR_INVALID_ARGUMENT, netchunk_repair_throttle_init(&throttle, 0, 0));
+}
+
+// Test that requests beyond the per-server cap wait for a slot
+void test_repair_throttle_concurrency_cap(void) {
+    init_throttle(2, 0);
+
+    netchunk_repair_throttle_acquire(&throttle, 0, 0);
+    netchunk_repair_throttle_acquire(&throttle, 0, 0);
+    TEST_ASSERT_EQUAL_INT(2, throttle.active[0]);
+
+    // Another server is not affected
+    netchunk_repair_throttle_acquire(&throttle, 1, 0);
+    TEST_ASSERT_EQUAL_INT(1, throttle.active[1]);
+    netchunk_repair_throttle_release(&throttle, 1);
+
+    acquired_in_thread = false;
+    pthread_t thread;
+    TEST_ASSERT_EQUAL_INT(0, pthread_create(&thread, NULL, acquire_server_zero, NULL));
+    usleep(50000);
+    TEST_ASSERT_FALSE(acquired_in_thread);
+
+    netchunk_repair_throttle_release(&throttle, 0);
+    pthread_join(thread, NULL);
+    TEST_ASSERT_TRUE(acquired_in_thread);
+
+    netchunk_repair_throttle_release(&throttle, 0);
+    TEST_ASSERT_EQUAL_INT(0, throttle.active[0]);
+}
+
+// Test that a schedule without files finishes and reports completion
+void test_repair_schedule_empty(void) {
+    netchunk_config_t config;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_config_init_defaults(&config));
+
+    netchunk_ftp_context_t ftp_context;
+    memset(&ftp_context, 0, sizeof(ftp_context));
+
+    netchunk_repair_context_t context;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_repair_init(&context, &config, &ftp_context));
+    netchunk_repair_set_progress_callback(&context, record_progress, NULL);
+
+    progress_calls = 0;
+    progress_total = 1;
+    netchunk_repair_stats_t stats;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS,
+        netchunk_repair_schedule(&context, NULL, 0, NETCHUNK_REPAIR_AUTO, &stats));
+    TEST_ASSERT_EQUAL_UINT32(0, stats.chunks_verified);
+    TEST_ASSERT_EQUAL_UINT32(1, progress_calls);
+    TEST_ASSERT_EQUAL_UINT32(0, progress_total);
+    TEST_ASSERT_NULL(context.throttle);
+
+    TEST_ASSERT_EQUAL(NETCHUNK_ERROR_INVALID_ARGUMENT,
+        netchunk_repair_schedule(&context, NULL, 1, NETCHUNK_REPAIR_AUTO, &stats));
+}
+
+// Unity test runner
+int main(void) {
+    UNITY_BEGIN();
+
+    // Queue tests
+    RUN_TEST(test_repair_queue_priority_order);
+    RUN_TEST(test_repair_queue_grows);
+
+    // Throttle tests
+    RUN_TEST(test_repair_throttle_bandwidth);
+    RUN_TEST(test_repair_throttle_unlimited);
+    RUN_TEST(test_repair_throttle_concurrency_cap);
+
+    // Scheduler tests
+    RUN_TEST(test_repair_schedule_empty);
+
+    return UNITY_END();
+}
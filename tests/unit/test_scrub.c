@@ -0,0 +1,106 @@
+#include "unity.h"
+#include "test_utils.h"
+#include "scrub.h"
+#include <limits.h>
+#include <string.h>
+
+#define TEST_INTERVAL 3600
+#define TEST_NOW ((time_t)1700000000)
+
+// Test data and fixtures
+static netchunk_chunk_t chunk;
+
+void setUp(void) {
+    // Initialize test environment
+    test_setup_environment();
+    memset(&chunk, 0, sizeof(chunk));
+    chunk.location_count = 3;
+    for (int i = 0; i < chunk.location_count; i++) {
+        snprintf(chunk.locations[i].server_id, sizeof(chunk.locations[i].server_id), "server%d", i + 1);
+    }
+}
+
+void tearDown(void) {
+    // Cleanup test environment
+    test_cleanup_environment();
+}
+
+// Helpers
+
+static void mark_verified(int index, time_t when) {
+    chunk.locations[index].verified = true;
+    chunk.locations[index].last_verified = when;
+}
+
+// Test that only replicas not verified within the interval are due
+void test_scrub_replica_due(void) {
+    netchunk_chunk_location_t* location = &chunk.locations[0];
+    TEST_ASSERT_TRUE(netchunk_scrub_replica_due(location, TEST_NOW, TEST_INTERVAL));
+
+    mark_verified(0, TEST_NOW - TEST_INTERVAL + 1);
+    TEST_ASSERT_FALSE(netchunk_scrub_replica_due(location, TEST_NOW, TEST_INTERVAL));
+    TEST_ASSERT_TRUE(netchunk_scrub_replica_due(location, TEST_NOW + 1, TEST_INTERVAL));
+
+    // No interval means every replica is checked every time
+    TEST_ASSERT_TRUE(netchunk_scrub_replica_due(location, TEST_NOW, 0));
+
+    // A verification time in the future is not trusted
+    mark_verified(0, TEST_NOW + 60);
+    TEST_ASSERT_TRUE(netchunk_scrub_replica_due(location, TEST_NOW, TEST_INTERVAL));
+
+    // A replica found missing or corrupt is due again right away
+    mark_verified(0, TEST_NOW);
+    location->verified = false;
+    TEST_ASSERT_TRUE(netchunk_scrub_replica_due(location, TEST_NOW, TEST_INTERVAL));
+    TEST_ASSERT_FALSE(netchunk_scrub_replica_due(NULL, TEST_NOW, TEST_INTERVAL));
+}
+
+// Test that steps are paced to the bandwidth budget
+void test_scrub_delay_ms(void) {
+    TEST_ASSERT_EQUAL_INT(1000, netchunk_scrub_delay_ms(1024 * 1024, 1024 * 1024));
+    TEST_ASSERT_EQUAL_INT(250, netchunk_scrub_delay_ms(256 * 1024, 1024 * 1024));
+    TEST_ASSERT_EQUAL_INT(3, netchunk_scrub_delay_ms(NETCHUNK_SCRUB_REQUEST_COST, 1024 * 1024));
+    TEST_ASSERT_EQUAL_INT(0, netchunk_scrub_delay_ms(1024 * 1024, 0));
+    TEST_ASSERT_EQUAL_INT(0, netchunk_scrub_delay_ms(0, 1024));
+
+    // Huge costs against a tiny budget saturate instead of overflowing
+    TEST_ASSERT_EQUAL_INT(INT_MAX, netchunk_scrub_delay_ms(UINT64_MAX, 1));
+}
+
+// Test that deep checks rotate through the replicas by verification time
+void test_scrub_sample_rotation(void) {
+    netchunk_replica_status_t statuses[3] = {
+        NETCHUNK_REPLICA_PRESENT, NETCHUNK_REPLICA_PRESENT, NETCHUNK_REPLICA_PRESENT
+    };
+
+    // Never verified replicas go first, in order
+    TEST_ASSERT_EQUAL_INT(0, netchunk_repair_select_sample(&chunk, statuses));
+
+    // Each download moves the replica to the back of the rotation
+    for (int round = 0; round < 6; round++) {
+        int sample = netchunk_repair_select_sample(&chunk, statuses);
+        TEST_ASSERT_EQUAL_INT(round % 3, sample);
+        mark_verified(sample, TEST_NOW + round);
+    }
+
+    // Replicas not found present, or already hashed remotely, are not downloaded
+    statuses[0] = NETCHUNK_REPLICA_MISSING;
+    statuses[1] = NETCHUNK_REPLICA_VERIFIED;
+    TEST_ASSERT_EQUAL_INT(2, netchunk_repair_select_sample(&chunk, statuses));
+    statuses[2] = NETCHUNK_REPLICA_UNREACHABLE;
+    TEST_ASSERT_EQUAL_INT(-1, netchunk_repair_select_sample(&chunk, statuses));
+}
+
+// Unity test runner
+int main(void) {
+    UNITY_BEGIN();
+
+    // Scheduling tests
+    RUN_TEST(test_scrub_replica_due);
+    RUN_TEST(test_scrub_delay_ms);
+
+    // Sampling tests
+    RUN_TEST(test_scrub_sample_rotation);
+
+    return UNITY_END();
+}
@@ -0,0 +1,219 @@
+#include "unity.h"
+#include "test_utils.h"
+#include "server_score.h"
+#include <math.h>
+#include <string.h>
+
+#define TEST_CHUNK_SIZE (4 * 1024 * 1024)
+
+// Test data and fixtures
+static netchunk_scoreboard_t board;
+
+void setUp(void) {
+    // Initialize test environment
+    test_setup_environment();
+    netchunk_scoreboard_init(&board, 3);
+}
+
+void tearDown(void) {
+    // Cleanup test environment
+    test_cleanup_environment();
+}
+
+// Helpers
+
+static void complete_transfer(int server, double latency_ms, double mb_per_s) {
+    netchunk_scoreboard_begin(&board, server);
+    netchunk_scoreboard_record_success(&board, server, latency_ms, TEST_CHUNK_SIZE,
+        (double)TEST_CHUNK_SIZE / (mb_per_s * 1024 * 1024) * 1000.0);
+}
+
+static void fail_transfer(int server, double now_ms) {
+    netchunk_scoreboard_begin(&board, server);
+    netchunk_scoreboard_record_failure(&board, server, now_ms);
+}
+
+// Test that the server expected to deliver a chunk first is ranked first
+void test_server_score_ranks_by_expected_time(void) {
+    complete_transfer(0, 5.0, 10.0); // Close but slow: ~400 ms per chunk
+    complete_transfer(1, 50.0, 100.0); // Far but fast: ~90 ms per chunk
+    complete_transfer(2, 20.0, 50.0);
+
+    int servers[] = { 0, 1, 2 };
+    netchunk_scoreboard_rank(&board, servers, 3, TEST_CHUNK_SIZE, 0.0);
+    TEST_ASSERT_EQUAL_INT(1, servers[0]);
+    TEST_ASSERT_EQUAL_INT(2, servers[1]);
+    TEST_ASSERT_EQUAL_INT(0, servers[2]);
+
+    // For tiny transfers latency dominates
+    int small[] = { 1, 2, 0 };
+    netchunk_scoreboard_rank(&board, small, 3, 1024, 0.0);
+    TEST_ASSERT_EQUAL_INT(0, small[0]);
+    TEST_ASSERT_EQUAL_INT(1, small[2]);
+}
+
+// Test that moving averages follow a server that slows down
+void test_server_score_ewma_tracks_changes(void) {
+    complete_transfer(0, 10.0, 100.0);
+    TEST_ASSERT_TRUE(fabs(board.servers[0].latency_ms - 10.0) < 0.01);
+
+    for (int i = 0; i < 30; i++) {
+        complete_transfer(0, 200.0, 5.0);
+    }
+    TEST_ASSERT_TRUE(fabs(board.servers[0].latency_ms - 200.0) < 5.0);
+    TEST_ASSERT_TRUE(fabs(board.servers[0].throughput_bps - 5.0 * 1024 * 1024) < 0.5 * 1024 * 1024);
+    TEST_ASSERT_EQUAL_UINT64(31, board.servers[0].samples);
+    TEST_ASSERT_EQUAL_INT(0, board.servers[0].in_flight);
+}
+
+// Test that transfers in flight make a server less attractive
+void test_server_score_accounts_for_load(void) {
+    complete_transfer(0, 10.0, 100.0);
+    complete_transfer(1, 10.0, 60.0);
+
+    int servers[] = { 1, 0 };
+    netchunk_scoreboard_rank(&board, servers, 2, TEST_CHUNK_SIZE, 0.0);
+    TEST_ASSERT_EQUAL_INT(0, servers[0]);
+
+    // Three running transfers split server 0's bandwidth four ways
+    for (int i = 0; i < 3; i++) {
+        netchunk_scoreboard_begin(&board, 0);
+    }
+    netchunk_scoreboard_rank(&board, servers, 2, TEST_CHUNK_SIZE, 0.0);
+    TEST_ASSERT_EQUAL_INT(1, servers[0]);
+    TEST_ASSERT_TRUE(netchunk_server_score_cost(&board.servers[0], TEST_CHUNK_SIZE) >
+        3.0 * netchunk_server_score_cost(&board.servers[1], TEST_CHUNK_SIZE) / 2.0);
+}
+
+// Test that failing servers are penalized and skipped until they may recover
+void test_server_score_errors_and_health(void) {
+    complete_transfer(0, 10.0, 100.0);
+    complete_transfer(1, 10.0, 100.0);
+
+    // One failure raises the expected cost without making the server unhealthy
+    fail_transfer(0, 1000.0);
+    TEST_ASSERT_TRUE(netchunk_server_score_cost(&board.servers[0], TEST_CHUNK_SIZE) >
+        netchunk_server_score_cost(&board.servers[1], TEST_CHUNK_SIZE));
+    TEST_ASSERT_TRUE(netchunk_server_score_healthy(&board.servers[0], 1000.0));
+
+    fail_transfer(0, 1000.0);
+    fail_transfer(0, 1000.0);
+    TEST_ASSERT_FALSE(netchunk_server_score_healthy(&board.servers[0], 1000.0));
+
+    // Unhealthy servers rank last even against a server with no successes yet
+    int servers[] = { 0, 2 };
+    netchunk_scoreboard_rank(&board, servers, 2, TEST_CHUNK_SIZE, 2000.0);
+    TEST_ASSERT_EQUAL_INT(2, servers[0]);
+
+    netchunk_server_score_t score;
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS, netchunk_scoreboard_get(&board, 0, 2000.0, &score));
+    TEST_ASSERT_FALSE(score.healthy);
+    TEST_ASSERT_EQUAL(NETCHUNK_SUCCESS,
+        netchunk_scoreboard_get(&board, 0, 1000.0 + NETCHUNK_SCORE_RETRY_INTERVAL_MS, &score));
+    TEST_ASSERT_TRUE(score.healthy);
+
+    // A success clears the failure streak
+    complete_transfer(0, 10.0, 100.0);
+    TEST_ASSERT_EQUAL_UINT32(0, board.servers[0].consecutive_failures);
+}
+
+// Test that unmeasured servers are tried first and ties keep the caller's order
+void test_server_score_unmeasured_and_ties(void) {
+    complete_transfer(0, 10.0, 100.0);
+    TEST_ASSERT_EQUAL_DOUBLE(0.0, netchunk_server_score_cost(&board.servers[2], TEST_CHUNK_SIZE));
+
+    int servers[] = { 0, 2, 1 };
+    netchunk_scoreboard_rank(&board, servers, 3, TEST_CHUNK_SIZE, 0.0);
+    TEST_ASSERT_EQUAL_INT(2, servers[0]);
+    TEST_ASSERT_EQUAL_INT(1, servers[1]);
+    TEST_ASSERT_EQUAL_INT(0, servers[2]);
+
+    // A server that only ever failed costs more than any measured one
+    fail_transfer(1, 0.0);
+    TEST_ASSERT_TRUE(isinf(netchunk_server_score_cost(&board.servers[1], TEST_CHUNK_SIZE)));
+
+    // Out of range indices are ignored
+    netchunk_scoreboard_begin(&board, 7);
+    netchunk_server_score_t score;
+    TEST_ASSERT_EQUAL(NETCHUNK_ERROR_INVALID_ARGUMENT, netchunk_scoreboard_get(&board, 7, 0.0, &score));
+}
+
+// Test that the p95 deadline appears once enough transfers were seen
+void test_server_score_p95_deadline(void) {
+    // Durations of 100 ms plus time to first byte, one slow outlier
+    for (int i = 1; i < NETCHUNK_SCORE_MIN_HISTORY; i++) {
+        complete_transfer(0, (double)i, 40.0);
+        TEST_ASSERT_EQUAL_DOUBLE(0.0, netchunk_scoreboard_p95(&board, 0));
+    }
+    complete_transfer(0, 900.0, 40.0);
+    TEST_ASSERT_TRUE(fabs(netchunk_scoreboard_p95(&board, 0) - 1000.0) < 0.5);
+
+    // Ten more normal transfers push the outlier past the 95th percentile
+    for (int i = 0; i < 10; i++) {
+        complete_transfer(0, 5.0, 40.0);
+    }
+    TEST_ASSERT_TRUE(fabs(netchunk_scoreboard_p95(&board, 0) - 109.0) < 0.5);
+
+    // Small transfers say nothing about chunk fetch times
+    netchunk_scoreboard_begin(&board, 1);
+    netchunk_scoreboard_record_success(&board, 1, 5.0, 1024, 1.0);
+    TEST_ASSERT_EQUAL_INT(0, board.history[1].count);
+    TEST_ASSERT_EQUAL_DOUBLE(0.0, netchunk_scoreboard_p95(&board, 7));
+}
+
+// Test that the history keeps only the most recent durations
+void test_server_score_p95_history_wraps(void) {
+    for (int i = 0; i < NETCHUNK_SCORE_HISTORY; i++) {
+        complete_transfer(0, 1900.0, 40.0);
+    }
+    TEST_ASSERT_TRUE(fabs(netchunk_scoreboard_p95(&board, 0) - 2000.0) < 0.5);
+
+    for (int i = 0; i < NETCHUNK_SCORE_HISTORY; i++) {
+        complete_transfer(0, 0.0, 40.0);
+    }
+    TEST_ASSERT_EQUAL_INT(NETCHUNK_SCORE_HISTORY, board.history[0].count);
+    TEST_ASSERT_TRUE(fabs(netchunk_scoreboard_p95(&board, 0) - 100.0) < 0.5);
+}
+
+// Test that abandoned transfers free their slot and only ever raise latency
+void test_server_score_cancel(void) {
+    complete_transfer(0, 10.0, 100.0);
+    uint64_t samples = board.servers[0].samples;
+
+    netchunk_scoreboard_begin(&board, 0);
+    netchunk_scoreboard_cancel(&board, 0, 5.0);
+    TEST_ASSERT_EQUAL_INT(0, board.servers[0].in_flight);
+    TEST_ASSERT_TRUE(fabs(board.servers[0].latency_ms - 10.0) < 0.01);
+
+    netchunk_scoreboard_begin(&board, 0);
+    netchunk_scoreboard_cancel(&board, 0, 510.0);
+    TEST_ASSERT_TRUE(board.servers[0].latency_ms > 100.0);
+    TEST_ASSERT_EQUAL_UINT64(samples, board.servers[0].samples);
+    TEST_ASSERT_EQUAL_DOUBLE(0.0, board.servers[0].error_rate);
+
+    // Without a latency sample there is nothing to compare against
+    netchunk_scoreboard_begin(&board, 2);
+    netchunk_scoreboard_cancel(&board, 2, 500.0);
+    TEST_ASSERT_EQUAL_DOUBLE(0.0, netchunk_server_score_cost(&board.servers[2], TEST_CHUNK_SIZE));
+}
+
+// Unity test runner
+int main(void) {
+    UNITY_BEGIN();
+
+    // Ranking tests
+    RUN_TEST(test_server_score_ranks_by_expected_time);
+    RUN_TEST(test_server_score_accounts_for_load);
+    RUN_TEST(test_server_score_unmeasured_and_ties);
+
+    // Sample tracking tests
+    RUN_TEST(test_server_score_ewma_tracks_changes);
+    RUN_TEST(test_server_score_errors_and_health);
+    RUN_TEST(test_server_score_cancel);
+
+    // Deadline tests
+    RUN_TEST(test_server_score_p95_deadline);
+    RUN_TEST(test_server_score_p95_history_wraps);
+
+    return UNITY_END();
+}